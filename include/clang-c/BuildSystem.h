@@ -58,6 +58,21 @@ clang_VirtualFileOverlay_addFileMapping(CXVirtualFileOverlay,
                                         const char *virtualPath,
                                         const char *realPath);
 
+/**
+ * \brief Serve everything below \p virtualRoot out of the memory-mapped
+ * snapshot at \p snapshotPath, as written by \c vfs::SnapshotWriter.
+ *
+ * The snapshot is recorded in the overlay's YAML as an 'external-snapshots'
+ * entry. When the overlay is loaded, the snapshot file system is stacked
+ * underneath the overlay's file mappings, so explicit mappings still take
+ * precedence over snapshot contents.
+ * \returns 0 for success, non-zero to indicate an error.
+ */
+CINDEX_LINKAGE enum CXErrorCode
+clang_VirtualFileOverlay_addSnapshot(CXVirtualFileOverlay,
+                                     const char *snapshotPath,
+                                     const char *virtualRoot);
+
 /**
  * \brief Set the case sensitivity for the \c CXVirtualFileOverlay object.
  * The \c CXVirtualFileOverlay object is case-sensitive by default, this
@@ -22,6 +22,7 @@
 #include "clang-c/CXErrorCode.h"
 #include "clang-c/CXString.h"
 #include "clang-c/BuildSystem.h"
+#include "clang-c/CXCompilationDatabase.h"
 
 /**
  * \brief The version constants for the libclang API.
@@ -32,7 +33,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 24
+#define CINDEX_VERSION_MINOR 29
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -247,7 +248,21 @@ typedef enum {
    */
   CXGlobalOpt_ThreadBackgroundPriorityForAll =
       CXGlobalOpt_ThreadBackgroundPriorityForIndexing |
-      CXGlobalOpt_ThreadBackgroundPriorityForEditing
+      CXGlobalOpt_ThreadBackgroundPriorityForEditing,
+
+  /**
+   * \brief Used to indicate that translation units of the index whose main
+   * files start with the same preamble, parsed with the same options and
+   * seeing the same versions of the files the preamble includes, should
+   * share one precompiled preamble.
+   *
+   * The preamble is kept, on disk and in memory, for as long as any of
+   * those translation units uses it.
+   *
+   * Affects #clang_parseTranslationUnit, #clang_reparseTranslationUnit,
+   * #clang_codeCompleteAt.
+   */
+  CXGlobalOpt_SharePreambles = 0x4
 
 } CXGlobalOptFlags;
 
@@ -274,6 +289,16 @@ CINDEX_LINKAGE void clang_CXIndex_setGlobalOptions(CXIndex, unsigned options);
  */
 CINDEX_LINKAGE unsigned clang_CXIndex_getGlobalOptions(CXIndex);
 
+/**
+ * \brief Gets the number of precompiled preambles shared by the translation
+ * units of a CXIndex.
+ *
+ * \returns The number of distinct preambles currently in use by translation
+ * units of the index with #CXGlobalOpt_SharePreambles set, or 0 if the
+ * option is not set.
+ */
+CINDEX_LINKAGE unsigned clang_CXIndex_getNumSharedPreambles(CXIndex);
+
 /**
  * \defgroup CINDEX_FILES File manipulation routines
  *
@@ -1202,7 +1227,21 @@ enum CXTranslationUnit_Flags {
    * included into the set of code completions returned from this translation
    * unit.
    */
-  CXTranslationUnit_IncludeBriefCommentsInCodeCompletion = 0x80
+  CXTranslationUnit_IncludeBriefCommentsInCodeCompletion = 0x80,
+
+  /**
+   * \brief Used to indicate that the function/method bodies of the main file
+   * should be parsed only when needed.
+   *
+   * The bodies are skipped as with \c CXTranslationUnit_SkipFunctionBodies,
+   * but their tokens are kept, and a body is parsed the first time
+   * \c clang_getCursor(), \c clang_annotateTokens() or
+   * \c clang_codeCompleteAt() looks at a location inside it.  This lets an
+   * editor open a large file about as fast as with skipped bodies, while
+   * still providing full information for the code the user looks at.
+   * Diagnostics from a body appear once it has been parsed.
+   */
+  CXTranslationUnit_LazyFunctionBodies = 0x100
 };
 
 /**
@@ -1450,6 +1489,59 @@ CINDEX_LINKAGE int clang_reparseTranslationUnit(CXTranslationUnit TU,
                                           struct CXUnsavedFile *unsaved_files,
                                                 unsigned options);
 
+/**
+ * \brief An edit of the main file of a translation unit since it was last
+ * parsed: \c removed_length bytes at \c offset of the contents it was
+ * parsed with were replaced by \c inserted_length bytes.
+ */
+typedef struct CXSourceEdit {
+  unsigned offset;
+  unsigned removed_length;
+  unsigned inserted_length;
+} CXSourceEdit;
+
+/**
+ * \brief Reparse the source files that produced this translation unit,
+ * reusing the parts of the main file that the given edits did not touch.
+ *
+ * This behaves like \c clang_reparseTranslationUnit(), except that the
+ * bodies of the functions and Objective-C methods that no edit touched are
+ * not parsed again when the preamble does not change, which keeps a small
+ * edit of a large implementation file fast.  The diagnostics inside those
+ * bodies are the ones from the previous parse, so they can miss the effect
+ * of an edit elsewhere, such as renaming a method the body calls; and
+ * cursors, tokens and code completion do not see into the bodies.  A client
+ * can refresh everything with \c clang_reparseTranslationUnit(), for
+ * instance when the editor is idle.
+ *
+ * \param TU The translation unit whose contents will be re-parsed.
+ *
+ * \param num_unsaved_files The number of unsaved file entries in \p
+ * unsaved_files.
+ *
+ * \param unsaved_files The files that have not yet been saved to disk,
+ * including the edited main file, as for \c clang_reparseTranslationUnit().
+ *
+ * \param num_edits The number of entries in \p edits.
+ *
+ * \param edits The edits of the main file since it was last parsed, in
+ * offsets of the contents it was last parsed with.  The edits must not
+ * overlap; if they do, or are empty, the whole file is parsed again.
+ *
+ * \param options A bitset of options composed of the flags in
+ * CXReparse_Flags.
+ *
+ * \returns 0 if the sources could be reparsed, or one of the error codes of
+ * \c clang_reparseTranslationUnit().
+ */
+CINDEX_LINKAGE int
+clang_reparseTranslationUnitWithEdits(CXTranslationUnit TU,
+                                      unsigned num_unsaved_files,
+                                      struct CXUnsavedFile *unsaved_files,
+                                      unsigned num_edits,
+                                      const CXSourceEdit *edits,
+                                      unsigned options);
+
 /**
   * \brief Categorizes how memory is being used by a translation unit.
   */
@@ -5094,6 +5186,55 @@ CINDEX_LINKAGE
 void clang_sortCodeCompletionResults(CXCompletionResult *Results,
                                      unsigned NumResults);
   
+/**
+ * \brief Flags that can be passed to \c clang_codeCompleteFilterResults()
+ * to control how results are matched against the typed prefix.
+ */
+enum CXCodeCompleteFilter_Flags {
+  /**
+   * \brief Match the typed prefix as a subsequence of the typed text of
+   * each result, rather than as a prefix of it, so that "iwf" matches
+   * "initWithFrame:".
+   */
+  CXCodeCompleteFilter_Fuzzy = 0x01,
+
+  /**
+   * \brief Match letters case-sensitively.
+   */
+  CXCodeCompleteFilter_CaseSensitive = 0x02
+};
+
+/**
+ * \brief Narrow a set of code-completion results to those whose typed text
+ * matches what the user typed after code completion was requested.
+ *
+ * This lets a client keep filtering the results of one
+ * \c clang_codeCompleteAt() call as the user types, rather than performing
+ * code completion again on each keystroke.  The matching results are
+ * ranked, best match first: prefix matches, then matches at the starts of
+ * words, then by priority.
+ *
+ * The typed text of the results is indexed on the first call, and a
+ * \p typed_prefix that extends the one of the previous call on the same
+ * \p Results only rescans the results that matched then.
+ *
+ * \param Results The results of \c clang_codeCompleteAt() to filter.
+ *
+ * \param typed_prefix The text typed since code completion was requested.
+ *
+ * \param options A bitwise OR of the enumerators of the
+ * CXCodeCompleteFilter_Flags enumeration.
+ *
+ * \returns A new \c CXCodeCompleteResults structure, which shares the
+ * completion strings of \p Results and should eventually be freed with
+ * \c clang_disposeCodeCompleteResults(); it may be freed before or after
+ * \p Results.
+ */
+CINDEX_LINKAGE
+CXCodeCompleteResults *
+clang_codeCompleteFilterResults(CXCodeCompleteResults *Results,
+                                const char *typed_prefix, unsigned options);
+
 /**
  * \brief Free the given set of code-completion results.
  */
@@ -5842,7 +5983,15 @@ typedef enum {
    * indexing session assosiated with a \c CXIndexAction object.
    * Bodies in system headers are always skipped.
    */
-  CXIndexOpt_SkipParsedBodiesInSession = 0x10
+  CXIndexOpt_SkipParsedBodiesInSession = 0x10,
+
+  /**
+   * \brief Skip the declarations and references of a header that was
+   * already indexed by another translation unit during an indexing session
+   * associated with a \c CXIndexAction object.
+   * IndexerCallbacks#ppIncludedFile is still invoked for every inclusion.
+   */
+  CXIndexOpt_SkipIndexedHeadersInSession = 0x20
 
 } CXIndexOptFlags;
 
@@ -5907,6 +6056,48 @@ CINDEX_LINKAGE int clang_indexTranslationUnit(CXIndexAction,
                                               unsigned index_options,
                                               CXTranslationUnit);
 
+/**
+ * \brief Index every compile command of a compilation database, on several
+ * threads, via callbacks implemented through #IndexerCallbacks.
+ *
+ * This is equivalent to calling #clang_indexSourceFile for each command,
+ * from its working directory, with the same \c CXIndexAction, except that
+ * the translation units are indexed concurrently and share the session
+ * state: the status of the files they look up and, with
+ * #CXIndexOpt_SkipIndexedHeadersInSession, the set of headers already
+ * indexed.  The translation units also share the module cache named by their
+ * command lines, as they would when built.
+ *
+ * The callbacks are invoked concurrently from the indexing threads, so they
+ * must be thread safe.  Each invocation of IndexerCallbacks#enteredMainFile
+ * starts the callbacks of one translation unit, and every callback until the
+ * translation unit is done is invoked on the same thread.  A non-zero return
+ * of IndexerCallbacks#abortQuery stops the translation unit being indexed;
+ * translation units not yet started are then skipped.
+ *
+ * \param db The compilation database whose compile commands to index.
+ *
+ * \param num_threads The number of threads to index on, or 0 for one per
+ * core.
+ *
+ * \param TU_options The options of the translation units, as for
+ * #clang_parseTranslationUnit.  \c CXTranslationUnit objects are not kept.
+ *
+ * \returns 0 if every translation unit was indexed, possibly with errors
+ * from which the compiler could recover; otherwise the \c CXErrorCode of the
+ * first failure.
+ *
+ * The other parameters are the same as #clang_indexSourceFile.
+ */
+CINDEX_LINKAGE int clang_indexCompilationDatabase(CXIndexAction,
+                                                  CXClientData client_data,
+                                              IndexerCallbacks *index_callbacks,
+                                                  unsigned index_callbacks_size,
+                                                  unsigned index_options,
+                                                  CXCompilationDatabase db,
+                                                  unsigned num_threads,
+                                                  unsigned TU_options);
+
 /**
  * \brief Retrieve the CXIdxFile, file, line, column, and offset represented by
  * the given CXIdxLoc.
@@ -0,0 +1,117 @@
+/*===-- clang-c/SymbolDatabase.h - Persistent symbol index --------*- C -*-===*\
+|*                                                                            *|
+|*                     The LLVM Compiler Infrastructure                       *|
+|*                                                                            *|
+|* This file is distributed under the University of Illinois Open Source      *|
+|* License. See LICENSE.TXT for details.                                      *|
+|*                                                                            *|
+|*===----------------------------------------------------------------------===*|
+|*                                                                            *|
+|* This header provides a public interface to an on-disk index from USRs to  *|
+|* the declarations, definitions and references of the entities they name.    *|
+|*                                                                            *|
+\*===----------------------------------------------------------------------===*/
+
+#ifndef CLANG_C_SYMBOLDATABASE_H
+#define CLANG_C_SYMBOLDATABASE_H
+
+#include "clang-c/Platform.h"
+#include "clang-c/Index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \defgroup SYMBOLDB Symbol database functions
+ * \ingroup CINDEX
+ *
+ * @{
+ */
+
+/**
+ * \brief A persistent index from USRs, as returned by
+ * \c clang_getCursorUSR(), to the places where the entities they name
+ * occur, which answers cross-reference queries without parsing.
+ *
+ * Must be freed by \c clang_SymbolDatabase_dispose.
+ */
+typedef void *CXSymbolDatabase;
+
+/**
+ * \brief The roles of an occurrence of an entity.
+ */
+typedef enum {
+  CXSymbolRole_Declaration = 0x1,
+  CXSymbolRole_Definition = 0x2,
+  CXSymbolRole_Reference = 0x4
+} CXSymbolRole;
+
+/**
+ * \brief Open the symbol database stored in \p path.  A missing file opens
+ * an empty database, which \c clang_SymbolDatabase_save() creates.
+ *
+ * \returns the database, or NULL if \p path exists but is not a symbol
+ * database.
+ */
+CINDEX_LINKAGE CXSymbolDatabase
+clang_SymbolDatabase_open(const char *path);
+
+/**
+ * \brief Free the given symbol database, discarding unsaved updates.
+ */
+CINDEX_LINKAGE void clang_SymbolDatabase_dispose(CXSymbolDatabase);
+
+/**
+ * \brief Record the declarations, definitions and references of the given
+ * translation unit, replacing those recorded before for each of its files.
+ *
+ * Files whose modification time has not changed since they were last
+ * recorded are skipped, so recording every translation unit of a project
+ * only records each header once.
+ *
+ * \returns the number of files recorded.
+ */
+CINDEX_LINKAGE unsigned
+clang_SymbolDatabase_addTranslationUnit(CXSymbolDatabase,
+                                        CXTranslationUnit TU);
+
+/**
+ * \brief Write the updates recorded since the database was opened or last
+ * saved to its file, which is replaced atomically.
+ *
+ * \returns zero on success, or a non-zero \c CXErrorCode on failure.
+ */
+CINDEX_LINKAGE int clang_SymbolDatabase_save(CXSymbolDatabase);
+
+/**
+ * \brief Visitor invoked for each occurrence found by
+ * \c clang_SymbolDatabase_findOccurrences().
+ *
+ * \param roles A bitwise OR of \c CXSymbolRole values.
+ */
+typedef enum CXVisitorResult (*CXSymbolOccurrenceVisitor)(
+    CXClientData client_data, const char *file, unsigned line,
+    unsigned column, unsigned roles);
+
+/**
+ * \brief Find the occurrences of the entity named by \p usr.
+ *
+ * \param roles A bitwise OR of \c CXSymbolRole values; only occurrences
+ * with one of them are visited.
+ *
+ * \returns the number of occurrences visited.
+ */
+CINDEX_LINKAGE unsigned
+clang_SymbolDatabase_findOccurrences(CXSymbolDatabase, const char *usr,
+                                     unsigned roles,
+                                     CXSymbolOccurrenceVisitor visitor,
+                                     CXClientData client_data);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
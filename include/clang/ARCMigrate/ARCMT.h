@@ -69,6 +69,26 @@ bool migrateWithTemporaryFiles(CompilerInvocation &origCI,
                                bool emitPremigrationARCErrors,
                                StringRef plistOut);
 
+/// \brief Migrates the translation units of a project, producing temporary
+/// files and metadata into the \p outputDir path like
+/// migrateWithTemporaryFiles.
+///
+/// Each translation unit is parsed once: the AST that is checked for manual
+/// issues is the one the transformations are applied to.  Translation units
+/// are migrated on up to \p NumThreads threads, 0 meaning one per core, and
+/// the files they migrate are merged through a MigrationResultSet, so a
+/// header included by several of them is written once.  Headers that two
+/// translation units migrate differently are reported through
+/// \p DiagClient and keep the version of the first one in \p Inputs.
+///
+/// \returns false if no error is produced, true otherwise.
+bool migrateProject(ArrayRef<CompilerInvocation *> Invocations,
+                    ArrayRef<FrontendInputFile> Inputs,
+                    DiagnosticConsumer *DiagClient,
+                    StringRef outputDir,
+                    unsigned NumThreads,
+                    bool emitPremigrationARCErrors = false);
+
 /// \brief Get the set of file remappings from the \p outputDir path that
 /// migrateWithTemporaryFiles produced.
 ///
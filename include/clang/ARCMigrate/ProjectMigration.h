@@ -0,0 +1,105 @@
+//===-- ProjectMigration.h - Whole-project ARC migration --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_ARCMIGRATE_PROJECTMIGRATION_H
+#define LLVM_CLANG_ARCMIGRATE_PROJECTMIGRATION_H
+
+#include "clang/ARCMigrate/FileRemapper.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace arcmt {
+
+/// \brief The migrated contents of a file, as produced by the migration of
+/// one translation unit.
+struct MigratedFile {
+  std::string Path;
+  std::string Contents;
+
+  MigratedFile(StringRef Path, StringRef Contents)
+    : Path(Path), Contents(Contents) {}
+};
+
+/// \brief A file that two translation units migrated differently.
+struct MigrationConflict {
+  std::string Path;
+  /// The translation unit whose version of the file is kept.
+  unsigned KeptTU;
+  /// The translation unit whose version of the file is dropped.
+  unsigned DroppedTU;
+};
+
+/// \brief Collects the files migrated by the translation units of a project,
+/// which may finish in any order on different threads.
+///
+/// A header is migrated by every translation unit that includes it; they
+/// normally agree, so each file is written once.  When they do not, which
+/// happens when the header is compiled with different macros or when
+/// translation units see different parts of a class, the version of the
+/// first translation unit in project order is kept and the others are
+/// reported as conflicts, so the result does not depend on the number of
+/// threads.
+class MigrationResultSet {
+  llvm::sys::Mutex Lock;
+  std::map<unsigned, std::vector<MigratedFile> > ByTU;
+
+public:
+  /// \brief Record the files migrated by translation unit \p TU.
+  void addTranslationUnit(unsigned TU, std::vector<MigratedFile> Files) {
+    llvm::MutexGuard Guard(Lock);
+    ByTU[TU].swap(Files);
+  }
+
+  /// \brief Merge the recorded files into \p Remapper.
+  ///
+  /// \returns true if no translation units disagreed; the conflicts are
+  /// appended to \p Conflicts.
+  bool applyTo(FileRemapper &Remapper,
+               std::vector<MigrationConflict> &Conflicts) {
+    llvm::MutexGuard Guard(Lock);
+    // The translation unit whose version was kept, and that version.
+    llvm::StringMap<std::pair<unsigned, const std::string *> > Kept;
+    bool Clean = true;
+    for (std::map<unsigned, std::vector<MigratedFile> >::const_iterator
+             I = ByTU.begin(), E = ByTU.end(); I != E; ++I) {
+      for (unsigned F = 0, FE = I->second.size(); F != FE; ++F) {
+        const MigratedFile &File = I->second[F];
+        std::pair<unsigned, const std::string *> &Entry = Kept[File.Path];
+        if (!Entry.second) {
+          Entry = std::make_pair(I->first, &File.Contents);
+          Remapper.remap(File.Path, llvm::MemoryBuffer::getMemBufferCopy(
+                                        File.Contents, File.Path));
+          continue;
+        }
+        if (*Entry.second == File.Contents)
+          continue;
+        MigrationConflict Conflict;
+        Conflict.Path = File.Path;
+        Conflict.KeptTU = Entry.first;
+        Conflict.DroppedTU = I->first;
+        Conflicts.push_back(Conflict);
+        Clean = false;
+      }
+    }
+    return Clean;
+  }
+};
+
+} // end namespace arcmt
+
+}  // end namespace clang
+
+#endif
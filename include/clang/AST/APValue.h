@@ -150,9 +150,9 @@ public:
   APValue(UninitStruct, unsigned B, unsigned M) : Kind(Uninitialized) {
     MakeStruct(B, M);
   }
-  explicit APValue(const FieldDecl *D, const APValue &V = APValue())
+  explicit APValue(const FieldDecl *D, APValue V = APValue())
       : Kind(Uninitialized) {
-    MakeUnion(); setUnion(D, V);
+    MakeUnion(); setUnion(D, std::move(V));
   }
   APValue(const ValueDecl *Member, bool IsDerivedMember,
           ArrayRef<const CXXRecordDecl*> Path) : Kind(Uninitialized) {
@@ -378,10 +378,10 @@ public:
   void setLValue(LValueBase B, const CharUnits &O,
                  ArrayRef<LValuePathEntry> Path, bool OnePastTheEnd,
                  unsigned CallIndex);
-  void setUnion(const FieldDecl *Field, const APValue &Value) {
+  void setUnion(const FieldDecl *Field, APValue Value) {
     assert(isUnion() && "Invalid accessor");
     ((UnionData*)(char*)Data.buffer)->Field = Field;
-    *((UnionData*)(char*)Data.buffer)->Value = Value;
+    *((UnionData*)(char*)Data.buffer)->Value = std::move(Value);
   }
   void setAddrLabelDiff(const AddrLabelExpr* LHSExpr,
                         const AddrLabelExpr* RHSExpr) {
@@ -24,6 +24,7 @@
 #include "clang/AST/RawCommentList.h"
 #include "clang/AST/TemplateName.h"
 #include "clang/AST/Type.h"
+#include "clang/AST/TypeUniquing.h"
 #include "clang/Basic/AddressSpaces.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/LangOptions.h"
@@ -81,12 +82,14 @@ class ASTContext : public RefCountedBase<ASTContext> {
 
   mutable SmallVector<Type *, 0> Types;
   mutable llvm::FoldingSet<ExtQuals> ExtQualNodes;
-  mutable llvm::FoldingSet<ComplexType> ComplexTypes;
-  mutable llvm::FoldingSet<PointerType> PointerTypes;
+  // Types built from a single other type are uniqued by that type alone,
+  // without profiling a FoldingSetNodeID; see TypeUniquing.h.
+  mutable ComplexTypeSet ComplexTypes;
+  mutable PointerTypeSet PointerTypes;
   mutable llvm::FoldingSet<AdjustedType> AdjustedTypes;
-  mutable llvm::FoldingSet<BlockPointerType> BlockPointerTypes;
-  mutable llvm::FoldingSet<LValueReferenceType> LValueReferenceTypes;
-  mutable llvm::FoldingSet<RValueReferenceType> RValueReferenceTypes;
+  mutable BlockPointerTypeSet BlockPointerTypes;
+  mutable LValueReferenceTypeSet LValueReferenceTypes;
+  mutable RValueReferenceTypeSet RValueReferenceTypes;
   mutable llvm::FoldingSet<MemberPointerType> MemberPointerTypes;
   mutable llvm::FoldingSet<ConstantArrayType> ConstantArrayTypes;
   mutable llvm::FoldingSet<IncompleteArrayType> IncompleteArrayTypes;
@@ -107,7 +110,7 @@ class ASTContext : public RefCountedBase<ASTContext> {
     SubstTemplateTypeParmPackTypes;
   mutable llvm::ContextualFoldingSet<TemplateSpecializationType, ASTContext&>
     TemplateSpecializationTypes;
-  mutable llvm::FoldingSet<ParenType> ParenTypes;
+  mutable ParenTypeSet ParenTypes;
   mutable llvm::FoldingSet<ElaboratedType> ElaboratedTypes;
   mutable llvm::FoldingSet<DependentNameType> DependentNameTypes;
   mutable llvm::ContextualFoldingSet<DependentTemplateSpecializationType,
@@ -115,9 +118,9 @@ class ASTContext : public RefCountedBase<ASTContext> {
     DependentTemplateSpecializationTypes;
   llvm::FoldingSet<PackExpansionType> PackExpansionTypes;
   mutable llvm::FoldingSet<ObjCObjectTypeImpl> ObjCObjectTypes;
-  mutable llvm::FoldingSet<ObjCObjectPointerType> ObjCObjectPointerTypes;
+  mutable ObjCObjectPointerTypeSet ObjCObjectPointerTypes;
   mutable llvm::FoldingSet<AutoType> AutoTypes;
-  mutable llvm::FoldingSet<AtomicType> AtomicTypes;
+  mutable AtomicTypeSet AtomicTypes;
   llvm::FoldingSet<AttributedType> AttributedTypes;
 
   mutable llvm::FoldingSet<QualifiedTemplateName> QualifiedTemplateNames;
@@ -158,6 +161,22 @@ class ASTContext : public RefCountedBase<ASTContext> {
   /// interface.
   llvm::DenseMap<const ObjCMethodDecl*,const ObjCMethodDecl*> ObjCMethodRedecls;
 
+  /// \brief Caches of ObjCInterfaceDecl::lookupMethod() with the default
+  /// flags, from a class and a selector to the method found, if any.
+  ///
+  /// Looking up a method walks the categories and protocols of the class and
+  /// of its superclasses, which is slow for root classes with hundreds of
+  /// categories.  The caches are cleared whenever a category, extension,
+  /// method or protocol is added to an Objective-C container.
+  ///
+  /// With modules, a category or method also becomes visible when its
+  /// module is made visible, which the ASTReader does without touching the
+  /// container, so nothing is cached then.
+  typedef llvm::DenseMap<std::pair<const ObjCInterfaceDecl *, Selector>,
+                         ObjCMethodDecl *> ObjCMethodLookupMap;
+  mutable ObjCMethodLookupMap ObjCInstanceMethodLookups;
+  mutable ObjCMethodLookupMap ObjCClassMethodLookups;
+
   /// \brief Mapping from __block VarDecls to their copy initialization expr.
   llvm::DenseMap<const VarDecl*, Expr*> BlockVarCopyInits;
     
@@ -390,6 +409,34 @@ private:
   /// AST objects will be released when the ASTContext itself is destroyed.
   mutable llvm::BumpPtrAllocator BumpAlloc;
 
+public:
+  /// \brief The kinds of AST nodes whose allocations are accounted for
+  /// separately when allocation accounting is enabled.
+  enum AllocationCategory {
+    AC_Decl,   ///< Indexed by Decl::Kind.
+    AC_Stmt,   ///< Indexed by Stmt::StmtClass.
+    AC_Type,   ///< Indexed by Type::TypeClass.
+    AC_Other,  ///< Everything else allocated through Allocate(); index 0.
+    NumAllocationCategories
+  };
+
+  /// \brief The number of objects of one kind allocated, and their bytes.
+  struct AllocationCounter {
+    uint64_t NumObjects;
+    uint64_t NumBytes;
+
+    AllocationCounter() : NumObjects(0), NumBytes(0) {}
+  };
+
+private:
+  /// \brief Whether allocations are attributed to the kind of node they
+  /// are made for; see enableAllocationAccounting().
+  bool AllocationAccounting;
+
+  /// \brief The allocations of each kind, per category, grown on demand.
+  mutable SmallVector<AllocationCounter, 0>
+      AllocationCounters[NumAllocationCategories];
+
   /// \brief Allocator for partial diagnostics.
   PartialDiagnostic::StorageAllocator DiagAllocator;
 
@@ -473,9 +520,60 @@ public:
   }
 
   void *Allocate(size_t Size, unsigned Align = 8) const {
+    if (AllocationAccounting)
+      recordAllocation(AC_Other, 0, Size);
+    return BumpAlloc.Allocate(Size, Align);
+  }
+
+  /// \brief Allocate memory for a node of kind \p Kind in category \p Cat,
+  /// attributing it to that kind when allocation accounting is enabled.
+  ///
+  /// This is what the placement operator new of Decl, Stmt and Type use.
+  void *Allocate(size_t Size, unsigned Align, AllocationCategory Cat,
+                 unsigned Kind) const {
+    if (AllocationAccounting)
+      recordAllocation(Cat, Kind, Size);
     return BumpAlloc.Allocate(Size, Align);
   }
   void Deallocate(void *Ptr) const { }
+
+  /// \brief Start attributing the bytes allocated for the AST to the kinds
+  /// of Decl, Stmt and Type they are allocated for, as reported by
+  /// PrintAllocationStats().
+  ///
+  /// This costs a branch per allocation when disabled and a counter update
+  /// when enabled, so it is off unless -print-stats is given.
+  void enableAllocationAccounting() { AllocationAccounting = true; }
+  bool isAllocationAccountingEnabled() const { return AllocationAccounting; }
+
+  void recordAllocation(AllocationCategory Cat, unsigned Kind,
+                        size_t Size) const {
+    SmallVectorImpl<AllocationCounter> &Counters = AllocationCounters[Cat];
+    if (Kind >= Counters.size())
+      Counters.resize(Kind + 1);
+    ++Counters[Kind].NumObjects;
+    Counters[Kind].NumBytes += Size;
+  }
+
+  /// \brief The allocations of kind \p Kind in category \p Cat recorded so
+  /// far.
+  AllocationCounter getAllocationCounter(AllocationCategory Cat,
+                                         unsigned Kind) const {
+    const SmallVectorImpl<AllocationCounter> &Counters =
+        AllocationCounters[Cat];
+    return Kind < Counters.size() ? Counters[Kind] : AllocationCounter();
+  }
+
+  /// \brief Print the recorded allocations per kind, largest first.
+  void PrintAllocationStats(raw_ostream &OS) const;
+
+  /// \brief Double the size of the AST allocator's slabs every \p N slabs.
+  ///
+  /// Translation units whose AST takes gigabytes, such as unity builds,
+  /// spend less time in malloc and waste less memory at the end of their
+  /// slabs with a small value.  This must be called right after the
+  /// ASTContext is created, before the AST grows.
+  void setAllocatorSlabGrowth(unsigned N) { BumpAlloc.setSlabGrowth(N); }
   
   /// Return the total amount of physical memory allocated for representing
   /// AST nodes and type information.
@@ -2114,6 +2212,40 @@ public:
     ObjCMethodRedecls[MD] = Redecl;
   }
 
+  /// \brief Find the cached result of looking up \p Sel in \p D.
+  ///
+  /// \returns true if the lookup is cached, in which case \p Result is set to
+  /// the method found, or null if there is none.
+  bool lookupCachedObjCMethod(const ObjCInterfaceDecl *D, Selector Sel,
+                              bool isInstance,
+                              ObjCMethodDecl *&Result) const {
+    if (LangOpts.Modules)
+      return false;
+    const ObjCMethodLookupMap &Map =
+        isInstance ? ObjCInstanceMethodLookups : ObjCClassMethodLookups;
+    ObjCMethodLookupMap::const_iterator I = Map.find(std::make_pair(D, Sel));
+    if (I == Map.end())
+      return false;
+    Result = I->second;
+    return true;
+  }
+
+  void cacheObjCMethodLookup(const ObjCInterfaceDecl *D, Selector Sel,
+                             bool isInstance, ObjCMethodDecl *Result) const {
+    if (LangOpts.Modules)
+      return;
+    ObjCMethodLookupMap &Map =
+        isInstance ? ObjCInstanceMethodLookups : ObjCClassMethodLookups;
+    Map[std::make_pair(D, Sel)] = Result;
+  }
+
+  /// \brief Forget all cached method lookups, after a change to an
+  /// Objective-C container that may change their results.
+  void invalidateObjCMethodLookups() const {
+    ObjCInstanceMethodLookups.clear();
+    ObjCClassMethodLookups.clear();
+  }
+
   /// \brief Returns the Objective-C interface that \p ND belongs to if it is
   /// an Objective-C method/property/ivar etc. that is part of an interface,
   /// otherwise returns null.
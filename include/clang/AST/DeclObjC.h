@@ -14,6 +14,7 @@
 #ifndef LLVM_CLANG_AST_DECLOBJC_H
 #define LLVM_CLANG_AST_DECLOBJC_H
 
+#include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/SelectorLocationsKind.h"
 #include "llvm/ADT/STLExtras.h"
@@ -1235,9 +1236,10 @@ public:
 
   /// \brief Set the raw pointer to the start of the category/extension
   /// list.
-  void setCategoryListRaw(ObjCCategoryDecl *category) {
-    data().CategoryList = category;
-  }
+  ///
+  /// This is how both Sema and the ASTReader register a category, so it
+  /// also forgets the cached method lookups.
+  void setCategoryListRaw(ObjCCategoryDecl *category);
 
   ObjCPropertyDecl
     *FindPropertyVisibleInPrimaryClass(IdentifierInfo *PropertyId) const;
@@ -1278,6 +1280,10 @@ public:
                           
   // Lookup a method. First, we search locally. If a method isn't
   // found, we search referenced protocols and class categories.
+  //
+  // Lookups with the default flags are cached in the ASTContext, which
+  // Sema, CodeGen and the other clients of the AST share; see
+  // ASTContext::lookupCachedObjCMethod.
   ObjCMethodDecl *lookupMethod(Selector Sel, bool isInstance,
                                bool shallowCategoryLookup = false,
                                bool followSuper = true,
@@ -2470,6 +2476,11 @@ ObjCInterfaceDecl::filtered_category_iterator<Filter>::operator++() {
   return *this;
 }
 
+inline void ObjCInterfaceDecl::setCategoryListRaw(ObjCCategoryDecl *category) {
+  data().CategoryList = category;
+  getASTContext().invalidateObjCMethodLookups();
+}
+
 inline bool ObjCInterfaceDecl::isVisibleCategory(ObjCCategoryDecl *Cat) {
   return !Cat->isHidden();
 }
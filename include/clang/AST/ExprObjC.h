@@ -340,6 +340,59 @@ public:
   friend class ASTStmtWriter;
 };
 
+/// \brief Determine whether \p E is an Objective-C object literal whose value
+/// is known at compile time: a string literal, a boxed numeric, character or
+/// BOOL literal, or an array or dictionary literal of such constants whose
+/// dictionary keys are distinct string literals.
+///
+/// CodeGen can emit such a literal as an immutable constant collection, like
+/// \c __NSConstantString, instead of a call to \c +arrayWithObjects:count: or
+/// \c +dictionaryWithObjects:forKeys:count: on every evaluation, when
+/// \c -fobjc-constant-literals is enabled and the runtime supports it.
+inline bool isObjCConstantLiteral(const Expr *E) {
+  E = E->IgnoreParenImpCasts();
+  if (isa<ObjCStringLiteral>(E))
+    return true;
+
+  if (const ObjCBoxedExpr *Boxed = dyn_cast<ObjCBoxedExpr>(E)) {
+    const Expr *Sub = Boxed->getSubExpr()->IgnoreParens();
+    if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(Sub))
+      if (UO->getOpcode() == UO_Minus || UO->getOpcode() == UO_Plus)
+        Sub = UO->getSubExpr()->IgnoreParens();
+    return isa<IntegerLiteral>(Sub) || isa<FloatingLiteral>(Sub) ||
+           isa<CharacterLiteral>(Sub) || isa<ObjCBoolLiteralExpr>(Sub);
+  }
+
+  if (const ObjCArrayLiteral *Array = dyn_cast<ObjCArrayLiteral>(E)) {
+    for (unsigned I = 0, N = Array->getNumElements(); I != N; ++I)
+      if (!isObjCConstantLiteral(Array->getElement(I)))
+        return false;
+    return true;
+  }
+
+  if (const ObjCDictionaryLiteral *Dict = dyn_cast<ObjCDictionaryLiteral>(E)) {
+    for (unsigned I = 0, N = Dict->getNumElements(); I != N; ++I) {
+      ObjCDictionaryElement Element = Dict->getKeyValueElement(I);
+      if (Element.isPackExpansion() ||
+          !isObjCConstantLiteral(Element.Value))
+        return false;
+      const ObjCStringLiteral *Key =
+          dyn_cast<ObjCStringLiteral>(Element.Key->IgnoreParenImpCasts());
+      if (!Key)
+        return false;
+      // A constant dictionary cannot represent a key that is overwritten.
+      for (unsigned J = 0; J != I; ++J)
+        if (cast<ObjCStringLiteral>(
+                Dict->getKeyValueElement(J).Key->IgnoreParenImpCasts())
+                ->getString()->getBytes() == Key->getString()->getBytes())
+          return false;
+    }
+    return true;
+  }
+
+  return false;
+}
+
 
 /// ObjCEncodeExpr, used for \@encode in Objective-C.  \@encode has the same
 /// type and behavior as StringLiteral except that the string initializer is
@@ -252,6 +252,32 @@ public:
   { 
     return false;
   }
+
+  /// \brief Provide the sizes of a record layout that layoutRecordType does
+  /// not cover.
+  ///
+  /// Called after layoutRecordType provided the layout of \p Record.  On
+  /// its own, that layout makes the data size the complete size and leaves
+  /// the non-virtual size and alignment to be recomputed, which is only
+  /// right for records whose layout cannot be reused by a derived class; a
+  /// source that has the layout the compiler computed, such as an AST file,
+  /// provides these too, so that derived classes reuse the tail padding and
+  /// lay out their bases as the ABI requires.
+  ///
+  /// \param DataSize The size of the record without tail padding.
+  ///
+  /// \param NonVirtualSize The size of the record without its virtual bases.
+  ///
+  /// \param NonVirtualAlignment The alignment of the record without its
+  /// virtual bases.
+  ///
+  /// \returns true if the sizes were provided, false otherwise.
+  virtual bool getRecordLayoutSizes(const RecordDecl *Record,
+                                    CharUnits &DataSize,
+                                    CharUnits &NonVirtualSize,
+                                    CharUnits &NonVirtualAlignment) {
+    return false;
+  }
   
   //===--------------------------------------------------------------------===//
   // Queries for performance analysis.
@@ -0,0 +1,111 @@
+//===--- TypeUniquing.h - Keys for uniquing simple types --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the keys by which ASTContext uniques the types that are
+//  built from a single other type, such as pointer and reference types.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_AST_TYPEUNIQUING_H
+#define LLVM_CLANG_AST_TYPEUNIQUING_H
+
+#include "clang/AST/Type.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/UniqueNodeSet.h"
+#include <utility>
+
+namespace clang {
+
+/// \brief The hash of a type as a uniquing key component.
+///
+/// This hashes every bit of the opaque pointer: DenseMapInfo<void *> drops
+/// the low bits, which hold the fast qualifiers, so \c const T and \c T
+/// would collide.
+inline unsigned getTypeHash(QualType T) {
+  return llvm::hash_value(T.getAsOpaquePtr());
+}
+
+/// \brief Uniquing information for a type class whose nodes are identified
+/// by one QualType, which \p Get retrieves from a node.
+///
+/// The key is hashed from the QualType's opaque pointer, which already
+/// holds the canonical components, so a lookup hashes one pointer instead
+/// of building a FoldingSetNodeID.
+template <typename T, QualType (T::*Get)() const>
+struct SingleTypeUniquingInfo {
+  typedef QualType KeyT;
+
+  static unsigned getHashValue(QualType Key) {
+    return getTypeHash(Key);
+  }
+  static bool isEqual(QualType Key, const T *Node) {
+    return (Node->*Get)() == Key;
+  }
+};
+
+/// \brief Uniquing information for lvalue reference types, which are also
+/// identified by whether they were spelled as lvalue references.
+struct LValueReferenceTypeUniquingInfo {
+  typedef std::pair<QualType, bool> KeyT;
+
+  static unsigned getHashValue(const KeyT &Key) {
+    return llvm::hash_combine(Key.first.getAsOpaquePtr(), Key.second);
+  }
+  static bool isEqual(const KeyT &Key, const LValueReferenceType *Node) {
+    return Node->getPointeeTypeAsWritten() == Key.first &&
+           Node->isSpelledAsLValue() == Key.second;
+  }
+};
+
+/// \brief Uniquing information for rvalue reference types.
+struct RValueReferenceTypeUniquingInfo {
+  typedef QualType KeyT;
+
+  static unsigned getHashValue(QualType Key) {
+    return getTypeHash(Key);
+  }
+  static bool isEqual(QualType Key, const RValueReferenceType *Node) {
+    return Node->getPointeeTypeAsWritten() == Key;
+  }
+};
+
+typedef llvm::UniqueNodeSet<
+    ComplexType,
+    SingleTypeUniquingInfo<ComplexType, &ComplexType::getElementType> >
+  ComplexTypeSet;
+typedef llvm::UniqueNodeSet<
+    PointerType,
+    SingleTypeUniquingInfo<PointerType, &PointerType::getPointeeType> >
+  PointerTypeSet;
+typedef llvm::UniqueNodeSet<
+    BlockPointerType,
+    SingleTypeUniquingInfo<BlockPointerType,
+                           &BlockPointerType::getPointeeType> >
+  BlockPointerTypeSet;
+typedef llvm::UniqueNodeSet<LValueReferenceType,
+                            LValueReferenceTypeUniquingInfo>
+  LValueReferenceTypeSet;
+typedef llvm::UniqueNodeSet<RValueReferenceType,
+                            RValueReferenceTypeUniquingInfo>
+  RValueReferenceTypeSet;
+typedef llvm::UniqueNodeSet<
+    ParenType, SingleTypeUniquingInfo<ParenType, &ParenType::getInnerType> >
+  ParenTypeSet;
+typedef llvm::UniqueNodeSet<
+    ObjCObjectPointerType,
+    SingleTypeUniquingInfo<ObjCObjectPointerType,
+                           &ObjCObjectPointerType::getPointeeType> >
+  ObjCObjectPointerTypeSet;
+typedef llvm::UniqueNodeSet<
+    AtomicType, SingleTypeUniquingInfo<AtomicType, &AtomicType::getValueType> >
+  AtomicTypeSet;
+
+} // end namespace clang
+
+#endif
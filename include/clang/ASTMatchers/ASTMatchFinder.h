@@ -42,6 +42,12 @@
 #define LLVM_CLANG_AST_MATCHERS_AST_MATCH_FINDER_H
 
 #include "clang/ASTMatchers/ASTMatchers.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 namespace clang {
 
@@ -102,8 +108,73 @@ public:
     ///
     /// Optionally override to do per translation unit tasks.
     virtual void onEndOfTranslationUnit() {}
+
+    /// \brief An id used to group the matchers of this callback in the
+    /// profile collected with MatchFinderOptions::CheckProfiling.
+    ///
+    /// Callbacks with the same id are profiled together.
+    virtual StringRef getID() const { return "<unknown>"; }
+  };
+
+  /// \brief The cost of the matchers registered with one callback id.
+  struct MatcherProfile {
+    /// \brief The time spent matching, including in nested matchers.
+    llvm::TimeRecord Time;
+    /// \brief The number of nodes the matchers were tried on.
+    unsigned NumTries;
+    /// \brief The number of matches, that is of calls to the callback.
+    unsigned NumMatches;
+
+    MatcherProfile() : NumTries(0), NumMatches(0) {}
   };
 
+  struct MatchFinderOptions {
+    struct Profiling {
+      Profiling(llvm::StringMap<MatcherProfile> &Records)
+          : Records(Records) {}
+
+      /// \brief Per callback id profiles, accumulated over every
+      /// translation unit matched.
+      llvm::StringMap<MatcherProfile> &Records;
+    };
+
+    /// \brief Enables per-check profiling of the matchers, at the cost of
+    /// reading the clock around every matcher invocation.
+    llvm::Optional<Profiling> CheckProfiling;
+
+    /// \brief Whether the results of ancestor queries (hasAncestor,
+    /// hasParent) are shared by all matchers.
+    ///
+    /// The match visitor already memoizes descendant queries per
+    /// (matcher, node, bound nodes) triple; with this set, it memoizes the
+    /// walks up the parent map as well, so that matchers that each ask
+    /// whether a node has some ancestor stop re-walking the same parent
+    /// chains.  The parent map itself is built once per ASTContext and
+    /// shared by every matcher.
+    bool MemoizeAncestorMatches;
+
+    MatchFinderOptions() : MemoizeAncestorMatches(true) {}
+  };
+
+  /// \brief Print the profile \p Records, the most expensive callback ids
+  /// first.
+  static void printProfile(const llvm::StringMap<MatcherProfile> &Records,
+                           raw_ostream &OS) {
+    std::vector<const llvm::StringMapEntry<MatcherProfile> *> Sorted;
+    for (llvm::StringMap<MatcherProfile>::const_iterator I = Records.begin(),
+                                                         E = Records.end();
+         I != E; ++I)
+      Sorted.push_back(&*I);
+    std::sort(Sorted.begin(), Sorted.end(), ProfileOrder());
+    for (unsigned I = 0, E = Sorted.size(); I != E; ++I) {
+      const MatcherProfile &P = Sorted[I]->getValue();
+      OS << llvm::format("%10.4f", P.Time.getWallTime()) << "s  "
+         << llvm::format("%10u", P.NumTries) << " tries  "
+         << llvm::format("%8u", P.NumMatches) << " matches  "
+         << Sorted[I]->getKey() << "\n";
+    }
+  }
+
   /// \brief Called when parsing is finished. Intended for testing only.
   class ParsingDoneTestCallback {
   public:
@@ -111,7 +182,7 @@ public:
     virtual void run() = 0;
   };
 
-  MatchFinder();
+  MatchFinder(MatchFinderOptions Options = MatchFinderOptions());
   ~MatchFinder();
 
   /// \brief Adds a matcher to execute when running over the AST.
@@ -179,8 +250,17 @@ private:
   std::vector<std::pair<internal::DynTypedMatcher, MatchCallback *> >
     MatcherCallbackPairs;
 
+  const MatchFinderOptions Options;
+
   /// \brief Called when parsing is done.
   ParsingDoneTestCallback *ParsingDone;
+
+  struct ProfileOrder {
+    bool operator()(const llvm::StringMapEntry<MatcherProfile> *LHS,
+                    const llvm::StringMapEntry<MatcherProfile> *RHS) const {
+      return RHS->getValue().Time < LHS->getValue().Time;
+    }
+  };
 };
 
 /// \brief Returns the results of matching \p Matcher on \p Node.
@@ -115,12 +115,21 @@ public:
 struct UninitVariablesAnalysisStats {
   unsigned NumVariablesAnalyzed;
   unsigned NumBlockVisits;
+  /// Whether the analysis stopped after \c maxBlockVisits visits, in which
+  /// case no use was reported.
+  bool HitBlockVisitLimit;
 };
 
+/// Run the analysis and report uses to \p handler.  The dataflow visits
+/// \p cfg's blocks at most \p maxBlockVisits times, if not 0, so that huge
+/// functions, whose blocks each carry a value for every variable, cannot
+/// make it quadratic; past that it stops without reporting anything, and
+/// sets \c stats.HitBlockVisitLimit so that the caller can say so.
 void runUninitializedVariablesAnalysis(const DeclContext &dc, const CFG &cfg,
                                        AnalysisDeclContext &ac,
                                        UninitVariablesHandler &handler,
-                                       UninitVariablesAnalysisStats &stats);
+                                       UninitVariablesAnalysisStats &stats,
+                                       unsigned maxBlockVisits = 0);
 
 }
 #endif
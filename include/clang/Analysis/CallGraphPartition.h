@@ -0,0 +1,143 @@
+//===--- CallGraphPartition.h - Call graph components -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines partitionCallGraph, which splits the functions of a
+//  translation unit into groups that never call each other, so that the
+//  static analyzer can analyze and report on each group separately.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_ANALYSIS_CALLGRAPHPARTITION_H
+#define LLVM_CLANG_ANALYSIS_CALLGRAPHPARTITION_H
+
+#include "clang/AST/DeclBase.h"
+#include "clang/Analysis/CallGraph.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <vector>
+
+namespace clang {
+
+/// \brief A set of functions to be analyzed together, in order.
+typedef SmallVector<Decl *, 8> CallGraphPartitionGroup;
+
+namespace detail {
+/// \brief Union-find over the declarations of a call graph.
+class CallGraphComponents {
+  llvm::DenseMap<const Decl *, unsigned> Index;
+  SmallVector<unsigned, 64> Parent;
+
+public:
+  unsigned getID(const Decl *D) {
+    std::pair<llvm::DenseMap<const Decl *, unsigned>::iterator, bool> Res =
+        Index.insert(std::make_pair(D, unsigned(Parent.size())));
+    if (Res.second)
+      Parent.push_back(Parent.size());
+    return Res.first->second;
+  }
+
+  unsigned find(unsigned ID) {
+    while (Parent[ID] != ID) {
+      Parent[ID] = Parent[Parent[ID]];
+      ID = Parent[ID];
+    }
+    return ID;
+  }
+
+  void join(unsigned A, unsigned B) {
+    A = find(A);
+    B = find(B);
+    // Keep the smaller ID as the root, so the result does not depend on the
+    // order the edges are visited in.
+    if (A != B)
+      Parent[std::max(A, B)] = std::min(A, B);
+  }
+};
+} // end namespace detail
+
+/// \brief Split \p Order, the functions of \p CG in the order they would be
+/// analyzed in, into groups such that no function of one group calls a
+/// function of another, directly or through other functions of \p CG.
+///
+/// Each group keeps the relative order of \p Order, so analyzing the groups
+/// one after the other inlines and skips the same functions as analyzing
+/// \p Order does.  The groups are sorted by the location of their first
+/// function in the source, so the result does not depend on the addresses
+/// of the declarations.
+///
+/// The groups do not share any function, but they do share the ASTContext,
+/// the SourceManager and the BugReporter of the translation unit, none of
+/// which is thread-safe, so they must still be analyzed one at a time.
+inline void
+partitionCallGraph(const CallGraph &CG, ArrayRef<Decl *> Order,
+                   SourceManager &SM,
+                   std::vector<CallGraphPartitionGroup> &Groups) {
+  Groups.clear();
+  detail::CallGraphComponents Components;
+  // Number the functions in the order they are analyzed in first.
+  for (unsigned I = 0, E = Order.size(); I != E; ++I)
+    Components.getID(Order[I]);
+  for (unsigned I = 0, E = Order.size(); I != E; ++I) {
+    const CallGraphNode *N = CG.getNode(Order[I]);
+    if (!N)
+      continue;
+    unsigned Caller = Components.getID(Order[I]);
+    for (CallGraphNode::const_iterator C = N->begin(), CE = N->end(); C != CE;
+         ++C)
+      if (const Decl *Callee = (*C)->getDecl())
+        Components.join(Caller, Components.getID(Callee));
+  }
+
+  // Roots are the smallest ID of their component, so they are numbered in
+  // order of first appearance too.
+  llvm::DenseMap<unsigned, unsigned> GroupOfRoot;
+  for (unsigned I = 0, E = Order.size(); I != E; ++I) {
+    unsigned Root = Components.find(Components.getID(Order[I]));
+    std::pair<llvm::DenseMap<unsigned, unsigned>::iterator, bool> Res =
+        GroupOfRoot.insert(std::make_pair(Root, unsigned(Groups.size())));
+    if (Res.second)
+      Groups.push_back(CallGraphPartitionGroup());
+    Groups[Res.first->second].push_back(Order[I]);
+  }
+
+  // Sort by the first location of each group; functions without one, such
+  // as implicit declarations, go last.  The groups are in order of first
+  // appearance in \p Order, so a stable sort breaks ties by it.
+  SmallVector<std::pair<SourceLocation, unsigned>, 16> Firsts;
+  for (unsigned G = 0, GE = Groups.size(); G != GE; ++G) {
+    SourceLocation First;
+    for (unsigned I = 0, E = Groups[G].size(); I != E; ++I) {
+      SourceLocation Loc = SM.getExpansionLoc(Groups[G][I]->getLocation());
+      if (Loc.isValid() &&
+          (First.isInvalid() || SM.isBeforeInTranslationUnit(Loc, First)))
+        First = Loc;
+    }
+    Firsts.push_back(std::make_pair(First, G));
+  }
+  std::stable_sort(Firsts.begin(), Firsts.end(),
+                   [&SM](const std::pair<SourceLocation, unsigned> &A,
+                         const std::pair<SourceLocation, unsigned> &B) {
+    if (A.first.isInvalid() || B.first.isInvalid())
+      return B.first.isInvalid() && A.first.isValid();
+    return SM.isBeforeInTranslationUnit(A.first, B.first);
+  });
+
+  std::vector<CallGraphPartitionGroup> Sorted(Groups.size());
+  for (unsigned G = 0, GE = Firsts.size(); G != GE; ++G)
+    Sorted[G].swap(Groups[Firsts[G].second]);
+  Groups.swap(Sorted);
+}
+
+} // end namespace clang
+
+#endif
@@ -19,6 +19,7 @@
 #include "clang/Basic/DiagnosticOptions.h"
 #include "clang/Basic/SourceLocation.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include <list>
@@ -260,6 +261,37 @@ private:
   /// so we can get back at it when we 'pop'.
   std::vector<DiagState *> DiagStateOnPushStack;
 
+  /// \brief The diagnostics that are ignored at every location, whatever
+  /// the DiagState; only meaningful for those set in IgnoredEverywhereKnown.
+  mutable llvm::BitVector IgnoredEverywhere;
+
+  /// \brief The diagnostics whose bit in IgnoredEverywhere is up to date.
+  ///
+  /// Cleared whenever a mapping, a DiagState or an option that can make a
+  /// diagnostic fire changes.
+  mutable llvm::BitVector IgnoredEverywhereKnown;
+
+  /// \brief The number of DiagStatePoints when IgnoredEverywhereKnown was
+  /// last cleared.
+  ///
+  /// Checked on every query, so that points added without going through
+  /// PushDiagStatePoint, such as those ASTReader reads from a PCH or module,
+  /// also invalidate the summary.
+  mutable unsigned IgnoredEverywhereNumPoints;
+
+  void invalidateIgnoredEverywhere() const {
+    IgnoredEverywhereKnown.reset();
+    IgnoredEverywhereNumPoints = DiagStatePoints.size();
+  }
+
+  /// \brief Compute whether \p DiagID is ignored in every DiagState under the
+  /// current -w, -Weverything and -pedantic options.
+  ///
+  /// Location-dependent suppression (such as in system headers) and
+  /// transient suppression (__extension__, setSuppressAllDiagnostics) can
+  /// only ignore more diagnostics, so they are not taken into account.
+  bool computeIgnoredEverywhere(unsigned DiagID) const;
+
   DiagState *GetCurDiagState() const {
     assert(!DiagStatePoints.empty());
     return DiagStatePoints.back().State;
@@ -274,6 +306,7 @@ private:
             DiagStatePoints.back().Loc.isBeforeInTranslationUnitThan(Loc)) &&
            "Previous point loc comes after or is the same as new one");
     DiagStatePoints.push_back(DiagStatePoint(State, Loc));
+    invalidateIgnoredEverywhere();
   }
 
   /// \brief Finds the DiagStatePoint that contains the diagnostic state of
@@ -431,14 +464,20 @@ public:
   /// \brief When set to true, any unmapped warnings are ignored.
   ///
   /// If this and WarningsAsErrors are both set, then this one wins.
-  void setIgnoreAllWarnings(bool Val) { IgnoreAllWarnings = Val; }
+  void setIgnoreAllWarnings(bool Val) {
+    IgnoreAllWarnings = Val;
+    invalidateIgnoredEverywhere();
+  }
   bool getIgnoreAllWarnings() const { return IgnoreAllWarnings; }
 
   /// \brief When set to true, any unmapped ignored warnings are no longer
   /// ignored.
   ///
   /// If this and IgnoreAllWarnings are both set, then that one wins.
-  void setEnableAllWarnings(bool Val) { EnableAllWarnings = Val; }
+  void setEnableAllWarnings(bool Val) {
+    EnableAllWarnings = Val;
+    invalidateIgnoredEverywhere();
+  }
   bool getEnableAllWarnings() const { return EnableAllWarnings; }
 
   /// \brief When set to true, any warnings reported are issued as errors.
@@ -508,6 +547,7 @@ public:
   /// This corresponds to the GCC -pedantic and -pedantic-errors option.
   void setExtensionHandlingBehavior(ExtensionHandling H) {
     ExtBehavior = H;
+    invalidateIgnoredEverywhere();
   }
   ExtensionHandling getExtensionHandlingBehavior() const { return ExtBehavior; }
 
@@ -622,6 +662,9 @@ public:
 
   /// \brief Reset the state of the diagnostic object to its initial 
   /// configuration.
+  ///
+  /// This recreates the DiagStates, so it also invalidates the summary of
+  /// the diagnostics ignored everywhere.
   void Reset();
   
   //===--------------------------------------------------------------------===//
@@ -635,9 +678,36 @@ public:
   /// \param Loc The source location we are interested in finding out the
   /// diagnostic state. Can be null in order to query the latest state.
   Level getDiagnosticLevel(unsigned DiagID, SourceLocation Loc) const {
+    if (isIgnoredEverywhere(DiagID))
+      return Ignored;
     return (Level)Diags->getDiagnosticLevel(DiagID, Loc, *this);
   }
 
+  /// \brief Determine whether \p DiagID is ignored at every location, under
+  /// every diagnostic pragma seen so far.
+  ///
+  /// This is a bit test once computed, so it is the cheap way for hot paths
+  /// to skip work for a warning that is disabled everywhere, without the
+  /// binary search through DiagStatePoints that getDiagnosticLevel needs.
+  bool isIgnoredEverywhere(unsigned DiagID) const {
+    if (DiagStatePoints.size() != IgnoredEverywhereNumPoints)
+      invalidateIgnoredEverywhere();
+    if (DiagID >= IgnoredEverywhereKnown.size()) {
+      IgnoredEverywhere.resize(diag::DIAG_UPPER_LIMIT);
+      IgnoredEverywhereKnown.resize(diag::DIAG_UPPER_LIMIT);
+      if (DiagID >= diag::DIAG_UPPER_LIMIT)
+        return false; // A custom diagnostic.
+    }
+    if (!IgnoredEverywhereKnown.test(DiagID)) {
+      IgnoredEverywhereKnown.set(DiagID);
+      if (computeIgnoredEverywhere(DiagID))
+        IgnoredEverywhere.set(DiagID);
+      else
+        IgnoredEverywhere.reset(DiagID);
+    }
+    return IgnoredEverywhere.test(DiagID);
+  }
+
   /// \brief Issue the message to the client.
   ///
   /// This actually returns an instance of DiagnosticBuilder which emits the
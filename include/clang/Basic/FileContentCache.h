@@ -0,0 +1,224 @@
+//===--- FileContentCache.h - Buffers shared by file contents ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the FileContentCache class, which keeps one memory buffer
+/// for each distinct file contents read by the FileManagers that share it.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_FILECONTENTCACHE_H
+#define LLVM_CLANG_BASIC_FILECONTENTCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
+#include <ctime>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace clang {
+
+/// \brief A thread-safe cache of file contents, keyed both by the file and
+/// by an MD5 of the contents, which several FileManagers can share.
+///
+/// Side-by-side SDKs ship many byte-identical headers under different
+/// paths.  Each path is still read once, since only its contents tell that
+/// it is a duplicate, but every copy after the first is dropped in favor
+/// of the buffer already in the cache, so identical headers take their
+/// memory once.  Reading the same file again, from any FileManager sharing
+/// the cache, costs no I/O at all while its size and modification time are
+/// unchanged.
+///
+/// The buffers are owned by the cache and live until it is purged or
+/// destroyed, so SourceManager must not free them (see
+/// ContentCache::replaceBuffer's DoNotFree).  A batch that compiles many
+/// translation units should call purge() between them, when no
+/// SourceManager holds a buffer, to bound what the cache keeps.  The
+/// buffers are copies in memory rather than mappings of the files, so the
+/// cache keeps no file open, and the headers can be edited or deleted while
+/// it lives.  A shared buffer is named after the first path it was read
+/// from; clients should name files by their FileEntry, as SourceManager
+/// does.
+class FileContentCache
+    : public llvm::ThreadSafeRefCountedBase<FileContentCache> {
+public:
+  /// \brief What identifies the contents of a file on disk.
+  ///
+  /// The modification time has a resolution of one second, like that of
+  /// FileEntry, so a file rewritten within the second it was read, with the
+  /// same size, is served stale.  Files that may change while the cache
+  /// lives, such as headers generated during the build, should be read with
+  /// FileManager::getBufferForFile instead.
+  struct FileKey {
+    llvm::sys::fs::UniqueID UniqueID;
+    off_t Size;
+    time_t ModTime;
+
+    FileKey(const llvm::sys::fs::UniqueID &UniqueID, off_t Size,
+            time_t ModTime)
+      : UniqueID(UniqueID), Size(Size), ModTime(ModTime) {}
+
+    bool operator<(const FileKey &RHS) const {
+      return std::tie(UniqueID, Size, ModTime) <
+             std::tie(RHS.UniqueID, RHS.Size, RHS.ModTime);
+    }
+  };
+
+private:
+  mutable llvm::sys::Mutex Lock;
+
+  /// The buffer last read for each file.
+  std::map<FileKey, const llvm::MemoryBuffer *> ByFile;
+
+  /// The distinct buffers, owned, by the MD5 of their contents; more than
+  /// one only on a collision.
+  llvm::StringMap<std::vector<llvm::MemoryBuffer *> > ByContents;
+
+  unsigned NumFileHits;
+  unsigned NumContentHits;
+  uint64_t BytesShared;
+  /// The size of the buffers in ByContents.
+  uint64_t BytesCached;
+
+  void deleteBuffers() {
+    for (llvm::StringMap<std::vector<llvm::MemoryBuffer *> >::iterator
+             I = ByContents.begin(), E = ByContents.end();
+         I != E; ++I)
+      for (unsigned J = 0, N = I->second.size(); J != N; ++J)
+        delete I->second[J];
+  }
+
+  /// Forget the earlier versions of the file \p Key, whose buffers can no
+  /// longer be looked up by file.
+  void eraseOtherVersions(const FileKey &Key) {
+    FileKey First(Key.UniqueID, 0, 0);
+    std::map<FileKey, const llvm::MemoryBuffer *>::iterator
+        I = ByFile.lower_bound(First);
+    while (I != ByFile.end() && I->first.UniqueID == Key.UniqueID) {
+      if (I->first.Size != Key.Size || I->first.ModTime != Key.ModTime)
+        ByFile.erase(I++);
+      else
+        ++I;
+    }
+  }
+
+  FileContentCache(const FileContentCache &) LLVM_DELETED_FUNCTION;
+  void operator=(const FileContentCache &) LLVM_DELETED_FUNCTION;
+
+public:
+  FileContentCache()
+    : NumFileHits(0), NumContentHits(0), BytesShared(0), BytesCached(0) {}
+
+  ~FileContentCache() { deleteBuffers(); }
+
+  /// \brief Free every buffer if they take more than \p MaxBytes, so that
+  /// later reads start over.
+  ///
+  /// No buffer returned by the cache may be in use then, so this is for a
+  /// driver to call between translation units, once their SourceManagers
+  /// are gone.
+  ///
+  /// \returns true if the buffers were freed.
+  bool purge(uint64_t MaxBytes = 0) {
+    llvm::MutexGuard Guard(Lock);
+    if (BytesCached <= MaxBytes)
+      return false;
+    deleteBuffers();
+    ByContents.clear();
+    ByFile.clear();
+    BytesCached = 0;
+    return true;
+  }
+
+  /// \brief The buffer already read for the file \p Key, or null.
+  const llvm::MemoryBuffer *lookup(const FileKey &Key) {
+    llvm::MutexGuard Guard(Lock);
+    std::map<FileKey, const llvm::MemoryBuffer *>::iterator I =
+        ByFile.find(Key);
+    if (I == ByFile.end())
+      return nullptr;
+    ++NumFileHits;
+    return I->second;
+  }
+
+  /// \brief Add the contents \p Buffer just read for the file \p Key, or for
+  /// a file with no identity on disk if \p Key is null.
+  ///
+  /// \returns the cached buffer with the same contents: a copy of \p Buffer,
+  /// which is then freed, unless another file had them first.
+  const llvm::MemoryBuffer *insert(const FileKey *Key,
+                                   std::unique_ptr<llvm::MemoryBuffer> Buffer) {
+    StringRef Contents = Buffer->getBuffer();
+    llvm::MD5 Hash;
+    Hash.update(Contents);
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    StringRef HashKey(reinterpret_cast<const char *>(Result), sizeof(Result));
+
+    llvm::MutexGuard Guard(Lock);
+    const llvm::MemoryBuffer *Shared = nullptr;
+    std::vector<llvm::MemoryBuffer *> &Same = ByContents[HashKey];
+    for (unsigned I = 0, E = Same.size(); I != E && !Shared; ++I)
+      if (Same[I]->getBuffer() == Contents)
+        Shared = Same[I];
+    if (Shared) {
+      ++NumContentHits;
+      BytesShared += Contents.size();
+    } else {
+      // Copy the contents out, since \p Buffer may map the file.
+      Same.push_back(llvm::MemoryBuffer::getMemBufferCopy(
+          Contents, Buffer->getBufferIdentifier()));
+      Shared = Same.back();
+      BytesCached += Contents.size();
+    }
+    if (Key) {
+      eraseOtherVersions(*Key);
+      ByFile[*Key] = Shared;
+    }
+    return Shared;
+  }
+
+  /// \brief The number of lookups of a file already read.
+  unsigned getNumFileHits() const {
+    llvm::MutexGuard Guard(Lock);
+    return NumFileHits;
+  }
+
+  /// \brief The number of files whose contents were already cached under
+  /// another name.
+  unsigned getNumContentHits() const {
+    llvm::MutexGuard Guard(Lock);
+    return NumContentHits;
+  }
+
+  /// \brief The bytes of the copies dropped for an earlier buffer.
+  uint64_t getBytesShared() const {
+    llvm::MutexGuard Guard(Lock);
+    return BytesShared;
+  }
+
+  /// \brief The size of the buffers the cache holds.
+  uint64_t getBytesCached() const {
+    llvm::MutexGuard Guard(Lock);
+    return BytesCached;
+  }
+};
+
+} // end namespace clang
+
+#endif
@@ -15,6 +15,7 @@
 #ifndef LLVM_CLANG_FILEMANAGER_H
 #define LLVM_CLANG_FILEMANAGER_H
 
+#include "clang/Basic/FileContentCache.h"
 #include "clang/Basic/FileSystemOptions.h"
 #include "clang/Basic/LLVM.h"
 #include "clang/Basic/VirtualFileSystem.h"
@@ -171,6 +172,10 @@ class FileManager : public RefCountedBase<FileManager> {
   // Caching.
   std::unique_ptr<FileSystemStatCache> StatCache;
 
+  /// \brief The contents of the files read, shared with other FileManagers,
+  /// if any.
+  IntrusiveRefCntPtr<FileContentCache> ContentCache;
+
   bool getStatValue(const char *Path, FileData &Data, bool isFile,
                     vfs::File **F);
 
@@ -246,6 +251,35 @@ public:
   llvm::MemoryBuffer *getBufferForFile(StringRef Filename,
                                        std::string *ErrorStr = 0);
 
+  /// \brief Share the contents of the files read through \p Cache, with
+  /// the other FileManagers using it.
+  void setContentCache(FileContentCache *Cache) { ContentCache = Cache; }
+  FileContentCache *getContentCache() const { return ContentCache.getPtr(); }
+
+  /// \brief Return the contents of \p Entry from the content cache, which
+  /// owns the buffer, reading the file if it is not cached yet.
+  ///
+  /// Files with the same contents share one buffer.  This requires a
+  /// content cache; volatile files should be read with getBufferForFile.
+  ///
+  /// \returns null, setting \p ErrorStr, if the file could not be read.
+  const llvm::MemoryBuffer *getSharedBufferForFile(const FileEntry *Entry,
+                                                   std::string *ErrorStr = 0) {
+    assert(ContentCache && "no content cache to share buffers through");
+    FileContentCache::FileKey Key(Entry->getUniqueID(), Entry->getSize(),
+                                  Entry->getModificationTime());
+    // Virtual files have no identity on disk to find their contents by.
+    bool HasKey = Entry->getUniqueID() != llvm::sys::fs::UniqueID(0, 0);
+    if (HasKey)
+      if (const llvm::MemoryBuffer *Buffer = ContentCache->lookup(Key))
+        return Buffer;
+    std::unique_ptr<llvm::MemoryBuffer> Buffer(
+        getBufferForFile(Entry, ErrorStr));
+    if (!Buffer)
+      return nullptr;
+    return ContentCache->insert(HasKey ? &Key : nullptr, std::move(Buffer));
+  }
+
   /// \brief Get the 'stat' information for the given \p Path.
   ///
   /// If the path is relative, it will be resolved against the WorkingDir of the
@@ -16,6 +16,7 @@
 #define LLVM_CLANG_BASIC_FILESYSTEMOPTIONS_H
 
 #include <string>
+#include <vector>
 
 namespace clang {
 
@@ -25,6 +26,15 @@ public:
   /// \brief If set, paths are resolved as if the working directory was
   /// set to the value of WorkingDir.
   std::string WorkingDir;
+
+  /// \brief If set, the directory holding the PersistentStatCache files
+  /// shared by the invocations of a build session.  The session is taken from
+  /// HeaderSearchOptions::BuildSessionTimestamp.
+  std::string StatCacheDir;
+
+  /// \brief The path prefixes whose 'stat' results may be kept in the
+  /// persistent stat cache, typically the SDK and toolchain roots.
+  std::vector<std::string> StatCachePrefixes;
 };
 
 } // end namespace clang
@@ -208,6 +208,23 @@ public:
     llvm_unreachable("bad kind");
   }
 
+  /// \brief Does this runtime's Foundation provide the classes of constant
+  /// NSArray and NSDictionary literals, which are emitted into the object
+  /// file like constant strings?
+  ///
+  /// This is really a property of the library, not the runtime.
+  bool hasConstantCollectionLiterals() const {
+    switch (getKind()) {
+    case FragileMacOSX: return false;
+    case MacOSX: return getVersion() >= VersionTuple(11);
+    case iOS: return getVersion() >= VersionTuple(14);
+    case GCC: return false;
+    case GNUstep: return false;
+    case ObjFW: return false;
+    }
+    llvm_unreachable("bad kind");
+  }
+
   /// \brief Does this runtime allow sizeof or alignof on object types?
   bool allowsSizeofAlignof() const {
     return isFragile();
@@ -0,0 +1,395 @@
+//===--- PersistentStatCache.h - Cross-process 'stat' cache -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the PersistentStatCache interface, a FileSystemStatCache
+/// whose results are shared by every compiler invocation of a build session.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_PERSISTENTSTATCACHE_H
+#define LLVM_CLANG_PERSISTENTSTATCACHE_H
+
+#include "clang/Basic/FileSystemStatCache.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+/// \brief The 'stat' information recorded for one path by the
+/// PersistentStatCache.
+struct PersistentStatEntry {
+  enum {
+    Exists = 0x1,
+    IsDirectory = 0x2,
+    IsNamedPipe = 0x4
+  };
+
+  uint64_t Size;
+  uint64_t ModTime;
+  uint64_t Device;
+  uint64_t File;
+  uint8_t Flags;
+
+  PersistentStatEntry()
+    : Size(0), ModTime(0), Device(0), File(0), Flags(0) {}
+
+  bool exists() const { return Flags & Exists; }
+
+  /// \brief The number of bytes an entry occupies on disk.
+  static unsigned getSerializedSize() { return 4 * 8 + 1; }
+};
+
+/// \brief OnDiskChainedHashTable traits mapping a path to its
+/// PersistentStatEntry.
+class PersistentStatCacheTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef PersistentStatEntry data_type;
+  typedef const PersistentStatEntry &data_type_ref;
+
+  static unsigned ComputeHash(StringRef Key) { return llvm::HashString(Key); }
+  static bool EqualKey(StringRef A, StringRef B) { return A == B; }
+  static StringRef GetInternalKey(StringRef Key) { return Key; }
+  static StringRef GetExternalKey(StringRef Key) { return Key; }
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(raw_ostream &Out, StringRef Key, data_type_ref) {
+    using namespace llvm::support;
+    endian::Writer<little>(Out).write<uint16_t>(Key.size());
+    return std::make_pair(Key.size(), PersistentStatEntry::getSerializedSize());
+  }
+
+  static void EmitKey(raw_ostream &Out, StringRef Key, unsigned) {
+    Out << Key;
+  }
+
+  static void EmitData(raw_ostream &Out, StringRef, data_type_ref Data,
+                       unsigned) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<uint64_t>(Data.Size);
+    LE.write<uint64_t>(Data.ModTime);
+    LE.write<uint64_t>(Data.Device);
+    LE.write<uint64_t>(Data.File);
+    LE.write<uint8_t>(Data.Flags);
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(D);
+    return std::make_pair(KeyLen, PersistentStatEntry::getSerializedSize());
+  }
+
+  static StringRef ReadKey(const unsigned char *D, unsigned N) {
+    return StringRef(reinterpret_cast<const char *>(D), N);
+  }
+
+  static data_type ReadData(StringRef, const unsigned char *D, unsigned) {
+    using namespace llvm::support;
+    PersistentStatEntry Data;
+    Data.Size = endian::readNext<uint64_t, little, unaligned>(D);
+    Data.ModTime = endian::readNext<uint64_t, little, unaligned>(D);
+    Data.Device = endian::readNext<uint64_t, little, unaligned>(D);
+    Data.File = endian::readNext<uint64_t, little, unaligned>(D);
+    Data.Flags = endian::readNext<uint8_t, little, unaligned>(D);
+    return Data;
+  }
+};
+
+/// \brief A stat cache that persists the results of 'stat' calls across
+/// compiler invocations of the same build session.
+///
+/// The cache file for a session is read into memory when the cache is
+/// created, so looking up a path that any earlier invocation of the session
+/// has stat'ed costs a hash probe instead of a system call.  The file is
+/// copied rather than kept mapped, so that other invocations can replace it.
+///
+/// Paths which are not yet in the file are stat'ed through the rest of the
+/// chain and recorded; they are merged into a new version of the file, which
+/// is atomically renamed over the old one, when the cache is destroyed.
+/// Concurrent writers may drop each other's additions, which only costs
+/// extra 'stat' calls later.
+///
+/// Like -fmodules-validate-once-per-build-session, this assumes the cached
+/// trees do not change during a build session, so only paths below the given
+/// prefixes (typically the SDK and toolchain roots) are cached.  Generated
+/// headers in the build tree must not be covered by a prefix.
+class PersistentStatCache : public FileSystemStatCache {
+public:
+  typedef OnDiskIterableChainedHashTable<PersistentStatCacheTrait> TableTy;
+
+  /// \brief How reading the cache file went.
+  enum LoadResult {
+    /// \brief The entries were read from the file.
+    Loaded,
+    /// \brief No invocation of the session has saved the cache yet.
+    Missing,
+    /// \brief The file could not be read, or is not a cache file of this
+    /// version and session.  It is replaced when the cache is saved.
+    Invalid
+  };
+
+private:
+  enum {
+    Magic = 0x43545343, // 'CSTC'
+    Version = 1,
+    HeaderSize = 24
+  };
+
+  std::string CacheFile;
+  uint64_t BuildSessionTimestamp;
+  std::vector<std::string> Prefixes;
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<TableTy> Table;
+  LoadResult Result;
+
+  /// \brief Entries looked up by this invocation that are not yet on disk.
+  llvm::StringMap<PersistentStatEntry> NewEntries;
+
+  unsigned NumHits, NumMisses;
+
+  bool isCachedPath(StringRef Path) const {
+    for (unsigned I = 0, E = Prefixes.size(); I != E; ++I)
+      if (Path.startswith(Prefixes[I]))
+        return Path.size() <= 0xFFFF;
+    return false;
+  }
+
+  /// \brief Read and validate the cache file, returning the table on
+  /// success and null otherwise, with the reason in \p Result.
+  static TableTy *loadTable(StringRef File, uint64_t Session,
+                            std::unique_ptr<llvm::MemoryBuffer> &Buffer,
+                            LoadResult &Result) {
+    using namespace llvm::support;
+    Buffer.reset();
+    std::unique_ptr<llvm::MemoryBuffer> Mapped;
+    if (llvm::error_code EC = llvm::MemoryBuffer::getFile(
+            File, Mapped, -1, /*RequiresNullTerminator=*/false)) {
+      Result = EC == llvm::errc::no_such_file_or_directory ? Missing : Invalid;
+      return 0;
+    }
+    Result = Invalid;
+    if (Mapped->getBufferSize() < HeaderSize + 8)
+      return 0;
+    Buffer.reset(llvm::MemoryBuffer::getMemBufferCopy(Mapped->getBuffer(),
+                                                      File));
+    Mapped.reset();
+
+    const unsigned char *Base =
+        reinterpret_cast<const unsigned char *>(Buffer->getBufferStart());
+    const unsigned char *D = Base;
+    if (endian::readNext<uint32_t, little, aligned>(D) != Magic ||
+        endian::readNext<uint32_t, little, aligned>(D) != Version ||
+        endian::readNext<uint64_t, little, aligned>(D) != Session)
+      return 0;
+    uint32_t TableOffset = endian::readNext<uint32_t, little, aligned>(D);
+    if (TableOffset < HeaderSize || TableOffset % 4 ||
+        TableOffset + 8 > Buffer->getBufferSize())
+      return 0;
+    Result = Loaded;
+    return TableTy::Create(Base + TableOffset, Base + HeaderSize, Base);
+  }
+
+  static void fillFileData(StringRef Path, const PersistentStatEntry &Entry,
+                           FileData &Data) {
+    Data.Name = Path;
+    Data.Size = Entry.Size;
+    Data.ModTime = Entry.ModTime;
+    Data.UniqueID = llvm::sys::fs::UniqueID(Entry.Device, Entry.File);
+    Data.IsDirectory = Entry.Flags & PersistentStatEntry::IsDirectory;
+    Data.IsNamedPipe = Entry.Flags & PersistentStatEntry::IsNamedPipe;
+    Data.InPCH = false;
+  }
+
+  static PersistentStatEntry makeEntry(const FileData &Data) {
+    PersistentStatEntry Entry;
+    Entry.Size = Data.Size;
+    Entry.ModTime = Data.ModTime;
+    Entry.Device = Data.UniqueID.getDevice();
+    Entry.File = Data.UniqueID.getFile();
+    Entry.Flags = PersistentStatEntry::Exists;
+    if (Data.IsDirectory)
+      Entry.Flags |= PersistentStatEntry::IsDirectory;
+    if (Data.IsNamedPipe)
+      Entry.Flags |= PersistentStatEntry::IsNamedPipe;
+    return Entry;
+  }
+
+  static PersistentStatEntry makeEntry(const vfs::Status &Status) {
+    PersistentStatEntry Entry;
+    Entry.Size = Status.getSize();
+    Entry.ModTime = Status.getLastModificationTime().toEpochTime();
+    Entry.Device = Status.getUniqueID().getDevice();
+    Entry.File = Status.getUniqueID().getFile();
+    Entry.Flags = PersistentStatEntry::Exists;
+    if (Status.isDirectory())
+      Entry.Flags |= PersistentStatEntry::IsDirectory;
+    if (Status.getType() == llvm::sys::fs::file_type::fifo_file)
+      Entry.Flags |= PersistentStatEntry::IsNamedPipe;
+    return Entry;
+  }
+
+public:
+  /// \brief Create a stat cache for the given build session.
+  ///
+  /// \param CacheDir The directory holding the per-session cache files.
+  /// \param BuildSessionTimestamp The build session, as returned by
+  /// \c clang_getBuildSessionTimestamp().  Cache files written by other
+  /// sessions are ignored.
+  /// \param CachedPrefixes The path prefixes whose 'stat' results may be
+  /// cached.
+  PersistentStatCache(StringRef CacheDir, uint64_t BuildSessionTimestamp,
+                      ArrayRef<std::string> CachedPrefixes)
+    : BuildSessionTimestamp(BuildSessionTimestamp),
+      Prefixes(CachedPrefixes.begin(), CachedPrefixes.end()), NumHits(0),
+      NumMisses(0) {
+    SmallString<256> Path;
+    getCacheFilePath(CacheDir, BuildSessionTimestamp, Path);
+    CacheFile = Path.str();
+    Table.reset(loadTable(CacheFile, BuildSessionTimestamp, Buffer, Result));
+  }
+
+  ~PersistentStatCache() {
+    save();
+  }
+
+  /// \brief Compute the name of the cache file for a build session.
+  static void getCacheFilePath(StringRef CacheDir, uint64_t Session,
+                               SmallVectorImpl<char> &Path) {
+    Path.clear();
+    Path.append(CacheDir.begin(), CacheDir.end());
+    llvm::sys::path::append(Path, "stat-cache-" + Twine(Session) + ".bin");
+  }
+
+  StringRef getCacheFile() const { return CacheFile; }
+
+  /// \brief How the cache file was read when the cache was created, so that
+  /// the caller can report one that is corrupt.
+  LoadResult getLoadResult() const { return Result; }
+
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumMisses() const { return NumMisses; }
+
+  LookupResult getStat(const char *Path, FileData &Data, bool isFile,
+                       vfs::File **F, vfs::FileSystem &FS) override {
+    StringRef Key(Path);
+    if (!isCachedPath(Key))
+      return statChained(Path, Data, isFile, F, FS);
+
+    const PersistentStatEntry *Entry = 0;
+    PersistentStatEntry OnDisk;
+    llvm::StringMap<PersistentStatEntry>::iterator Known = NewEntries.find(Key);
+    if (Known != NewEntries.end()) {
+      Entry = &Known->second;
+    } else if (Table) {
+      TableTy::iterator I = Table->find(Key);
+      if (I != Table->end()) {
+        OnDisk = *I;
+        Entry = &OnDisk;
+      }
+    }
+
+    if (Entry) {
+      ++NumHits;
+      if (!Entry->exists())
+        return CacheMissing;
+      fillFileData(Key, *Entry, Data);
+      return CacheExists;
+    }
+
+    ++NumMisses;
+    LookupResult Result = statChained(Path, Data, isFile, F, FS);
+    if (Result == CacheExists) {
+      NewEntries[Key] = makeEntry(Data);
+      return Result;
+    }
+
+    // A miss from the chain may only mean that the entry has the wrong kind
+    // for this lookup, so ask the file system before recording a negative
+    // result.
+    llvm::ErrorOr<vfs::Status> Status = FS.status(Key);
+    NewEntries[Key] = Status ? makeEntry(*Status) : PersistentStatEntry();
+    return Result;
+  }
+
+  /// \brief Merge the entries recorded by this invocation into the cache
+  /// file.
+  ///
+  /// \returns true on success, or if there was nothing to write.
+  bool save() {
+    if (NewEntries.empty())
+      return true;
+
+    // Reload the file, which may have been updated by other invocations
+    // since we read it.
+    std::unique_ptr<llvm::MemoryBuffer> Latest;
+    LoadResult LatestResult;
+    std::unique_ptr<TableTy> LatestTable(
+        loadTable(CacheFile, BuildSessionTimestamp, Latest, LatestResult));
+
+    OnDiskChainedHashTableGenerator<PersistentStatCacheTrait> Generator;
+    for (llvm::StringMap<PersistentStatEntry>::iterator
+             I = NewEntries.begin(), E = NewEntries.end(); I != E; ++I)
+      Generator.insert(I->getKey(), I->second);
+    if (LatestTable) {
+      for (TableTy::key_iterator I = LatestTable->key_begin(),
+                                 E = LatestTable->key_end(); I != E; ++I) {
+        StringRef Key = *I;
+        if (!NewEntries.count(Key))
+          Generator.insert(Key, *LatestTable->find(Key));
+      }
+    }
+
+    SmallString<4096> Contents;
+    {
+      using namespace llvm::support;
+      llvm::raw_svector_ostream Out(Contents);
+      endian::Writer<little> LE(Out);
+      LE.write<uint32_t>(Magic);
+      LE.write<uint32_t>(Version);
+      LE.write<uint64_t>(BuildSessionTimestamp);
+      LE.write<uint32_t>(0); // Table offset, patched below.
+      LE.write<uint32_t>(0); // Padding.
+      uint32_t TableOffset = Generator.Emit(Out);
+      Out.flush();
+      endian::write<uint32_t, little, unaligned>(Contents.data() + 16,
+                                                  TableOffset);
+    }
+
+    if (llvm::writeFileAtomically(CacheFile, Contents.str()))
+      return false;
+    NewEntries.clear();
+    return true;
+  }
+};
+
+} // end namespace clang
+
+#endif
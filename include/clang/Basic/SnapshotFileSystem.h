@@ -0,0 +1,393 @@
+//===- SnapshotFileSystem.h - Memory-mapped file system snapshot -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+/// \brief Defines vfs::SnapshotFileSystem, which serves a read-only directory
+/// tree (typically an SDK) out of one packed, memory-mapped file, and
+/// vfs::SnapshotWriter, which produces such files.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_SNAPSHOT_FILE_SYSTEM_H
+#define LLVM_CLANG_BASIC_SNAPSHOT_FILE_SYSTEM_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <vector>
+
+namespace clang {
+namespace vfs {
+
+/// \brief The description of one file or directory in a snapshot.
+struct SnapshotEntry {
+  /// \brief The index of the entry, which makes up its unique ID.
+  uint32_t Index;
+  /// \brief Whether this entry is a directory.
+  bool IsDirectory;
+  /// \brief The offset of the contents from the start of the snapshot.
+  uint64_t Offset;
+  /// \brief The size of the contents, not including the trailing NUL.
+  uint64_t Size;
+  /// \brief The modification time, in seconds since the epoch.
+  uint64_t ModTime;
+
+  SnapshotEntry()
+    : Index(0), IsDirectory(false), Offset(0), Size(0), ModTime(0) {}
+
+  static unsigned getSerializedSize() { return 4 + 1 + 3 * 8; }
+};
+
+/// \brief OnDiskChainedHashTable traits for the snapshot's path index.
+class SnapshotIndexTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef SnapshotEntry data_type;
+  typedef const SnapshotEntry &data_type_ref;
+
+  static unsigned ComputeHash(StringRef Key) { return llvm::HashString(Key); }
+  static bool EqualKey(StringRef A, StringRef B) { return A == B; }
+  static StringRef GetInternalKey(StringRef Key) { return Key; }
+  static StringRef GetExternalKey(StringRef Key) { return Key; }
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(raw_ostream &Out, StringRef Key, data_type_ref) {
+    using namespace llvm::support;
+    endian::Writer<little>(Out).write<uint16_t>(Key.size());
+    return std::make_pair(Key.size(), SnapshotEntry::getSerializedSize());
+  }
+
+  static void EmitKey(raw_ostream &Out, StringRef Key, unsigned) {
+    Out << Key;
+  }
+
+  static void EmitData(raw_ostream &Out, StringRef, data_type_ref Entry,
+                       unsigned) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<uint32_t>(Entry.Index);
+    LE.write<uint8_t>(Entry.IsDirectory);
+    LE.write<uint64_t>(Entry.Offset);
+    LE.write<uint64_t>(Entry.Size);
+    LE.write<uint64_t>(Entry.ModTime);
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(D);
+    return std::make_pair(KeyLen, SnapshotEntry::getSerializedSize());
+  }
+
+  static StringRef ReadKey(const unsigned char *D, unsigned N) {
+    return StringRef(reinterpret_cast<const char *>(D), N);
+  }
+
+  static data_type ReadData(StringRef, const unsigned char *D, unsigned) {
+    using namespace llvm::support;
+    SnapshotEntry Entry;
+    Entry.Index = endian::readNext<uint32_t, little, unaligned>(D);
+    Entry.IsDirectory = endian::readNext<uint8_t, little, unaligned>(D);
+    Entry.Offset = endian::readNext<uint64_t, little, unaligned>(D);
+    Entry.Size = endian::readNext<uint64_t, little, unaligned>(D);
+    Entry.ModTime = endian::readNext<uint64_t, little, unaligned>(D);
+    return Entry;
+  }
+};
+
+/// \brief The layout constants shared by the snapshot reader and writer.
+///
+/// A snapshot starts with a fixed header (magic, version and entry count),
+/// followed by the contents of every file, each NUL terminated and 8-byte
+/// aligned, followed by the path index and a trailer holding the offset of the
+/// index.
+namespace snapshot {
+enum {
+  Magic = 0x504E5343, // 'CSNP'
+  Version = 1,
+  HeaderSize = 24
+};
+} // end namespace snapshot
+
+/// \brief A file whose contents live inside a memory-mapped snapshot.
+class SnapshotFile : public File {
+  Status S;
+  StringRef Contents;
+
+public:
+  SnapshotFile(const Status &S, StringRef Contents)
+    : S(S), Contents(Contents) {}
+  ~SnapshotFile() {}
+
+  llvm::ErrorOr<Status> status() override { return S; }
+
+  llvm::error_code getBuffer(const Twine &Name,
+                             std::unique_ptr<llvm::MemoryBuffer> &Result,
+                             int64_t FileSize = -1,
+                             bool RequiresNullTerminator = true) override {
+    // Every file in the snapshot is followed by a NUL, so the buffer can
+    // always point straight into the mapping.
+    Result.reset(llvm::MemoryBuffer::getMemBuffer(Contents, Name.str(),
+                                                  RequiresNullTerminator));
+    return llvm::error_code::success();
+  }
+
+  llvm::error_code close() override { return llvm::error_code::success(); }
+
+  void setName(StringRef Name) override { S.setName(Name); }
+};
+
+/// \brief A read-only file system serving a directory tree captured by a
+/// SnapshotWriter.
+///
+/// Opening a file is a hash lookup plus a pointer into the mapping; no system
+/// calls are made after the snapshot has been mapped.  Paths are looked up
+/// verbatim, so clients should use the absolute, canonical paths that the
+/// snapshot was written with.  Typically this is pushed onto an
+/// OverlayFileSystem above the real file system, or used as the external file
+/// system of a YAML overlay (see clang_VirtualFileOverlay_addSnapshot).
+class SnapshotFileSystem : public FileSystem {
+  typedef OnDiskChainedHashTable<SnapshotIndexTrait> IndexTy;
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<IndexTy> Index;
+  uint64_t DeviceID;
+
+  SnapshotFileSystem(llvm::MemoryBuffer *Buffer, IndexTy *Index,
+                     uint64_t DeviceID)
+    : Buffer(Buffer), Index(Index), DeviceID(DeviceID) {}
+
+  bool lookup(const Twine &Path, SmallString<256> &Storage, StringRef &Key,
+              SnapshotEntry &Entry) {
+    Key = Path.toStringRef(Storage);
+    if (Key.size() > 1 && llvm::sys::path::is_separator(Key.back()))
+      Key = Key.drop_back();
+    IndexTy::iterator I = Index->find(Key);
+    if (I == Index->end())
+      return false;
+    Entry = *I;
+    return true;
+  }
+
+  Status makeStatus(StringRef Path, const SnapshotEntry &Entry) const {
+    llvm::sys::TimeValue MTime;
+    MTime.fromEpochTime(Entry.ModTime);
+    llvm::sys::fs::file_type Type =
+        Entry.IsDirectory ? llvm::sys::fs::file_type::directory_file
+                          : llvm::sys::fs::file_type::regular_file;
+    return Status(Path, Path, llvm::sys::fs::UniqueID(DeviceID, Entry.Index),
+                  MTime, 0, 0, Entry.Size, Type, llvm::sys::fs::all_read);
+  }
+
+public:
+  /// \brief Map the snapshot at \p SnapshotPath.
+  ///
+  /// \returns the file system, or null if the file could not be mapped or is
+  /// not a valid snapshot.
+  static SnapshotFileSystem *create(StringRef SnapshotPath) {
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::MemoryBuffer::getFile(SnapshotPath, Buffer, -1,
+                                    /*RequiresNullTerminator=*/false))
+      return 0;
+    return create(Buffer.release());
+  }
+
+  /// \brief Create a file system serving the snapshot in \p Buffer, taking
+  /// ownership of it.
+  static SnapshotFileSystem *create(llvm::MemoryBuffer *Buffer) {
+    using namespace llvm::support;
+    std::unique_ptr<llvm::MemoryBuffer> Owned(Buffer);
+    if (Buffer->getBufferSize() < snapshot::HeaderSize + 8)
+      return 0;
+    const unsigned char *Base =
+        reinterpret_cast<const unsigned char *>(Buffer->getBufferStart());
+    const unsigned char *D = Base;
+    if (endian::readNext<uint32_t, little, aligned>(D) != snapshot::Magic ||
+        endian::readNext<uint32_t, little, aligned>(D) != snapshot::Version)
+      return 0;
+    const unsigned char *Trailer = Base + Buffer->getBufferSize() - 8;
+    uint64_t IndexOffset =
+        endian::readNext<uint64_t, little, unaligned>(Trailer);
+    if (IndexOffset < snapshot::HeaderSize || IndexOffset % 4 ||
+        IndexOffset + 16 > Buffer->getBufferSize())
+      return 0;
+
+    // Give every snapshot its own device number for unique IDs, so that
+    // files from different snapshots are never considered the same file.
+    uint64_t DeviceID = getNextVirtualUniqueID().getFile() | (1ULL << 63);
+    return new SnapshotFileSystem(Owned.release(),
+                                  IndexTy::Create(Base + IndexOffset, Base),
+                                  DeviceID);
+  }
+
+  /// \brief The number of files and directories in the snapshot.
+  unsigned getNumEntries() const { return Index->getNumEntries(); }
+
+  llvm::ErrorOr<Status> status(const Twine &Path) override {
+    SmallString<256> Storage;
+    StringRef Key;
+    SnapshotEntry Entry;
+    if (!lookup(Path, Storage, Key, Entry))
+      return llvm::make_error_code(llvm::errc::no_such_file_or_directory);
+    return makeStatus(Key, Entry);
+  }
+
+  llvm::error_code openFileForRead(const Twine &Path,
+                                   std::unique_ptr<File> &Result) override {
+    SmallString<256> Storage;
+    StringRef Key;
+    SnapshotEntry Entry;
+    if (!lookup(Path, Storage, Key, Entry))
+      return llvm::make_error_code(llvm::errc::no_such_file_or_directory);
+    if (Entry.IsDirectory)
+      return llvm::make_error_code(llvm::errc::is_a_directory);
+    StringRef Contents(Buffer->getBufferStart() + Entry.Offset, Entry.Size);
+    Result.reset(new SnapshotFile(makeStatus(Key, Entry), Contents));
+    return llvm::error_code::success();
+  }
+};
+
+/// \brief Builds a snapshot file from a set of files and directories.
+///
+/// This is the library side of the snapshot converter: a tool walks the SDK
+/// with \c addTree and then calls \c write.
+class SnapshotWriter {
+  struct PendingEntry {
+    std::string Path;
+    SnapshotEntry Entry;
+    std::string Contents;
+  };
+
+  std::vector<PendingEntry> Entries;
+  llvm::StringMap<unsigned> EntryIndices;
+
+  PendingEntry &getEntry(StringRef Path) {
+    llvm::StringMap<unsigned>::iterator I = EntryIndices.find(Path);
+    if (I != EntryIndices.end())
+      return Entries[I->second];
+    EntryIndices[Path] = Entries.size();
+    Entries.push_back(PendingEntry());
+    Entries.back().Path = Path;
+    Entries.back().Entry.Index = Entries.size() - 1;
+    return Entries.back();
+  }
+
+  /// \brief Make sure every parent directory of \p Path is recorded, so that
+  /// directory lookups inside the snapshot succeed.
+  void addParents(StringRef Path, uint64_t ModTime) {
+    for (StringRef Parent = llvm::sys::path::parent_path(Path);
+         !Parent.empty() && !EntryIndices.count(Parent);
+         Parent = llvm::sys::path::parent_path(Parent))
+      addDirectory(Parent, ModTime);
+  }
+
+public:
+  /// \brief Add a directory at the absolute virtual path \p Path.
+  void addDirectory(StringRef Path, uint64_t ModTime) {
+    PendingEntry &E = getEntry(Path);
+    E.Entry.IsDirectory = true;
+    E.Entry.ModTime = ModTime;
+    addParents(Path, ModTime);
+  }
+
+  /// \brief Add a file at the absolute virtual path \p Path.
+  void addFile(StringRef Path, StringRef Contents, uint64_t ModTime) {
+    PendingEntry &E = getEntry(Path);
+    E.Entry.IsDirectory = false;
+    E.Entry.ModTime = ModTime;
+    E.Contents = Contents;
+    addParents(Path, ModTime);
+  }
+
+  /// \brief Add every file and directory below the real directory
+  /// \p RealRoot, which is mapped to the virtual path \p VirtualRoot.
+  llvm::error_code addTree(StringRef RealRoot, StringRef VirtualRoot) {
+    using namespace llvm::sys;
+    llvm::error_code EC;
+    fs::file_status RootStatus;
+    if ((EC = fs::status(RealRoot, RootStatus)))
+      return EC;
+    addDirectory(VirtualRoot,
+                 RootStatus.getLastModificationTime().toEpochTime());
+
+    for (fs::recursive_directory_iterator I(RealRoot, EC), E; I != E && !EC;
+         I.increment(EC)) {
+      StringRef RealPath = I->path();
+      SmallString<256> VirtualPath(VirtualRoot);
+      path::append(VirtualPath, RealPath.substr(RealRoot.size()));
+
+      fs::file_status Status;
+      if ((EC = I->status(Status)))
+        return EC;
+      uint64_t ModTime = Status.getLastModificationTime().toEpochTime();
+      if (fs::is_directory(Status)) {
+        addDirectory(VirtualPath, ModTime);
+        continue;
+      }
+      if (!fs::is_regular_file(Status))
+        continue;
+
+      std::unique_ptr<llvm::MemoryBuffer> Contents;
+      if ((EC = llvm::MemoryBuffer::getFile(RealPath, Contents, -1,
+                                            /*RequiresNullTerminator=*/false)))
+        return EC;
+      addFile(VirtualPath, Contents->getBuffer(), ModTime);
+    }
+    return EC;
+  }
+
+  /// \brief Write the snapshot to \p Out, which must be positioned at offset
+  /// zero: the path index records absolute offsets.
+  void write(raw_ostream &Out) {
+    using namespace llvm::support;
+    assert(Out.tell() == 0 && "snapshot must start at offset zero");
+    endian::Writer<little> LE(Out);
+    LE.write<uint32_t>(snapshot::Magic);
+    LE.write<uint32_t>(snapshot::Version);
+    LE.write<uint64_t>(Entries.size());
+    LE.write<uint64_t>(0); // Reserved.
+
+    static const char Padding[8] = { 0 };
+    for (unsigned I = 0, E = Entries.size(); I != E; ++I) {
+      PendingEntry &P = Entries[I];
+      if (P.Entry.IsDirectory)
+        continue;
+      P.Entry.Offset = Out.tell();
+      P.Entry.Size = P.Contents.size();
+      Out << P.Contents;
+      Out.write(Padding, llvm::RoundUpToAlignment(P.Entry.Size + 1, 8) -
+                             P.Entry.Size);
+    }
+
+    OnDiskChainedHashTableGenerator<SnapshotIndexTrait> Generator;
+    for (unsigned I = 0, E = Entries.size(); I != E; ++I)
+      Generator.insert(Entries[I].Path, Entries[I].Entry);
+    uint64_t IndexOffset = Generator.Emit(Out);
+
+    // The index offset is only known once the contents have been streamed
+    // out, so it lives in a trailer rather than in the header.
+    LE.write<uint64_t>(IndexOffset);
+  }
+};
+
+} // end namespace vfs
+} // end namespace clang
+#endif // LLVM_CLANG_BASIC_SNAPSHOT_FILE_SYSTEM_H
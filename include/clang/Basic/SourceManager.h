@@ -48,7 +48,10 @@
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/StatsJSONWriter.h"
+#include "llvm/Support/raw_ostream.h"
 #include <cassert>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <vector>
@@ -256,16 +259,23 @@ namespace SrcMgr {
     /// This is an invalid SLOC for the main file (top of the \#include chain).
     unsigned IncludeLoc;  // Really a SourceLocation
 
-    /// \brief Number of FileIDs (files and macros) that were created during
-    /// preprocessing of this \#include, including this SLocEntry.
-    ///
-    /// Zero means the preprocessor didn't provide such info for this SLocEntry.
-    unsigned NumCreatedFIDs;
-
     /// \brief Contains the ContentCache* and the bits indicating the
     /// characteristic of the file and whether it has \#line info, all
     /// bitmangled together.
-    uintptr_t Data;
+    ///
+    /// This is stored as 32-bit words so that FileInfo, and with it
+    /// SLocEntry, only needs 4-byte alignment: SLocEntry is 16 rather than
+    /// 24 bytes on 64-bit hosts.  The number of FileIDs created while
+    /// preprocessing the file lives in a side table of the SourceManager for
+    /// the same reason.
+    unsigned Data[sizeof(uintptr_t) / sizeof(unsigned)];
+
+    uintptr_t getData() const {
+      uintptr_t Result;
+      memcpy(&Result, Data, sizeof(Result));
+      return Result;
+    }
+    void setData(uintptr_t Value) { memcpy(Data, &Value, sizeof(Value)); }
 
     friend class clang::SourceManager;
     friend class clang::ASTWriter;
@@ -276,11 +286,10 @@ namespace SrcMgr {
                         CharacteristicKind FileCharacter) {
       FileInfo X;
       X.IncludeLoc = IL.getRawEncoding();
-      X.NumCreatedFIDs = 0;
-      X.Data = (uintptr_t)Con;
-      assert((X.Data & 7) == 0 &&"ContentCache pointer insufficiently aligned");
+      uintptr_t Data = (uintptr_t)Con;
+      assert((Data & 7) == 0 && "ContentCache pointer insufficiently aligned");
       assert((unsigned)FileCharacter < 4 && "invalid file character");
-      X.Data |= (unsigned)FileCharacter;
+      X.setData(Data | (unsigned)FileCharacter);
       return X;
     }
 
@@ -288,21 +297,21 @@ namespace SrcMgr {
       return SourceLocation::getFromRawEncoding(IncludeLoc);
     }
     const ContentCache* getContentCache() const {
-      return reinterpret_cast<const ContentCache*>(Data & ~uintptr_t(7));
+      return reinterpret_cast<const ContentCache*>(getData() & ~uintptr_t(7));
     }
 
     /// \brief Return whether this is a system header or not.
     CharacteristicKind getFileCharacteristic() const {
-      return (CharacteristicKind)(Data & 3);
+      return (CharacteristicKind)(getData() & 3);
     }
 
     /// \brief Return true if this FileID has \#line directives in it.
-    bool hasLineDirectives() const { return (Data & 4) != 0; }
+    bool hasLineDirectives() const { return (getData() & 4) != 0; }
 
     /// \brief Set the flag that indicates that this FileID has
     /// line table entries associated with it.
     void setHasLineDirectives() {
-      Data |= 4;
+      setData(getData() | 4);
     }
   };
 
@@ -662,6 +671,15 @@ class SourceManager : public RefCountedBase<SourceManager> {
 
   // Statistics for -print-stats.
   mutable unsigned NumLinearScans, NumBinaryProbes;
+  unsigned NumDiscardedExpansions;
+  uint64_t NumDiscardedOffsets;
+
+  /// \brief The number of FileIDs (files and macros) that were created during
+  /// preprocessing of each \#include, including its own; see
+  /// getNumCreatedFIDsForFileID.
+  ///
+  /// Files without an entry have no such info from the preprocessor.
+  mutable llvm::DenseMap<int, unsigned> NumCreatedFIDs;
 
   /// \brief Associates a FileID with its "included/expanded in" decomposed
   /// location.
@@ -954,12 +972,9 @@ public:
   /// \brief Get the number of FileIDs (files and macros) that were created
   /// during preprocessing of \p FID, including it.
   unsigned getNumCreatedFIDsForFileID(FileID FID) const {
-    bool Invalid = false;
-    const SrcMgr::SLocEntry &Entry = getSLocEntry(FID, &Invalid);
-    if (Invalid || !Entry.isFile())
-      return 0;
-
-    return Entry.getFile().NumCreatedFIDs;
+    llvm::DenseMap<int, unsigned>::const_iterator I =
+        NumCreatedFIDs.find(FID.ID);
+    return I == NumCreatedFIDs.end() ? 0 : I->second;
   }
 
   /// \brief Set the number of FileIDs (files and macros) that were created
@@ -970,8 +985,9 @@ public:
     if (Invalid || !Entry.isFile())
       return;
 
-    assert(Entry.getFile().NumCreatedFIDs == 0 && "Already set!");
-    const_cast<SrcMgr::FileInfo &>(Entry.getFile()).NumCreatedFIDs = NumFIDs;
+    unsigned &Num = NumCreatedFIDs[FID.ID];
+    assert(Num == 0 && "Already set!");
+    Num = NumFIDs;
   }
 
   //===--------------------------------------------------------------------===//
@@ -1416,6 +1432,127 @@ public:
   /// data structures in the SourceManager.
   size_t getDataStructureSizes() const;
 
+  /// \brief A breakdown of the SLocEntry tables and the offset space they
+  /// use, for tracking down memory use and running out of offsets (local
+  /// and loaded entries share 2^31 of them).
+  struct SLocEntryUsage {
+    unsigned NumFileEntries;
+    unsigned NumMacroBodyExpansions;
+    unsigned NumMacroArgExpansions;
+    unsigned NumLoadedEntries;
+
+    /// The offset space used by local file entries, local expansion
+    /// entries, and loaded entries.
+    uint64_t FileOffsets, ExpansionOffsets, LoadedOffsets;
+
+    /// The memory allocated for the SLocEntry tables, in bytes.
+    size_t TableBytes;
+
+    /// The expansion entries and the offset space given back by
+    /// discardLocalExpansionsSince.
+    unsigned NumDiscardedExpansions;
+    uint64_t DiscardedOffsets;
+  };
+
+  /// \brief Compute the usage of the SLocEntry tables.
+  SLocEntryUsage getSLocEntryUsage() const {
+    SLocEntryUsage U = SLocEntryUsage();
+    for (unsigned i = 1, e = LocalSLocEntryTable.size(); i != e; ++i) {
+      const SrcMgr::SLocEntry &Entry = LocalSLocEntryTable[i];
+      unsigned End = i + 1 == e ? NextLocalOffset
+                                : LocalSLocEntryTable[i + 1].getOffset();
+      unsigned Size = End - Entry.getOffset();
+      if (Entry.isFile()) {
+        ++U.NumFileEntries;
+        U.FileOffsets += Size;
+      } else {
+        if (Entry.getExpansion().isMacroArgExpansion())
+          ++U.NumMacroArgExpansions;
+        else
+          ++U.NumMacroBodyExpansions;
+        U.ExpansionOffsets += Size;
+      }
+    }
+    U.NumLoadedEntries = LoadedSLocEntryTable.size();
+    U.LoadedOffsets = MaxLoadedOffset - CurrentLoadedOffset;
+    U.TableBytes =
+        (LocalSLocEntryTable.capacity() + LoadedSLocEntryTable.capacity()) *
+        sizeof(SrcMgr::SLocEntry);
+    U.NumDiscardedExpansions = NumDiscardedExpansions;
+    U.DiscardedOffsets = NumDiscardedOffsets;
+    return U;
+  }
+
+  /// \brief Print the usage of the SLocEntry tables, as part of
+  /// -print-stats.
+  void printSLocEntryUsage(raw_ostream &OS) const {
+    SLocEntryUsage U = getSLocEntryUsage();
+    OS << "SLocEntry tables: " << U.TableBytes << " bytes, "
+       << sizeof(SrcMgr::SLocEntry) << " bytes per entry.\n";
+    OS << "  " << U.NumFileEntries << " file entries using " << U.FileOffsets
+       << " offsets.\n";
+    OS << "  " << U.NumMacroBodyExpansions << " macro body and "
+       << U.NumMacroArgExpansions << " macro argument expansions using "
+       << U.ExpansionOffsets << " offsets.\n";
+    OS << "  " << U.NumLoadedEntries << " loaded entries using "
+       << U.LoadedOffsets << " offsets.\n";
+    OS << "  " << U.NumDiscardedExpansions << " discarded expansions gave back "
+       << U.DiscardedOffsets << " offsets.\n";
+    OS << "  " << (uint64_t(NextLocalOffset) + U.LoadedOffsets) * 100 /
+                      MaxLoadedOffset
+       << "% of the offset space is in use.\n";
+  }
+
+  /// \brief A point in the local SLocEntry table to return to with
+  /// discardLocalExpansionsSince.
+  struct LocalSLocCheckpoint {
+    unsigned NumEntries;
+    unsigned NextOffset;
+  };
+
+  LocalSLocCheckpoint getLocalSLocCheckpoint() const {
+    LocalSLocCheckpoint Checkpoint = { unsigned(LocalSLocEntryTable.size()),
+                                       NextLocalOffset };
+    return Checkpoint;
+  }
+
+  /// \brief Discard the macro expansion entries created since \p Checkpoint,
+  /// giving back their memory and offset space.
+  ///
+  /// Most macro expansions only matter if a diagnostic points into them.
+  /// This is meant for expansions whose tokens are known to be dead if no
+  /// diagnostic was emitted while they were live, such as those of the
+  /// condition of an \#if: the Preprocessor takes a checkpoint before
+  /// evaluating the condition and, when no diagnostic was emitted and no
+  /// callbacks or preprocessing record may have kept locations, returns to
+  /// it afterwards.  Only expansion entries may have been created since the
+  /// checkpoint.
+  void discardLocalExpansionsSince(const LocalSLocCheckpoint &Checkpoint) {
+    unsigned NumEntries = Checkpoint.NumEntries;
+    assert(NumEntries <= LocalSLocEntryTable.size() &&
+           Checkpoint.NextOffset <= NextLocalOffset && "Invalid checkpoint");
+    if (NumEntries == LocalSLocEntryTable.size())
+      return;
+#ifndef NDEBUG
+    for (unsigned i = NumEntries, e = LocalSLocEntryTable.size(); i != e; ++i)
+      assert(LocalSLocEntryTable[i].isExpansion() &&
+             "Cannot discard file entries");
+#endif
+
+    NumDiscardedExpansions += LocalSLocEntryTable.size() - NumEntries;
+    NumDiscardedOffsets += NextLocalOffset - Checkpoint.NextOffset;
+    LocalSLocEntryTable.resize(NumEntries);
+    NextLocalOffset = Checkpoint.NextOffset;
+
+    // Forget anything cached about the discarded FileIDs.
+    if (LastFileIDLookup.ID >= int(NumEntries))
+      LastFileIDLookup = FileID();
+    if (LastLineNoFileIDQuery.ID >= int(NumEntries))
+      LastLineNoFileIDQuery = FileID();
+    IncludedLocMap.clear();
+    IBTUCache.clear();
+  }
+
   //===--------------------------------------------------------------------===//
   // Other miscellaneous methods.
   //===--------------------------------------------------------------------===//
@@ -1487,6 +1624,22 @@ public:
   ///
   void PrintStats() const;
 
+  /// \brief Add the counters that PrintStats prints to the current object of
+  /// \p W, for -stats-file.
+  void PrintStatsJSON(llvm::StatsJSONWriter &W) const {
+    W.value("local_sloc_entries", LocalSLocEntryTable.size());
+    W.value("loaded_sloc_entries", LoadedSLocEntryTable.size());
+    W.value("next_local_offset", NextLocalOffset);
+    W.value("file_infos", FileInfos.size());
+    W.value("linear_scans", NumLinearScans);
+    W.value("binary_probes", NumBinaryProbes);
+    W.value("content_cache_memory", getContentCacheSize());
+    W.value("data_structure_memory", getDataStructureSizes());
+    MemoryBufferSizes Buffers = getMemoryBufferSizes();
+    W.value("buffer_malloc_bytes", Buffers.malloc_bytes);
+    W.value("buffer_mmap_bytes", Buffers.mmap_bytes);
+  }
+
   /// \brief Get the number of local SLocEntries we have.
   unsigned local_sloc_entry_size() const { return LocalSLocEntryTable.size(); }
 
@@ -11,8 +11,10 @@
 #define LLVM_CLANG_CODEGEN_BACKEND_UTIL_H
 
 #include "clang/Basic/LLVM.h"
+#include "clang/CodeGen/ModuleBuilder.h"
 
 namespace llvm {
+  class Function;
   class Module;
 }
 
@@ -21,6 +23,7 @@ namespace clang {
   class CodeGenOptions;
   class TargetOptions;
   class LangOptions;
+  class StreamingFunctionOptimizer;
 
   enum BackendAction {
     Backend_EmitAssembly,  ///< Emit native assembly files
@@ -31,10 +34,54 @@ namespace clang {
     Backend_EmitObj        ///< Emit native object files
   };
 
+  /// EmitBackendOutput - Run the optimizer and code generator on \p M.
+  ///
+  /// If CGOpts.OptimizerThreads is greater than one, the function
+  /// simplification passes run on that many partitions through
+  /// llvm::runFunctionPassesInParallel before the module passes.  The result
+  /// is deterministic for a given thread count, but the names and order of
+  /// the globals the passes add can differ from a serial run.
+  ///
+  /// If \p Streamed is given, the function simplification passes are not run
+  /// again on the functions it has already optimized.  They still run, as
+  /// usual, on every other definition in \p M: the functions CodeGen only
+  /// reports from HandleTranslationUnit, and those it never reports, such as
+  /// thunks and global initializers.
   void EmitBackendOutput(DiagnosticsEngine &Diags, const CodeGenOptions &CGOpts,
                          const TargetOptions &TOpts, const LangOptions &LOpts,
                          StringRef TDesc, llvm::Module *M, BackendAction Action,
-                         raw_ostream *OS);
+                         raw_ostream *OS,
+                         const StreamingFunctionOptimizer *Streamed = 0);
+
+  /// StreamingFunctionOptimizer - A listener that runs the function
+  /// simplification passes on each function CodeGen reports to it, and
+  /// remembers which functions those were.
+  class StreamingFunctionOptimizer : public CodeGenFunctionListener {
+  public:
+    /// isOptimized - Whether the function passes have already run on \p F.
+    /// Functions erased from the module after being optimized are
+    /// forgotten, so a function that reuses the memory of one is not.
+    virtual bool isOptimized(const llvm::Function *F) const = 0;
+  };
+
+  /// createStreamingFunctionOptimizer - Create a listener that runs the
+  /// function simplification passes EmitBackendOutput would run on \p M on
+  /// each function as soon as CodeGen completes it.
+  ///
+  /// Installed on the CodeGenerator with setFunctionListener, this overlaps
+  /// the optimizer with parsing, and since a function's IR is simplified
+  /// while it is still hot in the cache, the module is smaller when the
+  /// whole-module passes and code generation start.  Pass the listener to
+  /// EmitBackendOutput so that it runs the function passes on the functions
+  /// the listener did not see.  Returns null if CGOpts.StreamingFunctionPasses
+  /// is not set or nothing would be run, e.g. at -O0.  The caller owns the
+  /// returned listener.
+  StreamingFunctionOptimizer *
+  createStreamingFunctionOptimizer(DiagnosticsEngine &Diags,
+                                   const CodeGenOptions &CGOpts,
+                                   const TargetOptions &TOpts,
+                                   const LangOptions &LOpts, StringRef TDesc,
+                                   llvm::Module *M);
 }
 
 #endif
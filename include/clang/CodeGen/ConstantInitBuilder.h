@@ -0,0 +1,267 @@
+//===--- ConstantInitBuilder.h - Builder for LLVM IR constants --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines ConstantInitBuilder, which builds nested constant
+// initializers such as Objective-C class, protocol and category metadata in
+// one shared buffer.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_CODEGEN_CONSTANTINITBUILDER_H
+#define LLVM_CLANG_CODEGEN_CONSTANTINITBUILDER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Module.h"
+#include <cassert>
+
+namespace clang {
+namespace CodeGen {
+
+class ConstantInitBuilder;
+
+/// ConstantAggregateBuilder - Collects the elements of one struct or array
+/// initializer at the end of its ConstantInitBuilder's buffer.
+///
+/// Builders nest: an element that is itself an aggregate is built by a
+/// child from beginStruct or beginArray, which must be finished before this
+/// builder gets more elements.  Finishing a builder turns its elements into
+/// one constant and pops them off the buffer, so a whole metadata tree is
+/// built without a temporary vector per struct.
+class ConstantAggregateBuilder {
+protected:
+  ConstantInitBuilder *Builder;
+  ConstantAggregateBuilder *Parent;
+  size_t Begin;
+  bool Finished;
+
+  ConstantAggregateBuilder(ConstantInitBuilder &Builder,
+                           ConstantAggregateBuilder *Parent);
+
+  /// Builders are returned by value from beginStruct and beginArray, so
+  /// they can be moved, but only while they have no unfinished child: the
+  /// ConstantInitBuilder then points to the moved-from builder as the
+  /// innermost one, which is fixed up, and no child points to it as its
+  /// parent.
+  ConstantAggregateBuilder(ConstantAggregateBuilder &&Other)
+    : Builder(Other.Builder), Parent(Other.Parent), Begin(Other.Begin),
+      Finished(Other.Finished) {
+    Other.Finished = true;
+    if (!Finished)
+      moveInnermost(Other);
+  }
+
+  void moveInnermost(ConstantAggregateBuilder &Other);
+
+  /// The elements added to this builder.
+  ArrayRef<llvm::Constant *> getElements() const;
+
+  /// Mark this builder as done and drop its elements from the buffer.
+  void pop();
+
+  ConstantAggregateBuilder(const ConstantAggregateBuilder &)
+      LLVM_DELETED_FUNCTION;
+  void operator=(const ConstantAggregateBuilder &) LLVM_DELETED_FUNCTION;
+
+public:
+  ~ConstantAggregateBuilder() {
+    assert(Finished && "constant aggregate was never finished");
+  }
+
+  void add(llvm::Constant *C);
+
+  void addInt(llvm::IntegerType *Ty, uint64_t Value, bool IsSigned = false) {
+    add(llvm::ConstantInt::get(Ty, Value, IsSigned));
+  }
+
+  void addNullPointer(llvm::PointerType *Ty) {
+    add(llvm::ConstantPointerNull::get(Ty));
+  }
+
+  /// Add \p C, bitcast to \p Ty if it has a different type.
+  void addBitCast(llvm::Constant *C, llvm::Type *Ty) {
+    add(llvm::ConstantExpr::getBitCast(C, Ty));
+  }
+
+  /// The number of elements added so far.
+  size_t size() const { return getElements().size(); }
+
+  class ConstantStructBuilder beginStruct(llvm::StructType *Ty = nullptr);
+  class ConstantArrayBuilder beginArray(llvm::Type *EltTy);
+};
+
+/// ConstantStructBuilder - Builds a ConstantStruct of a given type, or of
+/// the literal struct type of its elements.
+class ConstantStructBuilder : public ConstantAggregateBuilder {
+  llvm::StructType *Ty;
+  bool Packed;
+
+  friend class ConstantAggregateBuilder;
+  friend class ConstantInitBuilder;
+
+  ConstantStructBuilder(ConstantInitBuilder &Builder,
+                        ConstantAggregateBuilder *Parent,
+                        llvm::StructType *Ty)
+    : ConstantAggregateBuilder(Builder, Parent), Ty(Ty), Packed(false) {}
+
+public:
+  ConstantStructBuilder(ConstantStructBuilder &&Other)
+    : ConstantAggregateBuilder(std::move(Other)), Ty(Other.Ty),
+      Packed(Other.Packed) {}
+
+  /// Make the literal struct type packed; only without a given type.
+  void setPacked(bool IsPacked) {
+    assert(!Ty && "packing is part of the given struct type");
+    Packed = IsPacked;
+  }
+
+  /// Build the struct and drop its elements from the buffer.
+  llvm::Constant *finish() {
+    llvm::Constant *C =
+        Ty ? llvm::ConstantStruct::get(Ty, getElements())
+           : llvm::ConstantStruct::getAnon(getElements(), Packed);
+    pop();
+    return C;
+  }
+
+  /// Build the struct and add it to the builder this one was begun from.
+  void finishAndAddTo(ConstantAggregateBuilder &ParentBuilder) {
+    assert(&ParentBuilder == Parent && "not the parent builder");
+    llvm::Constant *C = finish();
+    ParentBuilder.add(C);
+  }
+
+  /// Build the struct into the initializer of a new global in \p M.
+  llvm::GlobalVariable *
+  finishAndCreateGlobal(llvm::Module &M, const Twine &Name, unsigned Align,
+                        bool IsConstant = false,
+                        llvm::GlobalValue::LinkageTypes Linkage =
+                            llvm::GlobalValue::InternalLinkage) {
+    llvm::Constant *Init = finish();
+    llvm::GlobalVariable *GV = new llvm::GlobalVariable(
+        M, Init->getType(), IsConstant, Linkage, Init, Name);
+    GV->setAlignment(Align);
+    return GV;
+  }
+};
+
+/// ConstantArrayBuilder - Builds a ConstantArray of elements of a given
+/// type, whose length is the number of elements added.
+class ConstantArrayBuilder : public ConstantAggregateBuilder {
+  llvm::Type *EltTy;
+
+  friend class ConstantAggregateBuilder;
+  friend class ConstantInitBuilder;
+
+  ConstantArrayBuilder(ConstantInitBuilder &Builder,
+                       ConstantAggregateBuilder *Parent, llvm::Type *EltTy)
+    : ConstantAggregateBuilder(Builder, Parent), EltTy(EltTy) {}
+
+public:
+  ConstantArrayBuilder(ConstantArrayBuilder &&Other)
+    : ConstantAggregateBuilder(std::move(Other)), EltTy(Other.EltTy) {}
+
+  /// Build the array and drop its elements from the buffer.
+  llvm::Constant *finish() {
+    llvm::Constant *C = llvm::ConstantArray::get(
+        llvm::ArrayType::get(EltTy, getElements().size()), getElements());
+    pop();
+    return C;
+  }
+
+  void finishAndAddTo(ConstantAggregateBuilder &ParentBuilder) {
+    assert(&ParentBuilder == Parent && "not the parent builder");
+    llvm::Constant *C = finish();
+    ParentBuilder.add(C);
+  }
+};
+
+/// ConstantInitBuilder - Owns the element buffer that all aggregate builders
+/// begun from it share.
+///
+/// One builder can be kept for the whole module: the buffer keeps its
+/// capacity between initializers, so emitting metadata for thousands of
+/// classes allocates it only as often as the deepest initializer grows it.
+class ConstantInitBuilder {
+  SmallVector<llvm::Constant *, 64> Buffer;
+  /// The innermost unfinished builder, which is the only one that may add
+  /// elements.
+  ConstantAggregateBuilder *Innermost;
+
+  friend class ConstantAggregateBuilder;
+
+  ConstantInitBuilder(const ConstantInitBuilder &) LLVM_DELETED_FUNCTION;
+  void operator=(const ConstantInitBuilder &) LLVM_DELETED_FUNCTION;
+
+public:
+  ConstantInitBuilder() : Innermost(nullptr) {}
+  ~ConstantInitBuilder() {
+    assert(Buffer.empty() && "unfinished constant aggregates");
+  }
+
+  ConstantStructBuilder beginStruct(llvm::StructType *Ty = nullptr) {
+    return ConstantStructBuilder(*this, nullptr, Ty);
+  }
+  ConstantArrayBuilder beginArray(llvm::Type *EltTy) {
+    return ConstantArrayBuilder(*this, nullptr, EltTy);
+  }
+};
+
+inline ConstantAggregateBuilder::ConstantAggregateBuilder(
+    ConstantInitBuilder &Builder, ConstantAggregateBuilder *Parent)
+  : Builder(&Builder), Parent(Parent), Begin(Builder.Buffer.size()),
+    Finished(false) {
+  assert(Builder.Innermost == Parent && "parent builder is not innermost");
+  Builder.Innermost = this;
+}
+
+inline void
+ConstantAggregateBuilder::moveInnermost(ConstantAggregateBuilder &Other) {
+  assert(Builder->Innermost == &Other &&
+         "moving a constant aggregate with an unfinished child");
+  Builder->Innermost = this;
+}
+
+inline ArrayRef<llvm::Constant *>
+ConstantAggregateBuilder::getElements() const {
+  return makeArrayRef(Builder->Buffer).slice(Begin);
+}
+
+inline void ConstantAggregateBuilder::pop() {
+  assert(!Finished && "constant aggregate finished twice");
+  assert(Builder->Innermost == this && "a child builder is unfinished");
+  Builder->Buffer.resize(Begin);
+  Builder->Innermost = Parent;
+  Finished = true;
+}
+
+inline void ConstantAggregateBuilder::add(llvm::Constant *C) {
+  assert(!Finished && "adding to a finished constant aggregate");
+  assert(Builder->Innermost == this && "a child builder is unfinished");
+  assert(C && "adding a null constant");
+  Builder->Buffer.push_back(C);
+}
+
+inline ConstantStructBuilder
+ConstantAggregateBuilder::beginStruct(llvm::StructType *Ty) {
+  return ConstantStructBuilder(*Builder, this, Ty);
+}
+
+inline ConstantArrayBuilder
+ConstantAggregateBuilder::beginArray(llvm::Type *EltTy) {
+  return ConstantArrayBuilder(*Builder, this, EltTy);
+}
+
+} // end namespace CodeGen
+} // end namespace clang
+
+#endif
@@ -18,6 +18,7 @@
 #include <string>
 
 namespace llvm {
+  class Function;
   class LLVMContext;
   class Module;
 }
@@ -28,11 +29,29 @@ namespace clang {
   class CodeGenOptions;
   class TargetOptions;
 
+  /// CodeGenFunctionListener - Receives each function as soon as CodeGen
+  /// has finished emitting its body, while the rest of the translation unit
+  /// is still being parsed.
+  class CodeGenFunctionListener {
+  public:
+    virtual ~CodeGenFunctionListener();
+
+    /// FunctionCompleted - Called once \p F has its final body.  Functions
+    /// whose body may still be replaced, such as a C function defined
+    /// without a prototype or one that a later alias or redeclaration may
+    /// retype, are only reported from HandleTranslationUnit.
+    virtual void FunctionCompleted(llvm::Function *F) = 0;
+  };
+
   class CodeGenerator : public ASTConsumer {
     virtual void anchor();
   public:
     virtual llvm::Module* GetModule() = 0;
     virtual llvm::Module* ReleaseModule() = 0;
+
+    /// setFunctionListener - Report the functions emitted from now on to
+    /// \p L, which is not owned.  Passing null stops reporting.
+    virtual void setFunctionListener(CodeGenFunctionListener *L) {}
   };
 
   /// CreateLLVMCodeGen - Create a CodeGenerator instance.
@@ -93,6 +93,9 @@ public:
 
   void addCommand(Command *C) { Jobs.addJob(C); }
 
+  /// Returns the redirection for stdout, stderr, etc, used for each command.
+  const StringRef **getRedirects() const { return Redirects; }
+
   const llvm::opt::ArgStringList &getTempFiles() const { return TempFiles; }
 
   const ArgStringMap &getResultFiles() const { return ResultFiles; }
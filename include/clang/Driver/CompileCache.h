@@ -0,0 +1,207 @@
+//===--- CompileCache.h - Content-addressed object cache --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the CompileCache class, a persistent on-disk store of
+// object files produced by -cc1 jobs, keyed by a hash of the preprocessed
+// input, the frontend arguments and the target triple.  The driver consults
+// it in CC_COMPILE_CACHE mode before spawning a -cc1 job, which lets it skip
+// the subprocess entirely on a hit.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CLANG_DRIVER_COMPILECACHE_H_
+#define CLANG_DRIVER_COMPILECACHE_H_
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Driver/Job.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <memory>
+#include <string>
+
+namespace clang {
+namespace driver {
+
+/// CompileCache - A content-addressed store of object files.
+///
+/// Entries live in \c CacheDir/<xx>/<key>.o, where \c <key> is the hex MD5
+/// computed by \c computeKey and \c <xx> its first two characters, which keeps
+/// directories small on file systems with slow lookups.  Entries are written
+/// to a unique temporary file and renamed into place, so concurrent builds
+/// sharing one cache directory never observe a partially written object.
+class CompileCache {
+  /// The root directory of the cache.
+  std::string CacheDir;
+
+  /// Statistics for this driver invocation.
+  unsigned NumHits, NumMisses, NumStores;
+
+  /// The hash format version, mixed into every key so stale entries written
+  /// by an incompatible compiler are never reused.
+  static StringRef getFormatVersion() { return "clang-compile-cache-1"; }
+
+public:
+  explicit CompileCache(StringRef Dir)
+    : CacheDir(Dir), NumHits(0), NumMisses(0), NumStores(0) {}
+
+  StringRef getCacheDir() const { return CacheDir; }
+
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumMisses() const { return NumMisses; }
+  unsigned getNumStores() const { return NumStores; }
+
+  /// isCacheable - Whether the given command is a -cc1 job whose only output
+  /// is the object file named by its -o argument.  Jobs which produce
+  /// side files (dependency files, serialized diagnostics, PCH, ...), or
+  /// which do not emit an object are never cached.
+  static bool isCacheable(const Command &C) {
+    const ArgStringList &Args = C.getArguments();
+    if (Args.empty() || StringRef(Args[0]) != "-cc1")
+      return false;
+
+    bool EmitsObject = false;
+    for (unsigned i = 0, e = Args.size(); i != e; ++i) {
+      StringRef Arg = Args[i];
+      if (Arg == "-emit-obj")
+        EmitsObject = true;
+      else if (Arg == "-dependency-file" || Arg == "-serialize-diagnostic-file"
+               || Arg == "-emit-pch" || Arg == "-emit-pth" ||
+               Arg == "-emit-module" || Arg == "-header-include-file" ||
+               Arg == "-diagnostic-log-file" || Arg == "-ftime-report" ||
+               Arg == "-print-stats" || Arg == "-fmodules")
+        return false;
+    }
+    return EmitsObject && !getOutputFile(C).empty();
+  }
+
+  /// getOutputFile - Return the argument of the last -o in \p C, or an empty
+  /// string if there is none.
+  static StringRef getOutputFile(const Command &C) {
+    const ArgStringList &Args = C.getArguments();
+    StringRef Output;
+    for (unsigned i = 0, e = Args.size(); i + 1 < e; ++i)
+      if (StringRef(Args[i]) == "-o")
+        Output = Args[++i];
+    return Output;
+  }
+
+  /// computeKey - Compute the cache key for the -cc1 command \p C.
+  ///
+  /// \param Triple - The effective target triple of the job.
+  /// \param PreprocessedInput - The main file after preprocessing, as
+  /// produced by running the same job with -E.
+  /// \param Key - Receives the hex string key.
+  static void computeKey(const Command &C, StringRef Triple,
+                         StringRef PreprocessedInput, SmallString<32> &Key) {
+    llvm::MD5 Hash;
+    const uint8_t Separator = 0;
+    Hash.update(getFormatVersion());
+    Hash.update(Separator);
+    Hash.update(Triple);
+    Hash.update(Separator);
+
+    // The output path is irrelevant to the object contents, so leave it out
+    // of the key; everything else goes in verbatim.
+    const ArgStringList &Args = C.getArguments();
+    for (unsigned i = 0, e = Args.size(); i != e; ++i) {
+      StringRef Arg = Args[i];
+      if (Arg == "-o" && i + 1 != e) {
+        ++i;
+        continue;
+      }
+      Hash.update(Arg);
+      Hash.update(Separator);
+    }
+
+    Hash.update(PreprocessedInput);
+
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    llvm::MD5::stringifyResult(Result, Key);
+  }
+
+  /// getEntryPath - Return the path of the entry for \p Key.
+  void getEntryPath(StringRef Key, SmallVectorImpl<char> &Path) const {
+    Path.clear();
+    Path.append(CacheDir.begin(), CacheDir.end());
+    llvm::sys::path::append(Path, Key.substr(0, 2), Twine(Key) + ".o");
+  }
+
+  /// lookup - If an entry exists for \p Key, copy it to \p OutputFile.
+  ///
+  /// \return True on a cache hit, in which case the -cc1 job does not need to
+  /// run.
+  bool lookup(StringRef Key, StringRef OutputFile) {
+    SmallString<256> EntryPath;
+    getEntryPath(Key, EntryPath);
+    if (!llvm::sys::fs::exists(Twine(EntryPath)) ||
+        !copyFile(EntryPath, OutputFile)) {
+      ++NumMisses;
+      return false;
+    }
+    ++NumHits;
+    return true;
+  }
+
+  /// store - Add the freshly produced \p OutputFile to the cache under
+  /// \p Key.  Failures are silently ignored; the cache is only an
+  /// optimization.
+  bool store(StringRef Key, StringRef OutputFile) {
+    SmallString<256> EntryPath;
+    getEntryPath(Key, EntryPath);
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::MemoryBuffer::getFile(OutputFile, Buffer, -1,
+                                    /*RequiresNullTerminator=*/false) ||
+        llvm::writeFileAtomically(EntryPath.str(), Buffer->getBuffer()))
+      return false;
+    ++NumStores;
+    return true;
+  }
+
+  /// printStats - Print cache statistics, in the format used by
+  /// CC_COMPILE_CACHE_STATS.
+  void printStats(raw_ostream &OS) const {
+    OS << "compile cache: " << NumHits << " hits, " << NumMisses
+       << " misses, " << NumStores << " stores (" << CacheDir << ")\n";
+  }
+
+private:
+  static bool copyFile(StringRef From, StringRef To) {
+    std::string Error;
+    SmallString<256> ToPath(To);
+    llvm::raw_fd_ostream OS(ToPath.c_str(), Error, llvm::sys::fs::F_None);
+    if (!Error.empty())
+      return false;
+
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::MemoryBuffer::getFile(From, Buffer, -1,
+                                    /*RequiresNullTerminator=*/false))
+      return false;
+
+    OS << Buffer->getBuffer();
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      return false;
+    }
+    return true;
+  }
+};
+
+} // end namespace driver
+} // end namespace clang
+
+#endif
@@ -12,6 +12,7 @@
 
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LLVM.h"
+#include "clang/Driver/Job.h"
 #include "clang/Driver/Phases.h"
 #include "clang/Driver/Types.h"
 #include "clang/Driver/Util.h"
@@ -121,6 +122,9 @@ public:
   /// The file to log CC_LOG_DIAGNOSTICS output to, if enabled.
   const char *CCLogDiagnosticsFilename;
 
+  /// The root directory of the CC_COMPILE_CACHE object cache, if enabled.
+  const char *CCCompileCacheDir;
+
   /// A list of inputs and their types for the given arguments.
   typedef SmallVector<std::pair<types::ID, const llvm::opt::Arg *>, 16>
       InputList;
@@ -153,6 +157,29 @@ public:
   /// Whether the driver is generating diagnostics for debugging purposes.
   unsigned CCGenDiagnostics : 1;
 
+  /// Set CC_COMPILE_CACHE mode, which causes cacheable -cc1 jobs to be looked
+  /// up in a CompileCache rooted at CCCompileCacheDir before they are run, and
+  /// their objects to be stored there after they succeed.
+  unsigned CCCompileCache : 1;
+
+  /// The entry points used by CC_INPROCESS_CC1 mode to run -cc1 and -cc1as
+  /// jobs as CC1Commands inside the driver process.  These are set by the
+  /// driver's main(), and are null when the mode is disabled.
+  CC1MainFn CC1Main;
+  CC1MainFn CC1AsMain;
+
+  /// The address of the driver's main(), passed through to in-process jobs.
+  void *CC1MainAddr;
+
+  /// The maximum number of jobs ExecuteCompilation runs concurrently, as set
+  /// by CC_PARALLEL_JOBS; 1 runs the job list serially.  Parallel execution
+  /// goes through a JobScheduler, and is disabled in CC_PRINT_OPTIONS mode so
+  /// that logged command lines are never interleaved.
+  unsigned NumParallelJobs;
+
+  /// Whether the driver runs eligible frontend jobs in-process.
+  bool isInProcessCC1Enabled() const { return CC1Main && CC1AsMain; }
+
 private:
   /// Name to use when invoking gcc/g++.
   std::string CCCGenericGCCName;
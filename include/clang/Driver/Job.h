@@ -13,6 +13,7 @@
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Option/Option.h"
+#include "llvm/Support/CrashRecoveryContext.h"
 #include <memory>
 
 namespace llvm {
@@ -33,6 +34,7 @@ public:
   enum JobClass {
     CommandClass,
     FallbackCommandClass,
+    CC1CommandClass,
     JobListClass
   };
 
@@ -41,6 +43,9 @@ private:
 
 protected:
   Job(JobClass _Kind) : Kind(_Kind) {}
+
+  /// setKind - Allow subclasses of concrete jobs to refine their kind.
+  void setKind(JobClass _Kind) { Kind = _Kind; }
 public:
   virtual ~Job();
 
@@ -94,7 +99,8 @@ public:
 
   static bool classof(const Job *J) {
     return J->getKind() == CommandClass ||
-           J->getKind() == FallbackCommandClass;
+           J->getKind() == FallbackCommandClass ||
+           J->getKind() == CC1CommandClass;
   }
 };
 
@@ -120,6 +126,94 @@ private:
   std::unique_ptr<Command> Fallback;
 };
 
+/// CC1MainFn - The signature of the cc1_main and cc1as_main entry points.
+/// \p ArgBegin and \p ArgEnd delimit the arguments following -cc1 or -cc1as.
+typedef int (*CC1MainFn)(const char **ArgBegin, const char **ArgEnd,
+                         const char *Argv0, void *MainAddr);
+
+/// CC1Command - Like Command, but runs a -cc1 or -cc1as job in the driver
+/// process by calling its entry point directly, instead of paying for a
+/// fork and exec of the driver executable.
+///
+/// The job runs inside a CrashRecoveryContext, so a frontend crash is
+/// reported to the driver as a negative result code, just like a crashing
+/// subprocess.  Jobs which the in-process path can not isolate fall back to
+/// Command::Execute.
+class CC1Command : public Command {
+  /// The entry point to call, cc1_main or cc1as_main.
+  CC1MainFn Main;
+
+  /// The address passed through to the entry point to locate the resource
+  /// directory.
+  void *MainAddr;
+
+public:
+  CC1Command(const Action &Source_, const Tool &Creator_,
+             const char *Executable_, const ArgStringList &Arguments_,
+             CC1MainFn Main_, void *MainAddr_)
+    : Command(Source_, Creator_, Executable_, Arguments_), Main(Main_),
+      MainAddr(MainAddr_) {
+    setKind(CC1CommandClass);
+  }
+
+  /// canExecuteInProcess - Whether this job may run in the driver process.
+  ///
+  /// Output redirection only applies to subprocesses, and -mllvm options
+  /// mutate the process-wide llvm::cl state, which would leak into every
+  /// later job of this compilation.
+  bool canExecuteInProcess(const StringRef **Redirects) const {
+    if (Redirects)
+      for (unsigned i = 0; i != 3; ++i)
+        if (Redirects[i])
+          return false;
+    const ArgStringList &Args = getArguments();
+    if (Args.empty())
+      return false;
+    StringRef Mode = Args[0];
+    if (Mode != "-cc1" && Mode != "-cc1as")
+      return false;
+    for (unsigned i = 1, e = Args.size(); i != e; ++i)
+      if (StringRef(Args[i]) == "-mllvm")
+        return false;
+    return true;
+  }
+
+  int Execute(const StringRef **Redirects, std::string *ErrMsg,
+              bool *ExecutionFailed) const override {
+    if (!canExecuteInProcess(Redirects))
+      return Command::Execute(Redirects, ErrMsg, ExecutionFailed);
+
+    if (ExecutionFailed)
+      *ExecutionFailed = false;
+
+    SmallVector<const char *, 128> Argv(getArguments().begin() + 1,
+                                        getArguments().end());
+    struct RunCC1 {
+      const CC1Command *Self;
+      SmallVectorImpl<const char *> *Argv;
+      int *Result;
+      void operator()() const {
+        *Result = Self->Main(Argv->begin(), Argv->end(), Self->getExecutable(),
+                             Self->MainAddr);
+      }
+    };
+    int Result = 0;
+    RunCC1 Run = { this, &Argv, &Result };
+
+    llvm::CrashRecoveryContext CRC;
+    if (!CRC.RunSafely(Run)) {
+      if (ErrMsg)
+        *ErrMsg = "in-process frontend job crashed";
+      return -1;
+    }
+    return Result;
+  }
+
+  static bool classof(const Job *J) {
+    return J->getKind() == CC1CommandClass;
+  }
+};
+
 /// JobList - A sequence of jobs to perform.
 class JobList : public Job {
 public:
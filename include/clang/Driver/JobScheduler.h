@@ -0,0 +1,230 @@
+//===--- JobScheduler.h - Parallel Job Execution ----------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the JobScheduler class, which runs the independent jobs
+// of a Compilation concurrently while respecting the dependencies implied by
+// their actions.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CLANG_DRIVER_JOBSCHEDULER_H_
+#define CLANG_DRIVER_JOBSCHEDULER_H_
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Driver/Action.h"
+#include "clang/Driver/Compilation.h"
+#include "clang/Driver/Driver.h"
+#include "clang/Driver/DriverDiagnostic.h"
+#include "clang/Driver/Job.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/Program.h"
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace clang {
+namespace driver {
+
+/// JobScheduler - Run the commands of a JobList on up to \c MaxJobs
+/// concurrent subprocesses.
+///
+/// A command depends on every earlier command whose source action is
+/// reachable from its own source action, so per-architecture compiles and
+/// assembles overlap while the link, lipo and dsymutil steps wait for their
+/// inputs.  A command also depends on every earlier command built from the
+/// same source action, since tools such as the -gsplit-dwarf objcopy steps
+/// run after the compile of that action and rewrite its output.
+///
+/// Commands that depend on a failed command are skipped, and failures are
+/// reported in job list order regardless of completion order.
+///
+/// Only plain Commands are spawned asynchronously.  Other kinds of commands
+/// (fallback and in-process commands) are run synchronously through
+/// Compilation::ExecuteCommand once their inputs are ready; subprocesses that
+/// are already running keep making progress meanwhile.
+class JobScheduler {
+  enum NodeState {
+    Waiting,
+    Running,
+    Succeeded,
+    Failed,
+    Skipped
+  };
+
+  struct Node {
+    const Command *Cmd;
+    NodeState State;
+    unsigned NumPendingInputs;
+    SmallVector<unsigned, 4> Users;
+    llvm::sys::ProcessInfo PI;
+    int Result;
+
+    explicit Node(const Command *Cmd)
+      : Cmd(Cmd), State(Waiting), NumPendingInputs(0), Result(0) {}
+  };
+
+  const Compilation &C;
+  unsigned MaxJobs;
+  std::vector<Node> Nodes;
+  std::deque<unsigned> Ready;
+  SmallVector<unsigned, 16> RunningNodes;
+  unsigned NumFinished;
+
+  void addJobs(const Job &J) {
+    if (const Command *Cmd = dyn_cast<Command>(&J)) {
+      Nodes.push_back(Node(Cmd));
+      return;
+    }
+    const JobList *Jobs = cast<JobList>(&J);
+    for (JobList::const_iterator it = Jobs->begin(), ie = Jobs->end();
+         it != ie; ++it)
+      addJobs(**it);
+  }
+
+  static void collectInputActions(const Action *A,
+                                  llvm::SmallPtrSet<const Action *, 16> &Set) {
+    for (Action::const_iterator it = A->begin(), ie = A->end(); it != ie; ++it)
+      if (Set.insert(*it))
+        collectInputActions(*it, Set);
+  }
+
+  void buildDependencies() {
+    for (unsigned i = 0, e = Nodes.size(); i != e; ++i) {
+      const Action *Source = &Nodes[i].Cmd->getSource();
+      llvm::SmallPtrSet<const Action *, 16> Inputs;
+      collectInputActions(Source, Inputs);
+      for (unsigned j = 0; j != i; ++j) {
+        const Action *Prev = &Nodes[j].Cmd->getSource();
+        if (Prev != Source && !Inputs.count(Prev))
+          continue;
+        Nodes[j].Users.push_back(i);
+        ++Nodes[i].NumPendingInputs;
+      }
+      if (!Nodes[i].NumPendingInputs)
+        Ready.push_back(i);
+    }
+  }
+
+  void finish(unsigned Idx, int Result) {
+    Node &N = Nodes[Idx];
+    N.Result = Result;
+    N.State = Result ? Failed : Succeeded;
+    ++NumFinished;
+    for (unsigned i = 0, e = N.Users.size(); i != e; ++i) {
+      unsigned User = N.Users[i];
+      if (Result)
+        skip(User);
+      else if (Nodes[User].State == Waiting && !--Nodes[User].NumPendingInputs)
+        Ready.push_back(User);
+    }
+  }
+
+  void skip(unsigned Idx) {
+    Node &N = Nodes[Idx];
+    if (N.State == Skipped)
+      return;
+    N.State = Skipped;
+    ++NumFinished;
+    for (unsigned i = 0, e = N.Users.size(); i != e; ++i)
+      skip(N.Users[i]);
+  }
+
+  void start(unsigned Idx, const StringRef **Redirects) {
+    Node &N = Nodes[Idx];
+    if (N.Cmd->getKind() != Job::CommandClass) {
+      const Command *FailingCommand = 0;
+      finish(Idx, C.ExecuteCommand(*N.Cmd, FailingCommand));
+      return;
+    }
+
+    SmallVector<const char *, 128> Argv;
+    Argv.push_back(N.Cmd->getExecutable());
+    Argv.append(N.Cmd->getArguments().begin(), N.Cmd->getArguments().end());
+    Argv.push_back(0);
+
+    std::string Error;
+    bool ExecutionFailed;
+    N.PI = llvm::sys::ExecuteNoWait(N.Cmd->getExecutable(), Argv.data(),
+                                    /*env=*/0, Redirects, /*memoryLimit=*/0,
+                                    &Error, &ExecutionFailed);
+    if (ExecutionFailed) {
+      C.getDriver().Diag(clang::diag::err_drv_command_failure) << Error;
+      finish(Idx, -1);
+      return;
+    }
+    N.State = Running;
+    RunningNodes.push_back(Idx);
+  }
+
+  /// reapOne - Wait until at least one running subprocess has terminated.
+  ///
+  /// sys::Wait can only wait for a specific child, so poll every running job
+  /// first and only block on the oldest one if none has finished yet.
+  void reapOne() {
+    for (unsigned Attempt = 0; Attempt != 2; ++Attempt) {
+      for (unsigned i = 0; i != RunningNodes.size(); ++i) {
+        Node &N = Nodes[RunningNodes[i]];
+        std::string Error;
+        llvm::sys::ProcessInfo WaitResult =
+            llvm::sys::Wait(N.PI, /*SecondsToWait=*/0,
+                            /*WaitUntilTerminates=*/Attempt != 0 && i == 0,
+                            &Error);
+        if (WaitResult.Pid != N.PI.Pid)
+          continue;
+        unsigned Idx = RunningNodes[i];
+        RunningNodes.erase(RunningNodes.begin() + i);
+        finish(Idx, WaitResult.ReturnCode);
+        return;
+      }
+    }
+  }
+
+public:
+  JobScheduler(const Compilation &C, const JobList &Jobs, unsigned MaxJobs)
+    : C(C), MaxJobs(std::max(MaxJobs, 1U)), NumFinished(0) {
+    addJobs(Jobs);
+    buildDependencies();
+  }
+
+  /// run - Execute all jobs.
+  ///
+  /// \param Redirects - Redirection for stdout, stderr, etc, as for
+  /// Command::Execute.
+  /// \param FailingCommands - Receives the failing commands and their result
+  /// codes, in job list order.
+  void run(const StringRef **Redirects,
+           SmallVectorImpl<std::pair<int, const Command *> > &FailingCommands) {
+    while (NumFinished != Nodes.size()) {
+      while (RunningNodes.size() < MaxJobs && !Ready.empty()) {
+        unsigned Idx = Ready.front();
+        Ready.pop_front();
+        if (Nodes[Idx].State == Waiting)
+          start(Idx, Redirects);
+      }
+      if (RunningNodes.empty()) {
+        if (Ready.empty())
+          break;
+        continue;
+      }
+      reapOne();
+    }
+
+    for (unsigned i = 0, e = Nodes.size(); i != e; ++i)
+      if (Nodes[i].State == Failed)
+        FailingCommands.push_back(std::make_pair(Nodes[i].Result,
+                                                 Nodes[i].Cmd));
+  }
+};
+
+} // end namespace driver
+} // end namespace clang
+
+#endif
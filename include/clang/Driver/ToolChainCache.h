@@ -0,0 +1,225 @@
+//===--- ToolChainCache.h - Per-session toolchain lookup cache --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the ToolChainCache class, which remembers what the
+// driver resolved for a target triple and sysroot (program and library
+// paths, SDK versions) for the rest of a build session, so that later driver
+// runs skip the file system probes behind ToolChain::GetProgramPath and
+// ToolChain::GetFilePath.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CLANG_DRIVER_TOOLCHAINCACHE_H_
+#define CLANG_DRIVER_TOOLCHAINCACHE_H_
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Driver/Driver.h"
+#include "clang/Driver/ToolChain.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+
+namespace clang {
+namespace driver {
+
+/// ToolChainCache - The toolchain resolution results of one triple and
+/// sysroot, shared by the driver runs of a build session.
+///
+/// Each entry maps a key such as "program:ld" or "sdk-version" to the string
+/// the driver resolved it to.  Besides the triple and sysroot, the results
+/// depend on where the driver is installed, the -B prefixes and PATH, which
+/// are all searched for programs; a hash of those is part of the key too, so
+/// driver runs that differ in any of them use separate caches.  The entries
+/// live in a small text file in \c CacheDir named after the session and a
+/// hash of the key;
+/// it is read when the cache is created, and rewritten through a temporary
+/// file and a rename when new entries were added.  As with the stat cache
+/// and -fmodules-validate-once-per-build-session, the toolchain and SDK are
+/// assumed not to change during a session, so entries are never
+/// revalidated.  Concurrent writers may drop each other's additions, which
+/// only costs the probes again.
+///
+/// The time spent resolving, whether from the cache or through the
+/// toolchain, is accumulated so that the driver can report its own overhead
+/// in -### mode, where it runs no jobs.
+class ToolChainCache {
+  std::string CacheFile;
+  std::string Triple;
+  std::string Sysroot;
+  /// The hash of the install dir, the -B prefixes and PATH.
+  size_t SearchPathHash;
+  llvm::StringMap<std::string> Entries;
+  bool Dirty;
+  unsigned NumHits, NumMisses;
+  llvm::TimeRecord ResolveTime;
+
+  /// The first line of the file, which must match for it to be used.
+  std::string getHeader() const {
+    return ("toolchain-cache 2\t" + Triple + "\t" + Sysroot + "\t" +
+            Twine::utohexstr(SearchPathHash)).str();
+  }
+
+  void load() {
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::MemoryBuffer::getFile(CacheFile, Buffer))
+      return;
+    std::pair<StringRef, StringRef> Line = Buffer->getBuffer().split('\n');
+    if (Line.first != getHeader())
+      return;
+    while (!Line.second.empty()) {
+      Line = Line.second.split('\n');
+      std::pair<StringRef, StringRef> Entry = Line.first.split('\t');
+      if (!Entry.first.empty())
+        Entries[Entry.first] = Entry.second;
+    }
+  }
+
+  template <typename Fn>
+  std::string resolve(StringRef Key, Fn Resolve) {
+    llvm::TimeRecord Start = llvm::TimeRecord::getCurrentTime(true);
+    std::string Value;
+    llvm::StringMap<std::string>::const_iterator I = Entries.find(Key);
+    if (I != Entries.end()) {
+      ++NumHits;
+      Value = I->second;
+    } else {
+      ++NumMisses;
+      Value = Resolve();
+      insert(Key, Value);
+    }
+    ResolveTime += llvm::TimeRecord::getCurrentTime(false);
+    ResolveTime -= Start;
+    return Value;
+  }
+
+  /// The hash of what the driver of \p TC searches for programs and files
+  /// besides the sysroot.
+  static size_t getSearchPathHash(const ToolChain &TC) {
+    const Driver &D = TC.getDriver();
+    llvm::hash_code Hash = llvm::hash_value(StringRef(D.getInstalledDir()));
+    for (unsigned I = 0, E = D.PrefixDirs.size(); I != E; ++I)
+      Hash = llvm::hash_combine(Hash, D.PrefixDirs[I]);
+    if (Optional<std::string> Path = llvm::sys::Process::GetEnv("PATH"))
+      Hash = llvm::hash_combine(Hash, *Path);
+    return Hash;
+  }
+
+public:
+  /// Create the cache of \p TC, reading the results recorded earlier in the
+  /// build session \p BuildSessionTimestamp.
+  ToolChainCache(StringRef CacheDir, uint64_t BuildSessionTimestamp,
+                 const ToolChain &TC, StringRef Sysroot)
+    : Triple(TC.getTripleString()), Sysroot(Sysroot),
+      SearchPathHash(getSearchPathHash(TC)), Dirty(false), NumHits(0),
+      NumMisses(0) {
+    SmallString<256> Path(CacheDir);
+    llvm::sys::path::append(
+        Path, "toolchain-" + Twine(BuildSessionTimestamp) + "-" +
+                  Twine::utohexstr(llvm::hash_combine(Triple, Sysroot,
+                                                      SearchPathHash)) +
+                  ".txt");
+    CacheFile = Path.str();
+    load();
+  }
+
+  ~ToolChainCache() { save(); }
+
+  StringRef getCacheFile() const { return CacheFile; }
+
+  /// Look up \p Key; returns false if it was not recorded.
+  bool lookup(StringRef Key, std::string &Value) const {
+    llvm::StringMap<std::string>::const_iterator I = Entries.find(Key);
+    if (I == Entries.end())
+      return false;
+    Value = I->second;
+    return true;
+  }
+
+  /// Record \p Value for \p Key.  Values that cannot be stored in the file
+  /// are not recorded.
+  void insert(StringRef Key, StringRef Value) {
+    if (Key.empty() || Key.find_first_of("\t\n") != StringRef::npos ||
+        Value.find('\n') != StringRef::npos)
+      return;
+    llvm::StringMap<std::string>::iterator I = Entries.find(Key);
+    if (I != Entries.end() && I->second == Value)
+      return;
+    Entries[Key] = Value;
+    Dirty = true;
+  }
+
+  /// ToolChain::GetProgramPath, through the cache.
+  std::string getProgramPath(const ToolChain &TC, const char *Name) {
+    return resolve("program:" + std::string(Name),
+                   [&] { return TC.GetProgramPath(Name); });
+  }
+
+  /// ToolChain::GetFilePath, through the cache.
+  std::string getFilePath(const ToolChain &TC, const char *Name) {
+    return resolve("file:" + std::string(Name),
+                   [&] { return TC.GetFilePath(Name); });
+  }
+
+  /// Any other result, such as the SDK version parsed from the sysroot,
+  /// computed by \p Compute on a miss.
+  template <typename Fn>
+  std::string get(StringRef Key, Fn Compute) {
+    return resolve(Key, Compute);
+  }
+
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumMisses() const { return NumMisses; }
+  const llvm::TimeRecord &getResolveTime() const { return ResolveTime; }
+
+  /// Print the lookup counts and the time spent resolving, for -###.
+  void printStats(raw_ostream &OS) const {
+    OS << "toolchain cache: " << NumHits << " hits, " << NumMisses
+       << " misses, ";
+    OS << llvm::format("%.4f", ResolveTime.getWallTime())
+       << "s resolving (" << CacheFile << ")\n";
+  }
+
+  /// Write the entries to the cache file if any were added.
+  ///
+  /// \returns true on success, or if there was nothing to write.
+  bool save() {
+    if (!Dirty)
+      return true;
+
+    SmallString<1024> Contents;
+    {
+      llvm::raw_svector_ostream Out(Contents);
+      Out << getHeader() << '\n';
+      for (llvm::StringMap<std::string>::const_iterator I = Entries.begin(),
+                                                        E = Entries.end();
+           I != E; ++I)
+        Out << I->getKey() << '\t' << I->second << '\n';
+    }
+    if (llvm::writeFileAtomically(CacheFile, Contents.str()))
+      return false;
+    Dirty = false;
+    return true;
+  }
+};
+
+} // end namespace driver
+} // end namespace clang
+
+#endif
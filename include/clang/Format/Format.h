@@ -17,7 +17,13 @@
 
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Tooling/Refactoring.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/system_error.h"
+#include <algorithm>
 
 namespace clang {
 
@@ -76,6 +82,19 @@ struct FormatStyle {
   /// \brief The penalty for breaking a function call after "call(".
   unsigned PenaltyBreakBeforeFirstCallParameter;
 
+  /// \brief The maximum number of states the line-breaking penalty search
+  /// explores for one unwrapped line, or 0 for no limit.
+  ///
+  /// Long Objective-C message sends and nested block literals can make the
+  /// search explore exponentially many states.  Once the limit is hit, the
+  /// rest of the line is laid out by a dynamic-programming pass that keeps
+  /// only the cheapest state per token for each choice of breaking before
+  /// it, which takes time linear in the number of tokens; the result may be
+  /// worse than the optimum.  The number of explored states per line and of
+  /// lines hitting the limit are printed with -debug-only=format-formatter
+  /// and counted by -stats.
+  unsigned PenaltySearchStateLimit;
+
   /// \brief Set whether & and * bind to the type as opposed to the variable.
   bool PointerBindsToType;
 
@@ -372,6 +391,7 @@ struct FormatStyle {
            PenaltyBreakString == R.PenaltyBreakString &&
            PenaltyExcessCharacter == R.PenaltyExcessCharacter &&
            PenaltyReturnTypeOnItsOwnLine == R.PenaltyReturnTypeOnItsOwnLine &&
+           PenaltySearchStateLimit == R.PenaltySearchStateLimit &&
            PointerBindsToType == R.PointerBindsToType &&
            SpacesBeforeTrailingComments == R.SpacesBeforeTrailingComments &&
            Cpp11BracedListStyle == R.Cpp11BracedListStyle &&
@@ -456,6 +476,147 @@ tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
                                std::vector<tooling::Range> Ranges,
                                StringRef FileName = "<stdin>");
 
+/// \brief State kept between reformat() calls on successive versions of one
+/// file, as an editor formatting on save does, so that each call does work
+/// proportional to what changed rather than to the size of the file.
+///
+/// The cache keeps two things:
+/// \li The offsets in the last formatted code at which the unwrapped line
+///   parser was at the top level (outside of any block, parenthesis or
+///   preprocessor directive), with the unwrapped lines before each.  The
+///   next call re-lexes and re-parses only from the last such offset before
+///   the first change; the lines before it are reused.
+/// \li The result of the line-breaking penalty search for each unwrapped
+///   line, keyed by the line's tokens, the state it starts in and the style.
+///   Identical lines, which generated code is full of, are only searched
+///   once.
+///
+/// Both are dropped when the style changes.  A cache must only be used for
+/// one file at a time.
+class FormattingCache {
+public:
+  /// \brief The whitespace the penalty search chose before one token of a
+  /// line.
+  struct TokenWhitespace {
+    unsigned Newlines;
+    unsigned Spaces;
+  };
+
+  /// \brief The result of the penalty search for one unwrapped line.
+  struct LineLayout {
+    unsigned Penalty;
+    SmallVector<TokenWhitespace, 16> Whitespace;
+  };
+
+private:
+  std::string StyleConfiguration;
+  /// The hash of StyleConfiguration, part of every layout key.
+  size_t StyleHash;
+  std::string LastCode;
+  /// Sorted offsets in LastCode at which the parser was at the top level.
+  std::vector<unsigned> TopLevelOffsets;
+  llvm::StringMap<LineLayout> Layouts;
+  unsigned NumReusedBytes, NumLayoutHits, NumLayoutMisses;
+
+public:
+  FormattingCache()
+      : StyleHash(0), NumReusedBytes(0), NumLayoutHits(0), NumLayoutMisses(0) {}
+
+  /// \brief Prepare to format with \p Style, dropping everything cached if
+  /// it differs from the style of the last call.
+  void setStyle(const FormatStyle &Style) {
+    std::string Configuration = configurationAsText(Style);
+    if (Configuration == StyleConfiguration)
+      return;
+    StyleConfiguration.swap(Configuration);
+    StyleHash = llvm::hash_value(StyleConfiguration);
+    clear();
+  }
+
+  void clear() {
+    LastCode.clear();
+    TopLevelOffsets.clear();
+    Layouts.clear();
+  }
+
+  /// \brief Return the offset in \p Code from which it must be parsed
+  /// again: the last top-level offset of the previously formatted code that
+  /// is not after the first difference between the two.
+  unsigned getReparseOffset(StringRef Code) const {
+    size_t Common = 0, Max = std::min<size_t>(Code.size(), LastCode.size());
+    while (Common != Max && Code[Common] == LastCode[Common])
+      ++Common;
+    // An offset exactly at the first difference is still good: the parser
+    // state there does not depend on what follows.
+    std::vector<unsigned>::const_iterator I = std::upper_bound(
+        TopLevelOffsets.begin(), TopLevelOffsets.end(), unsigned(Common));
+    return I == TopLevelOffsets.begin() ? 0 : *--I;
+  }
+
+  /// \brief Record \p Code as the last formatted version of the file, with
+  /// the offsets at which its parse was at the top level.
+  void setParsedCode(StringRef Code, ArrayRef<unsigned> TopLevel,
+                     unsigned ReusedBytes) {
+    LastCode = Code;
+    TopLevelOffsets.assign(TopLevel.begin(), TopLevel.end());
+    NumReusedBytes += ReusedBytes;
+  }
+
+  /// \brief Compute the key of an unwrapped line for the layout cache.
+  ///
+  /// The key covers everything the penalty search for the line depends on,
+  /// so that a layout is only reused where the search would choose it again.
+  ///
+  /// \param Tokens The text of the tokens of the line.
+  /// \param FirstIndent The column the line starts in.
+  /// \param Level The nesting level of the line.
+  /// \param InPPDirective Whether the line is (part of) a preprocessor
+  /// directive.
+  /// \param ColumnLimit The column limit the line is laid out against, which
+  /// is smaller than that of the style within a preprocessor directive.
+  /// \param PreviousIndent The column the previous line started in, which
+  /// decides the alignment of trailing comments and continuations.
+  void getLineKey(ArrayRef<StringRef> Tokens, unsigned FirstIndent,
+                  unsigned Level, bool InPPDirective, unsigned ColumnLimit,
+                  unsigned PreviousIndent, SmallVectorImpl<char> &Key) const {
+    Key.clear();
+    llvm::raw_svector_ostream OS(Key);
+    OS << StyleHash << ':' << FirstIndent << ':' << Level << ':'
+       << InPPDirective << ':' << ColumnLimit << ':' << PreviousIndent;
+    for (unsigned I = 0, E = Tokens.size(); I != E; ++I)
+      OS << ' ' << Tokens[I].size() << ':' << Tokens[I];
+    OS.flush();
+  }
+
+  /// \brief Find the cached layout of the line with key \p Key.
+  const LineLayout *findLayout(StringRef Key) {
+    llvm::StringMap<LineLayout>::const_iterator I = Layouts.find(Key);
+    if (I == Layouts.end()) {
+      ++NumLayoutMisses;
+      return 0;
+    }
+    ++NumLayoutHits;
+    return &I->second;
+  }
+
+  void addLayout(StringRef Key, const LineLayout &Layout) {
+    Layouts[Key] = Layout;
+  }
+
+  unsigned getNumReusedBytes() const { return NumReusedBytes; }
+  unsigned getNumLayoutHits() const { return NumLayoutHits; }
+  unsigned getNumLayoutMisses() const { return NumLayoutMisses; }
+};
+
+/// \brief Reformats the given \p Ranges in \p Code, reusing and updating
+/// the work of earlier calls on the same file recorded in \p Cache.
+///
+/// Otherwise identical to the reformat() function consuming a \c Lexer.
+tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
+                               std::vector<tooling::Range> Ranges,
+                               FormattingCache &Cache,
+                               StringRef FileName = "<stdin>");
+
 /// \brief Returns the \c LangOpts that the formatter expects you to set.
 ///
 /// \param Standard determines lexing mode: LC_Cpp11 and LS_Auto turn on C++11
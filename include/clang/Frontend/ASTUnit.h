@@ -21,6 +21,7 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Frontend/LazyFunctionBodies.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/ModuleLoader.h"
 #include "clang/Lex/PreprocessingRecord.h"
@@ -48,6 +49,7 @@ class Sema;
 class ASTContext;
 class ASTReader;
 class CodeCompleteConsumer;
+class CodeCompletionFilter;
 class CompilerInvocation;
 class CompilerInstance;
 class Decl;
@@ -60,6 +62,12 @@ class SourceManager;
 class TargetInfo;
 class ASTFrontendAction;
 class ASTDeserializationListener;
+class BackgroundPreambleBuilder;
+class PrecompiledPreamble;
+class PreambleCache;
+class FunctionBodyReuse;
+class Parser;
+struct SourceEdit;
 
 /// \brief Utility class for loading a ASTContext from an AST file.
 ///
@@ -290,6 +298,41 @@ private:
   /// \brief A list of the serialization ID numbers for each of the top-level
   /// declarations parsed within the precompiled preamble.
   std::vector<serialization::DeclID> TopLevelDeclsInPreamble;
+
+  /// \brief The precompiled preamble in use, when it came from the
+  /// background builder or a PreambleCache rather than being built in place.
+  IntrusiveRefCntPtr<PrecompiledPreamble> SharedPreamble;
+
+  /// \brief The cache of preambles shared with other translation units, if
+  /// any.
+  IntrusiveRefCntPtr<PreambleCache> SharedPreambles;
+
+  /// \brief The key SharedPreamble was acquired from SharedPreambles under,
+  /// which it is released under when it is replaced or the unit is
+  /// destroyed.
+  std::string SharedPreambleKey;
+
+  /// \brief The builder of the next preamble, when preambles are rebuilt in
+  /// the background.
+  std::unique_ptr<BackgroundPreambleBuilder> PreambleBuilder;
+
+  /// \brief Whether an out-of-date preamble is rebuilt on a background
+  /// thread.  Until the new preamble is ready, code completion keeps using
+  /// the stale one, and reparses whose preamble changed parse without one.
+  bool BuildPreambleInBackground : 1;
+
+  /// \brief The function bodies skipped by the last ReparseWithEdits, and the
+  /// stored diagnostics it moved for them, if the last parse was one.
+  std::unique_ptr<FunctionBodyReuse> BodyReuse;
+
+  /// \brief Whether the bodies of the main file are parsed on demand.
+  bool LazyFunctionBodies;
+
+  /// \brief The unparsed bodies of the main file, with lazy function bodies.
+  LazyFunctionBodyIndex LazyBodies;
+
+  /// \brief The parser kept from the last parse to parse LazyBodies.
+  std::unique_ptr<Parser> LazyBodyParser;
   
   /// \brief Whether we should be caching code-completion results.
   bool ShouldCacheCodeCompletionResults : 1;
@@ -383,6 +426,10 @@ private:
 
   /// \brief The set of cached code-completion results.
   std::vector<CachedCodeCompletionResult> CachedCompletionResults;
+
+  /// \brief An index of the typed text of the cached code-completion
+  /// results, built on first use and dropped when the cache is refreshed.
+  std::unique_ptr<CodeCompletionFilter> CachedCompletionFilter;
   
   /// \brief A mapping from the formatted type name to a unique number for that
   /// type, which is used for type equality comparisons.
@@ -481,6 +528,38 @@ public:
   bool isUnsafeToFree() const { return UnsafeToFree; }
   void setUnsafeToFree(bool Value) { UnsafeToFree = Value; }
 
+  /// \brief Rebuild out-of-date preambles on a background thread, swapping
+  /// the new preamble in at the first reparse or code completion after it
+  /// is ready.
+  void setBuildPreambleInBackground(bool Value) {
+    BuildPreambleInBackground = Value;
+  }
+  bool getBuildPreambleInBackground() const {
+    return BuildPreambleInBackground;
+  }
+
+  /// \brief Share precompiled preambles through \p Cache with other
+  /// translation units whose main files start with the same preamble.
+  void setPreambleCache(PreambleCache *Cache);
+
+  /// \brief Skip the function bodies of the main file at the next parse,
+  /// caching their tokens, and parse each one only when parseLazyBodies
+  /// asks for a range inside it.
+  void setLazyFunctionBodies(bool Value) { LazyFunctionBodies = Value; }
+  bool getLazyFunctionBodies() const { return LazyFunctionBodies; }
+
+  /// \brief Record that the body of \p D, from \p Begin to \p End in the
+  /// main file, was left unparsed; the parser calls this.
+  void addLazyFunctionBody(Decl *D, SourceLocation Begin, SourceLocation End);
+
+  /// \brief Parse the lazy function bodies that overlap \p Range, so that
+  /// cursors, annotated tokens and code completion see into them.
+  ///
+  /// \returns true if any body was parsed, which adds declarations and
+  /// diagnostics to the AST; anything computed from it before must be
+  /// recomputed.
+  bool parseLazyBodies(SourceRange Range);
+
   const DiagnosticsEngine &getDiagnostics() const { return *Diagnostics; }
   DiagnosticsEngine &getDiagnostics()             { return *Diagnostics; }
   
@@ -656,6 +735,15 @@ public:
     return CachedCompletionResults.size(); 
   }
 
+  /// \brief Retrieve the index of the typed text of the cached
+  /// code-completion results, whose indices are those of the
+  /// cached_completion iterators.
+  ///
+  /// Code completion narrows the cached results with it when the user has
+  /// already typed part of the name being completed, instead of adding every
+  /// cached result for Sema to filter.
+  CodeCompletionFilter &getCachedCompletionFilter();
+
   /// \brief Returns an iterator range for the local preprocessing entities
   /// of the local Preprocessor, if this is a parsed source file, or the loaded
   /// preprocessing entities of the primary module if this is an AST file.
@@ -818,6 +906,23 @@ public:
   /// contain any translation-unit information, false otherwise.  
   bool Reparse(ArrayRef<RemappedFile> RemappedFiles = None);
 
+  /// \brief Reparse after the edits \p Edits of the main file, given in
+  /// offsets of the contents it was last parsed with, skipping the function
+  /// and method bodies no edit touched.
+  ///
+  /// The skipped bodies keep the diagnostics of the last parse, and have no
+  /// body in the new AST, so cursors and code completion cannot see into
+  /// them; a plain Reparse parses everything again.
+  ///
+  /// \returns True if a failure occurred that causes the ASTUnit not to
+  /// contain any translation-unit information, false otherwise.
+  bool ReparseWithEdits(ArrayRef<RemappedFile> RemappedFiles,
+                        ArrayRef<SourceEdit> Edits);
+
+  /// \brief Whether the body of \p D can be skipped by the reparse in
+  /// progress; the ASTConsumer of ASTUnit's parses defers to this.
+  bool shouldSkipFunctionBody(Decl *D);
+
   /// \brief Perform code completion at the given file, line, and
   /// column within this translation unit.
   ///
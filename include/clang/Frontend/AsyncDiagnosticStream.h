@@ -0,0 +1,175 @@
+//===--- AsyncDiagnosticStream.h - Background diagnostic output -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines AsyncDiagnosticStream, a stream that writes the
+//  diagnostics rendered by a TextDiagnosticPrinter to their destination on a
+//  background thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_ASYNCDIAGNOSTICSTREAM_H
+#define LLVM_CLANG_FRONTEND_ASYNCDIAGNOSTICSTREAM_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include <deque>
+#include <string>
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace clang {
+
+/// \brief A stream that hands what is written to it, one flush at a time, to
+/// a thread that writes it to another stream.
+///
+/// Diagnostics are still rendered on the thread that reports them, since
+/// that needs the SourceManager, but the compiler no longer waits on slow
+/// terminals (such as the Windows and Cygwin consoles) while writing them.
+/// TextDiagnosticPrinter flushes its stream after each diagnostic, so each
+/// diagnostic is written as one chunk, in order.
+///
+/// At most \c MaxPendingBytes are queued; past that, writers wait for the
+/// output to catch up.  Colors are forwarded as escape sequences, or, on
+/// consoles that change colors through an API, by waiting for the output
+/// to drain and changing them on the destination.
+class AsyncDiagnosticStream : public raw_ostream {
+  raw_ostream &Target;
+  uint64_t Pos;
+
+#if LLVM_ENABLE_THREADS
+  enum { MaxPendingBytes = 1 << 20 };
+
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  std::deque<std::string> Pending;
+  size_t PendingBytes;
+  bool Writing;
+  bool Done;
+  std::thread Writer;
+
+  void run() {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    for (;;) {
+      Changed.wait(Lock, [this] { return Done || !Pending.empty(); });
+      if (Pending.empty())
+        return;
+      std::string Chunk;
+      Chunk.swap(Pending.front());
+      Pending.pop_front();
+      Writing = true;
+      Lock.unlock();
+      Target << Chunk;
+      Target.flush();
+      Lock.lock();
+      Writing = false;
+      PendingBytes -= Chunk.size();
+      Changed.notify_all();
+    }
+  }
+#endif
+
+  void write_impl(const char *Ptr, size_t Size) override {
+    Pos += Size;
+#if LLVM_ENABLE_THREADS
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Changed.wait(Lock, [this] { return PendingBytes < MaxPendingBytes; });
+    Pending.push_back(std::string(Ptr, Size));
+    PendingBytes += Size;
+    Changed.notify_all();
+#else
+    Target.write(Ptr, Size);
+    Target.flush();
+#endif
+  }
+
+  uint64_t current_pos() const override { return Pos; }
+
+  /// \brief Whether colors are changed through a console API rather than
+  /// escape sequences, and so must be changed on the destination once the
+  /// output has drained.
+  bool colorsNeedDrain() {
+    if (!llvm::sys::Process::ColorNeedsFlush())
+      return false;
+    drain();
+    return true;
+  }
+
+public:
+  explicit AsyncDiagnosticStream(raw_ostream &Target)
+    : Target(Target), Pos(0)
+#if LLVM_ENABLE_THREADS
+      , PendingBytes(0), Writing(false), Done(false)
+#endif
+  {
+#if LLVM_ENABLE_THREADS
+    Writer = std::thread([this] { run(); });
+#endif
+  }
+
+  ~AsyncDiagnosticStream() {
+    flush();
+#if LLVM_ENABLE_THREADS
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Done = true;
+    }
+    Changed.notify_all();
+    Writer.join();
+#endif
+  }
+
+  /// \brief Wait until everything flushed so far has been written.  Call
+  /// this before the process may exit, e.g. on a fatal error.
+  void drain() {
+    flush();
+#if LLVM_ENABLE_THREADS
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Changed.wait(Lock, [this] { return Pending.empty() && !Writing; });
+#endif
+  }
+
+  raw_ostream &changeColor(enum Colors Color, bool Bold = false,
+                           bool BG = false) override {
+    if (colorsNeedDrain())
+      Target.changeColor(Color, Bold, BG);
+    else if (Color == SAVEDCOLOR)
+      *this << llvm::sys::Process::OutputBold(BG);
+    else
+      *this << llvm::sys::Process::OutputColor(char(Color), Bold, BG);
+    return *this;
+  }
+
+  raw_ostream &resetColor() override {
+    if (colorsNeedDrain())
+      Target.resetColor();
+    else
+      *this << llvm::sys::Process::ResetColor();
+    return *this;
+  }
+
+  raw_ostream &reverseColor() override {
+    if (colorsNeedDrain())
+      Target.reverseColor();
+    else
+      *this << llvm::sys::Process::OutputReverse();
+    return *this;
+  }
+
+  bool is_displayed() const override { return Target.is_displayed(); }
+  bool has_colors() const override { return Target.has_colors(); }
+};
+
+} // end namespace clang
+
+#endif
@@ -146,6 +146,11 @@ public:
   /// Name of the profile file to use as input for -fprofile-instr-use
   std::string InstrProfileInput;
 
+  /// If given, the file to append the functions of this translation unit
+  /// to, hottest first according to InstrProfileInput, for the linker's
+  /// -order_file.
+  std::string ProfileOrderFile;
+
   /// Regular expression to select optimizations for which we should enable
   /// optimization remarks. Transformation passes whose name matches this
   /// expression (and support this feature), will emit a diagnostic
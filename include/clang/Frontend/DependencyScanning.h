@@ -0,0 +1,212 @@
+//===--- DependencyScanning.h - Fast dependency scanning --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the DependencyScanner class, which writes the dependency
+/// files of many translation units without compiling them.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_DEPENDENCYSCANNING_H
+#define LLVM_CLANG_FRONTEND_DEPENDENCYSCANNING_H
+
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemOptions.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Lex/DependencyDirectivesMinimizer.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include <memory>
+#include <string>
+
+namespace clang {
+
+/// \brief A file system that serves source files reduced to their
+/// dependency directives by DependencyDirectivesMinimizer.
+///
+/// Each file is read and minimized once, on its first status or open, and the
+/// result is kept for the lifetime of the file system; the file system is
+/// meant to live for a single build, during which the sources do not change.
+/// The status of a minimized file reports the size of the minimized
+/// contents.  Module maps, header maps and binary files (such as PCH files)
+/// are passed through unchanged.
+class DependencyMinimizingFileSystem : public vfs::FileSystem {
+  struct CachedFile {
+    /// Whether the file was minimized; if not, it is read from the
+    /// underlying file system.
+    bool Minimized;
+    vfs::Status Status;
+    std::string Contents;
+
+    CachedFile() : Minimized(false) {}
+  };
+
+  class MinimizedFile : public vfs::File {
+    vfs::Status Status;
+    StringRef Contents;
+
+  public:
+    MinimizedFile(const vfs::Status &Status, StringRef Contents)
+      : Status(Status), Contents(Contents) {}
+
+    llvm::ErrorOr<vfs::Status> status() override { return Status; }
+
+    llvm::error_code getBuffer(const Twine &Name,
+                               std::unique_ptr<llvm::MemoryBuffer> &Result,
+                               int64_t /*FileSize*/ = -1,
+                               bool RequiresNullTerminator = true) override {
+      // The contents are kept in a std::string, so they are null terminated.
+      SmallString<256> NameStorage;
+      Result.reset(llvm::MemoryBuffer::getMemBuffer(
+          Contents, Name.toStringRef(NameStorage), RequiresNullTerminator));
+      return llvm::error_code();
+    }
+
+    llvm::error_code close() override { return llvm::error_code(); }
+    void setName(StringRef Name) override { Status.setName(Name); }
+  };
+
+  IntrusiveRefCntPtr<vfs::FileSystem> Underlying;
+  llvm::StringMap<CachedFile> Cache;
+  unsigned NumMinimized;
+  uint64_t NumBytesRead, NumBytesMinimized;
+
+  static bool shouldMinimize(StringRef Path) {
+    return llvm::StringSwitch<bool>(llvm::sys::path::extension(Path))
+        .Cases(".modulemap", ".map", ".hmap", false)
+        .Cases(".pcm", ".pth", ".gch", false)
+        .Default(true);
+  }
+
+  /// \brief Return the cached minimized file at \p Path, or null if the file
+  /// is not to be minimized.
+  const CachedFile *getMinimized(const Twine &Path) {
+    SmallString<256> Storage;
+    StringRef Name = Path.toStringRef(Storage);
+    llvm::StringMap<CachedFile>::iterator Known = Cache.find(Name);
+    if (Known != Cache.end())
+      return Known->second.Minimized ? &Known->second : 0;
+    if (!shouldMinimize(Name))
+      return 0;
+
+    // Missing files are not cached: they may be generated later in the build.
+    llvm::ErrorOr<vfs::Status> Status = Underlying->status(Name);
+    if (!Status || !Status->isRegularFile())
+      return 0;
+    CachedFile &Entry = Cache[Name];
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (Underlying->getBufferForFile(Name, Buffer, -1,
+                                     /*RequiresNullTerminator=*/false))
+      return 0;
+    SmallString<4096> Minimized;
+    if (DependencyDirectivesMinimizer::minimize(Buffer->getBuffer(),
+                                                Minimized))
+      return 0;
+
+    ++NumMinimized;
+    NumBytesRead += Buffer->getBufferSize();
+    NumBytesMinimized += Minimized.size();
+    Entry.Minimized = true;
+    Entry.Contents = Minimized.str();
+    Entry.Status = vfs::Status(Status->getName(), Status->getName(),
+                               Status->getUniqueID(),
+                               Status->getLastModificationTime(),
+                               Status->getUser(), Status->getGroup(),
+                               Entry.Contents.size(), Status->getType(),
+                               Status->getPermissions());
+    return &Entry;
+  }
+
+public:
+  explicit DependencyMinimizingFileSystem(
+      IntrusiveRefCntPtr<vfs::FileSystem> Underlying)
+    : Underlying(Underlying), NumMinimized(0), NumBytesRead(0),
+      NumBytesMinimized(0) {}
+
+  llvm::ErrorOr<vfs::Status> status(const Twine &Path) override {
+    if (const CachedFile *File = getMinimized(Path))
+      return File->Status;
+    return Underlying->status(Path);
+  }
+
+  llvm::error_code
+  openFileForRead(const Twine &Path,
+                  std::unique_ptr<vfs::File> &Result) override {
+    if (const CachedFile *File = getMinimized(Path)) {
+      Result.reset(new MinimizedFile(File->Status, File->Contents));
+      return llvm::error_code();
+    }
+    return Underlying->openFileForRead(Path, Result);
+  }
+
+  /// \brief The number of files minimized so far.
+  unsigned getNumMinimizedFiles() const { return NumMinimized; }
+
+  /// \brief The total size of the minimized files, before and after
+  /// minimization.
+  uint64_t getNumBytesRead() const { return NumBytesRead; }
+  uint64_t getNumBytesMinimized() const { return NumBytesMinimized; }
+};
+
+/// \brief Writes the dependency files of translation units by preprocessing
+/// minimized sources, which is a fraction of the cost of a -E run.
+///
+/// All the translation units scanned by one DependencyScanner share a
+/// FileManager and a DependencyMinimizingFileSystem, so every header is
+/// stat'ed, read and minimized once for the whole batch, however many
+/// translation units include it.  This requires the translation units to
+/// share a working directory, and it means the scanner is not thread safe;
+/// use one scanner per thread to scan in parallel.
+class DependencyScanner {
+  IntrusiveRefCntPtr<DependencyMinimizingFileSystem> FS;
+  IntrusiveRefCntPtr<FileManager> FileMgr;
+
+public:
+  explicit DependencyScanner(
+      const FileSystemOptions &FileSystemOpts = FileSystemOptions(),
+      IntrusiveRefCntPtr<vfs::FileSystem> Underlying = vfs::getRealFileSystem())
+    : FS(new DependencyMinimizingFileSystem(Underlying)),
+      FileMgr(new FileManager(FileSystemOpts, FS)) {}
+
+  DependencyMinimizingFileSystem &getFileSystem() { return *FS; }
+  FileManager &getFileManager() { return *FileMgr; }
+
+  /// \brief Write the dependency file requested by the DependencyOutputOptions
+  /// of \p Invocation, which is otherwise a regular compile job.
+  ///
+  /// \param Diags The consumer of the diagnostics the preprocessor reports,
+  /// such as missing headers.
+  ///
+  /// \returns true on success.
+  bool scan(CompilerInvocation *Invocation, DiagnosticConsumer &Diags) {
+    Invocation->getFrontendOpts().ProgramAction = frontend::ScanDependencies;
+    // The scanner outlives the compile, so it must not leak its state.
+    Invocation->getFrontendOpts().DisableFree = false;
+
+    CompilerInstance Clang;
+    Clang.setInvocation(Invocation);
+    Clang.createDiagnostics(&Diags, /*ShouldOwnClient=*/false);
+    Clang.setVirtualFileSystem(FS);
+    Clang.setFileManager(FileMgr.getPtr());
+    ScanDependenciesAction Action;
+    return Clang.ExecuteAction(Action);
+  }
+};
+
+} // end namespace clang
+
+#endif
@@ -231,6 +231,18 @@ protected:
   void ExecuteAction() override;
 };
 
+/// \brief Preprocess the input only to write its dependency file.
+///
+/// The action is meant to run on sources reduced to their directives by a
+/// DependencyMinimizingFileSystem (see DependencyScanning.h), which leaves
+/// the preprocessor little to do besides following includes and evaluating
+/// the conditionals of the regions it enters.  Nothing is written except
+/// the outputs requested by the DependencyOutputOptions.
+class ScanDependenciesAction : public PreprocessorFrontendAction {
+protected:
+  void ExecuteAction() override;
+};
+
 class PrintPreprocessedAction : public PreprocessorFrontendAction {
 protected:
   void ExecuteAction() override;
@@ -53,6 +53,7 @@ namespace frontend {
     RewriteObjC,            ///< ObjC->C Rewriter.
     RewriteTest,            ///< Rewriter playground
     RunAnalysis,            ///< Run one or more source code analyses.
+    ScanDependencies,       ///< Only write the dependency file (-MD).
     MigrateSource,          ///< Run migrator.
     RunPreprocessorOnly     ///< Just lex, no output.
   };
@@ -201,6 +202,14 @@ public:
   /// The output file, if any.
   std::string OutputFile;
 
+  /// If given, the file to write a Chrome trace of the time and memory
+  /// spent in each frontend phase and LLVM pass to (-ftime-trace).
+  std::string TimeTraceFile;
+
+  /// If given, the file to write the statistics, timers and frontend
+  /// counters of the compilation to as JSON (-stats-file=).
+  std::string StatsFile;
+
   /// If given, the new suffix for fix-it rewritten files.
   std::string FixItSuffix;
 
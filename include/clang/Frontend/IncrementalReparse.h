@@ -0,0 +1,264 @@
+//===--- IncrementalReparse.h - Reuse of unedited bodies --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines SourceEditMap, which maps main file offsets across the
+/// edits made since the last parse, and FunctionBodyReuse, which lets
+/// ASTUnit::ReparseWithEdits skip the function and method bodies those edits
+/// did not touch.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_INCREMENTALREPARSE_H
+#define LLVM_CLANG_FRONTEND_INCREMENTALREPARSE_H
+
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <vector>
+
+namespace clang {
+
+/// \brief An edit of the main file since the last parse: \c RemovedLength
+/// bytes at \c Offset of the old contents were replaced by \c InsertedLength
+/// bytes.
+struct SourceEdit {
+  unsigned Offset;
+  unsigned RemovedLength;
+  unsigned InsertedLength;
+
+  SourceEdit(unsigned Offset, unsigned RemovedLength, unsigned InsertedLength)
+    : Offset(Offset), RemovedLength(RemovedLength),
+      InsertedLength(InsertedLength) {}
+
+  friend bool operator<(const SourceEdit &LHS, const SourceEdit &RHS) {
+    return LHS.Offset < RHS.Offset;
+  }
+};
+
+/// \brief Maps offsets in the main file between the contents of the last
+/// parse and the edited contents.
+///
+/// The edits are given in offsets of the old contents and must not overlap;
+/// an editor that records several edits to the same text should merge them
+/// first.
+class SourceEditMap {
+  SmallVector<SourceEdit, 4> Edits;
+  bool Valid;
+
+public:
+  explicit SourceEditMap(ArrayRef<SourceEdit> NewEdits)
+    : Edits(NewEdits.begin(), NewEdits.end()), Valid(true) {
+    std::sort(Edits.begin(), Edits.end());
+    for (unsigned I = 1, E = Edits.size(); I < E; ++I)
+      if (Edits[I - 1].Offset + Edits[I - 1].RemovedLength >
+          Edits[I].Offset)
+        Valid = false;
+  }
+
+  /// \brief Whether the edits are well formed; if not, nothing may be
+  /// reused.
+  bool isValid() const { return Valid; }
+
+  /// \brief Whether no edit touches the old text [\p OldBegin, \p OldEnd].
+  /// An insertion at either end counts as touching it.
+  bool isUnedited(unsigned OldBegin, unsigned OldEnd) const {
+    for (unsigned I = 0, E = Edits.size(); I != E; ++I) {
+      if (Edits[I].Offset > OldEnd)
+        break;
+      if (Edits[I].Offset + Edits[I].RemovedLength >= OldBegin)
+        return false;
+    }
+    return true;
+  }
+
+  /// \brief The offset in the new contents of the old offset \p OldOffset,
+  /// which no edit removed.
+  unsigned getNewOffset(unsigned OldOffset) const {
+    int64_t Delta = 0;
+    for (unsigned I = 0, E = Edits.size(); I != E; ++I) {
+      if (Edits[I].Offset >= OldOffset)
+        break;
+      assert(Edits[I].Offset + Edits[I].RemovedLength <= OldOffset &&
+             "offset was removed by an edit");
+      Delta += int64_t(Edits[I].InsertedLength) - Edits[I].RemovedLength;
+    }
+    return unsigned(OldOffset + Delta);
+  }
+
+  /// \brief Find the old offset of the new offset \p NewOffset.
+  ///
+  /// \returns false if \p NewOffset is in inserted text.
+  bool getOldOffset(unsigned NewOffset, unsigned &OldOffset) const {
+    int64_t Delta = 0;
+    for (unsigned I = 0, E = Edits.size(); I != E; ++I) {
+      int64_t NewBegin = Edits[I].Offset + Delta;
+      if (NewOffset < NewBegin)
+        break;
+      if (NewOffset < NewBegin + Edits[I].InsertedLength)
+        return false;
+      Delta += int64_t(Edits[I].InsertedLength) - Edits[I].RemovedLength;
+    }
+    OldOffset = unsigned(NewOffset - Delta);
+    return true;
+  }
+};
+
+/// \brief The extent in the main file of a function or Objective-C method
+/// definition, from the start of its declaration to the end of its body,
+/// and the offset of its name.
+struct FunctionBodyExtent {
+  unsigned DeclOffset;
+  unsigned BeginOffset;
+  unsigned EndOffset;
+
+  FunctionBodyExtent(unsigned DeclOffset, unsigned BeginOffset,
+                     unsigned EndOffset)
+    : DeclOffset(DeclOffset), BeginOffset(BeginOffset),
+      EndOffset(EndOffset) {}
+
+  friend bool operator<(const FunctionBodyExtent &LHS,
+                        const FunctionBodyExtent &RHS) {
+    return LHS.DeclOffset < RHS.DeclOffset;
+  }
+};
+
+/// \brief Append to \p Out the extents of the definitions in \p Decls, and
+/// in the namespaces, linkage specifications and \@implementations among
+/// them, whose bodies were parsed and lie in \p FID.
+///
+/// Templates are left out: their bodies are needed to instantiate them.
+inline void collectFunctionBodies(ArrayRef<Decl *> Decls,
+                                  const SourceManager &SM, FileID FID,
+                                  std::vector<FunctionBodyExtent> &Out) {
+  SmallVector<Decl *, 64> Worklist(Decls.begin(), Decls.end());
+  while (!Worklist.empty()) {
+    Decl *D = Worklist.pop_back_val();
+    if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D) ||
+        isa<ObjCImplDecl>(D)) {
+      DeclContext *DC = cast<DeclContext>(D);
+      Worklist.append(DC->decls_begin(), DC->decls_end());
+      continue;
+    }
+
+    if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+      if (!FD->doesThisDeclarationHaveABody() || FD->hasSkippedBody() ||
+          FD->isDependentContext() || FD->getTemplatedKind() !=
+                                          FunctionDecl::TK_NonTemplate)
+        continue;
+    } else if (ObjCMethodDecl *MD = dyn_cast<ObjCMethodDecl>(D)) {
+      if (!MD->hasBody() || MD->hasSkippedBody())
+        continue;
+    } else {
+      continue;
+    }
+
+    std::pair<FileID, unsigned> Name =
+        SM.getDecomposedExpansionLoc(D->getLocation());
+    std::pair<FileID, unsigned> Begin =
+        SM.getDecomposedExpansionLoc(D->getLocStart());
+    std::pair<FileID, unsigned> End =
+        SM.getDecomposedExpansionLoc(D->getLocEnd());
+    if (Name.first != FID || Begin.first != FID || End.first != FID)
+      continue;
+    Out.push_back(FunctionBodyExtent(Name.second, Begin.second, End.second));
+  }
+}
+
+/// \brief Decides, during a reparse, which function bodies to skip because
+/// they were parsed last time and no edit touched them.
+///
+/// ASTUnit's consumer forwards ASTConsumer::shouldSkipFunctionBody here,
+/// with the parser's SkipFunctionBodies set.  Every body that is not known
+/// from the last parse, or that an edit touches, is parsed as usual;
+/// Sema still parses the bodies it needs, such as those of constexpr
+/// functions.
+///
+/// The skipped bodies keep the diagnostics of the last parse: ASTUnit moves
+/// the stored diagnostics for which isInSkippedBody holds to their new
+/// offsets.  Those diagnostics can be stale if an edit elsewhere changed
+/// what such a body refers to; the next full reparse brings them up to
+/// date.
+class FunctionBodyReuse {
+  SourceEditMap EditMap;
+  /// The bodies of the last parse, in old offsets, sorted by DeclOffset.
+  std::vector<FunctionBodyExtent> Bodies;
+  /// Whether each of Bodies was skipped.
+  std::vector<bool> Skipped;
+
+public:
+  FunctionBodyReuse(ArrayRef<SourceEdit> Edits,
+                    std::vector<FunctionBodyExtent> OldBodies)
+    : EditMap(Edits), Bodies(std::move(OldBodies)),
+      Skipped(Bodies.size(), false) {
+    std::sort(Bodies.begin(), Bodies.end());
+  }
+
+  const SourceEditMap &getEditMap() const { return EditMap; }
+
+  /// \brief Whether the body of \p D, whose declaration the parser has just
+  /// seen in the main file \p FID of \p SM, can be skipped.
+  bool shouldSkipFunctionBody(const Decl *D, const SourceManager &SM,
+                              FileID FID) {
+    if (!EditMap.isValid())
+      return false;
+    if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D))
+      if (FD->isDependentContext() ||
+          FD->getTemplatedKind() != FunctionDecl::TK_NonTemplate)
+        return false;
+
+    std::pair<FileID, unsigned> Name =
+        SM.getDecomposedExpansionLoc(D->getLocation());
+    unsigned OldOffset;
+    if (Name.first != FID || !EditMap.getOldOffset(Name.second, OldOffset))
+      return false;
+
+    std::vector<FunctionBodyExtent>::iterator I = std::lower_bound(
+        Bodies.begin(), Bodies.end(), FunctionBodyExtent(OldOffset, 0, 0));
+    if (I == Bodies.end() || I->DeclOffset != OldOffset ||
+        !EditMap.isUnedited(I->BeginOffset, I->EndOffset))
+      return false;
+    Skipped[I - Bodies.begin()] = true;
+    return true;
+  }
+
+  /// \brief Whether the old offset \p OldOffset is in a skipped body.
+  bool isInSkippedBody(unsigned OldOffset) const {
+    // The definitions do not nest, so they are sorted by their start too.
+    std::vector<FunctionBodyExtent>::const_iterator I = std::upper_bound(
+        Bodies.begin(), Bodies.end(), OldOffset,
+        [](unsigned Offset, const FunctionBodyExtent &Body) {
+      return Offset < Body.BeginOffset;
+    });
+    if (I == Bodies.begin())
+      return false;
+    --I;
+    return Skipped[I - Bodies.begin()] && OldOffset <= I->EndOffset;
+  }
+
+  /// \brief Append to \p Out the skipped bodies, in new offsets, so that
+  /// the next reparse can skip them again.
+  void getSkippedBodies(std::vector<FunctionBodyExtent> &Out) const {
+    for (unsigned I = 0, E = Bodies.size(); I != E; ++I)
+      if (Skipped[I])
+        Out.push_back(
+            FunctionBodyExtent(EditMap.getNewOffset(Bodies[I].DeclOffset),
+                               EditMap.getNewOffset(Bodies[I].BeginOffset),
+                               EditMap.getNewOffset(Bodies[I].EndOffset)));
+  }
+};
+
+} // end namespace clang
+
+#endif
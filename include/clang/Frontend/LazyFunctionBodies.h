@@ -0,0 +1,103 @@
+//===--- LazyFunctionBodies.h - Bodies parsed on demand ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines LazyFunctionBodyIndex, which finds the function bodies of
+/// an ASTUnit that were left unparsed, with their tokens cached, when a
+/// client looks at a location inside one of them.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_LAZYFUNCTIONBODIES_H
+#define LLVM_CLANG_FRONTEND_LAZYFUNCTIONBODIES_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace clang {
+
+class Decl;
+
+/// \brief The unparsed function and Objective-C method bodies of the main
+/// file, by their offsets.
+///
+/// With lazy function bodies, the parser caches the tokens of each body of
+/// the main file in Sema instead of parsing it, and records its extent
+/// here.  When clang_getCursor, clang_annotateTokens or code completion
+/// needs a range of the file, ASTUnit takes the bodies overlapping it out of
+/// the index and has Sema parse them; every other body costs only its
+/// tokens, so a large file opens about as fast as with SkipFunctionBodies.
+class LazyFunctionBodyIndex {
+  struct Entry {
+    /// The offsets of the first cached token and of the closing brace.
+    unsigned Begin, End;
+    Decl *D;
+
+    Entry(unsigned Begin, unsigned End, Decl *D)
+      : Begin(Begin), End(End), D(D) {}
+
+    friend bool operator<(const Entry &LHS, const Entry &RHS) {
+      return LHS.Begin < RHS.Begin;
+    }
+  };
+
+  /// The bodies left to parse, sorted by Begin once Sorted is set.  Bodies
+  /// are mostly added in file order, so sorting is cheap.
+  std::vector<Entry> Entries;
+  bool Sorted;
+
+  void sort() {
+    if (!Sorted)
+      std::stable_sort(Entries.begin(), Entries.end());
+    Sorted = true;
+  }
+
+public:
+  LazyFunctionBodyIndex() : Sorted(true) {}
+
+  /// \brief Record that the body of \p D, from offset \p Begin to offset
+  /// \p End, was left unparsed.
+  void add(Decl *D, unsigned Begin, unsigned End) {
+    assert(Begin <= End && "invalid body extent");
+    if (!Entries.empty() && Begin < Entries.back().Begin)
+      Sorted = false;
+    Entries.push_back(Entry(Begin, End, D));
+  }
+
+  bool empty() const { return Entries.empty(); }
+  unsigned size() const { return Entries.size(); }
+  void clear() {
+    Entries.clear();
+    Sorted = true;
+  }
+
+  /// \brief Remove the bodies that overlap [\p Begin, \p End] and append
+  /// their declarations to \p Out, in file order.
+  void takeOverlapping(unsigned Begin, unsigned End,
+                       SmallVectorImpl<Decl *> &Out) {
+    sort();
+    // Bodies do not nest, so the ones that overlap are contiguous, starting
+    // at the last one that begins at or before Begin.
+    std::vector<Entry>::iterator First = std::upper_bound(
+        Entries.begin(), Entries.end(), Entry(Begin, Begin, nullptr));
+    if (First != Entries.begin() && std::prev(First)->End >= Begin)
+      --First;
+    std::vector<Entry>::iterator Last = First;
+    while (Last != Entries.end() && Last->Begin <= End)
+      Out.push_back((Last++)->D);
+    Entries.erase(First, Last);
+  }
+};
+
+} // end namespace clang
+
+#endif
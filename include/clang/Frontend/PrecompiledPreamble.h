@@ -0,0 +1,396 @@
+//===--- PrecompiledPreamble.h - Shared preamble PCHs -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the PrecompiledPreamble class, which holds a preamble PCH
+/// built by ASTUnit, together with the PreambleCache that shares preambles
+/// between translation units and the BackgroundPreambleBuilder that
+/// rebuilds them off the client's thread.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_PRECOMPILEDPREAMBLE_H
+#define LLVM_CLANG_FRONTEND_PRECOMPILEDPREAMBLE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendOptions.h"
+#include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "clang/Serialization/ASTBitCodes.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/Path.h"
+#include <functional>
+#include <string>
+#include <vector>
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace clang {
+
+/// \brief A precompiled preamble: the PCH file built for the preamble of a
+/// main file, and what ASTUnit needs to know to reuse it.
+///
+/// A preamble is immutable once it has been built, so it can be shared
+/// between threads and translation units; it is reference counted, and the
+/// PCH file is removed when the last reference goes away.
+class PrecompiledPreamble
+    : public llvm::ThreadSafeRefCountedBase<PrecompiledPreamble> {
+public:
+  /// \brief The PCH file.
+  std::string PCHFile;
+
+  /// \brief The preamble source the PCH was built from.
+  std::vector<char> Contents;
+
+  /// \brief Whether the preamble ends at the start of a new line.
+  bool EndsAtStartOfLine;
+
+  /// \brief The files the preamble used, to tell whether it is out of date.
+  llvm::StringMap<ASTUnit::PreambleFileHash> FilesInPreamble;
+
+  /// \brief The serialization IDs of the top-level declarations of the
+  /// preamble.
+  std::vector<serialization::DeclID> TopLevelDecls;
+
+  /// \brief The diagnostics produced while building the preamble.
+  SmallVector<ASTUnit::StandaloneDiagnostic, 4> Diagnostics;
+
+  /// \brief The number of warnings produced while building the preamble.
+  unsigned NumWarnings;
+
+  /// \brief The hash of the top-level declaration and macro names, to tell
+  /// when the global code-completion cache must be refreshed.
+  unsigned TopLevelHashValue;
+
+  PrecompiledPreamble()
+    : EndsAtStartOfLine(false), NumWarnings(0), TopLevelHashValue(0) {}
+
+  ~PrecompiledPreamble() {
+    if (!PCHFile.empty())
+      llvm::sys::fs::remove(PCHFile);
+  }
+
+  /// \brief Check whether the files the preamble included are unchanged,
+  /// as seen through \p FS or, for the files a translation unit has
+  /// overridden with unsaved buffers, in \p OverriddenFiles.
+  bool isUpToDate(vfs::FileSystem &FS,
+                  const llvm::StringMap<ASTUnit::PreambleFileHash>
+                      &OverriddenFiles) const {
+    for (llvm::StringMap<ASTUnit::PreambleFileHash>::const_iterator
+             I = FilesInPreamble.begin(), E = FilesInPreamble.end();
+         I != E; ++I) {
+      llvm::StringMap<ASTUnit::PreambleFileHash>::const_iterator Overridden =
+          OverriddenFiles.find(I->getKey());
+      if (Overridden != OverriddenFiles.end()) {
+        if (Overridden->second != I->second)
+          return false;
+        continue;
+      }
+      llvm::ErrorOr<vfs::Status> Status = FS.status(I->getKey());
+      if (!Status ||
+          ASTUnit::PreambleFileHash::createForFile(
+              Status->getSize(),
+              Status->getLastModificationTime().toEpochTime()) != I->second)
+        return false;
+    }
+    return true;
+  }
+
+  /// \brief Compute the key under which a preamble is shared: a hash of the
+  /// preamble source and of everything else that changes what it means.
+  ///
+  /// Besides the options in the module hash, that is the header search
+  /// paths and sysroot, the directory of the main file, which quoted
+  /// includes are found relative to, the files implicitly included with
+  /// -include, -imacros and -include-pch, and the files remapped to other
+  /// files or to unsaved buffers, with their contents.  The main file's own
+  /// buffer is left out, since its preamble part is \p PreambleContents.
+  static std::string computeKey(const CompilerInvocation &Invocation,
+                                StringRef PreambleContents) {
+    llvm::MD5 Hash;
+    StringRef Separator("\0", 1);
+    Hash.update(Invocation.getModuleHash());
+    Hash.update(Separator);
+
+    const HeaderSearchOptions &HSOpts = Invocation.getHeaderSearchOpts();
+    Hash.update(HSOpts.Sysroot);
+    Hash.update(Separator);
+    for (unsigned I = 0, N = HSOpts.UserEntries.size(); I != N; ++I) {
+      const HeaderSearchOptions::Entry &Entry = HSOpts.UserEntries[I];
+      Hash.update(Entry.Path);
+      char Flags[3] = { char(Entry.Group), char(Entry.IsFramework),
+                        char(Entry.IgnoreSysRoot) };
+      Hash.update(StringRef(Flags, sizeof(Flags)));
+      Hash.update(Separator);
+    }
+    Hash.update(Separator);
+
+    StringRef MainFile;
+    const FrontendOptions &FEOpts = Invocation.getFrontendOpts();
+    if (!FEOpts.Inputs.empty() && FEOpts.Inputs[0].isFile())
+      MainFile = FEOpts.Inputs[0].getFile();
+    Hash.update(llvm::sys::path::parent_path(MainFile));
+    Hash.update(Separator);
+
+    const PreprocessorOptions &PPOpts = Invocation.getPreprocessorOpts();
+    for (unsigned I = 0, N = PPOpts.Includes.size(); I != N; ++I) {
+      Hash.update(PPOpts.Includes[I]);
+      Hash.update(Separator);
+    }
+    Hash.update(Separator);
+    for (unsigned I = 0, N = PPOpts.MacroIncludes.size(); I != N; ++I) {
+      Hash.update(PPOpts.MacroIncludes[I]);
+      Hash.update(Separator);
+    }
+    Hash.update(Separator);
+    Hash.update(PPOpts.ImplicitPCHInclude);
+    Hash.update(Separator);
+
+    for (unsigned I = 0, N = PPOpts.RemappedFiles.size(); I != N; ++I) {
+      Hash.update(PPOpts.RemappedFiles[I].first);
+      Hash.update(Separator);
+      Hash.update(PPOpts.RemappedFiles[I].second);
+      Hash.update(Separator);
+    }
+    for (unsigned I = 0, N = PPOpts.RemappedFileBuffers.size(); I != N; ++I) {
+      StringRef File = PPOpts.RemappedFileBuffers[I].first;
+      if (File == MainFile)
+        continue;
+      Hash.update(File);
+      Hash.update(Separator);
+      Hash.update(PPOpts.RemappedFileBuffers[I].second->getBuffer());
+      Hash.update(Separator);
+    }
+    Hash.update(Separator);
+
+    Hash.update(PreambleContents);
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    SmallString<32> Key;
+    llvm::MD5::stringifyResult(Result, Key);
+    return Key.str();
+  }
+};
+
+/// \brief A thread-safe store of precompiled preambles, which lets
+/// translation units whose main files start with the same preamble share
+/// one PCH.
+///
+/// Preambles are stored under the key computed by
+/// PrecompiledPreamble::computeKey.  Translation units with the same key
+/// may still see different versions of the files the preamble includes (as
+/// when one of them has unsaved changes to a header), so a key can hold
+/// several preambles, and a translation unit only gets one whose included
+/// files match its own view of them.
+///
+/// The store counts the translation units using each preamble, and forgets
+/// a preamble when the last of them releases it; the PCH file is removed
+/// once nothing holds a reference to the preamble anymore.
+class PreambleCache : public llvm::ThreadSafeRefCountedBase<PreambleCache> {
+  struct StoredPreamble {
+    IntrusiveRefCntPtr<PrecompiledPreamble> Preamble;
+    unsigned NumUsers;
+  };
+
+  mutable llvm::sys::Mutex Lock;
+  llvm::StringMap<SmallVector<StoredPreamble, 1> > Preambles;
+  unsigned NumPreambles;
+
+public:
+  PreambleCache() : NumPreambles(0) {}
+
+  /// \brief Find a preamble stored under \p Key for which \p IsUpToDate
+  /// returns true, and register the calling translation unit as a user.
+  ///
+  /// \returns the preamble, or null if there is none.
+  IntrusiveRefCntPtr<PrecompiledPreamble>
+  acquire(StringRef Key,
+          const std::function<bool(const PrecompiledPreamble &)> &IsUpToDate) {
+    llvm::MutexGuard Guard(Lock);
+    llvm::StringMap<SmallVector<StoredPreamble, 1> >::iterator I =
+        Preambles.find(Key);
+    if (I == Preambles.end())
+      return 0;
+    for (unsigned i = 0, e = I->second.size(); i != e; ++i) {
+      StoredPreamble &Stored = I->second[i];
+      if (IsUpToDate(*Stored.Preamble)) {
+        ++Stored.NumUsers;
+        return Stored.Preamble;
+      }
+    }
+    return 0;
+  }
+
+  /// \brief Store \p Preamble, just built by the calling translation unit,
+  /// under \p Key, registering the translation unit as its first user.
+  void publish(StringRef Key,
+               IntrusiveRefCntPtr<PrecompiledPreamble> Preamble) {
+    llvm::MutexGuard Guard(Lock);
+    StoredPreamble Stored = { Preamble, 1 };
+    Preambles[Key].push_back(Stored);
+    ++NumPreambles;
+  }
+
+  /// \brief Unregister a user of \p Preamble, acquired or published under
+  /// \p Key, forgetting the preamble if that was the last one.
+  void release(StringRef Key, const PrecompiledPreamble *Preamble) {
+    llvm::MutexGuard Guard(Lock);
+    llvm::StringMap<SmallVector<StoredPreamble, 1> >::iterator I =
+        Preambles.find(Key);
+    if (I == Preambles.end())
+      return;
+    SmallVectorImpl<StoredPreamble> &Stored = I->second;
+    for (unsigned i = 0, e = Stored.size(); i != e; ++i) {
+      if (Stored[i].Preamble.getPtr() != Preamble)
+        continue;
+      if (--Stored[i].NumUsers == 0) {
+        Stored.erase(Stored.begin() + i);
+        --NumPreambles;
+        if (Stored.empty())
+          Preambles.erase(I);
+      }
+      return;
+    }
+  }
+
+  /// \brief The number of preambles in use.
+  unsigned size() const {
+    llvm::MutexGuard Guard(Lock);
+    return NumPreambles;
+  }
+};
+
+/// \brief Builds preambles on a background thread.
+///
+/// ASTUnit starts a build when it finds its preamble out of date, and keeps
+/// using the stale preamble (for code completion) or no preamble (for
+/// reparses whose preamble changed) until the build finishes.  The next
+/// reparse or code completion then swaps the new preamble in with
+/// takeResult(), so the swap happens on the client's thread, under the
+/// ASTUnit's usual concurrency check.
+///
+/// Starting a build while one is running supersedes it: the running build
+/// completes, but its result is discarded in favor of the later one.
+/// Without thread support, builds run synchronously in start().
+class BackgroundPreambleBuilder {
+public:
+  typedef std::function<IntrusiveRefCntPtr<PrecompiledPreamble>()> BuildFn;
+
+private:
+  IntrusiveRefCntPtr<PrecompiledPreamble> Result;
+#if LLVM_ENABLE_THREADS
+  std::mutex Lock;
+  std::condition_variable Finished;
+  std::thread Worker;
+  BuildFn Pending;
+  bool Building;
+
+  void run() {
+    for (;;) {
+      BuildFn Build;
+      {
+        std::lock_guard<std::mutex> Guard(Lock);
+        if (!Pending) {
+          Building = false;
+          Finished.notify_all();
+          return;
+        }
+        Build.swap(Pending);
+      }
+      IntrusiveRefCntPtr<PrecompiledPreamble> Built = Build();
+      std::lock_guard<std::mutex> Guard(Lock);
+      if (!Pending)
+        Result = Built;
+    }
+  }
+#endif
+
+  BackgroundPreambleBuilder(const BackgroundPreambleBuilder &)
+      LLVM_DELETED_FUNCTION;
+  void operator=(const BackgroundPreambleBuilder &) LLVM_DELETED_FUNCTION;
+
+public:
+#if LLVM_ENABLE_THREADS
+  BackgroundPreambleBuilder() : Building(false) {}
+#else
+  BackgroundPreambleBuilder() {}
+#endif
+
+  ~BackgroundPreambleBuilder() { wait(); }
+
+  /// \brief Start building a preamble with \p Build, which must not touch the
+  /// state of the ASTUnit (it gets its own FileManager and diagnostics).
+  /// \p Build returns null if the preamble could not be built.
+  void start(BuildFn Build) {
+#if LLVM_ENABLE_THREADS
+    std::lock_guard<std::mutex> Guard(Lock);
+    Pending = Build;
+    if (Building)
+      return;
+    Building = true;
+    // A previous worker has finished: it cleared Building before exiting.
+    if (Worker.joinable())
+      Worker.join();
+    Worker = std::thread(&BackgroundPreambleBuilder::run, this);
+#else
+    Result = Build();
+#endif
+  }
+
+  /// \brief Whether a build is running.
+  bool isBuilding() {
+#if LLVM_ENABLE_THREADS
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Building;
+#else
+    return false;
+#endif
+  }
+
+  /// \brief Take the most recently built preamble, if a build has finished
+  /// since the last call; otherwise return null.
+  IntrusiveRefCntPtr<PrecompiledPreamble> takeResult() {
+#if LLVM_ENABLE_THREADS
+    std::lock_guard<std::mutex> Guard(Lock);
+#endif
+    IntrusiveRefCntPtr<PrecompiledPreamble> Taken = Result;
+    Result.reset();
+    return Taken;
+  }
+
+  /// \brief Wait for the running build, if any, to finish.
+  void wait() {
+#if LLVM_ENABLE_THREADS
+    std::unique_lock<std::mutex> Guard(Lock);
+    while (Building)
+      Finished.wait(Guard);
+    if (Worker.joinable())
+      Worker.join();
+#endif
+  }
+};
+
+} // end namespace clang
+
+#endif
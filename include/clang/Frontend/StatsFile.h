@@ -0,0 +1,112 @@
+//===--- StatsFile.h - Machine-readable compile statistics ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines writeStatsFile, which writes the statistics of one
+//  compilation as JSON for -stats-file=.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_STATSFILE_H
+#define LLVM_CLANG_FRONTEND_STATSFILE_H
+
+#include "clang/AST/ASTContext.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/StatsJSONWriter.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+namespace clang {
+
+/// \brief Write the statistics of the compilation in \p CI to \p OS as one
+/// JSON object.
+///
+/// The object holds the name of the main file and the peak resident set
+/// size, then "stats" with every LLVM Statistic that was touched, "timers"
+/// with every timer group, such as the -ftime-report ones, and one object
+/// each for the SourceManager, Preprocessor and ASTContext counters that
+/// -print-stats prints.  Objects for parts of the frontend that \p CI does
+/// not have are left out.
+///
+/// Like the text output, the Statistic counters are only collected when
+/// statistics are enabled; the caller should call llvm::EnableStatistics()
+/// before the compilation when -stats-file= is given.
+inline void writeStatsJSON(const CompilerInstance &CI, raw_ostream &OS) {
+  llvm::StatsJSONWriter W(OS);
+  W.beginObject();
+  if (CI.hasSourceManager()) {
+    const SourceManager &SM = CI.getSourceManager();
+    if (const FileEntry *Main = SM.getFileEntryForID(SM.getMainFileID()))
+      W.value("file", StringRef(Main->getName()));
+  }
+  W.value("peak_rss", llvm::sys::Process::GetPeakMemoryUsage());
+
+  llvm::PrintStatisticsJSON(W.rawValue("stats"));
+  llvm::TimerGroup::printAllJSONValues(W.rawValue("timers"));
+
+  if (CI.hasSourceManager()) {
+    W.beginObject("source_manager");
+    CI.getSourceManager().PrintStatsJSON(W);
+    W.endObject();
+  }
+  if (CI.hasPreprocessor()) {
+    W.beginObject("preprocessor");
+    CI.getPreprocessor().PrintStatsJSON(W);
+    W.endObject();
+  }
+  if (CI.hasASTContext()) {
+    const ASTContext &Ctx = CI.getASTContext();
+    W.beginObject("ast_context");
+    W.value("types", Ctx.getTypes().size());
+    W.value("ast_memory", Ctx.getASTAllocatedMemory());
+    W.value("side_table_memory", Ctx.getSideTableAllocatedMemory());
+    W.value("implicit_default_constructors_declared",
+            ASTContext::NumImplicitDefaultConstructorsDeclared);
+    W.value("implicit_copy_constructors_declared",
+            ASTContext::NumImplicitCopyConstructorsDeclared);
+    W.value("implicit_move_constructors_declared",
+            ASTContext::NumImplicitMoveConstructorsDeclared);
+    W.value("implicit_copy_assignment_operators_declared",
+            ASTContext::NumImplicitCopyAssignmentOperatorsDeclared);
+    W.value("implicit_move_assignment_operators_declared",
+            ASTContext::NumImplicitMoveAssignmentOperatorsDeclared);
+    W.value("implicit_destructors_declared",
+            ASTContext::NumImplicitDestructorsDeclared);
+    W.endObject();
+  }
+  W.endObject();
+}
+
+/// \brief Write the statistics of \p CI to the file \p Path, replacing it.
+///
+/// \returns true on success; otherwise \p ErrorInfo describes the failure.
+inline bool writeStatsFile(const CompilerInstance &CI, StringRef Path,
+                           std::string &ErrorInfo) {
+  llvm::raw_fd_ostream OS(Path.str().c_str(), ErrorInfo,
+                          llvm::sys::fs::F_Text);
+  if (!ErrorInfo.empty())
+    return false;
+  writeStatsJSON(CI, OS);
+  OS.close();
+  if (OS.has_error()) {
+    OS.clear_error();
+    ErrorInfo = "error writing statistics";
+    return false;
+  }
+  return true;
+}
+
+} // end namespace clang
+
+#endif
@@ -0,0 +1,163 @@
+//===--- BatchIndexing.h - Parallel indexing of many TUs --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the state shared by the translation units of a batch
+/// indexing run, such as clang_indexCompilationDatabase.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_INDEX_BATCHINDEXING_H
+#define LLVM_CLANG_INDEX_BATCHINDEXING_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <set>
+
+namespace clang {
+namespace index {
+
+/// \brief The files whose declarations have been indexed during a session,
+/// shared by the threads indexing its translation units.
+///
+/// The first translation unit to enter a header claims it and indexes its
+/// declarations; the others still report the inclusion, but skip the
+/// declarations.  A header is identified by its file's unique ID, so it is
+/// indexed once whatever path it is included through.  This assumes the
+/// header declares the same entities wherever it is included, which holds
+/// for headers with include guards in a project built with one set of
+/// macros.
+class IndexedFileSet {
+  mutable llvm::sys::Mutex Lock;
+  std::set<llvm::sys::fs::UniqueID> Files;
+
+public:
+  /// \brief Claim the file \p ID for indexing.
+  ///
+  /// \returns true if no translation unit claimed it before.
+  bool claim(const llvm::sys::fs::UniqueID &ID) {
+    llvm::MutexGuard Guard(Lock);
+    return Files.insert(ID).second;
+  }
+
+  bool isIndexed(const llvm::sys::fs::UniqueID &ID) const {
+    llvm::MutexGuard Guard(Lock);
+    return Files.count(ID) != 0;
+  }
+
+  unsigned size() const {
+    llvm::MutexGuard Guard(Lock);
+    return Files.size();
+  }
+};
+
+/// \brief A file system that caches the status of the files and directories
+/// of an underlying file system, and can be shared by threads.
+///
+/// FileManager is not thread safe, so each translation unit of a batch keeps
+/// its own; giving them all one StatCachingFileSystem means each header is
+/// stat'ed once per batch rather than once per translation unit (and per
+/// header search directory).  Missing files are cached too, so the sources
+/// must not change while the file system is in use.
+class StatCachingFileSystem : public vfs::FileSystem {
+  IntrusiveRefCntPtr<vfs::FileSystem> Underlying;
+  mutable llvm::sys::Mutex Lock;
+  /// The cached status of each path; missing files have an empty name.
+  llvm::StringMap<vfs::Status> Cache;
+  unsigned NumHits, NumMisses;
+
+public:
+  explicit StatCachingFileSystem(
+      IntrusiveRefCntPtr<vfs::FileSystem> Underlying = vfs::getRealFileSystem())
+    : Underlying(Underlying), NumHits(0), NumMisses(0) {}
+
+  llvm::ErrorOr<vfs::Status> status(const Twine &Path) override {
+    SmallString<256> Storage;
+    StringRef Name = Path.toStringRef(Storage);
+    {
+      llvm::MutexGuard Guard(Lock);
+      llvm::StringMap<vfs::Status>::iterator Known = Cache.find(Name);
+      if (Known != Cache.end()) {
+        ++NumHits;
+        if (Known->second.getName().empty())
+          return llvm::make_error_code(
+              llvm::errc::no_such_file_or_directory);
+        return Known->second;
+      }
+      ++NumMisses;
+    }
+    // Stat without holding the lock; racing threads store the same status.
+    llvm::ErrorOr<vfs::Status> Status = Underlying->status(Name);
+    llvm::MutexGuard Guard(Lock);
+    Cache.GetOrCreateValue(Name, Status ? *Status : vfs::Status());
+    return Status;
+  }
+
+  llvm::error_code
+  openFileForRead(const Twine &Path,
+                  std::unique_ptr<vfs::File> &Result) override {
+    return Underlying->openFileForRead(Path, Result);
+  }
+
+  unsigned getNumHits() const {
+    llvm::MutexGuard Guard(Lock);
+    return NumHits;
+  }
+  unsigned getNumMisses() const {
+    llvm::MutexGuard Guard(Lock);
+    return NumMisses;
+  }
+};
+
+/// \brief Run \p Job for each of \p NumJobs jobs on up to \p NumThreads
+/// threads of the shared pool (see ThreadPool.h), and wait for them all to
+/// finish.
+///
+/// Jobs are handed out in order as threads become free, so putting the
+/// largest translation units first shortens the run.  \p Job is passed the
+/// index of the job and of the worker running it, which is less than
+/// \p NumThreads, for per-thread state; no two jobs with the same worker
+/// index run at once.  \p NumThreads of 0 means the size of the shared
+/// pool.  Without thread support, or with one thread, the jobs run in order
+/// on the calling thread.
+inline void runJobsInParallel(unsigned NumJobs, unsigned NumThreads,
+                              const std::function<void(unsigned Job,
+                                                       unsigned Thread)> &Job) {
+  if (NumThreads == 0)
+    NumThreads = llvm::getDefaultThreadPool().getThreadCount();
+  NumThreads = std::min(NumThreads, NumJobs);
+  if (NumThreads > 1) {
+    // Each worker task takes jobs until none are left.
+    std::atomic<unsigned> NextJob(0);
+    llvm::TaskGroup Group;
+    for (unsigned T = 0; T != NumThreads; ++T)
+      Group.spawn([&NextJob, NumJobs, &Job, T] {
+        for (unsigned J = NextJob++; J < NumJobs; J = NextJob++)
+          Job(J, T);
+      });
+    return;
+  }
+  for (unsigned J = 0; J != NumJobs; ++J)
+    Job(J, 0);
+}
+
+} // end namespace index
+} // end namespace clang
+
+#endif
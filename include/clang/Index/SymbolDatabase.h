@@ -0,0 +1,428 @@
+//===--- SymbolDatabase.h - Persistent USR-keyed symbol index ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the SymbolDatabase class, an on-disk index from USRs to
+/// the locations where the entities they name are declared, defined and
+/// referenced.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_INDEX_SYMBOLDATABASE_H
+#define LLVM_CLANG_INDEX_SYMBOLDATABASE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace index {
+
+/// \brief One place where the entity named by a USR occurs.
+struct SymbolOccurrence {
+  enum Role {
+    Declaration = 0x1,
+    Definition = 0x2,
+    Reference = 0x4
+  };
+
+  /// \brief The file, as an ID of the SymbolDatabase.
+  unsigned File;
+  unsigned Line;
+  unsigned Column;
+  /// \brief A bitwise OR of Role values.
+  unsigned Roles;
+
+  /// \brief The number of bytes an occurrence occupies on disk.
+  static unsigned getSerializedSize() { return 3 * 4 + 1; }
+};
+
+/// \brief The occurrences of one USR, as stored in a SymbolDatabase file.
+class OnDiskSymbolOccurrences {
+  const unsigned char *Data;
+  unsigned Count;
+
+public:
+  OnDiskSymbolOccurrences() : Data(0), Count(0) {}
+  OnDiskSymbolOccurrences(const unsigned char *Data, unsigned Count)
+    : Data(Data), Count(Count) {}
+
+  unsigned size() const { return Count; }
+
+  SymbolOccurrence operator[](unsigned I) const {
+    using namespace llvm::support;
+    const unsigned char *D = Data + I * SymbolOccurrence::getSerializedSize();
+    SymbolOccurrence Occurrence;
+    Occurrence.File = endian::readNext<uint32_t, little, unaligned>(D);
+    Occurrence.Line = endian::readNext<uint32_t, little, unaligned>(D);
+    Occurrence.Column = endian::readNext<uint32_t, little, unaligned>(D);
+    Occurrence.Roles = endian::readNext<uint8_t, little, unaligned>(D);
+    return Occurrence;
+  }
+};
+
+/// \brief OnDiskChainedHashTable traits mapping a USR to its occurrences.
+///
+/// The table is written from ArrayRefs of occurrences and read back as
+/// OnDiskSymbolOccurrences, hence the separate writer and reader traits.
+class SymbolDatabaseTraitBase {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+
+  static unsigned ComputeHash(StringRef Key) { return llvm::HashString(Key); }
+  static bool EqualKey(StringRef A, StringRef B) { return A == B; }
+  static StringRef GetInternalKey(StringRef Key) { return Key; }
+  static StringRef GetExternalKey(StringRef Key) { return Key; }
+};
+
+class SymbolDatabaseWriterTrait : public SymbolDatabaseTraitBase {
+public:
+  typedef ArrayRef<SymbolOccurrence> data_type;
+  typedef ArrayRef<SymbolOccurrence> data_type_ref;
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(raw_ostream &Out, StringRef Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    unsigned DataLen = Data.size() * SymbolOccurrence::getSerializedSize();
+    LE.write<uint16_t>(Key.size());
+    LE.write<uint32_t>(DataLen);
+    return std::make_pair(Key.size(), DataLen);
+  }
+
+  static void EmitKey(raw_ostream &Out, StringRef Key, unsigned) {
+    Out << Key;
+  }
+
+  static void EmitData(raw_ostream &Out, StringRef, data_type_ref Data,
+                       unsigned) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    for (unsigned I = 0, E = Data.size(); I != E; ++I) {
+      LE.write<uint32_t>(Data[I].File);
+      LE.write<uint32_t>(Data[I].Line);
+      LE.write<uint32_t>(Data[I].Column);
+      LE.write<uint8_t>(Data[I].Roles);
+    }
+  }
+};
+
+class SymbolDatabaseReaderTrait : public SymbolDatabaseTraitBase {
+public:
+  typedef OnDiskSymbolOccurrences data_type;
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(D);
+    unsigned DataLen = endian::readNext<uint32_t, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static StringRef ReadKey(const unsigned char *D, unsigned N) {
+    return StringRef(reinterpret_cast<const char *>(D), N);
+  }
+
+  static data_type ReadData(StringRef, const unsigned char *D, unsigned N) {
+    return OnDiskSymbolOccurrences(D,
+                                   N / SymbolOccurrence::getSerializedSize());
+  }
+};
+
+/// \brief A persistent index from USRs, as computed by generateUSRForDecl,
+/// to the occurrences of the entities they name.
+///
+/// The database file is read into memory when the database is opened, so
+/// looking up a USR is a single hash probe, with no parsing.  It is copied
+/// rather than kept mapped, so that other processes can replace it.  It
+/// is updated a file at a time: an indexer checks isUpToDate() for each
+/// file of a translation unit, and for each out-of-date one calls
+/// beginFile() and adds the file's occurrences, which replace the ones
+/// recorded for it before.  The update is merged into a new version of the
+/// database file by save(), which is atomically renamed over the old one,
+/// so readers never see a partial update.  Concurrent writers may drop each
+/// other's updates, which only means the files are re-indexed next time.
+class SymbolDatabase {
+public:
+  typedef OnDiskIterableChainedHashTable<SymbolDatabaseReaderTrait> TableTy;
+
+  /// \brief How opening the database file went.
+  enum LoadResult {
+    /// \brief The database was read from its file.
+    Loaded,
+    /// \brief There is no database file yet; the database is empty.
+    Missing,
+    /// \brief The file could not be read, or is not a database of this
+    /// version.  The database is empty, and save() replaces the file.
+    Invalid
+  };
+
+private:
+  enum {
+    Magic = 0x42445359, // 'YSDB'
+    Version = 1,
+    HeaderSize = 16
+  };
+
+  struct FileRecord {
+    std::string Path;
+    uint64_t ModTime;
+    /// Whether the occurrences of the file on disk are being replaced.
+    bool Replaced;
+  };
+
+  std::string DatabaseFile;
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<TableTy> Table;
+
+  std::vector<FileRecord> Files;
+  llvm::StringMap<unsigned> FileIDs;
+
+  /// \brief The occurrences added since the database was loaded or saved.
+  llvm::StringMap<std::vector<SymbolOccurrence> > NewOccurrences;
+  bool Modified;
+  LoadResult Result;
+
+  void load() {
+    Result = loadFile();
+    if (Result != Loaded) {
+      Table.reset();
+      Buffer.reset();
+      Files.clear();
+      FileIDs.clear();
+    }
+  }
+
+  LoadResult loadFile() {
+    using namespace llvm::support;
+    Table.reset();
+    Files.clear();
+    FileIDs.clear();
+    std::unique_ptr<llvm::MemoryBuffer> Mapped;
+    if (llvm::error_code EC = llvm::MemoryBuffer::getFile(
+            DatabaseFile, Mapped, -1, /*RequiresNullTerminator=*/false))
+      return EC == llvm::errc::no_such_file_or_directory ? Missing : Invalid;
+    if (Mapped->getBufferSize() < HeaderSize + 8)
+      return Invalid;
+    Buffer.reset(llvm::MemoryBuffer::getMemBufferCopy(Mapped->getBuffer(),
+                                                      DatabaseFile));
+    Mapped.reset();
+
+    const unsigned char *Base =
+        reinterpret_cast<const unsigned char *>(Buffer->getBufferStart());
+    const unsigned char *End = Base + Buffer->getBufferSize();
+    const unsigned char *D = Base;
+    if (endian::readNext<uint32_t, little, aligned>(D) != Magic ||
+        endian::readNext<uint32_t, little, aligned>(D) != Version)
+      return Invalid;
+    uint32_t TableOffset = endian::readNext<uint32_t, little, aligned>(D);
+    uint32_t FilesOffset = endian::readNext<uint32_t, little, aligned>(D);
+    if (TableOffset < HeaderSize || TableOffset % 4 ||
+        TableOffset + 8 > FilesOffset ||
+        FilesOffset + 4 > Buffer->getBufferSize())
+      return Invalid;
+
+    // The file table: a count, then the modification time and path of each.
+    D = Base + FilesOffset;
+    unsigned NumFiles = endian::readNext<uint32_t, little, unaligned>(D);
+    for (unsigned I = 0; I != NumFiles; ++I) {
+      if (End - D < 10)
+        return Invalid;
+      FileRecord File;
+      File.ModTime = endian::readNext<uint64_t, little, unaligned>(D);
+      unsigned Len = endian::readNext<uint16_t, little, unaligned>(D);
+      if (unsigned(End - D) < Len)
+        return Invalid;
+      File.Path.assign(reinterpret_cast<const char *>(D), Len);
+      File.Replaced = false;
+      D += Len;
+      FileIDs[File.Path] = Files.size();
+      Files.push_back(File);
+    }
+    Table.reset(TableTy::Create(Base + TableOffset, Base + HeaderSize, Base));
+    return Loaded;
+  }
+
+  static void addOccurrences(const OnDiskSymbolOccurrences &OnDisk,
+                             const std::vector<FileRecord> &Files,
+                             std::vector<SymbolOccurrence> &Result) {
+    for (unsigned I = 0, E = OnDisk.size(); I != E; ++I) {
+      SymbolOccurrence Occurrence = OnDisk[I];
+      if (Occurrence.File < Files.size() && !Files[Occurrence.File].Replaced)
+        Result.push_back(Occurrence);
+    }
+  }
+
+public:
+  /// \brief Open the database in \p File.  A missing or unreadable file
+  /// opens an empty database, which save() creates; getLoadResult() tells
+  /// the two apart, so that the caller can report a file it is about to
+  /// replace.
+  explicit SymbolDatabase(StringRef File)
+    : DatabaseFile(File), Modified(false) {
+    load();
+  }
+
+  StringRef getDatabaseFile() const { return DatabaseFile; }
+
+  /// \brief How the database file was read when the database was opened or
+  /// last saved.
+  LoadResult getLoadResult() const { return Result; }
+
+  unsigned getNumFiles() const { return Files.size(); }
+  StringRef getFilePath(unsigned FileID) const { return Files[FileID].Path; }
+
+  /// \brief Whether the occurrences recorded for \p Path were indexed from
+  /// the version of the file last modified at \p ModTime.
+  bool isUpToDate(StringRef Path, uint64_t ModTime) const {
+    llvm::StringMap<unsigned>::const_iterator I = FileIDs.find(Path);
+    return I != FileIDs.end() && Files[I->second].ModTime == ModTime;
+  }
+
+  /// \brief Start recording the occurrences in the version of \p Path last
+  /// modified at \p ModTime, dropping those recorded for the file before.
+  ///
+  /// \returns the ID of the file, to pass to addOccurrence().
+  unsigned beginFile(StringRef Path, uint64_t ModTime) {
+    Modified = true;
+    llvm::StringMap<unsigned>::iterator I = FileIDs.find(Path);
+    if (I != FileIDs.end()) {
+      Files[I->second].ModTime = ModTime;
+      Files[I->second].Replaced = true;
+      return I->second;
+    }
+    FileRecord File;
+    File.Path = Path;
+    File.ModTime = ModTime;
+    File.Replaced = true;
+    FileIDs[Path] = Files.size();
+    Files.push_back(File);
+    return Files.size() - 1;
+  }
+
+  /// \brief Record an occurrence of the entity named \p USR.  USRs longer
+  /// than 64K are not recorded.
+  void addOccurrence(StringRef USR, unsigned FileID, unsigned Line,
+                     unsigned Column, unsigned Roles) {
+    assert(FileID < Files.size() && Files[FileID].Replaced &&
+           "Occurrence in a file that has not been begun");
+    if (USR.size() > 0xFFFF)
+      return;
+    SymbolOccurrence Occurrence = { FileID, Line, Column, Roles };
+    NewOccurrences[USR].push_back(Occurrence);
+  }
+
+  /// \brief Append the occurrences of the entity named \p USR whose roles
+  /// include one of \p Roles to \p Result.
+  void lookup(StringRef USR, std::vector<SymbolOccurrence> &Result,
+              unsigned Roles = ~0U) const {
+    unsigned First = Result.size();
+    if (Table) {
+      TableTy::iterator I = Table->find(USR);
+      if (I != Table->end())
+        addOccurrences(*I, Files, Result);
+    }
+    llvm::StringMap<std::vector<SymbolOccurrence> >::const_iterator New =
+        NewOccurrences.find(USR);
+    if (New != NewOccurrences.end())
+      Result.insert(Result.end(), New->second.begin(), New->second.end());
+
+    unsigned Last = First;
+    for (unsigned I = First, E = Result.size(); I != E; ++I)
+      if (Result[I].Roles & Roles)
+        Result[Last++] = Result[I];
+    Result.resize(Last);
+  }
+
+  /// \brief Write the database, with the occurrences added since it was
+  /// opened, to its file.
+  ///
+  /// \returns true on success, or if there was nothing to write.
+  bool save() {
+    if (!Modified)
+      return true;
+
+    // Merge the surviving occurrences on disk with the new ones.
+    llvm::StringMap<std::vector<SymbolOccurrence> > Merged;
+    if (Table) {
+      for (TableTy::key_iterator I = Table->key_begin(),
+                                 E = Table->key_end(); I != E; ++I) {
+        StringRef USR = *I;
+        std::vector<SymbolOccurrence> Occurrences;
+        addOccurrences(*Table->find(USR), Files, Occurrences);
+        if (!Occurrences.empty())
+          Merged.GetOrCreateValue(USR).getValue().swap(Occurrences);
+      }
+    }
+    for (llvm::StringMap<std::vector<SymbolOccurrence> >::iterator
+             I = NewOccurrences.begin(), E = NewOccurrences.end();
+         I != E; ++I) {
+      std::vector<SymbolOccurrence> &Occurrences =
+          Merged.GetOrCreateValue(I->getKey()).getValue();
+      Occurrences.insert(Occurrences.end(), I->second.begin(),
+                         I->second.end());
+    }
+
+    OnDiskChainedHashTableGenerator<SymbolDatabaseWriterTrait> Generator;
+    for (llvm::StringMap<std::vector<SymbolOccurrence> >::iterator
+             I = Merged.begin(), E = Merged.end(); I != E; ++I)
+      Generator.insert(I->getKey(), I->second);
+
+    SmallString<4096> Contents;
+    {
+      using namespace llvm::support;
+      llvm::raw_svector_ostream Out(Contents);
+      endian::Writer<little> LE(Out);
+      LE.write<uint32_t>(Magic);
+      LE.write<uint32_t>(Version);
+      LE.write<uint32_t>(0); // Table offset, patched below.
+      LE.write<uint32_t>(0); // File table offset, patched below.
+      uint32_t TableOffset = Generator.Emit(Out);
+      uint32_t FilesOffset = Out.tell();
+      LE.write<uint32_t>(Files.size());
+      for (unsigned I = 0, E = Files.size(); I != E; ++I) {
+        LE.write<uint64_t>(Files[I].ModTime);
+        LE.write<uint16_t>(Files[I].Path.size());
+        Out << Files[I].Path;
+      }
+      Out.flush();
+      endian::write<uint32_t, little, unaligned>(Contents.data() + 8,
+                                                  TableOffset);
+      endian::write<uint32_t, little, unaligned>(Contents.data() + 12,
+                                                  FilesOffset);
+    }
+
+    if (llvm::writeFileAtomically(DatabaseFile, Contents.str()))
+      return false;
+
+    NewOccurrences.clear();
+    Modified = false;
+    load();
+    return true;
+  }
+};
+
+} // end namespace index
+} // end namespace clang
+
+#endif
@@ -0,0 +1,370 @@
+//===--- DependencyDirectivesMinimizer.h - Minimizer ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the DependencyDirectivesMinimizer class, which reduces a
+/// source file to the preprocessor directives that can affect the set of
+/// files it includes.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_DEPENDENCYDIRECTIVESMINIMIZER_H
+#define LLVM_CLANG_LEX_DEPENDENCYDIRECTIVESMINIMIZER_H
+
+#include "clang/Basic/CharInfo.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSwitch.h"
+
+namespace clang {
+
+/// \brief Reduces a source file to its include, macro, conditional and pragma
+/// directives (and Objective-C \@import declarations), one per line, with
+/// comments and line continuations removed.
+///
+/// Everything else in the file is skipped without being tokenized: all the
+/// minimizer tracks outside of directives is where comments and string
+/// literals start and end, so that a '#' in either is not mistaken for a
+/// directive.  Preprocessing the minimized file includes the same files as
+/// preprocessing the original, as long as no macro used in a conditional is
+/// defined in terms of __LINE__, and \#error and \#warning lines (which are
+/// dropped) are not relied upon to stop preprocessing.
+class DependencyDirectivesMinimizer {
+  const char *const Begin;
+  const char *Cur;
+  const char *const End;
+  SmallVectorImpl<char> &Out;
+
+  DependencyDirectivesMinimizer(StringRef Input, SmallVectorImpl<char> &Out)
+    : Begin(Input.begin()), Cur(Input.begin()), End(Input.end()), Out(Out) {}
+
+  /// \brief Return the size of the escaped newline at \p P, or 0 if there is
+  /// none.  Like the Lexer, whitespace is allowed between the backslash and
+  /// the newline.
+  unsigned getEscapedNewlineSize(const char *P) const {
+    if (P == End || *P != '\\')
+      return 0;
+    const char *Q = P + 1;
+    while (Q != End && isHorizontalWhitespace(*Q))
+      ++Q;
+    if (Q == End || !isVerticalWhitespace(*Q))
+      return 0;
+    if (Q + 1 != End && isVerticalWhitespace(Q[1]) && Q[0] != Q[1])
+      ++Q;
+    return Q + 1 - P;
+  }
+
+  /// \brief Return the character at \p P, after skipping escaped newlines, and
+  /// set \p Next to the character after it.
+  char peek(const char *P, const char *&Next) const {
+    while (unsigned Size = getEscapedNewlineSize(P))
+      P += Size;
+    if (P == End) {
+      Next = P;
+      return 0;
+    }
+    Next = P + 1;
+    return *P;
+  }
+
+  bool isAtNewline(const char *P) const {
+    return P == End || isVerticalWhitespace(*P);
+  }
+
+  const char *skipNewline(const char *P) const {
+    if (P == End)
+      return P;
+    if (P + 1 != End && isVerticalWhitespace(P[1]) && P[0] != P[1])
+      return P + 2;
+    return P + 1;
+  }
+
+  /// \brief Skip the block comment whose "/*" is at \p P.
+  const char *skipBlockComment(const char *P) const {
+    const char *Next;
+    peek(P, Next);
+    peek(Next, P);
+    for (char Prev = 0; P != End;) {
+      char C = peek(P, Next);
+      P = Next;
+      if (Prev == '*' && C == '/')
+        return P;
+      Prev = C;
+    }
+    return P;
+  }
+
+  /// \brief Skip to the newline ending the line comment at \p P.
+  const char *skipLineComment(const char *P) const {
+    for (;;) {
+      P += getEscapedNewlineSize(P);
+      if (isAtNewline(P))
+        return P;
+      ++P;
+    }
+  }
+
+  /// \brief Check whether the '"' at \p Quote starts a raw string literal.
+  bool isRawStringQuote(const char *Quote) const {
+    if (Quote == Begin || Quote[-1] != 'R')
+      return false;
+    const char *Prefix = Quote - 1;
+    // Skip an encoding prefix: u8R, uR, UR or LR.
+    if (Prefix != Begin && Prefix[-1] == '8' && Prefix - 1 != Begin &&
+        Prefix[-2] == 'u')
+      Prefix -= 2;
+    else if (Prefix != Begin &&
+             (Prefix[-1] == 'u' || Prefix[-1] == 'U' || Prefix[-1] == 'L'))
+      --Prefix;
+    return Prefix == Begin || !isIdentifierBody(Prefix[-1]);
+  }
+
+  /// \brief Skip the raw string literal whose '"' is at \p P, or return null
+  /// if its delimiter is invalid.
+  const char *skipRawString(const char *P) const {
+    const char *DelimBegin = P + 1, *DelimEnd = DelimBegin;
+    while (DelimEnd != End && *DelimEnd != '(') {
+      if (DelimEnd - DelimBegin == 16 || isWhitespace(*DelimEnd) ||
+          *DelimEnd == ')' || *DelimEnd == '\\')
+        return 0;
+      ++DelimEnd;
+    }
+    if (DelimEnd == End)
+      return 0;
+    StringRef Delim(DelimBegin, DelimEnd - DelimBegin);
+    for (P = DelimEnd + 1; P != End; ++P)
+      if (*P == ')' && StringRef(P + 1, End - P - 1).startswith(Delim) &&
+          P + 1 + Delim.size() != End && P[1 + Delim.size()] == '"')
+        return P + Delim.size() + 2;
+    return End;
+  }
+
+  /// \brief Skip the string or character literal whose opening quote is at
+  /// \p P.  An unterminated literal ends at the end of the line.
+  const char *skipQuoted(const char *P) const {
+    char Quote = *P++;
+    for (;;) {
+      P += getEscapedNewlineSize(P);
+      if (isAtNewline(P))
+        return P;
+      char C = *P++;
+      if (C == Quote)
+        return P;
+      if (C == '\\' && !isAtNewline(P))
+        ++P;
+    }
+  }
+
+  /// \brief Skip to the start of the next line, stepping over any comments
+  /// and literals on the way.
+  void skipLine() {
+    while (!isAtNewline(Cur)) {
+      if (unsigned Size = getEscapedNewlineSize(Cur)) {
+        Cur += Size;
+        continue;
+      }
+      const char *Next;
+      char C = *Cur;
+      if (C == '/' && peek(Cur + 1, Next) == '*') {
+        Cur = skipBlockComment(Cur);
+      } else if (C == '/' && peek(Cur + 1, Next) == '/') {
+        Cur = skipLineComment(Cur);
+      } else if (C == '"' && isRawStringQuote(Cur)) {
+        const char *AfterRaw = skipRawString(Cur);
+        Cur = AfterRaw ? AfterRaw : skipQuoted(Cur);
+      } else if (C == '"' || C == '\'') {
+        Cur = skipQuoted(Cur);
+      } else {
+        ++Cur;
+      }
+    }
+    Cur = skipNewline(Cur);
+  }
+
+  /// \brief Skip horizontal whitespace, escaped newlines and comments that do
+  /// not end the current line.  Block comments are replaced by whitespace, so
+  /// a block comment spanning lines does not end the line.
+  void skipSpace() {
+    for (;;) {
+      if (unsigned Size = getEscapedNewlineSize(Cur)) {
+        Cur += Size;
+        continue;
+      }
+      if (Cur == End)
+        return;
+      const char *Next;
+      if (isHorizontalWhitespace(*Cur))
+        ++Cur;
+      else if (*Cur == '/' && peek(Cur + 1, Next) == '*')
+        Cur = skipBlockComment(Cur);
+      else
+        return;
+    }
+  }
+
+  /// \brief Read the identifier at Cur, joining escaped newlines.
+  StringRef lexIdentifier(SmallVectorImpl<char> &Buffer) {
+    Buffer.clear();
+    for (;;) {
+      const char *Next;
+      char C = peek(Cur, Next);
+      if (!isIdentifierBody(C))
+        return StringRef(Buffer.data(), Buffer.size());
+      Buffer.push_back(C);
+      Cur = Next;
+    }
+  }
+
+  static bool isDependencyDirective(StringRef Name) {
+    return llvm::StringSwitch<bool>(Name)
+        .Cases("include", "include_next", "import", "__include_macros", true)
+        .Cases("define", "undef", "pragma", true)
+        .Cases("if", "ifdef", "ifndef", true)
+        .Cases("elif", "else", "endif", true)
+        .Default(false);
+  }
+
+  /// \brief Copy the rest of the directive line at Cur to the output,
+  /// collapsing whitespace and comments to single spaces.
+  void copyDirectiveBody() {
+    bool PendingSpace = true;
+    for (;;) {
+      if (unsigned Size = getEscapedNewlineSize(Cur)) {
+        Cur += Size;
+        continue;
+      }
+      if (isAtNewline(Cur))
+        break;
+      const char *Next;
+      char C = *Cur;
+      if (isHorizontalWhitespace(C)) {
+        PendingSpace = true;
+        ++Cur;
+        continue;
+      }
+      if (C == '/' && peek(Cur + 1, Next) == '*') {
+        Cur = skipBlockComment(Cur);
+        PendingSpace = true;
+        continue;
+      }
+      if (C == '/' && peek(Cur + 1, Next) == '/') {
+        Cur = skipLineComment(Cur);
+        break;
+      }
+      if (PendingSpace)
+        Out.push_back(' ');
+      PendingSpace = false;
+      if (C == '"' || C == '\'') {
+        // Copy literals verbatim, so that "//" and "/*" in them survive.
+        const char *LiteralEnd = skipQuoted(Cur);
+        Out.append(Cur, LiteralEnd);
+        Cur = LiteralEnd;
+        continue;
+      }
+      Out.push_back(C);
+      ++Cur;
+    }
+    Out.push_back('\n');
+    Cur = skipNewline(Cur);
+  }
+
+  void lexDirective() {
+    ++Cur; // Skip the '#'.
+    skipSpace();
+    SmallString<32> Buffer;
+    StringRef Name = lexIdentifier(Buffer);
+    if (!isDependencyDirective(Name)) {
+      skipLine();
+      return;
+    }
+    Out.push_back('#');
+    Out.append(Name.begin(), Name.end());
+    skipSpace();
+    copyDirectiveBody();
+  }
+
+  /// \brief Copy the Objective-C module import at Cur, up to its ';'.
+  void lexAtImport() {
+    Out.push_back('@');
+    ++Cur;
+    for (;;) {
+      if (unsigned Size = getEscapedNewlineSize(Cur)) {
+        Cur += Size;
+        continue;
+      }
+      if (Cur == End)
+        break;
+      const char *Next;
+      char C = *Cur;
+      if (C == '/') {
+        char NextC = peek(Cur + 1, Next);
+        if (NextC == '*' || NextC == '/') {
+          Cur = NextC == '*' ? skipBlockComment(Cur) : skipLineComment(Cur);
+          Out.push_back(' ');
+          continue;
+        }
+      }
+      Out.push_back(isWhitespace(C) ? ' ' : C);
+      ++Cur;
+      if (C == ';')
+        break;
+    }
+    Out.push_back('\n');
+    skipLine();
+  }
+
+  bool isAtImport() const {
+    if (*Cur != '@')
+      return false;
+    StringRef Rest(Cur + 1, End - Cur - 1);
+    return Rest.startswith("import") &&
+           (Rest.size() == 6 || !isIdentifierBody(Rest[6]));
+  }
+
+  void run() {
+    while (Cur != End) {
+      skipSpace();
+      if (Cur == End)
+        break;
+      const char *Next;
+      if (*Cur == '/' && peek(Cur + 1, Next) == '/')
+        Cur = skipLineComment(Cur);
+      if (isAtNewline(Cur))
+        Cur = skipNewline(Cur);
+      else if (*Cur == '#')
+        lexDirective();
+      else if (isAtImport())
+        lexAtImport();
+      else
+        skipLine();
+    }
+  }
+
+public:
+  /// \brief Minimize \p Input, appending the result to \p Output.  A UTF-8
+  /// byte order mark at the start of \p Input is skipped, as the Lexer does,
+  /// so that a directive on the first line is still found.
+  ///
+  /// \returns true if \p Input contains a null character, and so is not a
+  /// source file; \p Output is left unchanged then.
+  static bool minimize(StringRef Input, SmallVectorImpl<char> &Output) {
+    if (Input.find('\0') != StringRef::npos)
+      return true;
+    if (Input.startswith("\xEF\xBB\xBF"))
+      Input = Input.drop_front(3);
+    DependencyDirectivesMinimizer(Input, Output).run();
+    return false;
+  }
+};
+
+} // end namespace clang
+
+#endif
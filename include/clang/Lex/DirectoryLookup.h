@@ -174,6 +174,10 @@ public:
                               SmallVectorImpl<char> &MappedName) const;
 
 private:
+  /// DoFrameworkLookup - Look up a framework include in this framework
+  /// directory.  If the HeaderSearch has a FrameworkHeaderIndex covering the
+  /// directory, it decides whether and where the header exists, so only the
+  /// header itself is stat'ed.
   const FileEntry *DoFrameworkLookup(
       StringRef Filename, HeaderSearch &HS,
       SmallVectorImpl<char> *SearchPath,
@@ -0,0 +1,411 @@
+//===--- FrameworkHeaderIndex.h - Framework header lookup index -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the FrameworkHeaderIndex class, which maps framework
+/// includes such as <UIKit/UIKit.h> to header paths without probing the
+/// file system for every framework search directory.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_FRAMEWORKHEADERINDEX_H
+#define LLVM_CLANG_LEX_FRAMEWORKHEADERINDEX_H
+
+#include "clang/Basic/CharInfo.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace clang {
+
+/// \brief An index of the headers of every framework in a set of framework
+/// search directories (-F paths and the SDK's System/Library/Frameworks).
+///
+/// Resolving a framework include normally stats Name.framework/Headers/X and
+/// Name.framework/PrivateHeaders/X in every framework directory in turn.  The
+/// index lists each directory once instead, so DirectoryLookup can tell
+/// whether a directory holds the header, and where, from memory.  It is
+/// written to a per-build-session file and reused by later translation
+/// units.
+///
+/// A search directory's entry is rebuilt when the directory's modification
+/// time changes (a framework was added or removed).  The first lookup in a
+/// framework during a translation unit compares the modification times of its
+/// Headers and PrivateHeaders directories and of every directory under them;
+/// if any changed, lookups in that framework fall back to probing until the
+/// index is rebuilt.
+///
+/// Paths are indexed under a key with '/' separators and, on Windows and
+/// Cygwin, whose file systems ignore case, in lower case, so that the
+/// spelling of a directory or include does not turn a header that exists
+/// into a miss.  Includes the index cannot answer for, such as those with
+/// "." or ".." components, are reported as not indexed.
+class FrameworkHeaderIndex {
+public:
+  enum LookupResult {
+    /// The directory or framework is not (validly) indexed; probe as usual.
+    NotIndexed,
+    /// The directory definitely does not provide the header.
+    NotFound,
+    /// The header was found; see the \p Path argument of lookup().
+    Found
+  };
+
+private:
+  enum ValidationState { Unvalidated, Valid, Stale };
+
+  struct Framework {
+    /// The path of the Name.framework directory.
+    std::string Dir;
+    /// Headers, PrivateHeaders and the directories under them, relative to
+    /// \c Dir, with their modification times (0 if they did not exist).
+    std::vector<std::pair<std::string, uint64_t> > DirMTimes;
+    /// The headers, relative to Headers or PrivateHeaders, mapped to true for
+    /// private headers.  Public headers shadow private ones.
+    llvm::StringMap<bool> Headers;
+    ValidationState State;
+
+    Framework() : State(Unvalidated) {}
+  };
+
+  struct SearchDir {
+    uint64_t MTime;
+    llvm::StringMap<unsigned> Frameworks;
+    SearchDir() : MTime(0) {}
+  };
+
+  uint64_t BuildSessionTimestamp;
+  llvm::StringMap<SearchDir> SearchDirs;
+  std::vector<std::unique_ptr<Framework> > Frameworks;
+  bool Dirty;
+
+  /// \brief The key under which \p Path is indexed.
+  static StringRef getKey(StringRef Path, SmallVectorImpl<char> &Key) {
+    Key.clear();
+    Key.append(Path.begin(), Path.end());
+    for (unsigned I = 0, E = Key.size(); I != E; ++I) {
+      if (Key[I] == '\\')
+        Key[I] = '/';
+#if defined(LLVM_ON_WIN32) || defined(__CYGWIN__)
+      Key[I] = toLowercase(Key[I]);
+#endif
+    }
+    while (Key.size() > 1 && Key.back() == '/')
+      Key.pop_back();
+    return StringRef(Key.data(), Key.size());
+  }
+
+  /// \brief Whether \p Filename has an empty, "." or ".." component, which
+  /// the index has no entry for even if the header exists.
+  static bool hasUnindexedComponents(StringRef Filename) {
+    while (!Filename.empty()) {
+      StringRef Component;
+      std::tie(Component, Filename) = Filename.split('/');
+      if (Component.empty() || Component == "." || Component == "..")
+        return true;
+    }
+    return false;
+  }
+
+  static uint64_t getMTime(const Twine &Path) {
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(Path, Status))
+      return 0;
+    return Status.getLastModificationTime().toEpochTime();
+  }
+
+  static void addHeaders(Framework &FW, StringRef Subdir, bool IsPrivate) {
+    SmallString<256> Root(FW.Dir);
+    llvm::sys::path::append(Root, Subdir);
+    FW.DirMTimes.push_back(std::make_pair(Subdir.str(), getMTime(Root.str())));
+    llvm::error_code EC;
+    SmallString<128> Key;
+    for (llvm::sys::fs::recursive_directory_iterator I(Root.str(), EC), E;
+         I != E && !EC; I.increment(EC)) {
+      StringRef Path = I->path();
+      llvm::sys::fs::file_status Status;
+      if (Path.size() <= Root.size() + 1 || I->status(Status))
+        continue;
+      if (llvm::sys::fs::is_directory(Status)) {
+        FW.DirMTimes.push_back(std::make_pair(
+            Path.substr(FW.Dir.size() + 1).str(),
+            Status.getLastModificationTime().toEpochTime()));
+        continue;
+      }
+      StringRef Relative = Path.substr(Root.size() + 1);
+      FW.Headers.GetOrCreateValue(getKey(Relative, Key), IsPrivate);
+    }
+  }
+
+  void indexFramework(SearchDir &SD, StringRef Name, StringRef Dir) {
+    std::unique_ptr<Framework> FW(new Framework);
+    FW->Dir = Dir;
+    FW->State = Valid;
+    addHeaders(*FW, "Headers", /*IsPrivate=*/false);
+    addHeaders(*FW, "PrivateHeaders", /*IsPrivate=*/true);
+    SmallString<64> Key;
+    SD.Frameworks[getKey(Name, Key)] = Frameworks.size();
+    Frameworks.push_back(std::move(FW));
+  }
+
+  bool validate(Framework &FW) {
+    if (FW.State != Unvalidated)
+      return FW.State == Valid;
+    FW.State = Valid;
+    for (unsigned I = 0, E = FW.DirMTimes.size(); I != E; ++I) {
+      if (getMTime(FW.Dir + "/" + FW.DirMTimes[I].first) !=
+          FW.DirMTimes[I].second) {
+        FW.State = Stale;
+        break;
+      }
+    }
+    return FW.State == Valid;
+  }
+
+  /// \brief Consume " <decimal number>" from the front of \p Rest.
+  static bool readNumber(StringRef &Rest, uint64_t &Value) {
+    if (!Rest.startswith(" "))
+      return false;
+    size_t End = Rest.find_first_not_of("0123456789", 1);
+    if (End == 1 || End == StringRef::npos ||
+        Rest.slice(1, End).getAsInteger(10, Value))
+      return false;
+    Rest = Rest.substr(End);
+    return true;
+  }
+
+  /// \brief Consume " <length>:<bytes>" from the front of \p Rest.
+  static bool readString(StringRef &Rest, StringRef &Str) {
+    uint64_t Length;
+    if (!readNumber(Rest, Length) || !Rest.startswith(":") ||
+        Rest.size() - 1 < Length)
+      return false;
+    Str = Rest.substr(1, Length);
+    Rest = Rest.substr(1 + Length);
+    return true;
+  }
+
+  /// \brief Write \p Str as read by readString(), so that it may hold any
+  /// character, spaces and newlines included.
+  static void writeString(raw_ostream &Out, StringRef Str) {
+    Out << ' ' << Str.size() << ':' << Str;
+  }
+
+public:
+  explicit FrameworkHeaderIndex(uint64_t BuildSessionTimestamp)
+    : BuildSessionTimestamp(BuildSessionTimestamp), Dirty(false) {}
+
+  /// \brief Compute the name of the index file for a build session.
+  static void getIndexFilePath(StringRef CacheDir, uint64_t Session,
+                               SmallVectorImpl<char> &Path) {
+    Path.clear();
+    Path.append(CacheDir.begin(), CacheDir.end());
+    llvm::sys::path::append(Path, "framework-index-" + Twine(Session) +
+                                      ".txt");
+  }
+
+  /// \brief Make sure the framework search directory \p Dir is indexed and
+  /// up to date, indexing it if needed.
+  void addSearchDir(StringRef Dir) {
+    uint64_t MTime = getMTime(Dir);
+    SmallString<256> Key;
+    llvm::StringMap<SearchDir>::iterator Known =
+        SearchDirs.find(getKey(Dir, Key));
+    if (Known != SearchDirs.end() && Known->second.MTime == MTime)
+      return;
+
+    // Frameworks of a stale entry stay allocated but unreferenced.
+    SearchDir &SD = SearchDirs[Key];
+    SD = SearchDir();
+    SD.MTime = MTime;
+    Dirty = true;
+    llvm::error_code EC;
+    for (llvm::sys::fs::directory_iterator I(Dir, EC), E; I != E && !EC;
+         I.increment(EC)) {
+      StringRef Path = I->path();
+      StringRef Name = llvm::sys::path::filename(Path);
+      if (Name.endswith(".framework") && llvm::sys::fs::is_directory(Path))
+        indexFramework(SD, Name.drop_back(strlen(".framework")), Path);
+    }
+  }
+
+  /// \brief Look up the framework include \p Filename ("Name/Header.h") in
+  /// the framework search directory \p Dir.
+  ///
+  /// \param [out] Path Set to the path of the header if it is found.
+  /// \param [out] IsPrivate Set to true if the header was found in
+  /// PrivateHeaders.
+  ///
+  /// \returns NotFound only if \p Dir is indexed and definitely has no
+  /// such header; NotIndexed whenever the caller has to probe.
+  LookupResult lookup(StringRef Dir, StringRef Filename,
+                      SmallVectorImpl<char> &Path, bool &IsPrivate) {
+    SmallString<256> DirKey;
+    llvm::StringMap<SearchDir>::iterator SD =
+        SearchDirs.find(getKey(Dir, DirKey));
+    if (SD == SearchDirs.end())
+      return NotIndexed;
+
+    SmallString<128> FileKey;
+    StringRef Key = getKey(Filename, FileKey);
+    if (hasUnindexedComponents(Key))
+      return NotIndexed;
+    size_t Slash = Key.find('/');
+    if (Slash == StringRef::npos)
+      return NotFound;
+    llvm::StringMap<unsigned>::iterator FWIdx =
+        SD->second.Frameworks.find(Key.substr(0, Slash));
+    if (FWIdx == SD->second.Frameworks.end())
+      return NotFound;
+
+    Framework &FW = *Frameworks[FWIdx->second];
+    if (!validate(FW))
+      return NotIndexed;
+    llvm::StringMap<bool>::iterator Header =
+        FW.Headers.find(Key.substr(Slash + 1));
+    if (Header == FW.Headers.end())
+      return NotFound;
+
+    // Spell the path as the include does, as probing would.
+    IsPrivate = Header->second;
+    Path.clear();
+    Path.append(FW.Dir.begin(), FW.Dir.end());
+    llvm::sys::path::append(Path, IsPrivate ? "PrivateHeaders" : "Headers",
+                            Filename.substr(Filename.find_first_of("/\\") +
+                                            1));
+    return Found;
+  }
+
+  /// \brief Load the index written by save() for the same build session.
+  ///
+  /// \returns true if the file was loaded.
+  bool load(StringRef File) {
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::MemoryBuffer::getFile(File, Buffer))
+      return false;
+
+    StringRef Contents = Buffer->getBuffer(), Line;
+    std::tie(Line, Contents) = Contents.split('\n');
+    uint64_t Session;
+    if (!Line.startswith("framework-index 3 ") ||
+        Line.substr(strlen("framework-index 3 ")).getAsInteger(10, Session) ||
+        Session != BuildSessionTimestamp)
+      return false;
+
+    // One record per line, with strings written by writeString():
+    // D <mtime> <search dir>
+    // F <name> <framework dir>
+    // M <mtime> <directory, relative to the framework directory>
+    // H <0|1> <header>
+    SearchDir *SD = 0;
+    Framework *FW = 0;
+    SmallString<256> Key;
+    while (!Contents.empty()) {
+      char Kind = Contents[0];
+      Contents = Contents.substr(1);
+      uint64_t Number;
+      StringRef Str, Dir;
+      bool Parsed = true;
+      if (Kind == 'D' && readNumber(Contents, Number) &&
+          readString(Contents, Str)) {
+        SD = &SearchDirs[getKey(Str, Key)];
+        *SD = SearchDir();
+        SD->MTime = Number;
+        FW = 0;
+      } else if (Kind == 'F' && SD && readString(Contents, Str) &&
+                 readString(Contents, Dir)) {
+        std::unique_ptr<Framework> New(new Framework);
+        New->Dir = Dir;
+        SD->Frameworks[getKey(Str, Key)] = Frameworks.size();
+        FW = New.get();
+        Frameworks.push_back(std::move(New));
+      } else if (Kind == 'M' && FW && readNumber(Contents, Number) &&
+                 readString(Contents, Str)) {
+        FW->DirMTimes.push_back(std::make_pair(Str.str(), Number));
+      } else if (Kind == 'H' && FW && readNumber(Contents, Number) &&
+                 readString(Contents, Str)) {
+        FW->Headers.GetOrCreateValue(getKey(Str, Key), Number != 0);
+      } else {
+        Parsed = false;
+      }
+      if (!Parsed || !Contents.startswith("\n")) {
+        // A truncated or corrupt file; index from scratch.
+        SearchDirs.clear();
+        Frameworks.clear();
+        return false;
+      }
+      Contents = Contents.substr(1);
+    }
+    return true;
+  }
+
+  /// \brief Write the index to \p File if it changed, atomically replacing
+  /// any previous version.
+  ///
+  /// \returns true on success, or if there was nothing to write.
+  bool save(StringRef File) {
+    if (!Dirty)
+      return true;
+
+    SmallString<4096> Contents;
+    {
+      llvm::raw_svector_ostream Out(Contents);
+      Out << "framework-index 3 " << BuildSessionTimestamp << '\n';
+      for (llvm::StringMap<SearchDir>::iterator I = SearchDirs.begin(),
+                                                E = SearchDirs.end();
+           I != E; ++I) {
+        Out << "D " << I->second.MTime;
+        writeString(Out, I->getKey());
+        Out << '\n';
+        for (llvm::StringMap<unsigned>::iterator
+                 F = I->second.Frameworks.begin(),
+                 FE = I->second.Frameworks.end(); F != FE; ++F) {
+          const Framework &FW = *Frameworks[F->second];
+          Out << 'F';
+          writeString(Out, F->getKey());
+          writeString(Out, FW.Dir);
+          Out << '\n';
+          for (unsigned J = 0, JE = FW.DirMTimes.size(); J != JE; ++J) {
+            Out << "M " << FW.DirMTimes[J].second;
+            writeString(Out, FW.DirMTimes[J].first);
+            Out << '\n';
+          }
+          for (llvm::StringMap<bool>::const_iterator
+                   H = FW.Headers.begin(), HE = FW.Headers.end();
+               H != HE; ++H) {
+            Out << "H " << (H->second ? '1' : '0');
+            writeString(Out, H->getKey());
+            Out << '\n';
+          }
+        }
+      }
+    }
+    if (llvm::writeFileAtomically(File, Contents.str()))
+      return false;
+    Dirty = false;
+    return true;
+  }
+};
+
+} // end namespace clang
+
+#endif
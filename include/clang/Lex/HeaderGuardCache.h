@@ -0,0 +1,219 @@
+//===--- HeaderGuardCache.h - Cross-TU include guard cache ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the HeaderGuardCache interface, which remembers the include
+/// guards detected by MultipleIncludeOpt across the translation units of a
+/// build session.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_HEADERGUARDCACHE_H
+#define LLVM_CLANG_LEX_HEADERGUARDCACHE_H
+
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+
+namespace clang {
+
+/// \brief An external source of header file information that supplies the
+/// controlling macros of headers seen by earlier translation units of the
+/// same build session.
+///
+/// Without it, every translation unit has to open and lex a header once to
+/// discover its include guard, even when the guard macro is already defined
+/// by the time the header is first included (as happens with umbrella and
+/// prefix headers that pull in the same framework headers over and over).
+/// With the guard known up front, HeaderSearch::ShouldEnterIncludeFile skips
+/// such headers without opening them.
+///
+/// Guards are keyed by path and validated against the size and modification
+/// time of the file.  Only the controlling macro is cached: \#import and
+/// \#pragma once state records what this translation unit has included, so
+/// it must not be carried across translation units.
+///
+/// The cache is installed with HeaderSearch::SetExternalSource; any source
+/// already installed (such as a PCH reader) takes precedence.
+class HeaderGuardCache : public ExternalHeaderFileInfoSource {
+  enum {
+    Magic = 0x44524743, // 'CGRD'
+    Version = 1,
+    HeaderSize = 16,
+    EntryHeaderSize = 20
+  };
+
+  struct Entry {
+    uint64_t Size;
+    uint64_t ModTime;
+    std::string Guard;
+  };
+
+  std::string CacheFile;
+  uint64_t BuildSessionTimestamp;
+  IdentifierTable &Identifiers;
+  ExternalHeaderFileInfoSource *Next;
+
+  llvm::StringMap<Entry> Entries;
+  bool Dirty;
+  unsigned NumHits;
+
+  /// \brief Read the cache file of the session into \p Result.
+  static void load(StringRef File, uint64_t Session,
+                   llvm::StringMap<Entry> &Result) {
+    using namespace llvm::support;
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::MemoryBuffer::getFile(File, Buffer, -1,
+                                    /*RequiresNullTerminator=*/false))
+      return;
+    const char *P = Buffer->getBufferStart();
+    const char *End = Buffer->getBufferEnd();
+    if (End - P < HeaderSize ||
+        endian::read<uint32_t, little, unaligned>(P) != Magic ||
+        endian::read<uint32_t, little, unaligned>(P + 4) != Version ||
+        endian::read<uint64_t, little, unaligned>(P + 8) != Session)
+      return;
+    for (P += HeaderSize; End - P >= EntryHeaderSize;) {
+      unsigned PathLen = endian::read<uint16_t, little, unaligned>(P);
+      unsigned GuardLen = endian::read<uint16_t, little, unaligned>(P + 2);
+      if (unsigned(End - P - EntryHeaderSize) < PathLen + GuardLen)
+        return;
+      Entry E;
+      E.Size = endian::read<uint64_t, little, unaligned>(P + 4);
+      E.ModTime = endian::read<uint64_t, little, unaligned>(P + 12);
+      P += EntryHeaderSize;
+      StringRef Path(P, PathLen);
+      E.Guard.assign(P + PathLen, GuardLen);
+      P += PathLen + GuardLen;
+      Result[Path] = E;
+    }
+  }
+
+public:
+  /// \brief Create a guard cache for the given build session.
+  ///
+  /// \param CacheDir The directory holding the per-session cache files.
+  /// \param BuildSessionTimestamp The build session; cache files written by
+  /// other sessions are ignored.
+  /// \param Identifiers The identifier table in which to create the guard
+  /// macros' identifiers.
+  /// \param Next The external source to consult first, if any.
+  HeaderGuardCache(StringRef CacheDir, uint64_t BuildSessionTimestamp,
+                   IdentifierTable &Identifiers,
+                   ExternalHeaderFileInfoSource *Next = 0)
+    : BuildSessionTimestamp(BuildSessionTimestamp), Identifiers(Identifiers),
+      Next(Next), Dirty(false), NumHits(0) {
+    SmallString<256> Path(CacheDir);
+    llvm::sys::path::append(Path, "guard-cache-" +
+                                      Twine(BuildSessionTimestamp) + ".bin");
+    CacheFile = Path.str();
+    load(CacheFile, BuildSessionTimestamp, Entries);
+  }
+
+  StringRef getCacheFile() const { return CacheFile; }
+  unsigned getNumHits() const { return NumHits; }
+
+  HeaderFileInfo GetHeaderFileInfo(const FileEntry *FE) override {
+    if (Next) {
+      HeaderFileInfo HFI = Next->GetHeaderFileInfo(FE);
+      if (HFI.isNonDefault())
+        return HFI;
+    }
+
+    HeaderFileInfo HFI;
+    llvm::StringMap<Entry>::iterator I = Entries.find(FE->getName());
+    if (I == Entries.end() || I->second.Size != uint64_t(FE->getSize()) ||
+        I->second.ModTime != uint64_t(FE->getModificationTime()))
+      return HFI;
+    ++NumHits;
+    HFI.External = true;
+    HFI.ControllingMacro = &Identifiers.get(I->second.Guard);
+    return HFI;
+  }
+
+  /// \brief Record the controlling macros HeaderSearch has detected for the
+  /// files of \p FileMgr.  Called once the translation unit has been
+  /// preprocessed.
+  void recordGuards(const HeaderSearch &HS, const FileManager &FileMgr) {
+    SmallVector<const FileEntry *, 64> Files;
+    FileMgr.GetUniqueIDMapping(Files);
+    for (unsigned i = 0, e = Files.size(); i != e; ++i) {
+      const FileEntry *FE = Files[i];
+      HeaderFileInfo HFI;
+      if (!FE || !HS.tryGetFileInfo(FE, HFI) || !HFI.ControllingMacro)
+        continue;
+      StringRef Guard = HFI.ControllingMacro->getName();
+      StringRef Path = FE->getName();
+      if (Path.size() > 0xFFFF || Guard.size() > 0xFFFF)
+        continue;
+      Entry &E = Entries[Path];
+      if (E.Size == uint64_t(FE->getSize()) &&
+          E.ModTime == uint64_t(FE->getModificationTime()) && E.Guard == Guard)
+        continue;
+      E.Size = FE->getSize();
+      E.ModTime = FE->getModificationTime();
+      E.Guard = Guard;
+      Dirty = true;
+    }
+  }
+
+  /// \brief Merge the guards recorded by this invocation with those written
+  /// by concurrent invocations since the cache was loaded, and atomically
+  /// replace the cache file.
+  ///
+  /// \returns true on success, or if there was nothing to write.
+  bool save() {
+    if (!Dirty)
+      return true;
+
+    llvm::StringMap<Entry> Merged;
+    load(CacheFile, BuildSessionTimestamp, Merged);
+    for (llvm::StringMap<Entry>::iterator I = Entries.begin(),
+                                          E = Entries.end(); I != E; ++I)
+      Merged[I->getKey()] = I->second;
+
+    SmallString<4096> Contents;
+    {
+      using namespace llvm::support;
+      llvm::raw_svector_ostream Out(Contents);
+      endian::Writer<little> LE(Out);
+      LE.write<uint32_t>(Magic);
+      LE.write<uint32_t>(Version);
+      LE.write<uint64_t>(BuildSessionTimestamp);
+      for (llvm::StringMap<Entry>::iterator I = Merged.begin(),
+                                            E = Merged.end(); I != E; ++I) {
+        LE.write<uint16_t>(I->getKey().size());
+        LE.write<uint16_t>(I->second.Guard.size());
+        LE.write<uint64_t>(I->second.Size);
+        LE.write<uint64_t>(I->second.ModTime);
+        Out << I->getKey() << I->second.Guard;
+      }
+    }
+    if (llvm::writeFileAtomically(CacheFile, Contents.str()))
+      return false;
+    Dirty = false;
+    return true;
+  }
+};
+
+} // end namespace clang
+
+#endif
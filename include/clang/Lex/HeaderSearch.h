@@ -30,6 +30,7 @@ class DiagnosticsEngine;
 class ExternalIdentifierLookup;
 class FileEntry;
 class FileManager;
+class FrameworkHeaderIndex;
 class HeaderSearchOptions;
 class IdentifierInfo;
 
@@ -215,6 +216,10 @@ class HeaderSearch {
   /// name like "Carbon" to the Carbon.framework directory.
   llvm::StringMap<FrameworkCacheEntry, llvm::BumpPtrAllocator> FrameworkMap;
 
+  /// \brief The index of the headers in the framework search directories,
+  /// consulted by DirectoryLookup before probing a framework directory.
+  std::unique_ptr<FrameworkHeaderIndex> FrameworkIndex;
+
   /// IncludeAliases - maps include file names (including the quotes or
   /// angle brackets) to other include file names.  This is used to support the
   /// include_alias pragma for Microsoft compatibility.
@@ -352,6 +357,20 @@ public:
   void SetExternalSource(ExternalHeaderFileInfoSource *ES) {
     ExternalSource = ES;
   }
+
+  /// \brief Set the index of framework headers to use for framework lookups;
+  /// HeaderSearch takes ownership.
+  void setFrameworkHeaderIndex(FrameworkHeaderIndex *Index);
+
+  /// \brief Retrieve the index of framework headers, if any.
+  FrameworkHeaderIndex *getFrameworkHeaderIndex() const {
+    return FrameworkIndex.get();
+  }
+
+  /// \brief Retrieve the external source of header file information, if any.
+  ExternalHeaderFileInfoSource *getExternalSource() const {
+    return ExternalSource;
+  }
   
   /// \brief Set the target information for the header search, if not
   /// already known.
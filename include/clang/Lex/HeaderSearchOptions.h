@@ -92,6 +92,16 @@ public:
   /// \brief The directory used for a user build.
   std::string ModuleUserBuildPath;
 
+  /// \brief The directory holding the include guard cache shared by the
+  /// translation units of a build session, or empty to disable it. See
+  /// \c HeaderGuardCache; requires \c BuildSessionTimestamp.
+  std::string HeaderGuardCachePath;
+
+  /// \brief The directory holding the index of framework headers shared by
+  /// the translation units of a build session, or empty to disable it. See
+  /// \c FrameworkHeaderIndex; requires \c BuildSessionTimestamp.
+  std::string FrameworkIndexPath;
+
   /// \brief Whether we should disable the use of the hash string within the
   /// module cache.
   ///
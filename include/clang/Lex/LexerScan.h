@@ -0,0 +1,167 @@
+//===--- LexerScan.h - Vectorized lexer scanning ----------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the scanning kernels behind the Lexer's fast paths for
+/// identifiers, horizontal whitespace and block comments, which process 16
+/// bytes at a time with SSE2 or NEON where available.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_LEXERSCAN_H
+#define LLVM_CLANG_LEX_LEXERSCAN_H
+
+#include "clang/Basic/CharInfo.h"
+#include "llvm/Support/MathExtras.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CLANG_LEXER_SCAN_SSE2 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CLANG_LEXER_SCAN_NEON 1
+#endif
+
+namespace clang {
+namespace lexscan {
+
+/// The number of bytes the vector kernels process at a time.
+enum { ChunkSize = 16 };
+
+#if defined(CLANG_LEXER_SCAN_SSE2)
+/// \brief Return the index of the first byte of the chunk at \p Ptr for
+/// which \p Matches does not hold, or ChunkSize if it holds for all of them.
+template <typename MatchFn>
+inline unsigned findFirstMismatch(const char *Ptr, MatchFn Matches) {
+  __m128i Chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+  unsigned Mask = ~_mm_movemask_epi8(Matches(Chunk)) & 0xFFFF;
+  return Mask ? llvm::countTrailingZeros(Mask) : unsigned(ChunkSize);
+}
+
+/// Byte-wise Lo <= C <= Hi, for ASCII bounds; bytes >= 0x80 compare as
+/// negative and never match.
+inline __m128i inRange(__m128i C, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(C, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(Hi + 1), C));
+}
+
+inline __m128i equals(__m128i C, char Value) {
+  return _mm_cmpeq_epi8(C, _mm_set1_epi8(Value));
+}
+
+inline __m128i either(__m128i A, __m128i B) { return _mm_or_si128(A, B); }
+inline __m128i negate(__m128i A) {
+  return _mm_xor_si128(A, _mm_set1_epi8(-1));
+}
+#elif defined(CLANG_LEXER_SCAN_NEON)
+template <typename MatchFn>
+inline unsigned findFirstMismatch(const char *Ptr, MatchFn Matches) {
+  uint8x16_t Chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(Ptr));
+  uint8x16_t Mismatch = vmvnq_u8(Matches(Chunk));
+  // Narrow each byte to a nibble, leaving a 64-bit mask with 4 bits per
+  // byte: NEON has no movemask.
+  uint8x8_t Narrowed = vshrn_n_u16(vreinterpretq_u16_u8(Mismatch), 4);
+  uint64_t Mask = vget_lane_u64(vreinterpret_u64_u8(Narrowed), 0);
+  return Mask ? llvm::countTrailingZeros(Mask) / 4 : unsigned(ChunkSize);
+}
+
+inline uint8x16_t inRange(uint8x16_t C, char Lo, char Hi) {
+  return vandq_u8(vcgeq_u8(C, vdupq_n_u8(Lo)), vcleq_u8(C, vdupq_n_u8(Hi)));
+}
+
+inline uint8x16_t equals(uint8x16_t C, char Value) {
+  return vceqq_u8(C, vdupq_n_u8(Value));
+}
+
+inline uint8x16_t either(uint8x16_t A, uint8x16_t B) { return vorrq_u8(A, B); }
+inline uint8x16_t negate(uint8x16_t A) { return vmvnq_u8(A); }
+#endif
+
+#if defined(CLANG_LEXER_SCAN_SSE2) || defined(CLANG_LEXER_SCAN_NEON)
+struct IsIdentifierBody {
+  template <typename VecTy> VecTy operator()(VecTy C) const {
+    return either(either(inRange(C, 'a', 'z'), inRange(C, 'A', 'Z')),
+                  either(inRange(C, '0', '9'), equals(C, '_')));
+  }
+};
+
+struct IsHorizontalWhitespace {
+  template <typename VecTy> VecTy operator()(VecTy C) const {
+    // ' ', '\t', and '\v' '\f', which are adjacent.
+    return either(either(equals(C, ' '), equals(C, '\t')),
+                  inRange(C, '\v', '\f'));
+  }
+};
+
+struct IsNotSlashOrNull {
+  template <typename VecTy> VecTy operator()(VecTy C) const {
+    return negate(either(equals(C, '/'), equals(C, 0)));
+  }
+};
+
+/// \brief Advance \p Ptr over the bytes for which \p Matches holds, a chunk
+/// at a time while a whole chunk fits before \p End.
+template <typename MatchFn>
+inline const char *skipChunks(const char *Ptr, const char *End,
+                              MatchFn Matches) {
+  while (End - Ptr >= ChunkSize) {
+    unsigned Index = findFirstMismatch(Ptr, Matches);
+    Ptr += Index;
+    if (Index != ChunkSize)
+      break;
+  }
+  return Ptr;
+}
+#endif
+
+/// \brief Return a pointer to the first character at or after \p Ptr which is
+/// not an ASCII identifier body character [a-zA-Z0-9_].
+///
+/// \p End is the end of the buffer, which must be null terminated; no bytes
+/// at or past \p End are read.  The Lexer handles '$', '\\', '?' and UCNs on
+/// its slow path once this stops.
+inline const char *skipIdentifierBody(const char *Ptr, const char *End) {
+#if defined(CLANG_LEXER_SCAN_SSE2) || defined(CLANG_LEXER_SCAN_NEON)
+  Ptr = skipChunks(Ptr, End, IsIdentifierBody());
+#endif
+  while (isIdentifierBody(*Ptr))
+    ++Ptr;
+  return Ptr;
+}
+
+/// \brief Return a pointer to the first character at or after \p Ptr which is
+/// not horizontal whitespace (' ', '\\t', '\\f', '\\v').
+inline const char *skipHorizontalWhitespace(const char *Ptr,
+                                            const char *End) {
+#if defined(CLANG_LEXER_SCAN_SSE2) || defined(CLANG_LEXER_SCAN_NEON)
+  Ptr = skipChunks(Ptr, End, IsHorizontalWhitespace());
+#endif
+  while (isHorizontalWhitespace(*Ptr))
+    ++Ptr;
+  return Ptr;
+}
+
+/// \brief Return a pointer to the first '/' or null character at or after
+/// \p Ptr.  '/' is the only character a block comment can end on, so the
+/// Lexer checks for the preceding '*' (and any escaped newline) from there;
+/// a null is either the end of the buffer or an embedded null, which the
+/// Lexer diagnoses.
+inline const char *findSlash(const char *Ptr, const char *End) {
+#if defined(CLANG_LEXER_SCAN_SSE2) || defined(CLANG_LEXER_SCAN_NEON)
+  Ptr = skipChunks(Ptr, End, IsNotSlashOrNull());
+#endif
+  while (*Ptr != '/' && *Ptr != 0)
+    ++Ptr;
+  return Ptr;
+}
+
+} // end namespace lexscan
+} // end namespace clang
+
+#endif
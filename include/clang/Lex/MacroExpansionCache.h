@@ -0,0 +1,251 @@
+//===--- MacroExpansionCache.h - Memoized macro expansions ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the MacroExpansionCache class, which memoizes the results
+/// of macro expansions for the Preprocessor.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_MACROEXPANSIONCACHE_H
+#define LLVM_CLANG_LEX_MACROEXPANSIONCACHE_H
+
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/Token.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include <utility>
+
+namespace clang {
+
+/// \brief Memoizes the fully expanded token sequences of macro invocations,
+/// keyed by the invoked MacroInfo and the spelling of its arguments.
+///
+/// Availability and linkage macros such as NS_AVAILABLE_IOS(x) or NS_ENUM(T,
+/// N) are expanded with the same arguments tens of thousands of times per
+/// translation unit, and each expansion pre-expands the arguments, rescans
+/// and pastes all over again.  The Preprocessor records the tokens an
+/// outermost expansion produces, and replays them for later invocations with
+/// the same key instead of expanding again.
+///
+/// A recorded expansion depends on more than its key: on the definitions of
+/// the nested macros it expanded, and on the identifiers it produced not
+/// being macros.  Both are checked on lookup, and stale entries are dropped.
+/// An expansion is not recorded if it expands a builtin macro whose value
+/// depends on where it is expanded (__LINE__, __COUNTER__, _Pragma and the
+/// like), if it ends in an unexpanded function-like macro name (whose
+/// expansion would depend on the tokens after the invocation), or if it is
+/// too long to be worth keeping.
+///
+/// The recorded tokens are located at their spelling locations; on replay,
+/// the Preprocessor gives them expansion locations for the new invocation,
+/// and the flags of the invocation's macro name to the first of them.
+class MacroExpansionCache {
+public:
+  struct Expansion {
+    /// The tokens the expansion produced.
+    SmallVector<Token, 16> Tokens;
+
+    /// The macros expanded, including the invoked one, with the definitions
+    /// that were current when the expansion was recorded.
+    SmallVector<std::pair<IdentifierInfo *, const MacroInfo *>, 4> Macros;
+
+    /// The identifiers produced that were not macros.
+    SmallVector<IdentifierInfo *, 8> NonMacros;
+  };
+
+  enum {
+    /// The longest expansion that is recorded, in tokens.
+    MaxExpansionTokens = 512
+  };
+
+private:
+  llvm::StringMap<Expansion> Expansions;
+
+  /// The expansion being recorded and its key, if Recording.
+  Expansion Current;
+  SmallString<128> CurrentKey;
+  bool Recording;
+  /// Whether the last token of Current is an unexpanded macro name.
+  bool CurrentEndsInMacroName;
+
+  unsigned NumLookups, NumHits, NumStale, NumRecorded, NumUncacheable;
+
+  static void appendBytes(SmallVectorImpl<char> &Key, const void *Data,
+                          size_t Size) {
+    const char *Bytes = static_cast<const char *>(Data);
+    Key.append(Bytes, Bytes + Size);
+  }
+
+  static bool isValid(const Preprocessor &PP, const Expansion &E) {
+    for (unsigned i = 0, e = E.Macros.size(); i != e; ++i)
+      if (PP.getMacroInfo(E.Macros[i].first) != E.Macros[i].second)
+        return false;
+    for (unsigned i = 0, e = E.NonMacros.size(); i != e; ++i)
+      if (E.NonMacros[i]->hasMacroDefinition())
+        return false;
+    return true;
+  }
+
+public:
+  MacroExpansionCache()
+    : Recording(false), CurrentEndsInMacroName(false), NumLookups(0),
+      NumHits(0), NumStale(0), NumRecorded(0), NumUncacheable(0) {}
+
+  /// \brief Compute the key of an invocation of \p MI.
+  ///
+  /// \param ArgTokens The unexpanded argument tokens, each argument terminated
+  /// by an eof token as in MacroArgs; empty for object-like macros.
+  ///
+  /// \returns false if the arguments cannot be keyed (they contain
+  /// annotation tokens), in which case the invocation must be expanded
+  /// normally.
+  static bool computeKey(const Preprocessor &PP, const MacroInfo *MI,
+                         ArrayRef<Token> ArgTokens,
+                         SmallVectorImpl<char> &Key) {
+    Key.clear();
+    appendBytes(Key, &MI, sizeof(MI));
+    SmallString<64> SpellingBuffer;
+    for (unsigned i = 0, e = ArgTokens.size(); i != e; ++i) {
+      const Token &Tok = ArgTokens[i];
+      if (Tok.isAnnotation())
+        return false;
+      uint16_t Kind = Tok.getKind();
+      // Stringizing sees the leading whitespace of argument tokens.
+      char Flags = Tok.hasLeadingSpace() | Tok.isAtStartOfLine() << 1;
+      appendBytes(Key, &Kind, sizeof(Kind));
+      Key.push_back(Flags);
+      // The eof tokens that end the arguments are not spelled in the source.
+      if (Tok.is(tok::eof))
+        continue;
+      // The kind does not tell apart the spellings of a punctuator, such as
+      // a digraph and its token, which stringizing and pasting see, so key
+      // on the spelling of every token.
+      StringRef Spelling = PP.getSpelling(Tok, SpellingBuffer);
+      uint32_t Size = Spelling.size();
+      appendBytes(Key, &Size, sizeof(Size));
+      Key.append(Spelling.begin(), Spelling.end());
+    }
+    return true;
+  }
+
+  /// \brief Find the recorded expansion for \p Key, if it is still valid.
+  const Expansion *lookup(const Preprocessor &PP, StringRef Key) {
+    ++NumLookups;
+    llvm::StringMap<Expansion>::iterator I = Expansions.find(Key);
+    if (I == Expansions.end())
+      return 0;
+    if (!isValid(PP, I->second)) {
+      ++NumStale;
+      Expansions.erase(I);
+      return 0;
+    }
+    ++NumHits;
+    return &I->second;
+  }
+
+  /// \brief Whether an expansion is being recorded.  Nested invocations are
+  /// neither looked up nor recorded separately while one is.
+  bool isRecording() const { return Recording; }
+
+  /// \brief Start recording the expansion of the invocation of \p II (whose
+  /// definition is \p MI) described by \p Key.
+  void startRecording(StringRef Key, IdentifierInfo *II, const MacroInfo *MI) {
+    assert(!Recording && "Already recording an expansion");
+    Recording = true;
+    CurrentKey = Key;
+    CurrentEndsInMacroName = false;
+    Current = Expansion();
+    Current.Macros.push_back(std::make_pair(II, MI));
+  }
+
+  /// \brief Note that the expansion being recorded expanded the nested macro
+  /// \p II, defined by \p MI.
+  void noteMacroExpanded(IdentifierInfo *II, const MacroInfo *MI) {
+    if (Recording)
+      Current.Macros.push_back(std::make_pair(II, MI));
+  }
+
+  /// \brief Note that the expansion being recorded expanded a builtin macro.
+  ///
+  /// \param IsDeterministic Whether the builtin's value is the same wherever
+  /// it is expanded, as for __has_feature.
+  void noteBuiltinExpanded(bool IsDeterministic) {
+    if (!IsDeterministic)
+      abandonRecording();
+  }
+
+  /// \brief Append a token produced by the expansion being recorded.
+  void noteToken(const Preprocessor &PP, const Token &Tok) {
+    if (!Recording)
+      return;
+    if (Current.Tokens.size() == MaxExpansionTokens || Tok.isAnnotation()) {
+      abandonRecording();
+      return;
+    }
+    CurrentEndsInMacroName = false;
+    if (IdentifierInfo *II = Tok.getIdentifierInfo()) {
+      if (!II->hasMacroDefinition()) {
+        Current.NonMacros.push_back(II);
+      } else if (!Tok.isExpandDisabled()) {
+        // A function-like macro name that was not followed by '(', which
+        // must stay a macro for the expansion to stay the same.
+        Current.Macros.push_back(std::make_pair(II, PP.getMacroInfo(II)));
+        CurrentEndsInMacroName = true;
+      }
+    }
+    Current.Tokens.push_back(Tok);
+    Current.Tokens.back().setLocation(
+        PP.getSourceManager().getSpellingLoc(Tok.getLocation()));
+  }
+
+  /// \brief Stop recording without storing the expansion.
+  void abandonRecording() {
+    if (!Recording)
+      return;
+    Recording = false;
+    ++NumUncacheable;
+  }
+
+  /// \brief Store the completed expansion being recorded, if it was not
+  /// abandoned.
+  void finishRecording() {
+    // If the expansion ends in a function-like macro name, whether that is
+    // invoked depends on the tokens after the invocation.
+    if (CurrentEndsInMacroName)
+      abandonRecording();
+    if (!Recording)
+      return;
+    Recording = false;
+    ++NumRecorded;
+    Expansions[CurrentKey] = Current;
+  }
+
+  unsigned getNumLookups() const { return NumLookups; }
+  unsigned getNumHits() const { return NumHits; }
+
+  void printStats(raw_ostream &OS) const {
+    OS << "  " << Expansions.size() << " memoized macro expansions, "
+       << NumRecorded << " recorded, " << NumUncacheable << " uncacheable.\n";
+    OS << "  " << NumLookups << " lookups, " << NumHits << " hits ("
+       << (NumLookups ? NumHits * 100 / NumLookups : 0) << "%), " << NumStale
+       << " stale.\n";
+  }
+};
+
+} // end namespace clang
+
+#endif
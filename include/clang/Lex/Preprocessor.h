@@ -32,6 +32,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/StatsJSONWriter.h"
 #include <memory>
 #include <vector>
 
@@ -57,6 +58,7 @@ class DirectoryLookup;
 class PreprocessingRecord;
 class ModuleLoader;
 class PreprocessorOptions;
+class MacroExpansionCache;
 
 /// \brief Stores token information for comparing actual tokens with
 /// predefined values.  Only handles simple tokens and identifiers.
@@ -108,6 +110,10 @@ class Preprocessor : public RefCountedBase<Preprocessor> {
   /// objects internal to the Preprocessor.
   llvm::BumpPtrAllocator BP;
 
+  /// \brief The memoized macro expansions, if
+  /// PreprocessorOptions::MemoizeMacroExpansions is set.
+  std::unique_ptr<MacroExpansionCache> ExpansionCache;
+
   /// Identifiers for builtin macros and other builtins.
   IdentifierInfo *Ident__LINE__, *Ident__FILE__;   // __LINE__, __FILE__
   IdentifierInfo *Ident__DATE__, *Ident__TIME__;   // __DATE__, __TIME__
@@ -1172,8 +1178,37 @@ public:
 
   void PrintStats();
 
+  /// \brief Add the counters that PrintStats prints to the current object of
+  /// \p W, for -stats-file.
+  void PrintStatsJSON(llvm::StatsJSONWriter &W) const {
+    W.value("directives", NumDirectives);
+    W.value("includes", NumIncluded);
+    W.value("defines", NumDefined);
+    W.value("undefs", NumUndefined);
+    W.value("pragmas", NumPragma);
+    W.value("conditionals", NumIf);
+    W.value("elses", NumElse);
+    W.value("endifs", NumEndif);
+    W.value("skipped", NumSkipped);
+    W.value("entered_source_files", NumEnteredSourceFiles);
+    W.value("max_include_stack_depth", MaxIncludeStackDepth);
+    W.value("macros_expanded", NumMacroExpanded);
+    W.value("function_macros_expanded", NumFnMacroExpanded);
+    W.value("builtin_macros_expanded", NumBuiltinMacroExpanded);
+    W.value("fast_macros_expanded", NumFastMacroExpanded);
+    W.value("token_pastes", NumTokenPaste);
+    W.value("fast_token_pastes", NumFastTokenPaste);
+    W.value("memory", getTotalMemory());
+  }
+
   size_t getTotalMemory() const;
 
+  /// \brief Retrieve the memoized macro expansions, or null if expansions
+  /// are not memoized.
+  MacroExpansionCache *getMacroExpansionCache() const {
+    return ExpansionCache.get();
+  }
+
   /// When the macro expander pastes together a comment (/##/) in Microsoft
   /// mode, this method handles updating the current state, returning the
   /// token on the next source line.
@@ -71,6 +71,22 @@ public:
   /// \brief Dump declarations that are deserialized from PCH, for testing.
   bool DumpDeserializedPCHDecls;
 
+  /// \brief When true, the identifier and selector tables of the PCH are only
+  /// loaded on first lookup.
+  bool DeferPCHTableLoading;
+
+  /// \brief When true, the results of macro expansions are memoized and
+  /// replayed for later invocations with the same arguments.
+  bool MemoizeMacroExpansions;
+
+  /// \brief The deserialization profile naming the PCH identifiers and
+  /// selectors to preload when table loading is deferred, or empty.
+  std::string PCHDeserializationProfile;
+
+  /// \brief If not empty, the file to which the identifiers and selectors
+  /// deserialized from the PCH are appended, in the profile format.
+  std::string PCHDeserializationProfileOutput;
+
   /// \brief This is a set of names for decls that we do not want to be
   /// deserialized, and we emit an error if they are; for testing purposes.
   std::set<std::string> DeserializedPCHDeclsToErrorOn;
@@ -179,6 +195,8 @@ public:
                           DisablePCHValidation(false),
                           AllowPCHWithCompilerErrors(false),
                           DumpDeserializedPCHDecls(false),
+                          DeferPCHTableLoading(false),
+                          MemoizeMacroExpansions(false),
                           PrecompiledPreambleBytes(0, true),
                           RemappedFilesKeepOriginalName(true),
                           RetainRemappedFileBuffers(false),
@@ -219,6 +237,9 @@ public:
     MacroIncludes.clear();
     ChainedIncludes.clear();
     DumpDeserializedPCHDecls = false;
+    DeferPCHTableLoading = false;
+    PCHDeserializationProfile.clear();
+    PCHDeserializationProfileOutput.clear();
     ImplicitPCHInclude.clear();
     ImplicitPTHInclude.clear();
     TokenCache.clear();
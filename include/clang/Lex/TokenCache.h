@@ -0,0 +1,487 @@
+//===--- TokenCache.h - Memory-mapped pre-tokenized files -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the TokenCacheWriter and TokenCache classes, a
+/// pre-tokenized header cache that supersedes PTH.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_TOKENCACHE_H
+#define LLVM_CLANG_LEX_TOKENCACHE_H
+
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/Token.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+/// \brief The on-disk layout shared by TokenCacheWriter and TokenCache.
+///
+/// Everything is little-endian and 4-byte aligned, so the reader works on the
+/// mapped file in place:
+///
+///   Header        magic, version, file count, string count, and the offsets
+///                 of the file table and the string table
+///   Tokens        per file, an array of token records
+///   Conditionals  per file, sorted (directive, next directive) index pairs
+///   Strings       offset/length pairs, then the string bytes: paths,
+///                 identifier names and literal spellings, raw and cleaned,
+///                 each stored once
+///   Files         one record per file
+///
+/// Unlike PTH, tokens are stored raw, exactly as the raw lexer produces them
+/// (no keywords, no macro expansion), so one cache serves every language
+/// dialect, module configuration and predefined-macro set; the client
+/// resolves identifiers and evaluates directives itself.
+namespace tokencache {
+
+enum {
+  Magic = 0x434B5443, // 'CTKC'
+  Version = 2,
+  HeaderSize = 24,
+  TokenSize = 20,
+  FileRecordSize = 40,
+  /// The Spelling of a token record without a string.
+  NoString = 0
+};
+
+/// \brief A token as stored in the cache.
+struct CachedToken {
+  /// Offset of the token in its file.
+  uint32_t Offset;
+  /// The length of the token in the file, including escaped newlines.
+  uint32_t Length;
+  /// For identifiers and literals, 1 + the index in the string table of the
+  /// spelling exactly as it appears in the file, Length bytes long;
+  /// otherwise NoString.
+  uint32_t Spelling;
+  /// For identifiers and literals, 1 + the index of the cleaned spelling,
+  /// which is Spelling unless the token needs cleaning; otherwise NoString.
+  uint32_t CleanSpelling;
+  /// The tok::TokenKind, as lexed in raw mode.
+  uint16_t Kind;
+  /// The Token::TokenFlags.
+  uint16_t Flags;
+};
+
+inline uint32_t read32(const char *P) {
+  return llvm::support::endian::read<uint32_t, llvm::support::little,
+                                     llvm::support::aligned>(P);
+}
+
+inline uint64_t read64(const char *P) {
+  return llvm::support::endian::read<uint64_t, llvm::support::little,
+                                     llvm::support::unaligned>(P);
+}
+
+inline void write32(raw_ostream &OS, uint32_t V) {
+  char Buf[4];
+  llvm::support::endian::write<uint32_t, llvm::support::little,
+                               llvm::support::unaligned>(Buf, V);
+  OS.write(Buf, 4);
+}
+
+inline void write64(raw_ostream &OS, uint64_t V) {
+  write32(OS, uint32_t(V));
+  write32(OS, uint32_t(V >> 32));
+}
+
+/// \brief Whether \p Name is a conditional directive, and whether it opens,
+/// continues or closes a conditional block.
+enum CondKind { CK_None, CK_If, CK_Else, CK_Endif };
+
+inline CondKind getCondKind(StringRef Name) {
+  if (Name == "if" || Name == "ifdef" || Name == "ifndef")
+    return CK_If;
+  if (Name == "elif" || Name == "else")
+    return CK_Else;
+  if (Name == "endif")
+    return CK_Endif;
+  return CK_None;
+}
+
+} // end namespace tokencache
+
+/// \brief Tokenizes files and writes them to a token cache.
+class TokenCacheWriter {
+  struct FileData {
+    uint32_t Path;
+    uint64_t Size, ModTime;
+    std::vector<tokencache::CachedToken> Tokens;
+    std::vector<std::pair<uint32_t, uint32_t> > Conditionals;
+  };
+
+  std::vector<std::string> Strings;
+  llvm::StringMap<uint32_t> StringIDs;
+  std::vector<FileData> Files;
+
+  uint32_t getString(StringRef S) {
+    llvm::StringMap<uint32_t>::iterator I = StringIDs.find(S);
+    if (I != StringIDs.end())
+      return I->second;
+    Strings.push_back(S);
+    StringIDs[S] = Strings.size();
+    return Strings.size();
+  }
+
+public:
+  /// \brief Raw-lex the file \p FID and add its tokens to the cache.
+  ///
+  /// \returns false if the file has no FileEntry or its buffer is invalid.
+  bool addFile(const SourceManager &SM, FileID FID,
+               const LangOptions &LangOpts) {
+    using namespace tokencache;
+    const FileEntry *FE = SM.getFileEntryForID(FID);
+    bool Invalid = false;
+    const llvm::MemoryBuffer *Buffer = SM.getBuffer(FID, &Invalid);
+    if (!FE || Invalid)
+      return false;
+
+    Files.push_back(FileData());
+    FileData &FD = Files.back();
+    FD.Path = getString(FE->getName());
+    FD.Size = FE->getSize();
+    FD.ModTime = FE->getModificationTime();
+
+    Lexer L(FID, Buffer, SM, LangOpts);
+    L.SetCommentRetentionState(false);
+
+    // For each open conditional, the index of the '#' of its most recent
+    // directive.
+    std::vector<uint32_t> Open;
+    bool AfterHash = false;
+    Token Tok;
+    do {
+      L.LexFromRawLexer(Tok);
+      CachedToken CT;
+      CT.Offset = SM.getFileOffset(Tok.getLocation());
+      CT.Length = Tok.getLength();
+      CT.Kind = Tok.getKind();
+      CT.Flags = Tok.getFlags();
+      CT.Spelling = CT.CleanSpelling = NoString;
+      if (Tok.is(tok::raw_identifier) || Tok.isLiteral()) {
+        CT.Spelling = CT.CleanSpelling = getString(
+            StringRef(Buffer->getBufferStart() + CT.Offset, CT.Length));
+        if (Tok.needsCleaning())
+          CT.CleanSpelling = getString(Lexer::getSpelling(Tok, SM, LangOpts));
+      }
+
+      uint32_t Index = FD.Tokens.size();
+      if (AfterHash && Tok.is(tok::raw_identifier)) {
+        CondKind K = getCondKind(Strings[CT.CleanSpelling - 1]);
+        uint32_t Hash = Index - 1;
+        if (K == CK_If) {
+          Open.push_back(Hash);
+        } else if ((K == CK_Else || K == CK_Endif) && !Open.empty()) {
+          FD.Conditionals.push_back(std::make_pair(Open.back(), Hash));
+          if (K == CK_Else)
+            Open.back() = Hash;
+          else
+            Open.pop_back();
+        }
+      }
+      AfterHash = Tok.is(tok::hash) && Tok.isAtStartOfLine();
+      FD.Tokens.push_back(CT);
+    } while (Tok.isNot(tok::eof));
+
+    std::sort(FD.Conditionals.begin(), FD.Conditionals.end());
+    return true;
+  }
+
+  /// \brief Write the cache.
+  void emit(raw_ostream &OS) const {
+    using namespace tokencache;
+    uint64_t Pos = HeaderSize;
+    std::vector<uint32_t> TokenOffsets, CondOffsets;
+    for (unsigned i = 0, e = Files.size(); i != e; ++i) {
+      TokenOffsets.push_back(Pos);
+      Pos += Files[i].Tokens.size() * TokenSize;
+      CondOffsets.push_back(Pos);
+      Pos += Files[i].Conditionals.size() * 8;
+    }
+    uint32_t StringTableOffset = Pos;
+    uint32_t StringDataOffset = Pos + Strings.size() * 8;
+    uint64_t StringDataSize = 0;
+    for (unsigned i = 0, e = Strings.size(); i != e; ++i)
+      StringDataSize += Strings[i].size();
+    uint32_t FileTableOffset =
+        (StringDataOffset + StringDataSize + 3) & ~uint64_t(3);
+
+    write32(OS, Magic);
+    write32(OS, Version);
+    write32(OS, Files.size());
+    write32(OS, Strings.size());
+    write32(OS, StringTableOffset);
+    write32(OS, FileTableOffset);
+
+    for (unsigned i = 0, e = Files.size(); i != e; ++i) {
+      const FileData &FD = Files[i];
+      for (unsigned t = 0, te = FD.Tokens.size(); t != te; ++t) {
+        const CachedToken &CT = FD.Tokens[t];
+        write32(OS, CT.Offset);
+        write32(OS, CT.Length);
+        write32(OS, CT.Spelling);
+        write32(OS, CT.CleanSpelling);
+        write32(OS, uint32_t(CT.Kind) | uint32_t(CT.Flags) << 16);
+      }
+      for (unsigned c = 0, ce = FD.Conditionals.size(); c != ce; ++c) {
+        write32(OS, FD.Conditionals[c].first);
+        write32(OS, FD.Conditionals[c].second);
+      }
+    }
+
+    uint32_t Offset = StringDataOffset;
+    for (unsigned i = 0, e = Strings.size(); i != e; ++i) {
+      write32(OS, Offset);
+      write32(OS, Strings[i].size());
+      Offset += Strings[i].size();
+    }
+    for (unsigned i = 0, e = Strings.size(); i != e; ++i)
+      OS << Strings[i];
+    for (uint64_t P = StringDataOffset + StringDataSize; P != FileTableOffset;
+         ++P)
+      OS << '\0';
+
+    for (unsigned i = 0, e = Files.size(); i != e; ++i) {
+      const FileData &FD = Files[i];
+      write32(OS, FD.Path);
+      write32(OS, TokenOffsets[i]);
+      write32(OS, FD.Tokens.size());
+      write32(OS, CondOffsets[i]);
+      write32(OS, FD.Conditionals.size());
+      write32(OS, 0); // Padding.
+      write64(OS, FD.Size);
+      write64(OS, FD.ModTime);
+    }
+  }
+};
+
+/// \brief A memory-mapped token cache written by TokenCacheWriter.
+///
+/// Loading maps the file, checks that the file and string tables lie within
+/// it, and indexes the file table by path.  The tokens of a file are checked
+/// against the string table when getFile() first returns them; afterwards
+/// tokens, skip tables and spellings are read from the mapping as they are
+/// used.
+class TokenCache {
+public:
+  /// \brief The cached tokens of one file.
+  class File {
+    const TokenCache *Cache;
+    const char *Tokens, *Conditionals;
+    uint32_t NumTokens, NumConditionals;
+    friend class TokenCache;
+
+  public:
+    File() : Cache(0), Tokens(0), Conditionals(0), NumTokens(0),
+             NumConditionals(0) {}
+
+    bool isValid() const { return Cache != 0; }
+    unsigned size() const { return NumTokens; }
+
+    tokencache::CachedToken getToken(unsigned Index) const {
+      using namespace tokencache;
+      const char *P = Tokens + Index * TokenSize;
+      CachedToken CT;
+      CT.Offset = read32(P);
+      CT.Length = read32(P + 4);
+      CT.Spelling = read32(P + 8);
+      CT.CleanSpelling = read32(P + 12);
+      uint32_t KindAndFlags = read32(P + 16);
+      CT.Kind = KindAndFlags & 0xFFFF;
+      CT.Flags = KindAndFlags >> 16;
+      return CT;
+    }
+
+    /// \brief The cleaned spelling of an identifier or literal token.
+    StringRef getSpelling(const tokencache::CachedToken &CT) const {
+      return Cache->getString(CT.CleanSpelling);
+    }
+
+    /// \brief Fill in \p Result from token \p Index, as the raw lexer would
+    /// have produced it for the file starting at \p FileStart.
+    ///
+    /// Identifiers are resolved in \p Idents by their cleaned spelling and
+    /// get the token kind of the identifier (so keywords become keyword
+    /// tokens).  Literals point to their raw spelling in the mapped cache,
+    /// which is getLength() bytes long, and keep NeedsCleaning, so that
+    /// Lexer::getSpelling cleans them as it would tokens of the file.
+    void getToken(unsigned Index, SourceLocation FileStart,
+                  IdentifierTable &Idents, Token &Result) const {
+      tokencache::CachedToken CT = getToken(Index);
+      Result.startToken();
+      Result.setLocation(FileStart.getLocWithOffset(CT.Offset));
+      Result.setLength(CT.Length);
+      Result.setFlag(Token::TokenFlags(CT.Flags));
+      tok::TokenKind Kind = tok::TokenKind(CT.Kind);
+      if (Kind == tok::raw_identifier) {
+        IdentifierInfo &II = Idents.get(getSpelling(CT));
+        Result.setIdentifierInfo(&II);
+        Result.setKind(II.getTokenID());
+      } else {
+        Result.setKind(Kind);
+        if (Result.isLiteral())
+          Result.setLiteralData(Cache->getString(CT.Spelling).data());
+      }
+    }
+
+    /// \brief Given the index of the '#' of a conditional directive, return
+    /// the index of the '#' of the next directive of the same conditional
+    /// (\#elif, \#else or \#endif), which is where a skipped block ends, or 0
+    /// if there is none.
+    unsigned getNextConditional(unsigned HashIndex) const {
+      unsigned Lo = 0, Hi = NumConditionals;
+      while (Lo < Hi) {
+        unsigned Mid = Lo + (Hi - Lo) / 2;
+        uint32_t Key = tokencache::read32(Conditionals + Mid * 8);
+        if (Key == HashIndex)
+          return tokencache::read32(Conditionals + Mid * 8 + 4);
+        if (Key < HashIndex)
+          Lo = Mid + 1;
+        else
+          Hi = Mid;
+      }
+      return 0;
+    }
+  };
+
+private:
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  uint32_t NumStrings, StringTableOffset;
+  llvm::StringMap<const char *> FileRecords;
+  /// The file records whose tokens have been checked, and whether they were
+  /// valid.
+  mutable llvm::DenseMap<const char *, bool> CheckedFiles;
+
+  TokenCache() : NumStrings(0), StringTableOffset(0) {}
+
+  /// \brief Whether every token of \p Record refers to strings that exist,
+  /// with a raw spelling as long as the token.
+  bool checkTokens(const char *Record) const {
+    using namespace tokencache;
+    File F;
+    F.Cache = this;
+    F.Tokens = Buffer->getBufferStart() + read32(Record + 4);
+    F.NumTokens = read32(Record + 8);
+    for (unsigned i = 0; i != F.NumTokens; ++i) {
+      CachedToken CT = F.getToken(i);
+      if (CT.Spelling > NumStrings || CT.CleanSpelling > NumStrings ||
+          (CT.Spelling == NoString) != (CT.CleanSpelling == NoString))
+        return false;
+      if (CT.Spelling != NoString && getString(CT.Spelling).size() != CT.Length)
+        return false;
+    }
+    return true;
+  }
+
+  StringRef getString(uint32_t ID) const {
+    if (ID == tokencache::NoString || ID > NumStrings)
+      return StringRef();
+    const char *Entry =
+        Buffer->getBufferStart() + StringTableOffset + (ID - 1) * 8;
+    return StringRef(Buffer->getBufferStart() + tokencache::read32(Entry),
+                     tokencache::read32(Entry + 4));
+  }
+
+public:
+  /// \brief Map and validate the token cache \p Path.
+  ///
+  /// \returns null if the file cannot be read or is not a valid cache.
+  static TokenCache *load(StringRef Path) {
+    using namespace tokencache;
+    std::unique_ptr<TokenCache> Cache(new TokenCache);
+    if (llvm::MemoryBuffer::getFile(Path, Cache->Buffer, -1,
+                                    /*RequiresNullTerminator=*/false))
+      return 0;
+    const char *Base = Cache->Buffer->getBufferStart();
+    uint64_t Size = Cache->Buffer->getBufferSize();
+    if (Size < HeaderSize || read32(Base) != Magic ||
+        read32(Base + 4) != Version)
+      return 0;
+    uint32_t NumFiles = read32(Base + 8);
+    Cache->NumStrings = read32(Base + 12);
+    Cache->StringTableOffset = read32(Base + 16);
+    uint32_t FileTableOffset = read32(Base + 20);
+    if (Cache->StringTableOffset + uint64_t(Cache->NumStrings) * 8 > Size ||
+        FileTableOffset + uint64_t(NumFiles) * FileRecordSize > Size ||
+        FileTableOffset % 4)
+      return 0;
+
+    // Every string must lie between the string table and the file table, so
+    // that no spelling runs past the end of the mapping.
+    uint64_t StringDataOffset =
+        Cache->StringTableOffset + uint64_t(Cache->NumStrings) * 8;
+    for (uint32_t i = 0; i != Cache->NumStrings; ++i) {
+      const char *Entry = Base + Cache->StringTableOffset + i * 8;
+      uint32_t Offset = read32(Entry);
+      if (Offset < StringDataOffset ||
+          Offset + uint64_t(read32(Entry + 4)) > FileTableOffset)
+        return 0;
+    }
+
+    for (uint32_t i = 0; i != NumFiles; ++i) {
+      const char *Record = Base + FileTableOffset + i * FileRecordSize;
+      if (read32(Record + 4) + uint64_t(read32(Record + 8)) * TokenSize >
+              Size ||
+          read32(Record + 12) + uint64_t(read32(Record + 16)) * 8 > Size ||
+          read32(Record) > Cache->NumStrings)
+        return 0;
+      Cache->FileRecords[Cache->getString(read32(Record))] = Record;
+    }
+    return Cache.release();
+  }
+
+  /// \brief Look up the tokens of \p FE; the returned File is invalid if the
+  /// file is not cached, has changed since it was, or its tokens are not
+  /// consistent with the string table.
+  File getFile(const FileEntry *FE) const {
+    using namespace tokencache;
+    File Result;
+    llvm::StringMap<const char *>::const_iterator I =
+        FileRecords.find(FE->getName());
+    if (I == FileRecords.end())
+      return Result;
+    const char *Record = I->second;
+    if (read64(Record + 24) != uint64_t(FE->getSize()) ||
+        read64(Record + 32) != uint64_t(FE->getModificationTime()))
+      return Result;
+    std::pair<llvm::DenseMap<const char *, bool>::iterator, bool> Checked =
+        CheckedFiles.insert(std::make_pair(Record, false));
+    if (Checked.second)
+      Checked.first->second = checkTokens(Record);
+    if (!Checked.first->second)
+      return Result;
+    const char *Base = Buffer->getBufferStart();
+    Result.Cache = this;
+    Result.Tokens = Base + read32(Record + 4);
+    Result.NumTokens = read32(Record + 8);
+    Result.Conditionals = Base + read32(Record + 12);
+    Result.NumConditionals = read32(Record + 16);
+    return Result;
+  }
+};
+
+} // end namespace clang
+
+#endif
@@ -227,13 +227,31 @@ class Parser : public CodeCompletionHandler {
   /// be NULL.
   bool ParsingInObjCContainer;
 
+  /// \brief Whether function bodies are skipped rather than parsed.
+  ///
+  /// Bodies are otherwise parsed as soon as they are seen, except for the
+  /// inline members of classes (see LateParsedDeclarations) and, under
+  /// -fdelayed-template-parsing, templated functions, whose tokens are
+  /// cached and parsed later on this thread.  Bodies cannot be parsed in
+  /// parallel: they share the Preprocessor's identifier table, Sema's
+  /// scope and lookup state, the ASTContext's allocator and type uniquing
+  /// tables, and the diagnostics engine, none of which is thread-safe.
   bool SkipFunctionBodies;
 
+  /// \brief Whether the skipped bodies of the main file have their tokens
+  /// cached in Sema, to be parsed on demand by ParseLazyFunctionBody.  The
+  /// parser must then outlive the translation unit's parse.
+  bool LazyFunctionBodies;
+
 public:
   Parser(Preprocessor &PP, Sema &Actions, bool SkipFunctionBodies);
   ~Parser();
 
   const LangOptions &getLangOpts() const { return PP.getLangOpts(); }
+
+  /// \brief Cache the tokens of the skipped bodies of the main file in Sema
+  /// instead of dropping them; only meaningful with SkipFunctionBodies.
+  void setLazyFunctionBodies(bool Value) { LazyFunctionBodies = Value; }
   const TargetInfo &getTargetInfo() const { return PP.getTargetInfo(); }
   Preprocessor &getPreprocessor() const { return PP; }
   Sema &getActions() const { return Actions; }
@@ -1152,6 +1170,11 @@ private:
 
   static void LateTemplateParserCallback(void *P, LateParsedTemplate &LPT);
 
+  void LexFunctionBodyForLazyParsing(Decl *FnD);
+  void ParseLazyFunctionBody(LateParsedTemplate &LPT);
+
+  static void LazyBodyParserCallback(void *P, LateParsedTemplate &LPT);
+
   Sema::ParsingClassState
   PushParsingClass(Decl *TagOrTemplate, bool TopLevelClass, bool IsInterface);
   void DeallocateParsedClasses(ParsingClass *Class);
@@ -18,10 +18,13 @@
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Rewrite/Core/DeltaTree.h"
 #include "clang/Rewrite/Core/RewriteRope.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
 #include <cstring>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace clang {
   class LangOptions;
@@ -56,6 +59,35 @@ public:
   /// The original buffer is not actually changed.
   raw_ostream &write(raw_ostream &Stream) const;
 
+  /// \brief Write to \p Stream the rewritten text between the offsets
+  /// \p Begin and \p End of the rewritten buffer, without copying it into a
+  /// string first.
+  raw_ostream &write(raw_ostream &Stream, unsigned Begin, unsigned End) const;
+
+  /// \brief An edit for applyEdits(): replace \p Length bytes at \p Offset
+  /// in the original buffer with \p Text.  A \p Length of 0 inserts \p Text
+  /// after the text inserted at \p Offset so far.
+  struct Edit {
+    unsigned Offset;
+    unsigned Length;
+    StringRef Text;
+
+    Edit(unsigned Offset, unsigned Length, StringRef Text)
+      : Offset(Offset), Length(Length), Text(Text) {}
+  };
+
+  /// \brief Apply \p Edits, sorted by offset, in one pass over the buffer.
+  ///
+  /// This has the effect of calling ReplaceText() (or InsertText() when the
+  /// length is 0) for each edit in order, but rebuilds the buffer once
+  /// instead of splitting it at every edit, which makes tens of thousands of
+  /// edits to one file cost time linear in its size.  Edits at the same
+  /// offset are applied in the given order.
+  ///
+  /// \returns true (and does nothing) if the edits are not sorted, overlap,
+  /// or extend past the end of the buffer; false otherwise.
+  bool applyEdits(ArrayRef<Edit> Edits);
+
   /// RemoveText - Remove the specified text.
   void RemoveText(unsigned OrigOffset, unsigned Size,
                   bool removeLineIfEmpty = false);
@@ -120,6 +152,68 @@ private:  // Methods only usable by Rewriter.
   }
 };
 
+inline raw_ostream &RewriteBuffer::write(raw_ostream &Stream, unsigned Begin,
+                                         unsigned End) const {
+  assert(Begin <= End && End <= size() && "Invalid range to write!");
+  unsigned Pos = 0;
+  for (iterator I = begin(), E = end(); I != E && Pos < End;
+       I.MoveToNextPiece()) {
+    StringRef Piece = I.piece();
+    if (Pos + Piece.size() > Begin)
+      Stream << Piece.slice(Begin > Pos ? Begin - Pos : 0, End - Pos);
+    Pos += Piece.size();
+  }
+  return Stream;
+}
+
+inline bool RewriteBuffer::applyEdits(ArrayRef<Edit> Edits) {
+  if (Edits.empty())
+    return false;
+
+  // Map every edit into the current buffer before changing anything, so the
+  // edits see the buffer as it was when they were computed.
+  std::vector<unsigned> Mapped(Edits.size());
+  uint64_t NewSize = size();
+  for (unsigned I = 0, E = Edits.size(); I != E; ++I) {
+    Mapped[I] = getMappedOffset(Edits[I].Offset, true);
+    if (Mapped[I] + uint64_t(Edits[I].Length) > size())
+      return true;
+    if (I && (Edits[I].Offset < Edits[I-1].Offset + Edits[I-1].Length ||
+              Mapped[I] < Mapped[I-1] + Edits[I-1].Length))
+      return true;
+    NewSize += Edits[I].Text.size();
+    NewSize -= Edits[I].Length;
+  }
+
+  std::string Old;
+  Old.reserve(size());
+  {
+    llvm::raw_string_ostream OS(Old);
+    write(OS);
+  }
+  std::string New;
+  New.reserve(NewSize);
+  unsigned Pos = 0;
+  for (unsigned I = 0, E = Edits.size(); I != E; ++I) {
+    New.append(Old, Pos, Mapped[I] - Pos);
+    New.append(Edits[I].Text.begin(), Edits[I].Text.end());
+    Pos = Mapped[I] + Edits[I].Length;
+  }
+  New.append(Old, Pos, std::string::npos);
+  Buffer.assign(New.data(), New.data() + New.size());
+
+  for (unsigned I = 0, E = Edits.size(); I != E; ++I) {
+    int Change = int(Edits[I].Text.size()) - int(Edits[I].Length);
+    if (!Edits[I].Length) {
+      if (Change)
+        AddInsertDelta(Edits[I].Offset, Change);
+    } else if (Change) {
+      AddReplaceDelta(Edits[I].Offset, Change);
+    }
+  }
+  return false;
+}
+
 
 /// Rewriter - This is the main interface to the rewrite buffers.  Its primary
 /// job is to dispatch high-level requests to the low-level RewriteBuffers that
@@ -181,6 +275,10 @@ public:
   ///
   std::string getRewrittenText(SourceRange Range) const;
 
+  /// \brief Write the rewritten form of the text in the specified range to
+  /// \p OS, like getRewrittenText() but without building a string.
+  raw_ostream &writeRewrittenText(SourceRange Range, raw_ostream &OS) const;
+
   /// InsertText - Insert the specified string at the specified location in the
   /// original buffer.  This method returns true (and does nothing) if the input
   /// location was not rewritable, false otherwise.
@@ -270,6 +368,18 @@ public:
   /// FileID's buffer.
   RewriteBuffer &getEditBuffer(FileID FID);
 
+  /// \brief Apply \p Edits, sorted by offset into the original buffer of
+  /// \p FID, in one pass.  See RewriteBuffer::applyEdits().
+  ///
+  /// \returns true (and does nothing) if the edits could not be applied.
+  bool applyEdits(FileID FID, ArrayRef<RewriteBuffer::Edit> Edits) {
+    return getEditBuffer(FID).applyEdits(Edits);
+  }
+
+  /// \brief Write the rewritten contents of \p FID, or its original contents
+  /// if it was not rewritten, to \p OS.
+  raw_ostream &writeRewrittenFile(FileID FID, raw_ostream &OS) const;
+
   /// getRewriteBufferFor - Return the rewrite buffer for the specified FileID.
   /// If no modification has been made to it, return null.
   const RewriteBuffer *getRewriteBufferFor(FileID FID) const {
@@ -85,6 +85,10 @@ private:
   /// a single function.
   unsigned MaxUninitAnalysisBlockVisitsPerFunction;
 
+  /// \brief Number of functions whose uninitialized use analysis stopped at
+  /// the block visit limit.
+  unsigned NumUninitAnalysisAbandoned;
+
   /// @}
 
 public:
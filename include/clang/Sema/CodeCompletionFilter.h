@@ -0,0 +1,250 @@
+//===--- CodeCompletionFilter.h - Completion filtering ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the CodeCompletionFilter class, which narrows a set of
+/// code-completion results to those matching what the user has typed.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_CODECOMPLETIONFILTER_H
+#define LLVM_CLANG_SEMA_CODECOMPLETIONFILTER_H
+
+#include "clang/Basic/CharInfo.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Sema/CodeCompleteConsumer.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <algorithm>
+#include <vector>
+
+namespace clang {
+
+/// \brief Narrows code-completion results by the text typed since completion
+/// was requested, so that each keystroke in the same context does not need
+/// another run of Sema's code completion.
+///
+/// The filter indexes the typed text of each completion string once.  A
+/// result matches a typed prefix if the prefix is a prefix of its typed text
+/// or, in fuzzy mode, a subsequence of it ("iwf" matches "initWithFrame:").
+/// Matches are ranked by how well they match, preferring prefix matches,
+/// then characters that start words (in camelCase or after '_' or ':') and
+/// runs of consecutive characters, and then by the priority of the result.
+///
+/// Typing narrows: when the new prefix extends the last filtered one, only
+/// the results that matched last time are rescored.
+class CodeCompletionFilter {
+public:
+  enum FilterFlags {
+    /// \brief Match the typed prefix as a subsequence rather than a prefix.
+    Fuzzy = 0x1,
+    /// \brief Match letters case-sensitively.
+    CaseSensitive = 0x2
+  };
+
+  /// \brief A matching result: its index in the filtered set and its score,
+  /// which is higher for better matches.
+  struct Match {
+    unsigned Index;
+    unsigned Score;
+  };
+
+private:
+  struct Entry {
+    StringRef TypedText;
+    /// The classes of the characters in TypedText; see getCharMask().
+    uint32_t CharMask;
+    unsigned Priority;
+  };
+
+  std::vector<Entry> Entries;
+
+  SmallString<32> LastPrefix;
+  unsigned LastFlags;
+  bool HaveLastMatches;
+  std::vector<unsigned> LastMatches;
+
+  /// \brief A bitmask with one bit per letter (ignoring case), one for all
+  /// digits, one for '_' and one for anything else, so that most results
+  /// can be rejected without looking at their text.
+  static uint32_t getCharMask(StringRef Text) {
+    uint32_t Mask = 0;
+    for (unsigned i = 0, e = Text.size(); i != e; ++i) {
+      char C = toLowercase(Text[i]);
+      if (C >= 'a' && C <= 'z')
+        Mask |= 1u << (C - 'a');
+      else if (isDigit(C))
+        Mask |= 1u << 26;
+      else if (C == '_')
+        Mask |= 1u << 27;
+      else
+        Mask |= 1u << 28;
+    }
+    return Mask;
+  }
+
+  static bool isWordStart(StringRef Text, unsigned I) {
+    if (I == 0)
+      return true;
+    char Prev = Text[I - 1], C = Text[I];
+    if (!isIdentifierBody(Prev))
+      return isIdentifierBody(C);
+    if (Prev == '_')
+      return C != '_';
+    return isUppercase(C) && !isUppercase(Prev);
+  }
+
+  static bool equal(char A, char B, unsigned Flags) {
+    return (Flags & CaseSensitive) ? A == B : toLowercase(A) == toLowercase(B);
+  }
+
+  /// \brief Score \p Text against \p Prefix.
+  ///
+  /// \returns false if it does not match.
+  static bool score(StringRef Text, StringRef Prefix, unsigned Flags,
+                    unsigned &Score) {
+    if (Prefix.size() > Text.size())
+      return false;
+
+    // A prefix match beats any fuzzy match.
+    bool IsPrefix = true;
+    unsigned ExactCase = 0;
+    for (unsigned i = 0, e = Prefix.size(); i != e && IsPrefix; ++i) {
+      IsPrefix = equal(Text[i], Prefix[i], Flags);
+      ExactCase += Text[i] == Prefix[i];
+    }
+    if (IsPrefix) {
+      // Among prefix matches, prefer the right case and then the shortest.
+      Score = 0x80000000u | ExactCase << 16 |
+              (0xFFFF - std::min<size_t>(Text.size(), 0xFFFF));
+      return true;
+    }
+    if (!(Flags & Fuzzy))
+      return false;
+
+    // Match greedily, preferring the next word start over the next
+    // occurrence when both match the character.
+    Score = 0;
+    unsigned TextIdx = 0;
+    bool Consecutive = false;
+    for (unsigned i = 0, e = Prefix.size(); i != e; ++i) {
+      unsigned Found = Text.size(), FoundWordStart = Text.size();
+      for (unsigned j = TextIdx, je = Text.size(); j != je; ++j) {
+        if (!equal(Text[j], Prefix[i], Flags))
+          continue;
+        if (Found == Text.size())
+          Found = j;
+        if (isWordStart(Text, j)) {
+          FoundWordStart = j;
+          break;
+        }
+      }
+      if (Found == Text.size())
+        return false;
+      // Keep a run of consecutive characters going rather than jumping to
+      // a later word start.
+      unsigned Pos = (Consecutive && Found == TextIdx) ||
+                             FoundWordStart == Text.size()
+                         ? Found
+                         : FoundWordStart;
+      Consecutive = Pos == TextIdx && i != 0;
+      Score += 1;
+      if (isWordStart(Text, Pos))
+        Score += 4;
+      if (Consecutive)
+        Score += 2;
+      if (Text[Pos] == Prefix[i])
+        Score += 1;
+      TextIdx = Pos + 1;
+    }
+    return true;
+  }
+
+public:
+  CodeCompletionFilter() : LastFlags(0), HaveLastMatches(false) {}
+
+  explicit CodeCompletionFilter(ArrayRef<const CodeCompletionString *> Strings)
+    : LastFlags(0), HaveLastMatches(false) {
+    Entries.reserve(Strings.size());
+    for (unsigned i = 0, e = Strings.size(); i != e; ++i)
+      add(Strings[i]);
+  }
+
+  /// \brief Add the result \p CCS, with the next index.  The completion
+  /// string must outlive the filter.
+  void add(const CodeCompletionString *CCS) {
+    const char *TypedText = CCS->getTypedText();
+    Entry E;
+    E.TypedText = TypedText ? StringRef(TypedText) : StringRef();
+    E.CharMask = getCharMask(E.TypedText);
+    E.Priority = CCS->getPriority();
+    Entries.push_back(E);
+    HaveLastMatches = false;
+  }
+
+  unsigned size() const { return Entries.size(); }
+
+  /// \brief Append the results matching \p Prefix to \p Matches, best match
+  /// first.
+  ///
+  /// \param Flags A bitwise OR of FilterFlags.
+  void filter(StringRef Prefix, unsigned Flags,
+              SmallVectorImpl<Match> &Matches) {
+    uint32_t PrefixMask = getCharMask(Prefix);
+    bool Narrowing = HaveLastMatches && Flags == LastFlags &&
+                     Prefix.startswith(LastPrefix);
+    std::vector<unsigned> Candidates;
+    if (Narrowing)
+      Candidates.swap(LastMatches);
+
+    LastMatches.clear();
+    unsigned FirstMatch = Matches.size();
+    for (unsigned i = 0, e = Narrowing ? Candidates.size() : Entries.size();
+         i != e; ++i) {
+      unsigned Index = Narrowing ? Candidates[i] : i;
+      const Entry &E = Entries[Index];
+      Match M;
+      if ((PrefixMask & ~E.CharMask) != 0 ||
+          !score(E.TypedText, Prefix, Flags, M.Score))
+        continue;
+      M.Index = Index;
+      Matches.push_back(M);
+      LastMatches.push_back(Index);
+    }
+    LastPrefix = Prefix;
+    LastFlags = Flags;
+    HaveLastMatches = true;
+
+    std::stable_sort(Matches.begin() + FirstMatch, Matches.end(),
+                     MatchOrder(Entries));
+  }
+
+private:
+  struct MatchOrder {
+    const std::vector<Entry> &Entries;
+
+    explicit MatchOrder(const std::vector<Entry> &Entries)
+      : Entries(Entries) {}
+
+    bool operator()(const Match &LHS, const Match &RHS) const {
+      if (LHS.Score != RHS.Score)
+        return LHS.Score > RHS.Score;
+      const Entry &L = Entries[LHS.Index], &R = Entries[RHS.Index];
+      if (L.Priority != R.Priority)
+        return L.Priority < R.Priority;
+      return L.TypedText.compare_lower(R.TypedText) < 0;
+    }
+  };
+};
+
+} // end namespace clang
+
+#endif
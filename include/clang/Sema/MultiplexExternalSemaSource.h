@@ -192,6 +192,18 @@ public:
                  llvm::DenseMap<const CXXRecordDecl *,
                                 CharUnits> &VirtualBaseOffsets) override;
 
+  /// \brief Provide the sizes of a record layout that layoutRecordType does
+  /// not cover, from the first source that has them.
+  bool getRecordLayoutSizes(const RecordDecl *Record, CharUnits &DataSize,
+                            CharUnits &NonVirtualSize,
+                            CharUnits &NonVirtualAlignment) override {
+    for (size_t i = 0; i < Sources.size(); ++i)
+      if (Sources[i]->getRecordLayoutSizes(Record, DataSize, NonVirtualSize,
+                                           NonVirtualAlignment))
+        return true;
+    return false;
+  }
+
   /// Return the amount of memory used by memory buffers, breaking down
   /// by heap-backed versus mmap'ed memory.
   void getMemoryBufferSizes(MemoryBufferSizes &sizes) const override;
@@ -158,8 +158,10 @@ namespace clang {
   class TemplateArgumentList;
   class TemplateArgumentLoc;
   class TemplateDecl;
+  class TemplateInstantiationProfile;
   class TemplateParameterList;
   class TemplatePartialOrderingContext;
+  class TemplateSubstitutionCache;
   class TemplateTemplateParmDecl;
   class Token;
   class TypeAliasDecl;
@@ -473,6 +475,22 @@ public:
     OpaqueParser = P;
   }
 
+  /// \brief The function and Objective-C method bodies whose tokens the
+  /// parser cached instead of parsing them, under lazy function bodies.
+  typedef llvm::DenseMap<const Decl *, LateParsedTemplate *>
+  LazyFunctionBodyMapT;
+  LazyFunctionBodyMapT LazyFunctionBodyMap;
+
+  /// \brief Callback to the parser to parse a lazy function body on demand,
+  /// which outlives the parse of the translation unit.
+  LateTemplateParserCB *LazyBodyParser;
+  void *OpaqueLazyBodyParser;
+
+  void SetLazyBodyParser(LateTemplateParserCB *LBP, void *P) {
+    LazyBodyParser = LBP;
+    OpaqueLazyBodyParser = P;
+  }
+
   class DelayedDiagnostics;
 
   class DelayedDiagnosticsState {
@@ -871,6 +889,13 @@ public:
   /// of selectors are "overloaded").
   /// At the head of the list it is recorded whether there were 0, 1, or >= 2
   /// methods inside categories with a particular selector.
+  ///
+  /// Methods from precompiled headers and modules are not loaded up front:
+  /// the first lookup of a selector calls ReadMethodPool(), which probes the
+  /// on-disk selector table of each module file for that selector only, and
+  /// the external source records the generation it read so that later
+  /// lookups only read newly loaded modules.  Both the pool and that record
+  /// thus only grow with the selectors the translation unit references.
   GlobalMethodPool MethodPool;
 
   /// Method selectors used in a \@selector expression. Used for implementation
@@ -4889,6 +4914,16 @@ public:
   void MarkAsLateParsedTemplate(FunctionDecl *FD, Decl *FnD,
                                 CachedTokens &Toks);
   void UnmarkAsLateParsedTemplate(FunctionDecl *FD);
+
+  /// \brief Record the cached body tokens \p Toks of the function or
+  /// method \p FnD, whose body was skipped, to parse on demand.
+  void MarkAsLazyFunctionBody(Decl *FnD, CachedTokens &Toks);
+
+  /// \brief Parse the body of \p FnD if it was lazy, then perform the
+  /// instantiations it needs, as at the end of the translation unit.
+  ///
+  /// \returns true if the body was parsed.
+  bool ParseLazyFunctionBody(const Decl *FnD);
   bool IsInsideALocalClassWithinATemplateFunction();
 
   Decl *ActOnStaticAssertDeclaration(SourceLocation StaticAssertLoc,
@@ -6217,6 +6252,15 @@ public:
   /// which argument within the parameter pack will be used for substitution.
   int ArgumentPackSubstitutionIndex;
 
+  /// \brief The number of instantiations of each template and the time they
+  /// took, collected with -ftime-report; null otherwise.
+  std::unique_ptr<TemplateInstantiationProfile> InstantiationProfile;
+
+  /// \brief The results of substituting template arguments into types,
+  /// reused by SubstType when the same arguments are substituted into the
+  /// same pattern again.  Null disables the cache.
+  std::unique_ptr<TemplateSubstitutionCache> SubstitutionCache;
+
   /// \brief RAII object used to change the argument pack substitution index
   /// within a \c Sema object.
   ///
@@ -68,6 +68,13 @@ namespace clang {
       return TemplateArgumentLists[getNumLevels() - Depth - 1][Index];
     }
     
+    /// \brief Determine the number of template arguments, null ones
+    /// included, at the given depth.
+    unsigned getNumTemplateArguments(unsigned Depth) const {
+      assert(Depth < TemplateArgumentLists.size());
+      return TemplateArgumentLists[getNumLevels() - Depth - 1].size();
+    }
+
     /// \brief Determine whether there is a non-NULL template argument at the
     /// given depth and index.
     ///
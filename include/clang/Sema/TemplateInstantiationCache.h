@@ -0,0 +1,221 @@
+//===--- TemplateInstantiationCache.h - Instantiation profiling -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines TemplateInstantiationProfile, which attributes the time
+//  spent instantiating templates to each template for -ftime-report, and
+//  TemplateSubstitutionCache, which reuses the results of substituting the
+//  same template arguments into the same type.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_TEMPLATEINSTANTIATIONCACHE_H
+#define LLVM_CLANG_SEMA_TEMPLATEINSTANTIATIONCACHE_H
+
+#include "clang/AST/Type.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Sema/Template.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <vector>
+
+namespace clang {
+
+/// \brief The number of instantiations of each template, and the time they
+/// took.
+///
+/// Sema creates one when -ftime-report is given and times each call to
+/// InstantiateFunctionDefinition and InstantiateClass with a Timer.  A
+/// template's time includes the instantiations it triggers; time spent in
+/// recursive instantiations of the same template is only counted once.
+class TemplateInstantiationProfile {
+  struct Entry {
+    unsigned NumInstantiations;
+    unsigned ActiveDepth;
+    double Seconds;
+
+    Entry() : NumInstantiations(0), ActiveDepth(0), Seconds(0) {}
+  };
+
+  llvm::DenseMap<const NamedDecl *, Entry> Entries;
+
+public:
+  /// \brief Times one instantiation of a template for as long as it lives.
+  class Timer {
+    TemplateInstantiationProfile *Profile;
+    const NamedDecl *Template;
+    double Start;
+
+  public:
+    /// \param Profile The profile to record into; may be null, in which case
+    /// nothing is timed.
+    Timer(TemplateInstantiationProfile *Profile, const NamedDecl *Template)
+      : Profile(Profile), Template(Template), Start(0) {
+      if (!Profile)
+        return;
+      Entry &E = Profile->Entries[Template];
+      ++E.NumInstantiations;
+      if (E.ActiveDepth++ == 0)
+        Start = llvm::TimeRecord::getCurrentTime().getWallTime();
+    }
+
+    ~Timer() {
+      if (!Profile)
+        return;
+      Entry &E = Profile->Entries[Template];
+      if (--E.ActiveDepth == 0)
+        E.Seconds += llvm::TimeRecord::getCurrentTime().getWallTime() - Start;
+    }
+  };
+
+  unsigned getNumInstantiations(const NamedDecl *Template) const {
+    llvm::DenseMap<const NamedDecl *, Entry>::const_iterator I =
+        Entries.find(Template);
+    return I == Entries.end() ? 0 : I->second.NumInstantiations;
+  }
+
+  /// \brief Print the \p Limit templates that took the longest, slowest
+  /// first.
+  void print(raw_ostream &OS, unsigned Limit = 50) const {
+    typedef std::pair<const NamedDecl *, Entry> Item;
+    std::vector<Item> Sorted(Entries.begin(), Entries.end());
+    std::sort(Sorted.begin(), Sorted.end(),
+              [](const Item &A, const Item &B) {
+      return A.second.Seconds > B.second.Seconds;
+    });
+    if (Sorted.size() > Limit)
+      Sorted.resize(Limit);
+
+    OS << "===" << std::string(73, '-') << "===\n"
+       << "                      Template instantiation report\n"
+       << "===" << std::string(73, '-') << "===\n"
+       << "   Wall Time    Count  Template\n";
+    for (unsigned I = 0, E = Sorted.size(); I != E; ++I) {
+      OS << llvm::format("  %10.4f %8u  ", Sorted[I].second.Seconds,
+                         Sorted[I].second.NumInstantiations);
+      Sorted[I].first->printQualifiedName(OS);
+      OS << '\n';
+    }
+  }
+};
+
+/// \brief A cache of SubstType results, keyed by the pattern type and the
+/// template arguments substituted into it.
+///
+/// Instantiating many specializations of a class template that share member
+/// types with the same arguments (such as the allocator or traits types of
+/// a container) substitutes into the same patterns again and again.  Types
+/// are uniqued by the ASTContext, so a substitution that succeeded without
+/// diagnostics always yields the same type and can be reused.  Substitutions
+/// that failed, produced diagnostics or ran in a SFINAE context must not be
+/// recorded, since their outcome depends on the point of instantiation.
+///
+/// The cache is emptied whenever its memory exceeds its budget, so it never
+/// holds much more than that many bytes.
+class TemplateSubstitutionCache {
+  struct Entry {
+    llvm::FoldingSetNodeIDRef Key;
+    QualType Result;
+
+    Entry(llvm::FoldingSetNodeIDRef Key, QualType Result)
+      : Key(Key), Result(Result) {}
+  };
+
+  llvm::DenseMap<unsigned, SmallVector<Entry, 1> > Entries;
+  llvm::BumpPtrAllocator KeyAlloc;
+  size_t Budget;
+  unsigned NumEntries, NumHits, NumMisses, NumFlushes;
+
+  static void profile(llvm::FoldingSetNodeID &ID, QualType Pattern,
+                      const MultiLevelTemplateArgumentList &Args,
+                      int PackIndex, const ASTContext &Context) {
+    ID.AddPointer(Pattern.getAsOpaquePtr());
+    ID.AddInteger(PackIndex);
+    ID.AddInteger(Args.getNumLevels());
+    for (unsigned Depth = 0, E = Args.getNumLevels(); Depth != E; ++Depth) {
+      // Every argument counts, including those after a null one, which
+      // stands for an argument that is not substituted.
+      unsigned NumArgs = Args.getNumTemplateArguments(Depth);
+      ID.AddInteger(NumArgs);
+      for (unsigned Index = 0; Index != NumArgs; ++Index) {
+        const TemplateArgument &Arg = Args(Depth, Index);
+        ID.AddBoolean(Arg.isNull());
+        if (!Arg.isNull())
+          Arg.Profile(ID, Context);
+      }
+    }
+  }
+
+  size_t getMemoryUsage() const {
+    return KeyAlloc.getTotalMemory() + Entries.getMemorySize() +
+           NumEntries * sizeof(Entry);
+  }
+
+public:
+  /// \param Budget The number of bytes the cache may use.
+  explicit TemplateSubstitutionCache(size_t Budget = 16 << 20)
+    : Budget(Budget), NumEntries(0), NumHits(0), NumMisses(0),
+      NumFlushes(0) {}
+
+  /// \brief Find the result of substituting \p Args into \p Pattern.
+  ///
+  /// \param PackIndex The Sema::ArgumentPackSubstitutionIndex in effect.
+  ///
+  /// \returns the cached type, or a null type if there is none.
+  QualType lookup(QualType Pattern, const MultiLevelTemplateArgumentList &Args,
+                  int PackIndex, const ASTContext &Context) {
+    llvm::FoldingSetNodeID ID;
+    profile(ID, Pattern, Args, PackIndex, Context);
+    llvm::DenseMap<unsigned, SmallVector<Entry, 1> >::const_iterator I =
+        Entries.find(ID.ComputeHash());
+    if (I != Entries.end())
+      for (unsigned E = 0, EE = I->second.size(); E != EE; ++E)
+        if (ID == I->second[E].Key) {
+          ++NumHits;
+          return I->second[E].Result;
+        }
+    ++NumMisses;
+    return QualType();
+  }
+
+  /// \brief Record that substituting \p Args into \p Pattern yielded
+  /// \p Result without diagnostics.
+  void insert(QualType Pattern, const MultiLevelTemplateArgumentList &Args,
+              int PackIndex, const ASTContext &Context, QualType Result) {
+    if (getMemoryUsage() > Budget)
+      clear();
+    llvm::FoldingSetNodeID ID;
+    profile(ID, Pattern, Args, PackIndex, Context);
+    Entries[ID.ComputeHash()].push_back(Entry(ID.Intern(KeyAlloc), Result));
+    ++NumEntries;
+  }
+
+  void clear() {
+    if (!NumEntries)
+      return;
+    llvm::DenseMap<unsigned, SmallVector<Entry, 1> >().swap(Entries);
+    KeyAlloc.Reset();
+    NumEntries = 0;
+    ++NumFlushes;
+  }
+
+  unsigned size() const { return NumEntries; }
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumMisses() const { return NumMisses; }
+  unsigned getNumFlushes() const { return NumFlushes; }
+};
+
+} // end namespace clang
+
+#endif
@@ -35,7 +35,7 @@ namespace clang {
     /// Version 4 of AST files also requires that the version control branch and
     /// revision match exactly, since there is no backward compatibility of
     /// AST files at this time.
-    const unsigned VERSION_MAJOR = 5;
+    const unsigned VERSION_MAJOR = 6;
 
     /// \brief AST file minor version number supported by this version of
     /// Clang.
@@ -542,7 +542,23 @@ namespace clang {
       UNDEFINED_BUT_USED = 49,
 
       /// \brief Record code for late parsed template functions.
-      LATE_PARSED_TEMPLATE = 50
+      LATE_PARSED_TEMPLATE = 50,
+
+      /// \brief Record code for the map of record definition IDs to their
+      /// layouts in RECORD_LAYOUTS, sorted by ID.
+      RECORD_LAYOUTS_MAP = 51,
+
+      /// \brief Record code for the layouts of the record definitions whose
+      /// layout was computed while the AST file was built.
+      ///
+      /// Each layout is the record size and alignment in bits, its data
+      /// size, non-virtual size and non-virtual alignment in bytes, the
+      /// number of fields and their offsets in declaration order, and then,
+      /// for C++ classes, the number of direct non-virtual bases followed by
+      /// a (base decl ID, offset in bytes) pair for each, and the same for
+      /// virtual bases.  This array can only be interpreted properly using
+      /// the record layouts map.
+      RECORD_LAYOUTS = 52
     };
 
     /// \brief Record types used within a source manager block.
@@ -560,7 +576,12 @@ namespace clang {
       SM_SLOC_BUFFER_BLOB = 3,
       /// \brief Describes a source location entry (SLocEntry) for a
       /// macro expansion.
-      SM_SLOC_EXPANSION_ENTRY = 4
+      SM_SLOC_EXPANSION_ENTRY = 4,
+      /// \brief Describes a zlib-compressed blob that contains the data for
+      /// a buffer entry, in place of a SM_SLOC_BUFFER_BLOB.  The record
+      /// holds the size of the uncompressed data.  The blob is only
+      /// inflated when the buffer is first requested.
+      SM_SLOC_BUFFER_BLOB_COMPRESSED = 5
     };
 
     /// \brief Record types used within a preprocessor block.
@@ -1421,6 +1442,17 @@ namespace clang {
       }
     };
 
+    /// \brief Describes the location of a record layout in RECORD_LAYOUTS.
+    struct RecordLayoutInfo {
+      DeclID DefinitionID; // The ID of the record definition
+      unsigned Offset;     // Offset into the array of layouts.
+
+      friend bool operator<(const RecordLayoutInfo &X,
+                            const RecordLayoutInfo &Y) {
+        return X.DefinitionID < Y.DefinitionID;
+      }
+    };
+
     /// @}
   }
 } // end namespace clang
@@ -0,0 +1,96 @@
+//===--- ASTBlobJobs.h - Concurrent AST blob building -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines ASTBlobJobs, which lets ASTWriter build the blobs of
+//  independent records, such as the on-disk identifier and selector hash
+//  tables, on worker threads before emitting them in a fixed order.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SERIALIZATION_ASTBLOBJOBS_H
+#define LLVM_CLANG_SERIALIZATION_ASTBLOBJOBS_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace clang {
+namespace serialization {
+
+/// \brief A set of blobs that are built independently of each other and
+/// then emitted by the caller in the order they were added.
+///
+/// Each job writes one blob into its own buffer, so the contents of the
+/// blobs, and thus the AST file, do not depend on how many threads built
+/// them or in which order they finished.  A job must only read the
+/// writer's state: every identifier, selector and declaration it refers to
+/// must have been assigned its ID before run() is called.
+class ASTBlobJobs {
+public:
+  typedef std::function<void(raw_ostream &)> JobFn;
+
+private:
+  struct Job {
+    JobFn Fn;
+    SmallString<4096> Blob;
+
+    explicit Job(JobFn Fn) : Fn(Fn) {}
+
+    void run() {
+      llvm::raw_svector_ostream Out(Blob);
+      Fn(Out);
+      Out.flush();
+    }
+  };
+
+  std::vector<Job> Jobs;
+
+public:
+  /// \brief Queue a job that writes a blob to the stream it is given.
+  ///
+  /// \returns the index of the blob, for getBlob().
+  unsigned add(JobFn Fn) {
+    Jobs.push_back(Job(Fn));
+    return Jobs.size() - 1;
+  }
+
+  /// \brief Build every queued blob using up to \p NumThreads threads of the
+  /// shared pool (see ThreadPool.h); 1 builds them on the calling thread.
+  void run(unsigned NumThreads) {
+    NumThreads = std::min<unsigned>(NumThreads, Jobs.size());
+    if (NumThreads > 1) {
+      std::atomic<unsigned> Next(0);
+      llvm::TaskGroup Group;
+      for (unsigned I = 0; I != NumThreads; ++I)
+        Group.spawn([&] {
+          for (unsigned J; (J = Next++) < Jobs.size();)
+            Jobs[J].run();
+        });
+      return;
+    }
+    for (unsigned I = 0, E = Jobs.size(); I != E; ++I)
+      Jobs[I].run();
+  }
+
+  /// \brief The blob built by job \p I.
+  StringRef getBlob(unsigned I) const { return Jobs[I].Blob.str(); }
+
+  unsigned size() const { return Jobs.size(); }
+};
+
+} // end namespace serialization
+} // end namespace clang
+
+#endif
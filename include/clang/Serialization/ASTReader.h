@@ -81,6 +81,8 @@ class PreprocessorOptions;
 class Sema;
 class SwitchCase;
 class ASTDeserializationListener;
+class DeserializationProfile;
+class DeserializationStats;
 class ASTWriter;
 class ASTReader;
 class ASTDeclReader;
@@ -338,6 +340,17 @@ private:
   /// \brief The receiver of deserialization events.
   ASTDeserializationListener *DeserializationListener;
 
+  /// \brief If non-null, the object timing the records read by this reader.
+  DeserializationStats *Stats;
+
+  /// \brief Whether loading the identifier and selector tables of AST files
+  /// is deferred until the first lookup into them.
+  bool DeferTableLoading;
+
+  /// \brief When table loading is deferred, the identifiers and selectors to
+  /// preload anyway, because earlier translation units needed them.
+  const DeserializationProfile *PreloadProfile;
+
   SourceManager &SourceMgr;
   FileManager &FileMgr;
   DiagnosticsEngine &Diags;
@@ -1362,6 +1375,33 @@ public:
   /// \brief Set the AST deserialization listener.
   void setDeserializationListener(ASTDeserializationListener *Listener);
 
+  /// \brief Time the reading of records with \p S, which does not take
+  /// ownership.
+  ///
+  /// To also count the entities read, install \p S as the deserialization
+  /// listener as well.
+  void setDeserializationStats(DeserializationStats *S) { Stats = S; }
+  DeserializationStats *getDeserializationStats() const { return Stats; }
+
+  /// \brief Defer loading the identifier and selector tables of AST files.
+  ///
+  /// Normally the identifiers of a PCH that have macro definitions or
+  /// top-level declarations are preloaded, and the on-disk identifier and
+  /// selector tables of each AST file are set up, as soon as it is loaded.
+  /// With deferred loading, the tables are only set up on the first lookup
+  /// into them and only the identifiers named by \p Profile (if any) are
+  /// preloaded; all the others are resolved when first looked up through
+  /// \c get().  This makes loading a large PCH cheap for translation units
+  /// that only use a few of its declarations.
+  ///
+  /// Must be called before the first AST file is read.
+  void setDeferTableLoading(bool Defer,
+                            const DeserializationProfile *Profile = 0) {
+    DeferTableLoading = Defer;
+    PreloadProfile = Profile;
+  }
+  bool isTableLoadingDeferred() const { return DeferTableLoading; }
+
   /// \brief Determine whether this AST reader has a global index.
   bool hasGlobalIndex() const { return (bool)GlobalIndex; }
 
@@ -1654,6 +1694,26 @@ public:
   void FindFileRegionDecls(FileID File, unsigned Offset, unsigned Length,
                            SmallVectorImpl<Decl *> &Decls) override;
 
+  /// \brief Provide the layout of \p Record if it was computed when one of
+  /// the loaded AST files was built, so that the layout of a big class is
+  /// not recomputed by every translation unit that uses it.
+  ///
+  /// Only the RECORD_LAYOUTS_MAP of each module file is read at load time;
+  /// a layout is decoded the first time the record is laid out.
+  bool layoutRecordType(
+      const RecordDecl *Record, uint64_t &Size, uint64_t &Alignment,
+      llvm::DenseMap<const FieldDecl *, uint64_t> &FieldOffsets,
+      llvm::DenseMap<const CXXRecordDecl *, CharUnits> &BaseOffsets,
+      llvm::DenseMap<const CXXRecordDecl *, CharUnits> &VirtualBaseOffsets)
+      override;
+
+  /// \brief Provide the data size and the non-virtual size and alignment of
+  /// \p Record, recorded with the rest of its layout, so that classes
+  /// derived from it are laid out as they were when the AST file was built.
+  bool getRecordLayoutSizes(const RecordDecl *Record, CharUnits &DataSize,
+                            CharUnits &NonVirtualSize,
+                            CharUnits &NonVirtualAlignment) override;
+
   /// \brief Notify ASTReader that we started deserialization of
   /// a decl or type so until FinishedDeserializing is called there may be
   /// decls that are initializing. Must be paired with FinishedDeserializing.
@@ -40,6 +40,8 @@ namespace llvm {
 
 namespace clang {
 
+namespace serialization { class ASTBlobJobs; }
+
 class ASTContext;
 class NestedNameSpecifier;
 class CXXBaseSpecifier;
@@ -123,6 +125,17 @@ private:
   /// \brief Indicates that the AST contained compiler errors.
   bool ASTHasCompilerErrors;
 
+  /// \brief The number of threads the on-disk hash tables are built on.
+  unsigned NumSerializationThreads;
+
+  /// \brief Whether buffers embedded in the AST file are compressed with
+  /// zlib; see setCompressSourceBuffers.
+  bool CompressSourceBuffers;
+
+  /// \brief The indices in the ASTBlobJobs of WriteASTCore of the method
+  /// pool and identifier table blobs.
+  unsigned MethodPoolJob, IdentifierTableJob;
+
   /// \brief Mapping from input file entries to the index into the
   /// offset table where information about that input file is stored.
   llvm::DenseMap<const FileEntry *, uint32_t> InputFileIDs;
@@ -474,10 +487,18 @@ private:
   void WriteTypeDeclOffsets();
   void WriteFileDeclIDsMap();
   void WriteComments();
-  void WriteSelectors(Sema &SemaRef);
+  /// \brief Assign IDs to the selectors and identifiers to be written and
+  /// queue the generation of their on-disk hash tables on \p Jobs.
+  ///
+  /// The generators only look up IDs and record the offset of each entry,
+  /// in slots no other job writes, so the tables can be built concurrently.
+  /// WriteQueuedTables emits them once \p Jobs has run, in a fixed order,
+  /// which keeps the output identical for any number of threads.
+  void WriteSelectors(Sema &SemaRef, serialization::ASTBlobJobs &Jobs);
   void WriteReferencedSelectorsPool(Sema &SemaRef);
   void WriteIdentifierTable(Preprocessor &PP, IdentifierResolver &IdResolver,
-                            bool IsModule);
+                            bool IsModule, serialization::ASTBlobJobs &Jobs);
+  void WriteQueuedTables(const serialization::ASTBlobJobs &Jobs);
   void WriteAttributes(ArrayRef<const Attr*> Attrs, RecordDataImpl &Record);
   void WriteDeclUpdatesBlocks(RecordDataImpl &OffsetsRecord);
   void WriteDeclReplacementsBlock();
@@ -485,6 +506,7 @@ private:
   void WriteFPPragmaOptions(const FPOptions &Opts);
   void WriteOpenCLExtensions(Sema &SemaRef);
   void WriteObjCCategories();
+  void WriteRecordLayouts(ASTContext &Context);
   void WriteRedeclarations();
   void WriteMergedDecls();
   void WriteLateParsedTemplates(Sema &SemaRef);
@@ -532,6 +554,24 @@ public:
                 Module *WritingModule, StringRef isysroot,
                 bool hasErrors = false);
 
+  /// \brief Build the identifier table and the method pool on up to \p N
+  /// threads.  The AST file is the same for any value.
+  void setNumSerializationThreads(unsigned N) {
+    NumSerializationThreads = N ? N : 1;
+  }
+
+  /// \brief Write the contents of the buffers embedded in the AST file,
+  /// such as memory buffers and remapped files, as
+  /// SM_SLOC_BUFFER_BLOB_COMPRESSED records.
+  ///
+  /// Buffers that do not get smaller are written uncompressed, and nothing
+  /// is compressed when zlib is not available.  The reader inflates each
+  /// buffer the first time it is needed, so only the files a translation
+  /// unit actually looks at cost any time.
+  void setCompressSourceBuffers(bool Compress) {
+    CompressSourceBuffers = Compress;
+  }
+
   /// \brief Emit a token.
   void AddToken(const Token &Tok, RecordDataImpl &Record);
 
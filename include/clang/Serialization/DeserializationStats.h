@@ -0,0 +1,292 @@
+//===--- DeserializationStats.h - Deserialization statistics ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the DeserializationStats class, which records what the
+// ASTReader deserializes from AST files and how long it takes, and the
+// DeserializationProfile class, which persists the identifiers and selectors
+// a translation unit needed so later loads can preload only those.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SERIALIZATION_DESERIALIZATION_STATS_H
+#define LLVM_CLANG_SERIALIZATION_DESERIALIZATION_STATS_H
+
+#include "clang/AST/DeclBase.h"
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Serialization/ASTDeserializationListener.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+
+namespace clang {
+
+/// \brief The set of identifiers and selectors a translation unit looked up
+/// in its AST files.
+///
+/// The profile is a text file with one "identifier <name>" or
+/// "selector <name>" line per entry, so that profiles from several
+/// translation units using the same PCH can simply be concatenated.
+class DeserializationProfile {
+  llvm::StringSet<> Identifiers;
+  llvm::StringSet<> Selectors;
+
+public:
+  void addIdentifier(StringRef Name) { Identifiers.insert(Name); }
+  void addSelector(StringRef Name) { Selectors.insert(Name); }
+
+  bool hasIdentifier(StringRef Name) const { return Identifiers.count(Name); }
+  bool hasSelector(StringRef Name) const { return Selectors.count(Name); }
+
+  bool empty() const { return Identifiers.empty() && Selectors.empty(); }
+
+  /// \brief Read a profile from \p Path, adding its entries to this one.
+  ///
+  /// \returns true if the file could not be read.
+  bool read(StringRef Path) {
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::MemoryBuffer::getFile(Path, Buffer))
+      return true;
+
+    SmallVector<StringRef, 256> Lines;
+    Buffer->getBuffer().split(Lines, "\n", -1, /*KeepEmpty=*/false);
+    for (unsigned I = 0, N = Lines.size(); I != N; ++I) {
+      std::pair<StringRef, StringRef> Entry = Lines[I].split(' ');
+      if (Entry.first == "identifier")
+        addIdentifier(Entry.second);
+      else if (Entry.first == "selector")
+        addSelector(Entry.second);
+    }
+    return false;
+  }
+
+  void write(raw_ostream &OS) const {
+    for (llvm::StringSet<>::const_iterator I = Identifiers.begin(),
+                                           E = Identifiers.end();
+         I != E; ++I)
+      OS << "identifier " << I->getKey() << '\n';
+    for (llvm::StringSet<>::const_iterator I = Selectors.begin(),
+                                           E = Selectors.end();
+         I != E; ++I)
+      OS << "selector " << I->getKey() << '\n';
+  }
+};
+
+/// \brief Records the entities the ASTReader deserializes and the time spent
+/// reading each kind of record.
+///
+/// Counts come from the \c ASTDeserializationListener callbacks, so the
+/// statistics object can be installed with
+/// \c ASTReader::setDeserializationListener; any listener that was already
+/// installed is passed as \p Next and keeps receiving every callback.
+///
+/// Times come from \c RecordTimer scopes that the reader opens around the
+/// reading of each record once \c ASTReader::setDeserializationStats has been
+/// called.  Nested records (a decl whose type pulls in another decl, say) are
+/// charged to the innermost record only, so the per-kind times add up to the
+/// total time spent deserializing.
+class DeserializationStats : public ASTDeserializationListener {
+public:
+  /// \brief The kinds of records that are timed.
+  enum RecordKind {
+    RK_Decl,
+    RK_Type,
+    RK_Identifier,
+    RK_Selector,
+    RK_Macro,
+    RK_LexicalDeclContext,
+    RK_VisibleDeclContext,
+    RK_MethodPool,
+    RK_Statement,
+    RK_BufferDecompression,
+    NumRecordKinds
+  };
+
+  /// \brief Times the reading of one record for as long as it is live.
+  class RecordTimer {
+    DeserializationStats *Stats;
+
+  public:
+    RecordTimer(DeserializationStats *Stats, RecordKind Kind) : Stats(Stats) {
+      if (Stats)
+        Stats->startRecord(Kind);
+    }
+    ~RecordTimer() {
+      if (Stats)
+        Stats->finishRecord();
+    }
+  };
+
+private:
+  ASTDeserializationListener *Next;
+
+  struct KindInfo {
+    unsigned Count;
+    uint64_t SelfMicroseconds;
+    KindInfo() : Count(0), SelfMicroseconds(0) {}
+  };
+  KindInfo Kinds[NumRecordKinds];
+
+  /// \brief The records currently being read, innermost last, with the time
+  /// at which each one last became the innermost record.
+  SmallVector<std::pair<RecordKind, uint64_t>, 8> Active;
+
+  /// \brief Number of decls read, by decl kind name.
+  llvm::StringMap<unsigned> DeclsByKind;
+
+  unsigned NumIdentifiers, NumTypes, NumSelectors, NumMacros, NumModules;
+
+  /// \brief The compressed and uncompressed sizes of the buffers inflated.
+  uint64_t CompressedBufferBytes, UncompressedBufferBytes;
+
+  /// \brief The identifiers and selectors that have been read.
+  DeserializationProfile Profile;
+
+  static uint64_t now() { return llvm::sys::TimeValue::now().usec(); }
+
+  void startRecord(RecordKind Kind) {
+    uint64_t Now = now();
+    if (!Active.empty())
+      Kinds[Active.back().first].SelfMicroseconds += Now - Active.back().second;
+    Active.push_back(std::make_pair(Kind, Now));
+    ++Kinds[Kind].Count;
+  }
+
+  void finishRecord() {
+    uint64_t Now = now();
+    Kinds[Active.back().first].SelfMicroseconds += Now - Active.back().second;
+    Active.pop_back();
+    if (!Active.empty())
+      Active.back().second = Now;
+  }
+
+  static const char *getRecordKindName(RecordKind Kind) {
+    switch (Kind) {
+    case RK_Decl: return "decls";
+    case RK_Type: return "types";
+    case RK_Identifier: return "identifiers";
+    case RK_Selector: return "selectors";
+    case RK_Macro: return "macros";
+    case RK_LexicalDeclContext: return "lexical decl contexts";
+    case RK_VisibleDeclContext: return "visible decl contexts";
+    case RK_MethodPool: return "method pool entries";
+    case RK_Statement: return "statements";
+    case RK_BufferDecompression: return "decompressed buffers";
+    case NumRecordKinds: break;
+    }
+    return "unknown";
+  }
+
+public:
+  explicit DeserializationStats(ASTDeserializationListener *Next = 0)
+    : Next(Next), NumIdentifiers(0), NumTypes(0), NumSelectors(0),
+      NumMacros(0), NumModules(0), CompressedBufferBytes(0),
+      UncompressedBufferBytes(0) {}
+
+  /// \brief Retrieve the identifiers and selectors read so far, for writing
+  /// a profile that drives deferred table loading on later runs.
+  const DeserializationProfile &getProfile() const { return Profile; }
+
+  unsigned getNumRecords(RecordKind Kind) const { return Kinds[Kind].Count; }
+
+  /// \brief Retrieve the time spent reading records of kind \p Kind,
+  /// excluding nested records, in microseconds.
+  uint64_t getRecordTime(RecordKind Kind) const {
+    return Kinds[Kind].SelfMicroseconds;
+  }
+
+  /// \brief Note that a SM_SLOC_BUFFER_BLOB_COMPRESSED of \p CompressedSize
+  /// bytes was inflated to \p Size bytes.  The time it took is recorded by
+  /// an RK_BufferDecompression RecordTimer.
+  void BufferDecompressed(uint64_t CompressedSize, uint64_t Size) {
+    CompressedBufferBytes += CompressedSize;
+    UncompressedBufferBytes += Size;
+  }
+
+  void ReaderInitialized(ASTReader *Reader) override {
+    if (Next)
+      Next->ReaderInitialized(Reader);
+  }
+  void IdentifierRead(serialization::IdentID ID, IdentifierInfo *II) override {
+    ++NumIdentifiers;
+    if (II)
+      Profile.addIdentifier(II->getName());
+    if (Next)
+      Next->IdentifierRead(ID, II);
+  }
+  void MacroRead(serialization::MacroID ID, MacroInfo *MI) override {
+    ++NumMacros;
+    if (Next)
+      Next->MacroRead(ID, MI);
+  }
+  void TypeRead(serialization::TypeIdx Idx, QualType T) override {
+    ++NumTypes;
+    if (Next)
+      Next->TypeRead(Idx, T);
+  }
+  void DeclRead(serialization::DeclID ID, const Decl *D) override {
+    ++DeclsByKind[D->getDeclKindName()];
+    if (Next)
+      Next->DeclRead(ID, D);
+  }
+  void SelectorRead(serialization::SelectorID ID, Selector Sel) override {
+    ++NumSelectors;
+    Profile.addSelector(Sel.getAsString());
+    if (Next)
+      Next->SelectorRead(ID, Sel);
+  }
+  void MacroDefinitionRead(serialization::PreprocessedEntityID ID,
+                           MacroDefinition *MD) override {
+    if (Next)
+      Next->MacroDefinitionRead(ID, MD);
+  }
+  void ModuleRead(serialization::SubmoduleID ID, Module *Mod) override {
+    ++NumModules;
+    if (Next)
+      Next->ModuleRead(ID, Mod);
+  }
+
+  /// \brief Print the statistics in the style of \c ASTReader::PrintStats.
+  void print(raw_ostream &OS) const {
+    OS << "*** AST deserialization statistics:\n";
+    OS << "  " << NumIdentifiers << " identifiers read\n";
+    OS << "  " << NumTypes << " types read\n";
+    OS << "  " << NumSelectors << " selectors read\n";
+    OS << "  " << NumMacros << " macros read\n";
+    OS << "  " << NumModules << " submodules read\n";
+    if (unsigned N = Kinds[RK_BufferDecompression].Count)
+      OS << "  " << N << " buffers decompressed (" << CompressedBufferBytes
+         << " bytes to " << UncompressedBufferBytes << " bytes)\n";
+
+    OS << "  Decls read, by kind:\n";
+    for (llvm::StringMap<unsigned>::const_iterator I = DeclsByKind.begin(),
+                                                   E = DeclsByKind.end();
+         I != E; ++I)
+      OS << "    " << I->getValue() << " " << I->getKey() << "\n";
+
+    OS << "  Time spent, by record kind:\n";
+    for (unsigned K = 0; K != NumRecordKinds; ++K) {
+      if (!Kinds[K].Count)
+        continue;
+      OS << "    " << Kinds[K].Count << " "
+         << getRecordKindName(RecordKind(K)) << " in "
+         << Kinds[K].SelfMicroseconds << "us\n";
+    }
+  }
+};
+
+} // end namespace clang
+
+#endif
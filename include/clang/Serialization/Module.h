@@ -424,6 +424,16 @@ public:
   /// module.
   SmallVector<uint64_t, 1> ObjCCategories;
 
+  /// \brief Array of record layout location information within this module
+  /// file, sorted by the definition ID.
+  const serialization::RecordLayoutInfo *RecordLayoutsMap;
+
+  /// \brief The number of entries in RecordLayoutsMap.
+  unsigned LocalNumRecordLayoutsInMap;
+
+  /// \brief The record layouts computed when this module file was built.
+  SmallVector<uint64_t, 1> RecordLayouts;
+
   // === Types ===
 
   /// \brief The number of types in this AST file.
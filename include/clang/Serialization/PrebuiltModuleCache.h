@@ -0,0 +1,406 @@
+//===--- PrebuiltModuleCache.h - Shared module cache archives ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the PrebuiltModuleCache class, which exports the module
+// files of a local module cache into a shared archive directory together with
+// a merged global module index, and seeds other module caches from it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SERIALIZATION_PREBUILT_MODULE_CACHE_H
+#define LLVM_CLANG_SERIALIZATION_PREBUILT_MODULE_CACHE_H
+
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/LLVM.h"
+#include "clang/Serialization/GlobalModuleIndex.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <memory>
+#include <string>
+
+namespace clang {
+
+/// \brief A shared, read-mostly archive of prebuilt module caches.
+///
+/// Each archive entry is keyed by the SDK version and the module hash of the
+/// configuration that built it (see \c computeKey), and is laid out as
+///
+/// \code
+///   <Root>/<Key>/CURRENT        the number of the published generation
+///   <Root>/<Key>/<N>/*.pcm      the module files of generation N
+///   <Root>/<Key>/<N>/modules.idx
+///   <Root>/<Key>/<N>/MANIFEST
+/// \endcode
+///
+/// A published generation is never modified again, so any number of clients
+/// can import from it or read its global module index without taking a lock.
+/// Only exporters coordinate, through a \c LockFileManager on \c CURRENT: the
+/// exporter that owns the lock merges the previous generation with its own
+/// module files into generation N+1, builds a global module index over the
+/// union and then publishes it by atomically replacing \c CURRENT.
+///
+/// Module files record the size and modification time of the module files
+/// they import, so both export and import preserve modification times.
+/// Module files also refer to their imports (and to the headers they were
+/// built from) by path, so an archive can only be imported into a module
+/// cache at the path it was exported from, with the SDK at the same location;
+/// agents typically agree on a fixed module cache path for this purpose.
+class PrebuiltModuleCache {
+public:
+  /// \brief The result of an export or import operation.
+  enum ErrorCode {
+    /// \brief The operation succeeded.
+    EC_None,
+    /// \brief There is no archive entry for the key.
+    EC_NotFound,
+    /// \brief Another exporter held the lock for too long.
+    EC_Busy,
+    /// \brief The archive entry was exported from a different module cache
+    /// path and cannot be imported here.
+    EC_PathMismatch,
+    /// \brief There was an unspecified I/O error.
+    EC_IOError
+  };
+
+private:
+  /// \brief The root directory of the shared archive.
+  std::string Root;
+
+  /// \brief Statistics for this instance.
+  unsigned NumFilesExported, NumFilesImported;
+
+  static StringRef getFormatVersion() { return "clang-prebuilt-modules-1"; }
+
+  PrebuiltModuleCache(const PrebuiltModuleCache &) LLVM_DELETED_FUNCTION;
+  PrebuiltModuleCache &
+  operator=(const PrebuiltModuleCache &) LLVM_DELETED_FUNCTION;
+
+public:
+  explicit PrebuiltModuleCache(StringRef Root)
+    : Root(Root), NumFilesExported(0), NumFilesImported(0) {}
+
+  StringRef getRoot() const { return Root; }
+
+  unsigned getNumFilesExported() const { return NumFilesExported; }
+  unsigned getNumFilesImported() const { return NumFilesImported; }
+
+  /// \brief Compute the archive key for a configuration.
+  ///
+  /// \param SDKVersion The version of the SDK the modules were built against,
+  /// e.g. "iphoneos7.1".
+  ///
+  /// \param ModuleHash The module hash of the configuration, as returned by
+  /// \c CompilerInvocation::getModuleHash(); it covers the language options,
+  /// the target, the sysroot and the other flags that affect module files.
+  static void computeKey(StringRef SDKVersion, StringRef ModuleHash,
+                         SmallString<32> &Key) {
+    llvm::MD5 Hash;
+    const uint8_t Separator = 0;
+    Hash.update(getFormatVersion());
+    Hash.update(Separator);
+    Hash.update(SDKVersion);
+    Hash.update(Separator);
+    Hash.update(ModuleHash);
+
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    llvm::MD5::stringifyResult(Result, Key);
+  }
+
+  /// \brief Retrieve the directory of the published generation for \p Key.
+  ///
+  /// The returned directory can be passed to \c GlobalModuleIndex::readIndex
+  /// directly; it is immutable once published.
+  ///
+  /// \returns \c EC_None on success, or \c EC_NotFound if no generation has
+  /// been published for \p Key.
+  ErrorCode getPublishedDir(StringRef Key, SmallVectorImpl<char> &Dir) const {
+    unsigned Generation;
+    if (!readCurrentGeneration(Key, Generation))
+      return EC_NotFound;
+    getGenerationDir(Key, Generation, Dir);
+    return EC_None;
+  }
+
+  /// \brief Export the module files in \p ModuleCacheDir into the archive.
+  ///
+  /// \param FileMgr The file manager used to load module files while the
+  /// merged global module index is built.
+  ///
+  /// \param ModuleCacheDir The module cache directory for the configuration
+  /// identified by \p Key, i.e. the module cache path with the module hash
+  /// appended.
+  ErrorCode exportCache(FileManager &FileMgr, StringRef Key,
+                        StringRef ModuleCacheDir) {
+    SmallString<256> EntryDir(Root);
+    llvm::sys::path::append(EntryDir, Key);
+    if (llvm::sys::fs::create_directories(Twine(EntryDir)))
+      return EC_IOError;
+
+    SmallString<256> CurrentPath(EntryDir);
+    llvm::sys::path::append(CurrentPath, "CURRENT");
+
+    // Only one exporter at a time may create a generation.  If someone else
+    // is exporting, wait for them and then merge on top of their result.
+    for (unsigned Attempt = 0; ; ++Attempt) {
+      llvm::LockFileManager Lock(CurrentPath);
+      switch (Lock) {
+      case llvm::LockFileManager::LFS_Error:
+        return EC_IOError;
+
+      case llvm::LockFileManager::LFS_Shared:
+        if (Lock.waitForUnlock() == llvm::LockFileManager::Res_Timeout &&
+            Attempt != 0)
+          return EC_Busy;
+        continue;
+
+      case llvm::LockFileManager::LFS_Owned:
+        return exportLocked(FileMgr, Key, ModuleCacheDir);
+      }
+    }
+  }
+
+  /// \brief Seed the module cache directory \p ModuleCacheDir from the
+  /// published generation for \p Key.
+  ///
+  /// Module files which already exist in \p ModuleCacheDir are left alone.
+  /// No lock is taken: the published generation is never modified, and every
+  /// file is copied to a unique temporary name and renamed into place, so
+  /// concurrent compilations using \p ModuleCacheDir never observe a
+  /// partially written module file.
+  ErrorCode importCache(StringRef Key, StringRef ModuleCacheDir) {
+    SmallString<256> GenDir;
+    if (ErrorCode EC = getPublishedDir(Key, GenDir))
+      return EC;
+
+    SmallString<256> ManifestPath(GenDir);
+    llvm::sys::path::append(ManifestPath, "MANIFEST");
+    std::unique_ptr<llvm::MemoryBuffer> Manifest;
+    if (llvm::MemoryBuffer::getFile(ManifestPath.str(), Manifest))
+      return EC_IOError;
+
+    // The first line records the module cache directory the modules were
+    // built in; the remaining lines name the module files.
+    SmallVector<StringRef, 64> Lines;
+    Manifest->getBuffer().split(Lines, "\n", -1, /*KeepEmpty=*/false);
+    if (Lines.empty())
+      return EC_IOError;
+    SmallString<256> Dest(ModuleCacheDir);
+    llvm::sys::fs::make_absolute(Dest);
+    if (Lines[0] != Dest.str())
+      return EC_PathMismatch;
+
+    if (llvm::sys::fs::create_directories(Twine(Dest)))
+      return EC_IOError;
+
+    // Only take the global module index along when the destination is fresh;
+    // otherwise it would not describe the module files already there.
+    bool HadModules = containsModuleFiles(Dest);
+    for (unsigned I = 1, N = Lines.size(); I != N; ++I) {
+      StringRef Name = Lines[I];
+      if (Name == "modules.idx" && HadModules)
+        continue;
+
+      SmallString<256> From(GenDir), To(Dest);
+      llvm::sys::path::append(From, Name);
+      llvm::sys::path::append(To, Name);
+      if (llvm::sys::fs::exists(Twine(To)))
+        continue;
+      if (!copyPreservingTime(From, To))
+        return EC_IOError;
+      ++NumFilesImported;
+    }
+    return EC_None;
+  }
+
+  /// \brief Print statistics to the given stream.
+  void printStats(raw_ostream &OS) const {
+    OS << "prebuilt module cache: " << NumFilesExported << " files exported, "
+       << NumFilesImported << " files imported (" << Root << ")\n";
+  }
+
+private:
+  void getGenerationDir(StringRef Key, unsigned Generation,
+                        SmallVectorImpl<char> &Dir) const {
+    Dir.clear();
+    Dir.append(Root.begin(), Root.end());
+    llvm::sys::path::append(Dir, Key, Twine(Generation));
+  }
+
+  bool readCurrentGeneration(StringRef Key, unsigned &Generation) const {
+    SmallString<256> CurrentPath(Root);
+    llvm::sys::path::append(CurrentPath, Key, "CURRENT");
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::MemoryBuffer::getFile(CurrentPath.str(), Buffer))
+      return false;
+    return !Buffer->getBuffer().trim().getAsInteger(10, Generation);
+  }
+
+  static bool isModuleFile(StringRef Path) {
+    return llvm::sys::path::extension(Path) == ".pcm";
+  }
+
+  static bool containsModuleFiles(StringRef Dir) {
+    llvm::error_code EC;
+    for (llvm::sys::fs::directory_iterator It(Dir, EC), End; It != End && !EC;
+         It.increment(EC))
+      if (isModuleFile(It->path()))
+        return true;
+    return false;
+  }
+
+  /// \brief Copy the module files of \p FromDir into \p ToDir, skipping any
+  /// whose name is already in \p Copied.
+  bool copyModuleFiles(StringRef FromDir, StringRef ToDir,
+                       llvm::StringSet<> &Copied) {
+    llvm::error_code EC;
+    for (llvm::sys::fs::directory_iterator It(FromDir, EC), End;
+         It != End && !EC; It.increment(EC)) {
+      StringRef Name = llvm::sys::path::filename(It->path());
+      if (!isModuleFile(Name) || !Copied.insert(Name))
+        continue;
+      SmallString<256> To(ToDir);
+      llvm::sys::path::append(To, Name);
+      if (!copyPreservingTime(It->path(), To))
+        return false;
+    }
+    return !EC;
+  }
+
+  /// \brief Remove \p Dir and the files directly inside it.
+  static void removeDirectory(StringRef Dir) {
+    llvm::error_code EC;
+    for (llvm::sys::fs::directory_iterator It(Dir, EC), End; It != End && !EC;
+         It.increment(EC))
+      llvm::sys::fs::remove(It->path());
+    llvm::sys::fs::remove(Dir);
+  }
+
+  ErrorCode exportLocked(FileManager &FileMgr, StringRef Key,
+                         StringRef ModuleCacheDir) {
+    unsigned Previous = 0;
+    bool HasPrevious = readCurrentGeneration(Key, Previous);
+
+    // A directory for the next generation may be left over from an exporter
+    // that died before publishing it; nobody can be reading it.
+    SmallString<256> GenDir;
+    getGenerationDir(Key, Previous + 1, GenDir);
+    removeDirectory(GenDir);
+    if (llvm::sys::fs::create_directories(Twine(GenDir)))
+      return EC_IOError;
+
+    // The local module files win over the ones in the previous generation;
+    // if they were imported from it, they are identical anyway.
+    SmallString<256> Source(ModuleCacheDir);
+    llvm::sys::fs::make_absolute(Source);
+    llvm::StringSet<> Copied;
+    if (!copyModuleFiles(Source, GenDir, Copied)) {
+      removeDirectory(GenDir);
+      return EC_IOError;
+    }
+    unsigned NumLocal = Copied.size();
+    if (HasPrevious) {
+      SmallString<256> PrevDir;
+      getGenerationDir(Key, Previous, PrevDir);
+      if (!copyModuleFiles(PrevDir, GenDir, Copied)) {
+        removeDirectory(GenDir);
+        return EC_IOError;
+      }
+    }
+
+    if (GlobalModuleIndex::writeIndex(FileMgr, GenDir) !=
+        GlobalModuleIndex::EC_None) {
+      removeDirectory(GenDir);
+      return EC_IOError;
+    }
+
+    // Write the manifest, then publish the generation.
+    {
+      std::string Manifest = Source.str();
+      Manifest += '\n';
+      for (llvm::StringSet<>::iterator I = Copied.begin(), E = Copied.end();
+           I != E; ++I) {
+        Manifest += I->getKey();
+        Manifest += '\n';
+      }
+      Manifest += "modules.idx\n";
+
+      SmallString<256> ManifestPath(GenDir), CurrentPath(Root);
+      llvm::sys::path::append(ManifestPath, "MANIFEST");
+      llvm::sys::path::append(CurrentPath, Key, "CURRENT");
+      if (llvm::writeFileAtomically(ManifestPath.str(), Manifest) ||
+          llvm::writeFileAtomically(CurrentPath.str(),
+                                    llvm::utostr(Previous + 1) + "\n")) {
+        removeDirectory(GenDir);
+        return EC_IOError;
+      }
+    }
+    NumFilesExported += NumLocal;
+
+    // Clients that read CURRENT just before it changed may still be copying
+    // from the previous generation, so only retire the one before that.
+    if (Previous > 0) {
+      SmallString<256> RetiredDir;
+      getGenerationDir(Key, Previous - 1, RetiredDir);
+      removeDirectory(RetiredDir);
+    }
+    return EC_None;
+  }
+
+  /// \brief Copy \p From to \p To through a temporary file, giving the copy
+  /// the modification time of the original.
+  static bool copyPreservingTime(StringRef From, StringRef To) {
+    llvm::sys::fs::file_status Status;
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::sys::fs::status(From, Status) ||
+        llvm::MemoryBuffer::getFile(From, Buffer, -1,
+                                    /*RequiresNullTerminator=*/false))
+      return false;
+
+    int TempFD;
+    SmallString<256> TempPath;
+    if (llvm::sys::fs::createUniqueFile(Twine(To) + ".tmp-%%%%%%%%", TempFD,
+                                        TempPath))
+      return false;
+
+    bool Written;
+    {
+      llvm::raw_fd_ostream OS(TempFD, /*shouldClose=*/true);
+      OS << Buffer->getBuffer();
+      OS.flush();
+      Written = !OS.has_error() &&
+                !llvm::sys::fs::setLastModificationAndAccessTime(
+                    TempFD, Status.getLastModificationTime());
+      OS.close();
+      if (OS.has_error()) {
+        OS.clear_error();
+        Written = false;
+      }
+    }
+    if (!Written || llvm::sys::fs::rename(Twine(TempPath), Twine(To))) {
+      llvm::sys::fs::remove(Twine(TempPath));
+      return false;
+    }
+    return true;
+  }
+};
+
+} // end namespace clang
+
+#endif
@@ -96,6 +96,25 @@ enum CXXInlineableMemberKind {
   CIMK_Destructors
 };
 
+/// \brief Describes the orders in which the analyzer can explore the paths
+/// of a function.
+enum ExplorationStrategyKind {
+  ESK_NotSet = 0,
+
+  /// Explore the most recently reached program point first.
+  ESK_DFS = 1,
+
+  /// Explore the earliest reached program point first.
+  ESK_BFS = 2,
+
+  /// Explore blocks breadth-first and the statements of a block depth-first.
+  ESK_BFSBlockDFSContents = 3,
+
+  /// Explore the least visited program point first, so that a budget-limited
+  /// analysis covers more blocks.
+  ESK_UnexploredFirst = 4
+};
+
 /// \brief Describes the different modes of inter-procedural analysis.
 enum IPAKind {
   IPAK_NotSet = 0,
@@ -189,6 +208,12 @@ private:
 
   /// Controls which C++ member functions will be considered for inlining.
   CXXInlineableMemberKind CXXMemberInliningMode;
+
+  /// \sa getExplorationStrategy
+  ExplorationStrategyKind ExplorationStrategy;
+
+  /// \sa shouldReportExplorationRate
+  Optional<bool> ReportExplorationRate;
   
   /// \sa includeTemporaryDtorsInCFG
   Optional<bool> IncludeTemporaryDtorsInCFG;
@@ -242,6 +267,9 @@ private:
   /// \sa getMaxNodesPerTopLevelFunction
   Optional<unsigned> MaxNodesPerTopLevelFunction;
 
+  /// \sa getMaxMemoryPerTopLevelFunction
+  Optional<unsigned> MaxMemoryPerTopLevelFunction;
+
 public:
   /// Interprets an option's string value as a boolean.
   ///
@@ -263,6 +291,20 @@ public:
   /// \brief Returns the inter-procedural analysis mode.
   IPAKind getIPAMode();
 
+  /// Returns the order in which paths are explored: "dfs" (the default),
+  /// "bfs", "bfs-block-dfs-contents" or "unexplored-first".
+  ///
+  /// This is controlled by the 'exploration-strategy' config option.
+  ExplorationStrategyKind getExplorationStrategy();
+
+  /// Returns whether the number of blocks covered per second and per
+  /// megabyte should be printed at the end of the analysis, to compare
+  /// exploration strategies.
+  ///
+  /// This is controlled by the 'report-exploration-rate' config option,
+  /// which accepts the values "true" and "false".
+  bool shouldReportExplorationRate();
+
   /// Returns the option controlling which C++ member functions will be
   /// considered for inlining.
   ///
@@ -405,6 +447,21 @@ public:
   /// This is controlled by the 'max-nodes' config option.
   unsigned getMaxNodesPerTopLevelFunction();
 
+  /// Returns the maximum number of megabytes the exploded graph of a top
+  /// level function, with its program states, may use.  Nodes are reclaimed
+  /// more aggressively past half of it.
+  /// 0 is default, which means no limit.
+  ///
+  /// This is controlled by the 'max-memory' config option.
+  unsigned getMaxMemoryPerTopLevelFunction();
+
+  /// Returns the path of the file that keeps function summaries across
+  /// analyzer runs, so that unchanged functions are not explored again.
+  /// Empty is default, which disables the file.
+  ///
+  /// This is controlled by the 'summary-cache' config option.
+  StringRef getSummaryCachePath();
+
 public:
   AnalyzerOptions() :
     AnalysisStoreOpt(RegionStoreModel),
@@ -427,7 +484,8 @@ public:
     InliningMode(NoRedundancy),
     UserMode(UMK_NotSet),
     IPAMode(IPAK_NotSet),
-    CXXMemberInliningMode() {}
+    CXXMemberInliningMode(),
+    ExplorationStrategy(ESK_NotSet) {}
 
 };
   
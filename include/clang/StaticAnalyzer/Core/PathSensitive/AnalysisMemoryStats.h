@@ -0,0 +1,77 @@
+//===--- AnalysisMemoryStats.h - Analyzer memory statistics -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines AnalysisMemoryStats, which reports where the memory of
+//  the path-sensitive analysis of a function goes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_GR_ANALYSISMEMORYSTATS_H
+#define LLVM_CLANG_GR_ANALYSISMEMORYSTATS_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/ExplodedGraph.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace clang {
+namespace ento {
+
+/// \brief The size of an exploded graph and of the program states it refers
+/// to, printed with -analyzer-stats.
+struct AnalysisMemoryStats {
+  unsigned NumNodes;
+  unsigned NumReclaimedNodes;
+  unsigned NumStates;
+  unsigned NumStateRequests;
+
+  /// The bytes taken by the nodes and by the states themselves.
+  uint64_t NodeBytes;
+  uint64_t StateBytes;
+
+  /// The bytes taken by everything else in the allocator: the stores,
+  /// environments and generic data maps of the states, and the predecessor
+  /// and successor lists of the nodes.
+  uint64_t OtherBytes;
+
+  AnalysisMemoryStats(ExplodedGraph &G, const ProgramStateManager &StateMgr)
+    : NumNodes(G.size()), NumReclaimedNodes(G.getNumReclaimedNodes()),
+      NumStates(StateMgr.getNumStates()),
+      NumStateRequests(StateMgr.getNumStateRequests()),
+      NodeBytes(uint64_t(NumNodes) * sizeof(ExplodedNode)),
+      StateBytes(uint64_t(NumStates) * sizeof(ProgramState)) {
+    uint64_t Total = G.getMemoryUsage();
+    OtherBytes = Total > NodeBytes + StateBytes ?
+                 Total - NodeBytes - StateBytes : 0;
+  }
+
+  uint64_t getTotalBytes() const { return NodeBytes + StateBytes + OtherBytes; }
+
+  /// Returns the fraction of state requests answered by an existing state.
+  double getStateSharingRatio() const {
+    if (!NumStateRequests || NumStates >= NumStateRequests)
+      return 0;
+    return 1.0 - double(NumStates) / NumStateRequests;
+  }
+
+  void print(raw_ostream &OS) const {
+    OS << "Nodes: " << NumNodes << " (" << NumReclaimedNodes
+       << " reclaimed), " << NodeBytes << " bytes\n"
+       << "States: " << NumStates << " of " << NumStateRequests
+       << " requested (" << unsigned(getStateSharingRatio() * 100 + 0.5)
+       << "% shared), " << StateBytes << " bytes\n"
+       << "Stores, environments and edges: " << OtherBytes << " bytes\n"
+       << "Total: " << getTotalBytes() << " bytes\n";
+  }
+};
+
+} // end namespace ento
+} // end namespace clang
+
+#endif
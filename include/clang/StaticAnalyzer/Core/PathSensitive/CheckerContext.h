@@ -17,6 +17,7 @@
 
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
+#include "llvm/ADT/ImmutableHashMap.h"
 
 namespace clang {
 namespace ento {
@@ -37,6 +38,19 @@ namespace ento {
     REGISTER_TRAIT_WITH_PROGRAMSTATE(Name, \
                                      CLANG_ENTO_PROGRAMSTATE_MAP(Key, Value))
 
+  /// Declares an immutable map of type \p NameTy like
+  /// REGISTER_MAP_WITH_PROGRAMSTATE, implemented using llvm::ImmutableHashMap.
+  ///
+  /// Updates of the hash map allocate less than those of ImmutableMap, whose
+  /// rebalancing copies several nodes, which pays off for traits that hold
+  /// many entries and change often, such as per-symbol checker state.  The
+  /// key type must have a DenseMapInfo, and its iteration order is not the
+  /// key order.
+  #define REGISTER_HASH_MAP_WITH_PROGRAMSTATE(Name, Key, Value) \
+    REGISTER_TRAIT_WITH_PROGRAMSTATE(Name, \
+                                     CLANG_ENTO_PROGRAMSTATE_HASH_MAP(Key, \
+                                                                      Value))
+
   /// Declares an immutable set of type \p NameTy, suitable for placement into
   /// the ProgramState. This is implementing using llvm::ImmutableSet.
   ///
@@ -108,10 +108,14 @@ private:
 
 public:
   /// Construct a CoreEngine object to analyze the provided CFG.
+  ///
+  /// \param WL The worklist to explore paths with, which the engine takes
+  /// ownership of; a depth-first one if null.
   CoreEngine(SubEngine& subengine,
-             FunctionSummariesTy *FS)
+             FunctionSummariesTy *FS,
+             WorkList *WL = 0)
     : SubEng(subengine), G(new ExplodedGraph()),
-      WList(WorkList::makeDFS()),
+      WList(WL ? WL : WorkList::makeDFS()),
       BCounterFactory(G->getAllocator()),
       FunctionSummaries(FS){}
 
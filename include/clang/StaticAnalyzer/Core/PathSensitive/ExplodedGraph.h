@@ -287,6 +287,15 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
 
+  /// The number of bytes of the node allocator, which also holds the program
+  /// states and their stores and environments, that the graph may use.
+  ///
+  /// If this is 0, memory use is not limited.
+  uint64_t MemoryBudget;
+
+  /// The number of nodes reclaimed so far.
+  unsigned NumReclaimedNodes;
+
 public:
 
   /// \brief Retrieve the node associated with a (Location,State) pair,
@@ -378,10 +387,38 @@ public:
 
   /// Enable tracking of recently allocated nodes for potential reclamation
   /// when calling reclaimRecentlyAllocatedNodes().
+  ///
+  /// Once the graph is under memory pressure (see isUnderMemoryPressure()),
+  /// nodes are reclaimed every time a node is created, whatever the interval.
   void enableNodeReclamation(unsigned Interval) {
     ReclaimCounter = ReclaimNodeInterval = Interval;
   }
 
+  /// Limit the memory the graph may use to \p Bytes; 0 removes the limit.
+  ///
+  /// The budget is not enforced by the graph itself: the engine stops
+  /// exploring the function once isOverMemoryBudget() returns true, as it
+  /// does when the node budget is exhausted.
+  void setMemoryBudget(uint64_t Bytes) { MemoryBudget = Bytes; }
+  uint64_t getMemoryBudget() const { return MemoryBudget; }
+
+  /// Returns the number of bytes allocated for nodes, states and their
+  /// stores and environments.
+  size_t getMemoryUsage() { return getAllocator().getTotalMemory(); }
+
+  /// Returns true if more than half of the memory budget is used, from which
+  /// point nodes are reclaimed as soon as possible.
+  bool isUnderMemoryPressure() {
+    return MemoryBudget && getMemoryUsage() >= MemoryBudget / 2;
+  }
+
+  /// Returns true if the memory budget is used up.
+  bool isOverMemoryBudget() {
+    return MemoryBudget && getMemoryUsage() >= MemoryBudget;
+  }
+
+  unsigned getNumReclaimedNodes() const { return NumReclaimedNodes; }
+
   /// Reclaim "uninteresting" nodes created since the last time this method
   /// was called.
   void reclaimRecentlyAllocatedNodes();
@@ -109,6 +109,14 @@ public:
     return 0;
   }
 
+  /// Get the basic blocks of \p D visited so far, or null if none were.
+  const llvm::SmallBitVector *getVisitedBasicBlocks(const Decl *D) {
+    MapTy::const_iterator I = Map.find(D);
+    if (I != Map.end() && I->second.TotalBasicBlocks)
+      return &I->second.VisitedBasicBlocks;
+    return 0;
+  }
+
   unsigned getNumTimesInlined(const Decl* D) {
     MapTy::const_iterator I = Map.find(D);
     if (I != Map.end())
@@ -0,0 +1,383 @@
+//===--- PersistentFunctionSummaries.h - Cross-run summaries ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines an on-disk store of function summaries, which lets the
+// analyzer reuse what it learned about a function in earlier runs, and in
+// other translation units of the same run.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_GR_PERSISTENTFUNCTIONSUMMARIES_H
+#define LLVM_CLANG_GR_PERSISTENTFUNCTIONSUMMARIES_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
+#include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+
+namespace clang {
+namespace ento {
+
+/// \brief What an analyzer run learned about one function.
+struct PersistentFunctionSummary {
+  enum {
+    /// The function has been checked against the rules for which functions
+    /// may be inlined.
+    InlineChecked = 0x1,
+    /// The function may be inlined.
+    MayInline = 0x2,
+    /// The function was analyzed as a top level function without reaching
+    /// a budget limit and without emitting reports.
+    AnalyzedClean = 0x4
+  };
+
+  /// A hash of everything the analysis of the function depends on, such as
+  /// the tokens of its body and of the functions it may inline.  Summaries
+  /// whose hash differs from the current one are stale.
+  uint64_t ASTHash;
+
+  /// The number of times the function was inlined in the run that recorded
+  /// the summary, an estimate of what inlining it costs.
+  uint32_t TimesInlined;
+
+  uint8_t Flags;
+
+  /// The IDs of the CFG blocks visited; its size is the number of blocks.
+  llvm::SmallBitVector VisitedBasicBlocks;
+
+  PersistentFunctionSummary() : ASTHash(0), TimesInlined(0), Flags(0) {}
+
+  unsigned getSerializedSize() const {
+    return 8 + 4 + 4 + 1 + (VisitedBasicBlocks.size() + 7) / 8;
+  }
+};
+
+/// \brief OnDiskChainedHashTable traits mapping a USR to the
+/// PersistentFunctionSummary of the function it names.
+class PersistentFunctionSummaryTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef PersistentFunctionSummary data_type;
+  typedef const PersistentFunctionSummary &data_type_ref;
+
+  static unsigned ComputeHash(StringRef Key) { return llvm::HashString(Key); }
+  static bool EqualKey(StringRef A, StringRef B) { return A == B; }
+  static StringRef GetInternalKey(StringRef Key) { return Key; }
+  static StringRef GetExternalKey(StringRef Key) { return Key; }
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(raw_ostream &Out, StringRef Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<uint16_t>(Key.size());
+    LE.write<uint32_t>(Data.getSerializedSize());
+    return std::make_pair(Key.size(), Data.getSerializedSize());
+  }
+
+  static void EmitKey(raw_ostream &Out, StringRef Key, unsigned) {
+    Out << Key;
+  }
+
+  static void EmitData(raw_ostream &Out, StringRef, data_type_ref Data,
+                       unsigned) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    const llvm::SmallBitVector &Blocks = Data.VisitedBasicBlocks;
+    LE.write<uint64_t>(Data.ASTHash);
+    LE.write<uint32_t>(Data.TimesInlined);
+    LE.write<uint32_t>(Blocks.size());
+    LE.write<uint8_t>(Data.Flags);
+    for (unsigned I = 0, E = Blocks.size(); I < E; I += 8) {
+      uint8_t Byte = 0;
+      for (unsigned Bit = 0; Bit != 8 && I + Bit != E; ++Bit)
+        if (Blocks[I + Bit])
+          Byte |= 1 << Bit;
+      LE.write<uint8_t>(Byte);
+    }
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(D);
+    unsigned DataLen = endian::readNext<uint32_t, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static StringRef ReadKey(const unsigned char *D, unsigned N) {
+    return StringRef(reinterpret_cast<const char *>(D), N);
+  }
+
+  static data_type ReadData(StringRef, const unsigned char *D,
+                            unsigned DataLen) {
+    using namespace llvm::support;
+    PersistentFunctionSummary Data;
+    Data.ASTHash = endian::readNext<uint64_t, little, unaligned>(D);
+    Data.TimesInlined = endian::readNext<uint32_t, little, unaligned>(D);
+    unsigned NumBlocks = endian::readNext<uint32_t, little, unaligned>(D);
+    Data.Flags = endian::readNext<uint8_t, little, unaligned>(D);
+    // A truncated bitmap is corrupt; drop the blocks and keep the rest.
+    if (8 + 4 + 4 + 1 + (uint64_t(NumBlocks) + 7) / 8 != DataLen)
+      return Data;
+    Data.VisitedBasicBlocks.resize(NumBlocks);
+    for (unsigned I = 0; I != NumBlocks; ++I)
+      if (D[I / 8] & (1 << (I % 8)))
+        Data.VisitedBasicBlocks.set(I);
+    return Data;
+  }
+};
+
+/// \brief A file of function summaries keyed by USR, shared by the analyzer
+/// runs of a project.
+///
+/// The file is read into memory when the store is created; it is copied
+/// rather than kept mapped, so that other runs can replace it.  Summaries
+/// recorded by this run are merged into a new version of the file, which
+/// is renamed over the old one, by save(); runs that analyze several
+/// translation units at once may drop each other's summaries, which only
+/// costs re-analysis.
+///
+/// A summary is only returned when its AST hash matches the current one, so
+/// edited functions are explored again.  The file also records a hash of the
+/// analyzer configuration (the inlining mode and budgets, and the enabled
+/// checkers); a file written with another configuration is ignored.
+class PersistentFunctionSummaries {
+public:
+  typedef OnDiskIterableChainedHashTable<PersistentFunctionSummaryTrait>
+      TableTy;
+
+  /// \brief How reading the file went.
+  enum LoadResult {
+    /// \brief The summaries were read from the file.
+    Loaded,
+    /// \brief There is no file yet.
+    Missing,
+    /// \brief The file was written by another version of the analyzer or
+    /// with another configuration.
+    Mismatch,
+    /// \brief The file could not be read or is corrupt.
+    Invalid
+  };
+
+private:
+  enum {
+    Magic = 0x41534653, // 'SFSA'
+    Version = 1,
+    HeaderSize = 24
+  };
+
+  std::string File;
+  uint64_t ConfigHash;
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<TableTy> Table;
+  LoadResult Result;
+
+  /// \brief Summaries recorded by this run that are not yet on disk.
+  llvm::StringMap<PersistentFunctionSummary> NewSummaries;
+
+  unsigned NumHits, NumStale, NumMisses;
+
+  /// \brief Read and validate the file, returning the table on success and
+  /// null otherwise, with the reason in \p Result.
+  static TableTy *loadTable(StringRef File, uint64_t ConfigHash,
+                            std::unique_ptr<llvm::MemoryBuffer> &Buffer,
+                            LoadResult &Result) {
+    using namespace llvm::support;
+    Buffer.reset();
+    std::unique_ptr<llvm::MemoryBuffer> Mapped;
+    if (llvm::error_code EC = llvm::MemoryBuffer::getFile(
+            File, Mapped, -1, /*RequiresNullTerminator=*/false)) {
+      Result = EC == llvm::errc::no_such_file_or_directory ? Missing : Invalid;
+      return 0;
+    }
+    Result = Invalid;
+    if (Mapped->getBufferSize() < HeaderSize + 8)
+      return 0;
+    Buffer.reset(llvm::MemoryBuffer::getMemBufferCopy(Mapped->getBuffer(),
+                                                      File));
+    Mapped.reset();
+
+    const unsigned char *Base =
+        reinterpret_cast<const unsigned char *>(Buffer->getBufferStart());
+    const unsigned char *D = Base;
+    if (endian::readNext<uint32_t, little, aligned>(D) != Magic)
+      return 0;
+    if (endian::readNext<uint32_t, little, aligned>(D) != Version ||
+        endian::readNext<uint64_t, little, aligned>(D) != ConfigHash) {
+      Result = Mismatch;
+      return 0;
+    }
+    uint32_t TableOffset = endian::readNext<uint32_t, little, aligned>(D);
+    if (TableOffset < HeaderSize || TableOffset % 4 ||
+        TableOffset + 8 > Buffer->getBufferSize())
+      return 0;
+    Result = Loaded;
+    return TableTy::Create(Base + TableOffset, Base + HeaderSize, Base);
+  }
+
+public:
+  /// \brief Open the summaries stored in \p File by runs with the analyzer
+  /// configuration \p ConfigHash.  A missing, incompatible or corrupt file
+  /// opens an empty store, and is replaced by save(); getLoadResult() tells
+  /// these apart, so that the caller can report a corrupt file.
+  PersistentFunctionSummaries(StringRef File, uint64_t ConfigHash)
+    : File(File), ConfigHash(ConfigHash), NumHits(0), NumStale(0),
+      NumMisses(0) {
+    Table.reset(loadTable(File, ConfigHash, Buffer, Result));
+  }
+
+  StringRef getFile() const { return File; }
+  LoadResult getLoadResult() const { return Result; }
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumStale() const { return NumStale; }
+  unsigned getNumMisses() const { return NumMisses; }
+
+  /// \brief Find the summary of the function named by \p USR.
+  ///
+  /// \returns true if there is a summary whose AST hash is \p ASTHash.
+  bool lookup(StringRef USR, uint64_t ASTHash,
+              PersistentFunctionSummary &Result) {
+    llvm::StringMap<PersistentFunctionSummary>::iterator Known =
+        NewSummaries.find(USR);
+    if (Known != NewSummaries.end()) {
+      Result = Known->second;
+    } else if (Table) {
+      TableTy::iterator I = Table->find(USR);
+      if (I == Table->end()) {
+        ++NumMisses;
+        return false;
+      }
+      Result = *I;
+    } else {
+      ++NumMisses;
+      return false;
+    }
+    if (Result.ASTHash != ASTHash) {
+      ++NumStale;
+      return false;
+    }
+    ++NumHits;
+    return true;
+  }
+
+  /// \brief Record the summary of the function named by \p USR, replacing
+  /// the one on disk when the store is saved.
+  void record(StringRef USR, const PersistentFunctionSummary &Summary) {
+    if (USR.empty() || USR.size() > 0xFFFF)
+      return;
+    NewSummaries[USR] = Summary;
+  }
+
+  /// \brief Record what \p Summaries know about \p D, named by \p USR.
+  ///
+  /// \param AnalyzedClean Whether \p D was just analyzed as a top level
+  /// function without reaching a budget limit and without reports.
+  void record(StringRef USR, uint64_t ASTHash, const Decl *D,
+              FunctionSummariesTy &Summaries, bool AnalyzedClean) {
+    PersistentFunctionSummary Summary;
+    Summary.ASTHash = ASTHash;
+    Summary.TimesInlined = Summaries.getNumTimesInlined(D);
+    if (Optional<bool> MayInline = Summaries.mayInline(D)) {
+      Summary.Flags |= PersistentFunctionSummary::InlineChecked;
+      if (*MayInline)
+        Summary.Flags |= PersistentFunctionSummary::MayInline;
+    }
+    if (AnalyzedClean)
+      Summary.Flags |= PersistentFunctionSummary::AnalyzedClean;
+    if (const llvm::SmallBitVector *Blocks = Summaries.getVisitedBasicBlocks(D))
+      Summary.VisitedBasicBlocks = *Blocks;
+    record(USR, Summary);
+  }
+
+  /// \brief Seed \p Summaries with the inlining decision and the visited
+  /// blocks of \p D from \p Summary, so that a function which exhausted the
+  /// block budget before is not inlined and explored again.
+  ///
+  /// The number of times \p D was inlined is not imported, since it limits
+  /// inlining within one translation unit.
+  static void apply(const PersistentFunctionSummary &Summary, const Decl *D,
+                    FunctionSummariesTy &Summaries) {
+    if (Summary.Flags & PersistentFunctionSummary::InlineChecked) {
+      if (Summary.Flags & PersistentFunctionSummary::MayInline)
+        Summaries.markMayInline(D);
+      else
+        Summaries.markShouldNotInline(D);
+    }
+    const llvm::SmallBitVector &Blocks = Summary.VisitedBasicBlocks;
+    for (int I = Blocks.find_first(); I != -1; I = Blocks.find_next(I))
+      Summaries.markVisitedBasicBlock(I, D, Blocks.size());
+  }
+
+  /// \brief Merge the summaries recorded by this run into the file.
+  ///
+  /// \returns true on success, or if there was nothing to write.
+  bool save() {
+    if (NewSummaries.empty())
+      return true;
+
+    // Reload the file, which other runs may have updated since we read it.
+    std::unique_ptr<llvm::MemoryBuffer> Latest;
+    LoadResult LatestResult;
+    std::unique_ptr<TableTy> LatestTable(
+        loadTable(File, ConfigHash, Latest, LatestResult));
+
+    OnDiskChainedHashTableGenerator<PersistentFunctionSummaryTrait> Generator;
+    for (llvm::StringMap<PersistentFunctionSummary>::iterator
+             I = NewSummaries.begin(), E = NewSummaries.end(); I != E; ++I)
+      Generator.insert(I->getKey(), I->second);
+    if (LatestTable) {
+      for (TableTy::key_iterator I = LatestTable->key_begin(),
+                                 E = LatestTable->key_end(); I != E; ++I) {
+        StringRef Key = *I;
+        if (!NewSummaries.count(Key))
+          Generator.insert(Key, *LatestTable->find(Key));
+      }
+    }
+
+    SmallString<4096> Contents;
+    {
+      using namespace llvm::support;
+      llvm::raw_svector_ostream Out(Contents);
+      endian::Writer<little> LE(Out);
+      LE.write<uint32_t>(Magic);
+      LE.write<uint32_t>(Version);
+      LE.write<uint64_t>(ConfigHash);
+      LE.write<uint32_t>(0); // Table offset, patched below.
+      LE.write<uint32_t>(0); // Padding.
+      uint32_t TableOffset = Generator.Emit(Out);
+      Out.flush();
+      endian::write<uint32_t, little, unaligned>(Contents.data() + 16,
+                                                  TableOffset);
+    }
+
+    if (llvm::writeFileAtomically(File, Contents.str()))
+      return false;
+    NewSummaries.clear();
+    return true;
+  }
+};
+
+} // end namespace ento
+} // end namespace clang
+
+#endif
@@ -465,6 +465,10 @@ private:
   /// A vector of ProgramStates that we can reuse.
   std::vector<ProgramState *> freeStates;
 
+  /// The number of calls to getPersistentState, which together with the
+  /// size of StateSet tells how often states are shared.
+  unsigned NumStateRequests;
+
 public:
   ProgramStateManager(ASTContext &Ctx,
                  StoreManagerCreator CreateStoreManager,
@@ -530,6 +534,13 @@ public:
   }
 
   ProgramStateRef getPersistentState(ProgramState &Impl);
+
+  /// Returns the number of distinct states created.
+  unsigned getNumStates() const { return StateSet.size(); }
+
+  /// Returns the number of states requested, including those found to be
+  /// equal to a state created before.
+  unsigned getNumStateRequests() const { return NumStateRequests; }
   ProgramStateRef getPersistentStateWithGDM(ProgramStateRef FromState,
                                            ProgramStateRef GDMState);
 
@@ -23,6 +23,7 @@
 
 namespace llvm {
   template <typename K, typename D, typename I> class ImmutableMap;
+  template <typename K, typename D, typename I> class ImmutableHashMap;
   template <typename K, typename I> class ImmutableSet;
   template <typename T> class ImmutableList;
   template <typename T> class ImmutableListImpl;
@@ -103,6 +104,52 @@ namespace ento {
   #define CLANG_ENTO_PROGRAMSTATE_MAP(Key, Value) llvm::ImmutableMap<Key, Value>
 
 
+  // Partial-specialization for ImmutableHashMap.
+
+  template <typename Key, typename Data, typename Info>
+  struct ProgramStatePartialTrait< llvm::ImmutableHashMap<Key,Data,Info> > {
+    typedef llvm::ImmutableHashMap<Key,Data,Info> data_type;
+    typedef typename data_type::Factory&          context_type;
+    typedef Key                                   key_type;
+    typedef Data                                  value_type;
+    typedef const value_type*                     lookup_type;
+
+    static inline data_type MakeData(void *const* p) {
+      return data_type(p ? (const typename data_type::Node*) *p : 0);
+    }
+    static inline void *MakeVoidPtr(data_type B) {
+      return const_cast<typename data_type::Node*>(B.getRoot());
+    }
+    static lookup_type Lookup(data_type B, key_type K) {
+      return B.lookup(K);
+    }
+    static data_type Set(data_type B, key_type K, value_type E,context_type F){
+      return F.add(B, K, E);
+    }
+
+    static data_type Remove(data_type B, key_type K, context_type F) {
+      return F.remove(B, K);
+    }
+
+    static inline context_type MakeContext(void *p) {
+      return *((typename data_type::Factory*) p);
+    }
+
+    static void *CreateContext(llvm::BumpPtrAllocator& Alloc) {
+      return new typename data_type::Factory(Alloc);
+    }
+
+    static void DeleteContext(void *Ctx) {
+      delete (typename data_type::Factory*) Ctx;
+    }
+  };
+
+  /// Like CLANG_ENTO_PROGRAMSTATE_MAP, for maps implemented as
+  /// llvm::ImmutableHashMap.
+  #define CLANG_ENTO_PROGRAMSTATE_HASH_MAP(Key, Value) \
+    llvm::ImmutableHashMap<Key, Value>
+
+
   // Partial-specialization for ImmutableSet.
 
   template <typename Key, typename Info>
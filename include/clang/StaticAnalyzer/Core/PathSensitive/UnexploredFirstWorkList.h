@@ -0,0 +1,158 @@
+//===--- UnexploredFirstWorkList.h - Coverage-driven worklist ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines UnexploredFirstWorkList, the worklist returned by
+//  WorkList::makeUnexploredFirst(), and ExplorationRate, which measures how
+//  quickly an exploration strategy covers the blocks of the analyzed code.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_GR_UNEXPLOREDFIRSTWORKLIST_H
+#define LLVM_CLANG_GR_UNEXPLOREDFIRSTWORKLIST_H
+
+#include "clang/Analysis/ProgramPoint.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/WorkList.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <vector>
+
+namespace clang {
+namespace ento {
+
+/// \brief A worklist that explores the least visited program point first.
+///
+/// Each program point (a location in a given stack frame) counts the units
+/// dequeued at it.  The unit whose point has the lowest count is explored
+/// next, and among those the most recently enqueued, so the engine goes
+/// depth-first into code it has not seen and only comes back to loops and
+/// joins it has already explored once everything else has been reached.
+/// When the node budget runs out, the analysis has thus visited more blocks
+/// than a plain depth-first search, which keeps unrolling the first loop it
+/// finds.
+///
+/// Counts change while units wait, so priorities are refreshed lazily: a
+/// unit whose count went up since it was queued is pushed back with the new
+/// count instead of being returned.
+class UnexploredFirstWorkList : public WorkList {
+  struct Item {
+    WorkListUnit U;
+    unsigned Visits;
+    unsigned Seq;
+
+    Item(const WorkListUnit &U, unsigned Visits, unsigned Seq)
+      : U(U), Visits(Visits), Seq(Seq) {}
+
+    /// Orders items for a max-heap: fewer visits first, then newer first.
+    bool operator<(const Item &RHS) const {
+      if (Visits != RHS.Visits)
+        return Visits > RHS.Visits;
+      return Seq < RHS.Seq;
+    }
+  };
+
+  std::vector<Item> Queue;
+  llvm::DenseMap<ProgramPoint, unsigned> NumVisits;
+  unsigned NextSeq;
+
+  unsigned getNumVisits(const WorkListUnit &U) const {
+    llvm::DenseMap<ProgramPoint, unsigned>::const_iterator I =
+        NumVisits.find(U.getNode()->getLocation());
+    return I == NumVisits.end() ? 0 : I->second;
+  }
+
+public:
+  UnexploredFirstWorkList() : NextSeq(0) {}
+
+  bool hasWork() const override { return !Queue.empty(); }
+
+  void enqueue(const WorkListUnit &U) override {
+    Queue.push_back(Item(U, getNumVisits(U), NextSeq++));
+    std::push_heap(Queue.begin(), Queue.end());
+  }
+
+  WorkListUnit dequeue() override {
+    assert(!Queue.empty() && "Dequeue from an empty worklist");
+    for (;;) {
+      std::pop_heap(Queue.begin(), Queue.end());
+      Item &Top = Queue.back();
+      unsigned Visits = getNumVisits(Top.U);
+      if (Visits == Top.Visits) {
+        WorkListUnit U = Top.U;
+        Queue.pop_back();
+        ++NumVisits[U.getNode()->getLocation()];
+        return U;
+      }
+      // Stale priority; requeue with the current count.
+      Top.Visits = Visits;
+      std::push_heap(Queue.begin(), Queue.end());
+    }
+  }
+
+  bool visitItemsInWorkList(Visitor &V) override {
+    for (std::vector<Item>::iterator I = Queue.begin(), E = Queue.end();
+         I != E; ++I)
+      if (V.visit(I->U))
+        return true;
+    return false;
+  }
+};
+
+/// \brief The number of blocks covered by a set of analyses, against the
+/// time and memory they took.
+///
+/// AnalysisConsumer adds each top level function once it is analyzed, and
+/// prints the totals when the 'report-exploration-rate' option is set.
+/// Running the same code with each exploration strategy and the same
+/// budgets tells which one covers the most code in a given time.
+class ExplorationRate {
+  unsigned NumFunctions;
+  uint64_t BlocksCovered;
+  uint64_t TotalBlocks;
+  double Seconds;
+  uint64_t Bytes;
+
+public:
+  ExplorationRate()
+    : NumFunctions(0), BlocksCovered(0), TotalBlocks(0), Seconds(0),
+      Bytes(0) {}
+
+  /// \brief Add the analysis of a function which visited \p Covered of its
+  /// \p Total blocks, and the functions inlined into it, in \p Seconds of
+  /// wall time with an exploded graph of \p GraphBytes bytes.
+  void addFunction(unsigned Covered, unsigned Total, double Seconds,
+                   uint64_t GraphBytes) {
+    ++NumFunctions;
+    BlocksCovered += Covered;
+    TotalBlocks += Total;
+    this->Seconds += Seconds;
+    Bytes += GraphBytes;
+  }
+
+  double getBlocksPerSecond() const {
+    return Seconds > 0 ? BlocksCovered / Seconds : 0;
+  }
+
+  double getBlocksPerMB() const {
+    return Bytes ? BlocksCovered / (Bytes / (1024.0 * 1024.0)) : 0;
+  }
+
+  void print(raw_ostream &OS) const {
+    OS << "Blocks covered: " << BlocksCovered << " of " << TotalBlocks
+       << " in " << NumFunctions << " functions\n"
+       << llvm::format("Exploration rate: %.1f blocks/s, %.1f blocks/MB\n",
+                       getBlocksPerSecond(), getBlocksPerMB());
+  }
+};
+
+} // end namespace ento
+} // end namespace clang
+
+#endif
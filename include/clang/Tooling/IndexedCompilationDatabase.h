@@ -0,0 +1,451 @@
+//===--- IndexedCompilationDatabase.h - Binary compile commands -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements a compilation database read from a binary index of a
+//  JSON compilation database, which is memory-mapped rather than parsed, so
+//  that loading it costs the same whatever the size of the database.
+//
+//  The index of build/compile_commands.json is build/compile_commands.idx,
+//  written by IndexedCompilationDatabase::writeIndex.  It records the size
+//  and modification time of the JSON file it was built from, and is ignored
+//  once the JSON file changes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLING_INDEXED_COMPILATION_DATABASE_H
+#define LLVM_CLANG_TOOLING_INDEXED_COMPILATION_DATABASE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/OnDiskHashTable.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace tooling {
+
+/// \brief The IDs of the entries compiling one file, as stored in an
+/// IndexedCompilationDatabase.
+class OnDiskCompileCommandIDs {
+  const unsigned char *Data;
+  unsigned Count;
+
+public:
+  OnDiskCompileCommandIDs() : Data(0), Count(0) {}
+  OnDiskCompileCommandIDs(const unsigned char *Data, unsigned Count)
+    : Data(Data), Count(Count) {}
+
+  unsigned size() const { return Count; }
+
+  unsigned operator[](unsigned I) const {
+    using namespace llvm::support;
+    return endian::read<uint32_t, little, unaligned>(Data + I * 4);
+  }
+};
+
+/// \brief OnDiskChainedHashTable traits mapping a path, or a file name, to
+/// the IDs of the entries compiling it.
+class CompileCommandIndexTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  /// Written from a list of IDs, read back as OnDiskCompileCommandIDs.
+  typedef ArrayRef<uint32_t> data_type_ref;
+  typedef ArrayRef<uint32_t> data_type;
+
+  static unsigned ComputeHash(StringRef Key) { return llvm::HashString(Key); }
+  static bool EqualKey(StringRef A, StringRef B) { return A == B; }
+  static StringRef GetInternalKey(StringRef Key) { return Key; }
+  static StringRef GetExternalKey(StringRef Key) { return Key; }
+
+  static std::pair<unsigned, unsigned>
+  EmitKeyDataLength(raw_ostream &Out, StringRef Key, data_type_ref IDs) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<uint16_t>(Key.size());
+    LE.write<uint32_t>(IDs.size() * 4);
+    return std::make_pair(Key.size(), IDs.size() * 4);
+  }
+
+  static void EmitKey(raw_ostream &Out, StringRef Key, unsigned) {
+    Out << Key;
+  }
+
+  static void EmitData(raw_ostream &Out, StringRef, data_type_ref IDs,
+                       unsigned) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    for (unsigned I = 0, E = IDs.size(); I != E; ++I)
+      LE.write<uint32_t>(IDs[I]);
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(D);
+    unsigned DataLen = endian::readNext<uint32_t, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static StringRef ReadKey(const unsigned char *D, unsigned N) {
+    return StringRef(reinterpret_cast<const char *>(D), N);
+  }
+};
+
+/// \brief Reader side of CompileCommandIndexTrait.
+class CompileCommandIndexReaderTrait : public CompileCommandIndexTrait {
+public:
+  typedef OnDiskCompileCommandIDs data_type;
+
+  static data_type ReadData(StringRef, const unsigned char *D, unsigned N) {
+    return OnDiskCompileCommandIDs(D, N / 4);
+  }
+};
+
+/// \brief A compilation database memory-mapped from a binary index of a
+/// JSON compilation database.
+///
+/// Loading the database maps the index and checks its header; nothing is
+/// parsed until a command is asked for.  Each entry stores its directory,
+/// file and command line, with each argument terminated by a null character,
+/// so building a CompileCommand is a matter of splitting them.  Entries are
+/// found through two hash tables: one keyed by the native path of the file,
+/// and one keyed by its file name, through which a path that differs from
+/// the one in the database (as through a symlink) is matched, like
+/// JSONCompilationDatabase does, to the single entry for an equivalent file.
+class IndexedCompilationDatabase : public CompilationDatabase {
+  typedef OnDiskChainedHashTable<CompileCommandIndexReaderTrait> TableTy;
+
+  enum {
+    Magic = 0x58444343, // 'CCDX'
+    Version = 1,
+    HeaderSize = 40
+  };
+
+  std::unique_ptr<llvm::MemoryBuffer> Index;
+  const unsigned char *Base;
+  unsigned NumEntries;
+  const unsigned char *EntryOffsets;
+  std::unique_ptr<TableTy> PathTable;
+  std::unique_ptr<TableTy> NameTable;
+
+  IndexedCompilationDatabase(llvm::MemoryBuffer *Index)
+    : Index(Index), Base(0), NumEntries(0), EntryOffsets(0) {}
+
+  static uint32_t readEntryField(const unsigned char *&D, StringRef &Field) {
+    using namespace llvm::support;
+    uint32_t Len = endian::readNext<uint32_t, little, unaligned>(D);
+    Field = StringRef(reinterpret_cast<const char *>(D), Len);
+    D += Len;
+    return Len;
+  }
+
+  /// \brief Decode the entry \p ID, optionally only the file it compiles.
+  void readEntry(unsigned ID, StringRef &Directory, StringRef &File,
+                 std::vector<std::string> *CommandLine) const {
+    using namespace llvm::support;
+    const unsigned char *D =
+        Base + endian::read<uint32_t, little, unaligned>(EntryOffsets + ID * 4);
+    readEntryField(D, Directory);
+    readEntryField(D, File);
+    if (!CommandLine)
+      return;
+    StringRef Args;
+    readEntryField(D, Args);
+    CommandLine->clear();
+    while (!Args.empty()) {
+      std::pair<StringRef, StringRef> Split = Args.split('\0');
+      CommandLine->push_back(Split.first);
+      Args = Split.second;
+    }
+  }
+
+  static bool findIDs(TableTy &Table, StringRef Key,
+                      OnDiskCompileCommandIDs &IDs) {
+    TableTy::iterator I = Table.find(Key);
+    if (I == Table.end())
+      return false;
+    IDs = *I;
+    return true;
+  }
+
+  CompileCommand getCommand(unsigned ID) const {
+    StringRef Directory, File;
+    CompileCommand Command;
+    readEntry(ID, Directory, File, &Command.CommandLine);
+    Command.Directory = Directory;
+    return Command;
+  }
+
+  static void getNativePath(StringRef Path, SmallVectorImpl<char> &Native) {
+    Native.clear();
+    llvm::sys::path::native(Path, Native);
+  }
+
+  static std::string getIndexPath(StringRef BuildDirectory) {
+    SmallString<256> Path(BuildDirectory);
+    llvm::sys::path::append(Path, "compile_commands.idx");
+    return Path.str();
+  }
+
+  static bool getSourceStamp(StringRef JSONPath, uint64_t &Size,
+                             uint64_t &ModTime) {
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(JSONPath, Status))
+      return false;
+    Size = Status.getSize();
+    ModTime = Status.getLastModificationTime().toEpochTime();
+    return true;
+  }
+
+public:
+  /// \brief Load the index of the JSON compilation database \p JSONPath from
+  /// \p IndexPath.
+  ///
+  /// Returns NULL and sets ErrorMessage if there is no valid index, or the
+  /// index is out of date with respect to \p JSONPath; the caller should then
+  /// load the JSON database itself, and may write a new index for next time.
+  static IndexedCompilationDatabase *loadFromFile(StringRef IndexPath,
+                                                  StringRef JSONPath,
+                                                  std::string &ErrorMessage) {
+    using namespace llvm::support;
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::error_code EC = llvm::MemoryBuffer::getFile(
+            IndexPath, Buffer, -1, /*RequiresNullTerminator=*/false)) {
+      ErrorMessage = "Error while opening compilation database index: " +
+                     EC.message();
+      return 0;
+    }
+    uint64_t Size, ModTime;
+    if (!getSourceStamp(JSONPath, Size, ModTime)) {
+      ErrorMessage = "Cannot stat " + JSONPath.str();
+      return 0;
+    }
+
+    size_t BufferSize = Buffer->getBufferSize();
+    const unsigned char *Base =
+        reinterpret_cast<const unsigned char *>(Buffer->getBufferStart());
+    const unsigned char *D = Base;
+    if (BufferSize < HeaderSize ||
+        endian::readNext<uint32_t, little, aligned>(D) != Magic ||
+        endian::readNext<uint32_t, little, aligned>(D) != Version) {
+      ErrorMessage = "Invalid compilation database index";
+      return 0;
+    }
+    if (endian::readNext<uint64_t, little, aligned>(D) != Size ||
+        endian::readNext<uint64_t, little, aligned>(D) != ModTime) {
+      ErrorMessage = "Compilation database index is out of date";
+      return 0;
+    }
+    uint32_t NumEntries = endian::readNext<uint32_t, little, aligned>(D);
+    uint32_t EntriesOffset = endian::readNext<uint32_t, little, aligned>(D);
+    uint32_t PathTableOffset = endian::readNext<uint32_t, little, aligned>(D);
+    uint32_t NameTableOffset = endian::readNext<uint32_t, little, aligned>(D);
+    if (EntriesOffset > BufferSize ||
+        (BufferSize - EntriesOffset) / 4 < NumEntries ||
+        PathTableOffset % 4 || PathTableOffset + 8 > BufferSize ||
+        NameTableOffset % 4 || NameTableOffset + 8 > BufferSize) {
+      ErrorMessage = "Invalid compilation database index";
+      return 0;
+    }
+
+    IndexedCompilationDatabase *Database =
+        new IndexedCompilationDatabase(Buffer.release());
+    Database->Base = Base;
+    Database->NumEntries = NumEntries;
+    Database->EntryOffsets = Base + EntriesOffset;
+    Database->PathTable.reset(TableTy::Create(Base + PathTableOffset, Base));
+    Database->NameTable.reset(TableTy::Create(Base + NameTableOffset, Base));
+    return Database;
+  }
+
+  /// \brief Load the index of compile_commands.json in \p BuildDirectory.
+  static IndexedCompilationDatabase *
+  loadFromDirectory(StringRef BuildDirectory, std::string &ErrorMessage) {
+    SmallString<256> JSONPath(BuildDirectory);
+    llvm::sys::path::append(JSONPath, "compile_commands.json");
+    return loadFromFile(getIndexPath(BuildDirectory), JSONPath, ErrorMessage);
+  }
+
+  /// \brief Write an index, to \p IndexPath, of \p Source, which was loaded
+  /// from the JSON compilation database \p JSONPath.
+  ///
+  /// This is what a tool run after the build system regenerates the
+  /// database does, so that other tools start quickly.
+  ///
+  /// \returns true on success; otherwise sets ErrorMessage.
+  static bool writeIndex(const CompilationDatabase &Source, StringRef JSONPath,
+                         StringRef IndexPath, std::string &ErrorMessage) {
+    using namespace llvm::support;
+    uint64_t Size, ModTime;
+    if (!getSourceStamp(JSONPath, Size, ModTime)) {
+      ErrorMessage = "Cannot stat " + JSONPath.str();
+      return false;
+    }
+
+    // Pair each file with its commands, which a CompilationDatabase does
+    // not do for all its commands at once.
+    std::vector<std::string> Files = Source.getAllFiles();
+    std::vector<std::pair<unsigned, CompileCommand> > Commands;
+    for (unsigned I = 0, E = Files.size(); I != E; ++I) {
+      std::vector<CompileCommand> FileCommands =
+          Source.getCompileCommands(Files[I]);
+      for (unsigned C = 0, CE = FileCommands.size(); C != CE; ++C)
+        Commands.push_back(std::make_pair(I, FileCommands[C]));
+    }
+
+    SmallString<65536> Contents;
+    llvm::raw_svector_ostream Out(Contents);
+    endian::Writer<little> LE(Out);
+    Out << StringRef(std::string(HeaderSize, '\0')); // Patched below.
+
+    std::vector<uint32_t> Offsets;
+    llvm::StringMap<std::vector<uint32_t> > ByPath, ByName;
+    SmallString<256> Native;
+    for (unsigned I = 0, E = Commands.size(); I != E; ++I) {
+      const CompileCommand &Command = Commands[I].second;
+      getNativePath(Files[Commands[I].first], Native);
+      if (Native.size() > 0xFFFF)
+        continue;
+      Offsets.push_back(Out.tell());
+      uint32_t ID = Offsets.size() - 1;
+      LE.write<uint32_t>(Command.Directory.size());
+      Out << Command.Directory;
+      LE.write<uint32_t>(Native.size());
+      Out << Native;
+      std::string Args;
+      for (unsigned A = 0, AE = Command.CommandLine.size(); A != AE; ++A) {
+        Args += Command.CommandLine[A];
+        Args += '\0';
+      }
+      LE.write<uint32_t>(Args.size());
+      Out << Args;
+      ByPath[Native].push_back(ID);
+      ByName[llvm::sys::path::filename(Native)].push_back(ID);
+    }
+
+    io::Pad(Out, 4);
+    uint32_t EntriesOffset = Out.tell();
+    for (unsigned I = 0, E = Offsets.size(); I != E; ++I)
+      LE.write<uint32_t>(Offsets[I]);
+
+    uint32_t TableOffsets[2];
+    llvm::StringMap<std::vector<uint32_t> > *Maps[2] = { &ByPath, &ByName };
+    for (unsigned T = 0; T != 2; ++T) {
+      OnDiskChainedHashTableGenerator<CompileCommandIndexTrait> Generator;
+      for (llvm::StringMap<std::vector<uint32_t> >::iterator
+               I = Maps[T]->begin(), E = Maps[T]->end(); I != E; ++I)
+        Generator.insert(I->getKey(), I->second);
+      TableOffsets[T] = Generator.Emit(Out);
+    }
+    Out.flush();
+
+    char *Header = Contents.data();
+    endian::write<uint32_t, little, unaligned>(Header, Magic);
+    endian::write<uint32_t, little, unaligned>(Header + 4, Version);
+    endian::write<uint64_t, little, unaligned>(Header + 8, Size);
+    endian::write<uint64_t, little, unaligned>(Header + 16, ModTime);
+    endian::write<uint32_t, little, unaligned>(Header + 24, Offsets.size());
+    endian::write<uint32_t, little, unaligned>(Header + 28, EntriesOffset);
+    endian::write<uint32_t, little, unaligned>(Header + 32, TableOffsets[0]);
+    endian::write<uint32_t, little, unaligned>(Header + 36, TableOffsets[1]);
+
+    // Tools starting while the index is rewritten see either the old or the
+    // new one.
+    if (llvm::error_code EC =
+            llvm::writeFileAtomically(IndexPath, Contents.str())) {
+      ErrorMessage = "Cannot write " + IndexPath.str() + ": " + EC.message();
+      return false;
+    }
+    return true;
+  }
+
+  /// \brief Write the index of compile_commands.json in \p BuildDirectory,
+  /// \p Source, next to it.
+  static bool writeIndexForDirectory(const CompilationDatabase &Source,
+                                     StringRef BuildDirectory,
+                                     std::string &ErrorMessage) {
+    SmallString<256> JSONPath(BuildDirectory);
+    llvm::sys::path::append(JSONPath, "compile_commands.json");
+    return writeIndex(Source, JSONPath, getIndexPath(BuildDirectory),
+                      ErrorMessage);
+  }
+
+  std::vector<CompileCommand>
+  getCompileCommands(StringRef FilePath) const override {
+    std::vector<CompileCommand> Commands;
+    SmallString<256> Native;
+    getNativePath(FilePath, Native);
+    OnDiskCompileCommandIDs IDs;
+    if (!findIDs(*PathTable, Native, IDs)) {
+      // Match a path to the same file spelled differently, if exactly one
+      // entry with the same file name is equivalent to it.
+      OnDiskCompileCommandIDs Candidates;
+      if (!findIDs(*NameTable, llvm::sys::path::filename(Native), Candidates))
+        return Commands;
+      StringRef Match;
+      for (unsigned C = 0, CE = Candidates.size(); C != CE; ++C) {
+        StringRef Directory, File;
+        readEntry(Candidates[C], Directory, File, 0);
+        if (File == Match || !llvm::sys::fs::equivalent(File, Native.str()))
+          continue;
+        if (!Match.empty())
+          return Commands; // Ambiguous.
+        Match = File;
+      }
+      if (Match.empty() || !findIDs(*PathTable, Match, IDs))
+        return Commands;
+    }
+    for (unsigned C = 0, CE = IDs.size(); C != CE; ++C)
+      Commands.push_back(getCommand(IDs[C]));
+    return Commands;
+  }
+
+  std::vector<std::string> getAllFiles() const override {
+    std::vector<std::string> Files;
+    // The entries of a file are consecutive.
+    StringRef Last;
+    for (unsigned ID = 0; ID != NumEntries; ++ID) {
+      StringRef Directory, File;
+      readEntry(ID, Directory, File, 0);
+      if (ID == 0 || File != Last)
+        Files.push_back(File);
+      Last = File;
+    }
+    return Files;
+  }
+
+  std::vector<CompileCommand> getAllCompileCommands() const override {
+    std::vector<CompileCommand> Commands;
+    Commands.reserve(NumEntries);
+    for (unsigned ID = 0; ID != NumEntries; ++ID)
+      Commands.push_back(getCommand(ID));
+    return Commands;
+  }
+};
+
+} // end namespace tooling
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLING_INDEXED_COMPILATION_DATABASE_H
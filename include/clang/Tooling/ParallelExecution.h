@@ -0,0 +1,180 @@
+//===--- ParallelExecution.h - Parallel tool runs ---------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the helpers ClangTool uses to run a tool over many
+// translation units on several threads with the same output as a sequential
+// run.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLING_PARALLELEXECUTION_H
+#define LLVM_CLANG_TOOLING_PARALLELEXECUTION_H
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/raw_ostream.h"
+#include <map>
+#include <string>
+#include <utility>
+
+namespace clang {
+
+namespace tooling {
+
+/// \brief Writes the outputs of jobs finishing in any order to a stream in
+/// the order of the jobs.
+///
+/// Each job of a parallel run buffers what it would print (diagnostics, for
+/// one) and publishes it when it finishes; the output of job N is written as
+/// soon as jobs 0 to N-1 have published theirs, so the stream receives the
+/// same bytes as from a sequential run.
+class OrderedOutput {
+  llvm::sys::Mutex Lock;
+  raw_ostream &OS;
+  unsigned NextJob;
+  std::map<unsigned, std::string> Pending;
+
+public:
+  explicit OrderedOutput(raw_ostream &OS) : OS(OS), NextJob(0) {}
+
+  /// \brief Publish the output of job \p Job, which may be empty.  Every job
+  /// must publish exactly once.
+  void publish(unsigned Job, std::string Output) {
+    llvm::MutexGuard Guard(Lock);
+    assert(Job >= NextJob && !Pending.count(Job) && "Job published twice");
+    if (Job != NextJob) {
+      Pending[Job].swap(Output);
+      return;
+    }
+    OS << Output;
+    for (++NextJob; !Pending.empty() && Pending.begin()->first == NextJob;
+         ++NextJob) {
+      OS << Pending.begin()->second;
+      Pending.erase(Pending.begin());
+    }
+    OS.flush();
+  }
+
+  /// \brief The number of jobs whose output has been written.
+  unsigned getNumWritten() {
+    llvm::MutexGuard Guard(Lock);
+    return NextJob;
+  }
+};
+
+/// \brief Writes one line per translation unit of a tool run, saying whether
+/// it succeeded, in the order of the source paths, and a summary at the end.
+///
+/// This is the merged results stream of a batch check: with many files
+/// checked on several threads, a CI job reads a single "PASS" or "FAIL" line
+/// per file, and the failures, instead of scanning the interleaved
+/// diagnostics.
+class TranslationUnitResults {
+  OrderedOutput Output;
+  llvm::sys::Mutex Lock;
+  unsigned NumRecorded;
+  unsigned NumFailed;
+
+public:
+  explicit TranslationUnitResults(raw_ostream &OS)
+    : Output(OS), NumRecorded(0), NumFailed(0) {}
+
+  /// \brief Record the result of job \p Job, which checked \p File.  Every
+  /// job must be recorded exactly once.
+  void record(unsigned Job, StringRef File, bool Succeeded,
+              unsigned NumErrors, unsigned NumWarnings) {
+    std::string Line;
+    llvm::raw_string_ostream OS(Line);
+    OS << (Succeeded ? "PASS " : "FAIL ") << File;
+    if (NumErrors || NumWarnings)
+      OS << ": " << NumErrors << (NumErrors == 1 ? " error, " : " errors, ")
+         << NumWarnings << (NumWarnings == 1 ? " warning" : " warnings");
+    OS << '\n';
+    OS.flush();
+    {
+      llvm::MutexGuard Guard(Lock);
+      ++NumRecorded;
+      if (!Succeeded)
+        ++NumFailed;
+    }
+    Output.publish(Job, std::move(Line));
+  }
+
+  /// \brief Write the summary line, once every job has been recorded.
+  void finish(raw_ostream &OS) {
+    llvm::MutexGuard Guard(Lock);
+    OS << NumFailed << " of " << NumRecorded
+       << " translation units failed\n";
+    OS.flush();
+  }
+
+  unsigned getNumFailed() {
+    llvm::MutexGuard Guard(Lock);
+    return NumFailed;
+  }
+};
+
+/// \brief Diagnostic consumer that forwards diagnostics from several threads
+/// to a consumer that is not thread safe, one at a time.
+///
+/// Diagnostics of different translation units interleave, and so do their
+/// BeginSourceFile and EndSourceFile calls, so the target must not depend
+/// on those pairing up.  This suits consumers that count or store
+/// diagnostics; ClangTool gives each translation unit its own printer when
+/// output order matters.
+class LockedDiagnosticConsumer : public DiagnosticConsumer {
+  DiagnosticConsumer &Target;
+  mutable llvm::sys::Mutex Lock;
+
+public:
+  explicit LockedDiagnosticConsumer(DiagnosticConsumer &Target)
+    : Target(Target) {}
+
+  void BeginSourceFile(const LangOptions &LangOpts,
+                       const Preprocessor *PP) override {
+    llvm::MutexGuard Guard(Lock);
+    Target.BeginSourceFile(LangOpts, PP);
+  }
+
+  void EndSourceFile() override {
+    llvm::MutexGuard Guard(Lock);
+    Target.EndSourceFile();
+  }
+
+  void finish() override {
+    llvm::MutexGuard Guard(Lock);
+    Target.finish();
+  }
+
+  bool IncludeInDiagnosticCounts() const override {
+    llvm::MutexGuard Guard(Lock);
+    return Target.IncludeInDiagnosticCounts();
+  }
+
+  void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
+                        const Diagnostic &Info) override {
+    llvm::MutexGuard Guard(Lock);
+    DiagnosticConsumer::HandleDiagnostic(DiagLevel, Info);
+    Target.HandleDiagnostic(DiagLevel, Info);
+  }
+
+  void clear() override {
+    llvm::MutexGuard Guard(Lock);
+    DiagnosticConsumer::clear();
+    Target.clear();
+  }
+};
+
+} // end namespace tooling
+
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLING_PARALLELEXECUTION_H
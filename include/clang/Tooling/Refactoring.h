@@ -22,6 +22,8 @@
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
 #include <set>
 #include <string>
 
@@ -206,8 +208,28 @@ public:
 
   /// \brief Returns the set of replacements to which replacements should
   /// be added during the run of the tool.
+  ///
+  /// The set is not thread safe: when the tool runs on several threads (see
+  /// ClangTool::setNumThreads()), add replacements with addReplacement() or
+  /// addReplacements() instead.
   Replacements &getReplacements();
 
+  /// \brief Add \p R to the replacements.  May be called from any thread.
+  ///
+  /// Since the replacements are kept ordered, the result of a parallel run
+  /// does not depend on the order in which translation units finish.
+  void addReplacement(const Replacement &R) {
+    llvm::MutexGuard Guard(ReplaceLock);
+    Replace.insert(R);
+  }
+
+  /// \brief Add all of \p Rs to the replacements, which is cheaper than
+  /// adding them one at a time.  May be called from any thread.
+  void addReplacements(const Replacements &Rs) {
+    llvm::MutexGuard Guard(ReplaceLock);
+    Replace.insert(Rs.begin(), Rs.end());
+  }
+
   /// \brief Call run(), apply all generated replacements, and immediately save
   /// the results to disk.
   ///
@@ -228,6 +250,7 @@ private:
 
 private:
   Replacements Replace;
+  llvm::sys::Mutex ReplaceLock;
 };
 
 template <typename Node>
@@ -275,6 +275,35 @@ class ClangTool {
   /// \brief Clear the command line arguments adjuster chain.
   void clearArgumentsAdjusters();
 
+  /// \brief Set the number of threads run() and buildASTs() process files
+  /// on: 1 (the default) to process them in order on the calling thread, or
+  /// 0 for one thread per core.
+  ///
+  /// With more than one thread, the action must be safe to run on several
+  /// translation units at once; a FrontendActionFactory is asked for a new
+  /// action for each translation unit from the thread that runs it.  Each
+  /// thread has its own FileManager, sharing only the mapped virtual files.
+  /// Diagnostics are printed per translation unit, in the order of the
+  /// source paths, as in a sequential run; a consumer set with
+  /// setDiagnosticConsumer() is called from one thread at a time, through a
+  /// LockedDiagnosticConsumer.
+  void setNumThreads(unsigned NumThreads) { this->NumThreads = NumThreads; }
+  unsigned getNumThreads() const { return NumThreads; }
+
+  /// \brief Share the contents of the files read by all the threads'
+  /// FileManagers through \p Cache.
+  ///
+  /// Headers are then read once per run rather than once per thread, and
+  /// byte-identical copies, such as the same header in two SDKs, take their
+  /// memory once.  With more than one thread and no cache set, run() and
+  /// buildASTs() use a cache of their own.
+  void setFileContentCache(FileContentCache *Cache) { ContentCache = Cache; }
+
+  /// \brief Write a PASS or FAIL line for each translation unit to \p OS,
+  /// in the order of the source paths, followed by a summary; see
+  /// TranslationUnitResults.  Null, the default, writes nothing.
+  void setResultsStream(raw_ostream *OS) { ResultsOS = OS; }
+
   /// Runs an action over all files specified in the command line.
   ///
   /// \param Action Tool action.
@@ -286,7 +315,8 @@ class ClangTool {
 
   /// \brief Returns the file manager used in the tool.
   ///
-  /// The file manager is shared between all translation units.
+  /// The file manager is shared between all translation units processed on
+  /// the calling thread; see setNumThreads().
   FileManager &getFiles() { return *Files; }
 
  private:
@@ -300,6 +330,12 @@ class ClangTool {
   SmallVector<ArgumentsAdjuster *, 2> ArgsAdjusters;
 
   DiagnosticConsumer *DiagConsumer;
+
+  unsigned NumThreads;
+
+  llvm::IntrusiveRefCntPtr<FileContentCache> ContentCache;
+
+  raw_ostream *ResultsOS;
 };
 
 template <typename T>
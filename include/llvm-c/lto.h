@@ -40,7 +40,7 @@ typedef bool lto_bool_t;
  * @{
  */
 
-#define LTO_API_VERSION 10
+#define LTO_API_VERSION 11
 
 /**
  * \since prior to LTO_API_VERSION=3
@@ -435,6 +435,44 @@ lto_codegen_compile(lto_code_gen_t cg, size_t* length);
 extern lto_bool_t
 lto_codegen_compile_to_file(lto_code_gen_t cg, const char** name);
 
+/**
+ * Sets the number of partitions the merged module is split into by
+ * lto_codegen_compile_to_files(). Each partition is code generated on its
+ * own thread. Zero is treated as one.
+ *
+ * \since LTO_API_VERSION=11
+ */
+extern void
+lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned partitions);
+
+/**
+ * Sets the directory in which the native objects generated for each
+ * partition are cached. An object is reused when a later link produces a
+ * partition with identical bitcode, target, code generation options and
+ * preserved symbols; with a cache, functions are assigned to partitions by
+ * name so that unrelated partitions stay identical. Passing NULL disables
+ * the cache.
+ *
+ * \since LTO_API_VERSION=11
+ */
+extern void
+lto_codegen_set_cache_dir(lto_code_gen_t cg, const char *path);
+
+/**
+ * Generates code for all added modules into one native object file per
+ * partition (see lto_codegen_set_parallelism()). On success, names is set to
+ * an array of count file names, owned by the lto_code_gen_t and valid until
+ * lto_codegen_dispose() is called or code is generated again. Internal
+ * symbols shared between partitions are given hidden visibility, so the
+ * objects together export the same symbols as lto_codegen_compile_to_file()
+ * would. Returns true on error.
+ *
+ * \since LTO_API_VERSION=11
+ */
+extern lto_bool_t
+lto_codegen_compile_to_files(lto_code_gen_t cg, const char*** names,
+                             unsigned* count);
+
 
 /**
  * Sets options to help debug codegen bugs.
@@ -213,6 +213,22 @@ class APInt {
   /// out-of-line slow case for countLeadingZeros
   unsigned countLeadingZerosSlowCase() const;
 
+  /// out-of-line slow cases for the arithmetic and compound assignment
+  /// operators and the comparisons, whose single word cases are inline
+  APInt &IncrementSlowCase();
+  APInt &DecrementSlowCase();
+  APInt &AndAssignSlowCase(const APInt &RHS);
+  APInt &OrAssignSlowCase(const APInt &RHS);
+  APInt &XorAssignSlowCase(const APInt &RHS);
+  APInt &MulAssignSlowCase(const APInt &RHS);
+  APInt &AddAssignSlowCase(const APInt &RHS);
+  APInt &SubAssignSlowCase(const APInt &RHS);
+  APInt MulSlowCase(const APInt &RHS) const;
+  APInt AddSlowCase(const APInt &RHS) const;
+  APInt SubSlowCase(const APInt &RHS) const;
+  bool ultSlowCase(const APInt &RHS) const;
+  bool sltSlowCase(const APInt &RHS) const;
+
   /// out-of-line slow case for countTrailingOnes
   unsigned countTrailingOnesSlowCase() const;
 
@@ -587,7 +603,13 @@ public:
   /// \brief Prefix increment operator.
   ///
   /// \returns *this incremented by one
-  APInt &operator++();
+  APInt &operator++() {
+    if (isSingleWord()) {
+      ++VAL;
+      return clearUnusedBits();
+    }
+    return IncrementSlowCase();
+  }
 
   /// \brief Postfix decrement operator.
   ///
@@ -601,7 +623,13 @@ public:
   /// \brief Prefix decrement operator.
   ///
   /// \returns *this decremented by one.
-  APInt &operator--();
+  APInt &operator--() {
+    if (isSingleWord()) {
+      --VAL;
+      return clearUnusedBits();
+    }
+    return DecrementSlowCase();
+  }
 
   /// \brief Unary bitwise complement operator.
   ///
@@ -682,7 +710,14 @@ public:
   /// assigned to *this.
   ///
   /// \returns *this after ANDing with RHS.
-  APInt &operator&=(const APInt &RHS);
+  APInt &operator&=(const APInt &RHS) {
+    assert(BitWidth == RHS.BitWidth && "Bit widths must be the same");
+    if (isSingleWord()) {
+      VAL &= RHS.VAL;
+      return *this;
+    }
+    return AndAssignSlowCase(RHS);
+  }
 
   /// \brief Bitwise OR assignment operator.
   ///
@@ -690,7 +725,14 @@ public:
   /// assigned *this;
   ///
   /// \returns *this after ORing with RHS.
-  APInt &operator|=(const APInt &RHS);
+  APInt &operator|=(const APInt &RHS) {
+    assert(BitWidth == RHS.BitWidth && "Bit widths must be the same");
+    if (isSingleWord()) {
+      VAL |= RHS.VAL;
+      return *this;
+    }
+    return OrAssignSlowCase(RHS);
+  }
 
   /// \brief Bitwise OR assignment operator.
   ///
@@ -713,28 +755,56 @@ public:
   /// assigned to *this.
   ///
   /// \returns *this after XORing with RHS.
-  APInt &operator^=(const APInt &RHS);
+  APInt &operator^=(const APInt &RHS) {
+    assert(BitWidth == RHS.BitWidth && "Bit widths must be the same");
+    if (isSingleWord()) {
+      VAL ^= RHS.VAL;
+      return *this;
+    }
+    return XorAssignSlowCase(RHS);
+  }
 
   /// \brief Multiplication assignment operator.
   ///
   /// Multiplies this APInt by RHS and assigns the result to *this.
   ///
   /// \returns *this
-  APInt &operator*=(const APInt &RHS);
+  APInt &operator*=(const APInt &RHS) {
+    assert(BitWidth == RHS.BitWidth && "Bit widths must be the same");
+    if (isSingleWord()) {
+      VAL *= RHS.VAL;
+      return clearUnusedBits();
+    }
+    return MulAssignSlowCase(RHS);
+  }
 
   /// \brief Addition assignment operator.
   ///
   /// Adds RHS to *this and assigns the result to *this.
   ///
   /// \returns *this
-  APInt &operator+=(const APInt &RHS);
+  APInt &operator+=(const APInt &RHS) {
+    assert(BitWidth == RHS.BitWidth && "Bit widths must be the same");
+    if (isSingleWord()) {
+      VAL += RHS.VAL;
+      return clearUnusedBits();
+    }
+    return AddAssignSlowCase(RHS);
+  }
 
   /// \brief Subtraction assignment operator.
   ///
   /// Subtracts RHS from *this and assigns the result to *this.
   ///
   /// \returns *this
-  APInt &operator-=(const APInt &RHS);
+  APInt &operator-=(const APInt &RHS) {
+    assert(BitWidth == RHS.BitWidth && "Bit widths must be the same");
+    if (isSingleWord()) {
+      VAL -= RHS.VAL;
+      return clearUnusedBits();
+    }
+    return SubAssignSlowCase(RHS);
+  }
 
   /// \brief Left-shift assignment function.
   ///
@@ -812,18 +882,33 @@ public:
   /// \brief Multiplication operator.
   ///
   /// Multiplies this APInt by RHS and returns the result.
-  APInt operator*(const APInt &RHS) const;
+  APInt operator*(const APInt &RHS) const {
+    assert(BitWidth == RHS.BitWidth && "Bit widths must be the same");
+    if (isSingleWord())
+      return APInt(BitWidth, VAL * RHS.VAL);
+    return MulSlowCase(RHS);
+  }
 
   /// \brief Addition operator.
   ///
   /// Adds RHS to this APInt and returns the result.
-  APInt operator+(const APInt &RHS) const;
+  APInt operator+(const APInt &RHS) const {
+    assert(BitWidth == RHS.BitWidth && "Bit widths must be the same");
+    if (isSingleWord())
+      return APInt(BitWidth, VAL + RHS.VAL);
+    return AddSlowCase(RHS);
+  }
   APInt operator+(uint64_t RHS) const { return (*this) + APInt(BitWidth, RHS); }
 
   /// \brief Subtraction operator.
   ///
   /// Subtracts RHS from this APInt and returns the result.
-  APInt operator-(const APInt &RHS) const;
+  APInt operator-(const APInt &RHS) const {
+    assert(BitWidth == RHS.BitWidth && "Bit widths must be the same");
+    if (isSingleWord())
+      return APInt(BitWidth, VAL - RHS.VAL);
+    return SubSlowCase(RHS);
+  }
   APInt operator-(uint64_t RHS) const { return (*this) - APInt(BitWidth, RHS); }
 
   /// \brief Left logical shift operator.
@@ -1013,7 +1098,13 @@ public:
   /// the validity of the less-than relationship.
   ///
   /// \returns true if *this < RHS when both are considered unsigned.
-  bool ult(const APInt &RHS) const;
+  bool ult(const APInt &RHS) const {
+    assert(BitWidth == RHS.BitWidth &&
+           "Bit widths must be same for comparison");
+    if (isSingleWord())
+      return VAL < RHS.VAL;
+    return ultSlowCase(RHS);
+  }
 
   /// \brief Unsigned less than comparison
   ///
@@ -1029,7 +1120,13 @@ public:
   /// validity of the less-than relationship.
   ///
   /// \returns true if *this < RHS when both are considered signed.
-  bool slt(const APInt &RHS) const;
+  bool slt(const APInt &RHS) const {
+    assert(BitWidth == RHS.BitWidth &&
+           "Bit widths must be same for comparison");
+    if (isSingleWord())
+      return SignExtend64(VAL, BitWidth) < SignExtend64(RHS.VAL, BitWidth);
+    return sltSlowCase(RHS);
+  }
 
   /// \brief Signed less than comparison
   ///
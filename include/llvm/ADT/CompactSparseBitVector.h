@@ -0,0 +1,445 @@
+//===- llvm/ADT/CompactSparseBitVector.h - Array-backed bits ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the CompactSparseBitVector class, a sparse bitvector that
+// keeps its elements in one sorted array instead of a linked list.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_COMPACTSPARSEBITVECTOR_H
+#define LLVM_ADT_COMPACTSPARSEBITVECTOR_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstring>
+
+namespace llvm {
+
+/// CompactSparseBitVector - A sparse bitvector with the interface of
+/// SparseBitVector, whose elements of ElementSize bits are kept sorted in a
+/// SmallVector rather than in a list.
+///
+/// An element takes its index and its bits, with no list links and no heap
+/// block of its own, and the elements of a set are contiguous, so that union,
+/// intersection and difference are linear merges over plain word arrays,
+/// which the compiler turns into vector code.  Setting a bit in a new element
+/// in the middle of the set moves the elements after it; that is cheap for
+/// the sets of a few hundred elements that liveness keeps per register, but
+/// SparseBitVector remains better for huge sets filled in random order.
+template <unsigned ElementSize = 128>
+class CompactSparseBitVector {
+public:
+  typedef unsigned long BitWord;
+  enum {
+    BITWORD_SIZE = sizeof(BitWord) * CHAR_BIT,
+    BITWORDS_PER_ELEMENT = (ElementSize + BITWORD_SIZE - 1) / BITWORD_SIZE,
+    BITS_PER_ELEMENT = ElementSize
+  };
+
+private:
+  struct Element {
+    unsigned Index;
+    BitWord Bits[BITWORDS_PER_ELEMENT];
+
+    Element() {}
+    explicit Element(unsigned Idx) : Index(Idx) {
+      memset(Bits, 0, sizeof(Bits));
+    }
+
+    bool empty() const {
+      BitWord Any = 0;
+      for (unsigned i = 0; i < BITWORDS_PER_ELEMENT; ++i)
+        Any |= Bits[i];
+      return !Any;
+    }
+
+    bool operator==(const Element &RHS) const {
+      return Index == RHS.Index && !memcmp(Bits, RHS.Bits, sizeof(Bits));
+    }
+
+    unsigned count() const {
+      unsigned NumBits = 0;
+      for (unsigned i = 0; i < BITWORDS_PER_ELEMENT; ++i)
+        NumBits += sizeof(BitWord) == 4 ? CountPopulation_32(Bits[i])
+                                        : CountPopulation_64(Bits[i]);
+      return NumBits;
+    }
+
+    int find_first() const {
+      for (unsigned i = 0; i < BITWORDS_PER_ELEMENT; ++i)
+        if (Bits[i])
+          return i * BITWORD_SIZE + countTrailingZeros(Bits[i]);
+      llvm_unreachable("Illegal empty element");
+    }
+  };
+
+  typedef SmallVector<Element, 2> ElementVector;
+  ElementVector Elements;
+
+  static bool indexLess(const Element &E, unsigned Idx) {
+    return E.Index < Idx;
+  }
+
+  typename ElementVector::iterator find(unsigned ElementIndex) {
+    return std::lower_bound(Elements.begin(), Elements.end(), ElementIndex,
+                            indexLess);
+  }
+  typename ElementVector::const_iterator find(unsigned ElementIndex) const {
+    return std::lower_bound(Elements.begin(), Elements.end(), ElementIndex,
+                            indexLess);
+  }
+
+  /// Apply Op word by word to the elements present in both sets, keeping only
+  /// the results with set bits, and drop the elements only in this one unless
+  /// KeepUnmatched; return true if this set changed.
+  template <typename OpT>
+  bool intersectElements(const CompactSparseBitVector &RHS, bool KeepUnmatched,
+                         OpT Op) {
+    bool Changed = false;
+    unsigned Out = 0, j = 0, je = RHS.Elements.size();
+    for (unsigned i = 0, ie = Elements.size(); i != ie; ++i) {
+      Element &E = Elements[i];
+      while (j != je && RHS.Elements[j].Index < E.Index)
+        ++j;
+      if (j == je || RHS.Elements[j].Index != E.Index) {
+        if (KeepUnmatched)
+          Elements[Out++] = E;
+        else
+          Changed = true;
+        continue;
+      }
+      const Element &R = RHS.Elements[j];
+      BitWord Diff = 0, Any = 0;
+      for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w) {
+        BitWord New = Op(E.Bits[w], R.Bits[w]);
+        Diff |= New ^ E.Bits[w];
+        Any |= New;
+        E.Bits[w] = New;
+      }
+      Changed |= Diff != 0;
+      if (Any)
+        Elements[Out++] = E;
+    }
+    Elements.resize(Out);
+    return Changed;
+  }
+
+  // Iterator to walk the set bits in order.
+  class CompactSparseBitVectorIterator {
+    const CompactSparseBitVector *BitVector;
+    // The current element and word, and the bits of the word not yet
+    // visited.
+    unsigned ElementIdx;
+    unsigned WordIdx;
+    BitWord Bits;
+
+    // Move to the next word with set bits, at the current one or later.
+    void advanceToNonZero() {
+      const ElementVector &Elts = BitVector->Elements;
+      while (!Bits) {
+        if (++WordIdx == BITWORDS_PER_ELEMENT) {
+          WordIdx = 0;
+          if (++ElementIdx >= Elts.size())
+            return;
+        }
+        Bits = Elts[ElementIdx].Bits[WordIdx];
+      }
+    }
+
+  public:
+    CompactSparseBitVectorIterator()
+      : BitVector(0), ElementIdx(0), WordIdx(0), Bits(0) {}
+
+    CompactSparseBitVectorIterator(const CompactSparseBitVector *RHS,
+                                   bool End = false)
+      : BitVector(RHS), ElementIdx(End ? RHS->Elements.size() : 0),
+        WordIdx(0), Bits(0) {
+      if (ElementIdx < RHS->Elements.size()) {
+        Bits = RHS->Elements[0].Bits[0];
+        advanceToNonZero();
+      }
+    }
+
+    // Return the current set bit number.
+    unsigned operator*() const {
+      return BitVector->Elements[ElementIdx].Index * ElementSize +
+             WordIdx * BITWORD_SIZE + countTrailingZeros(Bits);
+    }
+
+    // Preincrement.
+    CompactSparseBitVectorIterator &operator++() {
+      Bits &= Bits - 1;
+      advanceToNonZero();
+      return *this;
+    }
+
+    // Postincrement.
+    CompactSparseBitVectorIterator operator++(int) {
+      CompactSparseBitVectorIterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const CompactSparseBitVectorIterator &RHS) const {
+      return ElementIdx == RHS.ElementIdx && WordIdx == RHS.WordIdx &&
+             Bits == RHS.Bits;
+    }
+    bool operator!=(const CompactSparseBitVectorIterator &RHS) const {
+      return !(*this == RHS);
+    }
+  };
+
+public:
+  typedef CompactSparseBitVectorIterator iterator;
+
+  CompactSparseBitVector() {}
+
+  void clear() { Elements.clear(); }
+
+  // Test, Reset, and Set a bit in the bitmap.
+  bool test(unsigned Idx) const {
+    typename ElementVector::const_iterator I = find(Idx / ElementSize);
+    if (I == Elements.end() || I->Index != Idx / ElementSize)
+      return false;
+    unsigned Bit = Idx % ElementSize;
+    return I->Bits[Bit / BITWORD_SIZE] & (1UL << (Bit % BITWORD_SIZE));
+  }
+
+  void reset(unsigned Idx) {
+    typename ElementVector::iterator I = find(Idx / ElementSize);
+    if (I == Elements.end() || I->Index != Idx / ElementSize)
+      return;
+    unsigned Bit = Idx % ElementSize;
+    I->Bits[Bit / BITWORD_SIZE] &= ~(1UL << (Bit % BITWORD_SIZE));
+    // When the element is zeroed out, delete it.
+    if (I->empty())
+      Elements.erase(I);
+  }
+
+  void set(unsigned Idx) {
+    unsigned ElementIndex = Idx / ElementSize;
+    typename ElementVector::iterator I;
+    // Bits are most often set in increasing order.
+    if (Elements.empty() || Elements.back().Index < ElementIndex) {
+      Elements.push_back(Element(ElementIndex));
+      I = Elements.end() - 1;
+    } else {
+      I = find(ElementIndex);
+      if (I->Index != ElementIndex)
+        I = Elements.insert(I, Element(ElementIndex));
+    }
+    unsigned Bit = Idx % ElementSize;
+    I->Bits[Bit / BITWORD_SIZE] |= 1UL << (Bit % BITWORD_SIZE);
+  }
+
+  bool test_and_set(unsigned Idx) {
+    if (test(Idx))
+      return false;
+    set(Idx);
+    return true;
+  }
+
+  bool operator==(const CompactSparseBitVector &RHS) const {
+    return Elements.size() == RHS.Elements.size() &&
+           std::equal(Elements.begin(), Elements.end(), RHS.Elements.begin());
+  }
+  bool operator!=(const CompactSparseBitVector &RHS) const {
+    return !(*this == RHS);
+  }
+
+  // Union our bitmap with the RHS and return true if we changed.
+  bool operator|=(const CompactSparseBitVector &RHS) {
+    if (this == &RHS || RHS.Elements.empty())
+      return false;
+
+    // Count the elements of RHS we lack, then merge from the back so that
+    // both the common case, where there are none, and the growth are done
+    // in place.
+    unsigned NumNew = 0;
+    for (unsigned i = 0, ie = Elements.size(), j = 0, je = RHS.Elements.size();
+         j != je; ++j) {
+      while (i != ie && Elements[i].Index < RHS.Elements[j].Index)
+        ++i;
+      if (i == ie || Elements[i].Index != RHS.Elements[j].Index)
+        ++NumNew;
+    }
+
+    bool Changed = NumNew != 0;
+    unsigned i = Elements.size(), j = RHS.Elements.size();
+    Elements.resize(i + NumNew);
+    unsigned Out = Elements.size();
+    while (j != 0) {
+      const Element &R = RHS.Elements[j - 1];
+      if (i != 0 && Elements[i - 1].Index > R.Index) {
+        Elements[--Out] = Elements[--i];
+      } else if (i != 0 && Elements[i - 1].Index == R.Index) {
+        Element &E = Elements[--i];
+        BitWord Diff = 0;
+        for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w) {
+          Diff |= R.Bits[w] & ~E.Bits[w];
+          E.Bits[w] |= R.Bits[w];
+        }
+        Changed |= Diff != 0;
+        --j;
+        --Out;
+        if (Out != i)
+          Elements[Out] = E;
+      } else {
+        Elements[--Out] = R;
+        --j;
+      }
+    }
+    assert(Out == i && "merge did not meet the untouched prefix");
+    return Changed;
+  }
+
+  // Intersect our bitmap with the RHS and return true if ours changed.
+  bool operator&=(const CompactSparseBitVector &RHS) {
+    if (this == &RHS)
+      return false;
+    return intersectElements(RHS, /*KeepUnmatched=*/false,
+                             [](BitWord L, BitWord R) { return L & R; });
+  }
+
+  // Intersect our bitmap with the complement of the RHS and return true
+  // if ours changed.
+  bool intersectWithComplement(const CompactSparseBitVector &RHS) {
+    if (this == &RHS) {
+      bool Changed = !Elements.empty();
+      Elements.clear();
+      return Changed;
+    }
+    return intersectElements(RHS, /*KeepUnmatched=*/true,
+                             [](BitWord L, BitWord R) { return L & ~R; });
+  }
+
+  // Three argument version of intersectWithComplement.
+  // Result of RHS1 & ~RHS2 is stored into this bitmap.
+  void intersectWithComplement(const CompactSparseBitVector &RHS1,
+                               const CompactSparseBitVector &RHS2) {
+    if (this == &RHS2) {
+      CompactSparseBitVector Tmp(RHS1);
+      Tmp.intersectWithComplement(RHS2);
+      *this = Tmp;
+      return;
+    }
+    if (this != &RHS1)
+      *this = RHS1;
+    intersectWithComplement(RHS2);
+  }
+
+  // Return true if we share any bits in common with RHS.
+  bool intersects(const CompactSparseBitVector &RHS) const {
+    unsigned i = 0, ie = Elements.size(), j = 0, je = RHS.Elements.size();
+    while (i != ie && j != je) {
+      if (Elements[i].Index < RHS.Elements[j].Index) {
+        ++i;
+      } else if (Elements[i].Index > RHS.Elements[j].Index) {
+        ++j;
+      } else {
+        BitWord Common = 0;
+        for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w)
+          Common |= Elements[i].Bits[w] & RHS.Elements[j].Bits[w];
+        if (Common)
+          return true;
+        ++i;
+        ++j;
+      }
+    }
+    return false;
+  }
+
+  // Return true iff all bits set in RHS are also set in this bitmap.
+  bool contains(const CompactSparseBitVector &RHS) const {
+    unsigned i = 0, ie = Elements.size();
+    for (unsigned j = 0, je = RHS.Elements.size(); j != je; ++j) {
+      while (i != ie && Elements[i].Index < RHS.Elements[j].Index)
+        ++i;
+      if (i == ie || Elements[i].Index != RHS.Elements[j].Index)
+        return false;
+      BitWord Missing = 0;
+      for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w)
+        Missing |= RHS.Elements[j].Bits[w] & ~Elements[i].Bits[w];
+      if (Missing)
+        return false;
+    }
+    return true;
+  }
+
+  // Return the first set bit in the bitmap.  Return -1 if no bits are set.
+  int find_first() const {
+    if (Elements.empty())
+      return -1;
+    return Elements[0].Index * ElementSize + Elements[0].find_first();
+  }
+
+  // Return true if the CompactSparseBitVector is empty.
+  bool empty() const { return Elements.empty(); }
+
+  unsigned count() const {
+    unsigned BitCount = 0;
+    for (unsigned i = 0, e = Elements.size(); i != e; ++i)
+      BitCount += Elements[i].count();
+    return BitCount;
+  }
+
+  iterator begin() const { return iterator(this); }
+  iterator end() const { return iterator(this, true); }
+};
+
+template <unsigned ElementSize>
+inline CompactSparseBitVector<ElementSize>
+operator|(const CompactSparseBitVector<ElementSize> &LHS,
+          const CompactSparseBitVector<ElementSize> &RHS) {
+  CompactSparseBitVector<ElementSize> Result(LHS);
+  Result |= RHS;
+  return Result;
+}
+
+template <unsigned ElementSize>
+inline CompactSparseBitVector<ElementSize>
+operator&(const CompactSparseBitVector<ElementSize> &LHS,
+          const CompactSparseBitVector<ElementSize> &RHS) {
+  CompactSparseBitVector<ElementSize> Result(LHS);
+  Result &= RHS;
+  return Result;
+}
+
+template <unsigned ElementSize>
+inline CompactSparseBitVector<ElementSize>
+operator-(const CompactSparseBitVector<ElementSize> &LHS,
+          const CompactSparseBitVector<ElementSize> &RHS) {
+  CompactSparseBitVector<ElementSize> Result;
+  Result.intersectWithComplement(LHS, RHS);
+  return Result;
+}
+
+// Dump a CompactSparseBitVector to a stream.
+template <unsigned ElementSize>
+void dump(const CompactSparseBitVector<ElementSize> &LHS, raw_ostream &out) {
+  out << "[";
+  typename CompactSparseBitVector<ElementSize>::iterator bi = LHS.begin(),
+    be = LHS.end();
+  if (bi != be) {
+    out << *bi;
+    for (++bi; bi != be; ++bi)
+      out << " " << *bi;
+  }
+  out << "]\n";
+}
+
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,446 @@
+//===--- ImmutableHashMap.h - Immutable hash array mapped trie --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the ImmutableHashMap class, a persistent map implemented
+// as a hash array mapped trie whose nodes are hash-consed by their factory.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_IMMUTABLEHASHMAP_H
+#define LLVM_ADT_IMMUTABLEHASHMAP_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <utility>
+
+namespace llvm {
+
+/// ImmutableHashMap - An immutable (functional) map from KeyT to DataT.
+///
+/// Like ImmutableMap, every update returns a new map that shares all the
+/// unchanged parts of the old one, but the map is a 32-way trie indexed by
+/// five bits of the key's hash per level instead of an AVL tree.  An update
+/// copies one small node per level on the path to the key, and never
+/// rebalances, so an update creates about log32(N) nodes where ImmutableMap
+/// creates several per rotation; lookups touch as few nodes.
+///
+/// The shape of the trie only depends on the keys it holds, not on the order
+/// they were added in: a key is stored in the first node where no other key
+/// shares its hash prefix.  Every node is uniqued by its factory on its
+/// entries and the addresses of its children, so two maps with the same
+/// contents built by one factory have the same root, and comparing maps,
+/// as ProgramState uniquing does, is a pointer comparison.  A node is
+/// uniqued before it is allocated, so updates that recreate an existing
+/// node allocate nothing.
+///
+/// Keys are hashed and compared through \p KeyInfoT, a DenseMapInfo-like
+/// class; keys and data are profiled through ImutProfileInfo for uniquing.
+/// Nodes live in the factory's allocator, and the destructors of the keys
+/// and data are never run.
+template <typename KeyT, typename DataT,
+          typename KeyInfoT = DenseMapInfo<KeyT> >
+class ImmutableHashMap {
+public:
+  typedef KeyT key_type;
+  typedef DataT data_type;
+  typedef std::pair<KeyT, DataT> value_type;
+
+  class Factory;
+
+  class Node : public FoldingSetNode {
+    friend class Factory;
+
+    /// Bit \c i is set if slot \c i of this node holds an entry, or a child.
+    uint32_t EntryMap, ChildMap;
+    /// The number of entries and children stored after the node.  Nodes
+    /// below the last level that hashes can distinguish hold colliding
+    /// entries only, with empty maps.
+    unsigned NumEntries, NumChildren;
+    /// The number of entries in this subtree.
+    unsigned Size;
+
+    Node(uint32_t EntryMap, uint32_t ChildMap, unsigned NumEntries,
+         unsigned NumChildren, unsigned Size)
+      : EntryMap(EntryMap), ChildMap(ChildMap), NumEntries(NumEntries),
+        NumChildren(NumChildren), Size(Size) {}
+
+    static size_t getChildrenOffset(unsigned NumEntries) {
+      size_t Offset = sizeof(Node) + NumEntries * sizeof(value_type);
+      return RoundUpToAlignment(Offset, AlignOf<Node *>::Alignment);
+    }
+
+  public:
+    const value_type *entries() const {
+      return reinterpret_cast<const value_type *>(this + 1);
+    }
+    const Node *const *children() const {
+      return reinterpret_cast<const Node *const *>(
+          reinterpret_cast<const char *>(this) +
+          getChildrenOffset(NumEntries));
+    }
+    unsigned getNumEntries() const { return NumEntries; }
+    unsigned getNumChildren() const { return NumChildren; }
+    unsigned size() const { return Size; }
+
+    /// The index among the entries or children of the slot \p Bit of \p Map.
+    static unsigned getIndex(uint32_t Map, uint32_t Bit) {
+      return CountPopulation_32(Map & (Bit - 1));
+    }
+
+    static void Profile(FoldingSetNodeID &ID, uint32_t EntryMap,
+                        uint32_t ChildMap, const value_type *Entries,
+                        unsigned NumEntries, const Node *const *Children,
+                        unsigned NumChildren) {
+      ID.AddInteger(EntryMap);
+      ID.AddInteger(ChildMap);
+      ID.AddInteger(NumEntries);
+      for (unsigned i = 0; i != NumEntries; ++i) {
+        ImutProfileInfo<KeyT>::Profile(ID, Entries[i].first);
+        ImutProfileInfo<DataT>::Profile(ID, Entries[i].second);
+      }
+      for (unsigned i = 0; i != NumChildren; ++i)
+        ID.AddPointer(Children[i]);
+    }
+
+    void Profile(FoldingSetNodeID &ID) const {
+      Profile(ID, EntryMap, ChildMap, entries(), NumEntries, children(),
+              NumChildren);
+    }
+
+    /// Find the data of \p K, whose hash is \p Hash, below \p Shift.
+    const DataT *lookup(const KeyT &K, unsigned Hash, unsigned Shift) const {
+      const Node *N = this;
+      for (;; Shift += 5) {
+        if (Shift >= 32) {
+          for (unsigned i = 0; i != N->NumEntries; ++i)
+            if (KeyInfoT::isEqual(N->entries()[i].first, K))
+              return &N->entries()[i].second;
+          return nullptr;
+        }
+        uint32_t Bit = 1U << ((Hash >> Shift) & 31);
+        if (N->EntryMap & Bit) {
+          const value_type &E = N->entries()[getIndex(N->EntryMap, Bit)];
+          return KeyInfoT::isEqual(E.first, K) ? &E.second : nullptr;
+        }
+        if (!(N->ChildMap & Bit))
+          return nullptr;
+        N = N->children()[getIndex(N->ChildMap, Bit)];
+      }
+    }
+  };
+
+private:
+  const Node *Root;
+
+public:
+  explicit ImmutableHashMap(const Node *R) : Root(R) {}
+
+  /// The root node, which identifies the contents of the map among the maps
+  /// built by one factory.  It is null for the empty map.
+  const Node *getRoot() const { return Root; }
+
+  bool isEmpty() const { return !Root; }
+  unsigned getNumEntries() const { return Root ? Root->size() : 0; }
+
+  const DataT *lookup(const KeyT &K) const {
+    return Root ? Root->lookup(K, KeyInfoT::getHashValue(K), 0) : nullptr;
+  }
+  bool contains(const KeyT &K) const { return lookup(K); }
+
+  bool operator==(const ImmutableHashMap &RHS) const {
+    return Root == RHS.Root;
+  }
+  bool operator!=(const ImmutableHashMap &RHS) const {
+    return Root != RHS.Root;
+  }
+
+  static void Profile(FoldingSetNodeID &ID, const ImmutableHashMap &M) {
+    ID.AddPointer(M.Root);
+  }
+  void Profile(FoldingSetNodeID &ID) const { Profile(ID, *this); }
+
+  /// iterator - Visits the entries in an unspecified but fixed order.
+  class iterator {
+    SmallVector<std::pair<const Node *, unsigned>, 8> Stack;
+
+    /// Move to the next entry, starting at the top of the stack.
+    void settle() {
+      while (!Stack.empty()) {
+        const Node *N = Stack.back().first;
+        unsigned I = Stack.back().second;
+        if (I < N->getNumEntries())
+          return;
+        Stack.pop_back();
+        if (I - N->getNumEntries() < N->getNumChildren()) {
+          Stack.push_back(std::make_pair(N, I + 1));
+          Stack.push_back(std::make_pair(
+              N->children()[I - N->getNumEntries()], 0U));
+        }
+      }
+    }
+
+  public:
+    iterator() {}
+    explicit iterator(const Node *Root) {
+      if (Root) {
+        Stack.push_back(std::make_pair(Root, 0U));
+        settle();
+      }
+    }
+
+    const value_type &operator*() const {
+      return Stack.back().first->entries()[Stack.back().second];
+    }
+    const value_type *operator->() const { return &**this; }
+    const KeyT &getKey() const { return (**this).first; }
+    const DataT &getData() const { return (**this).second; }
+
+    iterator &operator++() {
+      ++Stack.back().second;
+      settle();
+      return *this;
+    }
+    bool operator==(const iterator &RHS) const { return Stack == RHS.Stack; }
+    bool operator!=(const iterator &RHS) const { return Stack != RHS.Stack; }
+  };
+
+  iterator begin() const { return iterator(Root); }
+  iterator end() const { return iterator(); }
+
+  class Factory {
+    BumpPtrAllocator *Allocator;
+    bool OwnsAllocator;
+    FoldingSet<Node> Cache;
+
+    unsigned NumUpdates, NumNodesCreated, NumNodesShared;
+    size_t BytesAllocated;
+
+    Factory(const Factory &) LLVM_DELETED_FUNCTION;
+    void operator=(const Factory &) LLVM_DELETED_FUNCTION;
+
+    /// Get the unique node with these contents, allocating it if there is
+    /// none yet.
+    const Node *getNode(uint32_t EntryMap, uint32_t ChildMap,
+                        ArrayRef<value_type> Entries,
+                        ArrayRef<const Node *> Children) {
+      FoldingSetNodeID ID;
+      Node::Profile(ID, EntryMap, ChildMap, Entries.data(), Entries.size(),
+                    Children.data(), Children.size());
+      void *InsertPos;
+      if (Node *N = Cache.FindNodeOrInsertPos(ID, InsertPos)) {
+        ++NumNodesShared;
+        return N;
+      }
+
+      unsigned Size = Entries.size();
+      for (unsigned i = 0, e = Children.size(); i != e; ++i)
+        Size += Children[i]->size();
+      size_t ChildrenOffset = Node::getChildrenOffset(Entries.size());
+      size_t Bytes = ChildrenOffset + Children.size() * sizeof(Node *);
+      char *Mem = static_cast<char *>(
+          Allocator->Allocate(Bytes, AlignOf<Node>::Alignment));
+      Node *N = new (Mem)
+          Node(EntryMap, ChildMap, Entries.size(), Children.size(), Size);
+      value_type *NewEntries = reinterpret_cast<value_type *>(N + 1);
+      for (unsigned i = 0, e = Entries.size(); i != e; ++i)
+        new (&NewEntries[i]) value_type(Entries[i]);
+      std::copy(Children.begin(), Children.end(),
+                reinterpret_cast<const Node **>(Mem + ChildrenOffset));
+
+      Cache.InsertNode(N, InsertPos);
+      ++NumNodesCreated;
+      BytesAllocated += Bytes;
+      return N;
+    }
+
+    /// Order colliding entries by their keys' profiles, so that the node
+    /// holding them does not depend on the order they were added in.
+    static bool collisionLess(const value_type &A, const value_type &B) {
+      FoldingSetNodeID IDA, IDB;
+      ImutProfileInfo<KeyT>::Profile(IDA, A.first);
+      ImutProfileInfo<KeyT>::Profile(IDB, B.first);
+      return IDA < IDB;
+    }
+
+    const Node *getCollisionNode(SmallVectorImpl<value_type> &Entries) {
+      std::sort(Entries.begin(), Entries.end(), collisionLess);
+      return getNode(0, 0, Entries, None);
+    }
+
+    /// The node below \p Shift holding two entries with different keys.
+    const Node *getPairNode(const value_type &A, unsigned HashA,
+                            const value_type &B, unsigned HashB,
+                            unsigned Shift) {
+      if (Shift >= 32) {
+        SmallVector<value_type, 2> Entries;
+        Entries.push_back(A);
+        Entries.push_back(B);
+        return getCollisionNode(Entries);
+      }
+      unsigned SlotA = (HashA >> Shift) & 31, SlotB = (HashB >> Shift) & 31;
+      if (SlotA == SlotB) {
+        const Node *Child = getPairNode(A, HashA, B, HashB, Shift + 5);
+        return getNode(0, 1U << SlotA, None, Child);
+      }
+      value_type Entries[] = { SlotA < SlotB ? A : B, SlotA < SlotB ? B : A };
+      return getNode((1U << SlotA) | (1U << SlotB), 0, Entries, None);
+    }
+
+    const Node *add(const Node *N, unsigned Shift, unsigned Hash,
+                    const value_type &V) {
+      if (!N)
+        return getNode(1U << (Hash & 31), 0, V, None);
+
+      SmallVector<value_type, 16> Entries(N->entries(),
+                                          N->entries() + N->NumEntries);
+      SmallVector<const Node *, 16> Children(N->children(),
+                                             N->children() + N->NumChildren);
+      if (Shift >= 32) {
+        for (unsigned i = 0, e = Entries.size(); i != e; ++i)
+          if (KeyInfoT::isEqual(Entries[i].first, V.first)) {
+            if (Entries[i].second == V.second)
+              return N;
+            Entries[i].second = V.second;
+            return getCollisionNode(Entries);
+          }
+        Entries.push_back(V);
+        return getCollisionNode(Entries);
+      }
+
+      uint32_t Bit = 1U << ((Hash >> Shift) & 31);
+      if (N->ChildMap & Bit) {
+        unsigned CI = Node::getIndex(N->ChildMap, Bit);
+        const Node *Child = add(Children[CI], Shift + 5, Hash, V);
+        if (Child == Children[CI])
+          return N;
+        Children[CI] = Child;
+        return getNode(N->EntryMap, N->ChildMap, Entries, Children);
+      }
+
+      unsigned EI = Node::getIndex(N->EntryMap, Bit);
+      if (!(N->EntryMap & Bit)) {
+        Entries.insert(Entries.begin() + EI, V);
+        return getNode(N->EntryMap | Bit, N->ChildMap, Entries, Children);
+      }
+      if (KeyInfoT::isEqual(Entries[EI].first, V.first)) {
+        if (Entries[EI].second == V.second)
+          return N;
+        Entries[EI].second = V.second;
+        return getNode(N->EntryMap, N->ChildMap, Entries, Children);
+      }
+
+      // Two keys share this slot; push both down into a new child.
+      const Node *Child =
+          getPairNode(Entries[EI], KeyInfoT::getHashValue(Entries[EI].first),
+                      V, Hash, Shift + 5);
+      Entries.erase(Entries.begin() + EI);
+      Children.insert(Children.begin() + Node::getIndex(N->ChildMap, Bit),
+                      Child);
+      return getNode(N->EntryMap & ~Bit, N->ChildMap | Bit, Entries,
+                     Children);
+    }
+
+    const Node *remove(const Node *N, unsigned Shift, unsigned Hash,
+                       const KeyT &K) {
+      SmallVector<value_type, 16> Entries(N->entries(),
+                                          N->entries() + N->NumEntries);
+      SmallVector<const Node *, 16> Children(N->children(),
+                                             N->children() + N->NumChildren);
+      if (Shift >= 32) {
+        for (unsigned i = 0, e = Entries.size(); i != e; ++i)
+          if (KeyInfoT::isEqual(Entries[i].first, K)) {
+            Entries.erase(Entries.begin() + i);
+            return getCollisionNode(Entries);
+          }
+        return N;
+      }
+
+      uint32_t Bit = 1U << ((Hash >> Shift) & 31);
+      if (N->EntryMap & Bit) {
+        unsigned EI = Node::getIndex(N->EntryMap, Bit);
+        if (!KeyInfoT::isEqual(Entries[EI].first, K))
+          return N;
+        if (N->Size == 1)
+          return nullptr;
+        Entries.erase(Entries.begin() + EI);
+        return getNode(N->EntryMap & ~Bit, N->ChildMap, Entries, Children);
+      }
+      if (!(N->ChildMap & Bit))
+        return N;
+
+      unsigned CI = Node::getIndex(N->ChildMap, Bit);
+      const Node *Child = remove(Children[CI], Shift + 5, Hash, K);
+      if (Child == Children[CI])
+        return N;
+      // Children always hold at least two entries; a single remaining entry
+      // moves up into this node.
+      if (Child->Size == 1) {
+        assert(Child->NumEntries == 1 && "Unexpected single-entry subtree");
+        Children.erase(Children.begin() + CI);
+        Entries.insert(Entries.begin() + Node::getIndex(N->EntryMap, Bit),
+                       Child->entries()[0]);
+        return getNode(N->EntryMap | Bit, N->ChildMap & ~Bit, Entries,
+                       Children);
+      }
+      Children[CI] = Child;
+      return getNode(N->EntryMap, N->ChildMap, Entries, Children);
+    }
+
+  public:
+    Factory()
+      : Allocator(new BumpPtrAllocator()), OwnsAllocator(true),
+        NumUpdates(0), NumNodesCreated(0), NumNodesShared(0),
+        BytesAllocated(0) {}
+
+    explicit Factory(BumpPtrAllocator &Alloc)
+      : Allocator(&Alloc), OwnsAllocator(false), NumUpdates(0),
+        NumNodesCreated(0), NumNodesShared(0), BytesAllocated(0) {}
+
+    ~Factory() {
+      if (OwnsAllocator)
+        delete Allocator;
+    }
+
+    ImmutableHashMap getEmptyMap() { return ImmutableHashMap(nullptr); }
+
+    ImmutableHashMap add(ImmutableHashMap M, const KeyT &K, const DataT &D) {
+      ++NumUpdates;
+      return ImmutableHashMap(
+          add(M.Root, 0, KeyInfoT::getHashValue(K), value_type(K, D)));
+    }
+
+    ImmutableHashMap remove(ImmutableHashMap M, const KeyT &K) {
+      ++NumUpdates;
+      if (!M.Root)
+        return M;
+      return ImmutableHashMap(
+          remove(M.Root, 0, KeyInfoT::getHashValue(K), K));
+    }
+
+    /// Statistics about the uniquing of nodes: the number of add and
+    /// remove calls, of nodes allocated, of node constructions that found
+    /// an existing node instead, and of bytes allocated for nodes.
+    unsigned getNumUpdates() const { return NumUpdates; }
+    unsigned getNumNodesCreated() const { return NumNodesCreated; }
+    unsigned getNumNodesShared() const { return NumNodesShared; }
+    size_t getBytesAllocated() const { return BytesAllocated; }
+  };
+};
+
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,213 @@
+//===--- ParallelDeltaAlgorithm.h - Parallel Set Minimization ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_PARALLELDELTAALGORITHM_H
+#define LLVM_ADT_PARALLELDELTAALGORITHM_H
+
+#include "llvm/ADT/DeltaAlgorithm.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+/// ParallelDeltaAlgorithm - The delta debugging algorithm of \see
+/// DeltaAlgorithm, testing several candidate subsets at once.
+///
+/// Where DeltaAlgorithm tries the subsets of a partition and their
+/// complements one after the other until one satisfies the predicate, this
+/// tests the next \c NumWorkers candidates concurrently on the shared
+/// ThreadPool and then takes the first of them, in the sequential order,
+/// that passed.  For a deterministic predicate it therefore returns exactly
+/// the set DeltaAlgorithm returns, while a reduction whose tests each run a
+/// tool takes about 1/NumWorkers of the wall time; the price is the
+/// candidates of a batch after the first success, which are tested in vain.
+///
+/// Every result is cached, keyed by a hash of the subset, so a subset is
+/// never tested twice.  ExecuteOneTest is called from several threads at
+/// once and must be thread-safe; a tool-running predicate typically just
+/// needs distinct temporary files per call.
+class ParallelDeltaAlgorithm {
+public:
+  typedef DeltaAlgorithm::change_ty change_ty;
+  typedef DeltaAlgorithm::changeset_ty changeset_ty;
+  typedef DeltaAlgorithm::changesetlist_ty changesetlist_ty;
+
+private:
+  unsigned NumWorkers;
+  /// Test results by the hash of the subset; subsets whose hashes collide
+  /// share a bucket.
+  std::map<size_t, std::vector<std::pair<changeset_ty, bool> > > Cache;
+  unsigned NumTests;
+
+  static size_t getHash(const changeset_ty &S) {
+    return hash_combine_range(S.begin(), S.end());
+  }
+
+  const bool *lookup(const changeset_ty &S) const {
+    std::map<size_t, std::vector<std::pair<changeset_ty, bool> > >::
+        const_iterator I = Cache.find(getHash(S));
+    if (I == Cache.end())
+      return nullptr;
+    for (unsigned i = 0, e = I->second.size(); i != e; ++i)
+      if (I->second[i].first == S)
+        return &I->second[i].second;
+    return nullptr;
+  }
+
+  /// Get the results for all the \p Candidates, testing those that are not
+  /// cached concurrently.
+  void getTestResults(const changesetlist_ty &Candidates,
+                      std::vector<char> &Results) {
+    Results.assign(Candidates.size(), 0);
+    std::vector<unsigned> ToRun;
+    for (unsigned i = 0, e = Candidates.size(); i != e; ++i) {
+      if (const bool *R = lookup(Candidates[i]))
+        Results[i] = *R;
+      else
+        ToRun.push_back(i);
+    }
+    parallel_for(0u, unsigned(ToRun.size()), [&](unsigned i) {
+      Results[ToRun[i]] = ExecuteOneTest(Candidates[ToRun[i]]);
+    });
+    for (unsigned i = 0, e = ToRun.size(); i != e; ++i)
+      if (!lookup(Candidates[ToRun[i]]))
+        Cache[getHash(Candidates[ToRun[i]])].push_back(
+            std::make_pair(Candidates[ToRun[i]], bool(Results[ToRun[i]])));
+    NumTests += ToRun.size();
+  }
+
+  /// Split - Partition a set of changes \p S into one or two subsets, as
+  /// DeltaAlgorithm does.
+  static void Split(const changeset_ty &S, changesetlist_ty &Res) {
+    changeset_ty LHS, RHS;
+    unsigned idx = 0, N = S.size() / 2;
+    for (changeset_ty::const_iterator it = S.begin(), ie = S.end(); it != ie;
+         ++it, ++idx)
+      ((idx < N) ? LHS : RHS).insert(*it);
+    if (!LHS.empty())
+      Res.push_back(LHS);
+    if (!RHS.empty())
+      Res.push_back(RHS);
+  }
+
+  changeset_ty Delta(const changeset_ty &Changes,
+                     const changesetlist_ty &Sets) {
+    UpdatedSearchState(Changes, Sets);
+    if (Sets.size() <= 1)
+      return Changes;
+
+    changeset_ty Res;
+    if (Search(Changes, Sets, Res))
+      return Res;
+
+    changesetlist_ty SplitSets;
+    for (changesetlist_ty::const_iterator it = Sets.begin(), ie = Sets.end();
+         it != ie; ++it)
+      Split(*it, SplitSets);
+    if (SplitSets.size() == Sets.size())
+      return Changes;
+    return Delta(Changes, SplitSets);
+  }
+
+  /// Search - Try each subset of \p Sets and, with more than two sets, its
+  /// complement in \p Changes, in DeltaAlgorithm's order, a batch at a time.
+  bool Search(const changeset_ty &Changes, const changesetlist_ty &Sets,
+              changeset_ty &Res) {
+    // Candidate 2*i is Sets[i] and candidate 2*i+1 its complement.
+    unsigned Step = Sets.size() > 2 ? 1 : 2;
+    unsigned NumCandidates = 2 * Sets.size();
+    for (unsigned Begin = 0; Begin < NumCandidates;) {
+      changesetlist_ty Batch;
+      std::vector<unsigned> Ids;
+      for (unsigned c = Begin; c < NumCandidates && Batch.size() < NumWorkers;
+           c += Step) {
+        Ids.push_back(c);
+        if (c % 2 == 0) {
+          Batch.push_back(Sets[c / 2]);
+          continue;
+        }
+        changeset_ty Complement;
+        std::set_difference(Changes.begin(), Changes.end(),
+                            Sets[c / 2].begin(), Sets[c / 2].end(),
+                            std::insert_iterator<changeset_ty>(
+                                Complement, Complement.begin()));
+        Batch.push_back(Complement);
+      }
+      Begin = Ids.back() + Step;
+
+      std::vector<char> Results;
+      getTestResults(Batch, Results);
+      for (unsigned i = 0, e = Batch.size(); i != e; ++i) {
+        if (!Results[i])
+          continue;
+        unsigned Set = Ids[i] / 2;
+        if (Ids[i] % 2 == 0) {
+          changesetlist_ty SubSets;
+          Split(Batch[i], SubSets);
+          Res = Delta(Batch[i], SubSets);
+        } else {
+          changesetlist_ty ComplementSets;
+          ComplementSets.insert(ComplementSets.end(), Sets.begin(),
+                                Sets.begin() + Set);
+          ComplementSets.insert(ComplementSets.end(), Sets.begin() + Set + 1,
+                                Sets.end());
+          Res = Delta(Batch[i], ComplementSets);
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+protected:
+  /// UpdatedSearchState - Callback used when the search state changes.
+  virtual void UpdatedSearchState(const changeset_ty &Changes,
+                                  const changesetlist_ty &Sets) {}
+
+  /// ExecuteOneTest - Execute a single test predicate on the change set \p S.
+  /// This is called concurrently for different sets.
+  virtual bool ExecuteOneTest(const changeset_ty &S) = 0;
+
+public:
+  /// \param NumWorkers The number of tests to run at once; 0 means the size
+  /// of the shared ThreadPool.
+  explicit ParallelDeltaAlgorithm(unsigned NumWorkers = 0)
+    : NumWorkers(NumWorkers ? NumWorkers
+                            : getDefaultThreadPool().getThreadCount()),
+      NumTests(0) {}
+
+  virtual ~ParallelDeltaAlgorithm() {}
+
+  /// The number of times ExecuteOneTest has been called.
+  unsigned getNumTests() const { return NumTests; }
+
+  /// Run - Minimize the set \p Changes by executing \see ExecuteOneTest() on
+  /// subsets of changes and returning the smallest set which still satisfies
+  /// the test predicate.
+  changeset_ty Run(const changeset_ty &Changes) {
+    // Check empty set first to quickly find poor test functions.
+    changesetlist_ty Empty(1);
+    std::vector<char> Results;
+    getTestResults(Empty, Results);
+    if (Results[0])
+      return changeset_ty();
+
+    changesetlist_ty Sets;
+    Split(Changes, Sets);
+    return Delta(Changes, Sets);
+  }
+};
+
+} // end namespace llvm
+
+#endif
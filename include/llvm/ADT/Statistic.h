@@ -176,6 +176,10 @@ void PrintStatistics();
 /// \brief Print statistics to the given output stream.
 void PrintStatistics(raw_ostream &OS);
 
+/// \brief Print the value of every statistic that was touched as a JSON
+/// object whose members are named "DEBUG_TYPE.Name", for -stats-file.
+void PrintStatisticsJSON(raw_ostream &OS);
+
 } // End llvm namespace
 
 #endif
@@ -65,11 +65,19 @@ protected:
   /// of the string.
   unsigned LookupBucketFor(StringRef Key);
 
+  /// LookupBucketFor - As above, with FullHashValue being hash(Key) computed
+  /// by the caller.
+  unsigned LookupBucketFor(StringRef Key, unsigned FullHashValue);
+
   /// FindKey - Look up the bucket that contains the specified key. If it exists
   /// in the map, return the bucket number of the key.  Otherwise return -1.
   /// This does not modify the map.
   int FindKey(StringRef Key) const;
 
+  /// FindKey - As above, with FullHashValue being hash(Key) computed by the
+  /// caller.
+  int FindKey(StringRef Key, unsigned FullHashValue) const;
+
   /// RemoveKey - Remove the specified StringMapEntry from the table, but do not
   /// delete it.  This aborts if the value isn't in the table.
   void RemoveKey(StringMapEntryBase *V);
@@ -84,6 +92,13 @@ public:
     return (StringMapEntryBase*)-1;
   }
 
+  /// hash - Return the hash value that the table uses for Key.  Clients that
+  /// look the same string up repeatedly, or in several maps, can compute it
+  /// once and pass it to the lookups that take a precomputed hash.  This is
+  /// HashString, which is also the hash of the on-disk identifier tables of
+  /// AST files, so it cannot change without changing that format.
+  static unsigned hash(StringRef Key);
+
   unsigned getNumBuckets() const { return NumBuckets; }
   unsigned getNumItems() const { return NumItems; }
 
@@ -284,6 +299,19 @@ public:
     return const_iterator(TheTable+Bucket, true);
   }
 
+  /// find - Look up Key, whose hash(Key) is FullHashValue.
+  iterator find(StringRef Key, unsigned FullHashValue) {
+    int Bucket = FindKey(Key, FullHashValue);
+    if (Bucket == -1) return end();
+    return iterator(TheTable+Bucket, true);
+  }
+
+  const_iterator find(StringRef Key, unsigned FullHashValue) const {
+    int Bucket = FindKey(Key, FullHashValue);
+    if (Bucket == -1) return end();
+    return const_iterator(TheTable+Bucket, true);
+  }
+
   /// lookup - Return the entry for the specified key, or a default
   /// constructed value if no such entry exists.
   ValueTy lookup(StringRef Key) const {
@@ -344,7 +372,22 @@ public:
   /// return.
   template <typename InitTy>
   MapEntryTy &GetOrCreateValue(StringRef Key, InitTy Val) {
-    unsigned BucketNo = LookupBucketFor(Key);
+    return GetOrCreateValueInBucket(Key, LookupBucketFor(Key), Val);
+  }
+
+  /// GetOrCreateValueWithHash - As GetOrCreateValue, with FullHashValue being
+  /// hash(Key) computed by the caller.
+  template <typename InitTy>
+  MapEntryTy &GetOrCreateValueWithHash(StringRef Key, unsigned FullHashValue,
+                                       InitTy Val) {
+    return GetOrCreateValueInBucket(Key, LookupBucketFor(Key, FullHashValue),
+                                    Val);
+  }
+
+private:
+  template <typename InitTy>
+  MapEntryTy &GetOrCreateValueInBucket(StringRef Key, unsigned BucketNo,
+                                       InitTy Val) {
     StringMapEntryBase *&Bucket = TheTable[BucketNo];
     if (Bucket && Bucket != getTombstoneVal())
       return *static_cast<MapEntryTy*>(Bucket);
@@ -365,6 +408,7 @@ public:
     return *NewItem;
   }
 
+public:
   MapEntryTy &GetOrCreateValue(StringRef Key) {
     return GetOrCreateValue(Key, ValueTy());
   }
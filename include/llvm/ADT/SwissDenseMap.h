@@ -0,0 +1,457 @@
+//===--- llvm/ADT/SwissDenseMap.h - Group-probed hash table -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the SwissDenseMap class, an open-addressing hash table
+// that keeps one control byte per bucket and probes groups of control bytes
+// at a time.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_SWISSDENSEMAP_H
+#define LLVM_ADT_SWISSDENSEMAP_H
+
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace llvm {
+
+namespace swissmap_detail {
+
+/// A control byte: an empty or deleted marker, or, for a full bucket, 7 bits
+/// of the hash of its key.
+typedef signed char CtrlT;
+
+enum {
+  CtrlEmpty = -128,
+  CtrlDeleted = -2
+};
+
+#if defined(__SSE2__)
+/// A group of 16 control bytes, compared all at once with SSE2.
+struct Group {
+  enum { Width = 16 };
+
+  __m128i Ctrl;
+
+  explicit Group(const CtrlT *P)
+    : Ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(P))) {}
+
+  /// Return a mask with bit I set if byte I of the group is \p Byte.
+  unsigned match(CtrlT Byte) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(Byte), Ctrl));
+  }
+  unsigned matchEmpty() const { return match(CtrlEmpty); }
+
+  /// Empty and deleted bytes are the only negative ones.
+  unsigned matchEmptyOrDeleted() const { return _mm_movemask_epi8(Ctrl); }
+};
+#else
+/// A group of 8 control bytes, compared one at a time.
+struct Group {
+  enum { Width = 8 };
+
+  const CtrlT *Ctrl;
+
+  explicit Group(const CtrlT *P) : Ctrl(P) {}
+
+  unsigned match(CtrlT Byte) const {
+    unsigned Mask = 0;
+    for (unsigned I = 0; I != Width; ++I)
+      Mask |= unsigned(Ctrl[I] == Byte) << I;
+    return Mask;
+  }
+  unsigned matchEmpty() const { return match(CtrlEmpty); }
+  unsigned matchEmptyOrDeleted() const {
+    unsigned Mask = 0;
+    for (unsigned I = 0; I != Width; ++I)
+      Mask |= unsigned(Ctrl[I] < 0) << I;
+    return Mask;
+  }
+};
+#endif
+
+/// Spread the bits of a DenseMapInfo hash, which for pointers only shifts
+/// and xors the address, across the whole word.
+inline uint64_t mixHash(unsigned Hash) {
+  return uint64_t(Hash) * 0x9E3779B97F4A7C15ULL;
+}
+
+} // end namespace swissmap_detail
+
+template <typename KeyT, typename ValueT, bool IsConst>
+class SwissDenseMapIterator;
+
+/// SwissDenseMap - A hash map from KeyT to ValueT with the same interface
+/// and DenseMapInfo traits as DenseMap, laid out for large maps.
+///
+/// DenseMap probes quadratically over its buckets and compares each key it
+/// meets, so misses in a big map touch many cache lines of keys.  This map
+/// keeps a separate array of control bytes, each holding 7 bits of the hash
+/// of its bucket's key, and probes a whole group of them at once (16 with
+/// SSE2, 8 otherwise); keys are only compared for buckets whose bits match.
+/// The empty and tombstone keys of KeyInfoT are not used, so any key may be
+/// stored.
+///
+/// Iterators and references are invalidated by insertion, as with DenseMap.
+template <typename KeyT, typename ValueT,
+          typename KeyInfoT = DenseMapInfo<KeyT> >
+class SwissDenseMap {
+  typedef swissmap_detail::CtrlT CtrlT;
+  typedef swissmap_detail::Group Group;
+
+public:
+  typedef KeyT key_type;
+  typedef ValueT mapped_type;
+  typedef std::pair<KeyT, ValueT> value_type;
+  typedef unsigned size_type;
+  typedef SwissDenseMapIterator<KeyT, ValueT, false> iterator;
+  typedef SwissDenseMapIterator<KeyT, ValueT, true> const_iterator;
+
+private:
+  CtrlT *Ctrl;
+  value_type *Buckets;
+  unsigned NumBuckets;
+  unsigned NumEntries;
+  unsigned NumDeleted;
+
+  /// Buckets are filled to at most 7/8 of the table, counting deleted ones.
+  static unsigned getMaxLoad(unsigned NumBuckets) {
+    return NumBuckets - NumBuckets / 8;
+  }
+
+  static uint64_t hashOf(const KeyT &Key) {
+    return swissmap_detail::mixHash(KeyInfoT::getHashValue(Key));
+  }
+  static CtrlT getH2(uint64_t Hash) { return CtrlT(Hash >> 57); }
+  unsigned getFirstGroup(uint64_t Hash) const {
+    return unsigned(Hash >> 32) & (NumBuckets / Group::Width - 1);
+  }
+
+  /// Return the index of the bucket holding \p Key, or NumBuckets.
+  unsigned findIndex(const KeyT &Key) const {
+    if (NumBuckets == 0)
+      return 0;
+    uint64_t Hash = hashOf(Key);
+    CtrlT H2 = getH2(Hash);
+    unsigned GroupMask = NumBuckets / Group::Width - 1;
+    unsigned G = getFirstGroup(Hash);
+    // Triangular steps visit every group of a power-of-two table, and the
+    // load limit guarantees that some group has an empty byte.
+    for (unsigned Step = 1;; ++Step) {
+      Group Grp(Ctrl + G * Group::Width);
+      for (unsigned Mask = Grp.match(H2); Mask; Mask &= Mask - 1) {
+        unsigned Idx = G * Group::Width + unsigned(countTrailingZeros(Mask));
+        if (KeyInfoT::isEqual(Buckets[Idx].first, Key))
+          return Idx;
+      }
+      if (Grp.matchEmpty())
+        return NumBuckets;
+      G = (G + Step) & GroupMask;
+    }
+  }
+
+  /// Return the first empty or deleted bucket on the probe sequence of
+  /// \p Hash.
+  unsigned findInsertIndex(uint64_t Hash) const {
+    unsigned GroupMask = NumBuckets / Group::Width - 1;
+    unsigned G = getFirstGroup(Hash);
+    for (unsigned Step = 1;; ++Step) {
+      unsigned Mask = Group(Ctrl + G * Group::Width).matchEmptyOrDeleted();
+      if (Mask)
+        return G * Group::Width + unsigned(countTrailingZeros(Mask));
+      G = (G + Step) & GroupMask;
+    }
+  }
+
+  void allocateBuckets(unsigned Num) {
+    NumBuckets = Num;
+    NumEntries = 0;
+    NumDeleted = 0;
+    if (Num == 0) {
+      Ctrl = nullptr;
+      Buckets = nullptr;
+      return;
+    }
+    Ctrl = static_cast<CtrlT *>(::operator new(Num));
+    std::memset(Ctrl, swissmap_detail::CtrlEmpty, Num);
+    Buckets = static_cast<value_type *>(::operator new(Num *
+                                                       sizeof(value_type)));
+  }
+
+  void destroyAll() {
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      if (Ctrl[I] >= 0)
+        Buckets[I].~value_type();
+    ::operator delete(Ctrl);
+    ::operator delete(Buckets);
+  }
+
+  /// Move every entry into a table of \p Num buckets, dropping deleted
+  /// markers.
+  void rehash(unsigned Num) {
+    CtrlT *OldCtrl = Ctrl;
+    value_type *OldBuckets = Buckets;
+    unsigned OldNumBuckets = NumBuckets;
+    unsigned OldNumEntries = NumEntries;
+    allocateBuckets(Num);
+    for (unsigned I = 0; I != OldNumBuckets; ++I) {
+      if (OldCtrl[I] < 0)
+        continue;
+      uint64_t Hash = hashOf(OldBuckets[I].first);
+      unsigned Idx = findInsertIndex(Hash);
+      Ctrl[Idx] = getH2(Hash);
+      new (&Buckets[Idx]) value_type(std::move(OldBuckets[I]));
+      OldBuckets[I].~value_type();
+    }
+    NumEntries = OldNumEntries;
+    ::operator delete(OldCtrl);
+    ::operator delete(OldBuckets);
+  }
+
+  /// Return a power-of-two number of buckets, at least one group, that
+  /// holds \p Entries within the load limit.
+  static unsigned getBucketsFor(unsigned Entries) {
+    unsigned Num = Group::Width;
+    while (getMaxLoad(Num) < Entries)
+      Num *= 2;
+    return Num;
+  }
+
+  /// Find the bucket for a new entry with hash \p Hash, growing or cleaning
+  /// the table first if it is full.
+  unsigned prepareInsert(uint64_t Hash) {
+    if (NumEntries + NumDeleted + 1 > getMaxLoad(NumBuckets))
+      rehash(getBucketsFor(NumEntries + 1));
+    unsigned Idx = findInsertIndex(Hash);
+    if (Ctrl[Idx] == swissmap_detail::CtrlDeleted)
+      --NumDeleted;
+    Ctrl[Idx] = getH2(Hash);
+    ++NumEntries;
+    return Idx;
+  }
+
+  void eraseIndex(unsigned Idx) {
+    Buckets[Idx].~value_type();
+    --NumEntries;
+    // A probe only moves past a group that has no empty byte, so if this
+    // group already has one, no probe sequence depends on this bucket.
+    unsigned GroupStart = Idx - Idx % Group::Width;
+    if (Group(Ctrl + GroupStart).matchEmpty()) {
+      Ctrl[Idx] = swissmap_detail::CtrlEmpty;
+    } else {
+      Ctrl[Idx] = swissmap_detail::CtrlDeleted;
+      ++NumDeleted;
+    }
+  }
+
+  iterator makeIterator(unsigned Idx) {
+    return iterator(Ctrl + Idx, Buckets + Idx, Ctrl + NumBuckets);
+  }
+  const_iterator makeIterator(unsigned Idx) const {
+    return const_iterator(Ctrl + Idx, Buckets + Idx, Ctrl + NumBuckets);
+  }
+
+public:
+  explicit SwissDenseMap(unsigned InitialReserve = 0) {
+    allocateBuckets(InitialReserve ? getBucketsFor(InitialReserve) : 0);
+  }
+
+  SwissDenseMap(const SwissDenseMap &Other) {
+    allocateBuckets(Other.NumEntries ? getBucketsFor(Other.NumEntries) : 0);
+    for (const_iterator I = Other.begin(), E = Other.end(); I != E; ++I)
+      insert(*I);
+  }
+
+  SwissDenseMap(SwissDenseMap &&Other) {
+    allocateBuckets(0);
+    swap(Other);
+  }
+
+  ~SwissDenseMap() { destroyAll(); }
+
+  SwissDenseMap &operator=(SwissDenseMap Other) {
+    swap(Other);
+    return *this;
+  }
+
+  void swap(SwissDenseMap &RHS) {
+    std::swap(Ctrl, RHS.Ctrl);
+    std::swap(Buckets, RHS.Buckets);
+    std::swap(NumBuckets, RHS.NumBuckets);
+    std::swap(NumEntries, RHS.NumEntries);
+    std::swap(NumDeleted, RHS.NumDeleted);
+  }
+
+  iterator begin() { return makeIterator(0); }
+  iterator end() { return makeIterator(NumBuckets); }
+  const_iterator begin() const { return makeIterator(0); }
+  const_iterator end() const { return makeIterator(NumBuckets); }
+
+  bool empty() const { return NumEntries == 0; }
+  unsigned size() const { return NumEntries; }
+
+  /// Grow the table so that \p NumEntries entries fit without rehashing.
+  void reserve(unsigned Entries) {
+    if (Entries + NumDeleted > getMaxLoad(NumBuckets))
+      rehash(getBucketsFor(Entries));
+  }
+
+  /// Destroy every entry, keeping the buckets.
+  void clear() {
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      if (Ctrl[I] >= 0)
+        Buckets[I].~value_type();
+    if (NumBuckets)
+      std::memset(Ctrl, swissmap_detail::CtrlEmpty, NumBuckets);
+    NumEntries = 0;
+    NumDeleted = 0;
+  }
+
+  /// Return 1 if the specified key is in the map, 0 otherwise.
+  size_type count(const KeyT &Key) const {
+    return findIndex(Key) != NumBuckets;
+  }
+
+  iterator find(const KeyT &Key) { return makeIterator(findIndex(Key)); }
+  const_iterator find(const KeyT &Key) const {
+    return makeIterator(findIndex(Key));
+  }
+
+  /// Return the entry for the specified key, or a default constructed value
+  /// if no such entry exists.
+  ValueT lookup(const KeyT &Key) const {
+    unsigned Idx = findIndex(Key);
+    return Idx != NumBuckets ? Buckets[Idx].second : ValueT();
+  }
+
+  /// Insert \p KV if its key is not already in the map.  Return an iterator
+  /// to the entry with that key and whether \p KV was inserted.
+  std::pair<iterator, bool> insert(const value_type &KV) {
+    unsigned Idx = findIndex(KV.first);
+    if (Idx != NumBuckets)
+      return std::make_pair(makeIterator(Idx), false);
+    Idx = prepareInsert(hashOf(KV.first));
+    new (&Buckets[Idx]) value_type(KV);
+    return std::make_pair(makeIterator(Idx), true);
+  }
+
+  std::pair<iterator, bool> insert(value_type &&KV) {
+    unsigned Idx = findIndex(KV.first);
+    if (Idx != NumBuckets)
+      return std::make_pair(makeIterator(Idx), false);
+    Idx = prepareInsert(hashOf(KV.first));
+    new (&Buckets[Idx]) value_type(std::move(KV));
+    return std::make_pair(makeIterator(Idx), true);
+  }
+
+  ValueT &operator[](const KeyT &Key) {
+    unsigned Idx = findIndex(Key);
+    if (Idx == NumBuckets) {
+      Idx = prepareInsert(hashOf(Key));
+      new (&Buckets[Idx]) value_type(Key, ValueT());
+    }
+    return Buckets[Idx].second;
+  }
+
+  bool erase(const KeyT &Key) {
+    unsigned Idx = findIndex(Key);
+    if (Idx == NumBuckets)
+      return false;
+    eraseIndex(Idx);
+    return true;
+  }
+
+  void erase(iterator I) { eraseIndex(unsigned(I.Bucket - Buckets)); }
+
+  /// Return the number of bytes used by the table, for comparing it with
+  /// DenseMap::getMemorySize().
+  size_t getMemorySize() const {
+    return NumBuckets * (sizeof(value_type) + sizeof(CtrlT));
+  }
+};
+
+template <typename KeyT, typename ValueT, bool IsConst>
+class SwissDenseMapIterator {
+  template <typename, typename, typename> friend class SwissDenseMap;
+  friend class SwissDenseMapIterator<KeyT, ValueT, true>;
+
+  typedef std::pair<KeyT, ValueT> BucketT;
+  typedef swissmap_detail::CtrlT CtrlT;
+
+public:
+  typedef std::ptrdiff_t difference_type;
+  typedef typename std::conditional<IsConst, const BucketT, BucketT>::type
+      value_type;
+  typedef value_type *pointer;
+  typedef value_type &reference;
+  typedef std::forward_iterator_tag iterator_category;
+
+private:
+  const CtrlT *Ctrl;
+  pointer Bucket;
+  const CtrlT *End;
+
+  void skipEmpty() {
+    while (Ctrl != End && *Ctrl < 0) {
+      ++Ctrl;
+      ++Bucket;
+    }
+  }
+
+public:
+  SwissDenseMapIterator() : Ctrl(nullptr), Bucket(nullptr), End(nullptr) {}
+  SwissDenseMapIterator(const CtrlT *Ctrl, pointer Bucket, const CtrlT *End)
+    : Ctrl(Ctrl), Bucket(Bucket), End(End) {
+    skipEmpty();
+  }
+
+  // Allow conversion from iterator to const_iterator.
+  template <bool WasConst>
+  SwissDenseMapIterator(
+      const SwissDenseMapIterator<KeyT, ValueT, WasConst> &I,
+      typename std::enable_if<IsConst && !WasConst>::type * = nullptr)
+    : Ctrl(I.Ctrl), Bucket(I.Bucket), End(I.End) {}
+
+  reference operator*() const { return *Bucket; }
+  pointer operator->() const { return Bucket; }
+
+  bool operator==(const SwissDenseMapIterator &RHS) const {
+    return Ctrl == RHS.Ctrl;
+  }
+  bool operator!=(const SwissDenseMapIterator &RHS) const {
+    return Ctrl != RHS.Ctrl;
+  }
+
+  SwissDenseMapIterator &operator++() {
+    ++Ctrl;
+    ++Bucket;
+    skipEmpty();
+    return *this;
+  }
+  SwissDenseMapIterator operator++(int) {
+    SwissDenseMapIterator Tmp = *this;
+    ++*this;
+    return Tmp;
+  }
+};
+
+} // end namespace llvm
+
+#endif
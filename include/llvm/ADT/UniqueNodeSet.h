@@ -0,0 +1,191 @@
+//===- llvm/ADT/UniqueNodeSet.h - Keyed uniquing hash table -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the UniqueNodeSet class, an open-addressed table that
+// uniques nodes by a small fixed-size key, as a faster replacement for
+// FoldingSet when every node is identified by a few values.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_UNIQUENODESET_H
+#define LLVM_ADT_UNIQUENODESET_H
+
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/DataTypes.h"
+#include <cassert>
+#include <cstdlib>
+
+namespace llvm {
+
+/// UniqueNodeSet - A set of nodes that can be found by their key.
+///
+/// FoldingSet profiles every lookup into a FoldingSetNodeID, a vector of the
+/// node's components, hashes the vector, and then profiles each node in the
+/// bucket chain to compare it.  For nodes identified by a couple of
+/// pointers, this table instead takes a key struct and its hash, stores the
+/// full hash next to each node, and only compares keys whose hashes match.
+/// The buckets are probed quadratically, like DenseMap's.
+///
+/// \p InfoT must provide:
+///   typedef ... KeyT;
+///   static unsigned getHashValue(const KeyT &Key);
+///   static bool isEqual(const KeyT &Key, const NodeT *Node);
+///
+/// The interface follows FoldingSet's FindNodeOrInsertPos and InsertNode, so
+/// that a node can be created only when it is not found.  Nodes are not
+/// owned by the set; RemoveNode leaves a tombstone in their bucket, which a
+/// later insertion or rehash reclaims.
+template <typename NodeT, typename InfoT>
+class UniqueNodeSet {
+public:
+  typedef typename InfoT::KeyT KeyT;
+
+  /// InsertPos - Where FindNodeOrInsertPos found no node for a key.
+  struct InsertPos {
+    unsigned Bucket;
+    unsigned Hash;
+    /// The size of the table when Bucket was found.
+    unsigned NumBuckets;
+  };
+
+private:
+  struct BucketT {
+    NodeT *Node;
+    unsigned Hash;
+  };
+
+  BucketT *Buckets;
+  unsigned NumBuckets;
+  unsigned NumNodes;
+  unsigned NumTombstones;
+
+  static NodeT *getTombstone() {
+    return reinterpret_cast<NodeT *>(~uintptr_t(0));
+  }
+  static bool isLive(const NodeT *N) { return N && N != getTombstone(); }
+
+  UniqueNodeSet(const UniqueNodeSet &) LLVM_DELETED_FUNCTION;
+  void operator=(const UniqueNodeSet &) LLVM_DELETED_FUNCTION;
+
+  /// Find the first bucket without a live node on the probe sequence of
+  /// \p Hash.
+  unsigned findEmptyBucket(unsigned Hash) const {
+    unsigned Mask = NumBuckets - 1;
+    for (unsigned Bucket = Hash & Mask, Probe = 1;; Bucket += Probe++) {
+      Bucket &= Mask;
+      if (!isLive(Buckets[Bucket].Node))
+        return Bucket;
+    }
+  }
+
+  /// Rehash into \p NewNumBuckets buckets, a power of two.
+  void grow(unsigned NewNumBuckets) {
+    BucketT *OldBuckets = Buckets;
+    unsigned OldNumBuckets = NumBuckets;
+    NumBuckets = NewNumBuckets;
+    Buckets = static_cast<BucketT *>(calloc(NumBuckets, sizeof(BucketT)));
+    for (unsigned i = 0; i != OldNumBuckets; ++i)
+      if (isLive(OldBuckets[i].Node))
+        Buckets[findEmptyBucket(OldBuckets[i].Hash)] = OldBuckets[i];
+    free(OldBuckets);
+    NumTombstones = 0;
+  }
+
+public:
+  UniqueNodeSet()
+    : Buckets(nullptr), NumBuckets(0), NumNodes(0), NumTombstones(0) {}
+  ~UniqueNodeSet() { free(Buckets); }
+
+  unsigned size() const { return NumNodes; }
+  bool empty() const { return NumNodes == 0; }
+
+  /// FindNodeOrInsertPos - Look up the node for \p Key.  If there is none,
+  /// return null and set \p Pos to where InsertNode should put the node for
+  /// the key.
+  NodeT *FindNodeOrInsertPos(const KeyT &Key, InsertPos &Pos) {
+    Pos.Hash = InfoT::getHashValue(Key);
+    Pos.NumBuckets = NumBuckets;
+    Pos.Bucket = 0;
+    if (NumBuckets == 0)
+      return nullptr;
+    unsigned Mask = NumBuckets - 1;
+    unsigned FirstTombstone = ~0U;
+    for (unsigned Bucket = Pos.Hash & Mask, Probe = 1;; Bucket += Probe++) {
+      Bucket &= Mask;
+      const BucketT &B = Buckets[Bucket];
+      if (!B.Node) {
+        Pos.Bucket = FirstTombstone != ~0U ? FirstTombstone : Bucket;
+        return nullptr;
+      }
+      if (B.Node == getTombstone()) {
+        if (FirstTombstone == ~0U)
+          FirstTombstone = Bucket;
+        continue;
+      }
+      if (B.Hash == Pos.Hash && InfoT::isEqual(Key, B.Node))
+        return B.Node;
+    }
+  }
+
+  /// InsertNode - Insert \p N, whose key was just looked up unsuccessfully
+  /// through FindNodeOrInsertPos, at \p Pos.  Nodes created in between (for
+  /// instance, the canonical type of \p N) may have been inserted since.
+  void InsertNode(NodeT *N, InsertPos Pos) {
+    assert(isLive(N) && "Inserting a null node");
+    bool Rehashed = false;
+    if (LLVM_UNLIKELY((NumNodes + NumTombstones + 1) * 4 >= NumBuckets * 3)) {
+      // Rehash in place if tombstones take up most of the table.
+      grow(NumBuckets == 0 ? 64
+                           : NumNodes * 2 < NumBuckets ? NumBuckets
+                                                       : NumBuckets * 2);
+      Rehashed = true;
+    }
+    // A rehash moves the nodes, even one in place that keeps NumBuckets, so
+    // Pos may no longer be the first free bucket on the probe sequence; a
+    // node put after an empty bucket could not be found again.
+    if (Rehashed || Pos.NumBuckets != NumBuckets ||
+        isLive(Buckets[Pos.Bucket].Node))
+      Pos.Bucket = findEmptyBucket(Pos.Hash);
+    if (Buckets[Pos.Bucket].Node)
+      --NumTombstones;
+    Buckets[Pos.Bucket].Node = N;
+    Buckets[Pos.Bucket].Hash = Pos.Hash;
+    ++NumNodes;
+  }
+
+  /// RemoveNode - Remove \p N, whose key hashes to \p Hash, for instance
+  /// because it is about to be destroyed or its key is about to change.
+  /// \returns false if \p N is not in the set.
+  bool RemoveNode(NodeT *N, unsigned Hash) {
+    if (NumBuckets == 0)
+      return false;
+    unsigned Mask = NumBuckets - 1;
+    for (unsigned Bucket = Hash & Mask, Probe = 1;; Bucket += Probe++) {
+      Bucket &= Mask;
+      BucketT &B = Buckets[Bucket];
+      if (!B.Node)
+        return false;
+      if (B.Node == N) {
+        B.Node = getTombstone();
+        --NumNodes;
+        ++NumTombstones;
+        return true;
+      }
+    }
+  }
+
+  unsigned getNumBuckets() const { return NumBuckets; }
+
+  /// getMemorySize - The number of bytes allocated for the buckets.
+  size_t getMemorySize() const { return NumBuckets * sizeof(BucketT); }
+};
+
+} // end namespace llvm
+
+#endif
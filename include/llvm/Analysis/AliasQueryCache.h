@@ -0,0 +1,100 @@
+//===- llvm/Analysis/AliasQueryCache.h - Cached alias queries ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines AliasQueryCache, which remembers the results of alias
+// queries for a pass that asks the same ones many times while it works on a
+// function, as GVN and DSE do through MemoryDependenceAnalysis.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_ALIASQUERYCACHE_H
+#define LLVM_ANALYSIS_ALIASQUERYCACHE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include <utility>
+
+namespace llvm {
+
+/// AliasQueryCache - Answers AliasAnalysis::alias queries from a cache keyed
+/// by the pair of locations.
+///
+/// The cache is meant to live for as long as a pass works on one function.
+/// Results stay valid while the IR the locations point into is unchanged, so
+/// a client that transforms the function must keep the cache in step: call
+/// deleteValue instead of AliasAnalysis::deleteValue when deleting a value,
+/// which also drops the queries about it, and clear after changing how a
+/// pointer that may have been queried is computed.
+class AliasQueryCache {
+  typedef AliasAnalysis::Location Location;
+  typedef std::pair<Location, Location> LocPair;
+
+  AliasAnalysis &AA;
+  DenseMap<LocPair, AliasAnalysis::AliasResult> Cache;
+  /// The keys of Cache each pointer appears in, so that deleteValue does not
+  /// scan the whole cache.  Entries may name keys already dropped through
+  /// the other pointer.
+  DenseMap<const Value *, SmallVector<LocPair, 4> > KeysOf;
+  unsigned NumHits;
+  unsigned NumQueries;
+
+public:
+  explicit AliasQueryCache(AliasAnalysis &AA)
+    : AA(AA), NumHits(0), NumQueries(0) {}
+
+  AliasAnalysis &getAliasAnalysis() const { return AA; }
+
+  /// alias - As AliasAnalysis::alias, which is symmetric, so the pair of
+  /// locations is cached in one order only.
+  AliasAnalysis::AliasResult alias(const Location &LocA,
+                                   const Location &LocB) {
+    ++NumQueries;
+    LocPair Key = LocA.Ptr <= LocB.Ptr ? LocPair(LocA, LocB)
+                                       : LocPair(LocB, LocA);
+    DenseMap<LocPair, AliasAnalysis::AliasResult>::iterator I =
+        Cache.find(Key);
+    if (I != Cache.end()) {
+      ++NumHits;
+      return I->second;
+    }
+    AliasAnalysis::AliasResult Result = AA.alias(LocA, LocB);
+    Cache[Key] = Result;
+    KeysOf[Key.first.Ptr].push_back(Key);
+    if (Key.second.Ptr != Key.first.Ptr)
+      KeysOf[Key.second.Ptr].push_back(Key);
+    return Result;
+  }
+
+  /// deleteValue - Drop the queries about \p V, then tell the alias
+  /// analysis that it is being deleted.
+  void deleteValue(Value *V) {
+    DenseMap<const Value *, SmallVector<LocPair, 4> >::iterator I =
+        KeysOf.find(V);
+    if (I != KeysOf.end()) {
+      for (unsigned i = 0, e = I->second.size(); i != e; ++i)
+        Cache.erase(I->second[i]);
+      KeysOf.erase(I);
+    }
+    AA.deleteValue(V);
+  }
+
+  /// clear - Forget every result.
+  void clear() {
+    Cache.clear();
+    KeysOf.clear();
+  }
+
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumQueries() const { return NumQueries; }
+};
+
+} // End llvm namespace
+
+#endif
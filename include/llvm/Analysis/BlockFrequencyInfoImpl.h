@@ -70,6 +70,10 @@ class BlockFrequencyInfoImpl {
 
   static const uint64_t EntryFreq = 1 << 14;
 
+  // The number of sweeps over an irreducible loop that estimate how much of
+  // the mass of its side entries goes around it.
+  static const unsigned SideEntrySweeps = 4;
+
   std::string getBlockName(BasicBlock *BB) const {
     return BB->getName().str();
   }
@@ -118,6 +122,42 @@ class BlockFrequencyInfoImpl {
   typedef DenseMap<BlockT*, BranchProbability> LoopExitProbMap;
   LoopExitProbMap LoopExitProb;
 
+  // Irreducible loops are also entered at blocks other than their header.
+  // For each loop header, record these side entry edges with the
+  // probability that the mass they bring reaches a backedge to the header,
+  // after which it goes around the loop as if it had entered at the header.
+  // An edge that enters several nested loops belongs to the outermost one
+  // only, which keeps the lists as long as the number of such edges.
+  struct SideEntry {
+    BlockT *Pred, *BB;
+    BranchProbability BackProb;
+    SideEntry(BlockT *Pred, BlockT *BB, BranchProbability BackProb)
+      : Pred(Pred), BB(BB), BackProb(BackProb) {}
+  };
+  typedef DenseMap<BlockT *, SmallVector<SideEntry, 4> > SideEntryMap;
+  SideEntryMap SideEntries;
+  typedef std::pair<BlockT *, BlockT *> EdgeT;
+  DenseMap<EdgeT, std::pair<BlockT *, unsigned> > SideEntryOwner;
+
+  void addSideEntry(BlockT *Head, BlockT *Pred, BlockT *BB,
+                    BranchProbability BackProb) {
+    std::pair<BlockT *, unsigned> &Owner = SideEntryOwner[EdgeT(Pred, BB)];
+    if (Owner.first) {
+      // Loops are walked inner first, so this is an outer loop taking the
+      // edge over from an inner one.
+      SmallVectorImpl<SideEntry> &Old = SideEntries[Owner.first];
+      if (Owner.second + 1 != Old.size()) {
+        Old[Owner.second] = Old.back();
+        SideEntryOwner.find(EdgeT(Old.back().Pred, Old.back().BB))
+            ->second.second = Owner.second;
+      }
+      Old.pop_back();
+    }
+    SmallVectorImpl<SideEntry> &List = SideEntries[Head];
+    Owner = std::make_pair(Head, unsigned(List.size()));
+    List.push_back(SideEntry(Pred, BB, BackProb));
+  }
+
   // (reverse-)postorder traversal iterators.
   typedef typename std::vector<BlockT *>::iterator pot_iterator;
   typedef typename std::vector<BlockT *>::reverse_iterator rpot_iterator;
@@ -128,12 +168,13 @@ class BlockFrequencyInfoImpl {
   rpot_iterator rpot_begin() { return POT.rbegin(); }
   rpot_iterator rpot_end() { return POT.rend(); }
 
-  rpot_iterator rpot_at(BlockT *BB) {
-    rpot_iterator I = rpot_begin();
-    unsigned idx = RPO.lookup(BB);
-    assert(idx);
-    std::advance(I, idx - 1);
+  rpot_iterator rpot_at_index(unsigned idx) {
+    assert(idx && idx <= POT.size());
+    return rpot_begin() + (idx - 1);
+  }
 
+  rpot_iterator rpot_at(BlockT *BB) {
+    rpot_iterator I = rpot_at_index(RPO.lookup(BB));
     assert(*I == BB);
     return I;
   }
@@ -149,6 +190,14 @@ class BlockFrequencyInfoImpl {
     return a >= b;
   }
 
+  /// isVisitedPred - Return true if Pred, a predecessor of BB, comes before
+  /// BB in the loop whose header is at RPO index HeadIdx, that is, has
+  /// already been visited by the doLoop walking that loop.
+  bool isVisitedPred(BlockT *Pred, BlockT *BB, unsigned HeadIdx) const {
+    unsigned Idx = RPO.lookup(Pred);
+    return Idx >= HeadIdx && Idx < RPO.lookup(BB);
+  }
+
   /// getSingleBlockPred - return single BB block predecessor or NULL if
   /// BB has none or more predecessors.
   BlockT *getSingleBlockPred(BlockT *BB) {
@@ -168,8 +217,7 @@ class BlockFrequencyInfoImpl {
     return Pred;
   }
 
-  void doBlock(BlockT *BB, BlockT *LoopHead,
-               SmallPtrSet<BlockT *, 8> &BlocksInLoop) {
+  void doBlock(BlockT *BB, BlockT *LoopHead, unsigned HeadIdx) {
 
     DEBUG(dbgs() << "doBlock(" << getBlockName(BB) << ")\n");
     setBlockFreq(BB, 0);
@@ -180,9 +228,8 @@ class BlockFrequencyInfoImpl {
     }
 
     if (BlockT *Pred = getSingleBlockPred(BB)) {
-      if (BlocksInLoop.count(Pred))
+      if (isVisitedPred(Pred, BB, HeadIdx))
         setBlockFreq(BB, getEdgeFreq(Pred, BB));
-      // TODO: else? irreducible, ignore it for now.
       return;
     }
 
@@ -197,11 +244,23 @@ class BlockFrequencyInfoImpl {
 
       if (isBackedge(Pred, BB)) {
         isLoopHead = true;
-      } else if (BlocksInLoop.count(Pred)) {
+      } else if (isVisitedPred(Pred, BB, HeadIdx)) {
         incBlockFreq(BB, getEdgeFreq(Pred, BB));
         isInLoop = true;
       }
-      // TODO: else? irreducible.
+    }
+
+    if (isLoopHead) {
+      typename SideEntryMap::const_iterator I = SideEntries.find(BB);
+      if (I != SideEntries.end()) {
+        for (unsigned i = 0, e = I->second.size(); i != e; ++i) {
+          const SideEntry &SE = I->second[i];
+          if (!isVisitedPred(SE.Pred, BB, HeadIdx))
+            continue;
+          incBlockFreq(BB, getEdgeFreq(SE.Pred, SE.BB) * SE.BackProb);
+          isInLoop = true;
+        }
+      }
     }
 
     if (!isInLoop)
@@ -220,18 +279,122 @@ class BlockFrequencyInfoImpl {
           printBlockFreq(dbgs(), Freqs[BB]) << ".\n");
   }
 
+  /// findSideEntries - Record the edges that enter the cycle through Head
+  /// and its backedges at a block other than Head.  In RPO these are exactly
+  /// the edges into the cycle from blocks before Head, and they only exist
+  /// when the loop is irreducible, as in the dispatch of a generated state
+  /// machine.
+  void findSideEntries(BlockT *Head, unsigned HeadIdx, unsigned TailIdx) {
+    // Look for edges into the loop's RPO range first: they are rare, and
+    // finding the cycle is only needed to tell the side entries among them
+    // from edges to blocks after the loop's exits.
+    SmallVector<EdgeT, 8> Entries;
+    rpot_iterator I = rpot_at_index(HeadIdx);
+    for (unsigned Idx = HeadIdx + 1; Idx <= TailIdx; ++Idx) {
+      BlockT *BB = *++I;
+      for (typename GT::ChildIteratorType PI = GT::child_begin(BB),
+           PE = GT::child_end(BB); PI != PE; ++PI) {
+        unsigned PredIdx = RPO.lookup(*PI);
+        if (PredIdx && PredIdx < HeadIdx)
+          Entries.push_back(EdgeT(*PI, BB));
+      }
+    }
+    if (Entries.empty())
+      return;
+
+    // The blocks of the cycle, which reach a backedge to Head without leaving
+    // the RPO range of the loop.
+    std::vector<bool> InCycle(TailIdx - HeadIdx + 1);
+    SmallVector<BlockT *, 16> Worklist;
+    for (typename GT::ChildIteratorType PI = GT::child_begin(Head),
+         PE = GT::child_end(Head); PI != PE; ++PI) {
+      BlockT *Pred = *PI;
+      unsigned Idx = RPO.lookup(Pred);
+      if (isBackedge(Pred, Head) && !InCycle[Idx - HeadIdx]) {
+        InCycle[Idx - HeadIdx] = true;
+        Worklist.push_back(Pred);
+      }
+    }
+    while (!Worklist.empty()) {
+      BlockT *BB = Worklist.pop_back_val();
+      if (BB == Head)
+        continue;
+      for (typename GT::ChildIteratorType PI = GT::child_begin(BB),
+           PE = GT::child_end(BB); PI != PE; ++PI) {
+        BlockT *Pred = *PI;
+        unsigned Idx = RPO.lookup(Pred);
+        if (Idx < HeadIdx || Idx > TailIdx || InCycle[Idx - HeadIdx])
+          continue;
+        InCycle[Idx - HeadIdx] = true;
+        Worklist.push_back(Pred);
+      }
+    }
+
+    unsigned NumEntries = 0;
+    for (unsigned i = 0, e = Entries.size(); i != e; ++i)
+      if (InCycle[RPO.lookup(Entries[i].second) - HeadIdx])
+        Entries[NumEntries++] = Entries[i];
+    if (!NumEntries)
+      return;
+    Entries.resize(NumEntries);
+
+    // BackFreq[i] is the frequency with which control entering the block at
+    // HeadIdx + i with EntryFreq reaches a backedge to Head without leaving
+    // the cycle.  Each block's value is the sum over its successors, so one
+    // sweep against RPO settles the acyclic part of the cycle, and each
+    // further sweep carries the values of inner headers back over their
+    // backedges.  This keeps the cost linear in the size of the loop.
+    std::vector<uint64_t> BackFreq(TailIdx - HeadIdx + 1);
+    for (unsigned Sweep = 0; Sweep != SideEntrySweeps; ++Sweep) {
+      for (unsigned Idx = TailIdx; Idx > HeadIdx; --Idx) {
+        if (!InCycle[Idx - HeadIdx])
+          continue;
+        BlockT *BB = *rpot_at_index(Idx);
+        BlockFrequency Freq;
+        for (typename GraphTraits<BlockT *>::ChildIteratorType
+             SI = GraphTraits<BlockT *>::child_begin(BB),
+             SE = GraphTraits<BlockT *>::child_end(BB); SI != SE; ++SI) {
+          BlockT *Succ = *SI;
+          unsigned SuccIdx = RPO.lookup(Succ);
+          if (SuccIdx < HeadIdx || SuccIdx > TailIdx)
+            continue;
+          BlockFrequency SuccFreq =
+              Succ == Head ? EntryFreq : BackFreq[SuccIdx - HeadIdx];
+          Freq += SuccFreq * BPI->getEdgeProbability(BB, Succ);
+        }
+        BackFreq[Idx - HeadIdx] =
+            std::min(Freq.getFrequency(), uint64_t(EntryFreq));
+      }
+    }
+
+    for (unsigned i = 0, e = Entries.size(); i != e; ++i) {
+      BlockT *Pred = Entries[i].first, *BB = Entries[i].second;
+      BranchProbability BackProb(BackFreq[RPO.lookup(BB) - HeadIdx],
+                                 EntryFreq);
+      addSideEntry(Head, Pred, BB, BackProb);
+      DEBUG(dbgs() << "Irreducible entry " << getBlockName(Pred) << " -> "
+                   << getBlockName(BB) << " returns to "
+                   << getBlockName(Head) << " with " << BackProb << "\n");
+    }
+  }
+
   /// doLoop - Propagate block frequency down through the loop.
   void doLoop(BlockT *Head, BlockT *Tail) {
     DEBUG(dbgs() << "doLoop(" << getBlockName(Head) << ", "
                  << getBlockName(Tail) << ")\n");
 
-    SmallPtrSet<BlockT *, 8> BlocksInLoop;
+    // The blocks visited so far are the RPO range from Head to the current
+    // block, so membership is an index comparison rather than a set that
+    // grows with the loop.
+    unsigned HeadIdx = RPO.lookup(Head);
+    unsigned TailIdx = RPO.lookup(Tail);
+    if (Head != Tail)
+      findSideEntries(Head, HeadIdx, TailIdx);
 
     for (rpot_iterator I = rpot_at(Head), E = rpot_at(Tail); ; ++I) {
       BlockT *BB = *I;
-      doBlock(BB, Head, BlocksInLoop);
+      doBlock(BB, Head, HeadIdx);
 
-      BlocksInLoop.insert(BB);
       if (I == E)
         break;
     }
@@ -297,6 +460,8 @@ class BlockFrequencyInfoImpl {
     RPO.clear();
     POT.clear();
     LoopExitProb.clear();
+    SideEntries.clear();
+    SideEntryOwner.clear();
     Freqs.clear();
 
     BlockT *EntryBlock = fn->begin();
@@ -14,7 +14,10 @@
 #ifndef LLVM_ANALYSIS_INLINECOST_H
 #define LLVM_ANALYSIS_INLINECOST_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Analysis/CallGraphSCCPass.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/ValueHandle.h"
 #include <cassert>
 #include <climits>
 
@@ -101,6 +104,53 @@ public:
 class InlineCostAnalysis : public CallGraphSCCPass {
   const TargetTransformInfo *TTI;
 
+  /// ViableVH - A cached result of isInlineViable, dropped when the callee
+  /// is deleted so that a function later allocated at the same address does
+  /// not inherit it.  Unlike a ValueMap key it does not follow RAUW: a
+  /// function whose uses were replaced, possibly by a bitcast, still has the
+  /// same body.
+  class ViableVH : public CallbackVH {
+    InlineCostAnalysis *Owner;
+
+  public:
+    bool Viable;
+
+    ViableVH(const Function *F, bool Viable, InlineCostAnalysis *Owner)
+      : CallbackVH(const_cast<Function *>(F)), Owner(Owner), Viable(Viable) {}
+
+    void deleted() override {
+      // Erasing the entry destroys *this.
+      Owner->ViableCallees.erase(cast<Function>(getValPtr()));
+    }
+  };
+
+  /// ViableCallees - The results of isInlineViable, which only depend on the
+  /// body of the callee and so are shared by all of its call sites.
+  ///
+  /// An entry is only valid while the body is unchanged.  runOnSCC drops the
+  /// entries of the functions in the SCC, which the passes run on it may
+  /// still change, and functionModified drops that of a function changed in
+  /// any other way, such as a caller the inliner has just inlined into.
+  /// Deleted functions drop their own entry, and doFinalization drops all
+  /// of them, since passes outside the SCC pass manager may change anything.
+  DenseMap<const Function *, ViableVH> ViableCallees;
+
+  /// Find the cached result of isInlineViable for \p F; returns false if
+  /// there is none.
+  bool getCachedViability(const Function *F, bool &Viable) const {
+    DenseMap<const Function *, ViableVH>::const_iterator I =
+        ViableCallees.find(F);
+    if (I == ViableCallees.end())
+      return false;
+    Viable = I->second.Viable;
+    return true;
+  }
+
+  void cacheViability(const Function *F, bool Viable) {
+    ViableCallees.erase(F);
+    ViableCallees.insert(std::make_pair(F, ViableVH(F, Viable, this)));
+  }
+
 public:
   static char ID;
 
@@ -110,6 +160,14 @@ public:
   // Pass interface implementation.
   void getAnalysisUsage(AnalysisUsage &AU) const override;
   bool runOnSCC(CallGraphSCC &SCC) override;
+  using llvm::Pass::doFinalization;
+  bool doFinalization(CallGraph &CG) override {
+    ViableCallees.clear();
+    return false;
+  }
+
+  /// \brief Forget what is cached about \p F, whose body has changed.
+  void functionModified(const Function &F) { ViableCallees.erase(&F); }
 
   /// \brief Get an InlineCost object representing the cost of inlining this
   /// callsite.
@@ -222,6 +222,15 @@ public:
     /// loop body even when the number of loop iterations is not known at compile
     /// time).
     bool     Runtime;
+    /// The latency, in cycles, of the loads in the loop body that partial and
+    /// runtime unrolling should hide by overlapping iterations, such as
+    /// the NEON load latency of the target's scheduling model.  When not 0,
+    /// the unrolling factor is chosen by computePipelinedUnrollCount, still
+    /// within the (PartialOptSize)Threshold.
+    unsigned PipelineLatency;
+    /// The number of instructions issued per cycle that PipelineLatency is
+    /// measured against (the scheduling model's IssueWidth).
+    unsigned PipelineIssueWidth;
   };
 
   /// \brief Get target-customized preferences for the generic loop unrolling
@@ -381,6 +390,18 @@ public:
                                    unsigned Alignment,
                                    unsigned AddressSpace) const;
 
+  /// \return The cost of an interleaved load or store of \p Factor vectors
+  /// of type \p VecTy, i.e. of the members of a group of accesses with
+  /// stride \p Factor, such as the channels of packed RGB pixels.
+  ///
+  /// Targets with structured loads and stores, such as NEON's vld2/vld3 and
+  /// vst2/vst3, return the cost of those. The default is the cost of
+  /// \p Factor wide accesses plus the shuffles that (de)interleave them.
+  virtual unsigned getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                              unsigned Factor,
+                                              unsigned Alignment,
+                                              unsigned AddressSpace) const;
+
   /// \brief Calculate the cost of performing a vector reduction.
   ///
   /// This is the cost of reducing the vector value of type \p Ty to a scalar
@@ -18,13 +18,29 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Bitcode/BitCodes.h"
+#include "llvm/Support/raw_ostream.h"
 #include <vector>
 
 namespace llvm {
 
 class BitstreamWriter {
+  /// Out - The buffered part of the stream; with a backing file, the bytes
+  /// after the first FlushedBytes.
   SmallVectorImpl<char> &Out;
 
+  /// FS - The file that completed blocks are flushed to, if any.
+  raw_fd_ostream *FS;
+
+  /// FSBase - The offset in FS at which the stream starts.
+  uint64_t FSBase;
+
+  /// FlushedBytes - The number of bytes already written to FS.
+  uint64_t FlushedBytes;
+
+  /// FlushThreshold - Out is flushed to FS when a block ends and it holds at
+  /// least this many bytes.
+  size_t FlushThreshold;
+
   /// CurBit - Always between 0 and 31 inclusive, specifies the next bit to use.
   unsigned CurBit;
 
@@ -61,12 +77,35 @@ class BitstreamWriter {
   std::vector<BlockInfo> BlockInfoRecords;
 
   // BackpatchWord - Backpatch a 32-bit word in the output with the specified
-  // value.
-  void BackpatchWord(unsigned ByteNo, unsigned NewWord) {
-    Out[ByteNo++] = (unsigned char)(NewWord >>  0);
-    Out[ByteNo++] = (unsigned char)(NewWord >>  8);
-    Out[ByteNo++] = (unsigned char)(NewWord >> 16);
-    Out[ByteNo  ] = (unsigned char)(NewWord >> 24);
+  // value.  Words that were already flushed are rewritten in place in FS.
+  void BackpatchWord(uint64_t ByteNo, unsigned NewWord) {
+    unsigned char Bytes[4] = {
+      (unsigned char)(NewWord >>  0),
+      (unsigned char)(NewWord >>  8),
+      (unsigned char)(NewWord >> 16),
+      (unsigned char)(NewWord >> 24) };
+    if (ByteNo < FlushedBytes) {
+      // Flushes only happen at word boundaries, so the word is entirely in
+      // the file.
+      assert(FS && ByteNo + 4 <= FlushedBytes && "Word not flushed");
+      uint64_t Pos = FS->tell();
+      FS->seek(FSBase + ByteNo);
+      FS->write(reinterpret_cast<const char *>(Bytes), 4);
+      FS->seek(Pos);
+      return;
+    }
+    ByteNo -= FlushedBytes;
+    Out[ByteNo++] = Bytes[0];
+    Out[ByteNo++] = Bytes[1];
+    Out[ByteNo++] = Bytes[2];
+    Out[ByteNo  ] = Bytes[3];
+  }
+
+  /// FlushToFileIfNeeded - Write the buffered bytes to FS once there are
+  /// enough of them.  Called when a block ends, at a word boundary.
+  void FlushToFileIfNeeded() {
+    if (FS && Out.size() >= FlushThreshold)
+      FlushToFile();
   }
 
   void WriteByte(unsigned char Value) {
@@ -82,19 +121,33 @@ class BitstreamWriter {
     Out.append(&Bytes[0], &Bytes[4]);
   }
 
-  unsigned GetBufferOffset() const {
-    return Out.size();
+  uint64_t GetBufferOffset() const {
+    return FlushedBytes + Out.size();
   }
 
   unsigned GetWordIndex() const {
-    unsigned Offset = GetBufferOffset();
+    uint64_t Offset = GetBufferOffset();
     assert((Offset & 3) == 0 && "Not 32-bit aligned");
     return Offset / 4;
   }
 
 public:
   explicit BitstreamWriter(SmallVectorImpl<char> &O)
-    : Out(O), CurBit(0), CurValue(0), CurCodeSize(2) {}
+    : Out(O), FS(nullptr), FSBase(0), FlushedBytes(0), FlushThreshold(0),
+      CurBit(0), CurValue(0), CurCodeSize(2) {}
+
+  /// Create a writer that streams to \p FS: each time a block ends and \p O
+  /// holds at least \p FlushThreshold bytes, they are written to \p FS, and
+  /// the sizes of the blocks still open are backpatched in the file.  Peak
+  /// memory is then bounded by the largest run of records between block
+  /// ends, not by the size of the whole stream.  \p FS must be a regular
+  /// file, since flushed words are rewritten with seek, and the caller must
+  /// call FlushToFile() once it is done writing.
+  BitstreamWriter(SmallVectorImpl<char> &O, raw_fd_ostream &FS,
+                  size_t FlushThreshold = 1 << 20)
+    : Out(O), FS(&FS), FSBase(FS.tell()), FlushedBytes(0),
+      FlushThreshold(FlushThreshold), CurBit(0), CurValue(0),
+      CurCodeSize(2) {}
 
   ~BitstreamWriter() {
     assert(CurBit == 0 && "Unflushed data remaining");
@@ -111,6 +164,16 @@ public:
     }
   }
 
+  /// \brief Write everything buffered so far to the backing file.  The
+  /// stream must be at a word boundary.
+  void FlushToFile() {
+    assert(FS && "No file to flush to");
+    assert(CurBit == 0 && "Flushing in the middle of a word");
+    FS->write(Out.data(), Out.size());
+    FlushedBytes += Out.size();
+    Out.clear();
+  }
+
   /// \brief Retrieve the current position in the stream, in bits.
   uint64_t GetCurrentBitNo() const { return GetBufferOffset() * 8 + CurBit; }
 
@@ -256,7 +319,7 @@ public:
 
     // Compute the size of the block, in words, not counting the size field.
     unsigned SizeInWords = GetWordIndex() - B.StartSizeWord - 1;
-    unsigned ByteNo = B.StartSizeWord*4;
+    uint64_t ByteNo = uint64_t(B.StartSizeWord)*4;
 
     // Update the block size field in the header of this sub-block.
     BackpatchWord(ByteNo, SizeInWords);
@@ -265,6 +328,8 @@ public:
     CurCodeSize = B.PrevCodeSize;
     BlockScope.back().PrevAbbrevs.swap(CurAbbrevs);
     BlockScope.pop_back();
+
+    FlushToFileIfNeeded();
   }
 
   //===--------------------------------------------------------------------===//
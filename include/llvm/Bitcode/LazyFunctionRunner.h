@@ -0,0 +1,73 @@
+//===- LazyFunctionRunner.h - Lazy function passes --------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines runFunctionPassesLazily, which lets tools run a
+// function pipeline, such as llc's code generator, over a module opened with
+// getLazyBitcodeModule, reading each function body only when it is needed.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_BITCODE_LAZYFUNCTIONRUNNER_H
+#define LLVM_BITCODE_LAZYFUNCTIONRUNNER_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include <string>
+
+namespace llvm {
+
+/// \brief Run \p FPM over each function of \p M, materializing the body of
+/// each one just before its passes run.
+///
+/// With a module from getLazyBitcodeModule, only the module-level records
+/// are parsed up front, and bodies are read one at a time.  If
+/// \p Dematerialize is set, each body is dropped again once its passes
+/// have run, so at most one function body is in memory at a time.  That is
+/// only correct for pipelines whose results do not live in the IR, such as
+/// code generation to a file: dematerialized functions look like
+/// declarations to later passes and finalizers.
+///
+/// Dropping a body resets the function to external linkage, so the
+/// linkage, visibility and DLL storage class are restored afterwards; a
+/// dematerialized internal function is then materialized as internal again,
+/// and later passes see the symbol as the module declared it.
+///
+/// \returns true, with \p ErrInfo set, if a body could not be read.
+inline bool runFunctionPassesLazily(Module &M,
+                                    legacy::FunctionPassManager &FPM,
+                                    bool Dematerialize,
+                                    std::string *ErrInfo = nullptr) {
+  FPM.doInitialization();
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    Function &F = *I;
+    bool WasMaterializable = M.isMaterializable(&F);
+    if (WasMaterializable && M.Materialize(&F, ErrInfo))
+      return true;
+    if (F.isDeclaration())
+      continue;
+    FPM.run(F);
+    if (Dematerialize && WasMaterializable) {
+      GlobalValue::LinkageTypes Linkage = F.getLinkage();
+      GlobalValue::VisibilityTypes Visibility = F.getVisibility();
+      GlobalValue::DLLStorageClassTypes DLLStorageClass =
+          F.getDLLStorageClass();
+      M.Dematerialize(&F);
+      F.setLinkage(Linkage);
+      F.setVisibility(Visibility);
+      F.setDLLStorageClass(DLLStorageClass);
+    }
+  }
+  FPM.doFinalization();
+  return false;
+}
+
+} // end namespace llvm
+
+#endif
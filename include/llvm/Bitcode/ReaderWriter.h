@@ -24,6 +24,7 @@ namespace llvm {
   class LLVMContext;
   class Module;
   class ModulePass;
+  class raw_fd_ostream;
   class raw_ostream;
 
   /// Read the header of the specified bitcode buffer and prepare for lazy
@@ -60,6 +61,13 @@ namespace llvm {
   /// should be in "binary" mode.
   void WriteBitcodeToFile(const Module *M, raw_ostream &Out);
 
+  /// WriteBitcodeToFileStreaming - Like WriteBitcodeToFile, but flush each
+  /// completed block to \p Out as the module is written instead of building
+  /// the whole stream in memory first, so peak memory stays flat on large
+  /// modules.  \p Out must be a regular file: block sizes, and the size in
+  /// the Darwin wrapper header, are backpatched through seek.
+  void WriteBitcodeToFileStreaming(const Module *M, raw_fd_ostream &Out);
+
 
   /// isBitcodeWrapper - Return true if the given bytes are the magic bytes
   /// for an LLVM IR bitcode wrapper.
@@ -70,7 +70,21 @@ protected:
   /// (for example, on function calls)
   MachineInstr *EmitStartPt;
 
+  /// Why the last instruction that failed to select was rejected, or null if
+  /// no reason was given.  Set through Fail().
+  const char *FailureReason;
+
 public:
+  /// Return the reason given for the last selection failure, such as
+  /// "varargs call" or "NEON type", so that SelectionDAGISel can count
+  /// fallbacks by reason and instruction kind.  Returns null if the
+  /// selector did not give one.
+  const char *getFailureReason() const { return FailureReason; }
+
+  /// Forget the reason for the last failure, before selecting the next
+  /// instruction.
+  void clearFailureReason() { FailureReason = nullptr; }
+
   /// Return the position of the last instruction emitted for materializing
   /// constants for use in the current block.
   MachineInstr *getLastLocalValue() { return LastLocalValue; }
@@ -166,6 +180,13 @@ protected:
   explicit FastISel(FunctionLoweringInfo &funcInfo,
                     const TargetLibraryInfo *libInfo);
 
+  /// Record Reason as the cause of a selection failure and return false, as
+  /// in "return Fail("struct return");".
+  bool Fail(const char *Reason) {
+    FailureReason = Reason;
+    return false;
+  }
+
   /// This method is called by target-independent code when the normal FastISel
   /// process fails to select an instruction.  This gives targets a chance to
   /// emit code for anything that doesn't fit into FastISel's framework. It
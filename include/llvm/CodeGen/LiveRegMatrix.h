@@ -58,6 +58,12 @@ class LiveRegMatrix : public MachineFunctionPass {
   unsigned RegMaskVirtReg;
   BitVector RegMaskUsable;
 
+  // Budget of interference checks per virtual register, 0 for no limit.
+  // CheckVirtReg is the register whose checks are being counted.
+  unsigned CheckLimit;
+  unsigned CheckVirtReg;
+  unsigned ChecksLeft;
+
   // MachineFunctionPass boilerplate.
   void getAnalysisUsage(AnalysisUsage&) const override;
   bool runOnMachineFunction(MachineFunction&) override;
@@ -105,6 +111,33 @@ public:
   /// with the highest enum value is returned.
   InterferenceKind checkInterference(LiveInterval &VirtReg, unsigned PhysReg);
 
+  /// Limit the number of checkInterferenceWithinBudget() calls made for any
+  /// one virtual register to Limit, or lift the limit if Limit is 0.
+  void setCheckLimit(unsigned Limit) {
+    CheckLimit = Limit;
+    CheckVirtReg = 0;
+  }
+
+  /// Like checkInterference, but once the budget set by setCheckLimit() is
+  /// spent for VirtReg, report IK_RegUnit without looking at the matrix.
+  /// That interference can't be resolved by eviction, so an allocator stops
+  /// trying PhysRegs for VirtReg and moves on to splitting or spilling.
+  /// This bounds the eviction work on functions with thousands of
+  /// interfering virtual registers.
+  InterferenceKind checkInterferenceWithinBudget(LiveInterval &VirtReg,
+                                                 unsigned PhysReg) {
+    if (CheckLimit) {
+      if (VirtReg.reg != CheckVirtReg) {
+        CheckVirtReg = VirtReg.reg;
+        ChecksLeft = CheckLimit;
+      }
+      if (!ChecksLeft)
+        return IK_RegUnit;
+      --ChecksLeft;
+    }
+    return checkInterference(VirtReg, PhysReg);
+  }
+
   /// Assign VirtReg to PhysReg.
   /// This will mark VirtReg's live range as occupied in the LiveRegMatrix and
   /// update VirtRegMap. The live range is expected to be available in PhysReg.
@@ -29,11 +29,11 @@
 #ifndef LLVM_CODEGEN_LIVEVARIABLES_H
 #define LLVM_CODEGEN_LIVEVARIABLES_H
 
+#include "llvm/ADT/CompactSparseBitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IndexedMap.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
-#include "llvm/ADT/SparseBitVector.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/MachineInstr.h"
 #include "llvm/Target/TargetRegisterInfo.h"
@@ -79,9 +79,10 @@ public:
   struct VarInfo {
     /// AliveBlocks - Set of blocks in which this value is alive completely
     /// through.  This is a bit set which uses the basic block number as an
-    /// index.
+    /// index.  There is one per virtual register, so it is kept compact, in
+    /// one array.
     ///
-    SparseBitVector<> AliveBlocks;
+    CompactSparseBitVector<> AliveBlocks;
 
     /// Kills - List of MachineInstruction's which are the last use of this
     /// virtual register (kill it) in their basic block.
@@ -122,7 +123,7 @@ private:
   /// PHIJoins - list of virtual registers that are PHI joins. These registers
   /// may have multiple definitions, and they require special handling when
   /// building live intervals.
-  SparseBitVector<> PHIJoins;
+  CompactSparseBitVector<> PHIJoins;
 
 private:   // Intermediate data structures
   MachineFunction *MF;
@@ -160,6 +160,18 @@ public:
     DT->splitBlock(NewBB);
   }
 
+  /// insertEdge - Update the tree after the edge From -> To has been added
+  /// to the CFG.
+  inline void insertEdge(MachineBasicBlock *From, MachineBasicBlock *To) {
+    DT->insertEdge(From, To);
+  }
+
+  /// deleteEdge - Update the tree after the edge From -> To has been
+  /// removed from the CFG.
+  inline void deleteEdge(MachineBasicBlock *From, MachineBasicBlock *To) {
+    DT->deleteEdge(From, To);
+  }
+
   /// isReachableFromEntry - Return true if A is dominated by the entry
   /// block of the function containing it.
   bool isReachableFromEntry(const MachineBasicBlock *A) {
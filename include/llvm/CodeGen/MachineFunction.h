@@ -456,6 +456,16 @@ public:
     extractStoreMemRefs(MachineInstr::mmo_iterator Begin,
                         MachineInstr::mmo_iterator End);
 
+  /// getAllocatedBytes - Return the number of bytes handed out by the
+  /// allocator that holds this function's instructions, operand arrays,
+  /// memoperands and blocks.  Recycled instructions and operand arrays are
+  /// reused rather than allocated again, so this is a high-water mark.
+  size_t getAllocatedBytes() const { return Allocator.getBytesAllocated(); }
+
+  /// getAllocatorMemory - Return the number of bytes of slab memory the
+  /// allocator has reserved for this function, allocated or not.
+  size_t getAllocatorMemory() const { return Allocator.getTotalMemory(); }
+
   //===--------------------------------------------------------------------===//
   // Label Manipulation.
   //
@@ -0,0 +1,154 @@
+//===-- llvm/CodeGen/MemOpExpansion.h - Planning inline memops --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares MemOpExpansionTuning and planMemOpExpansion, which
+// decide whether a memcpy or memset of a constant size is expanded into
+// vector loads and stores, and into which accesses, for use by a target's
+// TargetSelectionDAGInfo::EmitTargetCodeForMemcpy and friends.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_MEMOPEXPANSION_H
+#define LLVM_CODEGEN_MEMOPEXPANSION_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <cassert>
+
+namespace llvm {
+
+/// MemOpExpansionTuning - The per-CPU limits of the vector expansion of
+/// memory intrinsics.  All sizes are in bytes.
+struct MemOpExpansionTuning {
+  /// The widest vector access, such as 16 for a NEON vld1/vst1 of a Q
+  /// register; 0 disables the vector expansion.  A power of two.
+  unsigned VectorWidth;
+  /// Sizes below this are left to the target's scalar expansion (ldm/stm).
+  unsigned MinVectorSize;
+  /// Sizes above this call the library, unless the expansion must be
+  /// inline.
+  unsigned MaxInlineSize;
+  /// The least known destination alignment for the vector expansion, for
+  /// CPUs whose unaligned vector stores are slow; 1 allows any.
+  unsigned MinVectorAlign;
+  /// Whether the last vector access may overlap the previous one instead of
+  /// finishing with narrower accesses.  Not valid for memmove.
+  bool OverlappingTail;
+
+  MemOpExpansionTuning()
+    : VectorWidth(0), MinVectorSize(0), MaxInlineSize(0), MinVectorAlign(1),
+      OverlappingTail(false) {}
+  MemOpExpansionTuning(unsigned VectorWidth, unsigned MinVectorSize,
+                       unsigned MaxInlineSize, unsigned MinVectorAlign,
+                       bool OverlappingTail)
+    : VectorWidth(VectorWidth), MinVectorSize(MinVectorSize),
+      MaxInlineSize(MaxInlineSize), MinVectorAlign(MinVectorAlign),
+      OverlappingTail(OverlappingTail) {
+    assert((VectorWidth == 0 || isPowerOf2_32(VectorWidth)) &&
+           "Vector width must be a power of two");
+  }
+
+  /// The NEON tuning of the ARMv7 CPU \p CPU.  These are starting points to
+  /// be checked against the library on the device; unknown CPUs get no
+  /// vector expansion.
+  static MemOpExpansionTuning getNEON(StringRef CPU) {
+    return StringSwitch<MemOpExpansionTuning>(CPU)
+        .Case("swift", MemOpExpansionTuning(16, 32, 256, 1, true))
+        .Cases("cortex-a15", "krait",
+               MemOpExpansionTuning(16, 32, 192, 1, true))
+        .Cases("cortex-a8", "cortex-a9",
+               MemOpExpansionTuning(16, 64, 128, 8, false))
+        .Default(MemOpExpansionTuning());
+  }
+};
+
+/// MemOpAccess - One load and store, or one store for memset, of an
+/// expansion.
+struct MemOpAccess {
+  uint64_t Offset;
+  unsigned Size;
+  /// The alignment known for the destination and source at Offset.
+  unsigned DstAlign, SrcAlign;
+  bool IsVector;
+};
+
+enum MemOpExpansionKind {
+  /// Leave the operation to the target's default lowering.
+  MOEK_Default,
+  /// Expand into the planned accesses.
+  MOEK_Inline,
+  /// Call the library function.
+  MOEK_Libcall
+};
+
+/// planMemOpExpansion - Decide how to lower a memory operation of \p Size
+/// bytes whose destination and source are aligned to \p DstAlign and
+/// \p SrcAlign (pass DstAlign again for memset), and if it is to be
+/// expanded inline, append its accesses to \p Accesses in address order.
+///
+/// The expansion is full vector accesses followed by either one overlapping
+/// vector access or narrower accesses for the remainder.  Each access records
+/// the alignment known at its offset, for the alignment hint of vld1/vst1,
+/// so that aligned operations get the :64 and :128 forms and others the
+/// unaligned vld1.8 and vst1.8.
+inline MemOpExpansionKind
+planMemOpExpansion(uint64_t Size, unsigned DstAlign, unsigned SrcAlign,
+                   bool AlwaysInline, const MemOpExpansionTuning &T,
+                   SmallVectorImpl<MemOpAccess> &Accesses) {
+  if (!T.VectorWidth || Size < T.MinVectorSize || Size < T.VectorWidth ||
+      DstAlign < T.MinVectorAlign)
+    return MOEK_Default;
+  if (Size > T.MaxInlineSize && !AlwaysInline)
+    return MOEK_Libcall;
+
+  uint64_t Offset = 0;
+  DstAlign = std::max(DstAlign, 1u);
+  SrcAlign = std::max(SrcAlign, 1u);
+  for (; Offset + T.VectorWidth <= Size; Offset += T.VectorWidth) {
+    MemOpAccess A = { Offset, T.VectorWidth,
+                      unsigned(MinAlign(DstAlign, Offset)),
+                      unsigned(MinAlign(SrcAlign, Offset)), true };
+    Accesses.push_back(A);
+  }
+
+  if (Offset == Size)
+    return MOEK_Inline;
+  if (T.OverlappingTail) {
+    uint64_t Last = Size - T.VectorWidth;
+    MemOpAccess A = { Last, T.VectorWidth, unsigned(MinAlign(DstAlign, Last)),
+                      unsigned(MinAlign(SrcAlign, Last)), true };
+    Accesses.push_back(A);
+    return MOEK_Inline;
+  }
+  for (unsigned Width = T.VectorWidth / 2; Offset != Size && Width;
+       Width /= 2) {
+    if (Offset + Width > Size)
+      continue;
+    MemOpAccess A = { Offset, Width, unsigned(MinAlign(DstAlign, Offset)),
+                      unsigned(MinAlign(SrcAlign, Offset)), Width >= 8 };
+    Accesses.push_back(A);
+    Offset += Width;
+  }
+  // Halving a width that is not a power of two does not cover every tail;
+  // finish such a tail a byte at a time.
+  for (; Offset != Size; ++Offset) {
+    MemOpAccess A = { Offset, 1, unsigned(MinAlign(DstAlign, Offset)),
+                      unsigned(MinAlign(SrcAlign, Offset)), false };
+    Accesses.push_back(A);
+  }
+  return MOEK_Inline;
+}
+
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,437 @@
+//===--- ParallelCG.h - Parallel code generation ----------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the splitCodeGen function, which splits a module into
+// partitions and generates code for them on the shared thread pool, each
+// with its own LLVMContext and TargetMachine.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PARALLELCG_H
+#define LLVM_CODEGEN_PARALLELCG_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+namespace parallel_cg {
+
+/// A suffix for the local globals of \p M that are promoted for the split,
+/// so that their names differ from those promoted in other modules.
+///
+/// It is a hash of the module identifier and of the names of the module's
+/// external definitions; two modules only get the same suffix if they define
+/// the same external symbols, and then they could not be linked together
+/// anyway.
+inline std::string getPromotionSuffix(const Module &M) {
+  MD5 Hash;
+  Hash.update(M.getModuleIdentifier());
+  for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+    if (!I->isDeclaration() && !I->hasLocalLinkage()) {
+      Hash.update(ArrayRef<uint8_t>((const uint8_t *)"", 1));
+      Hash.update(I->getName());
+    }
+  for (Module::const_global_iterator I = M.global_begin(),
+                                     E = M.global_end();
+       I != E; ++I)
+    if (!I->isDeclaration() && !I->hasLocalLinkage()) {
+      Hash.update(ArrayRef<uint8_t>((const uint8_t *)"", 1));
+      Hash.update(I->getName());
+    }
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  MD5::stringifyResult(Result, Str);
+  return ".llvm." + Str.substr(0, 16).str();
+}
+
+/// Make every global that another partition may refer to visible across
+/// partitions, without changing what the final link sees.
+///
+/// Local symbols become hidden external symbols, so the linked image still
+/// keeps them private.  Their names get the suffix of getPromotionSuffix, so
+/// that two modules with a static of the same name can still be linked
+/// together.  Linkonce definitions become weak, so the partition that owns
+/// them emits them even when it does not use them itself.
+inline void externalizeForSplit(Module &M) {
+  unsigned NextID = 0;
+  std::string Suffix = getPromotionSuffix(M);
+  SmallVector<GlobalValue *, 64> Globals;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
+    Globals.push_back(I);
+  for (Module::global_iterator I = M.global_begin(), E = M.global_end();
+       I != E; ++I)
+    Globals.push_back(I);
+  for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end(); I != E;
+       ++I)
+    Globals.push_back(I);
+
+  for (unsigned i = 0, e = Globals.size(); i != e; ++i) {
+    GlobalValue *GV = Globals[i];
+    if (GV->isDeclaration() || GV->hasAppendingLinkage())
+      continue;
+    if (GV->hasLocalLinkage()) {
+      // Local names are only unique within the module; give unnamed globals
+      // a name so they can be referred to at all.
+      if (GV->hasName())
+        GV->setName(GV->getName() + Suffix);
+      else
+        GV->setName("__llvm_split_" + utostr(NextID++) + Suffix);
+      GV->setLinkage(GlobalValue::ExternalLinkage);
+      GV->setVisibility(GlobalValue::HiddenVisibility);
+    } else if (GV->hasLinkOnceLinkage()) {
+      GV->setLinkage(GlobalValue::getWeakLinkage(
+          GV->getLinkage() == GlobalValue::LinkOnceODRLinkage));
+    }
+  }
+}
+
+/// Assign each defined global object of \p M to one of \p NumPartitions
+/// partitions, balancing the number of instructions per partition, or, if
+/// \p ByName is true, by a hash of its name so that the assignment of each
+/// global does not depend on the rest of the module.
+///
+/// Aliases and the globals they alias stay in partition 0, since an alias
+/// cannot refer to a declaration.  Globals with appending linkage
+/// (llvm.global_ctors and friends) are also emitted by partition 0 only.
+inline void assignPartitions(Module &M, unsigned NumPartitions,
+                             DenseMap<const GlobalValue *, unsigned> &Owner,
+                             bool ByName = false) {
+  SmallPtrSet<const GlobalValue *, 16> Pinned;
+  for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end(); I != E;
+       ++I) {
+    Pinned.insert(I);
+    if (const GlobalValue *Aliasee = I->getAliasedGlobal())
+      Pinned.insert(Aliasee);
+  }
+
+  std::vector<std::pair<unsigned, const GlobalValue *> > BySize;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    if (I->isDeclaration())
+      continue;
+    unsigned Size = 0;
+    for (Function::const_iterator BB = I->begin(), BE = I->end(); BB != BE;
+         ++BB)
+      Size += BB->size();
+    BySize.push_back(std::make_pair(Size, (const GlobalValue *)I));
+  }
+  for (Module::global_iterator I = M.global_begin(), E = M.global_end();
+       I != E; ++I)
+    if (!I->isDeclaration())
+      BySize.push_back(std::make_pair(1U, (const GlobalValue *)I));
+
+  // Largest first, with ties broken by name, so the assignment does not
+  // depend on pointer values and the output is reproducible.
+  struct Larger {
+    bool operator()(const std::pair<unsigned, const GlobalValue *> &A,
+                    const std::pair<unsigned, const GlobalValue *> &B) const {
+      if (A.first != B.first)
+        return A.first > B.first;
+      return A.second->getName() < B.second->getName();
+    }
+  };
+  std::sort(BySize.begin(), BySize.end(), Larger());
+
+  std::vector<uint64_t> Load(NumPartitions);
+  for (unsigned i = 0, e = BySize.size(); i != e; ++i) {
+    const GlobalValue *GV = BySize[i].second;
+    unsigned P;
+    if (Pinned.count(GV) || GV->hasAppendingLinkage())
+      P = 0;
+    else if (ByName)
+      P = HashString(GV->getName()) % NumPartitions;
+    else
+      P = std::min_element(Load.begin(), Load.end()) - Load.begin();
+    Owner[GV] = P;
+    Load[P] += BySize[i].first;
+  }
+}
+
+/// Whether the module flag \p Key is turned into data of its own in the
+/// output, such as the Objective-C image info or the linker options.
+inline bool isModuleDataFlag(StringRef Key) {
+  return Key.startswith("Objective-C") || Key == "Linker Options";
+}
+
+/// Turn \p Clone, a copy of the split module, into partition \p Partition by
+/// replacing every definition owned by another partition with a declaration.
+///
+/// Module-level data, such as the module inline assembly, the identification
+/// and the data that module flags turn into, is left to partition 0.
+inline void
+extractPartition(Module &Clone, const Module &M, unsigned Partition,
+                 const DenseMap<const GlobalValue *, unsigned> &Owner) {
+  for (Module::iterator I = Clone.begin(), E = Clone.end(); I != E; ++I) {
+    if (I->isDeclaration())
+      continue;
+    const GlobalValue *Orig = M.getNamedValue(I->getName());
+    DenseMap<const GlobalValue *, unsigned>::const_iterator Pos =
+        Owner.find(Orig);
+    if (Pos != Owner.end() && Pos->second != Partition) {
+      I->deleteBody();
+      I->setVisibility(Orig->getVisibility());
+    }
+  }
+
+  for (Module::global_iterator I = Clone.global_begin(),
+                               E = Clone.global_end(); I != E;) {
+    GlobalVariable *GV = I++;
+    if (GV->isDeclaration())
+      continue;
+    if (GV->hasAppendingLinkage()) {
+      if (Partition != 0)
+        GV->eraseFromParent();
+      continue;
+    }
+    DenseMap<const GlobalValue *, unsigned>::const_iterator Pos =
+        Owner.find(M.getNamedValue(GV->getName()));
+    if (Pos != Owner.end() && Pos->second != Partition) {
+      GV->setInitializer(nullptr);
+      GV->setLinkage(GlobalValue::ExternalLinkage);
+    }
+  }
+
+  if (Partition != 0) {
+    for (Module::alias_iterator I = Clone.alias_begin(),
+                                E = Clone.alias_end(); I != E;) {
+      GlobalAlias *GA = I++;
+      PointerType *Ty = GA->getType();
+      GlobalValue *Decl;
+      if (FunctionType *FTy = dyn_cast<FunctionType>(Ty->getElementType()))
+        Decl = Function::Create(FTy, GlobalValue::ExternalLinkage, "", &Clone);
+      else
+        Decl = new GlobalVariable(Clone, Ty->getElementType(),
+                                  /*isConstant=*/false,
+                                  GlobalValue::ExternalLinkage, nullptr, "",
+                                  nullptr, GlobalVariable::NotThreadLocal,
+                                  Ty->getAddressSpace());
+      Decl->setVisibility(GA->getVisibility());
+      GA->replaceAllUsesWith(Decl);
+      Decl->takeName(GA);
+      GA->eraseFromParent();
+    }
+  }
+
+  if (Partition != 0) {
+    Clone.setModuleInlineAsm("");
+    if (NamedMDNode *Ident = Clone.getNamedMetadata("llvm.ident"))
+      Ident->eraseFromParent();
+    if (NamedMDNode *Flags = Clone.getModuleFlagsMetadata()) {
+      SmallVector<MDNode *, 8> Kept;
+      for (unsigned i = 0, e = Flags->getNumOperands(); i != e; ++i) {
+        MDNode *Flag = Flags->getOperand(i);
+        MDString *Key = Flag->getNumOperands() > 1
+                            ? dyn_cast<MDString>(Flag->getOperand(1))
+                            : nullptr;
+        if (!Key || !isModuleDataFlag(Key->getString()))
+          Kept.push_back(Flag);
+      }
+      Flags->eraseFromParent();
+      for (unsigned i = 0, e = Kept.size(); i != e; ++i)
+        Clone.addModuleFlag(Kept[i]);
+    }
+  }
+
+  // Drop the declarations nothing in this partition refers to, so that the
+  // partition (and its bitcode) only depends on what it actually uses.
+  for (Module::iterator I = Clone.begin(), E = Clone.end(); I != E;) {
+    Function *F = I++;
+    if (F->isDeclaration() && F->use_empty())
+      F->eraseFromParent();
+  }
+  for (Module::global_iterator I = Clone.global_begin(),
+                               E = Clone.global_end(); I != E;) {
+    GlobalVariable *GV = I++;
+    if (GV->isDeclaration() && GV->use_empty())
+      GV->eraseFromParent();
+  }
+}
+
+/// Generate code for one partition, read back from \p Bitcode into a fresh
+/// context, with a new target machine configured like \p TM.
+inline bool codeGenPartition(StringRef Bitcode, const TargetMachine &TM,
+                             TargetMachine::CodeGenFileType FileType,
+                             raw_ostream &OS, std::string &ErrMsg) {
+  LLVMContext Context;
+  std::unique_ptr<MemoryBuffer> Buffer(MemoryBuffer::getMemBuffer(
+      Bitcode, "<split-module>", /*RequiresNullTerminator=*/false));
+  ErrorOr<Module *> ModuleOrErr = parseBitcodeFile(Buffer.get(), Context);
+  if (error_code EC = ModuleOrErr.getError()) {
+    ErrMsg = EC.message();
+    return false;
+  }
+  std::unique_ptr<Module> M(ModuleOrErr.get());
+
+  std::unique_ptr<TargetMachine> PartTM(TM.getTarget().createTargetMachine(
+      TM.getTargetTriple(), TM.getTargetCPU(), TM.getTargetFeatureString(),
+      TM.Options, TM.getRelocationModel(), TM.getCodeModel(),
+      TM.getOptLevel()));
+  if (!PartTM) {
+    ErrMsg = "could not create a target machine for " +
+             TM.getTargetTriple().str();
+    return false;
+  }
+
+  PassManager PM;
+  PM.add(new DataLayoutPass(M.get()));
+  formatted_raw_ostream FOS(OS);
+  if (PartTM->addPassesToEmitFile(PM, FOS, FileType)) {
+    ErrMsg = "target file type not supported";
+    return false;
+  }
+  PM.run(*M);
+  return true;
+}
+
+} // end namespace parallel_cg
+
+/// SplitCodeGenCache - An optional store of the objects generated for
+/// partitions, keyed by the partition bitcode, which lets splitCodeGen skip
+/// code generation for partitions that did not change.
+///
+/// Both methods are only ever called on the thread that called splitCodeGen.
+class SplitCodeGenCache {
+public:
+  virtual ~SplitCodeGenCache() {}
+
+  /// lookup - If an object was stored for the partition \p Bitcode, write it
+  /// to \p OS and return true.
+  virtual bool lookup(StringRef Bitcode, raw_ostream &OS) = 0;
+
+  /// store - Remember \p Object as the result of code generating the
+  /// partition \p Bitcode.
+  virtual void store(StringRef Bitcode, StringRef Object) = 0;
+};
+
+/// splitCodeGen - Generate code for \p M into one output per element of
+/// \p OSs, splitting it into that many partitions.
+///
+/// Each partition is a copy of \p M in which the definitions owned by other
+/// partitions are turned into declarations; it is serialized to bitcode and
+/// read back into its own LLVMContext, so the partitions can be code
+/// generated concurrently with their own target machine, configured like
+/// \p TM.  \p M is modified so that its globals are visible across
+/// partitions; see \c parallel_cg::externalizeForSplit.
+///
+/// If \p Cache is non-null, partitions are assigned by a hash of their
+/// names rather than by size, so that a change to one function does not move
+/// every other function to a different partition, and the objects of
+/// unchanged partitions are taken from the cache.  Otherwise, with a single
+/// output stream, \p M is code generated directly with \p TM.
+///
+/// \returns true on success; on failure \p ErrMsg describes the first failing
+/// partition.
+inline bool splitCodeGen(Module &M, ArrayRef<raw_ostream *> OSs,
+                         TargetMachine &TM,
+                         TargetMachine::CodeGenFileType FileType,
+                         std::string &ErrMsg,
+                         SplitCodeGenCache *Cache = nullptr) {
+  if (OSs.size() == 1 && !Cache) {
+    PassManager PM;
+    PM.add(new DataLayoutPass(&M));
+    formatted_raw_ostream FOS(*OSs[0]);
+    if (TM.addPassesToEmitFile(PM, FOS, FileType)) {
+      ErrMsg = "target file type not supported";
+      return false;
+    }
+    PM.run(M);
+    return true;
+  }
+
+  DenseMap<const GlobalValue *, unsigned> Owner;
+  if (OSs.size() != 1) {
+    parallel_cg::externalizeForSplit(M);
+    parallel_cg::assignPartitions(M, OSs.size(), Owner,
+                                  /*ByName=*/Cache != nullptr);
+  }
+
+  // Cloning and serializing touch the context of M, so they happen up front
+  // on this thread; only the per-partition code generation runs in parallel.
+  unsigned N = OSs.size();
+  std::vector<SmallString<0> > Bitcode(N);
+  for (unsigned i = 0; i != N; ++i) {
+    std::unique_ptr<Module> Clone(CloneModule(&M));
+    parallel_cg::extractPartition(*Clone, M, i, Owner);
+    raw_svector_ostream BCOS(Bitcode[i]);
+    WriteBitcodeToFile(Clone.get(), BCOS);
+  }
+
+  // With a cache, partitions are generated into memory so that they can be
+  // stored once they are complete.
+  std::vector<char> Pending(N, true);
+  std::vector<SmallString<0> > Objects(Cache ? N : 0);
+  std::vector<std::unique_ptr<raw_ostream> > ObjectOSs(N);
+  for (unsigned i = 0; i != N; ++i) {
+    if (Cache && Cache->lookup(Bitcode[i], *OSs[i]))
+      Pending[i] = false;
+    else if (Cache)
+      ObjectOSs[i].reset(new raw_svector_ostream(Objects[i]));
+  }
+
+  std::vector<std::string> Errors(N);
+  std::vector<char> Succeeded(N, true);
+  auto CodeGen = [&](unsigned i) {
+    raw_ostream &OS = ObjectOSs[i] ? *ObjectOSs[i] : *OSs[i];
+    Succeeded[i] = parallel_cg::codeGenPartition(Bitcode[i], TM, FileType, OS,
+                                                 Errors[i]);
+    OS.flush();
+  };
+  llvm_start_multithreaded();
+  {
+    TaskGroup Group;
+    for (unsigned i = 0; i != N; ++i)
+      if (Pending[i])
+        Group.spawn([&CodeGen, i] { CodeGen(i); });
+  }
+
+  for (unsigned i = 0; i != N; ++i) {
+    if (!Succeeded[i]) {
+      ErrMsg = "partition " + utostr(i) + ": " + Errors[i];
+      return false;
+    }
+    if (Cache && Pending[i]) {
+      *OSs[i] << Objects[i];
+      Cache->store(Bitcode[i], Objects[i]);
+    }
+  }
+  return true;
+}
+
+} // end namespace llvm
+
+#endif
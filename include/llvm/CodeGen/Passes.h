@@ -22,6 +22,7 @@
 namespace llvm {
 
 class FunctionPass;
+class ModulePass;
 class MachineFunctionPass;
 class PassConfigImpl;
 class PassInfo;
@@ -587,6 +588,27 @@ namespace llvm {
   /// the intrinsic for later emission to the StackMap.
   extern char &StackMapLivenessID;
 
+  /// createMachineOutlinerPass - This pass finds instruction sequences that
+  /// repeat after register allocation and replaces them with calls to a
+  /// single copy; it is meant for -Os and -Oz.  The MachineFunctions of a
+  /// module are not all alive at once, so it is a MachineFunctionPass that
+  /// runs just before emission: it adds the sequences of each function to a
+  /// suffix tree kept for the whole module, and replaces those already seen
+  /// often enough that the bytes saved exceed the call and return overhead.
+  ///
+  FunctionPass *createMachineOutlinerPass();
+
+  /// createMachineOutlinedFunctionEmitterPass - This pass emits the copies
+  /// of the sequences that the machine outliner replaced, once the last
+  /// function of the module has been emitted.  The copies are internal,
+  /// not private: with .subsections_via_symbols a private label does not
+  /// start an atom, so ld64 would treat a copy as part of the function that
+  /// precedes it and dead-strip it with that function.  As internal symbols
+  /// they are atoms of their own, which ld64 keeps as long as one of the
+  /// calls to them is kept.
+  ///
+  ModulePass *createMachineOutlinedFunctionEmitterPass();
+
 } // End llvm namespace
 
 #endif
@@ -193,6 +193,13 @@ class SelectionDAG {
 
   /// CSEMap - This structure is used to memoize nodes, automatically performing
   /// CSE with existing nodes when a duplicate is requested.
+  ///
+  /// clear() empties the buckets but keeps them, so after the first large
+  /// block of a function the table no longer rehashes as nodes are added.
+  /// Lookups hash the opcode, value types and operands that SDNode profiles;
+  /// a separate map keyed on the same fields would need the same hashing
+  /// and would have to be kept in sync with every node that is morphed or
+  /// has its operands updated in place.
   FoldingSet<SDNode> CSEMap;
 
   /// OperandAllocator - Pool allocation for machine-opcode SDNode operands.
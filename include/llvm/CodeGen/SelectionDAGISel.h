@@ -279,6 +279,11 @@ private:
 
   /// OpcodeOffset - This is a cache used to dispatch efficiently into isel
   /// state machines that start with a OPC_SwitchOpcode node.
+  ///
+  /// It is filled in the first time a node is matched, by walking the cases
+  /// of the root switch once, so every later match starts at its opcode's
+  /// case in constant time.  Nested OPC_SwitchOpcode and OPC_SwitchType
+  /// nodes are still scanned linearly, but they have few cases.
   std::vector<unsigned> OpcodeOffset;
 
   void UpdateChainsAndGlue(SDNode *NodeToMatch, SDValue InputChain,
@@ -665,10 +665,16 @@ namespace llvm {
       assert(unsigned(mbb->getNumber()) == MBBRanges.size() &&
              "Blocks must be added in order");
       MBBRanges.push_back(std::make_pair(startIdx, endIdx));
-      idx2MBBMap.push_back(IdxMBBPair(startIdx, mbb));
 
       renumberIndexes(newItr);
-      std::sort(idx2MBBMap.begin(), idx2MBBMap.end(), Idx2MBBCompare());
+
+      // idx2MBBMap is sorted, and renumbering keeps the order of existing
+      // indexes, so the new block only needs to be inserted in place once
+      // its start has a number, rather than re-sorting the whole map.
+      IdxMBBPair NewPair(startIdx, mbb);
+      idx2MBBMap.insert(std::upper_bound(idx2MBBMap.begin(), idx2MBBMap.end(),
+                                         NewPair, Idx2MBBCompare()),
+                        NewPair);
     }
 
     /// \brief Free the resources that were required to maintain a SlotIndex.
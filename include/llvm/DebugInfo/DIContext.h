@@ -127,6 +127,13 @@ enum DIDumpType {
 // entire size of the debug info sections.
 typedef DenseMap<uint64_t, std::pair<uint8_t, int64_t> > RelocAddrMap;
 
+/// DIContext - Read-only access to the debug info of one object file.
+///
+/// A context parses the units and tables of its object lazily and caches
+/// them as they are queried, so it must not be used from several threads at
+/// once.  Tools that process many objects in parallel, such as a dsymutil
+/// linking the debug info of an executable, use one context per object
+/// file, each on one thread.
 class DIContext {
 public:
   enum DIContextKind {
@@ -142,6 +149,12 @@ public:
 
   virtual void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All) = 0;
 
+  /// getLineInfoForAddress - Return the source location of \p Address.
+  ///
+  /// The first query that falls in a compile unit parses its line table;
+  /// later queries in that unit binary-search the parsed rows.  Symbolizers
+  /// should therefore keep a context per object for as long as they serve
+  /// queries rather than creating one per batch.
   virtual DILineInfo getLineInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) = 0;
   virtual DILineInfoTable getLineInfoForAddressRange(uint64_t Address,
@@ -493,6 +493,12 @@ public:
   /// stub, and 2) any thread modifying LLVM IR must hold the JIT's lock
   /// (ExecutionEngine::lock) or otherwise ensure that no other thread calls a
   /// lazy stub.  See http://llvm.org/PR5184 for details.
+  ///
+  /// MCJIT ignores this setting: it compiles whole modules, and defers each
+  /// module added with addModule until one of its symbols is looked up or
+  /// finalizeObject is called.  Clients that want MCJIT to start quickly put
+  /// functions, or groups of functions that call each other, in modules of
+  /// their own.
   void DisableLazyCompilation(bool Disabled = true) {
     CompilingLazily = !Disabled;
   }
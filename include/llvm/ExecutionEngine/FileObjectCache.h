@@ -0,0 +1,112 @@
+//===--- FileObjectCache.h - On-disk object cache for MCJIT -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines FileObjectCache, an ObjectCache that keeps the objects
+// MCJIT compiles in a directory so that later runs can load them instead of
+// compiling the same modules again.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_FILEOBJECTCACHE_H
+#define LLVM_EXECUTIONENGINE_FILEOBJECTCACHE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+
+namespace llvm {
+
+/// FileObjectCache - An ObjectCache that stores each object in a directory,
+/// named after a hash of the module's bitcode and of a key describing the
+/// code generation options.
+///
+/// The bitcode covers the module's code, target triple and data layout;
+/// the options key must cover everything else that changes the generated
+/// code, such as the CPU, the target features, the optimization level and
+/// the relocation model.  Objects are written to a temporary file and
+/// renamed into place, so concurrent processes sharing a directory never
+/// see a partial object.  Failures to read or write the cache are ignored:
+/// the module is then simply compiled.
+///
+/// Code generation changes the module, so the path is computed once, when
+/// MCJIT asks for the object before compiling, and remembered until the
+/// compiled object is stored.  Cached objects are copied into memory rather
+/// than left mapped, so that other processes can replace them.
+class FileObjectCache : public ObjectCache {
+  std::string CacheDir;
+  std::string OptionsKey;
+
+  /// The paths computed by getObject for the modules being compiled.
+  DenseMap<const Module *, std::string> PendingPaths;
+
+  /// getCachePath - Compute the path of the object for \p M.
+  void getCachePath(const Module *M, SmallVectorImpl<char> &Path) const {
+    SmallString<4096> Bitcode;
+    {
+      raw_svector_ostream OS(Bitcode);
+      WriteBitcodeToFile(M, OS);
+    }
+    MD5 Hash;
+    Hash.update(Bitcode.str());
+    Hash.update(OptionsKey);
+    MD5::MD5Result Result;
+    Hash.final(Result);
+    SmallString<32> HashStr;
+    MD5::stringifyResult(Result, HashStr);
+
+    Path.clear();
+    Path.append(CacheDir.begin(), CacheDir.end());
+    sys::path::append(Path, HashStr.str() + ".o");
+  }
+
+public:
+  /// Create a cache in \p Dir, which is created if needed, for objects
+  /// generated with the options described by \p OptionsKey.
+  FileObjectCache(StringRef Dir, StringRef OptionsKey)
+    : CacheDir(Dir), OptionsKey(OptionsKey) {}
+
+  void notifyObjectCompiled(const Module *M, const MemoryBuffer *Obj) override {
+    // Without the path from before code generation there is no key that the
+    // next getObject for the same module would compute.
+    DenseMap<const Module *, std::string>::iterator Pending =
+        PendingPaths.find(M);
+    if (Pending == PendingPaths.end())
+      return;
+    SmallString<128> Path(Pending->second);
+    PendingPaths.erase(Pending);
+    writeFileAtomically(Path.str(), Obj->getBuffer());
+  }
+
+  MemoryBuffer *getObject(const Module *M) override {
+    SmallString<128> Path;
+    getCachePath(M, Path);
+    std::unique_ptr<MemoryBuffer> Obj;
+    if (MemoryBuffer::getFile(Path.str(), Obj, -1, false)) {
+      PendingPaths[M] = Path.str();
+      return nullptr;
+    }
+    PendingPaths.erase(M);
+    return MemoryBuffer::getMemBufferCopy(Obj->getBuffer(),
+                                          Obj->getBufferIdentifier());
+  }
+};
+
+} // end namespace llvm
+
+#endif
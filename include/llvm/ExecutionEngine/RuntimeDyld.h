@@ -67,6 +67,12 @@ public:
   uint64_t getSymbolLoadAddress(StringRef Name);
 
   /// Resolve the relocations for all symbols we currently know about.
+  ///
+  /// Relocations are recorded per symbol, and external symbols are looked
+  /// up once each before the relocations against them are applied, so the
+  /// cost is dominated by applying the relocations, not by symbol lookup.
+  /// Those writes are not independent across sections: relocations in
+  /// different sections can patch the same stub or GOT entry.
   void resolveRelocations();
 
   /// Map a section to its target address space value.
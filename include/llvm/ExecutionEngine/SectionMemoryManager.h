@@ -40,7 +40,17 @@ class SectionMemoryManager : public RTDyldMemoryManager {
   void operator=(const SectionMemoryManager&) LLVM_DELETED_FUNCTION;
 
 public:
-  SectionMemoryManager() { }
+  SectionMemoryManager() : SlabSize(0) { }
+
+  /// \brief Create a memory manager that maps memory for each group in slabs
+  /// of at least \p SlabSize bytes and carves sections out of them.
+  ///
+  /// When many small modules are loaded, this replaces a mapping per
+  /// section with a mapping per slab; finalizeMemory still changes the
+  /// permissions of each group's blocks in one pass.  A slab size of 0 maps
+  /// just the pages each section needs.
+  explicit SectionMemoryManager(uintptr_t SlabSize) : SlabSize(SlabSize) { }
+
   virtual ~SectionMemoryManager();
 
   /// \brief Allocates a memory block of (at least) the given size suitable for
@@ -99,6 +109,9 @@ private:
   MemoryGroup CodeMem;
   MemoryGroup RWDataMem;
   MemoryGroup RODataMem;
+
+  /// The minimum number of bytes to map at a time for a group.
+  uintptr_t SlabSize;
 };
 
 }
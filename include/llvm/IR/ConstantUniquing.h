@@ -0,0 +1,159 @@
+//===- llvm/IR/ConstantUniquing.h - Keys for uniquing constants -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the keys by which LLVMContext uniques aggregate constants
+// and constant expressions, and the hash tables that use them.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_CONSTANTUNIQUING_H
+#define LLVM_IR_CONSTANTUNIQUING_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/UniqueNodeSet.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace llvm {
+
+/// ConstantAggrKey - The type and elements of a ConstantArray,
+/// ConstantStruct or ConstantVector, with their hash.
+///
+/// The std::map the context used before compared keys element by element at
+/// every level of the tree and stored a copy of the element vector next to
+/// each constant, which for the long arrays of Objective-C metadata (method
+/// and ivar lists) cost more than the constants themselves.  This key only
+/// refers to the elements, and the hash, computed once over the element
+/// pointers, lets most comparisons stop at the hash.
+template <typename TypeClass>
+struct ConstantAggrKey {
+  TypeClass *Ty;
+  ArrayRef<Constant *> Operands;
+  unsigned Hash;
+
+  ConstantAggrKey(TypeClass *Ty, ArrayRef<Constant *> Operands)
+    : Ty(Ty), Operands(Operands),
+      Hash(hash_combine(Ty, hash_combine_range(Operands.begin(),
+                                               Operands.end()))) {}
+};
+
+/// Uniquing information for the aggregate constant class \p ConstantClass
+/// whose type is a \p TypeClass.
+template <typename ConstantClass, typename TypeClass>
+struct ConstantAggrUniquingInfo {
+  typedef ConstantAggrKey<TypeClass> KeyT;
+
+  static unsigned getHashValue(const KeyT &Key) { return Key.Hash; }
+
+  static bool isEqual(const KeyT &Key, const ConstantClass *C) {
+    if (C->getType() != Key.Ty || C->getNumOperands() != Key.Operands.size())
+      return false;
+    for (unsigned I = 0, E = Key.Operands.size(); I != E; ++I)
+      if (C->getOperand(I) != Key.Operands[I])
+        return false;
+    return true;
+  }
+
+  /// The hash of the key of \p C, for RemoveNode.
+  static unsigned getNodeHash(const ConstantClass *C) {
+    SmallVector<Constant *, 8> Operands;
+    for (unsigned I = 0, E = C->getNumOperands(); I != E; ++I)
+      Operands.push_back(cast<Constant>(C->getOperand(I)));
+    return KeyT(C->getType(), Operands).Hash;
+  }
+};
+
+/// ConstantExprUniqueKey - Everything that identifies a ConstantExpr: its
+/// opcode, flags, predicate or indices, type and operands, with their hash.
+struct ConstantExprUniqueKey {
+  Type *Ty;
+  unsigned Opcode;
+  unsigned SubclassOptionalData;
+  unsigned Predicate;
+  ArrayRef<unsigned> Indices;
+  ArrayRef<Constant *> Operands;
+  unsigned Hash;
+
+  ConstantExprUniqueKey(Type *Ty, unsigned Opcode,
+                        ArrayRef<Constant *> Operands,
+                        unsigned SubclassOptionalData = 0,
+                        unsigned Predicate = 0,
+                        ArrayRef<unsigned> Indices = None)
+    : Ty(Ty), Opcode(Opcode), SubclassOptionalData(SubclassOptionalData),
+      Predicate(Predicate), Indices(Indices), Operands(Operands),
+      Hash(hash_combine(Ty, Opcode, SubclassOptionalData, Predicate,
+                        hash_combine_range(Indices.begin(), Indices.end()),
+                        hash_combine_range(Operands.begin(),
+                                           Operands.end()))) {}
+};
+
+/// Uniquing information for constant expressions.
+struct ConstantExprUniquingInfo {
+  typedef ConstantExprUniqueKey KeyT;
+
+  static unsigned getHashValue(const KeyT &Key) { return Key.Hash; }
+
+  static bool isEqual(const KeyT &Key, const ConstantExpr *CE) {
+    if (CE->getType() != Key.Ty || CE->getOpcode() != Key.Opcode ||
+        CE->getRawSubclassOptionalData() != Key.SubclassOptionalData ||
+        CE->getNumOperands() != Key.Operands.size())
+      return false;
+    if (CE->isCompare() && CE->getPredicate() != Key.Predicate)
+      return false;
+    if (CE->hasIndices() ? CE->getIndices() != Key.Indices
+                         : !Key.Indices.empty())
+      return false;
+    for (unsigned I = 0, E = Key.Operands.size(); I != E; ++I)
+      if (CE->getOperand(I) != Key.Operands[I])
+        return false;
+    return true;
+  }
+
+  /// The hash of the key of \p CE, for RemoveNode.
+  static unsigned getNodeHash(const ConstantExpr *CE) {
+    SmallVector<Constant *, 8> Operands;
+    for (unsigned I = 0, E = CE->getNumOperands(); I != E; ++I)
+      Operands.push_back(cast<Constant>(CE->getOperand(I)));
+    return KeyT(CE->getType(), CE->getOpcode(), Operands,
+                CE->getRawSubclassOptionalData(),
+                CE->isCompare() ? CE->getPredicate() : 0,
+                CE->hasIndices() ? CE->getIndices() : ArrayRef<unsigned>())
+        .Hash;
+  }
+};
+
+typedef UniqueNodeSet<ConstantArray,
+                      ConstantAggrUniquingInfo<ConstantArray, ArrayType> >
+  ConstantArraySet;
+typedef UniqueNodeSet<ConstantStruct,
+                      ConstantAggrUniquingInfo<ConstantStruct, StructType> >
+  ConstantStructSet;
+typedef UniqueNodeSet<ConstantVector,
+                      ConstantAggrUniquingInfo<ConstantVector, VectorType> >
+  ConstantVectorSet;
+typedef UniqueNodeSet<ConstantExpr, ConstantExprUniquingInfo>
+  ConstantExprSet;
+
+/// Print one line of uniquing statistics for the table \p Set, named
+/// \p Name, as LLVMContext::printConstantUniquingStats does.
+template <typename SetT>
+void printUniquingTableStats(raw_ostream &OS, StringRef Name,
+                             const SetT &Set) {
+  OS << format("%-20s", Name.str().c_str()) << format("%8u", Set.size())
+     << " constants in " << format("%8u", Set.getNumBuckets())
+     << " buckets, " << Set.getMemorySize() << " bytes\n";
+}
+
+} // end namespace llvm
+
+#endif
@@ -822,6 +822,13 @@ DIVariable createInlinedVariable(MDNode *DV, MDNode *InlinedScope,
 DIVariable cleanseInlinedVariable(MDNode *DV, LLVMContext &VMContext);
 
 /// Construct DITypeIdentifierMap by going through retained types of each CU.
+///
+/// This map is what makes ODR types unique in an LTO link: C++ and
+/// Objective-C++ types that DIBuilder gave an identifier (their mangled
+/// name) are referenced by that identifier, so when modules are linked,
+/// each type is kept once and DwarfDebug emits it in a single compile unit.
+/// DIE construction itself stays serial, because every unit shares the
+/// string pool, the abbreviation set and the type DIE map of DwarfDebug.
 DITypeIdentifierMap generateDITypeIdentifierMap(const NamedMDNode *CU_Nodes);
 
 /// Strip debug info in the module if it exists.
@@ -830,6 +837,15 @@ DITypeIdentifierMap generateDITypeIdentifierMap(const NamedMDNode *CU_Nodes);
 /// Return true if module is modified.
 bool StripDebugInfo(Module &M);
 
+/// Reduce the debug info in the module to what -gline-tables-only would have
+/// produced: the compile units, subprograms, lexical blocks and instruction
+/// locations are kept, while variables, the llvm.dbg.declare and
+/// llvm.dbg.value calls, types, imported entities and globals are dropped.
+/// The nodes that are no longer referenced are freed from the LLVMContext,
+/// which is most of the debug info memory of a large -g LTO link.
+/// Return true if module is modified.
+bool StripNonLineTableDebugInfo(Module &M);
+
 /// Return Debug Info Metadata Version by checking module flags.
 unsigned getDebugMetadataVersionFromModule(const Module &M);
 
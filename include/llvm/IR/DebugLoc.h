@@ -25,6 +25,12 @@ namespace llvm {
   /// DebugLoc - Debug location id.  This is carried by Instruction, SDNode,
   /// and MachineInstr to compactly encode file/line/scope information for an
   /// operation.
+  ///
+  /// A DebugLoc takes 8 bytes and does not own an MDNode: the scope and
+  /// inlined-at pair is interned once per LLVMContext, and the bitcode
+  /// reader decodes locations straight into DebugLocs.  Only getAsMDNode()
+  /// creates a DILocation node, which then lives as long as the context, so
+  /// it should be avoided in passes that visit every instruction.
   class DebugLoc {
     friend struct DenseMapInfo<DebugLoc>;
 
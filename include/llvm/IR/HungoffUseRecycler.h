@@ -0,0 +1,135 @@
+//===--- llvm/HungoffUseRecycler.h - Hung-off Use recycling -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines HungoffUseRecycler, an alternative allocator for the
+// operand arrays of PHINode, SwitchInst, IndirectBrInst and LandingPadInst,
+// enabled by building with LLVM_HUNGOFF_USE_RECYCLING=1.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_HUNGOFFUSERECYCLER_H
+#define LLVM_IR_HUNGOFFUSERECYCLER_H
+
+#include "llvm/IR/Use.h"
+#include "llvm/Support/AlignOf.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+/// LLVM_HUNGOFF_USE_RECYCLING - When set to 1, User::allocHungoffUses
+/// takes its arrays from the HungoffUseRecycler of the user's LLVMContext,
+/// and Use::zap gives them back to it, instead of calling operator new and
+/// operator delete.  It is off by default; turn it on to compare the
+/// locality of use-list heavy passes on a given workload.
+#ifndef LLVM_HUNGOFF_USE_RECYCLING
+#define LLVM_HUNGOFF_USE_RECYCLING 0
+#endif
+
+namespace llvm {
+
+/// \brief Hands out hung-off operand arrays from slabs, in power-of-two size
+/// classes, and reuses the arrays that are freed.
+///
+/// Growing a PHI node or a switch reallocates its operands, and RAUW-heavy
+/// passes churn through many arrays of the same few sizes.  Taking them
+/// from slabs keeps the operands of a function close together, and reusing
+/// freed arrays of the same class keeps the memory from growing.
+///
+/// Each array is preceded by a header naming its recycler and size class,
+/// so that it can be freed from Use::zap, which only knows its start.  A
+/// recycler belongs to one LLVMContext and, like the rest of the IR of that
+/// context, must only be used by one thread at a time.  Arrays larger than
+/// the largest size class come from operator new.
+class HungoffUseRecycler {
+  enum { NumSizeClasses = 16 };
+
+  struct Header {
+    HungoffUseRecycler *Owner;
+    unsigned SizeClass;
+  };
+
+  struct FreeBlock {
+    FreeBlock *Next;
+  };
+
+  FreeBlock *FreeLists[NumSizeClasses];
+  BumpPtrAllocator Slabs;
+  size_t BytesInUse;
+
+  static size_t getHeaderSize() {
+    return RoundUpToAlignment(sizeof(Header), AlignOf<Use>::Alignment);
+  }
+
+  /// \brief The bytes of a block for \p NumUses Uses, the User pointer that
+  /// follows them, and the header.
+  static size_t getBlockSize(unsigned NumUses) {
+    return getHeaderSize() + sizeof(Use) * NumUses + sizeof(Use::UserRef);
+  }
+
+  static Header *getHeader(void *Uses) {
+    return reinterpret_cast<Header *>(static_cast<char *>(Uses) -
+                                      getHeaderSize());
+  }
+
+public:
+  HungoffUseRecycler() : BytesInUse(0) {
+    std::memset(FreeLists, 0, sizeof(FreeLists));
+  }
+
+  /// \brief Allocate room for \p NumUses Uses followed by a Use::UserRef.
+  ///
+  /// The array may hold more Uses than requested; callers only rely on the
+  /// number they asked for.
+  void *allocate(unsigned NumUses) {
+    unsigned SizeClass = Log2_32_Ceil(std::max(NumUses, 1u));
+    void *Block;
+    if (SizeClass >= NumSizeClasses) {
+      Block = ::operator new(getBlockSize(NumUses));
+    } else if (FreeLists[SizeClass]) {
+      Block = FreeLists[SizeClass];
+      FreeLists[SizeClass] = FreeLists[SizeClass]->Next;
+    } else {
+      Block = Slabs.Allocate(getBlockSize(1u << SizeClass),
+                             AlignOf<Use>::Alignment);
+    }
+    Header *H = static_cast<Header *>(Block);
+    H->Owner = this;
+    H->SizeClass = SizeClass;
+    if (SizeClass < NumSizeClasses)
+      BytesInUse += getBlockSize(1u << SizeClass);
+    return static_cast<char *>(Block) + getHeaderSize();
+  }
+
+  /// \brief Free an array returned by allocate() on any recycler.
+  static void deallocate(void *Uses) {
+    Header *H = getHeader(Uses);
+    HungoffUseRecycler *Owner = H->Owner;
+    unsigned SizeClass = H->SizeClass;
+    if (SizeClass >= NumSizeClasses) {
+      ::operator delete(H);
+      return;
+    }
+    Owner->BytesInUse -= getBlockSize(1u << SizeClass);
+    FreeBlock *Free = new (H) FreeBlock;
+    Free->Next = Owner->FreeLists[SizeClass];
+    Owner->FreeLists[SizeClass] = Free;
+  }
+
+  /// \brief The bytes of the arrays currently allocated from slabs.
+  size_t getBytesInUse() const { return BytesInUse; }
+
+  /// \brief The bytes of slab memory, in use or free.
+  size_t getTotalMemory() const { return Slabs.getTotalMemory(); }
+};
+
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,113 @@
+//===- IncrementalVerifier.h - Re-verify only changed IR --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines IncrementalVerifier, which remembers the functions that
+// verified cleanly so that a pipeline verifying after every pass only
+// re-verifies the functions that passes changed.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_INCREMENTALVERIFIER_H
+#define LLVM_IR_INCREMENTALVERIFIER_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace llvm {
+
+/// IncrementalVerifier - Caches the result of verifying each function.
+///
+/// The owner reports changes: functionChanged after a function pass changed
+/// a function, and moduleChanged after anything else changed the module,
+/// which drops the whole cache.  The pass managers already know both, since
+/// runOnFunction and runOnModule return whether they changed anything.  A
+/// deleted function leaves the cache by itself.  Functions that have not
+/// changed since they last verified cleanly are not walked again.
+///
+/// Functions are verified one at a time on the calling thread: verifying
+/// goes through the type, constant and metadata tables of the LLVMContext,
+/// which are not safe to use from several threads.
+class IncrementalVerifier {
+  /// VerifiedVH - Drops a function that verified cleanly from the cache
+  /// when it is deleted.  Unlike a ValueMap key, it does not follow RAUW: a
+  /// function whose uses were replaced, possibly by a bitcast, is still the
+  /// function that verified.
+  class VerifiedVH : public CallbackVH {
+    IncrementalVerifier *Owner;
+
+  public:
+    VerifiedVH(const Function *F, IncrementalVerifier *Owner)
+      : CallbackVH(const_cast<Function *>(F)), Owner(Owner) {}
+
+    void deleted() override {
+      // Erasing the entry destroys *this.
+      Owner->Verified.erase(cast<Function>(getValPtr()));
+    }
+  };
+
+  DenseMap<const Function *, VerifiedVH> Verified;
+  bool ModuleChanged;
+
+  IncrementalVerifier(const IncrementalVerifier &) LLVM_DELETED_FUNCTION;
+  void operator=(const IncrementalVerifier &) LLVM_DELETED_FUNCTION;
+
+  void markVerified(const Function *F) {
+    Verified.insert(std::make_pair(F, VerifiedVH(F, this)));
+  }
+
+public:
+  IncrementalVerifier() : ModuleChanged(true) {}
+
+  /// functionChanged - \p F must be verified again.
+  void functionChanged(const Function &F) { Verified.erase(&F); }
+
+  /// moduleChanged - Everything must be verified again.
+  void moduleChanged() {
+    ModuleChanged = true;
+    Verified.clear();
+  }
+
+  /// verifyFunction - As llvm::verifyFunction, unless \p F is unchanged
+  /// since it last verified cleanly.  Declarations always verify.
+  bool verifyFunction(const Function &F, raw_ostream *OS = nullptr) {
+    if (F.isDeclaration() || Verified.count(&F))
+      return false;
+    if (llvm::verifyFunction(F, OS))
+      return true;
+    markVerified(&F);
+    return false;
+  }
+
+  /// verifyModule - As llvm::verifyModule after moduleChanged, and otherwise
+  /// verify only the functions that changed, in module order.
+  bool verifyModule(const Module &M, raw_ostream *OS = nullptr) {
+    if (ModuleChanged) {
+      if (llvm::verifyModule(M, OS))
+        return true;
+      ModuleChanged = false;
+      for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+        if (!I->isDeclaration())
+          markVerified(I);
+      return false;
+    }
+
+    bool Broken = false;
+    for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+      Broken |= verifyFunction(*I, OS);
+    return Broken;
+  }
+};
+
+} // End llvm namespace
+
+#endif
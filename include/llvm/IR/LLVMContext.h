@@ -31,6 +31,7 @@ class DiagnosticInfo;
 template <typename T> class SmallVectorImpl;
 class Function;
 class DebugLoc;
+class raw_ostream;
 
 /// This is an important class for using LLVM in a threaded context.  It
 /// (opaquely) owns and manages the core "global" data of LLVM's core
@@ -136,6 +137,11 @@ public:
   void emitOptimizationRemark(const char *PassName, const Function &Fn,
                               const DebugLoc &DLoc, const Twine &Msg);
 
+  /// printConstantUniquingStats - Print the number of constants, buckets and
+  /// bytes of each table that uniques the aggregate constants and constant
+  /// expressions of this context, for -stats and memory investigations.
+  void printConstantUniquingStats(raw_ostream &OS) const;
+
 private:
   LLVMContext(LLVMContext&) LLVM_DELETED_FUNCTION;
   void operator=(LLVMContext&) LLVM_DELETED_FUNCTION;
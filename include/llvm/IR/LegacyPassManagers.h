@@ -405,6 +405,17 @@ private:
 /// It batches all function passes and basic block pass managers together and
 /// sequence them to process one function at a time before processing next
 /// function.
+///
+/// Functions are processed on one thread even when they do not call each
+/// other.  Function passes are not isolated from the rest of the module:
+/// every operand that refers to a global or a constant links a Use into
+/// that value's use list, constants and types are uniqued in the shared
+/// LLVMContext, and the passes themselves are single instances whose
+/// analyses (and the AnalysisResolver) hold state for the current function.
+/// Running pipelines on several functions at once would need per-thread
+/// pass instances and a context whose uniquing tables and use lists of
+/// globals are synchronized.  To use several cores, split the module and
+/// run each part in its own LLVMContext, as parallel code generation does.
 class FPPassManager : public ModulePass, public PMDataManager {
 public:
   static char ID;
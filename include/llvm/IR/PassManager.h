@@ -579,11 +579,14 @@ protected:
 
   // We have to explicitly define all the special member functions because MSVC
   // refuses to generate them.
-  AnalysisManagerBase() {}
+  AnalysisManagerBase() : NumQueries(0), NumRuns(0) {}
   AnalysisManagerBase(AnalysisManagerBase &&Arg)
-      : AnalysisPasses(std::move(Arg.AnalysisPasses)) {}
+      : AnalysisPasses(std::move(Arg.AnalysisPasses)),
+        NumQueries(Arg.NumQueries), NumRuns(Arg.NumRuns) {}
   AnalysisManagerBase &operator=(AnalysisManagerBase &&RHS) {
     AnalysisPasses = std::move(RHS.AnalysisPasses);
+    NumQueries = RHS.NumQueries;
+    NumRuns = RHS.NumRuns;
     return *this;
   }
 
@@ -596,11 +599,18 @@ public:
     assert(AnalysisPasses.count(PassT::ID()) &&
            "This analysis pass was not registered prior to being queried");
 
-    ResultConceptT &ResultConcept =
-        derived_this()->getResultImpl(PassT::ID(), IR);
+    // Look in the cache first so that queries which had to run the analysis
+    // can be counted; a miss costs one extra lookup next to the analysis.
+    ++NumQueries;
+    ResultConceptT *ResultConcept =
+        derived_this()->getCachedResultImpl(PassT::ID(), IR);
+    if (!ResultConcept) {
+      ++NumRuns;
+      ResultConcept = &derived_this()->getResultImpl(PassT::ID(), IR);
+    }
     typedef detail::AnalysisResultModel<IRUnitT, PassT, typename PassT::Result>
         ResultModelT;
-    return static_cast<ResultModelT &>(ResultConcept).Result;
+    return static_cast<ResultModelT *>(ResultConcept)->Result;
   }
 
   /// \brief Get the cached result of an analysis pass for this module.
@@ -652,6 +662,16 @@ public:
     derived_this()->invalidateImpl(IR, PA);
   }
 
+  /// \brief The number of getResult() queries made on this manager.
+  unsigned getNumQueries() const { return NumQueries; }
+
+  /// \brief The number of getResult() queries that had to run the analysis
+  /// because no valid result was cached.
+  ///
+  /// Comparing this with the number of queries shows how many
+  /// recomputations precise preserved-analyses tracking saved.
+  unsigned getNumRuns() const { return NumRuns; }
+
 protected:
   /// \brief Lookup a registered analysis pass.
   PassConceptT &lookupPass(void *PassID) {
@@ -675,6 +695,9 @@ private:
 
   /// \brief Collection of module analysis passes, indexed by ID.
   AnalysisPassMapT AnalysisPasses;
+
+  /// \brief Counts of results queried and results computed.
+  unsigned NumQueries, NumRuns;
 };
 
 } // End namespace detail
@@ -52,6 +52,9 @@ protected:
   void *operator new(size_t s, unsigned Us);
   User(Type *ty, unsigned vty, Use *OpList, unsigned NumOps)
     : Value(ty, vty), OperandList(OpList), NumOperands(NumOps) {}
+  /// allocHungoffUses - Allocate an array of Uses followed by a pointer
+  /// back to this User, from the context's HungoffUseRecycler when LLVM is
+  /// built with LLVM_HUNGOFF_USE_RECYCLING.
   Use *allocHungoffUses(unsigned) const;
   void dropHungoffUses() {
     Use::zap(OperandList, OperandList + NumOperands, true);
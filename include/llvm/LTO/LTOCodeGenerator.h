@@ -74,6 +74,27 @@ struct LTOCodeGenerator {
 
   void setCpu(const char *mCpu) { MCpu = mCpu; }
 
+  // Split the merged module into the given number of partitions, each of
+  // which is code generated on its own thread into its own object file by
+  // compile_to_files(). The default is a single partition.
+  void setCodeGenPartitions(unsigned N) { NumPartitions = N ? N : 1; }
+
+  // Keep the native objects of the partitions in the given directory, keyed
+  // by a hash of the partition bitcode, the target, the code generation
+  // options and the preserved symbols, and reuse them when a later link
+  // produces an identical partition. An empty path disables the cache.
+  void setCacheDir(const char *Dir) { CacheDir = Dir ? Dir : ""; }
+
+  // Read function counts from the given instrumentation profile and write an
+  // ld64 -order_file for the merged module to OrderPath, listing the functions
+  // that ran, hottest first. Those functions are also placed in a
+  // __TEXT,__text_hot section so that they share pages even where the order
+  // file is not applied. Empty paths disable this.
+  void setFunctionOrderProfile(const char *ProfilePath, const char *OrderPath) {
+    OrderProfilePath = ProfilePath ? ProfilePath : "";
+    OrderFilePath = OrderPath ? OrderPath : "";
+  }
+
   void addMustPreserveSymbol(const char *sym) { MustPreserveSymbols[sym] = 1; }
 
   // To pass options to the driver and optimization passes. These options are
@@ -104,6 +125,21 @@ struct LTOCodeGenerator {
                        bool disableGVNLoadPRE,
                        std::string &errMsg);
 
+  // As with compile_to_file(), but split the merged module into the number of
+  // partitions set with setCodeGenPartitions() and compile each into its own
+  // object file, in parallel. The paths to the object files are returned via
+  // argument "names", which remains valid until the next compilation or the
+  // destruction of the LTOCodeGenerator. Return true on success.
+  //
+  // As with compile_to_file(), it is up to the linker to remove the object
+  // files.
+  bool compile_to_files(const char ***names,
+                        unsigned *count,
+                        bool disableOpt,
+                        bool disableInline,
+                        bool disableGVNLoadPRE,
+                        std::string &errMsg);
+
   // As with compile_to_file(), this function compiles the merged module into
   // single object file. Instead of returning the object-file-path to the caller
   // (linker), it brings the object to a buffer, and return the buffer to the
@@ -125,6 +161,14 @@ private:
                           bool disableInline,
                           bool disableGVNLoadPRE,
                           std::string &errMsg);
+
+  // Run the LTO passes over the merged module, then split it and generate
+  // one object file per output stream (see llvm::splitCodeGen).
+  bool generateObjectFiles(llvm::ArrayRef<llvm::raw_ostream *> outs,
+                           bool disableOpt,
+                           bool disableInline,
+                           bool disableGVNLoadPRE,
+                           std::string &errMsg);
   void applyScopeRestrictions();
   void applyRestriction(llvm::GlobalValue &GV,
                         const llvm::ArrayRef<llvm::StringRef> &Libcalls,
@@ -151,6 +195,12 @@ private:
   std::vector<char *> CodegenOptions;
   std::string MCpu;
   std::string NativeObjectPath;
+  unsigned NumPartitions;
+  std::string CacheDir;
+  std::string OrderProfilePath;
+  std::string OrderFilePath;
+  std::vector<std::string> NativeObjectPaths;
+  std::vector<const char *> NativeObjectPathPtrs;
   llvm::TargetOptions Options;
   lto_diagnostic_handler_t DiagHandler;
   void *DiagContext;
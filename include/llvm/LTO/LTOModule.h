@@ -20,6 +20,7 @@
 #include "llvm/IR/Module.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/Support/system_error.h"
 #include "llvm/Target/TargetMachine.h"
 #include <string>
 #include <vector>
@@ -87,6 +88,12 @@ public:
   /// InitializeAllTargetMCs();
   /// InitializeAllAsmPrinters();
   /// InitializeAllAsmParsers();
+  ///
+  /// The module is loaded lazily: only the global value headers, global
+  /// variable initializers, module-level asm and metadata are read, which is
+  /// all the symbol table needs. Function bodies are read by materializeAll()
+  /// when the module is added to an LTOCodeGenerator, so the bodies of
+  /// archive members the linker never loads are never parsed.
   static LTOModule *makeLTOModule(const char* path,
                                   llvm::TargetOptions options,
                                   std::string &errMsg);
@@ -156,15 +163,32 @@ public:
     return nullptr;
   }
 
-  /// getLLVVMModule - Return the Module.
+  /// getLLVVMModule - Return the Module. Its function bodies may not have
+  /// been read yet; see materializeAll().
   llvm::Module *getLLVVMModule() { return _module.get(); }
 
+  /// materializeAll - Read all the function bodies that were left unread by
+  /// lazy loading. Return true on success.
+  bool materializeAll(std::string &errMsg) {
+    if (llvm::error_code ec = _module->materializeAllPermanently()) {
+      errMsg = ec.message();
+      return false;
+    }
+    return true;
+  }
+
   /// getAsmUndefinedRefs -
   const std::vector<const char*> &getAsmUndefinedRefs() {
     return _asm_undefines;
   }
 
 private:
+  /// isDefinition - Returns 'true' if the global value is defined in this
+  /// module, whether or not its body has been read yet.
+  bool isDefinition(const llvm::GlobalValue *gv) const {
+    return !gv->isDeclaration() || _module->isMaterializable(gv);
+  }
+
   /// parseMetadata - Parse metadata from the module
   // FIXME: it only parses "Linker Options" metadata at the moment
   void parseMetadata();
@@ -0,0 +1,145 @@
+//===--- LTOObjectCache.h - LLVM Link Time Optimizer ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the LTOObjectCache class, which keeps the native objects
+// generated for LTO partitions on disk so incremental links can reuse them.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LTO_OBJECT_CACHE_H
+#define LTO_OBJECT_CACHE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+//===----------------------------------------------------------------------===//
+/// LTOObjectCache - A directory of native objects generated by LTO, keyed by
+/// a hash of the partition bitcode and of everything else that affects code
+/// generation: the target configuration, the code generation options and the
+/// set of symbols the linker asked to preserve.
+///
+/// Entries live in <dir>/<xx>/<key>.o and are written to a unique temporary
+/// file and renamed into place, so concurrent links can share a directory.
+///
+class LTOObjectCache : public llvm::SplitCodeGenCache {
+public:
+  explicit LTOObjectCache(llvm::StringRef Dir)
+    : CacheDir(Dir), NumHits(0), NumMisses(0), NumStores(0) {
+    std::fill(Context, Context + sizeof(Context), 0);
+  }
+
+  llvm::StringRef getCacheDir() const { return CacheDir; }
+
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumMisses() const { return NumMisses; }
+  unsigned getNumStores() const { return NumStores; }
+
+  // Record everything besides the partition bitcode that affects the
+  // generated objects. Must be called before the first lookup.
+  void setContext(const llvm::TargetMachine &TM,
+                  llvm::ArrayRef<char *> CodegenOptions,
+                  const llvm::StringMap<uint8_t> &MustPreserveSymbols) {
+    llvm::MD5 Hash;
+    const uint8_t Separator = 0;
+    Hash.update(getFormatVersion());
+    Hash.update(Separator);
+    Hash.update(TM.getTargetTriple());
+    Hash.update(Separator);
+    Hash.update(TM.getTargetCPU());
+    Hash.update(Separator);
+    Hash.update(TM.getTargetFeatureString());
+    Hash.update(Separator);
+    Hash.update(uint8_t(TM.getRelocationModel()));
+    Hash.update(uint8_t(TM.getCodeModel()));
+    Hash.update(uint8_t(TM.getOptLevel()));
+
+    for (unsigned i = 0, e = CodegenOptions.size(); i != e; ++i) {
+      Hash.update(CodegenOptions[i]);
+      Hash.update(Separator);
+    }
+
+    // StringMap iteration order is unspecified, so sort the symbols first.
+    std::vector<llvm::StringRef> Symbols;
+    for (llvm::StringMap<uint8_t>::const_iterator
+             I = MustPreserveSymbols.begin(), E = MustPreserveSymbols.end();
+         I != E; ++I)
+      Symbols.push_back(I->getKey());
+    std::sort(Symbols.begin(), Symbols.end());
+    for (unsigned i = 0, e = Symbols.size(); i != e; ++i) {
+      Hash.update(Symbols[i]);
+      Hash.update(Separator);
+    }
+
+    Hash.final(Context);
+  }
+
+  // Compute the key of the partition whose bitcode is Bitcode.
+  void computeKey(llvm::StringRef Bitcode, llvm::SmallString<32> &Key) const {
+    llvm::MD5 Hash;
+    Hash.update(llvm::ArrayRef<uint8_t>(Context, sizeof(Context)));
+    Hash.update(Bitcode);
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    llvm::MD5::stringifyResult(Result, Key);
+  }
+
+  bool lookup(llvm::StringRef Bitcode, llvm::raw_ostream &OS) override {
+    llvm::SmallString<256> EntryPath;
+    getEntryPath(Bitcode, EntryPath);
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    if (llvm::MemoryBuffer::getFile(EntryPath.str(), Buffer, -1,
+                                    /*RequiresNullTerminator=*/false)) {
+      ++NumMisses;
+      return false;
+    }
+    OS << Buffer->getBuffer();
+    ++NumHits;
+    return true;
+  }
+
+  // Failures are silently ignored; the cache is only an optimization.
+  void store(llvm::StringRef Bitcode, llvm::StringRef Object) override {
+    llvm::SmallString<256> EntryPath;
+    getEntryPath(Bitcode, EntryPath);
+    if (llvm::writeFileAtomically(EntryPath.str(), Object))
+      return;
+    ++NumStores;
+  }
+
+private:
+  static llvm::StringRef getFormatVersion() { return "llvm-lto-cache-1"; }
+
+  void getEntryPath(llvm::StringRef Bitcode,
+                    llvm::SmallVectorImpl<char> &Path) const {
+    llvm::SmallString<32> Key;
+    computeKey(Bitcode, Key);
+    Path.clear();
+    Path.append(CacheDir.begin(), CacheDir.end());
+    llvm::sys::path::append(Path, Key.substr(0, 2), llvm::Twine(Key) + ".o");
+  }
+
+  std::string CacheDir;
+  llvm::MD5::MD5Result Context;
+  unsigned NumHits, NumMisses, NumStores;
+};
+
+#endif // LTO_OBJECT_CACHE_H
@@ -0,0 +1,272 @@
+//===--- LinkInputResolver.h - LLVM Link Time Optimizer ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the LinkInputResolver class, which reads the symbols of
+// a link's object files and archive members on worker threads and then picks
+// the archive members to load in the order ld64 does.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LTO_LINK_INPUT_RESOLVER_H
+#define LTO_LINK_INPUT_RESOLVER_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/LTO/LTOModule.h"
+#include "llvm/Object/Archive.h"
+#include "llvm/Object/SymbolicFile.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/system_error.h"
+#include "llvm/Target/TargetOptions.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+//===----------------------------------------------------------------------===//
+/// LinkInputResolver - The symbols of every input of a link, and the members
+/// of its archives that the link loads.
+///
+/// readInputs maps the inputs and reads the symbols of the native objects,
+/// both plain and in archives, on the shared ThreadPool; only the symbol
+/// tables are read, not the sections.  Bitcode members are read afterwards
+/// on the calling thread through LTOModule, the implementation of lto.h,
+/// because every LTOModule lives in the global LLVMContext.
+///
+/// resolve then works on the collected symbols alone.  It loads every plain
+/// object, then searches the archives in command line order, again and
+/// again, for members that define a symbol that is still undefined, as ld64
+/// does; it ignores the position of an archive relative to the objects.
+class LinkInputResolver {
+public:
+  struct Member {
+    /// The member name; empty for a plain object.
+    std::string Name;
+    /// The contents, pointing into the mapped input.
+    llvm::StringRef Buffer;
+    bool IsBitcode;
+    std::vector<std::string> Defined;
+    std::vector<std::string> Undefined;
+    /// The error reading the symbols, if any.
+    llvm::error_code EC;
+
+    Member() : IsBitcode(false) {}
+  };
+
+  struct Input {
+    std::string Path;
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    bool IsArchive;
+    std::vector<Member> Members;
+
+    Input() : IsArchive(false) {}
+  };
+
+  /// A loaded member: the index of its input and its index in the input.
+  typedef std::pair<unsigned, unsigned> MemberIndex;
+
+private:
+  std::vector<Input> Inputs;
+
+  static void readNativeSymbols(const std::string &Path, Member &M) {
+    using namespace llvm::object;
+    llvm::MemoryBuffer *Buffer = llvm::MemoryBuffer::getMemBuffer(
+        M.Buffer, Path, /*RequiresNullTerminator=*/false);
+    llvm::ErrorOr<SymbolicFile *> ObjOrErr = SymbolicFile::createSymbolicFile(
+        Buffer, /*BufferOwned=*/true, llvm::sys::fs::file_magic::unknown,
+        nullptr);
+    if ((M.EC = ObjOrErr.getError()))
+      return;
+    std::unique_ptr<SymbolicFile> Obj(ObjOrErr.get());
+
+    for (basic_symbol_iterator I = Obj->symbol_begin(), E = Obj->symbol_end();
+         I != E; ++I) {
+      uint32_t Flags = I->getFlags();
+      if (!(Flags & BasicSymbolRef::SF_Global) ||
+          (Flags & BasicSymbolRef::SF_FormatSpecific))
+        continue;
+      std::string Name;
+      llvm::raw_string_ostream NameOS(Name);
+      if ((M.EC = I->printName(NameOS)))
+        return;
+      if (Flags & BasicSymbolRef::SF_Undefined)
+        M.Undefined.push_back(NameOS.str());
+      else
+        M.Defined.push_back(NameOS.str());
+    }
+  }
+
+  static void readBitcodeSymbols(const llvm::TargetOptions &Options,
+                                 const std::string &Path, Member &M) {
+    std::string ErrMsg;
+    std::unique_ptr<LTOModule> Mod(LTOModule::makeLTOModule(
+        M.Buffer.data(), M.Buffer.size(), Options, ErrMsg, Path));
+    if (!Mod) {
+      M.EC = llvm::make_error_code(llvm::errc::invalid_argument);
+      return;
+    }
+    for (uint32_t i = 0, e = Mod->getSymbolCount(); i != e; ++i) {
+      lto_symbol_attributes Attrs = Mod->getSymbolAttributes(i);
+      if ((Attrs & LTO_SYMBOL_SCOPE_MASK) == LTO_SYMBOL_SCOPE_INTERNAL)
+        continue;
+      unsigned Definition = Attrs & LTO_SYMBOL_DEFINITION_MASK;
+      if (Definition == LTO_SYMBOL_DEFINITION_UNDEFINED ||
+          Definition == LTO_SYMBOL_DEFINITION_WEAKUNDEF)
+        M.Undefined.push_back(Mod->getSymbolName(i));
+      else
+        M.Defined.push_back(Mod->getSymbolName(i));
+    }
+  }
+
+  /// Add the input \p Path, mapped in \p In.Buffer, and its members.
+  static llvm::error_code addMembers(Input &In) {
+    using namespace llvm::object;
+    llvm::StringRef Data = In.Buffer->getBuffer();
+    if (llvm::sys::fs::identify_magic(Data) !=
+        llvm::sys::fs::file_magic::archive) {
+      In.Members.push_back(Member());
+      In.Members.back().Buffer = Data;
+      return llvm::error_code::success();
+    }
+
+    In.IsArchive = true;
+    llvm::error_code EC;
+    Archive A(llvm::MemoryBuffer::getMemBuffer(Data, In.Path,
+                                               /*RequiresNullTerminator=*/
+                                               false),
+              EC);
+    if (EC)
+      return EC;
+    for (Archive::child_iterator I = A.child_begin(), E = A.child_end();
+         I != E; ++I) {
+      llvm::StringRef Name;
+      if (llvm::error_code EC = I->getName(Name))
+        return EC;
+      In.Members.push_back(Member());
+      In.Members.back().Name = Name;
+      In.Members.back().Buffer = I->getBuffer();
+    }
+    return llvm::error_code::success();
+  }
+
+public:
+  /// Map the files \p Paths and read the symbols of all their objects.  The
+  /// errors of reading single members are kept in Member::EC, and only
+  /// matter if resolve loads the member.
+  llvm::error_code readInputs(llvm::ArrayRef<std::string> Paths,
+                              const llvm::TargetOptions &Options) {
+    Inputs.clear();
+    Inputs.resize(Paths.size());
+    std::vector<llvm::error_code> Errors(Paths.size());
+    llvm::parallel_for(0u, unsigned(Paths.size()), [&](unsigned i) {
+      Inputs[i].Path = Paths[i];
+      if (!(Errors[i] = llvm::MemoryBuffer::getFile(
+                Paths[i], Inputs[i].Buffer, -1,
+                /*RequiresNullTerminator=*/false)))
+        Errors[i] = addMembers(Inputs[i]);
+    });
+    for (unsigned i = 0, e = Errors.size(); i != e; ++i)
+      if (Errors[i])
+        return Errors[i];
+
+    std::vector<std::pair<Input *, Member *> > Native, Bitcode;
+    for (unsigned i = 0, e = Inputs.size(); i != e; ++i)
+      for (unsigned j = 0, je = Inputs[i].Members.size(); j != je; ++j) {
+        Member &M = Inputs[i].Members[j];
+        M.IsBitcode = LTOModule::isBitcodeFile(M.Buffer.data(),
+                                               M.Buffer.size());
+        (M.IsBitcode ? Bitcode : Native).push_back(
+            std::make_pair(&Inputs[i], &M));
+      }
+
+    llvm::parallel_for(0u, unsigned(Native.size()), [&](unsigned i) {
+      readNativeSymbols(Native[i].first->Path, *Native[i].second);
+    });
+    for (unsigned i = 0, e = Bitcode.size(); i != e; ++i)
+      readBitcodeSymbols(Options, Bitcode[i].first->Path, *Bitcode[i].second);
+    return llvm::error_code::success();
+  }
+
+  unsigned getNumInputs() const { return Inputs.size(); }
+  const Input &getInput(unsigned i) const { return Inputs[i]; }
+
+  /// Pick the members the link loads, in the order it loads them, and
+  /// collect the symbols that stay undefined in \p Undefined.
+  ///
+  /// \returns the error of reading a loaded member, if any.
+  llvm::error_code resolve(std::vector<MemberIndex> &Loaded,
+                           std::vector<std::string> &Undefined) const {
+    llvm::StringMap<char> Defined, Pending;
+    std::vector<std::vector<char> > IsLoaded(Inputs.size());
+    auto Load = [&](unsigned i, unsigned j) -> llvm::error_code {
+      const Member &M = Inputs[i].Members[j];
+      if (M.EC)
+        return M.EC;
+      IsLoaded[i][j] = 1;
+      Loaded.push_back(MemberIndex(i, j));
+      for (unsigned k = 0, e = M.Defined.size(); k != e; ++k) {
+        Defined[M.Defined[k]] = 1;
+        Pending.erase(M.Defined[k]);
+      }
+      for (unsigned k = 0, e = M.Undefined.size(); k != e; ++k)
+        if (!Defined.count(M.Undefined[k]))
+          Pending[M.Undefined[k]] = 1;
+      return llvm::error_code::success();
+    };
+
+    // The first member of each archive that defines each symbol.
+    std::vector<llvm::StringMap<unsigned> > Providers(Inputs.size());
+    for (unsigned i = 0, e = Inputs.size(); i != e; ++i) {
+      IsLoaded[i].resize(Inputs[i].Members.size());
+      if (!Inputs[i].IsArchive) {
+        if (llvm::error_code EC = Load(i, 0))
+          return EC;
+        continue;
+      }
+      for (unsigned j = Inputs[i].Members.size(); j-- != 0;)
+        for (unsigned k = 0, ke = Inputs[i].Members[j].Defined.size();
+             k != ke; ++k)
+          Providers[i][Inputs[i].Members[j].Defined[k]] = j;
+    }
+
+    for (bool Changed = true; Changed;) {
+      Changed = false;
+      for (unsigned i = 0, e = Inputs.size(); i != e; ++i) {
+        if (!Inputs[i].IsArchive)
+          continue;
+        std::vector<std::string> Wanted;
+        for (llvm::StringMap<char>::const_iterator I = Pending.begin(),
+                                                   E = Pending.end();
+             I != E; ++I)
+          Wanted.push_back(I->getKey());
+        for (unsigned k = 0, ke = Wanted.size(); k != ke; ++k) {
+          llvm::StringMap<unsigned>::const_iterator P =
+              Providers[i].find(Wanted[k]);
+          if (P == Providers[i].end() || IsLoaded[i][P->second] ||
+              !Pending.count(Wanted[k]))
+            continue;
+          if (llvm::error_code EC = Load(i, P->second))
+            return EC;
+          Changed = true;
+        }
+      }
+    }
+
+    for (llvm::StringMap<char>::const_iterator I = Pending.begin(),
+                                               E = Pending.end();
+         I != E; ++I)
+      Undefined.push_back(I->getKey());
+    return llvm::error_code::success();
+  }
+};
+
+#endif // LTO_LINK_INPUT_RESOLVER_H
@@ -315,6 +315,11 @@ namespace llvm {
     bool UseIntegratedAssembler;
 
     /// Compress DWARF debug sections. Defaults to false.
+    ///
+    /// Only the ELF object writer honors this, by emitting zlib-compressed
+    /// .zdebug_* sections when zlib is available. Mach-O has no compressed
+    /// section format that ld64 and dsymutil understand, so the __DWARF
+    /// sections of Mach-O objects are always written uncompressed.
     bool CompressDebugSections;
 
   public:
@@ -42,6 +42,12 @@ private:
   /// lower ordinal will be valid.
   mutable DenseMap<const MCSectionData*, MCFragment*> LastValidFragment;
 
+  /// The first fragment of each section which was resized during the current
+  /// relaxation pass, or 0 if the section did not change. Only the fragments
+  /// from this one on can have moved, so the next pass over the section only
+  /// has to revisit them, and sections which did not change are stable.
+  DenseMap<const MCSectionData*, MCFragment*> FirstResizedFragment;
+
   /// \brief Make sure that the layout for the given fragment is valid, lazily
   /// computing it if necessary.
   void ensureValid(const MCFragment *F) const;
@@ -65,6 +71,29 @@ public:
   /// its bundle padding will be recomputed.
   void invalidateFragmentsFrom(MCFragment *F);
 
+  /// \brief Record that \p F was resized during the current relaxation pass.
+  /// This is called by invalidateFragmentsFrom.
+  void noteFragmentResized(MCFragment *F);
+
+  /// \brief Get the first fragment of \p SD resized since the last call to
+  /// startRelaxationPass, or 0 if no fragment of the section was resized.
+  MCFragment *getFirstResizedFragment(const MCSectionData *SD) const {
+    return FirstResizedFragment.lookup(SD);
+  }
+
+  /// \brief Forget the fragments resized in \p SD, before starting another
+  /// relaxation pass over it.
+  void startRelaxationPass(const MCSectionData *SD) {
+    FirstResizedFragment[SD] = 0;
+  }
+
+  /// \brief Create the per-section layout entries of every section up front.
+  ///
+  /// After this, laying out or relaxing a section only updates the entries of
+  /// that section and never inserts into the layout maps, so independent
+  /// sections can be relaxed concurrently.
+  void prepareForParallelLayout();
+
   /// \brief Perform layout for a single fragment, assuming that the previous
   /// fragment has already been laid out correctly, and the parent section has
   /// been initialized.
@@ -906,6 +906,10 @@ private:
   /// By default it's 0, which means bundling is disabled.
   unsigned BundleAlignSize;
 
+  /// The number of threads layout and relaxation may use for independent
+  /// sections. 1 relaxes the sections one after the other.
+  unsigned LayoutThreads;
+
   unsigned RelaxAll : 1;
   unsigned NoExecStack : 1;
   unsigned SubsectionsViaSymbols : 1;
@@ -955,8 +959,23 @@ private:
 
   /// \brief Perform one layout iteration of the given section and return true
   /// if any offsets were adjusted.
+  ///
+  /// Only the fragments from the first fragment resized in the previous
+  /// iteration on are revisited, since nothing before it has moved; the first
+  /// iteration visits the whole section.
   bool layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD);
 
+  /// \brief Perform one layout iteration of \p Sections, which are relaxed
+  /// independently of each other on up to LayoutThreads threads. Sections
+  /// which have become stable are removed from \p Sections.
+  ///
+  /// Fixups which cross sections are never resolved during relaxation, so the
+  /// relaxation of one section does not depend on the layout of another.
+  ///
+  /// \returns true if any offsets were adjusted.
+  bool layoutSectionsOnce(MCAsmLayout &Layout,
+                          SmallVectorImpl<MCSectionData *> &Sections);
+
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
   bool relaxLEB(MCAsmLayout &Layout, MCLEBFragment &IF);
@@ -1055,6 +1074,9 @@ public:
   bool getRelaxAll() const { return RelaxAll; }
   void setRelaxAll(bool Value) { RelaxAll = Value; }
 
+  unsigned getLayoutThreads() const { return LayoutThreads; }
+  void setLayoutThreads(unsigned Value) { LayoutThreads = Value ? Value : 1; }
+
   bool getNoExecStack() const { return NoExecStack; }
   void setNoExecStack(bool Value) { NoExecStack = Value; }
 
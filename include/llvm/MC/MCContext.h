@@ -15,6 +15,8 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/MC/MCDwarf.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/SectionKind.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Compiler.h"
@@ -67,6 +69,11 @@ namespace llvm {
     /// objects.
     BumpPtrAllocator Allocator;
 
+    /// MCInstAllocator - Allocator for the instructions created with
+    /// createMCInst. They live until the context is reset, which destroys
+    /// them all at once.
+    SpecificBumpPtrAllocator<MCInst> MCInstAllocator;
+
     /// Symbols - Bindings of names to symbols.
     SymbolTable Symbols;
 
@@ -152,6 +159,11 @@ namespace llvm {
     /// Darwin).
     bool AllowTemporaryLabels;
 
+    /// Give the temporaries of CreateTempSymbol names and symbol table
+    /// entries.  Only the assembly printer needs them; the object writers
+    /// never look a temporary up by name, nor emit it.
+    bool UseNamesOnTempLabels;
+
     /// The Compile Unit ID that we are currently processing.
     unsigned DwarfCompileUnitID;
 
@@ -184,6 +196,8 @@ namespace llvm {
     const MCObjectFileInfo *getObjectFileInfo() const { return MOFI; }
 
     void setAllowTemporaryLabels(bool Value) { AllowTemporaryLabels = Value; }
+    void setUseNamesOnTempLabels(bool Value) { UseNamesOnTempLabels = Value; }
+    bool getUseNamesOnTempLabels() const { return UseNamesOnTempLabels; }
 
     /// @name Module Lifetime Management
     /// @{
@@ -194,6 +208,22 @@ namespace llvm {
 
     /// @}
 
+    /// @name Instruction Management
+    /// @{
+
+    /// createMCInst - Create an empty instruction owned by the context.
+    ///
+    /// The instruction is carved out of a bump pointer pool and stays valid
+    /// until the context is reset, so streamers and targets can build
+    /// instructions, and instructions referenced by MCOperand::CreateInst,
+    /// without a heap allocation per instruction or any ownership tracking.
+    /// Instructions with up to 8 operands never allocate at all.
+    MCInst *createMCInst() {
+      return new (MCInstAllocator.Allocate()) MCInst();
+    }
+
+    /// @}
+
     /// @name Symbol Management
     /// @{
 
@@ -203,8 +233,27 @@ namespace llvm {
 
     /// CreateTempSymbol - Create and return a new assembler temporary symbol
     /// with a unique but unspecified name.
+    ///
+    /// Unless UseNamesOnTempLabels is set or AllowTemporaryLabels is not, the
+    /// symbol is unnamed, as from createUnnamedTempSymbol.
     MCSymbol *CreateTempSymbol();
 
+    /// createUnnamedTempSymbol - Create an assembler temporary symbol with no
+    /// name.  It is carved out of the context's arena, like MCInsts, and is
+    /// neither formatted, hashed nor entered in the symbol table, which for
+    /// the many local labels of the integrated assembler (one per basic
+    /// block, call site and DWARF range) is most of the cost of a symbol.
+    ///
+    /// When temporary labels are not allowed, or must have names, this is
+    /// CreateTempSymbol, which then returns a named symbol, non-temporary
+    /// if temporary labels are not allowed.
+    MCSymbol *createUnnamedTempSymbol() {
+      if (!AllowTemporaryLabels || UseNamesOnTempLabels)
+        return CreateTempSymbol();
+      return new (Allocator.Allocate<MCSymbol>())
+          MCSymbol(StringRef(), /*isTemporary=*/true);
+    }
+
     /// getUniqueSymbolID() - Return a unique identifier for use in constructing
     /// symbol names.
     unsigned getUniqueSymbolID() { return NextUniqueID++; }
@@ -11,13 +11,14 @@
 
 #include "llvm-c/Disassembler.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/MC/MCInst.h"
 #include "llvm/MC/MCRelocationInfo.h"
 #include "llvm/MC/MCSymbolizer.h"
 #include "llvm/Support/DataTypes.h"
+#include <vector>
 
 namespace llvm {
 
-class MCInst;
 class MCSubtargetInfo;
 class MemoryObject;
 class raw_ostream;
@@ -83,6 +84,48 @@ public:
                                        uint64_t address,
                                        raw_ostream &vStream,
                                        raw_ostream &cStream) const = 0;
+
+  /// One instruction decoded by getInstructions.
+  struct DecodedInst {
+    MCInst Inst;
+    uint64_t Address;
+    uint64_t Size;
+    DecodeStatus Status;
+  };
+
+  /// getInstructions - Decode every instruction in [begin, end) of region
+  /// and append them to insts, in address order. Bytes which cannot be
+  /// decoded are appended as a Fail entry covering the bytes consumed (at
+  /// least one), and decoding resumes after them.
+  ///
+  /// The default implementation calls getInstruction in a loop; targets can
+  /// override it to keep decoder state across instructions. A disassembler
+  /// caches its comment stream, so clients decoding several sections in
+  /// parallel must use one disassembler per thread.
+  ///
+  /// @return         - The number of instructions which failed to decode.
+  virtual uint64_t getInstructions(std::vector<DecodedInst> &insts,
+                                   const MemoryObject &region,
+                                   uint64_t begin, uint64_t end,
+                                   raw_ostream &vStream,
+                                   raw_ostream &cStream) const {
+    uint64_t NumFailed = 0;
+    for (uint64_t Address = begin; Address < end;) {
+      insts.push_back(DecodedInst());
+      DecodedInst &D = insts.back();
+      D.Address = Address;
+      D.Size = 0;
+      D.Status = getInstruction(D.Inst, D.Size, region, Address, vStream,
+                                cStream);
+      if (D.Status == Fail) {
+        ++NumFailed;
+        if (D.Size == 0)
+          D.Size = 1;
+      }
+      Address += D.Size;
+    }
+    return NumFailed;
+  }
 private:
   MCContext &Ctx;
 
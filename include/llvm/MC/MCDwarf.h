@@ -16,6 +16,7 @@
 #define LLVM_MC_MCDWARF_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/MapVector.h"
@@ -30,6 +31,7 @@
 namespace llvm {
 class MCAsmBackend;
 class MCContext;
+class MCFragment;
 class MCSection;
 class MCStreamer;
 class MCSymbol;
@@ -130,8 +132,14 @@ public:
 /// instruction is assembled and uses an address from a temporary label
 /// created at the current address in the current section and the info from
 /// the last .loc directive seen as stored in the context.
+///
+/// An entry in the same data fragment as the previous entry of its section
+/// has no label: the distance between them is fixed once the instructions
+/// are encoded, so the entry only records it as AddrDelta.  Most entries of
+/// a -g build are of this kind, which saves a temporary symbol each.
 class MCLineEntry : public MCDwarfLoc {
   MCSymbol *Label;
+  uint64_t AddrDelta;
 
 private:
   // Allow the default copy constructor and assignment operator to be used
@@ -140,13 +148,24 @@ private:
 public:
   // Constructor to create an MCLineEntry given a symbol and the dwarf loc.
   MCLineEntry(MCSymbol *label, const MCDwarfLoc loc)
-      : MCDwarfLoc(loc), Label(label) {}
+      : MCDwarfLoc(loc), Label(label), AddrDelta(0) {}
 
+  // Constructor to create an MCLineEntry AddrDelta bytes after the previous
+  // entry of its section.
+  MCLineEntry(uint64_t addrDelta, const MCDwarfLoc loc)
+      : MCDwarfLoc(loc), Label(nullptr), AddrDelta(addrDelta) {}
+
+  /// getLabel - The label at the entry's address, or null if it has none.
   MCSymbol *getLabel() const { return Label; }
 
+  /// getAddrDelta - The distance from the previous entry, for an entry
+  /// without a label.
+  uint64_t getAddrDelta() const { return AddrDelta; }
+
   // This is called when an instruction is assembled into the specified
   // section and if there is information from the last .loc directive that
-  // has yet to have a line entry made for it is made.
+  // has yet to have a line entry made for it is made.  The entry only gets a
+  // label when MCLineSection::tryAddLineEntry cannot place it.
   static void Make(MCStreamer *MCOS, const MCSection *Section);
 };
 
@@ -155,10 +174,45 @@ public:
 /// .loc directives.  This is the information used to build the dwarf line
 /// table for a section.
 class MCLineSection {
+  // Where the last entry of each section is, if it is known.
+  struct EntryPosition {
+    const MCFragment *Fragment;
+    uint64_t Offset;
+  };
+  DenseMap<const MCSection *, EntryPosition> LastPositions;
+
 public:
   // addLineEntry - adds an entry to this MCLineSection's line entries
   void addLineEntry(const MCLineEntry &LineEntry, const MCSection *Sec) {
     MCLineDivisions[Sec].push_back(LineEntry);
+    LastPositions.erase(Sec);
+  }
+
+  // addLineEntry - adds an entry with a label at Offset bytes into Fragment,
+  // a data fragment of Sec, so that the entries after it in the same
+  // fragment can do without one.
+  void addLineEntry(const MCLineEntry &LineEntry, const MCSection *Sec,
+                    const MCFragment *Fragment, uint64_t Offset) {
+    MCLineDivisions[Sec].push_back(LineEntry);
+    EntryPosition &Pos = LastPositions[Sec];
+    Pos.Fragment = Fragment;
+    Pos.Offset = Offset;
+  }
+
+  // tryAddLineEntry - if the last entry of Sec is also in Fragment, a data
+  // fragment, adds an entry for Loc at Offset bytes into it without a label
+  // and returns true.  Otherwise the caller needs a label for the entry.
+  bool tryAddLineEntry(const MCDwarfLoc &Loc, const MCSection *Sec,
+                       const MCFragment *Fragment, uint64_t Offset) {
+    DenseMap<const MCSection *, EntryPosition>::iterator I =
+        LastPositions.find(Sec);
+    if (I == LastPositions.end() || I->second.Fragment != Fragment ||
+        I->second.Offset > Offset)
+      return false;
+    MCLineDivisions[Sec].push_back(
+        MCLineEntry(Offset - I->second.Offset, Loc));
+    I->second.Offset = Offset;
+    return true;
   }
 
   typedef std::vector<MCLineEntry> MCLineEntryCollection;
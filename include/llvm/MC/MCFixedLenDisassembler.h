@@ -11,6 +11,9 @@
 #ifndef LLVM_MC_MCFIXEDLENDISASSEMBLER_H
 #define LLVM_MC_MCFIXEDLENDISASSEMBLER_H
 
+#include "llvm/Support/DataTypes.h"
+#include <vector>
+
 namespace llvm {
 
 namespace MCD {
@@ -26,6 +29,79 @@ enum DecoderOps {
   OPC_Fail              // OPC_Fail()
 };
 
+/// \brief A precomputed dispatch table for the first decision of a TableGen
+/// decoder table.
+///
+/// Decoder tables typically start with an OPC_ExtractField followed by a
+/// long chain of OPC_FilterValue entries, one per value of the field, which
+/// the decoder interprets linearly for every instruction.  DecoderIndex
+/// resolves that chain once into a table indexed by the field value, so
+/// decodeInstruction can start interpreting directly at the matching entry
+/// (or at the fallback following the chain) with a single lookup.
+class DecoderIndex {
+  const uint8_t *Table;
+  unsigned Start, Len;
+  /// Offsets into Table, indexed by field value; empty if the table does not
+  /// start with a chain this can resolve.
+  std::vector<uint32_t> Targets;
+
+  static uint64_t readULEB128(const uint8_t *&Ptr) {
+    uint64_t Value = 0;
+    unsigned Shift = 0;
+    uint8_t Byte;
+    do {
+      Byte = *Ptr++;
+      Value |= uint64_t(Byte & 0x7f) << Shift;
+      Shift += 7;
+    } while (Byte & 0x80);
+    return Value;
+  }
+
+public:
+  /// Fields wider than this are left to the interpreter.
+  enum { MaxFieldBits = 16 };
+
+  explicit DecoderIndex(const uint8_t *Table)
+    : Table(Table), Start(0), Len(0) {
+    const uint8_t *Ptr = Table;
+    if (*Ptr != OPC_ExtractField || Ptr[2] > MaxFieldBits)
+      return;
+    Start = Ptr[1];
+    Len = Ptr[2];
+    Ptr += 3;
+
+    std::vector<uint32_t> Found(1U << Len, 0);
+    while (*Ptr == OPC_FilterValue) {
+      ++Ptr;
+      uint64_t Val = readULEB128(Ptr);
+      unsigned NumToSkip = *Ptr++;
+      NumToSkip |= (*Ptr++) << 8;
+      // The first matching filter wins, as in the interpreter.
+      if (Val < Found.size() && !Found[Val])
+        Found[Val] = Ptr - Table;
+      Ptr += NumToSkip;
+    }
+    uint32_t Fallback = Ptr - Table;
+    for (unsigned i = 0, e = Found.size(); i != e; ++i)
+      if (!Found[i])
+        Found[i] = Fallback;
+    Targets.swap(Found);
+  }
+
+  /// \brief Whether the table starts with a chain that was resolved.
+  bool isValid() const { return !Targets.empty(); }
+
+  /// \brief Return the position in the decoder table at which to continue
+  /// decoding \p Insn, or the start of the table if the index is not valid.
+  template <typename InsnType>
+  const uint8_t *lookup(InsnType Insn) const {
+    if (Targets.empty())
+      return Table;
+    uint64_t Field = (uint64_t(Insn) >> Start) & ((uint64_t(1) << Len) - 1);
+    return Table + Targets[Field];
+  }
+};
+
 } // namespace MCDecode
 } // namespace llvm
 
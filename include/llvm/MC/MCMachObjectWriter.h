@@ -15,7 +15,9 @@
 #include "llvm/MC/MCExpr.h"
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/MachO.h"
+#include <memory>
 #include <vector>
 
 namespace llvm {
@@ -110,11 +112,36 @@ class MachObjectWriter : public MCObjectWriter {
   std::vector<MachSymbolData> UndefinedSymbolData;
 
   /// @}
+  /// @name Direct Output
+  /// @{
+
+  /// The stream to point at the mapped output file, or null to write to the
+  /// stream the writer was created with as usual.
+  raw_buffer_ostream *DirectOS;
+  std::string DirectOutputPath;
+  std::unique_ptr<FileOutputBuffer> DirectOutput;
+
+  /// @}
 
 public:
   MachObjectWriter(MCMachObjectTargetWriter *MOTW, raw_ostream &_OS,
                    bool _IsLittleEndian)
-    : MCObjectWriter(_OS, _IsLittleEndian), TargetObjectWriter(MOTW) {
+    : MCObjectWriter(_OS, _IsLittleEndian), TargetObjectWriter(MOTW),
+      DirectOS(0) {
+  }
+
+  /// \brief Create a writer which writes the object straight into a mapped
+  /// \p OutputPath instead of through a buffered stream.
+  ///
+  /// WriteObject computes the final file size first, creates a
+  /// FileOutputBuffer of that size and points \p BOS at it, so the header,
+  /// the section contents, the relocations and the symbol table are each
+  /// copied once into the mapping.  The file is committed by
+  /// commitDirectOutput.
+  MachObjectWriter(MCMachObjectTargetWriter *MOTW, raw_buffer_ostream &BOS,
+                   StringRef OutputPath, bool _IsLittleEndian)
+    : MCObjectWriter(BOS, _IsLittleEndian), TargetObjectWriter(MOTW),
+      DirectOS(&BOS), DirectOutputPath(OutputPath) {
   }
 
   /// @name Lifetime management Methods
@@ -257,6 +284,19 @@ public:
                                               bool InSet,
                                               bool IsPCRel) const override;
 
+  /// ComputeObjectSize - Compute the size of the file WriteObject produces for
+  /// the given layout, once post-layout binding has run.
+  uint64_t ComputeObjectSize(const MCAssembler &Asm,
+                             const MCAsmLayout &Layout) const;
+
+  /// Map the output file for a writer created for direct output and point its
+  /// stream at it.
+  error_code createDirectOutput(uint64_t Size);
+
+  /// Commit the output file of a writer created for direct output. This is a
+  /// no-op for writers which write to a stream.
+  error_code commitDirectOutput();
+
   void WriteObject(MCAssembler &Asm, const MCAsmLayout &Layout) override;
 };
 
@@ -271,6 +311,16 @@ public:
 MCObjectWriter *createMachObjectWriter(MCMachObjectTargetWriter *MOTW,
                                        raw_ostream &OS, bool IsLittleEndian);
 
+/// \brief Construct a new Mach-O writer instance which writes straight into
+/// the mapped file \p OutputPath.
+///
+/// \param BOS - The stream the writer writes through; it must outlive the
+/// writer and is pointed at the mapping once the object size is known.
+MCObjectWriter *createMachObjectFileWriter(MCMachObjectTargetWriter *MOTW,
+                                           raw_buffer_ostream &BOS,
+                                           StringRef OutputPath,
+                                           bool IsLittleEndian);
+
 } // End llvm namespace
 
 #endif
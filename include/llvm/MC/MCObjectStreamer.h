@@ -37,6 +37,11 @@ class MCObjectStreamer : public MCStreamer {
   MCSectionData::iterator CurInsertionPoint;
 
   virtual void EmitInstToData(const MCInst &Inst, const MCSubtargetInfo&) = 0;
+  /// Encode a run of instructions into the current data fragment with a
+  /// single lookup of the fragment, falling back to EmitInstruction for
+  /// instructions that may need relaxation or bundle padding.
+  void EmitInstructionsToData(ArrayRef<MCInst> Insts,
+                              const MCSubtargetInfo &STI);
   void EmitCFIStartProcImpl(MCDwarfFrameInfo &Frame) override;
   void EmitCFIEndProcImpl(MCDwarfFrameInfo &Frame) override;
 
@@ -72,6 +77,13 @@ protected:
 
   const MCExpr *AddValueSymbols(const MCExpr *Value);
 
+  /// Whether EmitInstructions may encode a run of instructions without
+  /// calling EmitInstruction for each of them.  This is false by default,
+  /// since the batched path would bypass an override of EmitInstruction,
+  /// such as one that emits mapping symbols; a streamer that does not
+  /// override EmitInstruction returns true to get the batched path.
+  virtual bool canEmitInstructionsToData() const { return false; }
+
 public:
   MCAssembler &getAssembler() { return *Assembler; }
 
@@ -89,6 +101,17 @@ public:
                      const MCExpr *Subsection) override;
   void EmitInstruction(const MCInst &Inst, const MCSubtargetInfo& STI) override;
 
+  /// \brief Encode a run of instructions straight into the current data
+  /// fragment if canEmitInstructionsToData(), and otherwise emit each of
+  /// them through EmitInstruction.
+  void EmitInstructions(ArrayRef<MCInst> Insts,
+                        const MCSubtargetInfo &STI) override {
+    if (canEmitInstructionsToData())
+      EmitInstructionsToData(Insts, STI);
+    else
+      MCStreamer::EmitInstructions(Insts, STI);
+  }
+
   /// \brief Emit an instruction to a special fragment, because this instruction
   /// can change its size during relaxation.
   virtual void EmitInstToFragment(const MCInst &Inst, const MCSubtargetInfo &);
@@ -110,6 +133,9 @@ public:
   void EmitDwarfAdvanceLineAddr(int64_t LineDelta, const MCSymbol *LastLabel,
                                 const MCSymbol *Label,
                                 unsigned PointerSize) override;
+  void EmitDwarfAdvanceLineAddr(int64_t LineDelta, const MCSymbol *LastLabel,
+                                const MCSymbol *Label, uint64_t AddrBias,
+                                unsigned PointerSize) override;
   void EmitDwarfAdvanceFrameAddr(const MCSymbol *LastLabel,
                                  const MCSymbol *Label) override;
   void EmitGPRel32Value(const MCExpr *Value) override;
@@ -0,0 +1,70 @@
+//===--- llvm/MC/MCSchedThroughput.h - Machine model throughput -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a helper that predicts, from a subtarget's machine model,
+// how many cycles an iteration of a loop body takes in the steady state, so
+// that a machine model can be checked against measurements on hardware.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_MC_MCSCHEDTHROUGHPUT_H
+#define LLVM_MC_MCSCHEDTHROUGHPUT_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/MC/MCSchedule.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include <algorithm>
+
+namespace llvm {
+
+/// \brief Predict the cycles per iteration of a loop whose body is the
+/// instructions of the scheduling classes \p SchedClasses, in order.
+///
+/// The result is the larger of the issue bound, the body's micro-ops over
+/// the model's IssueWidth, and the pressure on the busiest processor
+/// resource, its cycles over its number of units.  Dependency chains
+/// through the loop are not modeled, so for a microbenchmark that is not
+/// latency bound, the cycles measured on hardware should match this.
+///
+/// \returns a negative value if the subtarget has no per-operand machine
+/// model or a class is invalid or variant; variant classes must be resolved
+/// by the target before calling this.
+inline double predictLoopThroughput(const MCSubtargetInfo &STI,
+                                    ArrayRef<unsigned> SchedClasses) {
+  const MCSchedModel *SM = STI.getSchedModel();
+  if (!SM->hasInstrSchedModel())
+    return -1.0;
+
+  SmallVector<unsigned, 32> ResourceCycles(SM->getNumProcResourceKinds());
+  unsigned MicroOps = 0;
+  for (unsigned I = 0, E = SchedClasses.size(); I != E; ++I) {
+    const MCSchedClassDesc *SC = SM->getSchedClassDesc(SchedClasses[I]);
+    if (!SC->isValid() || SC->isVariant())
+      return -1.0;
+    MicroOps += SC->NumMicroOps;
+    for (const MCWriteProcResEntry *WPR = STI.getWriteProcResBegin(SC),
+                                   *WEnd = STI.getWriteProcResEnd(SC);
+         WPR != WEnd; ++WPR)
+      ResourceCycles[WPR->ProcResourceIdx] += WPR->Cycles;
+  }
+
+  double Cycles = double(MicroOps) / std::max(SM->IssueWidth, 1u);
+  // Resource 0 is the invalid resource.
+  for (unsigned Idx = 1, E = ResourceCycles.size(); Idx != E; ++Idx) {
+    unsigned NumUnits = SM->getProcResource(Idx)->NumUnits;
+    Cycles = std::max(Cycles,
+                      double(ResourceCycles[Idx]) / std::max(NumUnits, 1u));
+  }
+  return Cycles;
+}
+
+} // end namespace llvm
+
+#endif
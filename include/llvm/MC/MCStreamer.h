@@ -657,6 +657,18 @@ public:
                                         const MCSymbol *Label,
                                         unsigned PointerSize) = 0;
 
+  /// EmitDwarfAdvanceLineAddr - Advance the line table by LineDelta lines and
+  /// to Label, from AddrBias bytes past LastLabel, which is where the entries
+  /// without a label since LastLabel left its address.
+  virtual void EmitDwarfAdvanceLineAddr(int64_t LineDelta,
+                                        const MCSymbol *LastLabel,
+                                        const MCSymbol *Label,
+                                        uint64_t AddrBias,
+                                        unsigned PointerSize) {
+    assert(!AddrBias && "streamer does not support biased line advances");
+    EmitDwarfAdvanceLineAddr(LineDelta, LastLabel, Label, PointerSize);
+  }
+
   virtual void EmitDwarfAdvanceFrameAddr(const MCSymbol *LastLabel,
                                          const MCSymbol *Label) {}
 
@@ -706,6 +718,18 @@ public:
   /// section.
   virtual void EmitInstruction(const MCInst &Inst, const MCSubtargetInfo &STI) = 0;
 
+  /// EmitInstructions - Emit each of @p Insts, in order, as by
+  /// EmitInstruction.  Code generators that lower a run of instructions with
+  /// no labels or directives between them can use this to make one virtual
+  /// call per run; object streamers that do not override EmitInstruction
+  /// encode the run straight into the current data fragment.  Overriding
+  /// this must keep the effect of every EmitInstruction override.
+  virtual void EmitInstructions(ArrayRef<MCInst> Insts,
+                                const MCSubtargetInfo &STI) {
+    for (unsigned i = 0, e = Insts.size(); i != e; ++i)
+      EmitInstruction(Insts[i], STI);
+  }
+
   /// \brief Set the bundle alignment mode from now on in the section.
   /// The argument is the power of 2 to which the alignment is set. The
   /// value 0 means turn the bundle alignment off.
@@ -37,7 +37,8 @@ namespace llvm {
     static const MCSection *AbsolutePseudoSection;
 
     /// Name - The name of the symbol.  The referred-to string data is actually
-    /// held by the StringMap that lives in MCContext.
+    /// held by the StringMap that lives in MCContext.  Empty for the unnamed
+    /// temporaries of MCContext::createUnnamedTempSymbol.
     StringRef Name;
 
     /// Section - The section the symbol is defined in. This is null for
@@ -69,6 +70,9 @@ namespace llvm {
     /// getName - Get the symbol name.
     StringRef getName() const { return Name; }
 
+    /// hasName - Check if the symbol has a name; only temporaries do not.
+    bool hasName() const { return !Name.empty(); }
+
     /// @name Accessors
     /// @{
 
@@ -89,6 +89,12 @@ public:
       return StringRef(Data.data() + StartOfFile, getSize());
     }
 
+    /// \return the offset of the member header from the start of the archive,
+    /// as used by the archive symbol table.
+    uint64_t getChildOffset() const {
+      return Data.data() - Parent->getData().data();
+    }
+
     error_code getMemoryBuffer(OwningPtr<MemoryBuffer> &Result,
                                bool FullPath = false) const;
     error_code getMemoryBuffer(std::unique_ptr<MemoryBuffer> &Result,
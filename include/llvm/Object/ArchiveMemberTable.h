@@ -0,0 +1,129 @@
+//===--- ArchiveMemberTable.h - Random access to members --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the ArchiveMemberTable class, which indexes the members
+// of an Archive once so that they can be accessed randomly and processed in
+// parallel without copying their contents.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_ARCHIVEMEMBERTABLE_H
+#define LLVM_OBJECT_ARCHIVEMEMBERTABLE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Object/Archive.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace llvm {
+namespace object {
+
+/// \brief An index of the regular members of an archive.
+///
+/// Building the table walks the member headers once and resolves each
+/// member's name.  Afterwards every member is available by index as
+/// \c StringRef slices of the archive's buffer (which is typically mapped),
+/// so no member contents are ever copied, and the table can be shared
+/// read-only between threads.
+class ArchiveMemberTable {
+public:
+  struct Member {
+    Archive::Child C;
+    /// The resolved member name, pointing into the archive.
+    StringRef Name;
+    /// The member contents, pointing into the archive.
+    StringRef Buffer;
+    /// The offset of the member header from the start of the archive.
+    uint64_t Offset;
+
+    Member(const Archive::Child &C, StringRef Name)
+      : C(C), Name(Name), Buffer(C.getBuffer()), Offset(C.getChildOffset()) {}
+  };
+
+  typedef std::vector<Member>::const_iterator iterator;
+
+private:
+  std::vector<Member> Members;
+
+public:
+  ArchiveMemberTable(const Archive &A, error_code &EC) {
+    for (Archive::child_iterator I = A.child_begin(), E = A.child_end();
+         I != E; ++I) {
+      StringRef Name;
+      if ((EC = I->getName(Name)))
+        return;
+      Members.push_back(Member(*I.operator->(), Name));
+    }
+    EC = error_code::success();
+  }
+
+  unsigned size() const { return Members.size(); }
+  bool empty() const { return Members.empty(); }
+  const Member &operator[](unsigned Index) const { return Members[Index]; }
+  iterator begin() const { return Members.begin(); }
+  iterator end() const { return Members.end(); }
+
+  /// \brief Return the index of the member whose header is at \p Offset, as
+  /// found in the archive symbol table, or -1 if there is none.
+  int getIndexForOffset(uint64_t Offset) const {
+    struct OffsetLess {
+      bool operator()(const Member &M, uint64_t Offset) const {
+        return M.Offset < Offset;
+      }
+    };
+    iterator I = std::lower_bound(Members.begin(), Members.end(), Offset,
+                                  OffsetLess());
+    if (I == Members.end() || I->Offset != Offset)
+      return -1;
+    return I - Members.begin();
+  }
+
+  /// \brief Create a MemoryBuffer for member \p Index that refers to the
+  /// archive's memory instead of copying it.  The caller takes ownership.
+  MemoryBuffer *getMemoryBuffer(unsigned Index) const {
+    return MemoryBuffer::getMemBuffer(Members[Index].Buffer,
+                                      Members[Index].Name,
+                                      /*RequiresNullTerminator=*/false);
+  }
+
+  /// \brief Call \p Fn(Index, Member) for every member, on up to
+  /// \p NumThreads threads of the shared pool (see ThreadPool.h).
+  ///
+  /// Members are handed out one at a time, so uneven member sizes balance
+  /// out.  \p Fn is called concurrently and must be thread-safe; callers
+  /// that need deterministic output should store results by index and emit
+  /// them once this returns.
+  template <typename FnTy>
+  void parallelForEach(unsigned NumThreads, FnTy Fn) const {
+    NumThreads = std::min<unsigned>(NumThreads, Members.size());
+    if (NumThreads > 1) {
+      // Each task takes members until none are left, so no more than
+      // NumThreads of the pool's threads work on the table at once.
+      std::atomic<unsigned> Next(0);
+      TaskGroup Group;
+      for (unsigned T = 0; T != NumThreads; ++T)
+        Group.spawn([&] {
+          for (unsigned I = Next++; I < Members.size(); I = Next++)
+            Fn(I, Members[I]);
+        });
+      return;
+    }
+    for (unsigned I = 0, E = Members.size(); I != E; ++I)
+      Fn(I, Members[I]);
+  }
+};
+
+} // end namespace object
+} // end namespace llvm
+
+#endif
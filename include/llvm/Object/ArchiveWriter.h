@@ -0,0 +1,389 @@
+//===--- ArchiveWriter.h - ar archive file writer ---------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares writeArchive, which writes a BSD-style ar archive with a
+// precomputed "__.SYMDEF SORTED" symbol table covering both native and IR
+// object members, and ArchiveSymbolCache, which lets ranlib and libtool reuse
+// the symbols of members that did not change.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_ARCHIVEWRITER_H
+#define LLVM_OBJECT_ARCHIVEWRITER_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Object/Archive.h"
+#include "llvm/Object/SymbolicFile.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class LLVMContext;
+
+namespace object {
+
+/// \brief A member to be written by writeArchive.
+struct NewArchiveMember {
+  /// The member name, without any directory components.
+  std::string Name;
+  /// The member contents; not owned.
+  StringRef Buffer;
+  sys::TimeValue ModTime;
+  unsigned UID;
+  unsigned GID;
+  unsigned Perms;
+
+  NewArchiveMember(StringRef Name, StringRef Buffer)
+    : Name(Name), Buffer(Buffer), ModTime(sys::TimeValue::PosixZeroTime),
+      UID(0), GID(0), Perms(0644) {}
+};
+
+namespace archive_writer {
+
+/// \brief One entry of the symbol table: a symbol name and the index of the
+/// member defining it.
+typedef std::pair<std::string, unsigned> SymbolEntry;
+
+inline void writeZeros(raw_ostream &OS, unsigned Count) {
+  for (unsigned i = 0; i != Count; ++i)
+    OS << '\0';
+}
+
+inline void writeField(raw_ostream &OS, StringRef Value, unsigned Width) {
+  OS << Value.substr(0, Width);
+  OS.indent(Width - std::min<size_t>(Value.size(), Width));
+}
+
+inline void writeField(raw_ostream &OS, uint64_t Value, unsigned Width,
+                       unsigned Radix = 10) {
+  std::string Str;
+  raw_string_ostream SOS(Str);
+  if (Radix == 8)
+    SOS << format("%o", unsigned(Value));
+  else
+    SOS << Value;
+  writeField(OS, SOS.str(), Width);
+}
+
+/// \brief Whether \p Name has to be stored as a BSD "#1/<len>" long name.
+inline bool needsLongName(StringRef Name) {
+  return Name.size() > 16 || Name.find(' ') != StringRef::npos;
+}
+
+/// \brief The number of name bytes stored in front of the member data for a
+/// BSD long name, padded with NULs so that the data stays 4-byte aligned.
+inline unsigned getLongNameSize(StringRef Name) {
+  return (Name.size() + 4) & ~3U;
+}
+
+/// \brief The size of the member header plus data, excluding the padding to
+/// an even offset.
+inline uint64_t getMemberSize(StringRef Name, uint64_t DataSize) {
+  uint64_t Size = sizeof(ArchiveMemberHeader) + DataSize;
+  if (needsLongName(Name))
+    Size += getLongNameSize(Name);
+  return Size;
+}
+
+inline void writeMemberHeader(raw_ostream &OS, StringRef Name,
+                              const sys::TimeValue &ModTime, unsigned UID,
+                              unsigned GID, unsigned Perms,
+                              uint64_t DataSize) {
+  bool LongName = needsLongName(Name);
+  if (LongName)
+    writeField(OS, "#1/" + utostr(getLongNameSize(Name)), 16);
+  else
+    writeField(OS, Name, 16);
+  writeField(OS, ModTime.toEpochTime(), 12);
+  writeField(OS, UID, 6);
+  writeField(OS, GID, 6);
+  writeField(OS, Perms, 8, /*Radix=*/8);
+  writeField(OS, DataSize + (LongName ? getLongNameSize(Name) : 0), 10);
+  OS << "`\n";
+
+  if (LongName) {
+    OS << Name;
+    writeZeros(OS, getLongNameSize(Name) - Name.size());
+  }
+}
+
+/// \brief Collect the global symbols defined by member \p Index, if it is an
+/// object file or a bitcode file; other members define no symbols.
+inline void collectSymbols(const NewArchiveMember &Member, unsigned Index,
+                           LLVMContext &Context,
+                           std::vector<SymbolEntry> &Symbols) {
+  MemoryBuffer *Buffer = MemoryBuffer::getMemBuffer(
+      Member.Buffer, Member.Name, /*RequiresNullTerminator=*/false);
+  ErrorOr<SymbolicFile *> ObjOrErr = SymbolicFile::createSymbolicFile(
+      Buffer, /*BufferOwned=*/true, sys::fs::file_magic::unknown, &Context);
+  if (!ObjOrErr)
+    return;
+  std::unique_ptr<SymbolicFile> Obj(ObjOrErr.get());
+
+  for (basic_symbol_iterator I = Obj->symbol_begin(), E = Obj->symbol_end();
+       I != E; ++I) {
+    uint32_t Flags = I->getFlags();
+    if (!(Flags & BasicSymbolRef::SF_Global) ||
+        (Flags & (BasicSymbolRef::SF_Undefined | BasicSymbolRef::SF_Common |
+                  BasicSymbolRef::SF_FormatSpecific)))
+      continue;
+    std::string Name;
+    raw_string_ostream NameOS(Name);
+    if (I->printName(NameOS))
+      continue;
+    Symbols.push_back(SymbolEntry(NameOS.str(), Index));
+  }
+}
+
+/// \brief Order the symbol table by name, keeping only the first definition
+/// of each symbol as ranlib does.
+struct SymbolNameLess {
+  bool operator()(const SymbolEntry &A, const SymbolEntry &B) const {
+    return A.first < B.first;
+  }
+};
+struct SymbolNameEqual {
+  bool operator()(const SymbolEntry &A, const SymbolEntry &B) const {
+    return A.first == B.first;
+  }
+};
+
+} // end namespace archive_writer
+
+/// \brief Remembers the symbols defined by archive members, so that writing
+/// an archive again only parses the members that changed.
+///
+/// A member is looked up by name and matches only if its modification time,
+/// size and a hash of its contents are those it had when it was added, so a
+/// member rewritten within the same second is not mistaken for the old one.
+/// Hashing a member is much cheaper than reading its symbols, particularly
+/// for bitcode members.
+class ArchiveSymbolCache {
+  struct Entry {
+    uint64_t ModTime;
+    uint64_t Size;
+    size_t Hash;
+    std::vector<std::string> Symbols;
+  };
+  StringMap<Entry> Entries;
+
+  static size_t getHash(StringRef Buffer) { return hash_value(Buffer); }
+
+public:
+  /// \brief Set \p Symbols to the symbols recorded for \p Member.
+  /// \returns false if \p Member is not in the cache or has changed.
+  bool lookup(const NewArchiveMember &Member,
+              std::vector<std::string> &Symbols) const {
+    StringMap<Entry>::const_iterator I = Entries.find(Member.Name);
+    if (I == Entries.end() ||
+        I->second.ModTime != Member.ModTime.toEpochTime() ||
+        I->second.Size != Member.Buffer.size() ||
+        I->second.Hash != getHash(Member.Buffer))
+      return false;
+    Symbols = I->second.Symbols;
+    return true;
+  }
+
+  /// \brief Record that the member \p Name with contents \p Buffer defines
+  /// \p Symbols, replacing what was recorded for \p Name.
+  void insert(StringRef Name, const sys::TimeValue &ModTime, StringRef Buffer,
+              std::vector<std::string> Symbols) {
+    Entry &E = Entries[Name];
+    E.ModTime = ModTime.toEpochTime();
+    E.Size = Buffer.size();
+    E.Hash = getHash(Buffer);
+    E.Symbols.swap(Symbols);
+  }
+
+  /// \brief Record the members of \p A with the symbols each of them
+  /// defines, as ranlib does before updating an archive in place.
+  ///
+  /// The symbols are read from the members themselves, not from the
+  /// archive's symbol table: that keeps only the first definition of each
+  /// symbol, so a member defining a symbol an earlier member also defines
+  /// would be recorded without it, and lose it from the index once the
+  /// earlier member is removed or replaced.  Native object members are read
+  /// concurrently on the shared ThreadPool; bitcode members are read into
+  /// \p Context on the calling thread.
+  error_code addArchive(const Archive &A, LLVMContext &Context) {
+    using namespace archive_writer;
+
+    std::vector<NewArchiveMember> Members;
+    for (Archive::child_iterator I = A.child_begin(), E = A.child_end();
+         I != E; ++I) {
+      StringRef Name;
+      if (error_code EC = I->getName(Name))
+        return EC;
+      Members.push_back(NewArchiveMember(Name, I->getBuffer()));
+      Members.back().ModTime = I->getLastModified();
+    }
+
+    unsigned NumMembers = Members.size();
+    std::vector<std::vector<SymbolEntry> > MemberSymbols(NumMembers);
+    std::vector<unsigned> Native;
+    for (unsigned i = 0; i != NumMembers; ++i) {
+      if (sys::fs::identify_magic(Members[i].Buffer) ==
+          sys::fs::file_magic::bitcode)
+        collectSymbols(Members[i], i, Context, MemberSymbols[i]);
+      else
+        Native.push_back(i);
+    }
+    parallel_for(0u, unsigned(Native.size()), [&](unsigned i) {
+      collectSymbols(Members[Native[i]], Native[i], Context,
+                     MemberSymbols[Native[i]]);
+    });
+
+    for (unsigned i = 0; i != NumMembers; ++i) {
+      std::vector<std::string> Names;
+      for (unsigned j = 0, e = MemberSymbols[i].size(); j != e; ++j)
+        Names.push_back(MemberSymbols[i][j].first);
+      insert(Members[i].Name, Members[i].ModTime, Members[i].Buffer, Names);
+    }
+    return error_code::success();
+  }
+
+  void clear() { Entries.clear(); }
+};
+
+/// \brief Write an archive containing \p Members to \p OS.
+///
+/// If \p WriteSymtab is true, the archive starts with a "__.SYMDEF SORTED"
+/// member in the format ld64 and cctools ranlib use: a little-endian array
+/// of (string offset, member header offset) pairs sorted by symbol name,
+/// followed by the string table.  The symbols are those of every member that
+/// \c SymbolicFile understands, which includes LLVM bitcode read through
+/// \c IRObjectFile with \p Context, so linkers can resolve symbols against
+/// bitcode members without parsing them.
+///
+/// Native object members are read concurrently on the shared ThreadPool;
+/// bitcode members are read on the calling thread, since they are all
+/// loaded into \p Context.  If \p Cache is given, members it knows are not
+/// read at all, and the symbols of the others are added to it.
+inline error_code writeArchive(raw_ostream &OS,
+                               ArrayRef<NewArchiveMember> Members,
+                               bool WriteSymtab, LLVMContext &Context,
+                               ArchiveSymbolCache *Cache = nullptr) {
+  using namespace archive_writer;
+
+  std::vector<SymbolEntry> Symbols;
+  if (WriteSymtab) {
+    unsigned NumMembers = Members.size();
+    std::vector<std::vector<SymbolEntry> > MemberSymbols(NumMembers);
+    std::vector<char> Cached(NumMembers);
+    std::vector<unsigned> Native;
+    for (unsigned i = 0; i != NumMembers; ++i) {
+      std::vector<std::string> Names;
+      if (Cache && Cache->lookup(Members[i], Names)) {
+        Cached[i] = 1;
+        for (unsigned j = 0, e = Names.size(); j != e; ++j)
+          MemberSymbols[i].push_back(SymbolEntry(Names[j], i));
+      } else if (sys::fs::identify_magic(Members[i].Buffer) ==
+                 sys::fs::file_magic::bitcode) {
+        collectSymbols(Members[i], i, Context, MemberSymbols[i]);
+      } else {
+        Native.push_back(i);
+      }
+    }
+    parallel_for(0u, unsigned(Native.size()), [&](unsigned i) {
+      collectSymbols(Members[Native[i]], Native[i], Context,
+                     MemberSymbols[Native[i]]);
+    });
+
+    // Concatenating in member order keeps the first definition of each
+    // symbol first, whichever thread read it.
+    for (unsigned i = 0; i != NumMembers; ++i) {
+      if (Cache && !Cached[i]) {
+        std::vector<std::string> Names;
+        for (unsigned j = 0, e = MemberSymbols[i].size(); j != e; ++j)
+          Names.push_back(MemberSymbols[i][j].first);
+        Cache->insert(Members[i].Name, Members[i].ModTime, Members[i].Buffer,
+                      Names);
+      }
+      Symbols.insert(Symbols.end(), MemberSymbols[i].begin(),
+                     MemberSymbols[i].end());
+    }
+    std::stable_sort(Symbols.begin(), Symbols.end(), SymbolNameLess());
+    Symbols.erase(std::unique(Symbols.begin(), Symbols.end(),
+                              SymbolNameEqual()),
+                  Symbols.end());
+  }
+
+  // The symbol table size depends only on the names, so the offsets of all
+  // the members are known before anything is written.
+  const char SymdefName[] = "__.SYMDEF SORTED";
+  uint64_t StringTableSize = 0;
+  for (unsigned i = 0, e = Symbols.size(); i != e; ++i)
+    StringTableSize += Symbols[i].first.size() + 1;
+  StringTableSize = (StringTableSize + 3) & ~uint64_t(3);
+  uint64_t SymtabDataSize = 4 + 8 * Symbols.size() + 4 + StringTableSize;
+
+  uint64_t Offset = 8; // "!<arch>\n"
+  if (WriteSymtab)
+    Offset += (getMemberSize(SymdefName, SymtabDataSize) + 1) & ~uint64_t(1);
+  std::vector<uint64_t> MemberOffsets;
+  for (unsigned i = 0, e = Members.size(); i != e; ++i) {
+    MemberOffsets.push_back(Offset);
+    Offset += (getMemberSize(Members[i].Name, Members[i].Buffer.size()) + 1) &
+              ~uint64_t(1);
+  }
+  if (Offset > UINT32_MAX)
+    return make_error_code(errc::file_too_large);
+
+  OS << "!<arch>\n";
+
+  if (WriteSymtab) {
+    writeMemberHeader(OS, SymdefName, sys::TimeValue::now(), 0, 0, 0644,
+                      SymtabDataSize);
+    support::endian::Writer<support::little> LE(OS);
+    LE.write<uint32_t>(8 * Symbols.size());
+    uint32_t StringOffset = 0;
+    for (unsigned i = 0, e = Symbols.size(); i != e; ++i) {
+      LE.write<uint32_t>(StringOffset);
+      LE.write<uint32_t>(MemberOffsets[Symbols[i].second]);
+      StringOffset += Symbols[i].first.size() + 1;
+    }
+    LE.write<uint32_t>(StringTableSize);
+    for (unsigned i = 0, e = Symbols.size(); i != e; ++i)
+      OS << Symbols[i].first << '\0';
+    writeZeros(OS, StringTableSize - StringOffset);
+    if (getMemberSize(SymdefName, SymtabDataSize) & 1)
+      OS << '\n';
+  }
+
+  for (unsigned i = 0, e = Members.size(); i != e; ++i) {
+    const NewArchiveMember &M = Members[i];
+    writeMemberHeader(OS, M.Name, M.ModTime, M.UID, M.GID, M.Perms,
+                      M.Buffer.size());
+    OS << M.Buffer;
+    if (getMemberSize(M.Name, M.Buffer.size()) & 1)
+      OS << '\n';
+  }
+
+  return error_code::success();
+}
+
+} // end namespace object
+} // end namespace llvm
+
+#endif
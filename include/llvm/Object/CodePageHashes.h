@@ -0,0 +1,209 @@
+//===--- CodePageHashes.h - Mach-O code page hashes -------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the CodePageHashes class, which computes the per-page
+// SHA-1 hashes of a Mach-O code signature's CodeDirectory incrementally and
+// in parallel.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_CODEPAGEHASHES_H
+#define LLVM_OBJECT_CODEPAGEHASHES_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace llvm {
+namespace object {
+
+/// \brief The code slot hashes of a Mach-O CodeDirectory.
+///
+/// Every page of the signed range [0, CodeLimit) gets a SHA-1 hash, in the
+/// order the CodeDirectory stores its code slots.  Next to each hash the
+/// table keeps a cheap 64-bit fingerprint of the page contents.  When the
+/// table of the previous signing of the same file is available (see
+/// \c write and \c read), a page whose fingerprint did not change reuses
+/// its previous SHA-1 hash, so re-signing after a relink only pays for
+/// SHA-1 on the pages that actually changed.  The pages that do need
+/// hashing are spread across the threads of the shared pool (see
+/// ThreadPool.h).
+class CodePageHashes {
+public:
+  struct Digest {
+    uint8_t Bytes[20];
+  };
+
+  enum {
+    /// The page size used by CodeDirectory version 0x20001 and later.
+    DefaultPageSizeLog2 = 12,
+    Magic = 0x53485043, // 'CPHS'
+    Version = 1
+  };
+
+private:
+  struct Page {
+    uint64_t Fingerprint;
+    Digest Hash;
+  };
+
+  unsigned PageSizeLog2;
+  uint64_t CodeLimit;
+  std::vector<Page> Pages;
+
+  /// \brief A fast, word-at-a-time hash used only to detect changed pages.
+  static uint64_t fingerprint(StringRef Data) {
+    const uint64_t Mul = 0x9ddfea08eb382d69ULL;
+    uint64_t H = Data.size() * Mul;
+    const char *P = Data.data();
+    size_t Size = Data.size();
+    for (; Size >= 8; P += 8, Size -= 8) {
+      uint64_t W;
+      std::memcpy(&W, P, 8);
+      H = (H ^ W) * Mul;
+      H ^= H >> 47;
+    }
+    for (; Size; ++P, --Size)
+      H = (H ^ uint8_t(*P)) * Mul;
+    return H ^ (H >> 47);
+  }
+
+  void hashPages(StringRef Data, const CodePageHashes *Previous,
+                 unsigned Begin, unsigned End, unsigned &NumHashed) {
+    NumHashed = 0;
+    for (unsigned i = Begin; i != End; ++i) {
+      StringRef PageData = Data.substr(uint64_t(i) << PageSizeLog2,
+                                       uint64_t(1) << PageSizeLog2);
+      Page &P = Pages[i];
+      P.Fingerprint = fingerprint(PageData);
+      if (Previous && i < Previous->Pages.size() &&
+          Previous->Pages[i].Fingerprint == P.Fingerprint) {
+        P.Hash = Previous->Pages[i].Hash;
+        continue;
+      }
+      SHA1::hash(ArrayRef<uint8_t>(
+                     reinterpret_cast<const uint8_t *>(PageData.data()),
+                     PageData.size()),
+                 P.Hash.Bytes);
+      ++NumHashed;
+    }
+  }
+
+public:
+  explicit CodePageHashes(unsigned PageSizeLog2 = DefaultPageSizeLog2)
+    : PageSizeLog2(PageSizeLog2), CodeLimit(0) {}
+
+  unsigned getPageSizeLog2() const { return PageSizeLog2; }
+  uint64_t getCodeLimit() const { return CodeLimit; }
+  unsigned size() const { return Pages.size(); }
+  const Digest &getHash(unsigned Index) const { return Pages[Index].Hash; }
+
+  /// \brief Compute the hashes of the pages of \p Data, the signed range of
+  /// the file (everything before the code signature).
+  ///
+  /// \param Previous The table from the previous signing of this file, or
+  /// null.  It is ignored if its page size differs.
+  ///
+  /// \param NumThreads The number of chunks to split the pages into, and so
+  /// the maximum number of the shared pool's threads to hash them on.
+  ///
+  /// \returns the number of pages whose SHA-1 hash had to be computed.
+  unsigned compute(StringRef Data, const CodePageHashes *Previous,
+                   unsigned NumThreads = 1) {
+    if (Previous && Previous->PageSizeLog2 != PageSizeLog2)
+      Previous = nullptr;
+
+    CodeLimit = Data.size();
+    uint64_t PageSize = uint64_t(1) << PageSizeLog2;
+    unsigned NumPages = (CodeLimit + PageSize - 1) >> PageSizeLog2;
+    Pages.assign(NumPages, Page());
+
+    NumThreads = std::max(1U, std::min(NumThreads, NumPages));
+    std::vector<unsigned> NumHashed(NumThreads);
+    unsigned Chunk = (NumPages + NumThreads - 1) / NumThreads;
+    if (NumThreads > 1) {
+      TaskGroup Group;
+      for (unsigned T = 0; T != NumThreads; ++T) {
+        unsigned Begin = std::min(NumPages, T * Chunk);
+        unsigned End = std::min(NumPages, Begin + Chunk);
+        Group.spawn([=, &NumHashed] {
+          hashPages(Data, Previous, Begin, End, NumHashed[T]);
+        });
+      }
+    } else {
+      hashPages(Data, Previous, 0, NumPages, NumHashed[0]);
+    }
+
+    unsigned Total = 0;
+    for (unsigned T = 0; T != NumThreads; ++T)
+      Total += NumHashed[T];
+    return Total;
+  }
+
+  /// \brief Copy the hashes to \p Out in CodeDirectory code slot order; \p Out
+  /// must have room for 20 * size() bytes.
+  void writeCodeSlots(uint8_t *Out) const {
+    for (unsigned i = 0, e = Pages.size(); i != e; ++i, Out += 20)
+      std::memcpy(Out, Pages[i].Hash.Bytes, 20);
+  }
+
+  /// \brief Serialize the table, to be kept next to the signed file for the
+  /// next signing.
+  void write(raw_ostream &OS) const {
+    support::endian::Writer<support::little> LE(OS);
+    LE.write<uint32_t>(Magic);
+    LE.write<uint32_t>(Version);
+    LE.write<uint32_t>(PageSizeLog2);
+    LE.write<uint32_t>(Pages.size());
+    LE.write<uint64_t>(CodeLimit);
+    for (unsigned i = 0, e = Pages.size(); i != e; ++i) {
+      LE.write<uint64_t>(Pages[i].Fingerprint);
+      OS.write(reinterpret_cast<const char *>(Pages[i].Hash.Bytes), 20);
+    }
+  }
+
+  /// \brief Read a table written by \c write.
+  ///
+  /// \returns true if \p Data is not a valid table.
+  bool read(StringRef Data) {
+    using namespace support;
+    if (Data.size() < 24)
+      return true;
+    const char *P = Data.data();
+    if (endian::read<uint32_t, little, unaligned>(P) != Magic ||
+        endian::read<uint32_t, little, unaligned>(P + 4) != Version)
+      return true;
+    unsigned PageSize = endian::read<uint32_t, little, unaligned>(P + 8);
+    unsigned NumPages = endian::read<uint32_t, little, unaligned>(P + 12);
+    if ((Data.size() - 24) / 28 < NumPages)
+      return true;
+
+    PageSizeLog2 = PageSize;
+    CodeLimit = endian::read<uint64_t, little, unaligned>(P + 16);
+    Pages.resize(NumPages);
+    P += 24;
+    for (unsigned i = 0; i != NumPages; ++i, P += 28) {
+      Pages[i].Fingerprint = endian::read<uint64_t, little, unaligned>(P);
+      std::memcpy(Pages[i].Hash.Bytes, P + 8, 20);
+    }
+    return false;
+  }
+};
+
+} // end namespace object
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,342 @@
+//===--- DylibExportCache.h - Cross-link dylib export cache -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares DylibExportCache, which keeps the exported symbols of
+// the dylibs a link reads in a file, so that the next link against the same
+// SDK does not parse them again.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_DYLIBEXPORTCACHE_H
+#define LLVM_OBJECT_DYLIBEXPORTCACHE_H
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Object/Binary.h"
+#include "llvm/Object/Error.h"
+#include "llvm/Object/MachO.h"
+#include "llvm/Object/MachOUniversal.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+namespace object {
+
+/// DylibExportCache - The exported symbols of dylibs, keyed by path and
+/// checked against the size and modification time of the file.
+///
+/// A linker driver opens the cache file when it starts, asks it for the
+/// exports of each dylib instead of parsing the dylib, and saves it when the
+/// link is done.  Every link of a test bundle reads the same libSystem and
+/// framework stubs, so after the first link a lookup costs one stat; on
+/// Cygwin, where each process starts slowly and parsing a fat stub means
+/// mapping it, that is most of the cost of loading the SDK.  Links that
+/// run at the same time may drop each other's additions when saving, which
+/// only costs parsing those dylibs again later.
+///
+/// A dylib that re-exports others through LC_REEXPORT_DYLIB, as
+/// libSystem.dylib re-exports libsystem_c.dylib and the rest of
+/// /usr/lib/system, exports their symbols too.  The cache keeps the
+/// re-exported paths with each dylib and looks them up in turn, so each one
+/// is checked against its own file.  Install names are taken relative to the
+/// SDK root given to the constructor and @loader_path to the directory of the
+/// re-exporting dylib; one that starts with @rpath or @executable_path
+/// cannot be resolved without the link, so getExports() then fails with
+/// errc::not_supported and the linker parses that dylib itself.
+class DylibExportCache {
+  enum {
+    Magic = 0x43584544, // 'DEXC'
+    Version = 2
+  };
+
+  struct Entry {
+    uint64_t ModTime;
+    uint64_t Size;
+    std::vector<std::string> Exports;
+    /// The paths of the dylibs this one re-exports.
+    std::vector<std::string> ReExports;
+  };
+
+  std::string CacheFile;
+  Triple::ArchType Arch;
+  std::string SDKRoot;
+  StringMap<Entry> Entries;
+  bool Dirty;
+  unsigned NumHits, NumMisses;
+
+  /// Read the cache file; a missing or malformed one leaves the cache empty.
+  void load() {
+    using namespace support;
+    std::unique_ptr<MemoryBuffer> Buffer;
+    if (MemoryBuffer::getFile(CacheFile, Buffer, -1,
+                              /*RequiresNullTerminator=*/false))
+      return;
+    const unsigned char *D =
+        reinterpret_cast<const unsigned char *>(Buffer->getBufferStart());
+    const unsigned char *End = D + Buffer->getBufferSize();
+    if (End - D < 16 ||
+        endian::readNext<uint32_t, little, unaligned>(D) != Magic ||
+        endian::readNext<uint32_t, little, unaligned>(D) != Version ||
+        endian::readNext<uint32_t, little, unaligned>(D) != unsigned(Arch))
+      return;
+    uint32_t NumEntries = endian::readNext<uint32_t, little, unaligned>(D);
+
+    StringMap<Entry> Loaded;
+    for (uint32_t i = 0; i != NumEntries; ++i) {
+      StringRef Path;
+      Entry E;
+      if (!readString(D, End, Path) || End - D < 20)
+        return;
+      E.ModTime = endian::readNext<uint64_t, little, unaligned>(D);
+      E.Size = endian::readNext<uint64_t, little, unaligned>(D);
+      uint32_t NumExports = endian::readNext<uint32_t, little, unaligned>(D);
+      for (uint32_t j = 0; j != NumExports; ++j) {
+        StringRef Name;
+        if (!readString(D, End, Name))
+          return;
+        E.Exports.push_back(Name);
+      }
+      if (End - D < 4)
+        return;
+      uint32_t NumReExports = endian::readNext<uint32_t, little, unaligned>(D);
+      for (uint32_t j = 0; j != NumReExports; ++j) {
+        StringRef ReExport;
+        if (!readString(D, End, ReExport))
+          return;
+        E.ReExports.push_back(ReExport);
+      }
+      Loaded[Path] = E;
+    }
+    Entries.swap(Loaded);
+  }
+
+  static bool readString(const unsigned char *&D, const unsigned char *End,
+                         StringRef &Result) {
+    using namespace support;
+    if (End - D < 4)
+      return false;
+    uint32_t Size = endian::readNext<uint32_t, little, unaligned>(D);
+    if (uint64_t(End - D) < Size)
+      return false;
+    Result = StringRef(reinterpret_cast<const char *>(D), Size);
+    D += Size;
+    return true;
+  }
+
+  static void writeString(support::endian::Writer<support::little> &LE,
+                          raw_ostream &OS, StringRef Str) {
+    LE.write<uint32_t>(Str.size());
+    OS << Str;
+  }
+
+  /// Resolve the install name \p Name of a dylib that \p Path re-exports.
+  error_code resolveReExport(StringRef Path, StringRef Name,
+                             std::string &Result) const {
+    SmallString<128> Resolved;
+    if (Name.startswith("@loader_path/")) {
+      Resolved = sys::path::parent_path(Path);
+      sys::path::append(Resolved, Name.substr(sizeof("@loader_path/") - 1));
+    } else if (Name.startswith("@")) {
+      return make_error_code(errc::not_supported);
+    } else {
+      Resolved = SDKRoot;
+      sys::path::append(Resolved, Name);
+    }
+    Result = Resolved.str();
+    return error_code::success();
+  }
+
+  /// Add the paths of the dylibs that \p MachO re-exports to \p ReExports.
+  error_code readReExports(StringRef Path, const MachOObjectFile &MachO,
+                           std::vector<std::string> &ReExports) const {
+    using namespace support;
+    unsigned NumCommands = MachO.is64Bit() ? MachO.getHeader64().ncmds
+                                           : MachO.getHeader().ncmds;
+    if (NumCommands == 0)
+      return error_code::success();
+    MachOObjectFile::LoadCommandInfo Command = MachO.getFirstLoadCommandInfo();
+    for (unsigned i = 0;; ++i) {
+      if (Command.C.cmd == MachO::LC_REEXPORT_DYLIB) {
+        if (Command.C.cmdsize < sizeof(MachO::dylib_command))
+          return object_error::parse_failed;
+        // dylib_command::dylib.name is the offset of the install name from
+        // the start of the command.
+        const char *NameOffsetPtr = Command.Ptr + 8;
+        uint32_t NameOffset =
+            MachO.isLittleEndian()
+                ? endian::read<uint32_t, little, unaligned>(NameOffsetPtr)
+                : endian::read<uint32_t, big, unaligned>(NameOffsetPtr);
+        if (NameOffset >= Command.C.cmdsize)
+          return object_error::parse_failed;
+        StringRef Name(Command.Ptr + NameOffset,
+                       Command.C.cmdsize - NameOffset);
+        std::string ReExport;
+        if (error_code EC =
+                resolveReExport(Path, Name.substr(0, Name.find('\0')),
+                                ReExport))
+          return EC;
+        ReExports.push_back(ReExport);
+      }
+      if (i == NumCommands - 1)
+        break;
+      Command = MachO.getNextLoadCommandInfo(Command);
+    }
+    return error_code::success();
+  }
+
+  /// Read the exported symbols of the dylib \p Path and the paths of the
+  /// dylibs it re-exports, taking the slice for the cache's architecture out
+  /// of a universal file.
+  error_code readExports(StringRef Path, Entry &Result) {
+    ErrorOr<Binary *> BinOrErr = createBinary(Path);
+    if (error_code EC = BinOrErr.getError())
+      return EC;
+    std::unique_ptr<Binary> Bin(BinOrErr.get());
+
+    std::unique_ptr<ObjectFile> Slice;
+    ObjectFile *Obj = dyn_cast<ObjectFile>(Bin.get());
+    if (MachOUniversalBinary *Fat = dyn_cast<MachOUniversalBinary>(Bin.get())) {
+      if (error_code EC = Fat->getObjectForArch(Arch, Slice))
+        return EC;
+      Obj = Slice.get();
+    }
+    if (!Obj)
+      return object_error::invalid_file_type;
+
+    for (symbol_iterator I = Obj->symbol_begin(), E = Obj->symbol_end();
+         I != E; ++I) {
+      uint32_t Flags = I->getFlags();
+      if (!(Flags & BasicSymbolRef::SF_Global) ||
+          (Flags & (BasicSymbolRef::SF_Undefined |
+                    BasicSymbolRef::SF_FormatSpecific)))
+        continue;
+      StringRef Name;
+      if (error_code EC = I->getName(Name))
+        return EC;
+      Result.Exports.push_back(Name);
+    }
+    if (const MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(Obj))
+      return readReExports(Path, *MachO, Result.ReExports);
+    return error_code::success();
+  }
+
+  error_code getExports(StringRef Path, std::vector<std::string> &Exports,
+                        StringSet<> &Visited) {
+    if (!Visited.insert(Path))
+      return error_code::success();
+
+    sys::fs::file_status Status;
+    if (error_code EC = sys::fs::status(Path, Status))
+      return EC;
+    uint64_t ModTime = Status.getLastModificationTime().toEpochTime();
+
+    StringMap<Entry>::iterator I = Entries.find(Path);
+    if (I != Entries.end() && I->second.ModTime == ModTime &&
+        I->second.Size == Status.getSize()) {
+      ++NumHits;
+    } else {
+      ++NumMisses;
+      Entry E;
+      E.ModTime = ModTime;
+      E.Size = Status.getSize();
+      if (error_code EC = readExports(Path, E))
+        return EC;
+      Entries[Path] = E;
+      Dirty = true;
+      I = Entries.find(Path);
+    }
+
+    const Entry &Cached = I->second;
+    Exports.insert(Exports.end(), Cached.Exports.begin(), Cached.Exports.end());
+    // Copy the paths, since looking them up can grow Entries.
+    std::vector<std::string> ReExports(Cached.ReExports);
+    for (unsigned i = 0, e = ReExports.size(); i != e; ++i)
+      if (error_code EC = getExports(ReExports[i], Exports, Visited))
+        return EC;
+    return error_code::success();
+  }
+
+  DylibExportCache(const DylibExportCache &) LLVM_DELETED_FUNCTION;
+  void operator=(const DylibExportCache &) LLVM_DELETED_FUNCTION;
+
+public:
+  /// Use the cache file \p CacheFile, which holds the exports of the slices
+  /// for \p Arch; a file written for another architecture is ignored.
+  /// Absolute install names of re-exported dylibs are looked up under
+  /// \p SDKRoot.
+  DylibExportCache(StringRef CacheFile, Triple::ArchType Arch,
+                   StringRef SDKRoot = StringRef())
+    : CacheFile(CacheFile), Arch(Arch), SDKRoot(SDKRoot), Dirty(false),
+      NumHits(0), NumMisses(0) {
+    load();
+  }
+
+  /// Add the names of the symbols the dylib \p Path exports, including
+  /// those of the dylibs it re-exports, to \p Exports, parsing each dylib
+  /// only if it changed since it was cached.
+  error_code getExports(StringRef Path, std::vector<std::string> &Exports) {
+    StringSet<> Visited;
+    return getExports(Path, Exports, Visited);
+  }
+
+  /// Write the cache file if dylibs were parsed since it was read.  The new
+  /// file is written next to the old one and renamed over it, so links
+  /// reading it meanwhile see either version.
+  error_code save() {
+    if (!Dirty)
+      return error_code::success();
+    SmallString<4096> Contents;
+    {
+      raw_svector_ostream OS(Contents);
+      support::endian::Writer<support::little> LE(OS);
+      LE.write<uint32_t>(Magic);
+      LE.write<uint32_t>(Version);
+      LE.write<uint32_t>(Arch);
+      LE.write<uint32_t>(Entries.size());
+      for (StringMap<Entry>::const_iterator I = Entries.begin(),
+                                            E = Entries.end();
+           I != E; ++I) {
+        writeString(LE, OS, I->getKey());
+        LE.write<uint64_t>(I->second.ModTime);
+        LE.write<uint64_t>(I->second.Size);
+        LE.write<uint32_t>(I->second.Exports.size());
+        for (unsigned j = 0, e = I->second.Exports.size(); j != e; ++j)
+          writeString(LE, OS, I->second.Exports[j]);
+        LE.write<uint32_t>(I->second.ReExports.size());
+        for (unsigned j = 0, e = I->second.ReExports.size(); j != e; ++j)
+          writeString(LE, OS, I->second.ReExports[j]);
+      }
+    }
+    if (error_code EC = writeFileAtomically(CacheFile, Contents.str()))
+      return EC;
+    Dirty = false;
+    return error_code::success();
+  }
+
+  unsigned getNumHits() const { return NumHits; }
+  unsigned getNumMisses() const { return NumMisses; }
+};
+
+} // end namespace object
+} // end namespace llvm
+
+#endif
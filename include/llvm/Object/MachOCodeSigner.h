@@ -0,0 +1,209 @@
+//===--- MachOCodeSigner.h - Ad-hoc Mach-O code signing ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares functions that give a linked Mach-O file an ad-hoc code
+// signature, as codesign_allocate followed by ldid -S do, while the linker's
+// output is still mapped in a FileOutputBuffer, so the binary is written
+// once and never read back.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_MACHOCODESIGNER_H
+#define LLVM_OBJECT_MACHOCODESIGNER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Object/CodePageHashes.h"
+#include "llvm/Object/Error.h"
+#include "llvm/Object/MachOLoadCommandEditor.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileOutputBuffer.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/system_error.h"
+#include <cstring>
+
+namespace llvm {
+namespace object {
+
+namespace code_signer {
+
+// From <Security/CSCommonPriv.h>; the signature blobs are big-endian.
+enum {
+  CSMAGIC_REQUIREMENTS = 0xfade0c01,
+  CSMAGIC_CODEDIRECTORY = 0xfade0c02,
+  CSMAGIC_EMBEDDED_SIGNATURE = 0xfade0cc0,
+  CSSLOT_CODEDIRECTORY = 0,
+  CSSLOT_REQUIREMENTS = 2,
+  CS_ADHOC = 0x2,
+  CS_HASHTYPE_SHA1 = 1,
+  CodeDirectoryVersion = 0x20001,
+  /// The size of a version 0x20001 CodeDirectory header.
+  CodeDirectoryHeaderSize = 44,
+  /// The super blob header and its two index entries.
+  SuperBlobHeaderSize = 12 + 2 * 8,
+  /// An empty requirements blob, as ldid writes.
+  RequirementsSize = 12,
+  /// The special slots: the Info.plist hash, left zero, and the
+  /// requirements hash.
+  NumSpecialSlots = 2,
+  HashSize = 20
+};
+
+inline uint64_t getNumCodeSlots(uint64_t CodeLimit) {
+  return (CodeLimit + (1 << CodePageHashes::DefaultPageSizeLog2) - 1) >>
+         CodePageHashes::DefaultPageSizeLog2;
+}
+
+inline uint64_t getCodeDirectorySize(uint64_t CodeLimit,
+                                     StringRef Identifier) {
+  return CodeDirectoryHeaderSize + Identifier.size() + 1 +
+         (NumSpecialSlots + getNumCodeSlots(CodeLimit)) * HashSize;
+}
+
+inline void write32be(uint8_t *P, uint32_t Value) {
+  support::endian::write<uint32_t, support::big, support::unaligned>(
+      P, Value);
+}
+
+} // end namespace code_signer
+
+/// \brief The file offset at which the signature of a file whose contents
+/// end at \p FileEnd is placed.
+inline uint64_t getCodeSignatureOffset(uint64_t FileEnd) {
+  return (FileEnd + 15) & ~uint64_t(15);
+}
+
+/// \brief The size of the ad-hoc signature of a file signed up to
+/// \p CodeLimit with identifier \p Identifier.
+inline uint64_t getAdHocSignatureSize(uint64_t CodeLimit,
+                                      StringRef Identifier) {
+  using namespace code_signer;
+  uint64_t Size = SuperBlobHeaderSize +
+                  getCodeDirectorySize(CodeLimit, Identifier) +
+                  RequirementsSize;
+  return (Size + 15) & ~uint64_t(15);
+}
+
+/// \brief The size a linker must give its output buffer to sign it in place
+/// with signInPlace, when the linked file would end at \p FileEnd.
+inline uint64_t getSignedFileSize(uint64_t FileEnd, StringRef Identifier) {
+  uint64_t Offset = getCodeSignatureOffset(FileEnd);
+  return Offset + getAdHocSignatureSize(Offset, Identifier);
+}
+
+/// \brief Sign the thin Mach-O file at the start of \p Data, whose contents
+/// end at \p FileEnd, with an ad-hoc signature as ldid -S does.
+///
+/// \p Data must have room for getSignedFileSize(FileEnd, Identifier) bytes,
+/// zero past \p FileEnd, and __LINKEDIT must be the last segment of the
+/// file.  The LC_CODE_SIGNATURE command is added or updated and __LINKEDIT
+/// is grown to cover the signature, all within the header padding; then the
+/// pages are hashed on the shared ThreadPool and the signature is written
+/// after them, so the file is only touched through \p Data.
+///
+/// \param Hashes Receives the page hashes, to be kept for the next signing.
+/// \param Previous The page hashes of the previous signing of this file, or
+/// null.  Pages that did not change reuse their hashes.
+///
+/// \returns \c errc::no_buffer_space if the load commands do not fit, and
+/// \c object_error::parse_failed if __LINKEDIT does not end the file.
+inline error_code signInPlace(uint8_t *Data, uint64_t FileEnd,
+                              StringRef Identifier, CodePageHashes &Hashes,
+                              const CodePageHashes *Previous = nullptr) {
+  using namespace code_signer;
+  uint64_t CodeLimit = getCodeSignatureOffset(FileEnd);
+  uint64_t SignatureSize = getAdHocSignatureSize(CodeLimit, Identifier);
+  if (CodeLimit + SignatureSize > UINT32_MAX)
+    return make_error_code(errc::file_too_large);
+
+  error_code EC;
+  MachOLoadCommandEditor Editor(
+      StringRef(reinterpret_cast<const char *>(Data), FileEnd), EC);
+  if (EC)
+    return EC;
+  // __LINKEDIT is grown to cover the signature at the end of the file, which
+  // would overlap any segment that comes after it.
+  if (!Editor.isLastSegment("__LINKEDIT"))
+    return object_error::parse_failed;
+  Editor.setCodeSignature(CodeLimit, SignatureSize);
+  if (!Editor.setSegmentFileEnd("__LINKEDIT", CodeLimit + SignatureSize))
+    return object_error::parse_failed;
+  if (error_code EC = Editor.writeTo(reinterpret_cast<char *>(Data)))
+    return EC;
+
+  // The headers are final now, so the pages can be hashed.  The code
+  // directory only describes 4K pages.
+  if (Hashes.getPageSizeLog2() != CodePageHashes::DefaultPageSizeLog2)
+    Hashes = CodePageHashes();
+  Hashes.compute(StringRef(reinterpret_cast<const char *>(Data), CodeLimit),
+                 Previous, getDefaultThreadCount());
+
+  uint8_t *Sig = Data + CodeLimit;
+  uint32_t CDSize = getCodeDirectorySize(CodeLimit, Identifier);
+  uint32_t CDOffset = SuperBlobHeaderSize;
+  uint32_t ReqOffset = CDOffset + CDSize;
+  std::memset(Sig, 0, SignatureSize);
+
+  write32be(Sig, CSMAGIC_EMBEDDED_SIGNATURE);
+  write32be(Sig + 4, ReqOffset + RequirementsSize);
+  write32be(Sig + 8, 2);
+  write32be(Sig + 12, CSSLOT_CODEDIRECTORY);
+  write32be(Sig + 16, CDOffset);
+  write32be(Sig + 20, CSSLOT_REQUIREMENTS);
+  write32be(Sig + 24, ReqOffset);
+
+  uint8_t *Req = Sig + ReqOffset;
+  write32be(Req, CSMAGIC_REQUIREMENTS);
+  write32be(Req + 4, RequirementsSize);
+
+  uint8_t *CD = Sig + CDOffset;
+  uint32_t IdentOffset = CodeDirectoryHeaderSize;
+  uint32_t HashOffset =
+      IdentOffset + Identifier.size() + 1 + NumSpecialSlots * HashSize;
+  write32be(CD, CSMAGIC_CODEDIRECTORY);
+  write32be(CD + 4, CDSize);
+  write32be(CD + 8, CodeDirectoryVersion);
+  write32be(CD + 12, CS_ADHOC);
+  write32be(CD + 16, HashOffset);
+  write32be(CD + 20, IdentOffset);
+  write32be(CD + 24, NumSpecialSlots);
+  write32be(CD + 28, Hashes.size());
+  write32be(CD + 32, CodeLimit);
+  CD[36] = HashSize;
+  CD[37] = CS_HASHTYPE_SHA1;
+  CD[39] = CodePageHashes::DefaultPageSizeLog2;
+  std::memcpy(CD + IdentOffset, Identifier.data(), Identifier.size());
+
+  // Special slot N is stored N hashes before the code slots.
+  SHA1::SHA1Result ReqHash;
+  SHA1::hash(ArrayRef<uint8_t>(Req, RequirementsSize), ReqHash);
+  std::memcpy(CD + HashOffset - CSSLOT_REQUIREMENTS * HashSize, ReqHash,
+              HashSize);
+  Hashes.writeCodeSlots(CD + HashOffset);
+  return error_code::success();
+}
+
+/// \brief Sign the linked output in \p Buffer, whose contents end at
+/// \p FileEnd, and commit it.  \p Buffer must have been created with
+/// getSignedFileSize(FileEnd, Identifier) bytes.
+inline error_code signAndCommit(FileOutputBuffer &Buffer, uint64_t FileEnd,
+                                StringRef Identifier, CodePageHashes &Hashes,
+                                const CodePageHashes *Previous = nullptr) {
+  if (Buffer.getBufferSize() < getSignedFileSize(FileEnd, Identifier))
+    return make_error_code(errc::no_buffer_space);
+  if (error_code EC = signInPlace(Buffer.getBufferStart(), FileEnd,
+                                  Identifier, Hashes, Previous))
+    return EC;
+  return Buffer.commit();
+}
+
+} // end namespace object
+} // end namespace llvm
+
+#endif
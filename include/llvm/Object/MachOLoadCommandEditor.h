@@ -0,0 +1,479 @@
+//===--- MachOLoadCommandEditor.h - Edit Mach-O load commands ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares MachOLoadCommandEditor, which changes the load commands
+// of a Mach-O file within the padding the linker leaves after them, and
+// editMachOLoadCommands, which applies such edits to a file.  They implement
+// the operations of install_name_tool and the load command part of
+// codesign_allocate without copying the rest of the binary.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_MACHOLOADCOMMANDEDITOR_H
+#define LLVM_OBJECT_MACHOLOADCOMMANDEDITOR_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Object/Error.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileOutputBuffer.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MachO.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+namespace object {
+
+/// MachOLoadCommandEditor - Holds a copy of the load commands of a thin
+/// Mach-O file, which can be changed and then written back over the
+/// original ones.
+///
+/// The load commands may grow into the space between their end and the
+/// start of the first section contents, which ld64 pads for this purpose
+/// (see -headerpad).  Nothing else in the file moves, so the edits that fit
+/// are written in place; those that do not would need the program to be
+/// relinked, as install_name_tool reports too.
+class MachOLoadCommandEditor {
+  bool Is64;
+  bool IsLittleEndian;
+  uint32_t HeaderSize;
+  uint32_t OldCommandsSize;
+  uint64_t CommandSpace;
+  std::vector<std::string> Commands;
+  bool Changed;
+
+  uint32_t read32(const char *P) const {
+    if (IsLittleEndian)
+      return support::endian::read<uint32_t, support::little,
+                                   support::unaligned>(P);
+    return support::endian::read<uint32_t, support::big,
+                                 support::unaligned>(P);
+  }
+  uint64_t read64(const char *P) const {
+    if (IsLittleEndian)
+      return support::endian::read<uint64_t, support::little,
+                                   support::unaligned>(P);
+    return support::endian::read<uint64_t, support::big,
+                                 support::unaligned>(P);
+  }
+  void write32(char *P, uint32_t Value) const {
+    if (IsLittleEndian)
+      support::endian::write<uint32_t, support::little, support::unaligned>(
+          P, Value);
+    else
+      support::endian::write<uint32_t, support::big, support::unaligned>(
+          P, Value);
+  }
+  void write64(char *P, uint64_t Value) const {
+    if (IsLittleEndian)
+      support::endian::write<uint64_t, support::little, support::unaligned>(
+          P, Value);
+    else
+      support::endian::write<uint64_t, support::big, support::unaligned>(
+          P, Value);
+  }
+
+  static bool isDependentDylib(uint32_t Cmd) {
+    return Cmd == MachO::LC_LOAD_DYLIB || Cmd == MachO::LC_LOAD_WEAK_DYLIB ||
+           Cmd == MachO::LC_REEXPORT_DYLIB ||
+           Cmd == MachO::LC_LAZY_LOAD_DYLIB;
+  }
+
+  uint32_t getCmd(const std::string &Command) const {
+    return read32(Command.data());
+  }
+
+  /// The string of \p Command stored at the offset found at \p OffsetField.
+  StringRef getString(const std::string &Command, unsigned OffsetField) const {
+    uint32_t Offset = read32(Command.data() + OffsetField);
+    if (Offset >= Command.size())
+      return StringRef();
+    StringRef Str(Command.data() + Offset, Command.size() - Offset);
+    return Str.substr(0, Str.find('\0'));
+  }
+
+  /// Replace the string of \p Command, which follows its first \p FixedSize
+  /// bytes, by \p Str, NUL-terminated and padded to the pointer size.
+  void setString(std::string &Command, unsigned FixedSize,
+                 unsigned OffsetField, StringRef Str) {
+    unsigned Align = Is64 ? 8 : 4;
+    Command.resize(FixedSize);
+    Command.append(Str.begin(), Str.end());
+    Command.resize((Command.size() + Align) & ~(Align - 1), '\0');
+    write32(&Command[4], Command.size());
+    write32(&Command[OffsetField], FixedSize);
+    Changed = true;
+  }
+
+  std::string makeCommand(uint32_t Cmd, unsigned FixedSize) const {
+    std::string Command(FixedSize, '\0');
+    write32(&Command[0], Cmd);
+    write32(&Command[4], FixedSize);
+    return Command;
+  }
+
+public:
+  /// Read the load commands of the thin Mach-O file \p Data.  \p EC is set
+  /// to \c object_error::invalid_file_type if \p Data is not one.
+  MachOLoadCommandEditor(StringRef Data, error_code &EC)
+    : Is64(false), IsLittleEndian(true), HeaderSize(0), OldCommandsSize(0),
+      CommandSpace(0), Changed(false) {
+    EC = object_error::invalid_file_type;
+    if (Data.size() < sizeof(MachO::mach_header))
+      return;
+    uint32_t Magic = support::endian::read<uint32_t, support::little,
+                                           support::unaligned>(Data.data());
+    if (Magic == MachO::MH_MAGIC || Magic == MachO::MH_MAGIC_64)
+      IsLittleEndian = true;
+    else if (Magic == MachO::MH_CIGAM || Magic == MachO::MH_CIGAM_64)
+      IsLittleEndian = false;
+    else
+      return;
+    Is64 = Magic == MachO::MH_MAGIC_64 || Magic == MachO::MH_CIGAM_64;
+    HeaderSize = Is64 ? sizeof(MachO::mach_header_64)
+                      : sizeof(MachO::mach_header);
+
+    EC = object_error::parse_failed;
+    uint32_t NumCommands = read32(Data.data() + 16);
+    OldCommandsSize = read32(Data.data() + 20);
+    if (uint64_t(HeaderSize) + OldCommandsSize > Data.size())
+      return;
+
+    // The load commands may grow up to the first byte of the file that
+    // holds section contents.
+    uint64_t Limit = Data.size();
+    const char *P = Data.data() + HeaderSize;
+    const char *End = P + OldCommandsSize;
+    for (uint32_t i = 0; i != NumCommands; ++i) {
+      if (End - P < 8)
+        return;
+      uint32_t Cmd = read32(P), CmdSize = read32(P + 4);
+      if (CmdSize < 8 || CmdSize > uint64_t(End - P))
+        return;
+      Commands.push_back(std::string(P, CmdSize));
+
+      if (Cmd == MachO::LC_SEGMENT || Cmd == MachO::LC_SEGMENT_64) {
+        bool Seg64 = Cmd == MachO::LC_SEGMENT_64;
+        unsigned SegSize = Seg64 ? sizeof(MachO::segment_command_64)
+                                 : sizeof(MachO::segment_command);
+        unsigned SectSize = Seg64 ? sizeof(MachO::section_64)
+                                  : sizeof(MachO::section);
+        if (CmdSize < SegSize)
+          return;
+        uint64_t FileOff = Seg64 ? read64(P + 40) : read32(P + 32);
+        uint64_t FileSize = Seg64 ? read64(P + 48) : read32(P + 36);
+        uint32_t NumSects = read32(P + (Seg64 ? 64 : 48));
+        if (FileOff != 0 && FileSize != 0)
+          Limit = std::min(Limit, FileOff);
+        if (uint64_t(NumSects) * SectSize > CmdSize - SegSize)
+          return;
+        for (uint32_t j = 0; j != NumSects; ++j) {
+          const char *S = P + SegSize + j * SectSize;
+          uint64_t Size = Seg64 ? read64(S + 40) : read32(S + 36);
+          uint32_t Offset = read32(S + (Seg64 ? 48 : 40));
+          uint32_t Type = read32(S + (Seg64 ? 64 : 56)) & MachO::SECTION_TYPE;
+          if (Offset == 0 || Size == 0 || Type == MachO::S_ZEROFILL ||
+              Type == MachO::S_GB_ZEROFILL ||
+              Type == MachO::S_THREAD_LOCAL_ZEROFILL)
+            continue;
+          Limit = std::min<uint64_t>(Limit, Offset);
+        }
+      }
+      P += CmdSize;
+    }
+    if (Limit < uint64_t(HeaderSize) + OldCommandsSize)
+      return;
+    CommandSpace = Limit - HeaderSize;
+    EC = error_code::success();
+  }
+
+  bool is64Bit() const { return Is64; }
+
+  /// Whether any of the load commands was changed.
+  bool isChanged() const { return Changed; }
+
+  unsigned getNumCommands() const { return Commands.size(); }
+  StringRef getCommand(unsigned i) const { return Commands[i]; }
+
+  /// The size the load commands have now.
+  uint64_t getCommandsSize() const {
+    uint64_t Size = 0;
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i)
+      Size += Commands[i].size();
+    return Size;
+  }
+
+  /// The size the load commands may grow to without moving anything else.
+  uint64_t getCommandSpace() const { return CommandSpace; }
+
+  bool fitsInPlace() const { return getCommandsSize() <= CommandSpace; }
+
+  /// Set the install name recorded in the LC_ID_DYLIB command of a dylib,
+  /// as install_name_tool -id does.  \returns false if there is none.
+  bool setInstallName(StringRef Name) {
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i)
+      if (getCmd(Commands[i]) == MachO::LC_ID_DYLIB) {
+        setString(Commands[i], sizeof(MachO::dylib_command), 8, Name);
+        return true;
+      }
+    return false;
+  }
+
+  /// Change every dependent library named \p Old to \p New, as
+  /// install_name_tool -change does.  \returns false if there is none.
+  bool changeDependentName(StringRef Old, StringRef New) {
+    bool Found = false;
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i)
+      if (isDependentDylib(getCmd(Commands[i])) &&
+          getString(Commands[i], 8) == Old) {
+        setString(Commands[i], sizeof(MachO::dylib_command), 8, New);
+        Found = true;
+      }
+    return Found;
+  }
+
+  /// Add an LC_RPATH command for \p Path.  \returns false if there is one
+  /// already, which install_name_tool -add_rpath treats as an error.
+  bool addRpath(StringRef Path) {
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i)
+      if (getCmd(Commands[i]) == MachO::LC_RPATH &&
+          getString(Commands[i], 8) == Path)
+        return false;
+    Commands.push_back(makeCommand(MachO::LC_RPATH,
+                                   sizeof(MachO::rpath_command)));
+    setString(Commands.back(), sizeof(MachO::rpath_command), 8, Path);
+    return true;
+  }
+
+  /// Remove the LC_RPATH command for \p Path.  \returns false if there is
+  /// none.
+  bool deleteRpath(StringRef Path) {
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i)
+      if (getCmd(Commands[i]) == MachO::LC_RPATH &&
+          getString(Commands[i], 8) == Path) {
+        Commands.erase(Commands.begin() + i);
+        Changed = true;
+        return true;
+      }
+    return false;
+  }
+
+  /// Change the LC_RPATH command for \p Old to \p New.  \returns false if
+  /// there is none.
+  bool changeRpath(StringRef Old, StringRef New) {
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i)
+      if (getCmd(Commands[i]) == MachO::LC_RPATH &&
+          getString(Commands[i], 8) == Old) {
+        setString(Commands[i], sizeof(MachO::rpath_command), 8, New);
+        return true;
+      }
+    return false;
+  }
+
+  /// Point the LC_CODE_SIGNATURE command at \p DataSize bytes at file
+  /// offset \p DataOff, adding the command if there is none.  Making room
+  /// for the signature at the end of __LINKEDIT is up to the caller.
+  void setCodeSignature(uint32_t DataOff, uint32_t DataSize) {
+    unsigned i = 0, e = Commands.size();
+    while (i != e && getCmd(Commands[i]) != MachO::LC_CODE_SIGNATURE)
+      ++i;
+    if (i == e)
+      Commands.push_back(makeCommand(MachO::LC_CODE_SIGNATURE,
+                                     sizeof(MachO::linkedit_data_command)));
+    write32(&Commands[i][8], DataOff);
+    write32(&Commands[i][12], DataSize);
+    Changed = true;
+  }
+
+  /// \returns true if the segment \p SegName exists and no other segment has
+  /// file contents at or after its file offset, so that it can grow without
+  /// overlapping them.
+  bool isLastSegment(StringRef SegName) const {
+    bool Found = false;
+    uint64_t LastOff = 0, SegOff = 0;
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i) {
+      const std::string &Command = Commands[i];
+      uint32_t Cmd = getCmd(Command);
+      if (Cmd != MachO::LC_SEGMENT && Cmd != MachO::LC_SEGMENT_64)
+        continue;
+      bool Seg64 = Cmd == MachO::LC_SEGMENT_64;
+      uint64_t FileOff = Seg64 ? read64(&Command[40]) : read32(&Command[32]);
+      uint64_t FileSize = Seg64 ? read64(&Command[48]) : read32(&Command[36]);
+      if (StringRef(Command.data() + 8, 16).split('\0').first == SegName) {
+        Found = true;
+        SegOff = FileOff;
+      } else if (FileSize) {
+        LastOff = std::max(LastOff, FileOff);
+      }
+    }
+    return Found && LastOff < SegOff;
+  }
+
+  /// Make the segment \p SegName end at file offset \p FileEnd, growing its
+  /// VM size to cover it, as codesign_allocate does for __LINKEDIT when it
+  /// appends a signature.  \returns false if there is no such segment or it
+  /// starts after \p FileEnd.
+  bool setSegmentFileEnd(StringRef SegName, uint64_t FileEnd) {
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i) {
+      std::string &Command = Commands[i];
+      uint32_t Cmd = getCmd(Command);
+      if ((Cmd != MachO::LC_SEGMENT && Cmd != MachO::LC_SEGMENT_64) ||
+          StringRef(Command.data() + 8, 16).split('\0').first != SegName)
+        continue;
+      bool Seg64 = Cmd == MachO::LC_SEGMENT_64;
+      uint64_t FileOff = Seg64 ? read64(&Command[40]) : read32(&Command[32]);
+      uint64_t VMSize = Seg64 ? read64(&Command[32]) : read32(&Command[28]);
+      if (FileOff > FileEnd)
+        return false;
+      uint64_t FileSize = FileEnd - FileOff;
+      VMSize = std::max(VMSize, (FileSize + 0xfff) & ~uint64_t(0xfff));
+      if (Seg64) {
+        write64(&Command[32], VMSize);
+        write64(&Command[48], FileSize);
+      } else {
+        write32(&Command[28], VMSize);
+        write32(&Command[36], FileSize);
+      }
+      Changed = true;
+      return true;
+    }
+    return false;
+  }
+
+  /// Write the load commands and the header fields describing them over
+  /// those of the file whose contents start at \p Data, clearing what is
+  /// left of the old commands.
+  ///
+  /// \returns \c errc::no_buffer_space, leaving \p Data alone, if the load
+  /// commands no longer fit in place.
+  error_code writeTo(char *Data) const {
+    uint64_t Size = getCommandsSize();
+    if (Size > CommandSpace)
+      return make_error_code(errc::no_buffer_space);
+    write32(Data + 16, Commands.size());
+    write32(Data + 20, Size);
+    char *P = Data + HeaderSize;
+    for (unsigned i = 0, e = Commands.size(); i != e; ++i) {
+      std::memcpy(P, Commands[i].data(), Commands[i].size());
+      P += Commands[i].size();
+    }
+    if (Size < OldCommandsSize)
+      std::memset(P, 0, OldCommandsSize - Size);
+    return error_code::success();
+  }
+};
+
+namespace load_command_editor {
+
+/// Call \p Fn on an editor for each thin file in \p Data, a thin or
+/// universal Mach-O file that may be modified, and write back the slices it
+/// changed.
+template <typename FnTy>
+error_code editSlices(char *Data, uint64_t Size, FnTy &Fn) {
+  std::vector<std::pair<uint64_t, uint64_t> > Slices;
+  uint32_t Magic = 0;
+  if (Size >= 8)
+    Magic = support::endian::read<uint32_t, support::big,
+                                  support::unaligned>(Data);
+  if (Magic == MachO::FAT_MAGIC) {
+    // The fat header and the fat_arch table are always big-endian.
+    uint32_t NumArchs = support::endian::read<uint32_t, support::big,
+                                              support::unaligned>(Data + 4);
+    if (8 + uint64_t(NumArchs) * sizeof(MachO::fat_arch) > Size)
+      return object_error::parse_failed;
+    for (uint32_t i = 0; i != NumArchs; ++i) {
+      const char *Arch = Data + 8 + i * sizeof(MachO::fat_arch);
+      uint32_t Offset = support::endian::read<uint32_t, support::big,
+                                              support::unaligned>(Arch + 8);
+      uint32_t SliceSize = support::endian::read<uint32_t, support::big,
+                                                 support::unaligned>(Arch + 12);
+      if (uint64_t(Offset) + SliceSize > Size)
+        return object_error::parse_failed;
+      Slices.push_back(std::make_pair(Offset, SliceSize));
+    }
+  } else {
+    Slices.push_back(std::make_pair(uint64_t(0), Size));
+  }
+
+  // Check that every slice fits before writing any of them, so that a
+  // failed edit leaves the file unchanged.
+  std::vector<std::unique_ptr<MachOLoadCommandEditor> > Editors;
+  for (unsigned i = 0, e = Slices.size(); i != e; ++i) {
+    error_code EC;
+    Editors.push_back(std::unique_ptr<MachOLoadCommandEditor>(
+        new MachOLoadCommandEditor(
+            StringRef(Data + Slices[i].first, Slices[i].second), EC)));
+    if (EC)
+      return EC;
+    if (error_code EC = Fn(*Editors.back()))
+      return EC;
+    if (!Editors.back()->fitsInPlace())
+      return make_error_code(errc::no_buffer_space);
+  }
+  for (unsigned i = 0, e = Slices.size(); i != e; ++i)
+    if (Editors[i]->isChanged())
+      if (error_code EC = Editors[i]->writeTo(Data + Slices[i].first))
+        return EC;
+  return error_code::success();
+}
+
+} // end namespace load_command_editor
+
+/// \brief Edit the load commands of the thin or universal Mach-O file at
+/// \p InputPath, writing the result to \p OutputPath.
+///
+/// \p Fn is called with a MachOLoadCommandEditor for each thin file and
+/// returns an error_code.  If \p OutputPath is \p InputPath, the file is
+/// mapped and only its load commands are rewritten in place; otherwise the
+/// input is copied once into a mapped output, which keeps the input's
+/// executable bit, and edited there.
+///
+/// \returns \c errc::no_buffer_space if the edited load commands of a slice
+/// do not fit in its header padding, in which case the file at
+/// \p OutputPath is left as it was.
+template <typename FnTy>
+error_code editMachOLoadCommands(StringRef InputPath, StringRef OutputPath,
+                                 FnTy Fn) {
+  if (InputPath == OutputPath) {
+    error_code EC;
+    sys::fs::mapped_file_region Region(InputPath,
+                                       sys::fs::mapped_file_region::readwrite,
+                                       0, 0, EC);
+    if (EC)
+      return EC;
+    return load_command_editor::editSlices(Region.data(), Region.size(), Fn);
+  }
+
+  std::unique_ptr<MemoryBuffer> Input;
+  if (error_code EC = MemoryBuffer::getFile(InputPath, Input, -1,
+                                            /*RequiresNullTerminator=*/false))
+    return EC;
+  std::unique_ptr<FileOutputBuffer> Output;
+  if (error_code EC = FileOutputBuffer::create(
+          OutputPath, Input->getBufferSize(), Output,
+          sys::fs::can_execute(InputPath) ? FileOutputBuffer::F_executable
+                                          : 0))
+    return EC;
+  char *Data = reinterpret_cast<char *>(Output->getBufferStart());
+  std::memcpy(Data, Input->getBufferStart(), Input->getBufferSize());
+  if (error_code EC = load_command_editor::editSlices(
+          Data, Input->getBufferSize(), Fn))
+    return EC;
+  return Output->commit();
+}
+
+} // end namespace object
+} // end namespace llvm
+
+#endif
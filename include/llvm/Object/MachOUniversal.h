@@ -51,6 +51,16 @@ public:
 
     ObjectForArch getNext() const { return ObjectForArch(Parent, Index + 1); }
     uint32_t getCPUType() const { return Header.cputype; }
+    uint32_t getCPUSubType() const { return Header.cpusubtype; }
+    uint32_t getOffset() const { return Header.offset; }
+    uint32_t getSize() const { return Header.size; }
+    /// \brief The log2 of the alignment of the object in the universal binary.
+    uint32_t getAlign() const { return Header.align; }
+
+    /// \brief The raw bytes of the object, pointing into the universal binary.
+    StringRef getData() const {
+      return Parent->getData().substr(Header.offset, Header.size);
+    }
 
     error_code getAsObjectFile(std::unique_ptr<ObjectFile> &Result) const;
   };
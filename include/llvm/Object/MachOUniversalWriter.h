@@ -0,0 +1,226 @@
+//===--- MachOUniversalWriter.h - Write universal binaries ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares functions to create Mach-O universal binaries and to
+// extract slices from them, writing directly into a mapped output file.  They
+// implement the create, extract and thin operations of a lipo tool, and let
+// tools such as strip rewrite every slice of a universal binary.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_MACHOUNIVERSALWRITER_H
+#define LLVM_OBJECT_MACHOUNIVERSALWRITER_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Object/MachOUniversal.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileOutputBuffer.h"
+#include "llvm/Support/MachO.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/system_error.h"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+namespace object {
+
+/// \brief One architecture of a universal binary to be written.
+struct UniversalSlice {
+  /// The contents of the thin Mach-O file; typically a slice of a mapped
+  /// input, which is copied straight into the mapped output.
+  StringRef Data;
+  uint32_t CPUType;
+  uint32_t CPUSubType;
+  /// The log2 of the alignment of the slice in the output.
+  uint32_t Align;
+
+  UniversalSlice() : CPUType(0), CPUSubType(0), Align(0) {}
+
+  /// \brief Create a slice for an object of a universal binary, keeping its
+  /// alignment.
+  explicit UniversalSlice(const MachOUniversalBinary::ObjectForArch &O)
+    : Data(O.getData()), CPUType(O.getCPUType()),
+      CPUSubType(O.getCPUSubType()), Align(O.getAlign()) {}
+};
+
+namespace universal_writer {
+
+/// \brief The log2 of the page size of \p CPUType, which is the alignment
+/// lipo gives its slices so they can be mapped directly.
+inline uint32_t getDefaultAlignment(uint32_t CPUType) {
+  switch (CPUType) {
+  case MachO::CPU_TYPE_ARM:
+  case MachO::CPU_TYPE_ARM64:
+    return 14;
+  default:
+    return 12;
+  }
+}
+
+inline uint64_t alignTo(uint64_t Value, uint32_t Log2Align) {
+  uint64_t Align = uint64_t(1) << Log2Align;
+  return (Value + Align - 1) & ~(Align - 1);
+}
+
+inline error_code writeBuffer(StringRef OutputPath, uint64_t Size,
+                              unsigned Flags,
+                              std::unique_ptr<FileOutputBuffer> &Buffer) {
+  if (Size > UINT32_MAX)
+    return make_error_code(errc::file_too_large);
+  return FileOutputBuffer::create(OutputPath, Size, Buffer, Flags);
+}
+
+} // end namespace universal_writer
+
+/// \brief Describe the thin Mach-O file \p Data as a slice with the default
+/// alignment for its CPU type.
+///
+/// \returns \c object_error::invalid_file_type if \p Data is not a thin
+/// Mach-O file.
+inline error_code getSliceForMachO(StringRef Data, UniversalSlice &Slice) {
+  if (Data.size() < 12)
+    return object_error::invalid_file_type;
+
+  uint32_t Magic = support::endian::read<uint32_t, support::little,
+                                         support::unaligned>(Data.data());
+  uint32_t CPUType, CPUSubType;
+  if (Magic == MachO::MH_MAGIC || Magic == MachO::MH_MAGIC_64) {
+    CPUType = support::endian::read<uint32_t, support::little,
+                                    support::unaligned>(Data.data() + 4);
+    CPUSubType = support::endian::read<uint32_t, support::little,
+                                       support::unaligned>(Data.data() + 8);
+  } else if (Magic == MachO::MH_CIGAM || Magic == MachO::MH_CIGAM_64) {
+    CPUType = support::endian::read<uint32_t, support::big,
+                                    support::unaligned>(Data.data() + 4);
+    CPUSubType = support::endian::read<uint32_t, support::big,
+                                       support::unaligned>(Data.data() + 8);
+  } else {
+    return object_error::invalid_file_type;
+  }
+
+  Slice.Data = Data;
+  Slice.CPUType = CPUType;
+  Slice.CPUSubType = CPUSubType;
+  Slice.Align = universal_writer::getDefaultAlignment(CPUType);
+  return error_code::success();
+}
+
+/// \brief Write a universal binary containing \p Slices to \p OutputPath.
+///
+/// The output is created at its final size through a FileOutputBuffer and
+/// every slice is copied once, straight from its source into the mapped
+/// output at an offset aligned to 2^Align; the gaps are left zero-filled.
+/// If \p Executable is true, the output file is made executable.
+///
+/// \returns \c object_error::parse_failed if two slices have the same CPU
+/// type and subtype, which lipo does not allow either.
+inline error_code writeUniversalBinary(StringRef OutputPath,
+                                       ArrayRef<UniversalSlice> Slices,
+                                       bool Executable = false) {
+  using universal_writer::alignTo;
+  for (unsigned i = 0, e = Slices.size(); i != e; ++i)
+    for (unsigned j = 0; j != i; ++j)
+      if (Slices[i].CPUType == Slices[j].CPUType &&
+          Slices[i].CPUSubType == Slices[j].CPUSubType)
+        return object_error::parse_failed;
+
+  uint64_t Offset = sizeof(MachO::fat_header) +
+                    Slices.size() * sizeof(MachO::fat_arch);
+  std::vector<uint64_t> Offsets;
+  for (unsigned i = 0, e = Slices.size(); i != e; ++i) {
+    Offset = alignTo(Offset, Slices[i].Align);
+    Offsets.push_back(Offset);
+    Offset += Slices[i].Data.size();
+  }
+
+  std::unique_ptr<FileOutputBuffer> Buffer;
+  if (error_code EC = universal_writer::writeBuffer(
+          OutputPath, Offset,
+          Executable ? FileOutputBuffer::F_executable : 0, Buffer))
+    return EC;
+
+  // The fat header and the fat_arch table are always big-endian.
+  uint8_t *Out = Buffer->getBufferStart();
+  support::endian::write<uint32_t, support::big, support::unaligned>(
+      Out, MachO::FAT_MAGIC);
+  support::endian::write<uint32_t, support::big, support::unaligned>(
+      Out + 4, Slices.size());
+  uint8_t *Arch = Out + sizeof(MachO::fat_header);
+  for (unsigned i = 0, e = Slices.size(); i != e; ++i) {
+    const uint32_t Fields[] = { Slices[i].CPUType, Slices[i].CPUSubType,
+                                uint32_t(Offsets[i]),
+                                uint32_t(Slices[i].Data.size()),
+                                Slices[i].Align };
+    for (unsigned f = 0; f != 5; ++f, Arch += 4)
+      support::endian::write<uint32_t, support::big, support::unaligned>(
+          Arch, Fields[f]);
+    std::memcpy(Out + Offsets[i], Slices[i].Data.data(),
+                Slices[i].Data.size());
+  }
+
+  return Buffer->commit();
+}
+
+/// \brief Write to \p OutputPath a universal binary with the slices of \p In,
+/// each replaced by what \p Fn(Object, Out) leaves in the std::string \p Out.
+///
+/// \p Fn returns an error_code and is called for all slices concurrently on
+/// the shared ThreadPool, so it must be thread-safe; each call only sees its
+/// own object, whose data still points into \p In.  The new slices keep the
+/// CPU types, subtypes and alignments of the old ones, in the same order.
+///
+/// \returns the first error returned by \p Fn, in slice order, or that of
+/// writing the output.
+template <typename FnTy>
+error_code rewriteUniversalBinary(const MachOUniversalBinary &In,
+                                  StringRef OutputPath, FnTy Fn,
+                                  bool Executable = false) {
+  std::vector<MachOUniversalBinary::ObjectForArch> Objects;
+  for (MachOUniversalBinary::object_iterator I = In.begin_objects(),
+                                             E = In.end_objects();
+       I != E; ++I)
+    Objects.push_back(*I.operator->());
+
+  unsigned NumObjects = Objects.size();
+  std::vector<std::string> Contents(NumObjects);
+  std::vector<error_code> Errors(NumObjects);
+  parallel_for(0u, NumObjects, [&](unsigned i) {
+    Errors[i] = Fn(Objects[i], Contents[i]);
+  });
+
+  std::vector<UniversalSlice> Slices;
+  for (unsigned i = 0; i != NumObjects; ++i) {
+    if (Errors[i])
+      return Errors[i];
+    Slices.push_back(UniversalSlice(Objects[i]));
+    Slices.back().Data = Contents[i];
+  }
+  return writeUniversalBinary(OutputPath, Slices, Executable);
+}
+
+/// \brief Write the thin Mach-O file \p Data to \p OutputPath, as lipo's
+/// -thin and -extract operations do once they have picked a slice.
+inline error_code writeThinFile(StringRef OutputPath, StringRef Data,
+                                bool Executable = false) {
+  std::unique_ptr<FileOutputBuffer> Buffer;
+  if (error_code EC = universal_writer::writeBuffer(
+          OutputPath, Data.size(),
+          Executable ? FileOutputBuffer::F_executable : 0, Buffer))
+    return EC;
+  std::memcpy(Buffer->getBufferStart(), Data.data(), Data.size());
+  return Buffer->commit();
+}
+
+} // end namespace object
+} // end namespace llvm
+
+#endif
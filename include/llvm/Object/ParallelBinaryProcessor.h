@@ -0,0 +1,165 @@
+//===--- ParallelBinaryProcessor.h - Ordered parallel input -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares processBinariesInOrder, which lets tools like llvm-nm
+// and llvm-objdump open and process their inputs on worker threads while
+// producing exactly the output of a sequential run.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_PARALLELBINARYPROCESSOR_H
+#define LLVM_OBJECT_PARALLELBINARYPROCESSOR_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Object/Binary.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace llvm {
+namespace object {
+
+namespace parallel_binary {
+
+/// \brief The buffered output of processing one input.
+struct InputResult {
+  std::string Out;
+  std::string Err;
+  bool Succeeded;
+  bool Done;
+  InputResult() : Succeeded(false), Done(false) {}
+};
+
+/// \brief Open \p Path and run \p Fn on it, buffering everything it prints.
+template <typename FnTy>
+void processOne(StringRef ToolName, StringRef Path, FnTy &Fn,
+                InputResult &Result) {
+  raw_string_ostream Out(Result.Out), Err(Result.Err);
+  ErrorOr<Binary *> BinaryOrErr = createBinary(Path);
+  if (error_code EC = BinaryOrErr.getError()) {
+    Err << ToolName << ": '" << Path << "': " << EC.message() << ".\n";
+    Result.Succeeded = false;
+  } else {
+    std::unique_ptr<Binary> Bin(BinaryOrErr.get());
+    Result.Succeeded = Fn(Path, *Bin, Out, Err);
+  }
+  Out.flush();
+  Err.flush();
+}
+
+} // end namespace parallel_binary
+
+/// \brief Open each of \p Paths as a Binary (an object file, an archive or a
+/// Mach-O universal binary) and call \p Fn(Path, Binary, Out, Err) on it,
+/// using up to \p NumThreads worker threads.
+///
+/// \p Fn prints to the \c raw_ostreams it is given instead of outs() and
+/// errs(); the output of each input is buffered and written to \p Out and
+/// \p Err in input order as soon as all earlier inputs are done, so the
+/// result is byte-for-byte that of a sequential run.  Workers never run more
+/// than a few inputs ahead of the output, which bounds the memory held by
+/// buffered results.  \p Fn must be thread-safe and returns false on error.
+///
+/// Inputs that cannot be opened are reported as "<tool>: '<path>': <error>."
+/// on \p Err.
+///
+/// \returns true if every input was opened and processed successfully.
+template <typename FnTy>
+bool processBinariesInOrder(StringRef ToolName, ArrayRef<std::string> Paths,
+                            unsigned NumThreads, raw_ostream &Out,
+                            raw_ostream &Err, FnTy Fn) {
+  using parallel_binary::InputResult;
+  unsigned NumInputs = Paths.size();
+  std::vector<InputResult> Results(NumInputs);
+  bool Succeeded = true;
+
+  auto Emit = [&](unsigned I) {
+    Out << Results[I].Out;
+    Err << Results[I].Err;
+    Succeeded &= Results[I].Succeeded;
+    // Release the buffers as soon as they have been written.
+    std::string().swap(Results[I].Out);
+    std::string().swap(Results[I].Err);
+  };
+
+#if LLVM_ENABLE_THREADS
+  NumThreads = std::min(NumThreads, NumInputs);
+  if (NumThreads > 1) {
+    const unsigned Window = 4 * NumThreads;
+    std::mutex Mutex;
+    std::condition_variable Changed;
+    unsigned Next = 0, Emitted = 0;
+
+    auto Worker = [&] {
+      for (;;) {
+        unsigned I;
+        {
+          std::unique_lock<std::mutex> Lock(Mutex);
+          Changed.wait(Lock, [&] {
+            return Next == NumInputs || Next < Emitted + Window;
+          });
+          if (Next == NumInputs)
+            return;
+          I = Next++;
+        }
+        InputResult Result;
+        parallel_binary::processOne(ToolName, Paths[I], Fn, Result);
+        {
+          std::lock_guard<std::mutex> Lock(Mutex);
+          std::swap(Results[I], Result);
+          Results[I].Done = true;
+        }
+        Changed.notify_all();
+      }
+    };
+
+    std::vector<std::thread> Threads;
+    for (unsigned T = 0; T != NumThreads; ++T)
+      Threads.push_back(std::thread(Worker));
+
+    for (unsigned I = 0; I != NumInputs; ++I) {
+      {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        Changed.wait(Lock, [&] { return Results[I].Done; });
+      }
+      Emit(I);
+      {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Emitted = I + 1;
+      }
+      Changed.notify_all();
+    }
+
+    for (unsigned T = 0; T != NumThreads; ++T)
+      Threads[T].join();
+    return Succeeded;
+  }
+#endif
+
+  for (unsigned I = 0; I != NumInputs; ++I) {
+    parallel_binary::processOne(ToolName, Paths[I], Fn, Results[I]);
+    Emit(I);
+  }
+  return Succeeded;
+}
+
+} // end namespace object
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,100 @@
+//===--- OptionLookupTable.h - Hashed option name lookup --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OPTION_OPTIONLOOKUPTABLE_H
+#define LLVM_OPTION_OPTIONLOOKUPTABLE_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Option/OptTable.h"
+#include "llvm/Option/Option.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+namespace opt {
+
+/// \brief Finds the options whose spelling (a prefix followed by the name)
+/// an argument starts with, by hashing instead of searching the table.
+///
+/// OptTable::ParseOneArg binary searches the sorted option table for each
+/// argument and then compares prefixes; with hundreds of -I, -F and -D
+/// arguments per command line, that search dominates parsing.  This table
+/// maps every spelling to the options that have it, so finding the
+/// candidates for an argument costs one hash probe per spelling length up
+/// to the longest spelling, and none at all for lengths no option has.
+class OptionLookupTable {
+public:
+  /// \brief A candidate option: its index in the info table and the length
+  /// of its spelling.
+  typedef std::pair<unsigned, unsigned> Candidate;
+
+private:
+  StringMap<SmallVector<unsigned, 1> > Spellings;
+  /// Whether there is a spelling of each length, up to the longest one.
+  std::vector<bool> HasLength;
+  bool IgnoreCase;
+
+public:
+  /// Index the options in \p Infos, which is the table given to OptTable,
+  /// skipping groups and the special input and unknown options.
+  OptionLookupTable(const OptTable::Info *Infos, unsigned NumInfos,
+                    bool IgnoreCase = false)
+    : IgnoreCase(IgnoreCase) {
+    for (unsigned i = 0; i != NumInfos; ++i) {
+      const OptTable::Info &In = Infos[i];
+      if (In.Kind == Option::GroupClass || In.Kind == Option::InputClass ||
+          In.Kind == Option::UnknownClass || !In.Prefixes)
+        continue;
+      for (const char *const *P = In.Prefixes; *P; ++P) {
+        std::string Spelling = std::string(*P) + In.Name;
+        if (IgnoreCase)
+          Spelling = StringRef(Spelling).lower();
+        Spellings[Spelling].push_back(i);
+        if (HasLength.size() <= Spelling.size())
+          HasLength.resize(Spelling.size() + 1);
+        HasLength[Spelling.size()] = true;
+      }
+    }
+  }
+
+  /// \brief Collect the options \p Arg may be an instance of, longest
+  /// spelling first and in table order for equal spellings, which is the
+  /// order in which ParseOneArg tries them.
+  void lookup(StringRef Arg, SmallVectorImpl<Candidate> &Candidates) const {
+    Candidates.clear();
+    std::string Lowered;
+    if (IgnoreCase) {
+      Lowered = Arg.substr(0, HasLength.size()).lower();
+      Arg = Lowered;
+    }
+    size_t Len = std::min(Arg.size() + 1, HasLength.size());
+    while (Len-- != 0) {
+      if (!HasLength[Len])
+        continue;
+      StringMap<SmallVector<unsigned, 1> >::const_iterator I =
+          Spellings.find(Arg.substr(0, Len));
+      if (I == Spellings.end())
+        continue;
+      for (unsigned j = 0, e = I->second.size(); j != e; ++j)
+        Candidates.push_back(Candidate(I->second[j], Len));
+    }
+  }
+
+  /// \brief The number of distinct spellings.
+  unsigned size() const { return Spellings.size(); }
+};
+
+} // end namespace opt
+} // end namespace llvm
+
+#endif
@@ -20,6 +20,8 @@
 #include "llvm-c/Core.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/CBindingWrapping.h"
+#include "llvm/Support/DataTypes.h"
+#include <atomic>
 
 namespace llvm {
 
@@ -29,15 +31,34 @@ struct PassRegistrationListener;
 /// PassRegistry - This class manages the registration and intitialization of
 /// the pass subsystem as application startup, and assists the PassManager
 /// in resolving pass dependencies.
-/// NOTE: PassRegistry is NOT thread-safe.  If you want to use LLVM on multiple
-/// threads simultaneously, you will need to use a separate PassRegistry on
-/// each thread.
+///
+/// Registration and lookup are thread-safe, so several threads may build
+/// pass managers from the global registry, each for its own LLVMContext.
+/// Registration takes a lock.  Lookups by type identifier, which the pass
+/// managers make for every pass they schedule, are answered without locking
+/// from a small cache once a pass has been looked up.  unregisterPass must
+/// not run concurrently with lookups, which is the case when it is only
+/// called from llvm_shutdown or when a plugin is unloaded.
 class PassRegistry {
   mutable void *pImpl;
   void *getImpl() const;
-   
+
+  enum { NumCachedPasses = 128 };
+
+  /// LookupCache - The PassInfos last looked up by type identifier, indexed
+  /// by a hash of the identifier.  A slot is only trusted if the PassInfo
+  /// it holds has the identifier being looked up.
+  mutable std::atomic<const PassInfo *> LookupCache[NumCachedPasses];
+
+  static unsigned getCacheSlot(const void *TI) {
+    return unsigned((uintptr_t)TI >> 3) % NumCachedPasses;
+  }
+
 public:
-  PassRegistry() : pImpl(nullptr) { }
+  PassRegistry() : pImpl(nullptr) {
+    for (unsigned I = 0; I != NumCachedPasses; ++I)
+      LookupCache[I].store(nullptr, std::memory_order_relaxed);
+  }
   ~PassRegistry();
   
   /// getPassRegistry - Access the global registry object, which is 
@@ -106,7 +106,9 @@ private:
   std::unique_ptr<MemoryBuffer> DataBuffer;
   /// Iterator over the profile data.
   line_iterator Line;
-  /// The current set of counter values.
+  /// The counter values of the current record, parsed from its text.
+  /// readNextRecord points the record's Counts at them, so they are only
+  /// valid until the next record is read.
   std::vector<uint64_t> Counts;
 
   TextInstrProfReader(const TextInstrProfReader &) LLVM_DELETED_FUNCTION;
@@ -134,7 +136,12 @@ class RawInstrProfReader : public InstrProfReader {
 private:
   /// The profile data file contents.
   std::unique_ptr<MemoryBuffer> DataBuffer;
-  /// The current set of counter values.
+  /// The current set of counter values, byte swapped.
+  ///
+  /// This is only filled in when the profile was written with the other
+  /// endianness.  Otherwise readNextRecord points the record's Counts
+  /// directly at the counters in DataBuffer, which MemoryBuffer maps for
+  /// large files, so reading a record does not copy its counters.
   std::vector<uint64_t> Counts;
   struct ProfileData {
     const uint32_t NameSize;
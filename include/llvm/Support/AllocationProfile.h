@@ -0,0 +1,199 @@
+//===- llvm/Support/AllocationProfile.h - Memory held by owner --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines AllocationProfile, which adds up the memory that the
+// BumpPtrAllocators and recyclers of each owner, such as ASTContext,
+// MCContext, SelectionDAG or LLVMContext, hold, and records what each owner
+// held when the process held the most.  On a host with little address space
+// this tells which subsystem to trim for a translation unit that runs out
+// of memory.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_ALLOCATIONPROFILE_H
+#define LLVM_SUPPORT_ALLOCATIONPROFILE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+/// AllocationProfile - The memory held by the allocators of each owner.
+///
+/// Profiling is off until enable() is called, which a tool does for a
+/// command line flag before it creates any owner.  Each owner then charges
+/// its allocators to the AllocationOwner that getOwner() returns for its
+/// name, typically in its constructor:
+///
+/// \code
+///   Allocator.setProfileOwner(AllocationProfile::getOwner("MCContext"));
+/// \endcode
+///
+/// All the owners with the same name, such as the ASTContexts of several
+/// threads, share one AllocationOwner.  While profiling is off getOwner()
+/// returns null, so the allocators report nothing and cost a null check per
+/// slab or recycled node.
+///
+/// Slabs are counted when they are taken from the underlying allocator, so
+/// the bytes of an owner are the address space it uses, not what it asked
+/// for; the recycled bytes are the part of them waiting for reuse.
+class AllocationProfile {
+  class Owner : public AllocationOwner {
+    friend class AllocationProfile;
+
+    AllocationProfile &Profile;
+    std::string Name;
+    size_t Bytes, PeakBytes, BytesAtPeak;
+    size_t RecycledBytes, RecycledBytesAtPeak;
+
+    Owner(AllocationProfile &Profile, StringRef Name)
+      : Profile(Profile), Name(Name), Bytes(0), PeakBytes(0), BytesAtPeak(0),
+        RecycledBytes(0), RecycledBytesAtPeak(0) {}
+
+  public:
+    void noteSlabBytes(ptrdiff_t Delta) override {
+      MutexGuard Guard(Profile.Lock);
+      Bytes += Delta;
+      PeakBytes = std::max(PeakBytes, Bytes);
+      Profile.TotalBytes += Delta;
+      if (Profile.TotalBytes > Profile.PeakTotalBytes)
+        Profile.snapshotPeak();
+    }
+
+    void noteRecycledBytes(ptrdiff_t Delta) override {
+      MutexGuard Guard(Profile.Lock);
+      RecycledBytes += Delta;
+    }
+  };
+
+  sys::Mutex Lock;
+  bool Enabled;
+  /// The owners, by name; never freed, since allocators can outlive the
+  /// printing at exit.
+  std::vector<Owner *> Owners;
+  size_t TotalBytes, PeakTotalBytes;
+
+  AllocationProfile() : Enabled(false), TotalBytes(0), PeakTotalBytes(0) {}
+
+  AllocationProfile(const AllocationProfile &) LLVM_DELETED_FUNCTION;
+  void operator=(const AllocationProfile &) LLVM_DELETED_FUNCTION;
+
+  static AllocationProfile &get() {
+    static AllocationProfile *Profile = new AllocationProfile();
+    return *Profile;
+  }
+
+  /// snapshotPeak - Record what each owner holds as the new peak.  Called
+  /// with Lock held.
+  void snapshotPeak() {
+    PeakTotalBytes = TotalBytes;
+    for (unsigned I = 0, E = Owners.size(); I != E; ++I) {
+      Owners[I]->BytesAtPeak = Owners[I]->Bytes;
+      Owners[I]->RecycledBytesAtPeak = Owners[I]->RecycledBytes;
+    }
+  }
+
+  static void printAtExit() {
+    // errs() may already be destroyed.
+    raw_fd_ostream OS(2, false);
+    print(OS);
+  }
+
+  static bool isLargerAtPeak(const Owner *LHS, const Owner *RHS) {
+    if (LHS->BytesAtPeak != RHS->BytesAtPeak)
+      return LHS->BytesAtPeak > RHS->BytesAtPeak;
+    return LHS->Name < RHS->Name;
+  }
+
+public:
+  /// enable - Start profiling, and print the profile to stderr at exit if
+  /// PrintAtExit is set.
+  static void enable(bool PrintAtExit = true) {
+    AllocationProfile &Profile = get();
+    {
+      MutexGuard Guard(Profile.Lock);
+      if (Profile.Enabled)
+        return;
+      Profile.Enabled = true;
+    }
+    if (PrintAtExit)
+      std::atexit(printAtExit);
+  }
+
+  static bool isEnabled() {
+    AllocationProfile &Profile = get();
+    MutexGuard Guard(Profile.Lock);
+    return Profile.Enabled;
+  }
+
+  /// getOwner - The owner of the allocators of \p Name, or null if
+  /// profiling is off.
+  static AllocationOwner *getOwner(StringRef Name) {
+    AllocationProfile &Profile = get();
+    MutexGuard Guard(Profile.Lock);
+    if (!Profile.Enabled)
+      return nullptr;
+    for (unsigned I = 0, E = Profile.Owners.size(); I != E; ++I)
+      if (Profile.Owners[I]->Name == Name)
+        return Profile.Owners[I];
+    Profile.Owners.push_back(new Owner(Profile, Name));
+    return Profile.Owners.back();
+  }
+
+  /// resetPeaks - Forget the peaks so far, so that the next print() shows
+  /// those of the work since, such as the next translation unit of a batch.
+  static void resetPeaks() {
+    AllocationProfile &Profile = get();
+    MutexGuard Guard(Profile.Lock);
+    for (unsigned I = 0, E = Profile.Owners.size(); I != E; ++I)
+      Profile.Owners[I]->PeakBytes = Profile.Owners[I]->Bytes;
+    Profile.snapshotPeak();
+  }
+
+  /// print - Write the owners, largest at the peak first, with what each
+  /// held at the peak of all of them, its own peak and what it holds now,
+  /// in KB.
+  static void print(raw_ostream &OS) {
+    AllocationProfile &Profile = get();
+    MutexGuard Guard(Profile.Lock);
+    if (!Profile.Enabled)
+      return;
+    std::vector<Owner *> Sorted(Profile.Owners);
+    std::sort(Sorted.begin(), Sorted.end(), isLargerAtPeak);
+
+    OS << "===" << std::string(73, '-') << "===\n"
+       << "                        ... Allocation profile (KB) ...\n"
+       << "===" << std::string(73, '-') << "===\n\n"
+       << format("  Peak of all owners: %u KB, %u KB now\n\n",
+                 unsigned(Profile.PeakTotalBytes >> 10),
+                 unsigned(Profile.TotalBytes >> 10))
+       << "   At peak  Recycled  Own peak       Now  Owner\n";
+    for (unsigned I = 0, E = Sorted.size(); I != E; ++I) {
+      const Owner &O = *Sorted[I];
+      OS << format("%10u%10u%10u%10u  ", unsigned(O.BytesAtPeak >> 10),
+                   unsigned(O.RecycledBytesAtPeak >> 10),
+                   unsigned(O.PeakBytes >> 10), unsigned(O.Bytes >> 10))
+         << O.Name << '\n';
+    }
+    OS << '\n';
+    OS.flush();
+  }
+};
+
+} // end llvm namespace
+
+#endif
@@ -111,6 +111,24 @@ public:
   void PrintStats() const {}
 };
 
+/// \brief What the memory of an allocator is charged to, for profiling.
+///
+/// A BumpPtrAllocatorImpl reports the slabs it takes from and returns to its
+/// underlying allocator, and the recyclers report the memory sitting on
+/// their free lists, to the owner given to their setProfileOwner().  With no
+/// owner, the default, they report nothing.  See AllocationProfile.h.
+class AllocationOwner {
+public:
+  virtual ~AllocationOwner() {}
+
+  /// \brief The allocators of this owner hold \p Bytes more bytes in slabs,
+  /// or fewer if \p Bytes is negative.
+  virtual void noteSlabBytes(ptrdiff_t Bytes) = 0;
+
+  /// \brief \p Bytes more bytes, or fewer, wait on free lists for reuse.
+  virtual void noteRecycledBytes(ptrdiff_t Bytes) = 0;
+};
+
 namespace detail {
 
 // We call out to an external function to actually print the message as the
@@ -145,10 +163,13 @@ public:
                 "allocation.");
 
   BumpPtrAllocatorImpl()
-      : CurPtr(nullptr), End(nullptr), BytesAllocated(0), Allocator() {}
+      : CurPtr(nullptr), End(nullptr), BytesAllocated(0),
+        SlabsPerDoubling(DefaultSlabsPerDoubling), ProfileOwner(nullptr),
+        Allocator() {}
   template <typename T>
   BumpPtrAllocatorImpl(T &&Allocator)
       : CurPtr(nullptr), End(nullptr), BytesAllocated(0),
+        SlabsPerDoubling(DefaultSlabsPerDoubling), ProfileOwner(nullptr),
         Allocator(std::forward<T &&>(Allocator)) {}
 
   // Manually implement a move constructor as we must clear the old allocators
@@ -157,7 +178,8 @@ public:
       : CurPtr(Old.CurPtr), End(Old.End), Slabs(std::move(Old.Slabs)),
         CustomSizedSlabs(std::move(Old.CustomSizedSlabs)),
         BytesAllocated(Old.BytesAllocated),
-        Allocator(std::move(Old.Allocator)) {
+        SlabsPerDoubling(Old.SlabsPerDoubling),
+        ProfileOwner(Old.ProfileOwner), Allocator(std::move(Old.Allocator)) {
     Old.CurPtr = Old.End = nullptr;
     Old.BytesAllocated = 0;
     Old.Slabs.clear();
@@ -176,6 +198,9 @@ public:
     CurPtr = RHS.CurPtr;
     End = RHS.End;
     BytesAllocated = RHS.BytesAllocated;
+    SlabsPerDoubling = RHS.SlabsPerDoubling;
+    // The slabs stay charged to the owner that they were charged to.
+    ProfileOwner = RHS.ProfileOwner;
     Slabs = std::move(RHS.Slabs);
     CustomSizedSlabs = std::move(RHS.CustomSizedSlabs);
     Allocator = std::move(RHS.Allocator);
@@ -235,6 +260,8 @@ public:
     if (PaddedSize > SizeThreshold) {
       void *NewSlab = Allocator.Allocate(PaddedSize, 0);
       CustomSizedSlabs.push_back(std::make_pair(NewSlab, PaddedSize));
+      if (ProfileOwner)
+        ProfileOwner->noteSlabBytes(PaddedSize);
 
       Ptr = alignPtr((char *)NewSlab, Alignment);
       assert((uintptr_t)Ptr + Size <= (uintptr_t)NewSlab + PaddedSize);
@@ -261,6 +288,38 @@ public:
 
   size_t GetNumSlabs() const { return Slabs.size() + CustomSizedSlabs.size(); }
 
+  /// \brief Double the size of the slabs every \p N slabs instead of every
+  /// 128.
+  ///
+  /// A smaller value makes an allocator that grows very large, such as the
+  /// one holding the AST of a unity build, make fewer and larger calls to
+  /// the underlying allocator.  This can only be changed while no slab has
+  /// grown yet, so that the sizes of the existing slabs stay known.
+  void setSlabGrowth(unsigned N) {
+    assert(N > 0 && "Slabs must double after a positive number of slabs");
+    assert(Slabs.size() <= std::min(N, SlabsPerDoubling) &&
+           "Changing the growth of slabs that have already grown");
+    SlabsPerDoubling = N;
+  }
+  unsigned getSlabGrowth() const { return SlabsPerDoubling; }
+
+  /// \brief Charge the slabs of this allocator to \p Owner, or to nothing
+  /// if \p Owner is null.  The slabs already allocated move with the charge.
+  void setProfileOwner(AllocationOwner *Owner) {
+    if (Owner == ProfileOwner)
+      return;
+    ptrdiff_t TotalMemory = getTotalMemory();
+    if (ProfileOwner && TotalMemory)
+      ProfileOwner->noteSlabBytes(-TotalMemory);
+    ProfileOwner = Owner;
+    if (ProfileOwner && TotalMemory)
+      ProfileOwner->noteSlabBytes(TotalMemory);
+  }
+  AllocationOwner *getProfileOwner() const { return ProfileOwner; }
+
+  /// \brief The number of bytes requested from the allocator so far.
+  size_t getBytesAllocated() const { return BytesAllocated; }
+
   size_t getTotalMemory() const {
     size_t TotalMemory = 0;
     for (auto I = Slabs.begin(), E = Slabs.end(); I != E; ++I)
@@ -295,15 +354,24 @@ private:
   /// Used so that we can compute how much space was wasted.
   size_t BytesAllocated;
 
+  enum { DefaultSlabsPerDoubling = 128 };
+
+  /// \brief The number of slabs after which the slab size doubles.
+  unsigned SlabsPerDoubling;
+
+  /// \brief What the slabs are charged to, if anything.
+  AllocationOwner *ProfileOwner;
+
   /// \brief The allocator instance we use to get slabs of memory.
   AllocatorT Allocator;
 
-  static size_t computeSlabSize(unsigned SlabIdx) {
+  size_t computeSlabSize(unsigned SlabIdx) const {
     // Scale the actual allocated slab size based on the number of slabs
-    // allocated. Every 128 slabs allocated, we double the allocated size to
-    // reduce allocation frequency, but saturate at multiplying the slab size by
-    // 2^30.
-    return SlabSize * ((size_t)1 << std::min<size_t>(30, SlabIdx / 128));
+    // allocated. Every SlabsPerDoubling (128 by default) slabs allocated, we
+    // double the allocated size to reduce allocation frequency, but saturate
+    // at multiplying the slab size by 2^30.
+    return SlabSize *
+           ((size_t)1 << std::min<size_t>(30, SlabIdx / SlabsPerDoubling));
   }
 
   /// \brief Allocate a new slab and move the bump pointers over into the new
@@ -313,6 +381,8 @@ private:
 
     void *NewSlab = Allocator.Allocate(AllocatedSlabSize, 0);
     Slabs.push_back(NewSlab);
+    if (ProfileOwner)
+      ProfileOwner->noteSlabBytes(AllocatedSlabSize);
     CurPtr = (char *)(NewSlab);
     End = ((char *)NewSlab) + AllocatedSlabSize;
   }
@@ -320,6 +390,7 @@ private:
   /// \brief Deallocate a sequence of slabs.
   void DeallocateSlabs(SmallVectorImpl<void *>::iterator I,
                        SmallVectorImpl<void *>::iterator E) {
+    ptrdiff_t Freed = 0;
     for (; I != E; ++I) {
       size_t AllocatedSlabSize =
           computeSlabSize(std::distance(Slabs.begin(), I));
@@ -330,11 +401,15 @@ private:
       memset(*I, 0xCD, AllocatedSlabSize);
 #endif
       Allocator.Deallocate(*I, AllocatedSlabSize);
+      Freed += AllocatedSlabSize;
     }
+    if (ProfileOwner && Freed)
+      ProfileOwner->noteSlabBytes(-Freed);
   }
 
   /// \brief Deallocate all memory for custom sized slabs.
   void DeallocateCustomSizedSlabs() {
+    ptrdiff_t Freed = 0;
     for (auto &PtrAndSize : CustomSizedSlabs) {
       void *Ptr = PtrAndSize.first;
       size_t Size = PtrAndSize.second;
@@ -345,7 +420,10 @@ private:
       memset(Ptr, 0xCD, Size);
 #endif
       Allocator.Deallocate(Ptr, Size);
+      Freed += Size;
     }
+    if (ProfileOwner && Freed)
+      ProfileOwner->noteSlabBytes(-Freed);
   }
 
   template <typename T> friend class SpecificBumpPtrAllocator;
@@ -386,7 +464,7 @@ public:
 
     for (auto I = Allocator.Slabs.begin(), E = Allocator.Slabs.end(); I != E;
          ++I) {
-      size_t AllocatedSlabSize = BumpPtrAllocator::computeSlabSize(
+      size_t AllocatedSlabSize = Allocator.computeSlabSize(
           std::distance(Allocator.Slabs.begin(), I));
       char *Begin = alignPtr((char *)*I, alignOf<T>());
       char *End = *I == Allocator.Slabs.back() ? Allocator.CurPtr
@@ -406,6 +484,10 @@ public:
 
   /// \brief Allocate space for an array of objects without constructing them.
   T *Allocate(size_t num = 1) { return Allocator.Allocate<T>(num); }
+
+  void setProfileOwner(AllocationOwner *Owner) {
+    Allocator.setProfileOwner(Owner);
+  }
 };
 
 }  // end namespace llvm
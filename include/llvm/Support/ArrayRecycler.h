@@ -40,6 +40,15 @@ class ArrayRecycler {
   // Keep a free list for each array size.
   SmallVector<FreeList*, 8> Bucket;
 
+  // What the free lists are charged to, if anything, and the bytes on them,
+  // counted only with an owner.
+  AllocationOwner *ProfileOwner;
+  size_t FreeBytes;
+
+  static size_t getBucketBytes(unsigned Idx) {
+    return sizeof(T) << Idx;
+  }
+
   // Remove an entry from the free list in Bucket[Idx] and return it.
   // Return NULL if no entries are available.
   T *pop(unsigned Idx) {
@@ -49,6 +58,10 @@ class ArrayRecycler {
     if (!Entry)
       return nullptr;
     Bucket[Idx] = Entry->Next;
+    if (ProfileOwner) {
+      FreeBytes -= getBucketBytes(Idx);
+      ProfileOwner->noteRecycledBytes(-ptrdiff_t(getBucketBytes(Idx)));
+    }
     return reinterpret_cast<T*>(Entry);
   }
 
@@ -60,6 +73,10 @@ class ArrayRecycler {
       Bucket.resize(size_t(Idx) + 1);
     Entry->Next = Bucket[Idx];
     Bucket[Idx] = Entry;
+    if (ProfileOwner) {
+      FreeBytes += getBucketBytes(Idx);
+      ProfileOwner->noteRecycledBytes(getBucketBytes(Idx));
+    }
   }
 
 public:
@@ -91,6 +108,8 @@ public:
     Capacity getNext() const { return Capacity(Index + 1); }
   };
 
+  ArrayRecycler() : ProfileOwner(nullptr), FreeBytes(0) {}
+
   ~ArrayRecycler() {
     // The client should always call clear() so recycled arrays can be returned
     // to the allocator.
@@ -113,6 +132,16 @@ public:
   /// cache.
   void clear(BumpPtrAllocator&) {
     Bucket.clear();
+    if (ProfileOwner && FreeBytes)
+      ProfileOwner->noteRecycledBytes(-ptrdiff_t(FreeBytes));
+    FreeBytes = 0;
+  }
+
+  /// Charge the arrays waiting on the free lists to Owner. This can only be
+  /// done while the free lists are empty.
+  void setProfileOwner(AllocationOwner *Owner) {
+    assert(Bucket.empty() && "Charging an ArrayRecycler already in use");
+    ProfileOwner = Owner;
   }
 
   /// Allocate an array of at least the requested capacity.
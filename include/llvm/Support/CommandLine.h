@@ -140,16 +140,23 @@ enum MiscFlags {               // Miscellaneous flags to adjust argument
 //===----------------------------------------------------------------------===//
 // Option Category class
 //
+// Like options, categories are usually globals; registering one only links it
+// into a list, so that static constructors neither allocate nor sort.  The
+// sorted set -help prints is built from the list when it is needed.
 class OptionCategory {
 private:
   const char *const Name;
   const char *const Description;
+  OptionCategory *NextRegistered; // Singly linked list of categories.
   void registerCategory();
 public:
   OptionCategory(const char *const Name, const char *const Description = nullptr)
-      : Name(Name), Description(Description) { registerCategory(); }
+      : Name(Name), Description(Description), NextRegistered(nullptr) {
+    registerCategory();
+  }
   const char *getName() const { return Name; }
   const char *getDescription() const { return Description; }
+  OptionCategory *getNextRegisteredCategory() const { return NextRegistered; }
 };
 
 // The general Option Category (used as default category).
@@ -0,0 +1,268 @@
+//===- llvm/Support/CompileWatchdog.h - Compile progress watchdog -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines CompileWatchdog, which tracks the phase, function and
+// pass a compilation is in, reports them periodically while the compilation
+// runs long, and keeps a time budget after which the remaining functions are
+// compiled without optimization instead of running into a build timeout.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_COMPILEWATCHDOG_H
+#define LLVM_SUPPORT_COMPILEWATCHDOG_H
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/Watchdog.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#if LLVM_ENABLE_THREADS
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace llvm {
+
+/// CompileWatchdog - Watches the progress of one compilation.
+///
+/// The compiler marks where it is with CompileProgressScope, naming the
+/// current phase (such as "parse" or "codegen"), function and pass.  Every
+/// \c ReportInterval seconds a monitor thread prints the elapsed time and
+/// the innermost phase, function and pass, so a log shows where a
+/// compilation that hits a CI timeout spent its time.
+///
+/// With a \c Budget, isOverBudget turns true once that many seconds have
+/// passed; the pass managers then compile the remaining functions as if they
+/// were optnone (see degradeIfOverBudget in Transforms/Utils/CompileBudget.h)
+/// rather than fail.  With a \c HardLimit, the monitor thread prints the
+/// progress and aborts the process after that many seconds.
+///
+/// The watchdog must live on the stack of the thread that compiles, like
+/// other PrettyStackTraceEntry objects, so that a crash report of that
+/// thread ends with the progress at the time of the crash.  Without
+/// LLVM_ENABLE_THREADS no periodic reports are printed and the hard limit
+/// falls back to sys::Watchdog: on Unix SIGALRM then ends the process
+/// without a report, and on Windows there is no hard limit at all.  The
+/// budget applies either way.
+class CompileWatchdog : public PrettyStackTraceEntry {
+public:
+  enum ProgressKind { Phase, Function, Pass, NumProgressKinds };
+
+private:
+  enum { SnapshotSize = 256 };
+
+  sys::TimeValue Start;
+  unsigned ReportInterval, Budget, HardLimit;
+  raw_ostream &OS;
+  std::string Progress[NumProgressKinds];
+  bool ReportedOverBudget;
+
+  /// The progress as print() shows it, double-buffered so that the crash
+  /// handler reads a complete copy without taking the lock, which the
+  /// crashing thread may hold.
+  char Snapshot[2][SnapshotSize];
+  std::atomic<unsigned> SnapshotIndex;
+
+#if LLVM_ENABLE_THREADS
+  mutable std::mutex Lock;
+  std::condition_variable StopCondition;
+  bool Stopping;
+  std::thread Monitor;
+
+  void monitor() {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point Now = Clock::now();
+    Clock::time_point NextReport = Now + std::chrono::seconds(ReportInterval);
+    Clock::time_point Deadline = Now + std::chrono::seconds(HardLimit);
+    std::unique_lock<std::mutex> Guard(Lock);
+    while (!Stopping) {
+      Clock::time_point Wake = ReportInterval ? NextReport : Deadline;
+      if (ReportInterval && HardLimit && Deadline < Wake)
+        Wake = Deadline;
+      if (StopCondition.wait_until(Guard, Wake, [this] { return Stopping; }))
+        break;
+      Now = Clock::now();
+      if (HardLimit && Now >= Deadline) {
+        // The crash report only shows the stack trace entries of the thread
+        // that aborts, which is this one, so print the progress first.
+        OS << "watchdog: hard limit of " << HardLimit
+           << "s exceeded; aborting\n";
+        printProgress(OS);
+        abort();
+      }
+      if (ReportInterval && Now >= NextReport) {
+        printProgress(OS);
+        NextReport = Now + std::chrono::seconds(ReportInterval);
+      }
+    }
+  }
+#else
+  std::unique_ptr<sys::Watchdog> HardWatchdog;
+#endif
+
+  static CompileWatchdog *&current() {
+    static CompileWatchdog *Watchdog = nullptr;
+    return Watchdog;
+  }
+
+  /// Print the progress, such as ", phase 'codegen', function 'f'".
+  void printLevels(raw_ostream &Out) const {
+    static const char *const Names[NumProgressKinds] = {
+      "phase", "function", "pass"
+    };
+    for (unsigned K = 0; K != NumProgressKinds; ++K)
+      if (!Progress[K].empty())
+        Out << ", " << Names[K] << " '" << Progress[K] << "'";
+  }
+
+  /// Print the elapsed time and the progress; the caller holds the lock.
+  void printProgress(raw_ostream &Out) const {
+    Out << "watchdog: " << getElapsedSeconds() << "s elapsed";
+    printLevels(Out);
+    Out << '\n';
+    Out.flush();
+  }
+
+  /// Copy the progress to the snapshot print() does not read; the caller
+  /// holds the lock.
+  void updateSnapshot() {
+    unsigned Next = SnapshotIndex.load() ^ 1;
+    SmallString<SnapshotSize> Text;
+    raw_svector_ostream Out(Text);
+    printLevels(Out);
+    Out.flush();
+    size_t Size = std::min<size_t>(Text.size(), SnapshotSize - 1);
+    memcpy(Snapshot[Next], Text.data(), Size);
+    Snapshot[Next][Size] = '\0';
+    SnapshotIndex.store(Next);
+  }
+
+  CompileWatchdog(const CompileWatchdog &) LLVM_DELETED_FUNCTION;
+  void operator=(const CompileWatchdog &) LLVM_DELETED_FUNCTION;
+
+public:
+  /// Start watching.  Any of \p ReportInterval, \p Budget and \p HardLimit,
+  /// all in seconds, may be 0 to disable that part.  Reports go to \p OS,
+  /// which must be unbuffered or only used by this watchdog while it lives.
+  CompileWatchdog(unsigned ReportInterval, unsigned Budget,
+                  unsigned HardLimit = 0, raw_ostream &OS = errs())
+    : Start(sys::TimeValue::now()), ReportInterval(ReportInterval),
+      Budget(Budget), HardLimit(HardLimit), OS(OS), ReportedOverBudget(false),
+      SnapshotIndex(0) {
+    Snapshot[0][0] = Snapshot[1][0] = '\0';
+#if LLVM_ENABLE_THREADS
+    Stopping = false;
+    if (ReportInterval || HardLimit)
+      Monitor = std::thread([this] { monitor(); });
+#else
+    if (HardLimit)
+      HardWatchdog.reset(new sys::Watchdog(HardLimit));
+#endif
+    current() = this;
+  }
+
+  ~CompileWatchdog() {
+    current() = nullptr;
+#if LLVM_ENABLE_THREADS
+    if (Monitor.joinable()) {
+      {
+        std::lock_guard<std::mutex> Guard(Lock);
+        Stopping = true;
+      }
+      StopCondition.notify_all();
+      Monitor.join();
+    }
+#endif
+  }
+
+  /// \brief The watchdog of the running compilation, or null.
+  static CompileWatchdog *get() { return current(); }
+
+  uint64_t getElapsedSeconds() const {
+    return (sys::TimeValue::now() - Start).seconds();
+  }
+
+  /// \brief Set what the compilation is doing at the level \p Kind and
+  /// clear the levels inside it; returns the previous value.
+  std::string setProgress(ProgressKind Kind, StringRef Name) {
+#if LLVM_ENABLE_THREADS
+    std::lock_guard<std::mutex> Guard(Lock);
+#endif
+    std::string Old = Progress[Kind];
+    Progress[Kind] = Name;
+    for (unsigned K = Kind + 1; K != NumProgressKinds; ++K)
+      Progress[K].clear();
+    updateSnapshot();
+    return Old;
+  }
+
+  /// \brief Whether the budget is spent.  The first time it is, this prints
+  /// the progress and that the rest of the compilation is degraded.
+  bool isOverBudget() {
+    if (!Budget || getElapsedSeconds() < Budget)
+      return false;
+    if (!ReportedOverBudget) {
+      ReportedOverBudget = true;
+#if LLVM_ENABLE_THREADS
+      std::lock_guard<std::mutex> Guard(Lock);
+#endif
+      OS << "watchdog: compile time budget of " << Budget
+         << "s exceeded; compiling the remaining functions without "
+            "optimization\n";
+      printProgress(OS);
+    }
+    return true;
+  }
+
+  void print(raw_ostream &Out) const override {
+    // This runs from the crash handler, possibly while the lock is held, so
+    // it reads the snapshot rather than Progress.
+    Out << "watchdog: " << getElapsedSeconds() << "s elapsed"
+        << Snapshot[SnapshotIndex.load()] << '\n';
+  }
+};
+
+/// CompileProgressScope - Marks the installed CompileWatchdog, if any, as
+/// being in the named phase, function or pass for as long as it lives.
+class CompileProgressScope {
+  CompileWatchdog *Watchdog;
+  CompileWatchdog::ProgressKind Kind;
+  std::string Old;
+
+  CompileProgressScope(const CompileProgressScope &) LLVM_DELETED_FUNCTION;
+  void operator=(const CompileProgressScope &) LLVM_DELETED_FUNCTION;
+
+public:
+  CompileProgressScope(CompileWatchdog::ProgressKind Kind, StringRef Name)
+    : Watchdog(CompileWatchdog::get()), Kind(Kind) {
+    if (Watchdog)
+      Old = Watchdog->setProgress(Kind, Name);
+  }
+  ~CompileProgressScope() {
+    if (Watchdog)
+      Watchdog->setProgress(Kind, Old);
+  }
+};
+
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,114 @@
+//===- ConcurrentStringPool.h - Thread-safe string interning ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines ConcurrentStringPool, a string interning table that can
+// be shared by several threads, such as the threads of parallel code
+// generation or of LTO partitions that name the same symbols.
+//
+//   ConcurrentStringPool Pool;
+//   StringRef Name = Pool.intern("_main");
+//
+// Interned strings are never freed before the pool is destroyed, so the
+// returned StringRefs stay valid, and equal strings interned from any thread
+// share the same storage and can be compared by pointer.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_CONCURRENTSTRINGPOOL_H
+#define LLVM_SUPPORT_CONCURRENTSTRINGPOOL_H
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Mutex.h"
+
+namespace llvm {
+
+/// ConcurrentStringPool - A StringMap split into shards, each with its own
+/// lock and allocator.  A string is hashed once, outside of any lock; a
+/// remix of the hash picks the shard and the hash itself is passed on to
+/// the shard's map.  Threads
+/// interning different strings thus rarely wait for one another, unlike
+/// with a single StringMap behind one mutex.
+class ConcurrentStringPool {
+  static const unsigned LogNumShards = 4;
+  static const unsigned NumShards = 1 << LogNumShards;
+
+  struct Shard {
+    sys::Mutex Lock;
+    StringMap<char, BumpPtrAllocator> Strings;
+
+    Shard() : Lock(/*recursive=*/false) {}
+  };
+
+  Shard Shards[NumShards];
+
+  ConcurrentStringPool(const ConcurrentStringPool &) LLVM_DELETED_FUNCTION;
+  void operator=(const ConcurrentStringPool &) LLVM_DELETED_FUNCTION;
+
+  Shard &getShard(unsigned FullHashValue) {
+    // The top bits of HashString are mostly zero for short strings, and its
+    // low bits pick the buckets of the shard's map, so remix the hash
+    // rather than take either.
+    size_t Mixed = hash_value(FullHashValue);
+    return Shards[(Mixed >> 16) & (NumShards - 1)];
+  }
+
+public:
+  ConcurrentStringPool() {}
+
+  /// intern - Return a copy of \p Str that is owned by the pool and is the
+  /// same for every thread that interns an equal string.
+  StringRef intern(StringRef Str) {
+    unsigned FullHashValue = StringMapImpl::hash(Str);
+    Shard &S = getShard(FullHashValue);
+    sys::ScopedLock Guard(S.Lock);
+    return S.Strings.GetOrCreateValueWithHash(Str, FullHashValue, '\0')
+        .getKey();
+  }
+
+  /// lookup - Return the interned copy of \p Str, or a null StringRef if
+  /// it was never interned.
+  StringRef lookup(StringRef Str) {
+    unsigned FullHashValue = StringMapImpl::hash(Str);
+    Shard &S = getShard(FullHashValue);
+    sys::ScopedLock Guard(S.Lock);
+    StringMap<char, BumpPtrAllocator>::iterator I =
+        S.Strings.find(Str, FullHashValue);
+    if (I == S.Strings.end())
+      return StringRef();
+    return I->getKey();
+  }
+
+  /// size - The number of distinct strings in the pool.  This locks every
+  /// shard in turn, so it is only exact while no thread is interning.
+  unsigned size() {
+    unsigned Size = 0;
+    for (unsigned I = 0; I != NumShards; ++I) {
+      sys::ScopedLock Guard(Shards[I].Lock);
+      Size += Shards[I].Strings.size();
+    }
+    return Size;
+  }
+
+  /// getMemorySize - The bytes allocated for the interned strings.
+  size_t getMemorySize() {
+    size_t Bytes = 0;
+    for (unsigned I = 0; I != NumShards; ++I) {
+      sys::ScopedLock Guard(Shards[I].Lock);
+      Bytes += Shards[I].Strings.getAllocator().getTotalMemory();
+    }
+    return Bytes;
+  }
+};
+
+} // end namespace llvm
+
+#endif
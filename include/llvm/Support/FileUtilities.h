@@ -17,6 +17,7 @@
 
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
 namespace llvm {
 
@@ -73,6 +74,46 @@ namespace llvm {
     /// will not be removed when the object is destroyed.
     void releaseFile() { DeleteIt = false; }
   };
+
+  /// writeFileAtomically - Write \p Contents to \p Path so that concurrent
+  /// readers see either the previous file or the complete new one, never a
+  /// partial write.  The contents go to a uniquely named temporary file in
+  /// the same directory, which is then renamed over \p Path; the directory
+  /// is created if needed, and the temporary file is removed on failure.
+  ///
+  /// On Windows a file that is mapped into memory cannot be replaced, so the
+  /// rename fails while a reader still maps the old file.  Readers of files
+  /// written this way should copy the contents out of the mapping, or close
+  /// it, before the next write.
+  inline error_code writeFileAtomically(const Twine &Path,
+                                        StringRef Contents) {
+    SmallString<256> FinalPath, TempPath;
+    Path.toVector(FinalPath);
+    StringRef Dir = sys::path::parent_path(FinalPath);
+    if (!Dir.empty())
+      if (error_code EC = sys::fs::create_directories(Dir))
+        return EC;
+
+    int TempFD;
+    if (error_code EC = sys::fs::createUniqueFile(
+            Twine(FinalPath) + ".tmp-%%%%%%%%", TempFD, TempPath))
+      return EC;
+    {
+      raw_fd_ostream OS(TempFD, /*shouldClose=*/true);
+      OS << Contents;
+      OS.close();
+      if (OS.has_error()) {
+        OS.clear_error();
+        sys::fs::remove(TempPath.str());
+        return make_error_code(errc::io_error);
+      }
+    }
+    if (error_code EC = sys::fs::rename(TempPath.str(), FinalPath.str())) {
+      sys::fs::remove(TempPath.str());
+      return EC;
+    }
+    return error_code::success();
+  }
 } // End llvm namespace
 
 #endif
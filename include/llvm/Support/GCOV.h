@@ -387,6 +387,23 @@ public:
   void setRunCount(uint32_t Runs) { RunCount = Runs; }
   void setProgramCount(uint32_t Programs) { ProgramCount = Programs; }
   void print(StringRef GCNOFile, StringRef GCDAFile);
+
+  /// printSummary - Write the coverage of each source file seen by print()
+  /// as one comma-separated line: the file name, the number of lines and of
+  /// lines executed, then the number of branches, of branches executed and
+  /// of branches taken.  Tools reporting on many files can collect this
+  /// from one FileInfo per .gcno/.gcda pair and concatenate the results
+  /// instead of parsing the .gcov files.
+  void printSummary(raw_ostream &OS) const {
+    for (FileCoverageList::const_iterator I = FileCoverages.begin(),
+                                          E = FileCoverages.end();
+         I != E; ++I) {
+      const GCOVCoverage &Coverage = I->second;
+      OS << I->first << ',' << Coverage.LogicalLines << ','
+         << Coverage.LinesExec << ',' << Coverage.Branches << ','
+         << Coverage.BranchesExec << ',' << Coverage.BranchesTaken << '\n';
+    }
+  }
 private:
   void printFunctionSummary(raw_fd_ostream &OS,
                             const FunctionVector &Funcs) const;
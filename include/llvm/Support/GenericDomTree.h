@@ -551,6 +551,38 @@ public:
       this->Split<NodeT*, GraphTraits<NodeT*> >(*this, NewBB);
   }
 
+  /// insertEdge - Update the tree after the edge From -> To has been added
+  /// to the CFG.  If To was reachable and the nearest common dominator of
+  /// From and To is To or its immediate dominator, no dominator can change,
+  /// so the tree is left as is; otherwise it is recalculated.
+  void insertEdge(NodeT *From, NodeT *To) {
+    if (!this->IsPostDominators) {
+      if (!getNode(From))
+        return;   // Edges out of unreachable blocks do not matter.
+      if (DomTreeNodeBase<NodeT> *ToNode = getNode(To)) {
+        NodeT *NCA = findNearestCommonDominator(From, To);
+        DomTreeNodeBase<NodeT> *IDom = ToNode->getIDom();
+        if (NCA == To || (IDom && NCA == IDom->getBlock()))
+          return;
+      }
+    }
+    // An edge can also change the exits of the CFG, from which the post
+    // dominator tree is built, so that tree is always recalculated.
+    recalculate(*From->getParent());
+  }
+
+  /// deleteEdge - Update the tree after the edge From -> To has been removed
+  /// from the CFG.  Removing an edge that is unreachable, or whose target
+  /// dominates its source, changes no dominator and leaves the tree as is;
+  /// otherwise it is recalculated.
+  void deleteEdge(NodeT *From, NodeT *To) {
+    if (!this->IsPostDominators) {
+      if (!getNode(From) || dominates(To, From))
+        return;
+    }
+    recalculate(*From->getParent());
+  }
+
   /// print - Convert to human readable form
   ///
   void print(raw_ostream &o) const {
@@ -0,0 +1,165 @@
+//===-- PrefilteredRegex.h - Regex with a literal prefilter -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines PrefilteredRegex, a Regex that first searches a large
+// input for the literal text every match must start with, so that the
+// backtracking matcher only runs where a match can begin.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_PREFILTEREDREGEX_H
+#define LLVM_SUPPORT_PREFILTEREDREGEX_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Regex.h"
+#include <string>
+
+namespace llvm {
+
+/// PrefilteredRegex - Matches like Regex, for clients such as FileCheck that
+/// search long inputs for patterns that mostly start with plain text.
+///
+/// Searching a buffer with Regex::match tries the matcher at every offset.
+/// If every match of the pattern must start with a literal string, the
+/// first match can only start where that string first occurs, which
+/// StringRef::find locates much faster; the matcher then starts there, or
+/// is not run at all if the string does not occur.  Patterns that have no
+/// such prefix, are anchored, or use flags that change what the prefix
+/// matches are matched by Regex alone.
+class PrefilteredRegex {
+  Regex RE;
+  std::string Prefix;
+  unsigned NumCalls;
+  unsigned NumRejected;
+
+  static bool isMeta(char C) {
+    return StringRef(".[]()*+?{}|^$\\").find(C) != StringRef::npos;
+  }
+
+  /// Skip the bracket expression starting at \p Pattern[I], which is '['.
+  static size_t skipBracket(StringRef Pattern, size_t I) {
+    ++I;
+    if (I < Pattern.size() && Pattern[I] == '^')
+      ++I;
+    if (I < Pattern.size() && Pattern[I] == ']')
+      ++I;
+    while (I < Pattern.size() && Pattern[I] != ']') {
+      // [:class:], [.coll.] and [=equiv=] may contain ']'.
+      if (Pattern[I] == '[' && I + 1 < Pattern.size() &&
+          StringRef(":.=").find(Pattern[I + 1]) != StringRef::npos) {
+        char Close[] = { Pattern[I + 1], ']', '\0' };
+        size_t End = Pattern.find(Close, I + 2);
+        if (End == StringRef::npos)
+          return Pattern.size();
+        I = End + 2;
+        continue;
+      }
+      ++I;
+    }
+    return I + 1;
+  }
+
+  /// Whether \p Pattern has a '|' outside of parentheses and brackets.
+  static bool hasTopLevelAlternation(StringRef Pattern) {
+    unsigned Depth = 0;
+    for (size_t I = 0; I < Pattern.size();) {
+      char C = Pattern[I];
+      if (C == '\\') {
+        I += 2;
+        continue;
+      }
+      if (C == '[') {
+        I = skipBracket(Pattern, I);
+        continue;
+      }
+      if (C == '(')
+        ++Depth;
+      else if (C == ')' && Depth)
+        --Depth;
+      else if (C == '|' && !Depth)
+        return true;
+      ++I;
+    }
+    return false;
+  }
+
+public:
+  /// \brief The literal text every match of the extended regular expression
+  /// \p Pattern starts with, or an empty string if there is none or it
+  /// cannot be worked out simply.
+  static std::string getLiteralPrefix(StringRef Pattern) {
+    std::string Prefix;
+    if (Pattern.startswith("^") || hasTopLevelAlternation(Pattern))
+      return Prefix;
+    for (size_t I = 0; I < Pattern.size();) {
+      char C = Pattern[I];
+      size_t Next = I + 1;
+      if (C == '\\') {
+        // Only escaped metacharacters are literals; the others are
+        // backreferences.
+        if (Next == Pattern.size() || !isMeta(Pattern[Next]))
+          break;
+        C = Pattern[Next++];
+      } else if (isMeta(C)) {
+        break;
+      }
+      // A character that may be repeated zero times is not required, and
+      // nothing after a repeated one is at a fixed position.
+      if (Next < Pattern.size() &&
+          StringRef("*?{").find(Pattern[Next]) != StringRef::npos)
+        break;
+      Prefix += C;
+      if (Next < Pattern.size() && Pattern[Next] == '+')
+        break;
+      I = Next;
+    }
+    return Prefix;
+  }
+
+  /// Compile \p Pattern, an extended regular expression, as Regex does.
+  explicit PrefilteredRegex(StringRef Pattern, unsigned Flags = Regex::NoFlags)
+    : RE(Pattern, Flags), NumCalls(0), NumRejected(0) {
+    // Case-insensitive and basic expressions would need a different notion
+    // of literals.  Newline only changes what '^', '$', '.' and bracket
+    // expressions match, none of which is part of a prefix.
+    if (!(Flags & (Regex::IgnoreCase | Regex::BasicRegex)))
+      Prefix = getLiteralPrefix(Pattern);
+  }
+
+  bool isValid(std::string &Error) { return RE.isValid(Error); }
+  unsigned getNumMatches() const { return RE.getNumMatches(); }
+
+  /// The literal each match starts with; empty if the matcher always runs.
+  StringRef getPrefix() const { return Prefix; }
+
+  /// match - As Regex::match.  \p String is searched for the prefix first,
+  /// and the returned groups point into \p String as usual.
+  bool match(StringRef String, SmallVectorImpl<StringRef> *Matches = nullptr) {
+    ++NumCalls;
+    if (Prefix.empty())
+      return RE.match(String, Matches);
+    size_t Pos = String.find(Prefix);
+    if (Pos == StringRef::npos) {
+      ++NumRejected;
+      return false;
+    }
+    return RE.match(String.substr(Pos), Matches);
+  }
+
+  /// The number of calls to match, and of those that the prefix search
+  /// answered without running the matcher.  FileCheck can report these per
+  /// check file along with its timers.
+  unsigned getNumMatchCalls() const { return NumCalls; }
+  unsigned getNumRejected() const { return NumRejected; }
+};
+
+} // end namespace llvm
+
+#endif
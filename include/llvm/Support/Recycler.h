@@ -69,7 +69,15 @@ class Recycler {
   ///
   iplist<RecyclerStruct> FreeList;
 
+  /// ProfileOwner - What the free list is charged to, if anything, and
+  /// NumFree - the number of nodes on it, counted only with an owner.
+  ///
+  AllocationOwner *ProfileOwner;
+  size_t NumFree;
+
 public:
+  Recycler() : ProfileOwner(nullptr), NumFree(0) {}
+
   ~Recycler() {
     // If this fails, either the callee has lost track of some allocation,
     // or the callee isn't tracking allocations and should just call
@@ -82,6 +90,7 @@ public:
   /// deleted; calling clear is one way to ensure this.
   template<class AllocatorType>
   void clear(AllocatorType &Allocator) {
+    noteCleared();
     while (!FreeList.empty()) {
       T *t = reinterpret_cast<T *>(FreeList.remove(FreeList.begin()));
       Allocator.Deallocate(t);
@@ -94,18 +103,31 @@ public:
   /// There is no need to traverse the free list, pulling all the objects into
   /// cache.
   void clear(BumpPtrAllocator&) {
+    noteCleared();
     FreeList.clearAndLeakNodesUnsafely();
   }
 
+  /// setProfileOwner - Charge the nodes waiting on the free list to Owner.
+  /// This can only be done while the free list is empty.
+  ///
+  void setProfileOwner(AllocationOwner *Owner) {
+    assert(FreeList.empty() && "Charging a recycler already in use");
+    ProfileOwner = Owner;
+  }
+
   template<class SubClass, class AllocatorType>
   SubClass *Allocate(AllocatorType &Allocator) {
     static_assert(AlignOf<SubClass>::Alignment <= Align,
                   "Recycler allocation alignment is less than object align!");
     static_assert(sizeof(SubClass) <= Size,
                   "Recycler allocation size is less than object size!");
-    return !FreeList.empty() ?
-           reinterpret_cast<SubClass *>(FreeList.remove(FreeList.begin())) :
-           static_cast<SubClass *>(Allocator.Allocate(Size, Align));
+    if (FreeList.empty())
+      return static_cast<SubClass *>(Allocator.Allocate(Size, Align));
+    if (ProfileOwner) {
+      --NumFree;
+      ProfileOwner->noteRecycledBytes(-ptrdiff_t(Size));
+    }
+    return reinterpret_cast<SubClass *>(FreeList.remove(FreeList.begin()));
   }
 
   template<class AllocatorType>
@@ -116,11 +138,22 @@ public:
   template<class SubClass, class AllocatorType>
   void Deallocate(AllocatorType & /*Allocator*/, SubClass* Element) {
     FreeList.push_front(reinterpret_cast<RecyclerStruct *>(Element));
+    if (ProfileOwner) {
+      ++NumFree;
+      ProfileOwner->noteRecycledBytes(Size);
+    }
   }
 
   void PrintStats() {
     PrintRecyclerStats(Size, Align, FreeList.size());
   }
+
+private:
+  void noteCleared() {
+    if (ProfileOwner && NumFree)
+      ProfileOwner->noteRecycledBytes(-ptrdiff_t(NumFree * Size));
+    NumFree = 0;
+  }
 };
 
 }
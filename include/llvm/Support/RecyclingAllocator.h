@@ -51,6 +51,14 @@ public:
   template<class SubClass>
   void Deallocate(SubClass* E) { return Base.Deallocate(Allocator, E); }
 
+  /// setProfileOwner - Charge both the wrapped allocator and the recycled
+  /// objects to Owner; see AllocationOwner.
+  ///
+  void setProfileOwner(AllocationOwner *Owner) {
+    Allocator.setProfileOwner(Owner);
+    Base.setProfileOwner(Owner);
+  }
+
   void PrintStats() {
     Allocator.PrintStats();
     Base.PrintStats();
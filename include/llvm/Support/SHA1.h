@@ -0,0 +1,156 @@
+//===--- SHA1.h - SHA-1 message digest --------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the SHA-1 message digest (FIPS 180-4), with the same
+// interface as llvm::MD5.  It is used for Mach-O code signature page hashes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_SHA1_H
+#define LLVM_SUPPORT_SHA1_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include <cstring>
+
+namespace llvm {
+
+class SHA1 {
+  uint32_t State[5];
+  uint8_t Buffer[64];
+  uint64_t Length;
+
+  static uint32_t rotl(uint32_t V, unsigned N) {
+    return (V << N) | (V >> (32 - N));
+  }
+
+  /// \brief Process one 64-byte block.
+  void body(const uint8_t *Block) {
+    uint32_t W[80];
+    for (unsigned i = 0; i != 16; ++i)
+      W[i] = uint32_t(Block[4 * i]) << 24 | uint32_t(Block[4 * i + 1]) << 16 |
+             uint32_t(Block[4 * i + 2]) << 8 | uint32_t(Block[4 * i + 3]);
+    for (unsigned i = 16; i != 80; ++i)
+      W[i] = rotl(W[i - 3] ^ W[i - 8] ^ W[i - 14] ^ W[i - 16], 1);
+
+    uint32_t A = State[0], B = State[1], C = State[2], D = State[3],
+             E = State[4];
+    for (unsigned i = 0; i != 80; ++i) {
+      uint32_t F, K;
+      if (i < 20) {
+        F = (B & C) | (~B & D);
+        K = 0x5A827999;
+      } else if (i < 40) {
+        F = B ^ C ^ D;
+        K = 0x6ED9EBA1;
+      } else if (i < 60) {
+        F = (B & C) | (B & D) | (C & D);
+        K = 0x8F1BBCDC;
+      } else {
+        F = B ^ C ^ D;
+        K = 0xCA62C1D6;
+      }
+      uint32_t T = rotl(A, 5) + F + E + K + W[i];
+      E = D;
+      D = C;
+      C = rotl(B, 30);
+      B = A;
+      A = T;
+    }
+    State[0] += A;
+    State[1] += B;
+    State[2] += C;
+    State[3] += D;
+    State[4] += E;
+  }
+
+public:
+  typedef uint8_t SHA1Result[20];
+
+  SHA1() : Length(0) {
+    State[0] = 0x67452301;
+    State[1] = 0xEFCDAB89;
+    State[2] = 0x98BADCFE;
+    State[3] = 0x10325476;
+    State[4] = 0xC3D2E1F0;
+  }
+
+  /// \brief Updates the hash for the byte stream provided.
+  void update(ArrayRef<uint8_t> Data) {
+    const uint8_t *P = Data.data();
+    size_t Size = Data.size();
+    unsigned Used = Length % 64;
+    Length += Size;
+
+    if (Used) {
+      unsigned Free = 64 - Used;
+      if (Size < Free) {
+        std::memcpy(Buffer + Used, P, Size);
+        return;
+      }
+      std::memcpy(Buffer + Used, P, Free);
+      body(Buffer);
+      P += Free;
+      Size -= Free;
+    }
+    for (; Size >= 64; P += 64, Size -= 64)
+      body(P);
+    std::memcpy(Buffer, P, Size);
+  }
+
+  /// \brief Updates the hash for the StringRef provided.
+  void update(StringRef Str) {
+    update(ArrayRef<uint8_t>(reinterpret_cast<const uint8_t *>(Str.data()),
+                             Str.size()));
+  }
+
+  /// \brief Finishes off the hash and puts the result in result.
+  void final(SHA1Result &Result) {
+    uint64_t BitLength = Length * 8;
+    unsigned Used = Length % 64;
+    Buffer[Used++] = 0x80;
+    if (Used > 56) {
+      std::memset(Buffer + Used, 0, 64 - Used);
+      body(Buffer);
+      Used = 0;
+    }
+    std::memset(Buffer + Used, 0, 56 - Used);
+    for (unsigned i = 0; i != 8; ++i)
+      Buffer[56 + i] = uint8_t(BitLength >> (56 - 8 * i));
+    body(Buffer);
+
+    for (unsigned i = 0; i != 5; ++i)
+      for (unsigned j = 0; j != 4; ++j)
+        Result[4 * i + j] = uint8_t(State[i] >> (24 - 8 * j));
+  }
+
+  /// \brief Compute the digest of \p Data in one go.
+  static void hash(ArrayRef<uint8_t> Data, SHA1Result &Result) {
+    SHA1 Hash;
+    Hash.update(Data);
+    Hash.final(Result);
+  }
+
+  /// \brief Translates the bytes in \p Res to a hex string that is
+  /// deposited into \p Str. The result will be of length 40.
+  static void stringifyResult(const SHA1Result &Res, SmallString<40> &Str) {
+    static const char Hex[] = "0123456789abcdef";
+    Str.clear();
+    for (unsigned i = 0; i != 20; ++i) {
+      Str.push_back(Hex[Res[i] >> 4]);
+      Str.push_back(Hex[Res[i] & 15]);
+    }
+  }
+};
+
+}
+
+#endif
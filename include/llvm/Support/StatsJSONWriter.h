@@ -0,0 +1,132 @@
+//===- llvm/Support/StatsJSONWriter.h - Statistics as JSON ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines StatsJSONWriter, which writes counters, sizes and times
+// as nested JSON objects, so that the statistics of many compilations can be
+// collected and aggregated by scripts instead of scraped from the text that
+// -stats and -print-stats write to stderr.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_STATSJSONWRITER_H
+#define LLVM_SUPPORT_STATSJSONWRITER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cassert>
+
+namespace llvm {
+
+/// StatsJSONWriter - Writes one JSON object whose members are numbers,
+/// strings or nested objects.
+///
+/// Members are written as they are added, so the object is complete only
+/// after the outermost endObject.  Nested objects are opened with
+/// beginObject and closed with endObject like scopes; member names are not
+/// checked for uniqueness.
+class StatsJSONWriter {
+  raw_ostream &OS;
+  unsigned Depth;
+  bool NeedComma;
+
+  void writeIndent() {
+    for (unsigned I = 0; I != Depth; ++I)
+      OS << "  ";
+  }
+
+  void writeName(StringRef Name) {
+    assert(Depth && "Member outside of an object");
+    if (NeedComma)
+      OS << ',';
+    OS << '\n';
+    writeIndent();
+    writeString(Name);
+    OS << ": ";
+    NeedComma = true;
+  }
+
+public:
+  explicit StatsJSONWriter(raw_ostream &OS)
+    : OS(OS), Depth(0), NeedComma(false) {}
+
+  ~StatsJSONWriter() { assert(!Depth && "Unterminated object"); }
+
+  /// Write \p Str as a quoted JSON string.
+  void writeString(StringRef Str) {
+    OS << '"';
+    for (unsigned I = 0, E = Str.size(); I != E; ++I) {
+      unsigned char C = Str[I];
+      if (C == '"' || C == '\\')
+        OS << '\\' << C;
+      else if (C < 0x20)
+        OS << format("\\u%04x", C);
+      else
+        OS << C;
+    }
+    OS << '"';
+  }
+
+  /// Open the outermost object if \p Name is empty, or else an object named
+  /// \p Name inside the current one.
+  void beginObject(StringRef Name = StringRef()) {
+    if (Depth)
+      writeName(Name);
+    OS << '{';
+    ++Depth;
+    NeedComma = false;
+  }
+
+  void endObject() {
+    assert(Depth && "No object to end");
+    --Depth;
+    if (NeedComma) {
+      OS << '\n';
+      writeIndent();
+    }
+    OS << '}';
+    NeedComma = true;
+    if (!Depth)
+      OS << '\n';
+  }
+
+  void value(StringRef Name, unsigned long long Value) {
+    writeName(Name);
+    OS << Value;
+  }
+  void value(StringRef Name, unsigned long Value) {
+    value(Name, (unsigned long long)Value);
+  }
+  void value(StringRef Name, unsigned Value) {
+    value(Name, (unsigned long long)Value);
+  }
+
+  void value(StringRef Name, double Value) {
+    writeName(Name);
+    OS << format("%.6f", Value);
+  }
+
+  void value(StringRef Name, StringRef Str) {
+    writeName(Name);
+    writeString(Str);
+  }
+
+  /// Start a member named \p Name whose value the caller writes to the
+  /// returned stream, as one complete JSON value.
+  raw_ostream &rawValue(StringRef Name) {
+    writeName(Name);
+    return OS;
+  }
+
+  raw_ostream &getStream() { return OS; }
+};
+
+} // end namespace llvm
+
+#endif
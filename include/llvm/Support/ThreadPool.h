@@ -0,0 +1,350 @@
+//===-- llvm/Support/ThreadPool.h - Shared thread pool ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines ThreadPool, an executor that runs tasks on a fixed set of
+// worker threads, TaskGroup, which waits for a set of tasks, and the
+// parallel_for, parallel_for_each and parallel_sort algorithms built on them.
+//
+// The algorithms run on a single pool shared by the whole process, sized by
+// the -j setting of the tool (see setDefaultThreadCount) or else by the
+// LLVM_THREADS environment variable, so that parallel phases of the driver,
+// LTO and the tools do not each start their own threads.  Without
+// LLVM_ENABLE_THREADS every task runs on the calling thread.
+//
+// Tasks must not block on work that is not itself a pool task.  So code
+// whose workers wait for the calling thread, such as processBinariesInOrder,
+// whose workers wait for their output to be written, keeps threads of its
+// own, and so do long-lived background threads such as the writer of
+// raw_async_ostream.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_THREADPOOL_H
+#define LLVM_SUPPORT_THREADPOOL_H
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <vector>
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace llvm {
+
+namespace threadpool_detail {
+inline unsigned &getRequestedThreadCount() {
+  static unsigned Count = 0;
+  return Count;
+}
+} // end namespace threadpool_detail
+
+/// \brief Use \p NumThreads threads, or the default if it is 0, for the
+/// shared pool.  Tools call this with their -j value before the first
+/// parallel algorithm runs; later calls do not resize the shared pool.
+inline void setDefaultThreadCount(unsigned NumThreads) {
+  threadpool_detail::getRequestedThreadCount() = NumThreads;
+}
+
+/// \brief The number of threads the shared pool uses: the value given to
+/// setDefaultThreadCount, else the LLVM_THREADS environment variable, else
+/// the number of hardware threads.  This is 1 without LLVM_ENABLE_THREADS.
+inline unsigned getDefaultThreadCount() {
+#if LLVM_ENABLE_THREADS
+  if (unsigned Requested = threadpool_detail::getRequestedThreadCount())
+    return Requested;
+  if (const char *Env = std::getenv("LLVM_THREADS")) {
+    int Count = std::atoi(Env);
+    if (Count > 0)
+      return Count;
+  }
+  return std::max(std::thread::hardware_concurrency(), 1u);
+#else
+  return 1;
+#endif
+}
+
+/// ThreadPool - Runs tasks on worker threads in the order they are queued.
+///
+/// All workers take tasks from one queue; there is no per-thread queue to
+/// steal from.  Instead, a thread that waits on a TaskGroup runs queued
+/// tasks itself until its group is done, so a task may start parallel work
+/// of its own and wait for it without stalling the pool.
+class ThreadPool {
+#if LLVM_ENABLE_THREADS
+  std::vector<std::thread> Workers;
+  std::deque<std::function<void()> > Tasks;
+  std::mutex QueueLock;
+  std::condition_variable QueueCondition;
+  std::condition_variable CompletionCondition;
+  unsigned ActiveTasks;
+  bool Stopping;
+
+  void work() {
+    for (;;) {
+      std::function<void()> Task;
+      {
+        std::unique_lock<std::mutex> Lock(QueueLock);
+        QueueCondition.wait(Lock, [&] { return Stopping || !Tasks.empty(); });
+        if (Tasks.empty())
+          return;
+        Task = Tasks.front();
+        Tasks.pop_front();
+        ++ActiveTasks;
+      }
+      run(Task);
+    }
+  }
+
+  void run(std::function<void()> &Task) {
+    Task();
+    std::lock_guard<std::mutex> Lock(QueueLock);
+    if (--ActiveTasks == 0 && Tasks.empty())
+      CompletionCondition.notify_all();
+  }
+#endif
+
+  unsigned NumThreads;
+
+  ThreadPool(const ThreadPool &) LLVM_DELETED_FUNCTION;
+  void operator=(const ThreadPool &) LLVM_DELETED_FUNCTION;
+
+public:
+  /// Start \p NumThreads workers; with 0 or 1, tasks run on the thread that
+  /// queues them.
+  explicit ThreadPool(unsigned NumThreads = getDefaultThreadCount())
+    : NumThreads(std::max(NumThreads, 1u)) {
+#if LLVM_ENABLE_THREADS
+    ActiveTasks = 0;
+    Stopping = false;
+    if (this->NumThreads > 1)
+      for (unsigned I = 0; I != this->NumThreads; ++I)
+        Workers.push_back(std::thread([this] { work(); }));
+#endif
+  }
+
+  /// Run the tasks still queued, then stop the workers.
+  ~ThreadPool() {
+#if LLVM_ENABLE_THREADS
+    {
+      std::lock_guard<std::mutex> Lock(QueueLock);
+      Stopping = true;
+    }
+    QueueCondition.notify_all();
+    for (unsigned I = 0, E = Workers.size(); I != E; ++I)
+      Workers[I].join();
+#endif
+  }
+
+  /// The number of threads that run tasks, at least 1.
+  unsigned getThreadCount() const { return NumThreads; }
+
+  /// Queue \p Task to run on a worker.
+  void async(std::function<void()> Task) {
+#if LLVM_ENABLE_THREADS
+    if (!Workers.empty()) {
+      {
+        std::lock_guard<std::mutex> Lock(QueueLock);
+        Tasks.push_back(Task);
+      }
+      QueueCondition.notify_one();
+      return;
+    }
+#endif
+    Task();
+  }
+
+  /// Run one queued task on the calling thread.  \returns false if the
+  /// queue was empty.
+  bool runOneTask() {
+#if LLVM_ENABLE_THREADS
+    std::function<void()> Task;
+    {
+      std::lock_guard<std::mutex> Lock(QueueLock);
+      if (Tasks.empty())
+        return false;
+      Task = Tasks.front();
+      Tasks.pop_front();
+      ++ActiveTasks;
+    }
+    run(Task);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /// Wait until every queued task has run.  This must not be called from a
+  /// task of this pool; use a TaskGroup there instead.
+  void wait() {
+#if LLVM_ENABLE_THREADS
+    std::unique_lock<std::mutex> Lock(QueueLock);
+    CompletionCondition.wait(Lock,
+                             [&] { return ActiveTasks == 0 && Tasks.empty(); });
+#endif
+  }
+};
+
+/// \brief The pool shared by the parallel algorithms, started on first use
+/// with getDefaultThreadCount() threads.
+inline ThreadPool &getDefaultThreadPool() {
+  static ThreadPool Pool;
+  return Pool;
+}
+
+/// TaskGroup - Runs tasks on a ThreadPool and waits for all of them.  This
+/// may be used from inside a task of the same pool.
+class TaskGroup {
+  ThreadPool &Pool;
+#if LLVM_ENABLE_THREADS
+  std::mutex Lock;
+  std::condition_variable Done;
+  unsigned Pending;
+#endif
+
+  TaskGroup(const TaskGroup &) LLVM_DELETED_FUNCTION;
+  void operator=(const TaskGroup &) LLVM_DELETED_FUNCTION;
+
+public:
+  explicit TaskGroup(ThreadPool &Pool = getDefaultThreadPool()) : Pool(Pool) {
+#if LLVM_ENABLE_THREADS
+    Pending = 0;
+#endif
+  }
+  ~TaskGroup() { wait(); }
+
+  /// Run \p Task as part of this group.
+  void spawn(std::function<void()> Task) {
+#if LLVM_ENABLE_THREADS
+    {
+      std::lock_guard<std::mutex> Guard(Lock);
+      ++Pending;
+    }
+    Pool.async([this, Task] {
+      Task();
+      std::lock_guard<std::mutex> Guard(Lock);
+      if (--Pending == 0)
+        Done.notify_all();
+    });
+#else
+    Task();
+#endif
+  }
+
+  /// Wait for the tasks of this group, running queued tasks of the pool on
+  /// this thread in the meantime.
+  void wait() {
+#if LLVM_ENABLE_THREADS
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> Guard(Lock);
+        if (Pending == 0)
+          return;
+      }
+      if (!Pool.runOneTask())
+        break;
+    }
+    // Whatever is left of the group is running on other threads.
+    std::unique_lock<std::mutex> Guard(Lock);
+    Done.wait(Guard, [&] { return Pending == 0; });
+#endif
+  }
+};
+
+/// \brief Call \p Fn(I) for every I in [Begin, End), in no particular
+/// order, on the shared pool.  \p Fn must be thread-safe.
+template <typename IndexTy, typename FuncTy>
+void parallel_for(IndexTy Begin, IndexTy End, FuncTy Fn) {
+  if (End <= Begin)
+    return;
+  ThreadPool &Pool = getDefaultThreadPool();
+  // A few chunks per thread balance uneven iterations without queuing one
+  // task per element.
+  IndexTy NumChunks = Pool.getThreadCount() * 4;
+  IndexTy ChunkSize = std::max<IndexTy>((End - Begin) / NumChunks, 1);
+  if (Pool.getThreadCount() == 1 || ChunkSize == End - Begin) {
+    for (IndexTy I = Begin; I != End; ++I)
+      Fn(I);
+    return;
+  }
+  TaskGroup Group(Pool);
+  for (IndexTy I = Begin; I < End; I += std::min(ChunkSize, End - I)) {
+    IndexTy ChunkEnd = I + std::min(ChunkSize, End - I);
+    Group.spawn([=] {
+      for (IndexTy J = I; J != ChunkEnd; ++J)
+        Fn(J);
+    });
+  }
+}
+
+/// \brief Call \p Fn on every element of the random-access range
+/// [Begin, End), in no particular order, on the shared pool.
+template <typename IterTy, typename FuncTy>
+void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
+  typedef typename std::iterator_traits<IterTy>::difference_type DiffTy;
+  parallel_for(DiffTy(0), End - Begin, [=](DiffTy I) { Fn(Begin[I]); });
+}
+
+/// \brief Sort the random-access range [Begin, End) with \p Comp on the
+/// shared pool: chunks are sorted in parallel, then merged pairwise.  Like
+/// std::sort, this is not stable.
+template <typename IterTy, typename CompareTy>
+void parallel_sort(IterTy Begin, IterTy End, CompareTy Comp) {
+  typedef typename std::iterator_traits<IterTy>::difference_type DiffTy;
+  // Below this, starting tasks costs more than sorting.
+  const DiffTy MinChunkSize = 1024;
+  ThreadPool &Pool = getDefaultThreadPool();
+  DiffTy Size = End - Begin;
+  DiffTy NumChunks = 1;
+  while (NumChunks < DiffTy(Pool.getThreadCount()) &&
+         Size / (NumChunks * 2) >= MinChunkSize)
+    NumChunks *= 2;
+  if (NumChunks == 1) {
+    std::sort(Begin, End, Comp);
+    return;
+  }
+
+  std::vector<IterTy> Bounds;
+  for (DiffTy I = 0; I != NumChunks; ++I)
+    Bounds.push_back(Begin + Size * I / NumChunks);
+  Bounds.push_back(End);
+
+  {
+    TaskGroup Group(Pool);
+    for (DiffTy I = 0; I != NumChunks; ++I) {
+      IterTy ChunkBegin = Bounds[I], ChunkEnd = Bounds[I + 1];
+      Group.spawn([=] { std::sort(ChunkBegin, ChunkEnd, Comp); });
+    }
+  }
+  for (DiffTy Width = 1; Width != NumChunks; Width *= 2) {
+    TaskGroup Group(Pool);
+    for (DiffTy I = 0; I != NumChunks; I += 2 * Width) {
+      IterTy First = Bounds[I], Middle = Bounds[I + Width],
+             Last = Bounds[I + 2 * Width];
+      Group.spawn([=] { std::inplace_merge(First, Middle, Last, Comp); });
+    }
+  }
+}
+
+/// \brief Sort [Begin, End) with operator< on the shared pool.
+template <typename IterTy>
+void parallel_sort(IterTy Begin, IterTy End) {
+  typedef typename std::iterator_traits<IterTy>::value_type ValueTy;
+  parallel_sort(Begin, End, std::less<ValueTy>());
+}
+
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,172 @@
+//===- llvm/Support/TimeTraceProfiler.h - Chrome trace profiling *- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines TimeTraceProfiler, which records the start and end of
+// named events, such as compiler phases and passes run on a function, along
+// with the change in heap usage over each one, and writes them out in the
+// Chrome trace event format for chrome://tracing.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_TIMETRACEPROFILER_H
+#define LLVM_SUPPORT_TIMETRACEPROFILER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/ThreadLocal.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+/// TimeTraceProfiler - Records a tree of timed events and writes them as a
+/// Chrome trace.
+///
+/// Recording an event costs two clock reads and two calls to
+/// sys::Process::GetMallocUsage(), and nothing at all while no profiler is
+/// installed, so the hooks in PMDataManager and in the clang frontend can
+/// stay in release builds.  Profilers are installed per thread, so a
+/// profiler only records the events of the thread that installed it, and
+/// threads that compile in parallel each need their own; events must be
+/// properly nested.
+class TimeTraceProfiler {
+  struct Event {
+    std::string Name;
+    std::string Detail;
+    uint64_t StartUs;
+    uint64_t DurationUs;
+    int64_t MallocDelta;
+  };
+
+  struct OpenEvent {
+    unsigned Index;
+    size_t StartMalloc;
+  };
+
+  std::vector<Event> Events;
+  std::vector<OpenEvent> Stack;
+  uint64_t StartUs;
+
+  static uint64_t now() { return sys::TimeValue::now().usec(); }
+
+  static sys::ThreadLocal<const TimeTraceProfiler> &current() {
+    static sys::ThreadLocal<const TimeTraceProfiler> Profiler;
+    return Profiler;
+  }
+
+  static void writeEscaped(raw_ostream &OS, StringRef Str) {
+    for (unsigned I = 0, E = Str.size(); I != E; ++I) {
+      unsigned char C = Str[I];
+      if (C == '"' || C == '\\')
+        OS << '\\' << C;
+      else if (C < 0x20)
+        OS << format("\\u%04x", C);
+      else
+        OS << C;
+    }
+  }
+
+public:
+  TimeTraceProfiler() : StartUs(now()) {}
+
+  /// \brief The profiler installed by this thread, or null if its events
+  /// are not recorded.
+  static TimeTraceProfiler *get() {
+    return const_cast<TimeTraceProfiler *>(current().get());
+  }
+
+  /// \brief Record the events of this thread into \p Profiler, which is not
+  /// owned, from now on; null stops recording.
+  static void install(TimeTraceProfiler *Profiler) {
+    if (Profiler)
+      current().set(Profiler);
+    else
+      current().erase();
+  }
+
+  /// \brief Start an event named \p Name, such as a pass name, with an
+  /// optional \p Detail, such as the function it runs on.
+  void begin(StringRef Name, StringRef Detail = StringRef()) {
+    Event E;
+    E.Name = Name;
+    E.Detail = Detail;
+    E.StartUs = now() - StartUs;
+    E.DurationUs = 0;
+    E.MallocDelta = 0;
+    OpenEvent Open = { unsigned(Events.size()),
+                       sys::Process::GetMallocUsage() };
+    Events.push_back(E);
+    Stack.push_back(Open);
+  }
+
+  /// \brief End the innermost event that is still open.
+  void end() {
+    assert(!Stack.empty() && "No event to end");
+    Event &E = Events[Stack.back().Index];
+    E.DurationUs = now() - StartUs - E.StartUs;
+    E.MallocDelta = int64_t(sys::Process::GetMallocUsage()) -
+                    int64_t(Stack.back().StartMalloc);
+    Stack.pop_back();
+  }
+
+  /// \brief Write the events that have ended as a Chrome trace, with the
+  /// change in heap usage of each one as its "malloc-delta" argument.
+  void write(raw_ostream &OS, StringRef ProcessName = "llvm") const {
+    OS << "{\"traceEvents\":[";
+    bool First = true;
+    for (unsigned I = 0, E = Events.size(); I != E; ++I) {
+      const Event &Ev = Events[I];
+      if (!First)
+        OS << ',';
+      First = false;
+      OS << "\n{\"pid\":1,\"tid\":0,\"ph\":\"X\",\"ts\":" << Ev.StartUs
+         << ",\"dur\":" << Ev.DurationUs << ",\"name\":\"";
+      writeEscaped(OS, Ev.Name);
+      OS << "\",\"args\":{\"detail\":\"";
+      writeEscaped(OS, Ev.Detail);
+      OS << "\",\"malloc-delta\":" << Ev.MallocDelta << "}}";
+    }
+    if (!First)
+      OS << ',';
+    OS << "\n{\"pid\":1,\"tid\":0,\"ph\":\"M\",\"name\":\"process_name\","
+       << "\"args\":{\"name\":\"";
+    writeEscaped(OS, ProcessName);
+    OS << "\"}}\n]}\n";
+  }
+};
+
+/// TimeTraceScope - Records an event in the installed TimeTraceProfiler,
+/// if any, for as long as it lives.
+class TimeTraceScope {
+  TimeTraceProfiler *Profiler;
+
+  TimeTraceScope(const TimeTraceScope &) LLVM_DELETED_FUNCTION;
+  void operator=(const TimeTraceScope &) LLVM_DELETED_FUNCTION;
+
+public:
+  explicit TimeTraceScope(StringRef Name, StringRef Detail = StringRef())
+    : Profiler(TimeTraceProfiler::get()) {
+    if (Profiler)
+      Profiler->begin(Name, Detail);
+  }
+  ~TimeTraceScope() {
+    if (Profiler)
+      Profiler->end();
+  }
+};
+
+} // end namespace llvm
+
+#endif
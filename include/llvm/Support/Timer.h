@@ -177,6 +177,15 @@ public:
   
   /// printAll - This static method prints all timers and clears them all out.
   static void printAll(raw_ostream &OS);
+
+  /// printJSONValues - Print the wall, user and system time of each started
+  /// timer in this group as a JSON object of objects named after the timers.
+  /// Unlike print, the timers are not zeroed.
+  void printJSONValues(raw_ostream &OS);
+
+  /// printAllJSONValues - Print the JSON values of all timer groups, as an
+  /// object of objects named after the groups.
+  static void printAllJSONValues(raw_ostream &OS);
   
 private:
   friend class Timer;
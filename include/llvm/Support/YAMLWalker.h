@@ -0,0 +1,146 @@
+//===--- YAMLWalker.h - Event-based YAML traversal --------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines yaml::Handler and yaml::walk, which report the contents
+//  of a yaml::Stream as a sequence of events, in the style of a SAX parser,
+//  to clients that read large files once, such as clang-apply-replacements.
+//
+//  The parser already produces nodes lazily while a document is iterated;
+//  walk visits every node as soon as it is parsed, so the client never holds
+//  on to a tree of its own, and hands scalars over as slices of the input
+//  unless they contain escapes or folded lines.  With the input mapped
+//  through walkFile, a file with plain scalars is read without copying any
+//  of its text.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_YAMLWALKER_H
+#define LLVM_SUPPORT_YAMLWALKER_H
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/system_error.h"
+#include <memory>
+
+namespace llvm {
+namespace yaml {
+
+/// \brief The events reported by walk.  Each callback is given the node it
+/// reports on, for its anchor, tag and source range.
+///
+/// The callbacks that may start a subtree return whether walk should descend
+/// into it; returning false skips it without reporting its contents, which
+/// still scans it but does less work.  StringRefs passed to the callbacks
+/// point into the input, or into scratch storage of walk when the scalar had
+/// to be unescaped, which is only valid during the call.
+class Handler {
+public:
+  virtual ~Handler() {}
+
+  virtual bool startDocument(Document &D) { return true; }
+  virtual void endDocument(Document &D) {}
+
+  virtual bool startMapping(MappingNode &N) { return true; }
+  virtual void endMapping(MappingNode &N) {}
+
+  /// \brief The key of the next entry of a mapping; its value is reported
+  /// next unless this returns false.  Keys that are not scalars are skipped
+  /// and reported as empty.
+  virtual bool key(StringRef Key, KeyValueNode &N) { return true; }
+
+  virtual bool startSequence(SequenceNode &N) { return true; }
+  virtual void endSequence(SequenceNode &N) {}
+
+  virtual void scalar(StringRef Value, ScalarNode &N) {}
+  virtual void null(NullNode &N) {}
+  virtual void alias(AliasNode &N) {}
+};
+
+namespace walker_detail {
+
+inline void walkNode(Node *N, Handler &H, SmallVectorImpl<char> &Storage) {
+  if (!N)
+    return;
+  if (ScalarNode *S = dyn_cast<ScalarNode>(N)) {
+    Storage.clear();
+    H.scalar(S->getValue(Storage), *S);
+  } else if (MappingNode *M = dyn_cast<MappingNode>(N)) {
+    if (!H.startMapping(*M)) {
+      M->skip();
+      return;
+    }
+    for (MappingNode::iterator I = M->begin(), E = M->end(); I != E; ++I) {
+      Node *Key = I->getKey();
+      StringRef KeyValue;
+      if (ScalarNode *SK = dyn_cast_or_null<ScalarNode>(Key)) {
+        Storage.clear();
+        KeyValue = SK->getValue(Storage);
+      } else if (Key) {
+        Key->skip();
+      }
+      if (H.key(KeyValue, *I))
+        walkNode(I->getValue(), H, Storage);
+      else if (Node *Value = I->getValue())
+        Value->skip();
+    }
+    H.endMapping(*M);
+  } else if (SequenceNode *Seq = dyn_cast<SequenceNode>(N)) {
+    if (!H.startSequence(*Seq)) {
+      Seq->skip();
+      return;
+    }
+    for (SequenceNode::iterator I = Seq->begin(), E = Seq->end(); I != E;
+         ++I)
+      walkNode(&*I, H, Storage);
+    H.endSequence(*Seq);
+  } else if (NullNode *Null = dyn_cast<NullNode>(N)) {
+    H.null(*Null);
+  } else if (AliasNode *A = dyn_cast<AliasNode>(N)) {
+    H.alias(*A);
+  }
+}
+
+} // end namespace walker_detail
+
+/// \brief Report every document of \p S to \p H.
+/// \returns true if there was an error, false otherwise.
+inline bool walk(Stream &S, Handler &H) {
+  SmallString<256> Storage;
+  for (document_iterator I = S.begin(), E = S.end(); I != E; ++I) {
+    if (!H.startDocument(*I))
+      continue;
+    walker_detail::walkNode(I->getRoot(), H, Storage);
+    H.endDocument(*I);
+  }
+  return S.failed();
+}
+
+/// \brief Map the file \p Path and report its documents to \p H.
+///
+/// \returns \c errc::invalid_argument if the file is not valid YAML, after
+/// printing the errors through \p SM.
+inline error_code walkFile(const Twine &Path, SourceMgr &SM, Handler &H) {
+  std::unique_ptr<MemoryBuffer> Buffer;
+  if (error_code EC = MemoryBuffer::getFile(Path, Buffer))
+    return EC;
+  Stream S(Buffer->getBuffer(), SM);
+  if (walk(S, H))
+    return make_error_code(errc::invalid_argument);
+  return error_code::success();
+}
+
+} // end namespace yaml
+} // end namespace llvm
+
+#endif
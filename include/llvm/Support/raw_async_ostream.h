@@ -0,0 +1,146 @@
+//===-- raw_async_ostream.h - Double-buffered background output -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines raw_async_ostream, a raw_ostream with two large buffers
+// that hands each full buffer to a background thread that writes it to
+// another stream, while the caller keeps printing into the other buffer.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_RAW_ASYNC_OSTREAM_H
+#define LLVM_SUPPORT_RAW_ASYNC_OSTREAM_H
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace llvm {
+
+/// raw_async_ostream - A stream for tools that print a lot, such as
+/// llvm-objdump -d, llvm-dis and clang -emit-llvm -S.
+///
+/// The output is collected in a buffer of \c BufferSize bytes, 1MB by
+/// default, so the destination sees few large writes instead of many small
+/// ones, which matters most on pipes and on Cygwin.  A full buffer is written
+/// out by a background thread, without being copied, while printing goes on
+/// into the second buffer; printing only waits when it fills that one too
+/// before the first has been written.  Writes larger than the buffer go to
+/// the destination directly, after the pending buffer.
+///
+/// Output reaches the destination in order.  flush() only hands the buffer
+/// to the writer; call drain() before reading the destination or checking it
+/// for errors.  Without LLVM_ENABLE_THREADS the buffers are written on the
+/// calling thread.
+class raw_async_ostream : public raw_ostream {
+  raw_ostream &Target;
+  uint64_t Pos;
+  size_t BufferSize;
+  std::unique_ptr<char[]> Buffers[2];
+  unsigned Current;
+
+#if LLVM_ENABLE_THREADS
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  const char *PendingPtr;
+  size_t PendingSize;
+  bool Done;
+  std::thread Writer;
+
+  void run() {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    for (;;) {
+      Changed.wait(Lock, [this] { return Done || PendingPtr; });
+      if (!PendingPtr)
+        return;
+      const char *Ptr = PendingPtr;
+      size_t Size = PendingSize;
+      Lock.unlock();
+      Target.write(Ptr, Size);
+      Lock.lock();
+      PendingPtr = nullptr;
+      Changed.notify_all();
+    }
+  }
+#endif
+
+  void write_impl(const char *Ptr, size_t Size) override {
+    Pos += Size;
+#if LLVM_ENABLE_THREADS
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Changed.wait(Lock, [this] { return !PendingPtr; });
+    if (Ptr == Buffers[Current].get()) {
+      // Hand the full buffer to the writer and print into the other one.
+      // The stream's buffer is empty here, so it can be switched.
+      PendingPtr = Ptr;
+      PendingSize = Size;
+      Current ^= 1;
+      SetBuffer(Buffers[Current].get(), BufferSize);
+      Changed.notify_all();
+      return;
+    }
+    Lock.unlock();
+#endif
+    Target.write(Ptr, Size);
+  }
+
+  uint64_t current_pos() const override { return Pos; }
+
+  raw_async_ostream(const raw_async_ostream &) LLVM_DELETED_FUNCTION;
+  void operator=(const raw_async_ostream &) LLVM_DELETED_FUNCTION;
+
+public:
+  explicit raw_async_ostream(raw_ostream &Target,
+                             size_t BufferSize = 1 << 20)
+    : Target(Target), Pos(0), BufferSize(BufferSize), Current(0)
+#if LLVM_ENABLE_THREADS
+      , PendingPtr(nullptr), PendingSize(0), Done(false)
+#endif
+  {
+    Buffers[0].reset(new char[BufferSize]);
+#if LLVM_ENABLE_THREADS
+    Buffers[1].reset(new char[BufferSize]);
+    Writer = std::thread([this] { run(); });
+#endif
+    SetBuffer(Buffers[0].get(), BufferSize);
+  }
+
+  ~raw_async_ostream() {
+    drain();
+#if LLVM_ENABLE_THREADS
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Done = true;
+    }
+    Changed.notify_all();
+    Writer.join();
+#endif
+  }
+
+  /// drain - Wait until everything written so far has been written to the
+  /// destination, and flush it.
+  void drain() {
+    flush();
+#if LLVM_ENABLE_THREADS
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Changed.wait(Lock, [this] { return !PendingPtr; });
+    }
+#endif
+    Target.flush();
+  }
+};
+
+} // end namespace llvm
+
+#endif
@@ -474,6 +474,40 @@ public:
   StringRef str();
 };
 
+/// raw_buffer_ostream - A raw_ostream that writes into a fixed range of
+/// memory, such as the mapping of a FileOutputBuffer.  The stream is
+/// unbuffered, so every write is copied once, straight to its destination.
+/// Writing past the end of the range is a programming error.
+class raw_buffer_ostream : public raw_ostream {
+  char *Start, *Cur, *End;
+
+  /// write_impl - See raw_ostream::write_impl.
+  void write_impl(const char *Ptr, size_t Size) override {
+    assert(Size <= size_t(End - Cur) && "write past the end of the buffer");
+    memcpy(Cur, Ptr, Size);
+    Cur += Size;
+  }
+
+  /// current_pos - Return the current position within the stream, not
+  /// counting the bytes currently in the buffer.
+  uint64_t current_pos() const override { return Cur - Start; }
+
+public:
+  /// Construct a stream with no buffer attached yet; see setBuffer.
+  raw_buffer_ostream() : Start(0), Cur(0), End(0) { SetUnbuffered(); }
+  raw_buffer_ostream(char *Start, char *End)
+    : Start(Start), Cur(Start), End(End) { SetUnbuffered(); }
+
+  /// setBuffer - Direct the output to [Start, End), from its beginning.
+  void setBuffer(char *NewStart, char *NewEnd) {
+    Start = Cur = NewStart;
+    End = NewEnd;
+  }
+
+  /// getBytesLeft - Return the room left in the buffer.
+  size_t getBytesLeft() const { return End - Cur; }
+};
+
 /// raw_null_ostream - A raw_ostream that discards all output.
 class raw_null_ostream : public raw_ostream {
   /// write_impl - See raw_ostream::write_impl.
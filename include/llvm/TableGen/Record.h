@@ -1647,6 +1647,10 @@ struct MultiClass {
 class RecordKeeper {
   std::map<std::string, Record*> Classes, Defs;
 
+  /// DerivedDefsCache - The results of getAllDerivedDefinitionsCached, by
+  /// class name.  Cleared whenever a class or def is added or removed.
+  mutable std::map<std::string, std::vector<Record*> > DerivedDefsCache;
+
 public:
   ~RecordKeeper() {
     for (std::map<std::string, Record*>::iterator I = Classes.begin(),
@@ -1669,11 +1673,13 @@ public:
     return I == Defs.end() ? nullptr : I->second;
   }
   void addClass(Record *R) {
+    DerivedDefsCache.clear();
     bool Ins = Classes.insert(std::make_pair(R->getName(), R)).second;
     (void)Ins;
     assert(Ins && "Class already exists");
   }
   void addDef(Record *R) {
+    DerivedDefsCache.clear();
     bool Ins = Defs.insert(std::make_pair(R->getName(), R)).second;
     (void)Ins;
     assert(Ins && "Record already exists");
@@ -1682,12 +1688,14 @@ public:
   /// removeClass - Remove, but do not delete, the specified record.
   ///
   void removeClass(const std::string &Name) {
+    DerivedDefsCache.clear();
     assert(Classes.count(Name) && "Class does not exist!");
     Classes.erase(Name);
   }
   /// removeDef - Remove, but do not delete, the specified record.
   ///
   void removeDef(const std::string &Name) {
+    DerivedDefsCache.clear();
     assert(Defs.count(Name) && "Def does not exist!");
     Defs.erase(Name);
   }
@@ -1701,6 +1709,21 @@ public:
   std::vector<Record*>
   getAllDerivedDefinitions(const std::string &ClassName) const;
 
+  /// getAllDerivedDefinitionsCached - Like getAllDerivedDefinitions, but
+  /// remember the result, so that the many backends and helpers that ask
+  /// for the same class (e.g. "Instruction" or "Register") scan the defs
+  /// once.  The reference is valid until a class or def is added or
+  /// removed.
+  const std::vector<Record*> &
+  getAllDerivedDefinitionsCached(const std::string &ClassName) const {
+    std::map<std::string, std::vector<Record*> >::iterator I =
+      DerivedDefsCache.find(ClassName);
+    if (I == DerivedDefsCache.end())
+      I = DerivedDefsCache.insert(std::make_pair(
+            ClassName, getAllDerivedDefinitions(ClassName))).first;
+    return I->second;
+  }
+
   void dump() const;
 };
 
@@ -16,6 +16,7 @@
 #define LLVM_TRANSFORMS_IPO_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
 
 namespace llvm {
 
@@ -192,6 +193,15 @@ ModulePass *createMergeFunctionsPass();
 ///
 ModulePass *createPartialInliningPass();
 
+//===----------------------------------------------------------------------===//
+/// createHotColdSplittingPass - This pass outlines the cold regions of
+/// functions, such as error handling and assertion failures, into ".cold"
+/// functions placed in ColdSection, using profile frequencies when
+/// ColdFreqRatio is not 0.
+///
+ModulePass *createHotColdSplittingPass(unsigned ColdFreqRatio = 0,
+                                       StringRef ColdSection = "");
+
 //===----------------------------------------------------------------------===//
 // createMetaRenamerPass - Rename everything with metasyntatic names.
 //
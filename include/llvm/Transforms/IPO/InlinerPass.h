@@ -74,10 +74,21 @@ struct Inliner : public CallGraphSCCPass {
   /// deal with that subset of the functions.
   bool removeDeadFunctions(CallGraph &CG, bool AlwaysInlineOnly = false);
 
+  /// setInlineBudget - Limit the total cost of the call sites this pass
+  /// inlines, so that inlining a large module, as in LTO, takes a bounded
+  /// amount of time.  Once the budget is spent, only always-inline call sites
+  /// are inlined.  Zero, the default, means no limit.
+  void setInlineBudget(unsigned Budget) { InlineBudget = Budget; }
+
 private:
   // InlineThreshold - Cache the value here for easy access.
   unsigned InlineThreshold;
 
+  // InlineBudget - The limit set by setInlineBudget, and the cost inlined so
+  // far.
+  unsigned InlineBudget;
+  unsigned InlinedCost;
+
   // InsertLifetime - Insert @llvm.lifetime intrinsics.
   bool InsertLifetime;
 
@@ -43,6 +43,16 @@ Pass *createObjCARCContractPass();
 //
 Pass *createObjCARCOptPass();
 
+/// \brief Create an ObjCARCOpt pass that gives up on functions in which more
+/// than \p MaxTrackedPointers distinct retained pointers would have to be
+/// tracked, leaving their retains and releases alone.
+///
+/// The per-block pointer states of the dataflow grow with the number of
+/// pointers tracked, so huge functions with thousands of retain/release
+/// pairs make the optimizer super-linear.  0 means no limit, as for
+/// createObjCARCOptPass().
+Pass *createObjCARCOptPass(unsigned MaxTrackedPointers);
+
 } // End llvm namespace
 
 #endif
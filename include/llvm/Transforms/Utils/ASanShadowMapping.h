@@ -0,0 +1,104 @@
+//===- ASanShadowMapping.h - AddressSanitizer shadow memory -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header defines getASanShadowMapping, the shadow memory mapping that
+// the AddressSanitizer instrumentation uses for a target, and
+// isSafeASanAccess, which finds the accesses that cannot need a check.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_TRANSFORMS_UTILS_ASANSHADOWMAPPING_H
+#define LLVM_TRANSFORMS_UTILS_ASANSHADOWMAPPING_H
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/MemoryBuiltins.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+
+namespace llvm {
+
+// Shadow = (Mem >> Scale) + Offset, or (Mem >> Scale) | Offset when
+// OrShadowOffset is set.  These must match the mapping that the ASan runtime
+// in compiler-rt sets up (asan_mapping.h).
+struct ASanShadowMapping {
+  int Scale;
+  uint64_t Offset;
+  bool OrShadowOffset;
+};
+
+/// Return the shadow mapping of \p TargetTriple for pointers of \p LongSize
+/// bits.
+///
+/// 32-bit iOS puts the shadow at 1 << 30: the default 1 << 29 lies inside
+/// the region where the kernel maps the dyld shared cache and the main
+/// executable of a 32-bit iOS process.
+inline ASanShadowMapping getASanShadowMapping(const Triple &TargetTriple,
+                                              int LongSize) {
+  bool IsAndroid = TargetTriple.getEnvironment() == Triple::Android;
+  bool IsIOS = TargetTriple.isiOS();
+  bool IsFreeBSD = TargetTriple.getOS() == Triple::FreeBSD;
+  bool IsLinux = TargetTriple.getOS() == Triple::Linux;
+  bool IsPPC64 = TargetTriple.getArch() == Triple::ppc64 ||
+                 TargetTriple.getArch() == Triple::ppc64le;
+  bool IsX86_64 = TargetTriple.getArch() == Triple::x86_64;
+  bool IsMIPS32 = TargetTriple.getArch() == Triple::mips ||
+                  TargetTriple.getArch() == Triple::mipsel;
+
+  ASanShadowMapping Mapping;
+  Mapping.Scale = 3;
+  if (LongSize == 32) {
+    if (IsAndroid)
+      Mapping.Offset = 0;
+    else if (IsMIPS32)
+      Mapping.Offset = 0x0aaa8000;
+    else if (IsFreeBSD || IsIOS)
+      Mapping.Offset = 1ULL << 30;
+    else
+      Mapping.Offset = 1ULL << 29;
+  } else {
+    if (IsPPC64)
+      Mapping.Offset = 1ULL << 41;
+    else if (IsFreeBSD)
+      Mapping.Offset = 1ULL << 46;
+    else if (IsLinux && IsX86_64)
+      Mapping.Offset = 0x7FFF8000;
+    else
+      Mapping.Offset = 1ULL << 44;
+  }
+  // OR-ing a power-of-two offset is cheaper than adding it, at least on
+  // x86, but not on PowerPC.
+  Mapping.OrShadowOffset =
+      !IsPPC64 && Mapping.Offset && !(Mapping.Offset & (Mapping.Offset - 1));
+  return Mapping;
+}
+
+/// Return true if an access of \p TypeSize bits through \p Addr stays within
+/// a stack or global object, so that its shadow check can never fail.
+///
+/// Only allocas and globals are trusted: an in-bounds access to a heap
+/// object may still be a use after free.  Accesses whose offset is not a
+/// constant, such as variable array indices, are not safe.
+inline bool isSafeASanAccess(ObjectSizeOffsetVisitor &ObjSizeVis,
+                             const DataLayout *DL, Value *Addr,
+                             uint64_t TypeSize) {
+  Value *Obj = GetUnderlyingObject(Addr, DL);
+  if (!isa<AllocaInst>(Obj) && !isa<GlobalVariable>(Obj))
+    return false;
+  SizeOffsetType SizeOffset = ObjSizeVis.compute(Addr);
+  if (!ObjSizeVis.bothKnown(SizeOffset))
+    return false;
+  int64_t Size = SizeOffset.first.getSExtValue();
+  int64_t Offset = SizeOffset.second.getSExtValue();
+  // Both sizes are in bytes; TypeSize is in bits.
+  return Offset >= 0 && Size >= Offset &&
+         uint64_t(Size - Offset) >= TypeSize / 8;
+}
+
+} // llvm namespace
+
+#endif  // LLVM_TRANSFORMS_UTILS_ASANSHADOWMAPPING_H
@@ -0,0 +1,167 @@
+//===-- BlockCopyElim.h - Keep non-escaping blocks on the stack -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines elideNonEscapingBlockCopies, which removes the
+// _Block_copy calls whose heap copy never outlives the stack block literal
+// it was made from, together with the matching _Block_release calls.
+//
+// Under ARC, CodeGen emits objc_retainBlock instead and marks the copies it
+// may drop with clang.arc.copy_on_escape, which the ObjCARC optimizer
+// handles.  Code built without ARC, such as GCD-heavy C and Objective-C,
+// calls _Block_copy directly and pays a malloc and a free for every block
+// that dispatch_sync or a similar call only uses while the frame is alive.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_BLOCKCOPYELIM_H
+#define LLVM_TRANSFORMS_UTILS_BLOCKCOPYELIM_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Use.h"
+
+namespace llvm {
+
+namespace block_copy_elim {
+
+inline bool isCallTo(const Value *V, StringRef Name) {
+  const CallInst *CI = dyn_cast<CallInst>(V);
+  if (!CI)
+    return false;
+  const Function *Callee =
+      dyn_cast<Function>(CI->getCalledValue()->stripPointerCasts());
+  return Callee && Callee->getName() == Name && CI->getNumArgOperands() == 1;
+}
+
+/// Whether \p U is the block argument of a libdispatch call that runs the
+/// block before it returns and does not keep it, such as dispatch_sync.
+/// Their declarations carry no nocapture attribute, so the capture tracker
+/// would otherwise reject the copy these calls are the main source of.
+inline bool isSynchronousDispatchArg(const Use *U) {
+  const CallInst *CI = dyn_cast<CallInst>(U->getUser());
+  // The arguments of a call are its first operands.
+  if (!CI || U->getOperandNo() >= CI->getNumArgOperands())
+    return false;
+  const Function *Callee =
+      dyn_cast<Function>(CI->getCalledValue()->stripPointerCasts());
+  if (!Callee)
+    return false;
+  unsigned ArgNo = U->getOperandNo();
+  StringRef Name = Callee->getName();
+  if (Name == "dispatch_sync" || Name == "dispatch_barrier_sync")
+    return CI->getNumArgOperands() == 2 && ArgNo == 1;
+  if (Name == "dispatch_apply")
+    return CI->getNumArgOperands() == 3 && ArgNo == 2;
+  return false;
+}
+
+/// Whether any use of \p Alloca ends its lifetime, after which a block
+/// literal stored in it is dead even though the frame is not.
+inline bool hasLifetimeEnd(const Value *Alloca) {
+  SmallVector<const Value *, 8> Worklist(1, Alloca);
+  while (!Worklist.empty()) {
+    const Value *V = Worklist.pop_back_val();
+    for (Value::const_use_iterator UI = V->use_begin(), UE = V->use_end();
+         UI != UE; ++UI) {
+      const User *U = UI->getUser();
+      if (isa<BitCastInst>(U) || isa<GetElementPtrInst>(U))
+        Worklist.push_back(U);
+      else if (const IntrinsicInst *II = dyn_cast<IntrinsicInst>(U))
+        if (II->getIntrinsicID() == Intrinsic::lifetime_end)
+          return true;
+    }
+  }
+  return false;
+}
+
+/// Tracks the uses of a heap copy, allowing only uses that end while its
+/// source block literal is alive: _Block_release of the copy, calls that do
+/// not capture it, and synchronous libdispatch calls.
+struct CopyTracker : public CaptureTracker {
+  SmallVector<CallInst *, 2> Releases;
+  bool Escapes;
+
+  CopyTracker() : Escapes(false) {}
+
+  void tooManyUses() override { Escapes = true; }
+
+  bool shouldExplore(const Use *U) override {
+    // Through a phi or select the copy may survive into a later iteration,
+    // by which time the stack literal holds other captures.
+    if (isa<PHINode>(U->getUser()) || isa<SelectInst>(U->getUser())) {
+      Escapes = true;
+      return false;
+    }
+    return true;
+  }
+
+  bool captured(const Use *U) override {
+    if (isCallTo(U->getUser(), "_Block_release")) {
+      Releases.push_back(cast<CallInst>(U->getUser()));
+      return false;
+    }
+    if (isSynchronousDispatchArg(U))
+      return false;
+    Escapes = true;
+    return true;
+  }
+};
+
+} // end namespace block_copy_elim
+
+/// elideNonEscapingBlockCopies - Replace each _Block_copy of a block literal
+/// on the stack by the literal itself, and delete its _Block_releases, when
+/// the copy is neither stored, returned nor passed to a call that may
+/// capture it.  dispatch_sync, dispatch_barrier_sync and dispatch_apply are
+/// known to finish with their block before they return.
+///
+/// The block's copy helper retains what the block captures and its dispose
+/// helper releases it again, so dropping both calls together leaves the
+/// reference counts balanced.  The stack literal's lifetime must not be
+/// ended before the function returns.
+///
+/// \returns true if the function was changed.
+inline bool elideNonEscapingBlockCopies(Function &F) {
+  using namespace block_copy_elim;
+  SmallVector<CallInst *, 8> Copies;
+  for (Function::iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB)
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I)
+      if (isCallTo(I, "_Block_copy"))
+        Copies.push_back(cast<CallInst>(I));
+
+  bool Changed = false;
+  for (unsigned i = 0, e = Copies.size(); i != e; ++i) {
+    CallInst *Copy = Copies[i];
+    Value *Literal = Copy->getArgOperand(0);
+    const Value *Alloca = Literal->stripPointerCasts();
+    if (!isa<AllocaInst>(Alloca) || hasLifetimeEnd(Alloca))
+      continue;
+
+    CopyTracker Tracker;
+    PointerMayBeCaptured(Copy, &Tracker);
+    if (Tracker.Escapes)
+      continue;
+
+    for (unsigned j = 0, je = Tracker.Releases.size(); j != je; ++j)
+      Tracker.Releases[j]->eraseFromParent();
+    if (Literal->getType() != Copy->getType())
+      Literal = new BitCastInst(Literal, Copy->getType(), "", Copy);
+    Copy->replaceAllUsesWith(Literal);
+    Copy->eraseFromParent();
+    Changed = true;
+  }
+  return Changed;
+}
+
+} // end namespace llvm
+
+#endif
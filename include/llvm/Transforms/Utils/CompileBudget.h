@@ -0,0 +1,48 @@
+//===-- CompileBudget.h - Degrade optimization over budget ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines degradeIfOverBudget, which the function pass managers
+// call before running the passes on each function, so that once the
+// CompileWatchdog budget is spent the remaining functions are compiled the
+// way optnone functions are.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_COMPILEBUDGET_H
+#define LLVM_TRANSFORMS_UTILS_COMPILEBUDGET_H
+
+#include "llvm/IR/Attributes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/CompileWatchdog.h"
+
+namespace llvm {
+
+/// degradeIfOverBudget - If the installed CompileWatchdog's budget is spent,
+/// mark \p F optnone, so that the passes that honor skipOptnoneFunction
+/// leave it alone and code generation uses the fast paths.
+///
+/// The functions already optimized keep their code; only the time left is
+/// bounded.  Since optnone requires noinline, \p F also stops being inlined
+/// into its callers.
+///
+/// \returns true if \p F was changed.
+inline bool degradeIfOverBudget(Function &F) {
+  CompileWatchdog *Watchdog = CompileWatchdog::get();
+  if (!Watchdog || F.isDeclaration() ||
+      F.hasFnAttribute(Attribute::OptimizeNone) || !Watchdog->isOverBudget())
+    return false;
+  F.removeFnAttr(Attribute::AlwaysInline);
+  F.addFnAttr(Attribute::OptimizeNone);
+  F.addFnAttr(Attribute::NoInline);
+  return true;
+}
+
+} // end namespace llvm
+
+#endif
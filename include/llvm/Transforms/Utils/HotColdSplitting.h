@@ -0,0 +1,177 @@
+//===- HotColdSplitting.h - Outline cold regions of functions ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the utilities behind the hot/cold splitting pass, which
+// uses CodeExtractor to move the cold regions of a function, such as error
+// handling and assertion failures, into separate ".cold" functions that can
+// be placed away from the hot code.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_HOTCOLDSPLITTING_H
+#define LLVM_TRANSFORMS_UTILS_HOTCOLDSPLITTING_H
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Transforms/Utils/CodeExtractor.h"
+
+namespace llvm {
+
+/// HotColdSplittingOptions - The limits of the hot/cold splitting.
+struct HotColdSplittingOptions {
+  /// A block whose frequency is below the entry frequency divided by this is
+  /// cold; 0 ignores the frequencies, leaving only the blocks that never
+  /// return and the calls to cold functions.
+  uint64_t ColdFreqRatio;
+  /// The fewest instructions worth outlining: smaller regions cost more in
+  /// the call than they save in the hot function.
+  unsigned MinRegionSize;
+  /// The section of the outlined functions, such as ".text.unlikely" for
+  /// ELF, which the linker groups away from the hot code; empty leaves the
+  /// default.
+  StringRef ColdSection;
+
+  HotColdSplittingOptions()
+    : ColdFreqRatio(0), MinRegionSize(4), ColdSection() {}
+};
+
+/// isColdBlock - Return true if \p BB is cold: it ends in unreachable, as
+/// the failure path of an assertion does, it calls a function marked cold,
+/// or \p BFI gives it a frequency below the entry's divided by
+/// Opts.ColdFreqRatio.  The frequencies only reflect the program's behavior
+/// when the branch weights come from a profile.
+inline bool isColdBlock(const BasicBlock &BB, const BlockFrequencyInfo *BFI,
+                        const HotColdSplittingOptions &Opts) {
+  if (isa<UnreachableInst>(BB.getTerminator()))
+    return true;
+  for (BasicBlock::const_iterator I = BB.begin(), E = BB.end(); I != E; ++I)
+    if (const CallInst *CI = dyn_cast<CallInst>(I))
+      if (CI->hasFnAttr(Attribute::Cold))
+        return true;
+  if (!BFI || !Opts.ColdFreqRatio)
+    return false;
+  return BFI->getBlockFreq(&BB).getFrequency() <
+         BFI->getEntryFreq() / Opts.ColdFreqRatio;
+}
+
+/// findColdRegions - Append to \p Regions the regions of \p F that are worth
+/// outlining, each a cold block followed by the cold blocks it dominates.
+///
+/// A region is only kept if control enters it at its first block alone, as
+/// CodeExtractor requires, and it has at least Opts.MinRegionSize
+/// instructions.  Regions never overlap and never contain the entry block.
+inline void
+findColdRegions(Function &F, DominatorTree &DT, const BlockFrequencyInfo *BFI,
+                const HotColdSplittingOptions &Opts,
+                SmallVectorImpl<SmallVector<BasicBlock *, 8> > &Regions) {
+  SmallPtrSet<BasicBlock *, 32> Cold;
+  for (Function::iterator BB = std::next(F.begin()), E = F.end(); BB != E;
+       ++BB)
+    if (DT.isReachableFromEntry(BB) && isColdBlock(*BB, BFI, Opts))
+      Cold.insert(BB);
+
+  // Walk the dominator tree in preorder, so that each region starts at the
+  // outermost cold block of its subtree.
+  SmallPtrSet<BasicBlock *, 32> Taken;
+  SmallVector<DomTreeNode *, 16> Worklist;
+  Worklist.push_back(DT.getRootNode());
+  while (!Worklist.empty()) {
+    DomTreeNode *N = Worklist.pop_back_val();
+    BasicBlock *Root = N->getBlock();
+    if (!Cold.count(Root) || Taken.count(Root)) {
+      Worklist.append(N->begin(), N->end());
+      continue;
+    }
+
+    SmallVector<BasicBlock *, 8> Region;
+    SmallPtrSet<BasicBlock *, 8> InRegion;
+    SmallVector<DomTreeNode *, 8> RegionWorklist(1, N);
+    unsigned Size = 0;
+    while (!RegionWorklist.empty()) {
+      DomTreeNode *RN = RegionWorklist.pop_back_val();
+      BasicBlock *BB = RN->getBlock();
+      if (!Cold.count(BB)) {
+        // Hot code below a cold block is looked at on its own.
+        Worklist.push_back(RN);
+        continue;
+      }
+      Region.push_back(BB);
+      InRegion.insert(BB);
+      Size += BB->size();
+      RegionWorklist.append(RN->begin(), RN->end());
+    }
+
+    bool SingleEntry = true;
+    for (unsigned i = 1, e = Region.size(); i != e && SingleEntry; ++i)
+      for (pred_iterator PI = pred_begin(Region[i]), PE = pred_end(Region[i]);
+           PI != PE; ++PI)
+        if (!InRegion.count(*PI)) {
+          SingleEntry = false;
+          break;
+        }
+    for (unsigned i = 0, e = Region.size(); i != e; ++i)
+      Taken.insert(Region[i]);
+    if (SingleEntry && Size >= Opts.MinRegionSize)
+      Regions.push_back(Region);
+  }
+}
+
+/// splitColdRegions - Outline the cold regions of \p F into functions named
+/// after it with a ".cold" suffix, marked cold, minsize and noinline, and
+/// placed in Opts.ColdSection.
+///
+/// \p DT is updated for each extraction; \p BFI is only used to find the
+/// regions and is stale afterwards.
+///
+/// \returns the number of regions outlined.
+inline unsigned splitColdRegions(Function &F, DominatorTree &DT,
+                                 const BlockFrequencyInfo *BFI,
+                                 const HotColdSplittingOptions &Opts) {
+  if (F.isDeclaration() || F.hasFnAttribute(Attribute::OptimizeNone) ||
+      F.hasFnAttribute(Attribute::Cold))
+    return 0;
+
+  SmallVector<SmallVector<BasicBlock *, 8>, 4> Regions;
+  findColdRegions(F, DT, BFI, Opts, Regions);
+
+  unsigned NumSplit = 0;
+  for (unsigned i = 0, e = Regions.size(); i != e; ++i) {
+    // The regions are disjoint, and extracting one only adds the block that
+    // calls it, so the others stay single-entry.
+    if (i)
+      DT.recalculate(F);
+    CodeExtractor CE(Regions[i], &DT);
+    if (!CE.isEligible())
+      continue;
+    Function *ColdF = CE.extractCodeRegion();
+    if (!ColdF)
+      continue;
+    ColdF->setName(F.getName() + ".cold");
+    ColdF->addFnAttr(Attribute::Cold);
+    ColdF->addFnAttr(Attribute::MinSize);
+    ColdF->addFnAttr(Attribute::OptimizeForSize);
+    ColdF->addFnAttr(Attribute::NoInline);
+    if (!Opts.ColdSection.empty())
+      ColdF->setSection(Opts.ColdSection);
+    ++NumSplit;
+  }
+  if (NumSplit)
+    DT.recalculate(F);
+  return NumSplit;
+}
+
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,475 @@
+//===- ParallelFunctionPasses.h - Function passes on threads ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines runFunctionPassesInParallel, which runs a function pass
+// pipeline over the functions of a module on several threads, each on a copy
+// of the module in its own LLVMContext, and moves the optimized bodies back
+// into the module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_PARALLELFUNCTIONPASSES_H
+#define LLVM_TRANSFORMS_UTILS_PARALLELFUNCTIONPASSES_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/TypeFinder.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+namespace parallel_fpm {
+
+/// Assign the function definitions of \p M, by index in the function list,
+/// to \p NumPartitions partitions with about the same number of
+/// instructions, largest first.  Declarations get no partition (~0U).
+///
+/// Functions that an alias refers to are left to partition 0, and set in
+/// \p KeepBody: every partition keeps their bodies so that its aliases
+/// stay valid.
+inline std::vector<unsigned> assignFunctions(Module &M,
+                                             unsigned NumPartitions,
+                                             std::vector<char> &KeepBody) {
+  std::vector<std::pair<unsigned, unsigned> > BySize;
+  std::vector<unsigned> Owner;
+  SmallPtrSet<const GlobalValue *, 8> Aliased;
+  for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end(); I != E;
+       ++I)
+    if (const GlobalValue *Aliasee = I->getAliasedGlobal())
+      Aliased.insert(Aliasee);
+
+  KeepBody.clear();
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    Owner.push_back(I->isDeclaration() ? ~0U : 0U);
+    KeepBody.push_back(Aliased.count(I));
+    if (I->isDeclaration() || Aliased.count(I))
+      continue;
+    unsigned Size = 0;
+    for (Function::const_iterator BB = I->begin(), BE = I->end(); BB != BE;
+         ++BB)
+      Size += BB->size();
+    // Sort by decreasing size, then by position, so ties are deterministic.
+    BySize.push_back(std::make_pair(~Size, unsigned(Owner.size() - 1)));
+  }
+  std::sort(BySize.begin(), BySize.end());
+
+  std::vector<uint64_t> Load(NumPartitions);
+  for (unsigned i = 0, e = BySize.size(); i != e; ++i) {
+    unsigned Least = 0;
+    for (unsigned P = 1; P != NumPartitions; ++P)
+      if (Load[P] < Load[Least])
+        Least = P;
+    Owner[BySize[i].second] = Least;
+    Load[Least] += ~BySize[i].first;
+  }
+  return Owner;
+}
+
+/// Read \p Bitcode into a new module in \p Context.
+inline Module *readModule(StringRef Bitcode, LLVMContext &Context,
+                          std::string &ErrMsg) {
+  std::unique_ptr<MemoryBuffer> Buffer(MemoryBuffer::getMemBuffer(
+      Bitcode, "<function-pass-partition>", /*RequiresNullTerminator=*/false));
+  ErrorOr<Module *> ModuleOrErr = parseBitcodeFile(Buffer.get(), Context);
+  if (error_code EC = ModuleOrErr.getError()) {
+    ErrMsg = EC.message();
+    return nullptr;
+  }
+  return ModuleOrErr.get();
+}
+
+/// Optimize the functions that partition \p Partition owns in the module in
+/// \p Bitcode, in a context of its own, and serialize the result back into
+/// \p Bitcode.
+inline bool
+optimizePartition(SmallString<0> &Bitcode, unsigned Partition,
+                  const std::vector<unsigned> &Owner,
+                  const std::function<void(FunctionPassManager &)> &AddPasses,
+                  std::string &ErrMsg) {
+  LLVMContext Context;
+  std::unique_ptr<Module> M(readModule(Bitcode, Context, ErrMsg));
+  if (!M)
+    return false;
+
+  FunctionPassManager FPM(M.get());
+  AddPasses(FPM);
+  FPM.doInitialization();
+  unsigned Index = 0;
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I, ++Index)
+    if (Index < Owner.size() && Owner[Index] == Partition)
+      FPM.run(*I);
+  FPM.doFinalization();
+
+  Bitcode.clear();
+  raw_svector_ostream OS(Bitcode);
+  WriteBitcodeToFile(M.get(), OS);
+  OS.flush();
+  return true;
+}
+
+/// Maps the types of a partition read back into the context of a module to
+/// the types of that module.
+///
+/// The bitcode reader gives each identified struct type of the partition a
+/// fresh name, such as %struct.foo.6, because the context already has the
+/// module's %struct.foo.  The types of the globals and functions that
+/// correspond by position pair most of them with the module's types; the
+/// ones only used inside function bodies are paired by name, with the
+/// suffix dropped, if the module's type of that name has the same
+/// structure.  Types with no counterpart map to themselves.
+class PartitionTypeMapper : public ValueMapTypeRemapper {
+  DenseMap<Type *, Type *> Map;
+  /// The types mapped by the addTypeMapping in progress, to undo it if the
+  /// types turn out to differ.
+  SmallVector<Type *, 16> Speculative;
+
+  bool pairTypes(Type *Src, Type *Dst) {
+    if (Src == Dst)
+      return true;
+    DenseMap<Type *, Type *>::iterator I = Map.find(Src);
+    if (I != Map.end())
+      return I->second == Dst;
+    if (Src->getTypeID() != Dst->getTypeID() ||
+        Src->getNumContainedTypes() != Dst->getNumContainedTypes())
+      return false;
+
+    // Types in one context are uniqued, so different types only correspond
+    // if an identified struct type occurs in them.
+    if (StructType *SST = dyn_cast<StructType>(Src)) {
+      StructType *DST = cast<StructType>(Dst);
+      if (SST->isLiteral() != DST->isLiteral() ||
+          SST->isPacked() != DST->isPacked() ||
+          SST->isOpaque() != DST->isOpaque())
+        return false;
+    } else if (!Src->getNumContainedTypes()) {
+      return false;
+    } else if (ArrayType *SAT = dyn_cast<ArrayType>(Src)) {
+      if (SAT->getNumElements() != cast<ArrayType>(Dst)->getNumElements())
+        return false;
+    } else if (VectorType *SVT = dyn_cast<VectorType>(Src)) {
+      if (SVT->getNumElements() != cast<VectorType>(Dst)->getNumElements())
+        return false;
+    } else if (PointerType *SPT = dyn_cast<PointerType>(Src)) {
+      if (SPT->getAddressSpace() !=
+          cast<PointerType>(Dst)->getAddressSpace())
+        return false;
+    } else if (FunctionType *SFT = dyn_cast<FunctionType>(Src)) {
+      if (SFT->isVarArg() != cast<FunctionType>(Dst)->isVarArg())
+        return false;
+    }
+
+    Map[Src] = Dst;
+    Speculative.push_back(Src);
+    for (unsigned i = 0, e = Src->getNumContainedTypes(); i != e; ++i)
+      if (!pairTypes(Src->getContainedType(i), Dst->getContainedType(i)))
+        return false;
+    return true;
+  }
+
+public:
+  /// Map \p Src, and the types in it, to \p Dst and the types in that, if
+  /// they have the same structure.
+  bool addTypeMapping(Type *Src, Type *Dst) {
+    bool Paired = pairTypes(Src, Dst);
+    if (!Paired)
+      for (unsigned i = 0, e = Speculative.size(); i != e; ++i)
+        Map.erase(Speculative[i]);
+    Speculative.clear();
+    return Paired;
+  }
+
+  /// Pair the named struct types of \p Part that are still unmapped with
+  /// the types of \p M that they were renamed from.
+  void addTypeMappingsByName(Module &M, Module &Part) {
+    TypeFinder StructTypes;
+    StructTypes.run(Part, /*onlyNamed=*/true);
+    for (TypeFinder::iterator I = StructTypes.begin(), E = StructTypes.end();
+         I != E; ++I) {
+      StructType *ST = *I;
+      if (Map.count(ST))
+        continue;
+      StringRef Name = ST->getName();
+      size_t Dot = Name.rfind('.');
+      if (Dot == StringRef::npos ||
+          Name.find_first_not_of("0123456789", Dot + 1) != StringRef::npos)
+        continue;
+      if (StructType *DST = M.getTypeByName(Name.substr(0, Dot)))
+        addTypeMapping(ST, DST);
+    }
+  }
+
+  Type *remapType(Type *Ty) override {
+    DenseMap<Type *, Type *>::iterator I = Map.find(Ty);
+    if (I != Map.end())
+      return I->second;
+    StructType *ST = dyn_cast<StructType>(Ty);
+    if (!Ty->getNumContainedTypes() || (ST && !ST->isLiteral()))
+      return Ty;
+
+    SmallVector<Type *, 4> Elements;
+    bool Changed = false;
+    for (unsigned i = 0, e = Ty->getNumContainedTypes(); i != e; ++i) {
+      Elements.push_back(remapType(Ty->getContainedType(i)));
+      Changed |= Elements.back() != Ty->getContainedType(i);
+    }
+
+    Type *Result = Ty;
+    if (Changed) {
+      switch (Ty->getTypeID()) {
+      default:
+        llvm_unreachable("unknown derived type");
+      case Type::ArrayTyID:
+        Result = ArrayType::get(Elements[0],
+                                cast<ArrayType>(Ty)->getNumElements());
+        break;
+      case Type::VectorTyID:
+        Result = VectorType::get(Elements[0],
+                                 cast<VectorType>(Ty)->getNumElements());
+        break;
+      case Type::PointerTyID:
+        Result = PointerType::get(Elements[0],
+                                  cast<PointerType>(Ty)->getAddressSpace());
+        break;
+      case Type::FunctionTyID:
+        Result = FunctionType::get(Elements[0],
+                                   makeArrayRef(Elements).slice(1),
+                                   cast<FunctionType>(Ty)->isVarArg());
+        break;
+      case Type::StructTyID:
+        Result = StructType::get(Ty->getContext(), Elements, ST->isPacked());
+        break;
+      }
+    }
+    return Map[Ty] = Result;
+  }
+};
+
+/// Move the bodies of the functions that partition \p Partition owns from
+/// \p Part, the optimized partition read into the context of \p M, into
+/// \p M, mapping the types of \p Part to those of \p M.
+///
+/// The first \p NumGlobals global variables and the functions correspond
+/// by position, since the partition is a copy of \p M whose lists only
+/// grew: the passes may have added declarations (such as library functions
+/// that calls were simplified to) and private constants.  These are
+/// recreated in \p M, after the ones that earlier partitions added.
+inline void mergePartition(Module &M, Module &Part, unsigned Partition,
+                           const std::vector<unsigned> &Owner,
+                           unsigned NumGlobals) {
+  ValueToValueMapTy VMap;
+  PartitionTypeMapper TypeMapper;
+  SmallVector<GlobalVariable *, 8> NewGlobals;
+
+  // Pair the types first, before any of them is remapped.
+  Module::global_iterator MG = M.global_begin();
+  unsigned GlobalIndex = 0;
+  for (Module::global_iterator PG = Part.global_begin(),
+                               PGE = Part.global_end();
+       PG != PGE && GlobalIndex != NumGlobals; ++PG, ++MG, ++GlobalIndex)
+    TypeMapper.addTypeMapping(PG->getType(), MG->getType());
+  Module::iterator MF = M.begin();
+  unsigned FunctionIndex = 0;
+  for (Module::iterator PF = Part.begin(), PFE = Part.end();
+       PF != PFE && FunctionIndex != Owner.size(); ++PF, ++MF, ++FunctionIndex)
+    TypeMapper.addTypeMapping(PF->getType(), MF->getType());
+  TypeMapper.addTypeMappingsByName(M, Part);
+
+  MG = M.global_begin();
+  GlobalIndex = 0;
+  for (Module::global_iterator PG = Part.global_begin(),
+                               PGE = Part.global_end(); PG != PGE;
+       ++PG, ++GlobalIndex) {
+    if (GlobalIndex < NumGlobals) {
+      VMap[PG] = MG++;
+      continue;
+    }
+    GlobalVariable *GV = new GlobalVariable(
+        M, TypeMapper.remapType(PG->getType()->getElementType()),
+        PG->isConstant(),
+        PG->getLinkage(), nullptr, PG->getName(), nullptr,
+        PG->getThreadLocalMode(), PG->getType()->getAddressSpace());
+    GV->copyAttributesFrom(PG);
+    VMap[PG] = GV;
+    NewGlobals.push_back(GV);
+  }
+
+  MF = M.begin();
+  FunctionIndex = 0;
+  for (Module::iterator PF = Part.begin(), PFE = Part.end(); PF != PFE;
+       ++PF, ++FunctionIndex) {
+    if (FunctionIndex < Owner.size()) {
+      VMap[PF] = MF++;
+      continue;
+    }
+    VMap[PF] = M.getOrInsertFunction(
+        PF->getName(),
+        cast<FunctionType>(TypeMapper.remapType(PF->getFunctionType())),
+        PF->getAttributes());
+  }
+
+  Module::alias_iterator MA = M.alias_begin();
+  for (Module::alias_iterator PA = Part.alias_begin(),
+                              PAE = Part.alias_end(); PA != PAE; ++PA, ++MA)
+    VMap[PA] = MA;
+
+  // The initializers of new globals may refer to each other.
+  Module::global_iterator PG = Part.global_begin();
+  std::advance(PG, std::distance(Part.global_begin(), Part.global_end()) -
+                       NewGlobals.size());
+  for (unsigned i = 0, e = NewGlobals.size(); i != e; ++i, ++PG)
+    if (PG->hasInitializer())
+      NewGlobals[i]->setInitializer(
+          MapValue(PG->getInitializer(), VMap, RF_None, &TypeMapper));
+
+  unsigned Index = 0;
+  Module::iterator PF = Part.begin();
+  for (Module::iterator F = M.begin(), E = M.end();
+       F != E && Index != Owner.size(); ++F, ++PF, ++Index) {
+    if (Owner[Index] != Partition)
+      continue;
+    // deleteBody makes the function external; keep what it was.
+    GlobalValue::LinkageTypes Linkage = F->getLinkage();
+    F->deleteBody();
+    F->setLinkage(Linkage);
+    Function::arg_iterator NewArg = F->arg_begin();
+    for (Function::arg_iterator A = PF->arg_begin(), AE = PF->arg_end();
+         A != AE; ++A, ++NewArg)
+      VMap[A] = NewArg;
+    SmallVector<ReturnInst *, 8> Returns;
+    CloneFunctionInto(F, PF, VMap, /*ModuleLevelChanges=*/true, Returns, "",
+                      nullptr, &TypeMapper);
+  }
+}
+
+} // end namespace parallel_fpm
+
+/// runFunctionPassesInParallel - Run the function passes that \p AddPasses
+/// adds to a FunctionPassManager over every function definition of \p M,
+/// split into up to \p NumThreads partitions that are optimized on the
+/// shared thread pool (see ThreadPool.h).
+///
+/// The passes of one function cannot run next to those of another in the
+/// same context (see FPPassManager), so the functions are split into
+/// partitions of similar size.  Each partition optimizes its functions in
+/// a copy of the whole module that is serialized to bitcode and read into
+/// its own LLVMContext.  Only the function bodies are deleted from the
+/// copies, so the passes see the same global initializers and declarations
+/// as they would in \p M.  The optimized bodies are then moved back into
+/// \p M in partition order, so the result does not depend on the timing of
+/// the threads.
+///
+/// Of what the passes change outside the function they run on, only new
+/// declarations and new private globals are merged back; the first
+/// partition to add a declaration decides its attributes.  Other changes,
+/// such as attributes set on other functions, are lost.  Since the
+/// partitions depend on the number of threads, the pipeline should only
+/// hold passes that keep to their own function, or the result can differ
+/// between thread counts.
+///
+/// \p AddPasses is called once per partition, possibly concurrently, and
+/// must only create passes.  Modules with debug info are optimized on the
+/// calling thread, since the copies of their metadata would have to be
+/// merged back.
+///
+/// \returns true on success; on failure \p ErrMsg describes the first failing
+/// partition and \p M is unchanged.
+inline bool runFunctionPassesInParallel(
+    Module &M, unsigned NumThreads,
+    const std::function<void(FunctionPassManager &)> &AddPasses,
+    std::string &ErrMsg) {
+  unsigned NumDefinitions = 0;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
+    if (!I->isDeclaration())
+      ++NumDefinitions;
+  unsigned N = std::min(NumThreads, NumDefinitions);
+  if (N < 2 || M.getNamedMetadata("llvm.dbg.cu")) {
+    FunctionPassManager FPM(&M);
+    AddPasses(FPM);
+    FPM.doInitialization();
+    for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
+      if (!I->isDeclaration())
+        FPM.run(*I);
+    FPM.doFinalization();
+    return true;
+  }
+
+  std::vector<char> KeepBody;
+  std::vector<unsigned> Owner = parallel_fpm::assignFunctions(M, N, KeepBody);
+  unsigned NumGlobals = std::distance(M.global_begin(), M.global_end());
+
+  // Cloning, serializing and merging touch the context of M, so they happen
+  // on this thread; only the optimization of the partitions runs in
+  // parallel.
+  std::vector<SmallString<0> > Bitcode(N);
+  for (unsigned P = 0; P != N; ++P) {
+    std::unique_ptr<Module> Clone(CloneModule(&M));
+    unsigned Index = 0;
+    for (Module::iterator I = Clone->begin(), E = Clone->end(); I != E;
+         ++I, ++Index) {
+      if (!I->isDeclaration() && Owner[Index] != P && !KeepBody[Index])
+        I->deleteBody();
+    }
+    raw_svector_ostream OS(Bitcode[P]);
+    WriteBitcodeToFile(Clone.get(), OS);
+    OS.flush();
+  }
+
+  std::vector<std::string> Errors(N);
+  std::vector<char> Succeeded(N, true);
+  {
+    llvm_start_multithreaded();
+    TaskGroup Group;
+    for (unsigned P = 0; P != N; ++P)
+      Group.spawn([&, P] {
+        Succeeded[P] = parallel_fpm::optimizePartition(Bitcode[P], P, Owner,
+                                                       AddPasses, Errors[P]);
+      });
+    Group.wait();
+  }
+
+  std::vector<std::unique_ptr<Module> > Parts(N);
+  for (unsigned P = 0; P != N; ++P) {
+    if (Succeeded[P])
+      Parts[P].reset(
+          parallel_fpm::readModule(Bitcode[P], M.getContext(), Errors[P]));
+    if (!Parts[P]) {
+      ErrMsg = "partition " + utostr(P) + ": " + Errors[P];
+      return false;
+    }
+  }
+  for (unsigned P = 0; P != N; ++P)
+    parallel_fpm::mergePartition(M, *Parts[P], P, Owner, NumGlobals);
+  return true;
+}
+
+} // end namespace llvm
+
+#endif
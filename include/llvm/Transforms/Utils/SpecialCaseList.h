@@ -48,6 +48,12 @@
 #define LLVM_TRANSFORMS_UTILS_SPECIALCASELIST_H
 
 #include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Regex.h"
+#include <algorithm>
+#include <string>
+#include <vector>
 
 namespace llvm {
 class Function;
@@ -55,8 +61,6 @@ class GlobalAlias;
 class GlobalVariable;
 class MemoryBuffer;
 class Module;
-class Regex;
-class StringRef;
 
 class SpecialCaseList {
  public:
@@ -98,7 +102,66 @@ class SpecialCaseList {
   SpecialCaseList(SpecialCaseList const &) LLVM_DELETED_FUNCTION;
   SpecialCaseList &operator=(SpecialCaseList const &) LLVM_DELETED_FUNCTION;
 
-  struct Entry;
+  /// The patterns of one prefix and category.  Patterns without regex
+  /// syntax are matched by a hash lookup, and patterns that are a literal
+  /// followed by a single trailing '*', such as "fun:_ZN4base*", through a
+  /// sorted prefix table; only the remaining ones are combined into one
+  /// alternation and run as a regex.  Large blacklists are mostly of the
+  /// first two kinds.
+  struct Entry {
+    StringSet<> Strings;
+    /// Sorted, and free of prefixes of one another after finalize().
+    std::vector<std::string> Prefixes;
+    Regex *RegEx;
+
+    Entry() : RegEx(nullptr) {}
+
+    /// Add \p Glob, a pattern with '*' already rewritten to ".*", to the
+    /// lookup tables, or append it to \p Regexp if it needs a regex.
+    void addPattern(StringRef Glob, std::string &Regexp) {
+      if (Regex::isLiteralERE(Glob)) {
+        Strings.insert(Glob);
+        return;
+      }
+      if (Glob.endswith(".*") &&
+          Regex::isLiteralERE(Glob.drop_back(2))) {
+        Prefixes.push_back(Glob.drop_back(2));
+        return;
+      }
+      if (!Regexp.empty())
+        Regexp += "|";
+      Regexp += Glob;
+    }
+
+    /// Sort the prefix table and drop the prefixes that a shorter one
+    /// already covers, after the last addPattern.
+    void finalize() {
+      std::sort(Prefixes.begin(), Prefixes.end());
+      std::vector<std::string>::iterator Out = Prefixes.begin();
+      for (std::vector<std::string>::iterator I = Prefixes.begin(),
+                                              E = Prefixes.end();
+           I != E; ++I)
+        if (Out == Prefixes.begin() || !StringRef(*I).startswith(Out[-1]))
+          *Out++ = *I;
+      Prefixes.erase(Out, Prefixes.end());
+    }
+
+    /// Whether a prefix covers \p Query.  Since no prefix in the table
+    /// starts with another, only the greatest one not above \p Query can.
+    bool matchPrefix(StringRef Query) const {
+      std::vector<std::string>::const_iterator I =
+          std::upper_bound(Prefixes.begin(), Prefixes.end(), Query,
+                           [](StringRef Q, const std::string &P) {
+                             return Q < StringRef(P);
+                           });
+      return I != Prefixes.begin() && Query.startswith(I[-1]);
+    }
+
+    bool match(StringRef Query) const {
+      return Strings.count(Query) || matchPrefix(Query) ||
+             (RegEx && RegEx->match(Query));
+    }
+  };
   StringMap<StringMap<Entry> > Entries;
 
   SpecialCaseList();
@@ -16,6 +16,8 @@
 #ifndef LLVM_TRANSFORMS_UTILS_UNROLLLOOP_H
 #define LLVM_TRANSFORMS_UTILS_UNROLLLOOP_H
 
+#include "llvm/Support/MathExtras.h"
+
 namespace llvm {
 
 class Loop;
@@ -30,6 +32,41 @@ bool UnrollLoop(Loop *L, unsigned Count, unsigned TripCount, bool AllowRuntime,
 bool UnrollRuntimeLoopProlog(Loop *L, unsigned Count, LoopInfo *LI,
                              LPPassManager* LPM);
 
+/// Return the unrolling factor that lets a loop body of \p LoopSize
+/// instructions hide a load latency of \p Latency cycles, on a target that
+/// issues \p IssueWidth instructions per cycle, or 0 if unrolling does not
+/// help or does not fit.
+///
+/// This is a software-pipelining mode of partial unrolling: the copies of the
+/// body are independent until the loop-carried values, so the scheduler can
+/// issue the loads of later copies while the earlier ones wait.  That needs
+/// enough copies to fill the latency after the first, rounded up to a power
+/// of two for the runtime unroller.  The unrolled body must fit in
+/// \p Threshold, which for -Os is the PartialOptSizeThreshold, and the factor
+/// in \p MaxCount.
+inline unsigned computePipelinedUnrollCount(unsigned LoopSize,
+                                            unsigned Latency,
+                                            unsigned IssueWidth,
+                                            unsigned Threshold,
+                                            unsigned MaxCount) {
+  if (!LoopSize || !Latency)
+    return 0;
+  if (!IssueWidth)
+    IssueWidth = 1;
+  unsigned IterCycles = (LoopSize + IssueWidth - 1) / IssueWidth;
+  // An iteration that takes as long as the latency already hides it.
+  if (IterCycles >= Latency)
+    return 0;
+  // One copy plus enough to cover the latency, as the smallest power of two
+  // of at least that many (NextPowerOf2 is strictly greater).
+  unsigned Covering = (Latency + IterCycles - 1) / IterCycles;
+  unsigned Count = unsigned(NextPowerOf2(Covering));
+  unsigned Fits = Threshold / LoopSize;
+  while (Count > 1 && (Count > Fits || Count > MaxCount))
+    Count /= 2;
+  return Count > 1 ? Count : 0;
+}
+
 }
 
 #endif
@@ -123,6 +123,17 @@ Pass *createLoopVectorizePass(bool NoUnrolling = false,
 //
 Pass *createSLPVectorizerPass();
 
+/// @brief Create an SLP vectorizer that, if \p VectorizeAggregates is set,
+/// also seeds trees from chains of insertvalue instructions and uses
+/// extractvalue operands as vector lanes.
+///
+/// Small float structs such as CGPoint and CGRect are passed and returned
+/// as first-class aggregates, so their arithmetic is built from
+/// extractvalue and ends in insertvalue chains that the default seeds miss.
+/// Trees that are rejected as too costly are reported, with their cost,
+/// through LLVMContext::emitOptimizationRemark under -Rpass=slp-vectorizer.
+Pass *createSLPVectorizerPass(bool VectorizeAggregates);
+
 //===----------------------------------------------------------------------===//
 /// @brief Vectorize the BasicBlock.
 ///